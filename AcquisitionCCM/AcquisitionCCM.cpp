@@ -36,10 +36,24 @@
 #include "Spinnaker.h"
 #include "SpinGenApi/SpinnakerGenApi.h"
 #include "ImageUtilityCCM.h"
+#include "FrameStats.h"
+#include "ColorCorrectionKernel.h"
+#include "StreamProfile.h"
+#include "ConversionBackend.h"
+#include "BoundedQueue.h"
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <regex>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <functional>
 
 using namespace Spinnaker;
 using namespace Spinnaker::GenApi;
@@ -60,6 +74,70 @@ const uint64_t kExampleImageOffsetY = 0;
 const uint64_t kExampleImageSize = kExampleImageWidth * kExampleImageHeight * 3;
 const PixelFormatEnums kExampleImagePixelFormat = PixelFormat_BGR8;
 
+// Per-frame stage timings are printed at the end of acquisition and written to this CSV file
+// every kFrameStatsInterval seconds. Set the file name to empty to only print them.
+const string kFrameStatsFileName = "AcquisitionCCM-stats.csv";
+const double kFrameStatsInterval = 5.0;
+
+// Use the following enum and global constant to select whether grabbed images are converted,
+// color corrected and saved on the grab thread, by a pool of worker threads fed by the grab
+// loop so that consecutive frames are processed concurrently, or by the batched conversion backend
+// in ConversionBackend.h, which converts on the GPU when built with OpenCL support.
+enum ccmPipelineType
+{
+    CCM_INLINE,
+    CCM_WORKER_POOL,
+    CCM_CONVERSION_BACKEND
+};
+
+const ccmPipelineType kCCMPipeline = CCM_WORKER_POOL;
+
+// Number of CCM worker threads, and the number of grabbed images that may wait for a worker
+// before the grab loop blocks. Keep the queue depth below the stream buffer count so the camera
+// always has free buffers to fill.
+const unsigned int kNumCCMWorkers = 4;
+const unsigned int kCCMQueueDepth = 8;
+
+// Conversion backend used by CCM_CONVERSION_BACKEND. CONVERSION_BACKEND_AUTO uses OpenCL when the
+// example is built with CONVERSION_BACKEND_USE_OPENCL defined and a device is found, and
+// ImageProcessor otherwise.
+const conversionBackendType kConversionBackend = CONVERSION_BACKEND_AUTO;
+
+// Set SaveBeforeImage to false to skip saving each image before color correction, which halves the
+// number of jpeg encodes per frame.
+const bool SaveBeforeImage = true;
+
+// Use the following enum and global constant to select whether the CCM workers color correct images
+// with ImageUtilityCCM, or with the fixed-point SIMD kernel in ColorCorrectionKernel.h. The host kernel
+// applies a linear 3x3 matrix that is measured once per CCM setting from ImageUtilityCCM; settings
+// that do not behave linearly (for example the Advanced 9x3 type) fall back to ImageUtilityCCM.
+enum ccmEngineType
+{
+    SPINNAKER_CCM_ENGINE,
+    HOST_CCM_ENGINE
+};
+
+const ccmEngineType kCCMEngine = SPINNAKER_CCM_ENGINE;
+
+// Use the following global constant to select the stream buffer profile. STREAM_PROFILE_NO_DROP
+// (OldestFirst, buffers sized for consumer stalls) keeps every frame for saving, and
+// STREAM_PROFILE_LOW_LATENCY (NewestOnly, few buffers) always hands over the most recent frame.
+const streamProfileType kStreamProfile = STREAM_PROFILE_NO_DROP;
+
+// Set FuseDemosaicCCM to true to demosaic 8-bit Bayer images and color correct them in one pass with
+// the host kernel, so that every pixel is only touched once. The fused path uses bilinear instead of
+// HQ linear interpolation, and is not used while SaveBeforeImage is set.
+const bool FuseDemosaicCCM = false;
+
+// Largest difference, as a fraction of full scale, between the measured matrix and ImageUtilityCCM
+// for the host kernel to be used.
+const float kHostCCMTolerance = 3.0f / 255.0f;
+
+// Set BenchmarkCCMEngines to true to time ImageUtilityCCM against the host kernel on the example
+// image after it has been color corrected (see UseExampleImageFile).
+const bool BenchmarkCCMEngines = true;
+const unsigned int kNumCCMBenchmarkIterations = 10;
+
 // Set UseExampleCCMCode to true to use the example custom CCM code below instead of going with the
 // pre-defined color correction matrix settings provided in the CCMSettings. This is intended to demonstrate
 // how to load a custom color correction matrix that is either encrypted based on a known matrix or provided 
@@ -81,6 +159,8 @@ const string kExampleCCMCode = "a3dc9a59f6c7e43ef86ed3c410f6374633d3fbeac484c65e
 "1a28a15b25ec38dccd9e336b8f0e53bf486ba024734ea74eb8e5539ff3e738ff4b19370f5958b6529f9751359e6ef1da1f9e34f75d20ac"
 "1dcb4ed864d573ee03d1af0a326533d871ad73821bdd6b378dc7f88d848a8598e1d0a38e05289b42b226ab6ac86d707e0dbee3f552c";
 
+// Serializes console output from the grab loop and the CCM workers
+mutex printMutex;
 
 // Disables or enables heartbeat on GEV cameras so debugging does not incur timeout errors
 int ConfigureGVCPHeartbeat(CameraPtr pCam, bool enableHeartbeat)
@@ -322,6 +402,304 @@ int PrintCCMSettings(CCMSettings& ccmSettings, string& fileNameSuffix)
     return 0;
 }
 
+//
+// This function measures the linear color correction matrix applied by ImageUtilityCCM for a setting
+//
+// *** NOTES ***
+// A small probe image holding a mid gray, the gray stepped up and down in each channel, and a few
+// validation colors is color corrected with ImageUtilityCCM. The steps give the columns of the 3x3
+// matrix, the gray gives the offset, and the validation colors check that the setting is in fact
+// linear. The probe is done in BGR16 where supported for a more precise matrix.
+//
+bool MeasureColorMatrix(const CCMSettings& ccmSettings, ColorMatrix& matrix, float& maxError)
+{
+    const size_t probeSize = 16;
+    const unsigned int numValidationColors = 4;
+    const float validationColors[numValidationColors][3] = {
+        {0.30f, 0.50f, 0.60f}, {0.60f, 0.40f, 0.35f}, {0.45f, 0.55f, 0.40f}, {0.40f, 0.40f, 0.60f}};
+    const float gray = 0.5f;
+    const float step = 0.125f;
+
+    const PixelFormatEnums probeFormats[2] = {PixelFormat_BGR16, PixelFormat_BGR8};
+
+    for (unsigned int f = 0; f < 2; f++)
+    {
+        const bool is16Bit = probeFormats[f] == PixelFormat_BGR16;
+        const float fullScale = is16Bit ? 65535.0f : 255.0f;
+        const size_t bytesPerChannel = is16Bit ? 2 : 1;
+
+        // Fill the probe with gray, then the stepped and validation colors from the first pixel on
+        vector<float> colors(probeSize * probeSize * 3, gray);
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            colors[(1 + i * 2) * 3 + i] = gray + step;
+            colors[(2 + i * 2) * 3 + i] = gray - step;
+        }
+        for (unsigned int v = 0; v < numValidationColors; v++)
+        {
+            for (unsigned int i = 0; i < 3; i++)
+            {
+                colors[(7 + v) * 3 + i] = validationColors[v][i];
+            }
+        }
+
+        vector<unsigned char> probeBuffer(colors.size() * bytesPerChannel);
+        vector<unsigned char> correctedBuffer(colors.size() * bytesPerChannel);
+        for (size_t j = 0; j < colors.size(); j++)
+        {
+            const unsigned int value = static_cast<unsigned int>(colors[j] * fullScale + 0.5f);
+            if (is16Bit)
+            {
+                reinterpret_cast<uint16_t*>(&probeBuffer[0])[j] = static_cast<uint16_t>(value);
+            }
+            else
+            {
+                probeBuffer[j] = static_cast<unsigned char>(value);
+            }
+        }
+
+        vector<float> corrected(colors.size());
+        try
+        {
+            ImagePtr probeImage = Image::Create(probeSize, probeSize, 0, 0, probeFormats[f], &probeBuffer[0]);
+            ImagePtr correctedImage = Image::Create(probeSize, probeSize, 0, 0, probeFormats[f], &correctedBuffer[0]);
+            ImageUtilityCCM::ColorCorrect(probeImage, correctedImage, ccmSettings);
+
+            for (size_t j = 0; j < colors.size(); j++)
+            {
+                const float value = is16Bit ? reinterpret_cast<const uint16_t*>(&correctedBuffer[0])[j]
+                                            : correctedBuffer[j];
+                corrected[j] = value / fullScale;
+            }
+        }
+        catch (Spinnaker::Exception&)
+        {
+            // Fall back to the 8-bit probe if BGR16 is not supported
+            continue;
+        }
+
+        for (unsigned int c = 0; c < 3; c++)
+        {
+            matrix.offset[c] = corrected[c];
+            for (unsigned int i = 0; i < 3; i++)
+            {
+                matrix.m[c][i] = (corrected[(1 + i * 2) * 3 + c] - corrected[(2 + i * 2) * 3 + c]) / (2.0f * step);
+                matrix.offset[c] -= matrix.m[c][i] * gray;
+            }
+        }
+
+        maxError = 0.0f;
+        for (unsigned int v = 0; v < numValidationColors; v++)
+        {
+            for (unsigned int c = 0; c < 3; c++)
+            {
+                float predicted = matrix.offset[c];
+                for (unsigned int i = 0; i < 3; i++)
+                {
+                    predicted += matrix.m[c][i] * validationColors[v][i];
+                }
+
+                // Clipped outputs cannot be compared
+                if (predicted > 0.0f && predicted < 1.0f)
+                {
+                    maxError = max(maxError, fabs(predicted - corrected[(7 + v) * 3 + c]));
+                }
+            }
+        }
+
+        return maxError <= kHostCCMTolerance;
+    }
+
+    return false;
+}
+
+// This function returns the host color correction kernel for a CCM setting, measuring its matrix the
+// first time the setting is used. Returns nullptr if the setting cannot be applied by the host kernel.
+// It can be called from several threads; the first caller for a setting measures it while the others wait.
+const ColorCorrectionKernel* GetHostCCMKernel(const CCMSettings& ccmSettings)
+{
+    static map<string, shared_ptr<ColorCorrectionKernel>> kernels;
+    static mutex kernelsMutex;
+    lock_guard<mutex> kernelsLock(kernelsMutex);
+
+    ostringstream key;
+    key << ccmSettings.ColorTemperature << "-" << ccmSettings.Sensor << "-" << ccmSettings.Type << "-"
+        << ccmSettings.ColorSpace << "-" << ccmSettings.Application << "-" << ccmSettings.CustomCCMCode;
+
+    map<string, shared_ptr<ColorCorrectionKernel>>::const_iterator it = kernels.find(key.str());
+    if (it != kernels.end())
+    {
+        return it->second.get();
+    }
+
+    ColorMatrix matrix;
+    float maxError = 0.0f;
+    shared_ptr<ColorCorrectionKernel> kernel;
+
+    if (MeasureColorMatrix(ccmSettings, matrix, maxError))
+    {
+        kernel = shared_ptr<ColorCorrectionKernel>(new ColorCorrectionKernel(matrix));
+        if (!kernel->IsValid())
+        {
+            kernel = nullptr;
+        }
+    }
+
+    lock_guard<mutex> printLock(printMutex);
+    if (kernel == nullptr)
+    {
+        cout << "CCM setting is not a linear matrix the host kernel can apply (error " << maxError * 255.0f
+             << " of 255); using ImageUtilityCCM..." << endl;
+    }
+    else
+    {
+        cout << "Host CCM matrix (B, G, R rows; " << ColorCorrectionKernel::GetInstructionSet() << "):" << endl;
+        for (unsigned int c = 0; c < 3; c++)
+        {
+            cout << "   " << matrix.m[c][0] << ", " << matrix.m[c][1] << ", " << matrix.m[c][2] << " + "
+                 << matrix.offset[c] << endl;
+        }
+    }
+
+    kernels[key.str()] = kernel;
+    return kernel.get();
+}
+
+// Returns the average time in milliseconds of one call to body
+double TimeIterations(const function<void()>& body, unsigned int numIterations)
+{
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < numIterations; i++)
+    {
+        body();
+    }
+    const chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() / numIterations;
+}
+
+// Prints the time of one benchmark case and the resulting throughput
+void PrintBenchmarkResult(const string& name, double milliseconds, size_t numPixels)
+{
+    cout << "   " << name << ": " << milliseconds << " ms/image ("
+         << (milliseconds > 0.0 ? numPixels / (milliseconds * 1000.0) : 0.0) << " MP/s)" << endl;
+}
+
+//
+// This function times ImageUtilityCCM against the host kernel on the example image
+//
+// *** NOTES ***
+// Every engine color corrects the same BGR8 image kNumCCMBenchmarkIterations times. For the fused
+// path the example image is first sampled into a BayerRG8 mosaic, and compared against converting
+// that mosaic with the image processor followed by ImageUtilityCCM. The host outputs are compared
+// with the ImageUtilityCCM output, and the host kernel result is saved for visual comparison.
+//
+int BenchmarkColorCorrection(const ImagePtr& sourceImage, const CCMSettings& ccmSettings, const string& fileNameSuffix)
+{
+    cout << endl << "*** CCM BENCHMARK ***" << endl << endl;
+
+    const ColorCorrectionKernel* pHostKernel = GetHostCCMKernel(ccmSettings);
+    if (pHostKernel == nullptr)
+    {
+        return 0;
+    }
+
+    try
+    {
+        const size_t width = sourceImage->GetWidth();
+        const size_t height = sourceImage->GetHeight();
+        const size_t numPixels = width * height;
+
+        vector<unsigned char> sdkBuffer(numPixels * 3);
+        vector<unsigned char> hostBuffer(numPixels * 3);
+        ImagePtr sdkImage = Image::Create(width, height, 0, 0, PixelFormat_BGR8, &sdkBuffer[0]);
+        ImagePtr hostImage = Image::Create(width, height, 0, 0, PixelFormat_BGR8, &hostBuffer[0]);
+
+        cout << "Color correcting " << width << "x" << height << " BGR8 " << kNumCCMBenchmarkIterations
+             << " times per engine..." << endl;
+
+        PrintBenchmarkResult(
+            "ImageUtilityCCM::CreateColorCorrected",
+            TimeIterations([&]() { ImageUtilityCCM::CreateColorCorrected(sourceImage, ccmSettings); },
+                           kNumCCMBenchmarkIterations),
+            numPixels);
+        PrintBenchmarkResult(
+            "ImageUtilityCCM::ColorCorrect",
+            TimeIterations([&]() { ImageUtilityCCM::ColorCorrect(sourceImage, sdkImage, ccmSettings); },
+                           kNumCCMBenchmarkIterations),
+            numPixels);
+        PrintBenchmarkResult(
+            "Host kernel (scalar)",
+            TimeIterations([&]() { pHostKernel->Apply(sourceImage, hostImage, false); }, kNumCCMBenchmarkIterations),
+            numPixels);
+        PrintBenchmarkResult(
+            string("Host kernel (") + ColorCorrectionKernel::GetInstructionSet() + ")",
+            TimeIterations([&]() { pHostKernel->Apply(sourceImage, hostImage); }, kNumCCMBenchmarkIterations),
+            numPixels);
+
+        // Compare the host kernel output against ImageUtilityCCM
+        unsigned int maxDifference = 0;
+        uint64_t totalDifference = 0;
+        for (size_t j = 0; j < sdkBuffer.size(); j++)
+        {
+            const unsigned int difference = static_cast<unsigned int>(abs(sdkBuffer[j] - hostBuffer[j]));
+            maxDifference = max(maxDifference, difference);
+            totalDifference += difference;
+        }
+        cout << "   Host kernel vs ImageUtilityCCM: mean difference "
+             << static_cast<double>(totalDifference) / sdkBuffer.size() << ", max difference " << maxDifference
+             << " of 255" << endl;
+
+        ostringstream filename;
+        filename << "AcquisitionCCM-Example-Host" << fileNameSuffix << ".jpg";
+        hostImage->Save(filename.str().c_str());
+        cout << "   Host kernel image saved at " << filename.str() << endl;
+
+        // Sample the example image into a BayerRG8 mosaic for the fused demosaic path
+        vector<unsigned char> bayerBuffer(numPixels);
+        const unsigned char* bgr = static_cast<const unsigned char*>(sourceImage->GetData());
+        const size_t bgrStride = sourceImage->GetStride();
+        for (size_t y = 0; y < height; y++)
+        {
+            for (size_t x = 0; x < width; x++)
+            {
+                // Channel index within the BGR pixel of an RGGB tile position
+                const size_t channel = (y & 1) == 0 ? ((x & 1) == 0 ? 2 : 1) : ((x & 1) == 0 ? 1 : 0);
+                bayerBuffer[y * width + x] = bgr[y * bgrStride + x * 3 + channel];
+            }
+        }
+        ImagePtr bayerImage = Image::Create(width, height, 0, 0, PixelFormat_BayerRG8, &bayerBuffer[0]);
+
+        vector<unsigned char> convertedBuffer(numPixels * 3);
+        ImagePtr convertedImage = Image::Create(width, height, 0, 0, PixelFormat_BGR8, &convertedBuffer[0]);
+
+        ImageProcessor processor;
+        processor.SetColorProcessing(SPINNAKER_COLOR_PROCESSING_ALGORITHM_HQ_LINEAR);
+
+        cout << endl << "Demosaicing and color correcting the BayerRG8 mosaic of the example image..." << endl;
+
+        PrintBenchmarkResult(
+            "ImageProcessor::Convert + ImageUtilityCCM::ColorCorrect",
+            TimeIterations(
+                [&]() {
+                    processor.Convert(bayerImage, convertedImage, PixelFormat_BGR8);
+                    ImageUtilityCCM::ColorCorrect(convertedImage, sdkImage, ccmSettings);
+                },
+                kNumCCMBenchmarkIterations),
+            numPixels);
+        PrintBenchmarkResult(
+            "Host fused demosaic + CCM",
+            TimeIterations([&]() { pHostKernel->DemosaicAndApply(bayerImage, hostImage); }, kNumCCMBenchmarkIterations),
+            numPixels);
+    }
+    catch (Spinnaker::Exception& e)
+    {
+        cout << "Error: " << e.what() << endl;
+        return -1;
+    }
+
+    return 0;
+}
+
 int RunColorCorrectionOnExampleImage()
 {
     int result = 0;
@@ -384,6 +762,11 @@ int RunColorCorrectionOnExampleImage()
         // Save image
         colorCorrectedImage->Save(filename.str().c_str());
         cout << "Image saved at " << filename.str() << endl;
+
+        if (BenchmarkCCMEngines)
+        {
+            result = result | BenchmarkColorCorrection(sourceImage, ccmSettings, fileNameSuffix);
+        }
     }
     catch (Spinnaker::Exception& e)
     {
@@ -394,6 +777,474 @@ int RunColorCorrectionOnExampleImage()
     return result;
 }
 
+// Preallocated BGR8 destination images that one CCM worker converts and color corrects every frame
+// into, instead of allocating two new images per frame. The buffers are only reallocated when the
+// image size changes.
+class CCMBuffers
+{
+public:
+    CCMBuffers() : m_width(0), m_height(0) {};
+    ~CCMBuffers() {};
+
+    void Reserve(size_t width, size_t height)
+    {
+        if (width == m_width && height == m_height)
+        {
+            return;
+        }
+
+        m_width = width;
+        m_height = height;
+        m_convertedBuffer.assign(width * height * 3, 0);
+        m_correctedBuffer.assign(width * height * 3, 0);
+        m_converted = Image::Create(width, height, 0, 0, PixelFormat_BGR8, &m_convertedBuffer[0]);
+        m_corrected = Image::Create(width, height, 0, 0, PixelFormat_BGR8, &m_correctedBuffer[0]);
+    }
+
+    ImagePtr GetConverted() const
+    {
+        return m_converted;
+    }
+
+    ImagePtr GetCorrected() const
+    {
+        return m_corrected;
+    }
+
+private:
+    size_t m_width;
+    size_t m_height;
+    vector<unsigned char> m_convertedBuffer;
+    vector<unsigned char> m_correctedBuffer;
+    ImagePtr m_converted;
+    ImagePtr m_corrected;
+};
+
+// A grabbed image waiting for a CCM worker, and its index in the acquisition
+struct CCMJob
+{
+    ImagePtr pImage;
+    unsigned int imageCnt;
+};
+
+// CCM worker thread body; converts each grabbed image into the worker's own buffers, returns the
+// camera buffer as soon as it has been converted, then color corrects and saves the image. Images are
+// color corrected by the host kernel when one is given, and by ImageUtilityCCM otherwise.
+void ColorCorrectImages(
+    BoundedQueue<CCMJob>& jobs,
+    const CCMSettings& ccmSettings,
+    const ColorCorrectionKernel* pHostKernel,
+    const string& filePrefix,
+    const string& fileNameSuffix,
+    FrameStats& stats,
+    atomic<unsigned int>& numCorrected,
+    atomic<int>& result)
+{
+    // ImageProcessor is not shared between threads, so every worker keeps its own instance
+    ImageProcessor processor;
+    processor.SetColorProcessing(SPINNAKER_COLOR_PROCESSING_ALGORITHM_HQ_LINEAR);
+
+    CCMBuffers buffers;
+    FrameRecorder& frameRecorder = stats.CreateRecorder();
+    CCMJob job;
+
+    // The fused path writes the corrected image directly, so there is no Before image to save
+    const bool fuseDemosaic = pHostKernel != nullptr && FuseDemosaicCCM && !SaveBeforeImage;
+
+    while (jobs.Pop(job))
+    {
+        bool converted = false;
+        bool corrected = false;
+
+        try
+        {
+            buffers.Reserve(job.pImage->GetWidth(), job.pImage->GetHeight());
+
+            if (fuseDemosaic)
+            {
+                // Demosaic and color correct in one pass; false if the image is not 8-bit Bayer
+                ImagePtr colorCorrectedImage = buffers.GetCorrected();
+
+                StageTimer ccmTimer(frameRecorder, STAGE_CCM);
+                corrected = pHostKernel->DemosaicAndApply(job.pImage, colorCorrectedImage);
+            }
+
+            if (!corrected)
+            {
+                // Convert image to BGR 8
+                ImagePtr convertedImage = buffers.GetConverted();
+
+                StageTimer convertTimer(frameRecorder, STAGE_CONVERT);
+                processor.Convert(job.pImage, convertedImage, PixelFormat_BGR8);
+                convertTimer.Stop();
+            }
+            converted = true;
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Error: " << e.what() << endl;
+            result = -1;
+        }
+
+        // Release image
+        StageTimer releaseTimer(frameRecorder, STAGE_RELEASE);
+        job.pImage->Release();
+        job.pImage = nullptr;
+        releaseTimer.Stop();
+
+        if (!converted)
+        {
+            continue;
+        }
+
+        try
+        {
+            if (SaveBeforeImage)
+            {
+                ostringstream filenameBefore;
+                filenameBefore << filePrefix << job.imageCnt << "-Before.jpg";
+
+                StageTimer saveBeforeTimer(frameRecorder, STAGE_SAVE);
+                buffers.GetConverted()->Save(filenameBefore.str().c_str());
+            }
+
+            // Color correct into the preallocated destination image
+            ImagePtr colorCorrectedImage = buffers.GetCorrected();
+
+            if (!corrected)
+            {
+                StageTimer ccmTimer(frameRecorder, STAGE_CCM);
+                if (pHostKernel == nullptr || !pHostKernel->Apply(buffers.GetConverted(), colorCorrectedImage))
+                {
+                    ImageUtilityCCM::ColorCorrect(buffers.GetConverted(), colorCorrectedImage, ccmSettings);
+                }
+            }
+
+            // Create a unique filename
+            ostringstream filename;
+            filename << filePrefix << job.imageCnt << fileNameSuffix << ".jpg";
+
+            // Save image
+            StageTimer saveTimer(frameRecorder, STAGE_SAVE);
+            colorCorrectedImage->Save(filename.str().c_str());
+            saveTimer.Stop();
+
+            numCorrected++;
+
+            lock_guard<mutex> lock(printMutex);
+            cout << "Image saved at " << filename.str() << endl;
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Error: " << e.what() << endl;
+            result = -1;
+        }
+
+        stats.ReportIfDue();
+    }
+}
+
+//
+// This function grabs images on the calling thread and hands them to a pool of CCM workers
+//
+// *** NOTES ***
+// The grab loop only waits for the camera, so images are pulled off the stream at the camera's
+// frame rate while up to kNumCCMWorkers frames are converted, color corrected and saved at the
+// same time. If the workers fall behind, the queue fills and holds back the grab loop rather than
+// growing without bound.
+//
+int AcquireImagesWorkerPool(
+    CameraPtr pCam,
+    unsigned int numImages,
+    const CCMSettings& ccmSettings,
+    const string& filePrefix,
+    const string& fileNameSuffix,
+    FrameStats& stats)
+{
+    int result = 0;
+    atomic<unsigned int> numCorrected(0);
+    atomic<int> workerResult(0);
+    BoundedQueue<CCMJob> jobs(kCCMQueueDepth);
+    FrameRecorder& frameRecorder = stats.CreateRecorder();
+
+    // Measure the host kernel's matrix before the workers start
+    const ColorCorrectionKernel* pHostKernel = kCCMEngine == HOST_CCM_ENGINE ? GetHostCCMKernel(ccmSettings) : nullptr;
+
+    vector<thread> workers;
+    for (unsigned int i = 0; i < kNumCCMWorkers; i++)
+    {
+        workers.push_back(thread(
+            ColorCorrectImages,
+            ref(jobs),
+            cref(ccmSettings),
+            pHostKernel,
+            cref(filePrefix),
+            cref(fileNameSuffix),
+            ref(stats),
+            ref(numCorrected),
+            ref(workerResult)));
+    }
+
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    for (unsigned int imageCnt = 0; imageCnt < numImages; imageCnt++)
+    {
+        try
+        {
+            // Retrieve next received image
+            StageTimer getTimer(frameRecorder, STAGE_GET_NEXT_IMAGE);
+            ImagePtr pResultImage = pCam->GetNextImage(1000);
+            getTimer.Stop();
+            frameRecorder.RecordFrame(pResultImage);
+
+            // Ensure image completion
+            if (pResultImage->IsIncomplete())
+            {
+                {
+                    lock_guard<mutex> lock(printMutex);
+                    cout << "Image incomplete: " << Image::GetImageStatusDescription(pResultImage->GetImageStatus())
+                         << "..." << endl
+                         << endl;
+                }
+
+                // Release image
+                StageTimer releaseTimer(frameRecorder, STAGE_RELEASE);
+                pResultImage->Release();
+                continue;
+            }
+
+            {
+                lock_guard<mutex> lock(printMutex);
+                cout << "Grabbed image " << imageCnt << ", width = " << pResultImage->GetWidth()
+                     << ", height = " << pResultImage->GetHeight() << endl;
+            }
+
+            // Hand the image over; it is released by the worker once converted
+            CCMJob job;
+            job.pImage = pResultImage;
+            job.imageCnt = imageCnt;
+            jobs.Push(job);
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Error: " << e.what() << endl;
+            result = -1;
+        }
+    }
+
+    // Wait for the workers to finish the images still queued
+    jobs.Close();
+    for (unsigned int i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+
+    const double seconds =
+        chrono::duration_cast<chrono::duration<double>>(chrono::steady_clock::now() - start).count();
+
+    cout << endl
+         << "Color corrected " << numCorrected << " images in " << seconds << " s ("
+         << (seconds > 0.0 ? numCorrected / seconds : 0.0) << " fps) with " << kNumCCMWorkers << " workers" << endl
+         << endl;
+
+    return result | workerResult;
+}
+
+// Saver thread body for the conversion backend; color corrects the converted images that the backend
+// has not already corrected, saves them in the order they were grabbed, and hands each slot back.
+void SaveConvertedImages(
+    ConversionBackend& backend,
+    const CCMSettings& ccmSettings,
+    const ColorCorrectionKernel* pHostKernel,
+    const string& filePrefix,
+    const string& fileNameSuffix,
+    FrameStats& stats,
+    atomic<unsigned int>& numCorrected,
+    atomic<int>& result)
+{
+    CCMBuffers buffers;
+    FrameRecorder& frameRecorder = stats.CreateRecorder();
+    ConvertedFrame frame;
+
+    while (!backend.IsDrained())
+    {
+        if (!backend.Retrieve(frame, 100))
+        {
+            continue;
+        }
+
+        try
+        {
+            if (!frame.converted)
+            {
+                lock_guard<mutex> lock(printMutex);
+                cout << "Error: image " << frame.tag << " could not be converted" << endl;
+                result = -1;
+            }
+            else
+            {
+                if (SaveBeforeImage)
+                {
+                    ostringstream filenameBefore;
+                    filenameBefore << filePrefix << frame.tag << "-Before.jpg";
+
+                    StageTimer saveBeforeTimer(frameRecorder, STAGE_SAVE);
+                    frame.pImage->Save(filenameBefore.str().c_str());
+                }
+
+                ImagePtr colorCorrectedImage = frame.pImage;
+
+                if (!frame.colorCorrected)
+                {
+                    // Color correct into the preallocated destination image
+                    buffers.Reserve(frame.pImage->GetWidth(), frame.pImage->GetHeight());
+                    colorCorrectedImage = buffers.GetCorrected();
+
+                    StageTimer ccmTimer(frameRecorder, STAGE_CCM);
+                    if (pHostKernel == nullptr || !pHostKernel->Apply(frame.pImage, colorCorrectedImage))
+                    {
+                        ImageUtilityCCM::ColorCorrect(frame.pImage, colorCorrectedImage, ccmSettings);
+                    }
+                }
+
+                // Create a unique filename
+                ostringstream filename;
+                filename << filePrefix << frame.tag << fileNameSuffix << ".jpg";
+
+                // Save image
+                StageTimer saveTimer(frameRecorder, STAGE_SAVE);
+                colorCorrectedImage->Save(filename.str().c_str());
+                saveTimer.Stop();
+
+                numCorrected++;
+
+                lock_guard<mutex> lock(printMutex);
+                cout << "Image saved at " << filename.str() << (frame.onGpu ? " (converted on GPU)" : "") << endl;
+            }
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Error: " << e.what() << endl;
+            result = -1;
+        }
+
+        backend.Release(frame);
+        stats.ReportIfDue();
+    }
+}
+
+//
+// This function grabs images on the calling thread and converts them with the conversion backend
+//
+// *** NOTES ***
+// Each grabbed image is copied into one of the backend's slots and its camera buffer is released
+// straight away. The backend converts the slots in batches, on the GPU when OpenCL is available,
+// while a saver thread color corrects and saves the results. When the host kernel is used and no
+// Before image is saved, the color correction is fused into the GPU demosaic, which uses bilinear
+// instead of HQ linear interpolation.
+//
+int AcquireImagesConversionBackend(
+    CameraPtr pCam,
+    unsigned int numImages,
+    const CCMSettings& ccmSettings,
+    const string& filePrefix,
+    const string& fileNameSuffix,
+    FrameStats& stats)
+{
+    int result = 0;
+    atomic<unsigned int> numCorrected(0);
+    atomic<int> saverResult(0);
+    FrameRecorder& frameRecorder = stats.CreateRecorder();
+
+    // Measure the host kernel's matrix before the saver starts
+    const ColorCorrectionKernel* pHostKernel = kCCMEngine == HOST_CCM_ENGINE ? GetHostCCMKernel(ccmSettings) : nullptr;
+
+    ConversionBackend backend(kConversionBackend, PixelFormat_BGR8);
+    if (!SaveBeforeImage)
+    {
+        backend.SetColorCorrection(pHostKernel);
+    }
+    cout << "Converting with " << backend.GetName() << "..." << endl << endl;
+
+    thread saver(
+        SaveConvertedImages,
+        ref(backend),
+        cref(ccmSettings),
+        pHostKernel,
+        cref(filePrefix),
+        cref(fileNameSuffix),
+        ref(stats),
+        ref(numCorrected),
+        ref(saverResult));
+
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    for (unsigned int imageCnt = 0; imageCnt < numImages; imageCnt++)
+    {
+        try
+        {
+            // Retrieve next received image
+            StageTimer getTimer(frameRecorder, STAGE_GET_NEXT_IMAGE);
+            ImagePtr pResultImage = pCam->GetNextImage(1000);
+            getTimer.Stop();
+            frameRecorder.RecordFrame(pResultImage);
+
+            // Ensure image completion
+            if (pResultImage->IsIncomplete())
+            {
+                {
+                    lock_guard<mutex> lock(printMutex);
+                    cout << "Image incomplete: " << Image::GetImageStatusDescription(pResultImage->GetImageStatus())
+                         << "..." << endl
+                         << endl;
+                }
+
+                // Release image
+                StageTimer releaseTimer(frameRecorder, STAGE_RELEASE);
+                pResultImage->Release();
+                continue;
+            }
+
+            {
+                lock_guard<mutex> lock(printMutex);
+                cout << "Grabbed image " << imageCnt << ", width = " << pResultImage->GetWidth()
+                     << ", height = " << pResultImage->GetHeight() << endl;
+            }
+
+            // Copy the image into the backend, then return the camera buffer
+            backend.Submit(pResultImage, imageCnt);
+
+            StageTimer releaseTimer(frameRecorder, STAGE_RELEASE);
+            pResultImage->Release();
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Error: " << e.what() << endl;
+            result = -1;
+        }
+    }
+
+    // Convert the last partial batch and wait for the saver to drain the backend
+    backend.Finish();
+    saver.join();
+
+    const double seconds =
+        chrono::duration_cast<chrono::duration<double>>(chrono::steady_clock::now() - start).count();
+
+    cout << endl
+         << "Color corrected " << numCorrected << " images in " << seconds << " s ("
+         << (seconds > 0.0 ? numCorrected / seconds : 0.0) << " fps)" << endl;
+    backend.PrintStatistics();
+    cout << endl;
+
+    return result | saverResult;
+}
+
 // This function acquires, performs color correction on and saves 10 images from a device.
 int AcquireImages(CameraPtr pCam, INodeMap& nodeMap, INodeMap& nodeMapTLDevice)
 {
@@ -525,81 +1376,131 @@ int AcquireImages(CameraPtr pCam, INodeMap& nodeMap, INodeMap& nodeMapTLDevice)
         //
         processor.SetColorProcessing(SPINNAKER_COLOR_PROCESSING_ALGORITHM_HQ_LINEAR);
 
-        for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
+        // Time each stage of the acquisition loop
+        FrameStats stats("AcquisitionCCM", kFrameStatsFileName, kFrameStatsInterval);
+        FrameRecorder& frameRecorder = stats.CreateRecorder();
+
+        if (kCCMPipeline == CCM_WORKER_POOL || kCCMPipeline == CCM_CONVERSION_BACKEND)
         {
-            try
+            // Create the filename prefix shared by every image
+            ostringstream filePrefix;
+
+            filePrefix << "AcquisitionCCM-";
+            if (!deviceSerialNumber.empty())
             {
-                // Retrieve next received image
-                ImagePtr pResultImage = pCam->GetNextImage(1000);
+                filePrefix << deviceSerialNumber.c_str() << "-";
+            }
 
-                // Ensure image completion
-                if (pResultImage->IsIncomplete())
-                {
-                    // Retrieve and print the image status description
-                    cout << "Image incomplete: " << Image::GetImageStatusDescription(pResultImage->GetImageStatus())
-                        << "..." << endl
-                        << endl;
-                }
-                else
+            if (kCCMPipeline == CCM_WORKER_POOL)
+            {
+                result = result | AcquireImagesWorkerPool(pCam, k_numImages, ccmSettings, filePrefix.str(), fileNameSuffix, stats);
+            }
+            else
+            {
+                result = result | AcquireImagesConversionBackend(
+                                      pCam, k_numImages, ccmSettings, filePrefix.str(), fileNameSuffix, stats);
+            }
+        }
+        else
+        {
+            for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
+            {
+                try
                 {
-                    // Print image information; height and width recorded in pixels
+                    // Retrieve next received image
+                    StageTimer getTimer(frameRecorder, STAGE_GET_NEXT_IMAGE);
+                    ImagePtr pResultImage = pCam->GetNextImage(1000);
+                    getTimer.Stop();
+                    frameRecorder.RecordFrame(pResultImage);
+
+                    // Ensure image completion
+                    if (pResultImage->IsIncomplete())
+                    {
+                        // Retrieve and print the image status description
+                        cout << "Image incomplete: " << Image::GetImageStatusDescription(pResultImage->GetImageStatus())
+                            << "..." << endl
+                            << endl;
+                    }
+                    else
+                    {
+                        // Print image information; height and width recorded in pixels
 
-                    const size_t width = pResultImage->GetWidth();
+                        const size_t width = pResultImage->GetWidth();
 
-                    const size_t height = pResultImage->GetHeight();
+                        const size_t height = pResultImage->GetHeight();
 
-                    cout << "Grabbed image " << imageCnt << ", width = " << width << ", height = " << height << endl;
+                        cout << "Grabbed image " << imageCnt << ", width = " << width << ", height = " << height << endl;
 
-                    // Convert image to BGR 8
-                    ImagePtr convertedImage = processor.Convert(pResultImage, PixelFormat_BGR8);
+                        // Convert image to BGR 8
+                        StageTimer convertTimer(frameRecorder, STAGE_CONVERT);
+                        ImagePtr convertedImage = processor.Convert(pResultImage, PixelFormat_BGR8);
+                        convertTimer.Stop();
 
-                    // Create a unique filename
-                    ostringstream filenameBefore;
+                        if (SaveBeforeImage)
+                        {
+                            // Create a unique filename
+                            ostringstream filenameBefore;
 
-                    filenameBefore << "AcquisitionCCM-";
-                    if (!deviceSerialNumber.empty())
-                    {
-                        filenameBefore << deviceSerialNumber.c_str() << "-";
-                    }
-                    filenameBefore << imageCnt << "-Before.jpg";
+                            filenameBefore << "AcquisitionCCM-";
+                            if (!deviceSerialNumber.empty())
+                            {
+                                filenameBefore << deviceSerialNumber.c_str() << "-";
+                            }
+                            filenameBefore << imageCnt << "-Before.jpg";
 
-                    // Save image
-                    convertedImage->Save(filenameBefore.str().c_str());
+                            // Save image
+                            StageTimer saveBeforeTimer(frameRecorder, STAGE_SAVE);
+                            convertedImage->Save(filenameBefore.str().c_str());
+                            saveBeforeTimer.Stop();
 
-                    cout << "Image saved at " << filenameBefore.str() << endl;
+                            cout << "Image saved at " << filenameBefore.str() << endl;
+                        }
 
-                    ImagePtr colorCorrectedImage = ImageUtilityCCM::CreateColorCorrected(
-                        convertedImage,
-                        ccmSettings);
+                        StageTimer ccmTimer(frameRecorder, STAGE_CCM);
+                        ImagePtr colorCorrectedImage = ImageUtilityCCM::CreateColorCorrected(
+                            convertedImage,
+                            ccmSettings);
+                        ccmTimer.Stop();
 
-                    // Create a unique filename
-                    ostringstream filename;
+                        // Create a unique filename
+                        ostringstream filename;
 
-                    filename << "AcquisitionCCM-";
-                    if (!deviceSerialNumber.empty())
-                    {
-                        filename << deviceSerialNumber.c_str() << "-";
-                    }
-                    filename << imageCnt << fileNameSuffix << ".jpg";
+                        filename << "AcquisitionCCM-";
+                        if (!deviceSerialNumber.empty())
+                        {
+                            filename << deviceSerialNumber.c_str() << "-";
+                        }
+                        filename << imageCnt << fileNameSuffix << ".jpg";
 
-                    // Save image
-                    colorCorrectedImage->Save(filename.str().c_str());
+                        // Save image
+                        StageTimer saveTimer(frameRecorder, STAGE_SAVE);
+                        colorCorrectedImage->Save(filename.str().c_str());
+                        saveTimer.Stop();
 
-                    cout << "Image saved at " << filename.str() << endl;
-                }
+                        cout << "Image saved at " << filename.str() << endl;
+                    }
 
-                // Release image
-                pResultImage->Release();
+                    // Release image
+                    StageTimer releaseTimer(frameRecorder, STAGE_RELEASE);
+                    pResultImage->Release();
+                    releaseTimer.Stop();
 
-                cout << endl;
-            }
-            catch (Spinnaker::Exception& e)
-            {
-                cout << "Error: " << e.what() << endl;
-                result = -1;
+                    stats.ReportIfDue();
+
+                    cout << endl;
+                }
+                catch (Spinnaker::Exception& e)
+                {
+                    cout << "Error: " << e.what() << endl;
+                    result = -1;
+                }
             }
         }
 
+        // Print the stage timings and stream statistics
+        stats.RecordStreamStatistics(pCam->GetTLStreamNodeMap());
+        stats.Report();
+
         // End acquisition
         pCam->EndAcquisition();
     }
@@ -677,9 +1578,19 @@ int RunSingleCamera(CameraPtr pCam)
         result = result | ResetGVCPHeartbeat(pCam);
 #endif
 
+        // Configure stream buffers
+        StreamSettings streamSettings;
+        if (!ApplyStreamProfile(pCam, kStreamProfile, streamSettings))
+        {
+            cout << "Unable to apply every stream buffer setting; continuing with the settings below..." << endl;
+        }
+        PrintStreamSettings(streamSettings);
+
         // Acquire images
         result = result | AcquireImages(pCam, nodeMap, nodeMapTLDevice);
 
+        PrintStreamDrops(pCam, streamSettings);
+
 #ifdef _DEBUG
         // Reset heartbeat for GEV camera
         result = result | ResetGVCPHeartbeat(pCam);
@@ -26,9 +26,29 @@
 #include "SpinGenApi/SpinnakerGenApi.h"
 #include <iostream>
 #include <sstream>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
 
 #include "opencv2/highgui.hpp"
 #include "opencv2/imgproc.hpp"
+#include "opencv2/core/ocl.hpp"
+
+#include "FrameStats.h"
+#include "StreamProfile.h"
+#include "BoundedQueue.h"
+
+// Set to 1 when OpenCV has been built with the CUDA modules to make the
+// OPENCV_CUDA_DEMOSAIC backend available
+#define USE_OPENCV_CUDA 0
+
+#if USE_OPENCV_CUDA
+#include "opencv2/cudaimgproc.hpp"
+#endif
 
 using namespace Spinnaker;
 using namespace Spinnaker::GenApi;
@@ -38,6 +58,60 @@ using namespace cv;
 
 #define WINDOW_NAME "Current Image"
 
+// Use the following enum and global constant to select whether images are
+// displayed and saved inline on the acquisition loop, or handed from a grab
+// thread to separate display and encode stages.
+enum pipelineType
+{
+    INLINE,
+    PIPELINED
+};
+
+const pipelineType chosenPipeline = PIPELINED;
+
+// Number of grabbed images that may wait for the encode stage, and the
+// number of threads encoding them
+const unsigned int k_encodeQueueDepth = 8;
+const unsigned int k_numEncodeThreads = 2;
+
+// Use the following enum and global constant to select how Bayer images are
+// demosaiced into BGR before display and encoding. Images in other pixel
+// formats are passed through unchanged.
+enum demosaicType
+{
+    SPINNAKER_DEMOSAIC,
+    OPENCV_DEMOSAIC,
+    OPENCV_UMAT_DEMOSAIC,
+    OPENCV_CUDA_DEMOSAIC
+};
+
+const demosaicType chosenDemosaic = OPENCV_DEMOSAIC;
+
+// Number of grabbed images that may wait for the demosaic stage, and the
+// number of threads demosaicing them
+const unsigned int k_demosaicQueueDepth = 4;
+const unsigned int k_numDemosaicThreads = 4;
+
+// Time every available demosaic backend on the first grabbed image
+const bool k_compareDemosaic = true;
+const unsigned int k_numDemosaicBenchmarkIterations = 10;
+
+// Per-frame stage timings are printed at the end of acquisition and written
+// to this CSV file every k_frameStatsInterval seconds (empty to disable)
+const char* const k_frameStatsCsv = "AcquisitionOpenCV-stats.csv";
+const double k_frameStatsInterval = 5.0;
+
+// Use the following global constant to select the stream buffer profile.
+// STREAM_PROFILE_LOW_LATENCY (NewestOnly, few buffers) keeps the displayed
+// image current and skips frames the loop could not keep up with, while
+// STREAM_PROFILE_NO_DROP (OldestFirst, buffers sized for consumer stalls)
+// keeps every frame for saving. The pipeline holds mono frames in their stream
+// buffers while they wait in the demosaic and encode queues, which needs more
+// buffers than the low latency profile has, so only select it for INLINE.
+const streamProfileType chosenStreamProfile = STREAM_PROFILE_NO_DROP;
+
+mutex printMutex;
+
 #ifdef _DEBUG
 // Disables heartbeat on GEV cameras so debugging does not incur timeout errors
 int DisableHeartbeat(INodeMap & nodeMap, INodeMap & nodeMapTLDevice)
@@ -92,6 +166,551 @@ int DisableHeartbeat(INodeMap & nodeMap, INodeMap & nodeMapTLDevice)
 }
 #endif
 
+// Wrap the image data in an OpenCV Mat without copying it
+Mat WrapImage(const ImagePtr & pImage)
+{
+    unsigned int rows = pImage->GetHeight();
+    unsigned int cols = pImage->GetWidth();
+    unsigned int num_channels = pImage->GetNumChannels();
+    void *image_data = pImage->GetData();
+    unsigned int stride = pImage->GetStride();
+    return cv::Mat(rows, cols, (num_channels == 3) ? CV_8UC3 : CV_8UC1, image_data, stride);
+}
+
+// A grabbed image shared by the display and encode stages. The Spinnaker
+// buffer is released back to the stream as soon as the last stage holding it
+// lets go, rather than after both have finished with the frame.
+//
+// *** NOTES ***
+// The Mat either wraps pImage in place or, for demosaiced frames, holds its
+// own copy; pImage is then the converted image backing it (if any) and is not
+// a stream buffer, so it is not released.
+//
+struct SharedFrame
+{
+    SharedFrame(ImagePtr image, const Mat & view, unsigned int count, bool streamBuffer)
+        : pImage(image), image(view), imageCnt(count), isStreamBuffer(streamBuffer) {};
+
+    ~SharedFrame()
+    {
+        if (!isStreamBuffer)
+        {
+            return;
+        }
+
+        try
+        {
+            pImage->Release();
+        }
+        catch (Spinnaker::Exception &e)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Error: " << e.what() << endl;
+        }
+    }
+
+    ImagePtr pImage;
+    Mat image;
+    unsigned int imageCnt;
+    bool isStreamBuffer;
+};
+
+typedef shared_ptr<SharedFrame> SharedFramePtr;
+
+// Single slot holding the most recent frame for display. Putting a new frame
+// replaces one that has not been shown yet, so a slow display drops frames
+// instead of queueing them and holding back the grab thread.
+class LatestFrame
+{
+public:
+
+    LatestFrame() : m_closed(false), m_numDropped(0) {};
+
+    void Put(const SharedFramePtr & frame)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (m_frame)
+        {
+            m_numDropped++;
+
+            // Frames demosaiced on several threads can arrive out of order
+            if (frame->imageCnt < m_frame->imageCnt)
+            {
+                return;
+            }
+        }
+        m_frame = frame;
+        m_ready.notify_one();
+    }
+
+    // Returns false once the slot has been closed and the last frame taken
+    bool Take(SharedFramePtr & frame)
+    {
+        unique_lock<mutex> lock(m_mutex);
+        m_ready.wait(lock, [this] { return m_frame || m_closed; });
+        if (!m_frame)
+        {
+            return false;
+        }
+
+        frame = m_frame;
+        m_frame.reset();
+        return true;
+    }
+
+    void Close()
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_closed = true;
+        m_ready.notify_all();
+    }
+
+    unsigned int GetNumDropped()
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return m_numDropped;
+    }
+
+private:
+
+    bool m_closed;
+    unsigned int m_numDropped;
+    SharedFramePtr m_frame;
+    mutex m_mutex;
+    condition_variable m_ready;
+};
+
+// Returns the OpenCV conversion code for demosaicing an 8-bit Bayer pixel
+// format into BGR, or -1 if the pixel format is not 8-bit Bayer.
+//
+// *** NOTES ***
+// OpenCV names its Bayer patterns after the second row of the sensor, so the
+// Bayer*2RGB codes (which match the camera's pattern names) produce the BGR
+// channel order that imshow and imwrite expect.
+//
+int GetBayerConversionCode(PixelFormatEnums pixelFormat)
+{
+    switch (pixelFormat)
+    {
+    case PixelFormat_BayerRG8:
+        return COLOR_BayerRG2RGB;
+    case PixelFormat_BayerGB8:
+        return COLOR_BayerGB2RGB;
+    case PixelFormat_BayerGR8:
+        return COLOR_BayerGR2RGB;
+    case PixelFormat_BayerBG8:
+        return COLOR_BayerBG2RGB;
+    default:
+        return -1;
+    }
+}
+
+const char* GetDemosaicName(demosaicType backend)
+{
+    switch (backend)
+    {
+    case SPINNAKER_DEMOSAIC:
+        return "Spinnaker ImageProcessor (HQ linear)";
+    case OPENCV_DEMOSAIC:
+        return "OpenCV cvtColor";
+    case OPENCV_UMAT_DEMOSAIC:
+        return "OpenCV cvtColor on UMat (OpenCL)";
+    case OPENCV_CUDA_DEMOSAIC:
+        return "OpenCV CUDA demosaicing";
+    default:
+        return "Unknown";
+    }
+}
+
+// Returns whether the backend can run on this machine
+bool IsDemosaicAvailable(demosaicType backend)
+{
+    switch (backend)
+    {
+    case OPENCV_UMAT_DEMOSAIC:
+        return cv::ocl::haveOpenCL();
+    case OPENCV_CUDA_DEMOSAIC:
+#if USE_OPENCV_CUDA
+        return cuda::getCudaEnabledDeviceCount() > 0;
+#else
+        return false;
+#endif
+    default:
+        return true;
+    }
+}
+
+// Falls back to the OpenCV CPU backend if the requested one is not available
+demosaicType ResolveDemosaicBackend(demosaicType requested)
+{
+    if (!IsDemosaicAvailable(requested))
+    {
+        cout << GetDemosaicName(requested) << " is not available, using " << GetDemosaicName(OPENCV_DEMOSAIC) << " instead..." << endl;
+        return OPENCV_DEMOSAIC;
+    }
+
+    if (requested == OPENCV_UMAT_DEMOSAIC)
+    {
+        cv::ocl::setUseOpenCL(true);
+    }
+
+    cout << "Demosaicing Bayer images with " << GetDemosaicName(requested) << "..." << endl;
+    return requested;
+}
+
+// Per-thread state for the demosaic backends, so that their intermediate
+// buffers are reused from one frame to the next
+struct DemosaicContext
+{
+    DemosaicContext()
+    {
+        processor.SetColorProcessing(SPINNAKER_COLOR_PROCESSING_ALGORITHM_HQ_LINEAR);
+    }
+
+    ImageProcessor processor;
+    UMat source;
+    UMat demosaiced;
+#if USE_OPENCV_CUDA
+    cuda::GpuMat gpuSource;
+    cuda::GpuMat gpuDemosaiced;
+#endif
+};
+
+// Demosaic a Bayer image into a BGR Mat with the given backend. For the
+// Spinnaker backend the returned Mat wraps pConverted, which must be kept
+// alive for as long as the Mat is used.
+Mat DemosaicImage(const ImagePtr & pImage, int bayerCode, demosaicType backend, DemosaicContext & context, ImagePtr & pConverted)
+{
+    Mat demosaiced;
+
+    switch (backend)
+    {
+    case SPINNAKER_DEMOSAIC:
+        pConverted = context.processor.Convert(pImage, PixelFormat_BGR8);
+        demosaiced = WrapImage(pConverted);
+        break;
+
+    case OPENCV_UMAT_DEMOSAIC:
+        WrapImage(pImage).copyTo(context.source);
+        cvtColor(context.source, context.demosaiced, bayerCode);
+        context.demosaiced.copyTo(demosaiced);
+        break;
+
+#if USE_OPENCV_CUDA
+    case OPENCV_CUDA_DEMOSAIC:
+        context.gpuSource.upload(WrapImage(pImage));
+        cuda::demosaicing(context.gpuSource, context.gpuDemosaiced, bayerCode);
+        context.gpuDemosaiced.download(demosaiced);
+        break;
+#endif
+
+    default:
+        cvtColor(WrapImage(pImage), demosaiced, bayerCode);
+        break;
+    }
+
+    return demosaiced;
+}
+
+// This function grabs one image and times each available demosaic backend on
+// it, so that the fastest one can be chosen for this camera and machine.
+int CompareDemosaicBackends(CameraPtr pCam)
+{
+    int result = 0;
+
+    cout << endl << "*** DEMOSAIC COMPARISON ***" << endl << endl;
+
+    try
+    {
+        ImagePtr pResultImage = pCam->GetNextImage();
+
+        const int bayerCode = GetBayerConversionCode(pResultImage->GetPixelFormat());
+        if (pResultImage->IsIncomplete() || bayerCode < 0)
+        {
+            cout << "Skipping comparison; the first image is incomplete or not 8-bit Bayer (" << pResultImage->GetPixelFormatName() << ")..." << endl;
+        }
+        else
+        {
+            const demosaicType backends[] = { SPINNAKER_DEMOSAIC, OPENCV_DEMOSAIC, OPENCV_UMAT_DEMOSAIC, OPENCV_CUDA_DEMOSAIC };
+            DemosaicContext context;
+
+            for (unsigned int i = 0; i < sizeof(backends) / sizeof(backends[0]); i++)
+            {
+                if (!IsDemosaicAvailable(backends[i]))
+                {
+                    cout << GetDemosaicName(backends[i]) << ": not available" << endl;
+                    continue;
+                }
+
+                // The first run allocates the backend's buffers and is not timed
+                ImagePtr pConverted;
+                DemosaicImage(pResultImage, bayerCode, backends[i], context, pConverted);
+
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                for (unsigned int iteration = 0; iteration < k_numDemosaicBenchmarkIterations; iteration++)
+                {
+                    DemosaicImage(pResultImage, bayerCode, backends[i], context, pConverted);
+                }
+                double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+                cout << GetDemosaicName(backends[i]) << ": " << ms / k_numDemosaicBenchmarkIterations << " ms per image" << endl;
+            }
+        }
+
+        pResultImage->Release();
+    }
+    catch (Spinnaker::Exception &e)
+    {
+        cout << "Error: " << e.what() << endl;
+        result = -1;
+    }
+
+    cout << endl;
+
+    return result;
+}
+
+// Grab stage of the pipeline; retrieves images and hands each complete one to
+// the demosaic stage without copying it
+void GrabImages(CameraPtr pCam, unsigned int numImages, BoundedQueue<SharedFramePtr> & demosaicQueue, FrameStats & stats, atomic<int> & result)
+{
+    FrameRecorder & frameRecorder = stats.CreateRecorder();
+
+    for (unsigned int imageCnt = 0; imageCnt < numImages; imageCnt++)
+    {
+        try
+        {
+            StageTimer getTimer(frameRecorder, STAGE_GET_NEXT_IMAGE);
+            ImagePtr pResultImage = pCam->GetNextImage();
+            getTimer.Stop();
+            frameRecorder.RecordFrame(pResultImage);
+            stats.ReportIfDue();
+
+            if (pResultImage->IsIncomplete())
+            {
+                lock_guard<mutex> lock(printMutex);
+                cout << "Image incomplete: "
+                    << Image::GetImageStatusDescription(pResultImage->GetImageStatus())
+                    << "..." << endl << endl;
+
+                pResultImage->Release();
+                continue;
+            }
+
+            {
+                lock_guard<mutex> lock(printMutex);
+                cout << "Grabbed image " << imageCnt << ", width = " << pResultImage->GetWidth() << ", height = " << pResultImage->GetHeight() << endl;
+            }
+
+            // The queue is closed early when a later stage has stopped the pipeline
+            if (!demosaicQueue.Push(make_shared<SharedFrame>(pResultImage, WrapImage(pResultImage), imageCnt, true)))
+            {
+                break;
+            }
+        }
+        catch (Spinnaker::Exception &e)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Error: " << e.what() << endl;
+            result = -1;
+        }
+        catch (std::exception &e)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Error: " << e.what() << endl;
+            result = -1;
+            break;
+        }
+    }
+
+    demosaicQueue.Close();
+}
+
+// Demosaic stage of the pipeline; converts Bayer images to BGR, returning the
+// Spinnaker buffer as soon as it has been converted, and hands every frame to
+// both the display slot and the encode queue. The last worker to finish
+// closes both. An OpenCV or allocation error, or an encode stage that has
+// stopped, closes the demosaic queue so that the grab thread stops too.
+void DemosaicImages(BoundedQueue<SharedFramePtr> & demosaicQueue, demosaicType backend, LatestFrame & display,
+    BoundedQueue<SharedFramePtr> & encodeQueue, atomic<unsigned int> & numActiveWorkers, FrameStats & stats, atomic<int> & result)
+{
+    FrameRecorder & frameRecorder = stats.CreateRecorder();
+    DemosaicContext context;
+    SharedFramePtr frame;
+
+    while (demosaicQueue.Pop(frame))
+    {
+        const int bayerCode = GetBayerConversionCode(frame->pImage->GetPixelFormat());
+        if (bayerCode >= 0)
+        {
+            try
+            {
+                ImagePtr pConverted;
+                StageTimer demosaicTimer(frameRecorder, STAGE_DEMOSAIC);
+                Mat demosaiced = DemosaicImage(frame->pImage, bayerCode, backend, context, pConverted);
+                demosaicTimer.Stop();
+                frame = make_shared<SharedFrame>(pConverted, demosaiced, frame->imageCnt, false);
+            }
+            catch (Spinnaker::Exception &e)
+            {
+                lock_guard<mutex> lock(printMutex);
+                cout << "Error: " << e.what() << endl;
+                result = -1;
+            }
+            catch (std::exception &e)
+            {
+                {
+                    lock_guard<mutex> lock(printMutex);
+                    cout << "Error: " << e.what() << endl;
+                }
+                result = -1;
+                demosaicQueue.Close();
+                break;
+            }
+        }
+
+        display.Put(frame);
+        if (!encodeQueue.Push(frame))
+        {
+            demosaicQueue.Close();
+            break;
+        }
+        frame.reset();
+    }
+    frame.reset();
+
+    if (--numActiveWorkers == 0)
+    {
+        display.Close();
+        encodeQueue.Close();
+    }
+}
+
+// Encode stage of the pipeline; saves each grabbed image as a jpeg. An error
+// from imwrite closes the encode queue, which stops the stages before it.
+void EncodeImages(BoundedQueue<SharedFramePtr> & encodeQueue, const gcstring & deviceSerialNumber, FrameStats & stats, atomic<unsigned int> & numEncoded, atomic<int> & result)
+{
+    FrameRecorder & frameRecorder = stats.CreateRecorder();
+    SharedFramePtr frame;
+
+    while (encodeQueue.Pop(frame))
+    {
+        // Create a unique filename
+        ostringstream filename;
+
+        filename << "Acquisition-";
+        if (!deviceSerialNumber.empty())
+        {
+            filename << deviceSerialNumber.c_str() << "-";
+        }
+        filename << frame->imageCnt << ".jpg";
+
+        // Save the current image using imwrite
+        try
+        {
+            StageTimer saveTimer(frameRecorder, STAGE_SAVE);
+            imwrite(filename.str(), frame->image);
+            saveTimer.Stop();
+        }
+        catch (std::exception &e)
+        {
+            {
+                lock_guard<mutex> lock(printMutex);
+                cout << "Error: " << e.what() << endl;
+            }
+            result = -1;
+            encodeQueue.Close();
+            frame.reset();
+            break;
+        }
+
+        // Done with the buffer; it is released here unless still waiting for display
+        frame.reset();
+        numEncoded++;
+
+        lock_guard<mutex> lock(printMutex);
+        cout << "Image saved at " << filename.str() << endl;
+    }
+}
+
+// This function runs the grab, demosaic and encode stages on their own threads
+// and the display stage on the calling thread, which owns the highgui window.
+int AcquireImagesPipelined(CameraPtr pCam, const gcstring & deviceSerialNumber, unsigned int numImages, demosaicType demosaicBackend, FrameStats & stats)
+{
+    atomic<int> result(0);
+    atomic<unsigned int> numEncoded(0);
+    unsigned int numDisplayed = 0;
+
+    LatestFrame display;
+    BoundedQueue<SharedFramePtr> demosaicQueue(k_demosaicQueueDepth);
+    BoundedQueue<SharedFramePtr> encodeQueue(k_encodeQueueDepth);
+
+    vector<thread> encodeThreads;
+    for (unsigned int i = 0; i < k_numEncodeThreads; i++)
+    {
+        encodeThreads.push_back(thread(EncodeImages, ref(encodeQueue), cref(deviceSerialNumber), ref(stats), ref(numEncoded), ref(result)));
+    }
+
+    atomic<unsigned int> numActiveWorkers(k_numDemosaicThreads);
+    vector<thread> demosaicThreads;
+    for (unsigned int i = 0; i < k_numDemosaicThreads; i++)
+    {
+        demosaicThreads.push_back(thread(DemosaicImages, ref(demosaicQueue), demosaicBackend, ref(display), ref(encodeQueue), ref(numActiveWorkers), ref(stats), ref(result)));
+    }
+
+    thread grabThread(GrabImages, pCam, numImages, ref(demosaicQueue), ref(stats), ref(result));
+
+    FrameRecorder & frameRecorder = stats.CreateRecorder();
+    SharedFramePtr frame;
+    while (display.Take(frame))
+    {
+        try
+        {
+            StageTimer displayTimer(frameRecorder, STAGE_DISPLAY);
+
+            // Resize to a quarter resolution for image display
+            Mat display_frame = cv::Mat();
+            cv::resize(frame->image, display_frame, cv::Size(), 0.5, 0.5);
+
+            // The resized copy is all that is needed from here on
+            frame.reset();
+
+            imshow(WINDOW_NAME, display_frame);
+            waitKey(1);    // otherwise the image will not display...
+            displayTimer.Stop();
+
+            numDisplayed++;
+        }
+        catch (std::exception &e)
+        {
+            {
+                lock_guard<mutex> lock(printMutex);
+                cout << "Error: " << e.what() << endl;
+            }
+            result = -1;
+            frame.reset();
+
+            // Stop grabbing and keep taking frames until the other stages have drained
+            demosaicQueue.Close();
+        }
+    }
+
+    grabThread.join();
+    for (unsigned int i = 0; i < demosaicThreads.size(); i++)
+    {
+        demosaicThreads[i].join();
+    }
+    for (unsigned int i = 0; i < encodeThreads.size(); i++)
+    {
+        encodeThreads[i].join();
+    }
+
+    cout << endl << "Pipeline summary: " << numEncoded << " images saved, " << numDisplayed << " displayed, "
+        << display.GetNumDropped() << " skipped by the display" << endl;
+
+    return result;
+}
+
 // This function acquires and saves 50 images from a device.
 int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice)
 {
@@ -194,6 +813,18 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
         }
         cout << endl;
 
+        // Choose the demosaic backend, optionally comparing all of them first
+        const demosaicType demosaicBackend = ResolveDemosaicBackend(chosenDemosaic);
+        DemosaicContext demosaicContext;
+
+        if (k_compareDemosaic)
+        {
+            result = result | CompareDemosaicBackends(pCam);
+        }
+
+        // Time each stage of the acquisition loop
+        FrameStats stats("AcquisitionOpenCV", k_frameStatsCsv, k_frameStatsInterval);
+
         // Create a highgui window to display incomming images
         namedWindow(WINDOW_NAME);
         moveWindow(WINDOW_NAME, 0, 0);
@@ -201,112 +832,144 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
         // Retrieve, convert, and save images
         const unsigned int k_numImages = 50;
 
-        for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
+        if (chosenPipeline == PIPELINED)
         {
-            try
+            result = result | AcquireImagesPipelined(pCam, deviceSerialNumber, k_numImages, demosaicBackend, stats);
+        }
+        else
+        {
+            FrameRecorder & frameRecorder = stats.CreateRecorder();
+
+            for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
             {
-                //
-                // Retrieve next received image
-                //
-                // *** NOTES ***
-                // Capturing an image houses images on the camera buffer. Trying
-                // to capture an image that does not exist will hang the camera.
-                //
-                // *** LATER ***
-                // Once an image from the buffer is saved and/or no longer
-                // needed, the image must be released in order to keep the
-                // buffer from filling up.
-                //
-                ImagePtr pResultImage = pCam->GetNextImage();
-
-                //
-                // Ensure image completion
-                //
-                // *** NOTES ***
-                // Images can easily be checked for completion. This should be
-                // done whenever a complete image is expected or required.
-                // Further, check image status for a little more insight into
-                // why an image is incomplete.
-                //
-                if (pResultImage->IsIncomplete())
-                {
-                    // Retrieve and print the image status description
-                    cout << "Image incomplete: "
-                        << Image::GetImageStatusDescription(pResultImage->GetImageStatus())
-                        << "..." << endl << endl;
-                }
-                else
+                try
                 {
                     //
-                    // Print image information; height and width recorded in pixels
+                    // Retrieve next received image
                     //
                     // *** NOTES ***
-                    // Images have quite a bit of available metadata including
-                    // things such as CRC, image status, and offset values, to
-                    // name a few.
+                    // Capturing an image houses images on the camera buffer. Trying
+                    // to capture an image that does not exist will hang the camera.
                     //
-                    const size_t width = pResultImage->GetWidth();
-
-                    const size_t height = pResultImage->GetHeight();
-
-                    cout << "Grabbed image " << imageCnt << ", width = " << width << ", height = " << height << endl;
-
-                    // Convert the Image to OpenCV Mat and display the result in a window.
-                    // Note that if the camera is streaming in BayerRG8 format you will need to debayer the image to
-                    // convert it into a 3-channel color image. You can do this before passing the spinnaker image data
-                    // to the Mat object, using pResultImage->Convert(PixelFormat_RGB8, HQ_LINEAR) or you can
-                    // use OpenCV to debayer the image after the BayerRG8 image data is passed to the Mat object.
-                    // To preform the debayering (demosaicing) on the Mat object with OpenCV you can use cvtColor as follow:
-                    // cvtColor(current_frame, demosaiced_frame, COLOR_BayerRG2RGB);
-
-                    unsigned int rows = pResultImage->GetHeight();
-                    unsigned int cols = pResultImage->GetWidth();
-                    unsigned int num_channels = pResultImage->GetNumChannels();
-                    void *image_data = pResultImage->GetData();
-                    unsigned int stride = pResultImage->GetStride();
-                    Mat current_frame = cv::Mat(rows, cols, (num_channels == 3) ? CV_8UC3 : CV_8UC1, image_data, stride);
-
-                    // Resize to a quarter resolution for image display
-                    Mat display_frame = cv::Mat();
-                    cv::resize(current_frame, display_frame, cv::Size(), 0.5, 0.5);
-
-                    imshow(WINDOW_NAME, display_frame);
-                    waitKey(1);    // otherwise the image will not display...
-
-                    // Create a unique filename
-                    ostringstream filename;
+                    // *** LATER ***
+                    // Once an image from the buffer is saved and/or no longer
+                    // needed, the image must be released in order to keep the
+                    // buffer from filling up.
+                    //
+                    StageTimer getTimer(frameRecorder, STAGE_GET_NEXT_IMAGE);
+                    ImagePtr pResultImage = pCam->GetNextImage();
+                    getTimer.Stop();
+                    frameRecorder.RecordFrame(pResultImage);
 
-                    filename << "Acquisition-";
-                    if (!deviceSerialNumber.empty())
+                    //
+                    // Ensure image completion
+                    //
+                    // *** NOTES ***
+                    // Images can easily be checked for completion. This should be
+                    // done whenever a complete image is expected or required.
+                    // Further, check image status for a little more insight into
+                    // why an image is incomplete.
+                    //
+                    if (pResultImage->IsIncomplete())
                     {
-                        filename << deviceSerialNumber.c_str() << "-";
+                        // Retrieve and print the image status description
+                        cout << "Image incomplete: "
+                            << Image::GetImageStatusDescription(pResultImage->GetImageStatus())
+                            << "..." << endl << endl;
+                    }
+                    else
+                    {
+                        //
+                        // Print image information; height and width recorded in pixels
+                        //
+                        // *** NOTES ***
+                        // Images have quite a bit of available metadata including
+                        // things such as CRC, image status, and offset values, to
+                        // name a few.
+                        //
+                        const size_t width = pResultImage->GetWidth();
+
+                        const size_t height = pResultImage->GetHeight();
+
+                        cout << "Grabbed image " << imageCnt << ", width = " << width << ", height = " << height << endl;
+
+                        // Convert the Image to OpenCV Mat and display the result in a window.
+                        // If the camera is streaming in an 8-bit Bayer format the image is demosaiced
+                        // into a 3-channel color image with the backend chosen by chosenDemosaic,
+                        // either Spinnaker's ImageProcessor before the data is passed to the Mat object
+                        // or OpenCV's cvtColor (e.g. COLOR_BayerRG2RGB) on the Mat object.
+                        Mat current_frame = WrapImage(pResultImage);
+
+                        ImagePtr pConverted;
+                        const int bayerCode = GetBayerConversionCode(pResultImage->GetPixelFormat());
+                        if (bayerCode >= 0)
+                        {
+                            StageTimer demosaicTimer(frameRecorder, STAGE_DEMOSAIC);
+                            current_frame = DemosaicImage(pResultImage, bayerCode, demosaicBackend, demosaicContext, pConverted);
+                        }
+
+                        // Resize to a quarter resolution for image display
+                        StageTimer displayTimer(frameRecorder, STAGE_DISPLAY);
+                        Mat display_frame = cv::Mat();
+                        cv::resize(current_frame, display_frame, cv::Size(), 0.5, 0.5);
+
+                        imshow(WINDOW_NAME, display_frame);
+                        waitKey(1);    // otherwise the image will not display...
+                        displayTimer.Stop();
+
+                        // Create a unique filename
+                        ostringstream filename;
+
+                        filename << "Acquisition-";
+                        if (!deviceSerialNumber.empty())
+                        {
+                            filename << deviceSerialNumber.c_str() << "-";
+                        }
+                        filename << imageCnt << ".jpg";
+
+                        // Save the current image using imwrite
+                        StageTimer saveTimer(frameRecorder, STAGE_SAVE);
+                        imwrite(filename.str(), current_frame);
+                        saveTimer.Stop();
+                        cout << "Image saved at " << filename.str() << endl;
                     }
-                    filename << imageCnt << ".jpg";
 
-                    // Save the current image using imwrite
-                    imwrite(filename.str(), current_frame);
-                    cout << "Image saved at " << filename.str() << endl;
-                }
+                    //
+                    // Release image
+                    //
+                    // *** NOTES ***
+                    // Images retrieved directly from the camera (i.e. non-converted
+                    // images) need to be released in order to keep from filling the
+                    // buffer.
+                    //
+                    StageTimer releaseTimer(frameRecorder, STAGE_RELEASE);
+                    pResultImage->Release();
+                    releaseTimer.Stop();
 
-                //
-                // Release image
-                //
-                // *** NOTES ***
-                // Images retrieved directly from the camera (i.e. non-converted
-                // images) need to be released in order to keep from filling the
-                // buffer.
-                //
-                pResultImage->Release();
+                    stats.ReportIfDue();
 
-                cout << endl;
-            }
-            catch (Spinnaker::Exception &e)
-            {
-                cout << "Error: " << e.what() << endl;
-                result = -1;
+                    cout << endl;
+                }
+                catch (Spinnaker::Exception &e)
+                {
+                    cout << "Error: " << e.what() << endl;
+                    result = -1;
+                }
+                catch (std::exception &e)
+                {
+                    // OpenCV errors and failed allocations will not clear up on the
+                    // next image, so acquisition is ended
+                    cout << "Error: " << e.what() << endl;
+                    result = -1;
+                    break;
+                }
             }
         }
 
+        // Print the stage timings and stream statistics
+        stats.RecordStreamStatistics(pCam->GetTLStreamNodeMap());
+        stats.Report();
+
         //
         // End acquisition
         //
@@ -386,9 +1049,19 @@ int RunSingleCamera(CameraPtr pCam)
         // Retrieve GenICam nodemap
         INodeMap & nodeMap = pCam->GetNodeMap();
 
+        // Configure stream buffers
+        StreamSettings streamSettings;
+        if (!ApplyStreamProfile(pCam, chosenStreamProfile, streamSettings))
+        {
+            cout << "Unable to apply every stream buffer setting; continuing with the settings below..." << endl;
+        }
+        PrintStreamSettings(streamSettings);
+
         // Acquire images
         result = result | AcquireImages(pCam, nodeMap, nodeMapTLDevice);
 
+        PrintStreamDrops(pCam, streamSettings);
+
         // Deinitialize camera
         pCam->DeInit();
     }
@@ -45,6 +45,11 @@
 #include <ctime>
 #include <chrono>
 #include <time.h>
+#include "RawRecorder.h"
+#include "FrameStats.h"
+#include "CameraProfile.h"
+#include "CameraClockSync.h"
+#include "StreamProfile.h"
 
 using namespace Spinnaker;
 using namespace Spinnaker::GenApi;
@@ -61,6 +66,25 @@ enum chunkDataType
 
 const chunkDataType chosenChunkData = IMAGE;
 
+// Use the following global constant to select whether each image is saved as
+// a jpeg or recorded into a raw container; see recordingType in RawRecorder.h.
+const recordingType chosenRecording = SAVE_JPEG;
+
+// Per-frame stage timings are printed at the end of acquisition and written
+// to this CSV file every k_frameStatsInterval seconds (empty to disable)
+const char* const k_frameStatsCsv = "CameraTimeToPCTime-stats.csv";
+const double k_frameStatsInterval = 5.0;
+
+// Interval in seconds at which the camera timestamp is latched in the background
+// to keep the camera to host clock model up to date
+const double k_clockSyncInterval = 2.0;
+
+// Use the following global constant to select the stream buffer profile.
+// STREAM_PROFILE_NO_DROP (OldestFirst, buffers sized for consumer stalls)
+// keeps every frame for recording, while STREAM_PROFILE_LOW_LATENCY
+// (NewestOnly, few buffers) always hands over the most recent frame.
+const streamProfileType chosenStreamProfile = STREAM_PROFILE_NO_DROP;
+
 // This function configures the camera to add chunk data to each image. It does
 // this by enabling each type of chunk data before enabling chunk data mode.
 // When chunk data is turned on, the data is made available in both the nodemap
@@ -213,107 +237,6 @@ int PrintDeviceInfo(INodeMap & nodeMap)
     return result;
 }
 
-// Calculate offset for BFS / Oryx and some other cameras
-int64_t calculateOffset(CameraPtr pCam)
-{
-    const std::time_t now = std::time(nullptr);
-    const std::tm calendar_time = *std::localtime(std::addressof(now));
-
-    // Convert current calendar time into seconds
-    int64_t hour_in_seconds = calendar_time.tm_hour * 3600;
-    int64_t minute_in_seconds = calendar_time.tm_min * 60;
-    int64_t current_time_in_seconds = hour_in_seconds + minute_in_seconds + calendar_time.tm_sec;
-    cout << "Current time in seconds: " << current_time_in_seconds << endl;
-
-    // Get current camera time using TimestampLatch
-    CCommandPtr ptrTimestampLatch = pCam->GetNodeMap().GetNode("TimestampLatch");
-    // Execute command
-    ptrTimestampLatch->Execute();
-    CIntegerPtr ptrTimestampLatchValue = pCam->GetNodeMap().GetNode("TimestampLatchValue");
-
-    if (!IsAvailable(ptrTimestampLatchValue) || !IsReadable(ptrTimestampLatchValue)) {
-        cout << " Unable to read Time Stamp Latch Value (node retrieval). Aborting.." << endl; return -1;
-    }
-
-    // Print out timestamp value
-    int64_t timestampLatchValue = ptrTimestampLatchValue->GetValue();
-    cout << "Timestamp Latch Value in ns: " << timestampLatchValue << endl;
-
-    // Calculate offset = PC_TIME (s) - CAMERA_TIME(s)
-    int64_t offset = current_time_in_seconds - (timestampLatchValue / 1000000000);
-    cout << "Offset (current PC time(s) - camera timestamp(s)): " << offset << endl;
-
-    return offset;
-}
-
-// Calculate offset for BFLY-U3, FL3-U3 and GS3-U3 cameras
-int64_t calculateOffset_gen2USB(CameraPtr pCam)
-{
-    const std::time_t now = std::time(nullptr);
-    const std::tm calendar_time = *std::localtime(std::addressof(now));
-
-    int64_t hour_in_seconds = calendar_time.tm_hour * 3600;
-    int64_t minute_in_seconds = calendar_time.tm_min * 60;
-    int64_t current_time_in_seconds = hour_in_seconds + minute_in_seconds + calendar_time.tm_sec;
-
-    // Convert current calendar time into seconds
-    cout << "Current time in seconds: " << current_time_in_seconds << endl;
-
-    // Get current camera time using TimestampLatch
-    CCommandPtr ptrTimestampLatch = pCam->GetNodeMap().GetNode("TimestampLatch");
-    // Execute command
-    ptrTimestampLatch->Execute();
-    CIntegerPtr ptrTimestampLatchValue = pCam->GetNodeMap().GetNode("Timestamp");
-
-    if (!IsAvailable(ptrTimestampLatchValue) || !IsReadable(ptrTimestampLatchValue)) {
-        cout << " Unable to read Time Stamp Latch Value (node retrieval). Aborting.." << endl; return -1;
-    }
-
-    // Print out timestamp value
-    int64_t timestampLatchValue = ptrTimestampLatchValue->GetValue();
-    cout << "Timestamp Latch Value in ns: " << timestampLatchValue << endl;
-
-    // Calculate offset = PC_TIME (s) - CAMERA_TIME(s)
-    int64_t offset = current_time_in_seconds - (timestampLatchValue / 1000000000);
-    cout << "Offset (current PC time(s) - camera timestamp(s)): " << offset << endl;
-
-    return offset;
-}
-
-// Calculate offset for BFLY-PGE and FL3-GE cameras
-int64_t calculateOffset_GEV(CameraPtr pCam)
-{
-    const std::time_t now = std::time(nullptr);
-    const std::tm calendar_time = *std::localtime(std::addressof(now));
-
-    int64_t hour_in_seconds = calendar_time.tm_hour * 3600;
-    int64_t minute_in_seconds = calendar_time.tm_min * 60;
-    int64_t current_time_in_seconds = hour_in_seconds + minute_in_seconds + calendar_time.tm_sec;
-
-    // Convert current calendar time into seconds
-    cout << "Current time in seconds: " << current_time_in_seconds << endl;
-
-    // Get current camera time using TimestampControlLatch
-    CCommandPtr ptrTimestampLatch = pCam->GetNodeMap().GetNode("GevTimestampControlLatch");
-    // Execute command
-    ptrTimestampLatch->Execute();
-    CIntegerPtr ptrTimestampLatchValue = pCam->GetNodeMap().GetNode("GevTimestampValue");
-
-    if (!IsAvailable(ptrTimestampLatchValue) || !IsReadable(ptrTimestampLatchValue)) {
-        cout << " Unable to read Time Stamp Latch Value (node retrieval). Aborting.." << endl; return -1;
-    }
-
-    // Print out timestamp value
-    int64_t timestampLatchValue = ptrTimestampLatchValue->GetValue();
-    cout << "Timestamp Latch Value in ns: " << timestampLatchValue << endl;
-
-    // Calculate offset = PC_TIME (s) - CAMERA_TIME(s)
-    int64_t offset = current_time_in_seconds - (timestampLatchValue / 1000000000);
-    cout << "Offset (current PC time(s) - camera timestamp(s)): " << offset << endl;
-
-    return offset;
-}
-
 // This function acquires and saves 10 images from a device; please see
 // Acquisition example for more in-depth comments on acquiring images.
 int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice)
@@ -350,49 +273,73 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
 
         cout << "Acquiring images..." << endl;
 
-        // Retrieve device serial number for filename
-        gcstring deviceSerialNumber("");
-
-        CStringPtr ptrStringSerial = nodeMapTLDevice.GetNode("DeviceSerialNumber");
-        if (IsAvailable(ptrStringSerial) && IsReadable(ptrStringSerial))
-        {
-            deviceSerialNumber = ptrStringSerial->GetValue();
-
-            cout << "Device serial number retrieved as " << deviceSerialNumber << "..." << endl;
-        }
-        cout << endl;
-
-        CEnumerationPtr ptrDeviceType = nodeMapTLDevice.GetNode("DeviceType");
-        if (!IsAvailable(ptrDeviceType) || !IsReadable(ptrDeviceType))
+        //
+        // Resolve the camera profile
+        //
+        // *** NOTES ***
+        // The serial number, device type, camera family and the timestamp
+        // latch nodes are resolved once here, so that neither the clock model
+        // nor the acquisition loop looks up a node by name.
+        //
+        CameraProfile profile;
+        if (!profile.Resolve(pCam))
         {
-            cout << "Error with reading the device's type. Aborting..." << endl << endl;
+            cout << "Unable to determine camera family. Aborting..." << endl << endl;
+            pCam->EndAcquisition();
             return -1;
         }
 
-        CStringPtr ptrDeviceModelName = nodeMap.GetNode("DeviceModelName");
-        gcstring cameraModel = ptrDeviceModelName->ToString();
-        cout << "Camera model is: " << cameraModel << endl;
+        const gcstring deviceSerialNumber = profile.serialNumber;
+        cout << "Device serial number retrieved as " << deviceSerialNumber << "..." << endl;
+        cout << "Camera model is: " << profile.modelName << endl << endl;
 
-        if (!IsAvailable(ptrDeviceModelName) || !IsReadable(ptrDeviceModelName))
+        //
+        // Start the camera to host clock model
+        //
+        // *** NOTES ***
+        // The camera timestamp is latched a few times now and then every
+        // k_clockSyncInterval seconds on a background thread, and the offset
+        // and drift between the camera and PC clocks are fitted over those
+        // latches. Chunk timestamps are then converted to PC time without
+        // accessing the camera from the acquisition loop.
+        //
+        CameraClockSync clockSync(profile, k_clockSyncInterval);
+        if (!clockSync.Start())
         {
-            cout << "Unable to determine camera family. Aborting..." << endl << endl;
+            cout << "Unable to latch the camera timestamp. Aborting..." << endl << endl;
+            pCam->EndAcquisition();
             return -1;
         }
 
-        int64_t hours, minutes;
-        int64_t imageTimestamp;
-        int64_t imageTimestamp_converted;
+        ClockModel clockModel = clockSync.GetModel();
+        cout << "Clock model fitted over " << clockModel.numSamples << " latches, residual " << clockModel.residualNs / 1000.0
+            << " microseconds" << endl;
 
         // Retrieve, convert, and save images
         const unsigned int k_numImages = 10;
 
+        // Create the container that raw images are recorded into
+        RawRecording recording(chosenRecording);
+        if (!recording.Open("ChunkData", deviceSerialNumber.c_str(), k_numImages, pCam->PayloadSize.GetValue()))
+        {
+            pCam->EndAcquisition();
+            return -1;
+        }
+
+        // Time each stage of the acquisition loop
+        FrameStats stats("CameraTimeToPCTime", k_frameStatsCsv, k_frameStatsInterval);
+        FrameRecorder & frameRecorder = stats.CreateRecorder();
+
         for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
         {
             try
             {
                 // Retrieve next received image and ensure image completion
 
+                StageTimer getTimer(frameRecorder, STAGE_GET_NEXT_IMAGE);
                 ImagePtr pResultImage = pCam->GetNextImage();
+                getTimer.Stop();
+                frameRecorder.RecordFrame(pResultImage);
 
                 ChunkData chunkData = pResultImage->GetChunkData();
 
@@ -410,74 +357,64 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
                     uint64_t timestamp = chunkData.GetTimestamp();
                     cout << "Chunk Timestamp in ns: " << timestamp << endl;
 
-                    // Get DeviceType
-                    CEnumerationPtr ptrDeviceType = nodeMapTLDevice.GetNode("DeviceType");
-                    if (!IsAvailable(ptrDeviceType) || !IsReadable(ptrDeviceType))
-                    {
-                        cout << "Error with reading the device's type. Aborting..." << endl << endl;
-                        return -1;
-                    }
+                    // Convert the chunk timestamp to PC time using the clock model
+                    const int64_t imageTimestamp_converted = clockSync.ToHostTime(static_cast<int64_t>(timestamp));
+                    cout << "PC timestamp in ns (chunk timestamp mapped through the clock model): " << imageTimestamp_converted << endl;
+
+                    // Convert imageTimestamp to local clock time
+                    const std::time_t imageTime = static_cast<std::time_t>(imageTimestamp_converted / 1000000000);
+                    const std::tm calendar_time = *std::localtime(&imageTime);
+
+                    const int64_t hours = calendar_time.tm_hour;
+                    const uint16_t minutes_converted = static_cast<uint16_t>(calendar_time.tm_min);
+                    const uint16_t seconds_converted = static_cast<uint16_t>(calendar_time.tm_sec);
+                    const uint16_t milliseconds_converted = static_cast<uint16_t>((imageTimestamp_converted / 1000000) % 1000);
 
-                    // How to calcualte offset for GigE vision cameras
-                    if (ptrDeviceType->GetIntValue() == DeviceType_GEV)
+                    cout << "ImageTimestamp " << imageTimestamp_converted << " (ns) is equivalent to " << endl
+                        << hours << " hours " << minutes_converted << " minutes " << seconds_converted << " seconds "
+                        << milliseconds_converted << " milliseconds." << endl;
+
+                    if (recording.IsRaw())
                     {
-                        if (cameraModel.find("Blackfly S") == 0 || cameraModel.find("Oryx") == 0)
-                        {
-                            imageTimestamp_converted = (timestamp / 1000000000) + calculateOffset(pCam);
-                        }
-                        else
+                        StageTimer saveTimer(frameRecorder, STAGE_SAVE);
+                        if (!recording.Record(pResultImage, chunkData.GetFrameID(), timestamp))
                         {
-                            imageTimestamp_converted = (timestamp / 1000000000) + calculateOffset_GEV(pCam);
+                            result = -1;
                         }
                     }
-
-                    // How to calcualte offset for BFLY-U3, GS3-U3, FL3-U3 or CM3-U3
-                    else if (cameraModel.find("Blackfly BFLY-U3") == 0 || cameraModel.find("Grasshopper3 GS3-U3") == 0
-                        || cameraModel.find("Flea3 FL3-U3") == 0 || cameraModel.find("Chameleon3 CM3-U3") == 0)
-                    {
-                        imageTimestamp_converted = (timestamp / 1000000000) + calculateOffset_gen2USB(pCam);
-                    }
-
-                    // How to calculate offset for the rest of the cameras
                     else
                     {
-                        imageTimestamp_converted = (timestamp / 1000000000) + calculateOffset(pCam);
-                    }
-                    cout << "PC timestamp in seconds (chunk timestamp + offset): " << imageTimestamp_converted << endl;
-
-                    // Convert imageTimestamp to clock time
-                    minutes = imageTimestamp_converted / 60;
-                    hours = minutes / 60;
-
-                    uint16_t minutes_converted = minutes % 60;
-                    uint16_t seconds_converted = imageTimestamp_converted % 60;
+                        // Convert image to mono 8
+                        StageTimer convertTimer(frameRecorder, STAGE_CONVERT);
+                        ImagePtr convertedImage = pResultImage->Convert(PixelFormat_Mono8, HQ_LINEAR);
+                        convertTimer.Stop();
 
-                    cout << "ImageTimestamp " << imageTimestamp_converted << " (seconds) is equivalent to " << endl
-                        << hours << " hours " << minutes_converted << " minutes " << seconds_converted << " seconds."
-                        << endl;
+                        // Create a unique filename
+                        ostringstream filename;
 
-                    // Convert image to mono 8
-                    ImagePtr convertedImage = pResultImage->Convert(PixelFormat_Mono8, HQ_LINEAR);
+                        filename << "ChunkData-";
+                        if (deviceSerialNumber != "")
+                        {
+                            filename << deviceSerialNumber.c_str() << "-";
+                            filename << hours << "-" << minutes_converted << "-" << seconds_converted << "-" << milliseconds_converted << "-";
+                        }
+                        filename << imageCnt << ".jpg";
 
-                    // Create a unique filename
-                    ostringstream filename;
+                        // Save image
+                        StageTimer saveTimer(frameRecorder, STAGE_SAVE);
+                        convertedImage->Save(filename.str().c_str());
+                        saveTimer.Stop();
 
-                    filename << "ChunkData-";
-                    if (deviceSerialNumber != "")
-                    {
-                        filename << deviceSerialNumber.c_str() << "-";
-                        filename << hours << "-" << minutes_converted << "-" << seconds_converted << "-";
+                        cout << "Image saved at " << filename.str() << endl;
                     }
-                    filename << imageCnt << ".jpg";
-
-                    // Save image
-                    convertedImage->Save(filename.str().c_str());
-
-                    cout << "Image saved at " << filename.str() << endl;
                 }
 
                 // Release image
+                StageTimer releaseTimer(frameRecorder, STAGE_RELEASE);
                 pResultImage->Release();
+                releaseTimer.Stop();
+
+                stats.ReportIfDue();
 
                 cout << endl;
             }
@@ -488,6 +425,23 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
             }
         }
 
+        // Write the container index
+        if (!recording.Close())
+        {
+            result = -1;
+        }
+
+        // Print the final clock model
+        clockSync.Stop();
+        clockModel = clockSync.GetModel();
+        cout << "Clock model fitted over " << clockModel.numSamples << " latches: drift " << clockSync.GetDriftPpm()
+            << " ppm, residual " << clockModel.residualNs / 1000.0 << " microseconds, "
+            << clockSync.GetNumFailedLatches() << " failed latches" << endl << endl;
+
+        // Print the stage timings and stream statistics
+        stats.RecordStreamStatistics(pCam->GetTLStreamNodeMap());
+        stats.Report();
+
         // End acquisition
         pCam->EndAcquisition();
     }
@@ -612,9 +566,19 @@ int RunSingleCamera(CameraPtr pCam)
             return err;
         }
 
+        // Configure stream buffers; chunk data is already enabled so the payload size includes it
+        StreamSettings streamSettings;
+        if (!ApplyStreamProfile(pCam, chosenStreamProfile, streamSettings))
+        {
+            cout << "Unable to apply every stream buffer setting; continuing with the settings below..." << endl;
+        }
+        PrintStreamSettings(streamSettings);
+
         // Acquire images and display chunk data
         result = result | AcquireImages(pCam, nodeMap, nodeMapTLDevice);
 
+        PrintStreamDrops(pCam, streamSettings);
+
         // Disable chunk data
         err = DisableChunkData(nodeMap);
         if (err < 0)
@@ -0,0 +1,493 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief BandwidthPlanner.h shares the link of a network interface between
+*  the GigE Vision cameras streaming through it.
+*
+*  PlanInterface() reads the payload size and frame rate of every camera on
+*  an interface and works out the bandwidth each one needs on the wire,
+*  including the Ethernet, IP, UDP and GVSP overhead of every packet. The
+*  usable part of the link is split between the cameras in proportion to
+*  what they need, so every camera gets its frame rate whenever the link can
+*  carry all of them, and the spare time goes into the gaps between packets
+*  rather than into bursts the NIC has to buffer. ApplyPlan() writes the
+*  result as DeviceLinkThroughputLimit where the camera has it, and as a
+*  packet delay (GevSCPD) otherwise. A camera whose frame rate cannot be
+*  read, for example because it is triggered, has no known demand; it is
+*  left out of the split, keeps its current limit and is listed as not
+*  planned by PrintPlan().
+*
+*  ProbeBandwidthPlan() streams all planned cameras at once for a few seconds
+*  and reports the incomplete images, lost frames and packet resend requests
+*  of each, to confirm that the plan holds on the real network.
+*
+*  The cameras must be initialized, and frame rate, image size, pixel format
+*  and chunk data configured, before planning.
+*/
+
+#ifndef BANDWIDTH_PLANNER_H
+#define BANDWIDTH_PLANNER_H
+
+#include "Spinnaker.h"
+#include "SpinGenApi/SpinnakerGenApi.h"
+#include "CameraProfile.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+// IP, UDP and GVSP headers; included in GevSCPSPacketSize
+const int64_t k_gvspPacketHeaderSize = 36;
+
+// Ethernet header, frame check sequence, preamble and inter-frame gap; not included in GevSCPSPacketSize
+const int64_t k_ethernetFrameOverhead = 38;
+
+// Link speed assumed when no camera on the interface reports GevLinkSpeed, in Mbps
+const int64_t k_defaultLinkSpeed = 1000;
+
+// Camera on an interface and what the planner assigned to it; rates are in bytes per second on the wire
+struct BandwidthPlanEntry
+{
+    Spinnaker::CameraPtr pCam;
+    CameraProfile profile;
+    int64_t payloadSize;
+    double frameRate;         // 0 when the camera reports none, e.g. while it is triggered
+    int64_t packetSize;
+    double demand;
+    double allocation;
+    double plannedFrameRate;
+    int64_t packetDelay;
+    bool useThroughputLimit;
+};
+
+struct BandwidthPlan
+{
+    Spinnaker::GenICam::gcstring interfaceName;
+    double linkCapacity;
+    double budget;
+    double demand;
+    bool oversubscribed;
+    std::vector<BandwidthPlanEntry> cameras;
+};
+
+// Stream counters of one camera over a probe
+struct BandwidthProbeResult
+{
+    Spinnaker::GenICam::gcstring serialNumber;
+    unsigned int numImages;
+    unsigned int numIncomplete;
+    int64_t lostFrames;
+    int64_t resendRequests;
+};
+
+class BandwidthPlanner
+{
+public:
+    // maxPacketSize is the largest packet the NIC accepts (its MTU); headroom is the fraction of the link that is planned
+    BandwidthPlanner(int64_t maxPacketSize = 9000, double headroom = 0.9)
+        : m_maxPacketSize(maxPacketSize), m_headroom(headroom)
+    {
+    }
+
+    // Plans the GigE Vision cameras on an interface; returns false if there are none
+    bool PlanInterface(Spinnaker::InterfacePtr pInterface, BandwidthPlan& plan) const
+    {
+        using namespace Spinnaker::GenApi;
+
+        plan = BandwidthPlan();
+        plan.linkCapacity = 0.0;
+        plan.demand = 0.0;
+
+        CStringPtr ptrInterfaceName = pInterface->GetTLNodeMap().GetNode("InterfaceDisplayName");
+        if (IsAvailable(ptrInterfaceName) && IsReadable(ptrInterfaceName))
+        {
+            plan.interfaceName = ptrInterfaceName->GetValue();
+        }
+
+        pInterface->UpdateCameras();
+        Spinnaker::CameraList camList = pInterface->GetCameras();
+
+        int64_t linkSpeed = 0;
+        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        {
+            BandwidthPlanEntry entry;
+            entry.pCam = camList.GetByIndex(i);
+            if (!entry.pCam->IsInitialized() || !entry.profile.Resolve(entry.pCam) || !entry.profile.IsGEV())
+            {
+                continue;
+            }
+
+            INodeMap& nodeMap = entry.pCam->GetNodeMap();
+
+            CIntegerPtr ptrPayloadSize = nodeMap.GetNode("PayloadSize");
+            if (!IsAvailable(ptrPayloadSize) || !IsReadable(ptrPayloadSize))
+            {
+                continue;
+            }
+            entry.payloadSize = ptrPayloadSize->GetValue();
+            entry.frameRate = ReadFrameRate(nodeMap);
+
+            // Largest packet both the camera and the NIC take
+            CIntegerPtr ptrPacketSize = nodeMap.GetNode("GevSCPSPacketSize");
+            entry.packetSize = (IsAvailable(ptrPacketSize) && IsReadable(ptrPacketSize))
+                                   ? ClampToNode(ptrPacketSize, m_maxPacketSize)
+                                   : m_maxPacketSize;
+
+            // Every packet carries packetSize - header bytes of image data and takes packetSize + framing on the wire;
+            // without a frame rate the demand is unknown and the camera keeps its current limit
+            const double packetsPerFrame =
+                std::ceil(static_cast<double>(entry.payloadSize) / (entry.packetSize - k_gvspPacketHeaderSize));
+            entry.demand = packetsPerFrame * (entry.packetSize + k_ethernetFrameOverhead) * entry.frameRate;
+
+            CIntegerPtr ptrThroughputLimit = nodeMap.GetNode("DeviceLinkThroughputLimit");
+            entry.useThroughputLimit = IsAvailable(ptrThroughputLimit) && IsWritable(ptrThroughputLimit);
+
+            CIntegerPtr ptrLinkSpeed = nodeMap.GetNode("GevLinkSpeed");
+            if (IsAvailable(ptrLinkSpeed) && IsReadable(ptrLinkSpeed) && ptrLinkSpeed->GetValue() > 0)
+            {
+                linkSpeed = (linkSpeed == 0) ? ptrLinkSpeed->GetValue() : std::min<int64_t>(linkSpeed, ptrLinkSpeed->GetValue());
+            }
+
+            plan.demand += entry.demand;
+            plan.cameras.push_back(entry);
+        }
+
+        if (plan.cameras.empty())
+        {
+            return false;
+        }
+
+        // GevLinkSpeed is in Mbps
+        plan.linkCapacity = (linkSpeed > 0 ? linkSpeed : k_defaultLinkSpeed) * 1e6 / 8.0;
+        plan.budget = plan.linkCapacity * m_headroom;
+        plan.oversubscribed = plan.demand > plan.budget;
+
+        // Share the budget in proportion to demand; an oversubscribed link lowers every camera's frame rate alike
+        const double share = plan.demand > 0.0 ? plan.budget / plan.demand : 1.0;
+        for (size_t i = 0; i < plan.cameras.size(); i++)
+        {
+            BandwidthPlanEntry& entry = plan.cameras[i];
+            if (!IsPlanned(entry))
+            {
+                entry.allocation = 0.0;
+                entry.plannedFrameRate = 0.0;
+                entry.packetDelay = 0;
+                continue;
+            }
+            entry.allocation = entry.demand * share;
+            entry.plannedFrameRate = plan.oversubscribed ? entry.frameRate * share : entry.frameRate;
+            entry.packetDelay = GetPacketDelay(entry, plan.linkCapacity);
+        }
+
+        return true;
+    }
+
+    // Writes the packet size and the throughput limit or packet delay of every camera in the plan;
+    // cameras without a frame rate are left as they are
+    static bool ApplyPlan(const BandwidthPlan& plan)
+    {
+        using namespace Spinnaker::GenApi;
+
+        bool applied = true;
+
+        for (size_t i = 0; i < plan.cameras.size(); i++)
+        {
+            const BandwidthPlanEntry& entry = plan.cameras[i];
+            if (!IsPlanned(entry))
+            {
+                continue;
+            }
+            INodeMap& nodeMap = entry.pCam->GetNodeMap();
+
+            try
+            {
+                CIntegerPtr ptrPacketSize = nodeMap.GetNode("GevSCPSPacketSize");
+                if (IsAvailable(ptrPacketSize) && IsWritable(ptrPacketSize))
+                {
+                    ptrPacketSize->SetValue(ClampToNode(ptrPacketSize, entry.packetSize));
+                }
+
+                // The throughput limit makes the camera space its own packets
+                if (entry.useThroughputLimit)
+                {
+                    CIntegerPtr ptrThroughputLimit = nodeMap.GetNode("DeviceLinkThroughputLimit");
+                    ptrThroughputLimit->SetValue(ClampToNode(ptrThroughputLimit, static_cast<int64_t>(entry.allocation)));
+                }
+                else
+                {
+                    CIntegerPtr ptrPacketDelay = nodeMap.GetNode("GevSCPD");
+                    if (!IsAvailable(ptrPacketDelay) || !IsWritable(ptrPacketDelay))
+                    {
+                        applied = false;
+                        continue;
+                    }
+                    ptrPacketDelay->SetValue(ClampToNode(ptrPacketDelay, entry.packetDelay));
+                }
+            }
+            catch (Spinnaker::Exception&)
+            {
+                applied = false;
+            }
+        }
+
+        return applied;
+    }
+
+    static void PrintPlan(const BandwidthPlan& plan)
+    {
+        std::cout << "Interface " << plan.interfaceName << ": link " << plan.linkCapacity / 1e6 << " MB/s, planned "
+                  << plan.budget / 1e6 << " MB/s, requested " << plan.demand / 1e6 << " MB/s"
+                  << (plan.oversubscribed ? " (oversubscribed)" : "") << std::endl;
+
+        for (size_t i = 0; i < plan.cameras.size(); i++)
+        {
+            const BandwidthPlanEntry& entry = plan.cameras[i];
+            if (!IsPlanned(entry))
+            {
+                std::cout << "\tCamera " << entry.profile.serialNumber << ": " << entry.payloadSize
+                          << " bytes, frame rate not readable; not planned, its current limit is kept" << std::endl;
+                continue;
+            }
+            std::cout << "\tCamera " << entry.profile.serialNumber << ": " << entry.payloadSize << " bytes at "
+                      << entry.frameRate << " fps needs " << entry.demand / 1e6 << " MB/s, allocated "
+                      << entry.allocation / 1e6 << " MB/s";
+            if (entry.useThroughputLimit)
+            {
+                std::cout << " as DeviceLinkThroughputLimit";
+            }
+            else
+            {
+                std::cout << " as GevSCPD " << entry.packetDelay;
+            }
+            std::cout << ", packet size " << entry.packetSize;
+            if (plan.oversubscribed)
+            {
+                std::cout << ", expect " << entry.plannedFrameRate << " fps";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    // Cameras whose frame rate could not be read have no demand to plan for
+    static bool IsPlanned(const BandwidthPlanEntry& entry)
+    {
+        return entry.frameRate > 0.0;
+    }
+
+private:
+    // Frame rate the camera is set to, or the rate it will actually reach when that is not available
+    static double ReadFrameRate(Spinnaker::GenApi::INodeMap& nodeMap)
+    {
+        using namespace Spinnaker::GenApi;
+
+        const char* const names[] = {"AcquisitionFrameRate", "AcquisitionResultingFrameRate"};
+        for (unsigned int i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+        {
+            CFloatPtr ptrFrameRate = nodeMap.GetNode(names[i]);
+            if (IsAvailable(ptrFrameRate) && IsReadable(ptrFrameRate) && ptrFrameRate->GetValue() > 0.0)
+            {
+                return ptrFrameRate->GetValue();
+            }
+        }
+        return 0.0;
+    }
+
+    static int64_t ClampToNode(const Spinnaker::GenApi::CIntegerPtr& ptrInteger, int64_t value)
+    {
+        const int64_t minimum = ptrInteger->GetMin();
+        const int64_t maximum = ptrInteger->GetMax();
+        const int64_t increment = std::max<int64_t>(ptrInteger->GetInc(), 1);
+
+        value = std::min<int64_t>(std::max<int64_t>(value, minimum), maximum);
+        return minimum + (value - minimum) / increment * increment;
+    }
+
+    // Gap to leave after every packet, in ticks, so that a camera sends at its allocation
+    static int64_t GetPacketDelay(const BandwidthPlanEntry& entry, double linkCapacity)
+    {
+        using namespace Spinnaker::GenApi;
+
+        if (entry.allocation <= 0.0)
+        {
+            return 0;
+        }
+
+        const double wireBytes = static_cast<double>(entry.packetSize + k_ethernetFrameOverhead);
+        const double gapSeconds = std::max<double>(0.0, wireBytes / entry.allocation - wireBytes / linkCapacity);
+
+        // GevSCPD counts ticks of the camera timestamp clock
+        const CIntegerPtr& ptrTickFrequency = entry.profile.ptrTimestampTickFrequency;
+        const double tickFrequency = (IsAvailable(ptrTickFrequency) && IsReadable(ptrTickFrequency) &&
+                                      ptrTickFrequency->GetValue() > 0)
+                                         ? static_cast<double>(ptrTickFrequency->GetValue())
+                                         : 1e9;
+
+        return static_cast<int64_t>(gapSeconds * tickFrequency);
+    }
+
+    int64_t m_maxPacketSize;
+    double m_headroom;
+};
+
+// Reads a stream counter, trying each of its names in turn; returns -1 if none is available
+inline int64_t ReadStreamCounter(Spinnaker::GenApi::INodeMap& nodeMapStream, const char* const* names, unsigned int numNames)
+{
+    using namespace Spinnaker::GenApi;
+
+    for (unsigned int i = 0; i < numNames; i++)
+    {
+        CIntegerPtr ptrCounter = nodeMapStream.GetNode(names[i]);
+        if (IsAvailable(ptrCounter) && IsReadable(ptrCounter))
+        {
+            return ptrCounter->GetValue();
+        }
+    }
+    return -1;
+}
+
+// Streams every planned camera at once for the given time and records its stream counters.
+// Acquisition must not be running; it is started and ended here.
+inline bool ProbeBandwidthPlan(
+    const std::vector<BandwidthPlan>& plans,
+    double seconds,
+    std::vector<BandwidthProbeResult>& results)
+{
+    const char* const lostFrameNames[] = {"StreamLostFrameCount"};
+    const char* const resendNames[] = {"StreamPacketResendRequestCount", "GevResendRequestCount"};
+
+    std::vector<Spinnaker::CameraPtr> cameras;
+    results.clear();
+    for (size_t i = 0; i < plans.size(); i++)
+    {
+        for (size_t j = 0; j < plans[i].cameras.size(); j++)
+        {
+            BandwidthProbeResult result;
+            result.serialNumber = plans[i].cameras[j].profile.serialNumber;
+            result.numImages = 0;
+            result.numIncomplete = 0;
+
+            Spinnaker::GenApi::INodeMap& nodeMapStream = plans[i].cameras[j].pCam->GetTLStreamNodeMap();
+            result.lostFrames = ReadStreamCounter(nodeMapStream, lostFrameNames, 1);
+            result.resendRequests = ReadStreamCounter(nodeMapStream, resendNames, 2);
+
+            cameras.push_back(plans[i].cameras[j].pCam);
+            results.push_back(result);
+        }
+    }
+
+    try
+    {
+        for (size_t i = 0; i < cameras.size(); i++)
+        {
+            cameras[i]->BeginAcquisition();
+        }
+    }
+    catch (Spinnaker::Exception& e)
+    {
+        std::cout << "Error: " << e.what() << std::endl;
+        for (size_t i = 0; i < cameras.size(); i++)
+        {
+            if (cameras[i]->IsStreaming())
+            {
+                cameras[i]->EndAcquisition();
+            }
+        }
+        return false;
+    }
+
+    // One grab thread per camera so that they all stream at once, as they will in the application
+    const std::chrono::steady_clock::time_point end =
+        std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<int64_t>(seconds * 1e6));
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < cameras.size(); i++)
+    {
+        threads.push_back(std::thread([&cameras, &results, end, i]() {
+            while (std::chrono::steady_clock::now() < end)
+            {
+                try
+                {
+                    Spinnaker::ImagePtr pImage = cameras[i]->GetNextImage(1000);
+                    results[i].numImages++;
+                    if (pImage->IsIncomplete())
+                    {
+                        results[i].numIncomplete++;
+                    }
+                    pImage->Release();
+                }
+                catch (Spinnaker::Exception&)
+                {
+                    // Grab timeout; the lost frame counter accounts for it
+                }
+            }
+        }));
+    }
+
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+
+    bool passed = true;
+    for (size_t i = 0; i < cameras.size(); i++)
+    {
+        cameras[i]->EndAcquisition();
+
+        Spinnaker::GenApi::INodeMap& nodeMapStream = cameras[i]->GetTLStreamNodeMap();
+        const int64_t lostFrames = ReadStreamCounter(nodeMapStream, lostFrameNames, 1);
+        const int64_t resendRequests = ReadStreamCounter(nodeMapStream, resendNames, 2);
+        results[i].lostFrames = (lostFrames >= 0 && results[i].lostFrames >= 0) ? lostFrames - results[i].lostFrames : -1;
+        results[i].resendRequests =
+            (resendRequests >= 0 && results[i].resendRequests >= 0) ? resendRequests - results[i].resendRequests : -1;
+
+        if (results[i].numImages == 0 || results[i].numIncomplete > 0 || results[i].lostFrames > 0)
+        {
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+inline void PrintBandwidthProbe(const std::vector<BandwidthProbeResult>& results, double seconds)
+{
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BandwidthProbeResult& result = results[i];
+        std::cout << "\tCamera " << result.serialNumber << ": " << result.numImages / seconds << " fps, "
+                  << result.numIncomplete << " incomplete, ";
+        if (result.lostFrames >= 0)
+        {
+            std::cout << result.lostFrames << " lost, ";
+        }
+        if (result.resendRequests >= 0)
+        {
+            std::cout << (result.numImages > 0 ? static_cast<double>(result.resendRequests) / result.numImages : 0.0)
+                      << " resend requests per image";
+        }
+        else
+        {
+            std::cout << "resend requests not reported";
+        }
+        std::cout << std::endl;
+    }
+}
+
+#endif // BANDWIDTH_PLANNER_H
@@ -0,0 +1,111 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief BoundedQueue.h hands items between the threads of a pipeline, for
+*  example from a grab thread to its processing or writer threads.
+*
+*  A BoundedQueue holds at most the capacity it is created with. Push() waits
+*  while the queue is full, so a slow consumer holds back its own producers
+*  instead of the queue growing, and Pop() waits while it is empty. The
+*  producer calls Close() once no more items will be pushed; Pop() then
+*  returns the items still queued and false after the last one, and a Push()
+*  that is waiting or comes later returns false. Typical use:
+*
+*      BoundedQueue<ImagePtr> queue(8);
+*
+*      // Producer
+*      queue.Push(pImage);
+*      queue.Close();
+*
+*      // Consumer
+*      ImagePtr pImage;
+*      while (queue.Pop(pImage))
+*      {
+*          ...
+*      }
+*/
+
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stddef.h>
+
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(capacity), m_closed(false)
+    {
+    }
+
+    // Returns false if the queue was closed before the item could be pushed
+    bool Push(const T& item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_queue.size() < m_capacity || m_closed; });
+        if (m_closed)
+        {
+            return false;
+        }
+
+        m_queue.push_back(item);
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    // Returns false once the queue has been closed and fully drained
+    bool Pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return !m_queue.empty() || m_closed; });
+        if (m_queue.empty())
+        {
+            return false;
+        }
+
+        item = m_queue.front();
+        m_queue.pop_front();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    // Wakes every producer and consumer; items already queued can still be popped
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+
+private:
+    BoundedQueue(const BoundedQueue&);
+    BoundedQueue& operator=(const BoundedQueue&);
+
+    const size_t m_capacity;
+    bool m_closed;
+    std::deque<T> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+};
+
+#endif // BOUNDED_QUEUE_H
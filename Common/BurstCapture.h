@@ -0,0 +1,386 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief BurstCapture.h grabs a whole burst of images into preallocated
+*  memory and processes it on a worker thread once the burst is complete.
+*
+*  A BurstArena is one block of memory with room for a burst of frames of
+*  the camera's payload size, allocated once. Capture() takes a free arena,
+*  retrieves the images of one burst with GetNextImage() and copies each of
+*  them into the next slot of the arena before releasing it, so the stream
+*  buffer is back in the pool within a memcpy and nothing is allocated,
+*  converted or encoded while the burst streams in. The full arena is then
+*  handed to the worker thread, which calls the burst handler with it, while
+*  the next burst is captured into the other arena. Capture() only waits if
+*  every arena is still being processed, and reports how long it waited.
+*
+*  Combine it with the burst stream profile of StreamProfile.h, so that the
+*  stream has a buffer for every frame of the burst. Typical use:
+*
+*      BurstCapture capture(burstCount, GetBurstFrameSize(nodeMap), [](const BurstArena& arena) {
+*          for (size_t i = 0; i < arena.GetNumFrames(); i++)
+*          {
+*              ImagePtr pImage = arena.GetImage(i);
+*              ...
+*          }
+*      });
+*      BurstResult result;
+*      capture.Capture(pCam, 1000, result);
+*      ...
+*      capture.Finish();
+*      capture.PrintStatistics();
+*/
+
+#ifndef BURST_CAPTURE_H
+#define BURST_CAPTURE_H
+
+#include "Spinnaker.h"
+#include "SpinGenApi/SpinnakerGenApi.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+// Number of arenas; one is captured into while the other is processed
+const unsigned int k_burstArenaCount = 2;
+
+// One frame of a burst; incomplete frames keep their status but no data
+struct BurstFrame
+{
+    uint64_t frameID;
+    uint64_t timestamp;
+    size_t width;
+    size_t height;
+    Spinnaker::PixelFormatEnums pixelFormat;
+    size_t offset;
+    size_t size;
+    bool incomplete;
+    Spinnaker::ImageStatus imageStatus;
+};
+
+class BurstArena
+{
+public:
+    BurstArena(size_t maxFrames, size_t frameSize)
+        : m_maxFrames(maxFrames), m_frameSize(frameSize), m_data(maxFrames * frameSize), m_burstIndex(0)
+    {
+        m_frames.reserve(maxFrames);
+    }
+
+    void Clear(unsigned int burstIndex)
+    {
+        m_frames.clear();
+        m_burstIndex = burstIndex;
+    }
+
+    // Copies the image into the next slot; returns false if the arena is full or the image is larger than a slot
+    bool Add(const Spinnaker::ImagePtr& image)
+    {
+        if (m_frames.size() >= m_maxFrames)
+        {
+            return false;
+        }
+
+        BurstFrame frame;
+        frame.frameID = image->GetFrameID();
+        frame.timestamp = image->GetTimeStamp();
+        frame.width = image->GetWidth();
+        frame.height = image->GetHeight();
+        frame.pixelFormat = image->GetPixelFormat();
+        frame.offset = m_frames.size() * m_frameSize;
+        frame.size = 0;
+        frame.incomplete = image->IsIncomplete();
+        frame.imageStatus = image->GetImageStatus();
+
+        if (!frame.incomplete)
+        {
+            frame.size = image->GetImageSize();
+            if (frame.size > m_frameSize)
+            {
+                return false;
+            }
+            memcpy(&m_data[frame.offset], image->GetData(), frame.size);
+        }
+
+        m_frames.push_back(frame);
+        return true;
+    }
+
+    unsigned int GetBurstIndex() const
+    {
+        return m_burstIndex;
+    }
+
+    size_t GetNumFrames() const
+    {
+        return m_frames.size();
+    }
+
+    const BurstFrame& GetFrame(size_t i) const
+    {
+        return m_frames[i];
+    }
+
+    // Image over the frame's slot of the arena, valid until the handler returns; null for incomplete frames
+    Spinnaker::ImagePtr GetImage(size_t i) const
+    {
+        const BurstFrame& frame = m_frames[i];
+        if (frame.incomplete)
+        {
+            return Spinnaker::ImagePtr();
+        }
+        return Spinnaker::Image::Create(
+            frame.width, frame.height, 0, 0, frame.pixelFormat, const_cast<unsigned char*>(&m_data[frame.offset]));
+    }
+
+private:
+    BurstArena(const BurstArena&);
+    BurstArena& operator=(const BurstArena&);
+
+    const size_t m_maxFrames;
+    const size_t m_frameSize;
+    std::vector<unsigned char> m_data;
+    std::vector<BurstFrame> m_frames;
+    unsigned int m_burstIndex;
+};
+
+// Outcome of one Capture(); the times are in milliseconds
+struct BurstResult
+{
+    unsigned int burstIndex;
+    unsigned int numFrames;
+    unsigned int numIncomplete;
+    unsigned int numMissing;  // Frames that did not arrive within the timeout
+    unsigned int numRejected; // Frames larger than a slot of the arena
+    double waitMs;            // Time spent waiting for an arena to be processed
+    double captureMs;         // Time from the first to the last frame of the burst
+};
+
+// Size of an arena slot: the current payload size, which covers the image and its chunk data
+inline size_t GetBurstFrameSize(Spinnaker::GenApi::INodeMap& nodeMap)
+{
+    using namespace Spinnaker::GenApi;
+
+    CIntegerPtr ptrPayloadSize = nodeMap.GetNode("PayloadSize");
+    return (IsAvailable(ptrPayloadSize) && IsReadable(ptrPayloadSize)) ? static_cast<size_t>(ptrPayloadSize->GetValue()) : 0;
+}
+
+class BurstCapture
+{
+public:
+    typedef std::function<void(const BurstArena&)> BurstHandler;
+
+    // Allocates every arena up front; the handler runs on the worker thread, one burst at a time
+    BurstCapture(size_t framesPerBurst, size_t frameSize, BurstHandler handler, unsigned int numArenas = k_burstArenaCount)
+        : m_framesPerBurst(framesPerBurst), m_handler(handler), m_numBursts(0), m_numFrames(0), m_numIncomplete(0),
+          m_numMissing(0), m_maxCaptureMs(0.0), m_totalWaitMs(0.0), m_totalProcessMs(0.0), m_numProcessed(0),
+          m_stopping(false)
+    {
+        for (unsigned int i = 0; i < std::max<unsigned int>(numArenas, 1u); i++)
+        {
+            m_arenas.push_back(std::unique_ptr<BurstArena>(new BurstArena(framesPerBurst, frameSize)));
+            m_free.push_back(m_arenas.back().get());
+        }
+        m_worker = std::thread(&BurstCapture::Process, this);
+    }
+
+    ~BurstCapture()
+    {
+        Finish();
+    }
+
+    // Retrieves one burst into a free arena and queues it for processing. timeoutMs applies to each
+    // frame; a frame that does not arrive in time ends the burst and the rest count as missing.
+    bool Capture(Spinnaker::CameraPtr pCam, uint64_t timeoutMs, BurstResult& result)
+    {
+        result = BurstResult();
+
+        const std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+        BurstArena* arena = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_arenaFree.wait(lock, [this] { return !m_free.empty(); });
+            arena = m_free.front();
+            m_free.pop_front();
+            result.burstIndex = m_numBursts++;
+        }
+        result.waitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+        arena->Clear(result.burstIndex);
+
+        std::chrono::steady_clock::time_point firstFrame;
+        std::chrono::steady_clock::time_point lastFrame;
+        bool success = true;
+
+        for (size_t i = 0; i < m_framesPerBurst; i++)
+        {
+            Spinnaker::ImagePtr pImage;
+            try
+            {
+                pImage = pCam->GetNextImage(timeoutMs);
+            }
+            catch (Spinnaker::Exception&)
+            {
+                result.numMissing = static_cast<unsigned int>(m_framesPerBurst - i);
+                success = false;
+                break;
+            }
+
+            lastFrame = std::chrono::steady_clock::now();
+            if (i == 0)
+            {
+                firstFrame = lastFrame;
+            }
+
+            if (!arena->Add(pImage))
+            {
+                result.numRejected++;
+                success = false;
+            }
+            else if (arena->GetFrame(arena->GetNumFrames() - 1).incomplete)
+            {
+                result.numIncomplete++;
+            }
+            pImage->Release();
+        }
+
+        result.numFrames = static_cast<unsigned int>(arena->GetNumFrames());
+        if (result.numFrames > 0)
+        {
+            result.captureMs = std::chrono::duration<double, std::milli>(lastFrame - firstFrame).count();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_numFrames += result.numFrames;
+            m_numIncomplete += result.numIncomplete;
+            m_numMissing += result.numMissing + result.numRejected;
+            m_maxCaptureMs = std::max<double>(m_maxCaptureMs, result.captureMs);
+            m_totalWaitMs += result.waitMs;
+            m_full.push_back(arena);
+        }
+        m_arenaFull.notify_one();
+
+        return success && result.numIncomplete == 0;
+    }
+
+    // Waits until every captured burst is processed and stops the worker
+    void Finish()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_arenaFull.notify_all();
+
+        if (m_worker.joinable())
+        {
+            m_worker.join();
+        }
+    }
+
+    void PrintStatistics()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::cout << "Bursts: " << m_numBursts << " captured, " << m_numFrames << " frames, " << m_numIncomplete
+                  << " incomplete, " << m_numMissing << " missing" << std::endl;
+        if (m_numBursts > 0)
+        {
+            std::cout << "Longest burst " << static_cast<int64_t>(m_maxCaptureMs) << " ms, waited "
+                      << static_cast<int64_t>(m_totalWaitMs) << " ms in total for a free arena";
+            if (m_numProcessed > 0)
+            {
+                std::cout << ", mean processing " << static_cast<int64_t>(m_totalProcessMs / m_numProcessed)
+                          << " ms per burst";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+private:
+    BurstCapture(const BurstCapture&);
+    BurstCapture& operator=(const BurstCapture&);
+
+    // Worker thread; processes the full arenas in the order they were captured
+    void Process()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (true)
+        {
+            m_arenaFull.wait(lock, [this] { return m_stopping || !m_full.empty(); });
+            if (m_full.empty())
+            {
+                return;
+            }
+
+            BurstArena* arena = m_full.front();
+            m_full.pop_front();
+            lock.unlock();
+
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            try
+            {
+                m_handler(*arena);
+            }
+            catch (Spinnaker::Exception& e)
+            {
+                std::cout << "Error processing burst " << arena->GetBurstIndex() << ": " << e.what() << std::endl;
+            }
+            const double processMs =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            lock.lock();
+            m_totalProcessMs += processMs;
+            m_numProcessed++;
+            m_free.push_back(arena);
+            m_arenaFree.notify_one();
+        }
+    }
+
+    const size_t m_framesPerBurst;
+    BurstHandler m_handler;
+    std::vector<std::unique_ptr<BurstArena>> m_arenas;
+
+    std::mutex m_mutex;
+    std::condition_variable m_arenaFree;
+    std::condition_variable m_arenaFull;
+    std::deque<BurstArena*> m_free;
+    std::deque<BurstArena*> m_full;
+
+    unsigned int m_numBursts;
+    unsigned int m_numFrames;
+    unsigned int m_numIncomplete;
+    unsigned int m_numMissing;
+    double m_maxCaptureMs;
+    double m_totalWaitMs;
+    double m_totalProcessMs;
+    unsigned int m_numProcessed;
+    bool m_stopping;
+    std::thread m_worker;
+};
+
+#endif // BURST_CAPTURE_H
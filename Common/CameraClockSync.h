@@ -0,0 +1,357 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief CameraClockSync.h maps camera timestamps (such as the chunk data
+*  timestamp of an image) to host time with nanosecond resolution.
+*
+*  A background thread latches the camera timestamp every few seconds and
+*  records the host time half way through the latch command. The offset and
+*  drift between the two clocks are fitted by linear regression over the
+*  recent latches, keeping only the half with the shortest command round
+*  trips since those bound the latch instant most tightly. Converting a
+*  timestamp only evaluates the fitted line, so no device access happens on
+*  the acquisition thread.
+*
+*  The fit is done against std::chrono::steady_clock so that host clock
+*  adjustments do not disturb it. ToHostTime() adds the current offset of
+*  std::chrono::system_clock to give wall-clock time.
+*/
+
+#ifndef CAMERA_CLOCK_SYNC_H
+#define CAMERA_CLOCK_SYNC_H
+
+#include "Spinnaker.h"
+#include "SpinGenApi/SpinnakerGenApi.h"
+#include "CameraProfile.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+// Number of latches taken back to back by Start() so that conversions are valid immediately
+const unsigned int k_clockSyncInitialLatches = 8;
+
+// Number of most recent latches the clock model is fitted over
+const size_t k_clockSyncHistory = 64;
+
+// Drift is only fitted once the latches span at least this long; before that the nominal tick rate is used
+const double k_clockSyncMinDriftSpanSeconds = 2.0;
+
+// One camera timestamp latch and the host steady_clock time it was taken at
+struct ClockLatchSample
+{
+    int64_t cameraTime;
+    int64_t hostTime;
+    int64_t roundTrip;
+};
+
+// Line mapping camera ticks to host nanoseconds: host = hostReference + slope * (camera - cameraReference)
+struct ClockModel
+{
+    int64_t cameraReference;
+    int64_t hostReference;
+    double slope;
+    int64_t systemOffset;
+    double residualNs;
+    size_t numSamples;
+    bool valid;
+};
+
+class CameraClockSync
+{
+public:
+    // The profile must have been resolved on the initialized camera
+    CameraClockSync(const CameraProfile& profile, double latchIntervalSeconds = 2.0)
+        : m_latchType(profile.latchType), m_latchInterval(latchIntervalSeconds), m_nominalSlope(1.0),
+          m_ptrLatch(profile.ptrTimestampLatch), m_ptrValue(profile.ptrTimestampValue),
+          m_ptrTickFrequency(profile.ptrTimestampTickFrequency), m_numFailedLatches(0), m_stopping(false)
+    {
+        m_model.cameraReference = 0;
+        m_model.hostReference = 0;
+        m_model.slope = 1.0;
+        m_model.systemOffset = 0;
+        m_model.residualNs = 0.0;
+        m_model.numSamples = 0;
+        m_model.valid = false;
+    }
+
+    ~CameraClockSync()
+    {
+        Stop();
+    }
+
+    // Take the initial latches and start latching in the background.
+    // Returns false if the camera timestamp cannot be latched.
+    bool Start()
+    {
+        Stop();
+
+        if (!Spinnaker::GenApi::IsAvailable(m_ptrLatch) || !Spinnaker::GenApi::IsWritable(m_ptrLatch) ||
+            !Spinnaker::GenApi::IsAvailable(m_ptrValue) || !Spinnaker::GenApi::IsReadable(m_ptrValue))
+        {
+            return false;
+        }
+
+        // GEV timestamps count ticks of GevTimestampTickFrequency rather than nanoseconds
+        m_nominalSlope = 1.0;
+        if (m_latchType == LATCH_GEV && Spinnaker::GenApi::IsAvailable(m_ptrTickFrequency) &&
+            Spinnaker::GenApi::IsReadable(m_ptrTickFrequency) && m_ptrTickFrequency->GetValue() > 0)
+        {
+            m_nominalSlope = 1e9 / static_cast<double>(m_ptrTickFrequency->GetValue());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_samples.clear();
+            m_stopping = false;
+        }
+
+        for (unsigned int i = 0; i < k_clockSyncInitialLatches; i++)
+        {
+            AddLatch();
+        }
+
+        if (!IsSynchronized())
+        {
+            return false;
+        }
+
+        m_thread = std::thread(&CameraClockSync::Run, this);
+        return true;
+    }
+
+    // Stop latching; the last fitted model stays usable
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    bool IsSynchronized() const
+    {
+        return GetModel().valid;
+    }
+
+    // Host steady_clock time, in nanoseconds since its epoch, at which the camera read cameraTimestamp
+    int64_t ToSteadyTime(int64_t cameraTimestamp) const
+    {
+        return Evaluate(GetModel(), cameraTimestamp);
+    }
+
+    // Host wall-clock time, in nanoseconds since the system_clock epoch, at which the camera read cameraTimestamp
+    int64_t ToHostTime(int64_t cameraTimestamp) const
+    {
+        const ClockModel model = GetModel();
+        return Evaluate(model, cameraTimestamp) + model.systemOffset;
+    }
+
+    ClockModel GetModel() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_model;
+    }
+
+    // Rate of the camera clock relative to its nominal rate, in parts per million
+    double GetDriftPpm() const
+    {
+        return (GetModel().slope / m_nominalSlope - 1.0) * 1e6;
+    }
+
+    unsigned int GetNumFailedLatches() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_numFailedLatches;
+    }
+
+private:
+    // Non-copyable; the sync owns its latch thread
+    CameraClockSync(const CameraClockSync&);
+    CameraClockSync& operator=(const CameraClockSync&);
+
+    static int64_t SteadyNow()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static int64_t SystemNow()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static int64_t Evaluate(const ClockModel& model, int64_t cameraTimestamp)
+    {
+        return model.hostReference +
+               static_cast<int64_t>(std::floor(model.slope * static_cast<double>(cameraTimestamp - model.cameraReference) + 0.5));
+    }
+
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (!m_wake.wait_for(
+            lock, std::chrono::duration<double>(m_latchInterval), [this] { return m_stopping; }))
+        {
+            lock.unlock();
+            AddLatch();
+            lock.lock();
+        }
+    }
+
+    // Latch the camera timestamp once and refit the model
+    void AddLatch()
+    {
+        ClockLatchSample sample;
+        int64_t systemOffset = 0;
+
+        try
+        {
+            // The camera latches while the command is in flight, so its mid point is the best host estimate
+            const int64_t before = SteadyNow();
+            m_ptrLatch->Execute();
+            const int64_t after = SteadyNow();
+            systemOffset = SystemNow() - SteadyNow();
+
+            sample.cameraTime = m_ptrValue->GetValue();
+            sample.hostTime = before + (after - before) / 2;
+            sample.roundTrip = after - before;
+        }
+        catch (Spinnaker::Exception&)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_numFailedLatches++;
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // A timestamp that went backwards means the camera clock was reset; start over
+        if (!m_samples.empty() && sample.cameraTime < m_samples.back().cameraTime)
+        {
+            m_samples.clear();
+        }
+
+        m_samples.push_back(sample);
+        if (m_samples.size() > k_clockSyncHistory)
+        {
+            m_samples.pop_front();
+        }
+
+        Fit(systemOffset);
+    }
+
+    // Fit the clock model over the latches with the shortest round trips; called with m_mutex held
+    void Fit(int64_t systemOffset)
+    {
+        std::vector<int64_t> roundTrips;
+        for (size_t i = 0; i < m_samples.size(); i++)
+        {
+            roundTrips.push_back(m_samples[i].roundTrip);
+        }
+        std::nth_element(roundTrips.begin(), roundTrips.begin() + roundTrips.size() / 2, roundTrips.end());
+        const int64_t maxRoundTrip = roundTrips[roundTrips.size() / 2];
+
+        std::vector<ClockLatchSample> used;
+        for (size_t i = 0; i < m_samples.size(); i++)
+        {
+            if (m_samples[i].roundTrip <= maxRoundTrip)
+            {
+                used.push_back(m_samples[i]);
+            }
+        }
+
+        // Work relative to the first latch so that the sums keep full precision
+        const int64_t cameraOrigin = used.front().cameraTime;
+        const int64_t hostOrigin = used.front().hostTime;
+
+        double meanX = 0.0;
+        double meanY = 0.0;
+        for (size_t i = 0; i < used.size(); i++)
+        {
+            meanX += static_cast<double>(used[i].cameraTime - cameraOrigin);
+            meanY += static_cast<double>(used[i].hostTime - hostOrigin);
+        }
+        meanX /= used.size();
+        meanY /= used.size();
+
+        double sxx = 0.0;
+        double sxy = 0.0;
+        for (size_t i = 0; i < used.size(); i++)
+        {
+            const double dx = static_cast<double>(used[i].cameraTime - cameraOrigin) - meanX;
+            const double dy = static_cast<double>(used[i].hostTime - hostOrigin) - meanY;
+            sxx += dx * dx;
+            sxy += dx * dy;
+        }
+
+        // Drift cannot be told apart from latch jitter over a short span
+        const double span = static_cast<double>(used.back().cameraTime - cameraOrigin) * m_nominalSlope / 1e9;
+        const double slope = (span >= k_clockSyncMinDriftSpanSeconds && sxx > 0.0) ? sxy / sxx : m_nominalSlope;
+
+        ClockModel model;
+        model.cameraReference = cameraOrigin + static_cast<int64_t>(std::floor(meanX + 0.5));
+        model.hostReference = hostOrigin + static_cast<int64_t>(std::floor(meanY + 0.5));
+        model.slope = slope;
+        model.systemOffset = systemOffset;
+        model.numSamples = used.size();
+        model.valid = true;
+
+        double residual = 0.0;
+        for (size_t i = 0; i < used.size(); i++)
+        {
+            const double error = static_cast<double>(used[i].hostTime - Evaluate(model, used[i].cameraTime));
+            residual += error * error;
+        }
+        model.residualNs = std::sqrt(residual / used.size());
+
+        m_model = model;
+    }
+
+    clockLatchType m_latchType;
+    double m_latchInterval;
+    double m_nominalSlope;
+    Spinnaker::GenApi::CCommandPtr m_ptrLatch;
+    Spinnaker::GenApi::CIntegerPtr m_ptrValue;
+    Spinnaker::GenApi::CIntegerPtr m_ptrTickFrequency;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<ClockLatchSample> m_samples;
+    ClockModel m_model;
+    unsigned int m_numFailedLatches;
+    bool m_stopping;
+    std::thread m_thread;
+};
+
+#endif // CAMERA_CLOCK_SYNC_H
@@ -0,0 +1,164 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief CameraProfile.h resolves what a camera is and which nodes apply to
+*  it once, so that the examples do not repeat device type checks, model name
+*  comparisons and GenICam node lookups while they acquire.
+*
+*  Resolve() reads the serial number, model name and device type from the
+*  transport layer nodemap and works out the camera family from the model
+*  name. When the camera is initialized it also looks up the timestamp latch
+*  nodes that apply to the family and, on GigE Vision cameras, the IEEE 1588
+*  nodes. The cached node pointers stay valid until the camera is
+*  deinitialized; call Resolve() again after the next Init().
+*/
+
+#ifndef CAMERA_PROFILE_H
+#define CAMERA_PROFILE_H
+
+#include "Spinnaker.h"
+#include "SpinGenApi/SpinnakerGenApi.h"
+#include <stdint.h>
+
+// Camera families, identified by the family code in the model name
+enum cameraFamily
+{
+    FAMILY_UNKNOWN,
+    FAMILY_BFS,  // Blackfly S
+    FAMILY_ORX,  // Oryx
+    FAMILY_FFY,  // Firefly
+    FAMILY_BFLY, // Blackfly
+    FAMILY_CM3,  // Chameleon3
+    FAMILY_GS3,  // Grasshopper3
+    FAMILY_FL3   // Flea3
+};
+
+// Nodes used to latch the camera timestamp
+enum clockLatchType
+{
+    LATCH_TIMESTAMP,      // TimestampLatch, read back from TimestampLatchValue (BFS, Oryx and newer)
+    LATCH_TIMESTAMP_USB2, // TimestampLatch, read back from Timestamp (BFLY-U3, FL3-U3, GS3-U3, CM3-U3)
+    LATCH_GEV             // GevTimestampControlLatch, read back from GevTimestampValue (BFLY-PGE, FL3-GE)
+};
+
+class CameraProfile
+{
+public:
+    CameraProfile() : deviceType(-1), family(FAMILY_UNKNOWN), latchType(LATCH_TIMESTAMP), resolvedNodes(false)
+    {
+    }
+
+    // Read the device identity and, if the camera is initialized, cache its nodes.
+    // Returns false if the model name cannot be read.
+    bool Resolve(Spinnaker::CameraPtr pCam)
+    {
+        using namespace Spinnaker::GenApi;
+
+        INodeMap& nodeMapTLDevice = pCam->GetTLDeviceNodeMap();
+
+        CStringPtr ptrSerialNumber = nodeMapTLDevice.GetNode("DeviceSerialNumber");
+        serialNumber = (IsAvailable(ptrSerialNumber) && IsReadable(ptrSerialNumber)) ? ptrSerialNumber->GetValue() : "";
+
+        CEnumerationPtr ptrDeviceType = nodeMapTLDevice.GetNode("DeviceType");
+        deviceType = (IsAvailable(ptrDeviceType) && IsReadable(ptrDeviceType)) ? ptrDeviceType->GetIntValue() : -1;
+
+        CStringPtr ptrModelName = nodeMapTLDevice.GetNode("DeviceModelName");
+        if (!IsAvailable(ptrModelName) || !IsReadable(ptrModelName))
+        {
+            return false;
+        }
+        modelName = ptrModelName->GetValue();
+        family = GetFamily(modelName);
+
+        // GigE vision cameras other than BFS and Oryx use the GEV timestamp latch, and
+        // Gen2 USB3 cameras read the latched value back from Timestamp
+        if (IsGEV())
+        {
+            latchType = (family == FAMILY_BFS || family == FAMILY_ORX) ? LATCH_TIMESTAMP : LATCH_GEV;
+        }
+        else
+        {
+            latchType = IsGen2() ? LATCH_TIMESTAMP_USB2 : LATCH_TIMESTAMP;
+        }
+
+        resolvedNodes = pCam->IsInitialized();
+        if (resolvedNodes)
+        {
+            INodeMap& nodeMap = pCam->GetNodeMap();
+
+            const bool gevLatch = latchType == LATCH_GEV;
+            ptrTimestampLatch = nodeMap.GetNode(gevLatch ? "GevTimestampControlLatch" : "TimestampLatch");
+            ptrTimestampValue = nodeMap.GetNode(
+                gevLatch ? "GevTimestampValue" : (latchType == LATCH_TIMESTAMP_USB2 ? "Timestamp" : "TimestampLatchValue"));
+            ptrTimestampTickFrequency = nodeMap.GetNode("GevTimestampTickFrequency");
+
+            ptrIEEE1588 = nodeMap.GetNode("GevIEEE1588");
+            ptrIEEE1588DataSetLatch = nodeMap.GetNode("GevIEEE1588DataSetLatch");
+            ptrIEEE1588StatusLatched = nodeMap.GetNode("GevIEEE1588StatusLatched");
+            ptrIEEE1588OffsetFromMasterLatched = nodeMap.GetNode("GevIEEE1588OffsetFromMasterLatched");
+        }
+
+        return true;
+    }
+
+    bool IsGEV() const
+    {
+        return deviceType == Spinnaker::DeviceType_GEV;
+    }
+
+    // Blackfly, Chameleon3, Grasshopper3 and Flea3
+    bool IsGen2() const
+    {
+        return family == FAMILY_BFLY || family == FAMILY_CM3 || family == FAMILY_GS3 || family == FAMILY_FL3;
+    }
+
+    // Family whose code appears in the model name, e.g. "BFS" in "Blackfly S BFS-U3-16S2M"
+    static cameraFamily GetFamily(const Spinnaker::GenICam::gcstring& cameraModel)
+    {
+        const char* const codes[] = {"BFLY", "BFS", "ORX", "FFY", "CM3", "GS3", "FL3"};
+        const cameraFamily families[] = {FAMILY_BFLY, FAMILY_BFS, FAMILY_ORX, FAMILY_FFY, FAMILY_CM3, FAMILY_GS3, FAMILY_FL3};
+
+        for (unsigned int i = 0; i < sizeof(codes) / sizeof(codes[0]); i++)
+        {
+            if (cameraModel.find(codes[i]) != std::string::npos)
+            {
+                return families[i];
+            }
+        }
+        return FAMILY_UNKNOWN;
+    }
+
+    Spinnaker::GenICam::gcstring serialNumber;
+    Spinnaker::GenICam::gcstring modelName;
+    int64_t deviceType;
+    cameraFamily family;
+    clockLatchType latchType;
+
+    // Nodes below are only resolved for an initialized camera
+    bool resolvedNodes;
+    Spinnaker::GenApi::CCommandPtr ptrTimestampLatch;
+    Spinnaker::GenApi::CIntegerPtr ptrTimestampValue;
+    Spinnaker::GenApi::CIntegerPtr ptrTimestampTickFrequency;
+
+    Spinnaker::GenApi::CBooleanPtr ptrIEEE1588;
+    Spinnaker::GenApi::CCommandPtr ptrIEEE1588DataSetLatch;
+    Spinnaker::GenApi::CEnumerationPtr ptrIEEE1588StatusLatched;
+    Spinnaker::GenApi::CIntegerPtr ptrIEEE1588OffsetFromMasterLatched;
+};
+
+#endif // CAMERA_PROFILE_H
@@ -0,0 +1,1203 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief CaptureCoordinator.h spreads a camera array over several hosts and
+*  assembles synchronized framesets from the frame metadata of all of them.
+*
+*  Every capture host grabs its own cameras and sends the serial number,
+*  frame ID and IEEE 1588 timestamp of every frame to one aggregator over
+*  TCP; the images themselves stay on the host. As all cameras share the
+*  IEEE 1588 clock, timestamps from different hosts can be compared directly.
+*
+*  CaptureHostLink is the capture host side. Connect() introduces the host
+*  and the IEEE 1588 status of its cameras, and WaitForStart() blocks until
+*  the aggregator has heard from every host and found them on one clock, so
+*  that all hosts start acquisition together. Send() queues a frame record
+*  and never blocks the grab thread; a sender thread batches the records
+*  into as few writes as possible. IsStopRequested() turns true once the
+*  aggregator has its framesets or the connection is lost.
+*
+*  FrameSetAggregator is the aggregator side. Run() accepts the hosts,
+*  checks that exactly one camera of the rig is the IEEE 1588 master and
+*  that every other one follows it closely, and starts the hosts. Frames are
+*  then grouped into framesets spanning every camera of the rig, the same
+*  way as for cameras on one host: when every camera has a frame waiting,
+*  the oldest frames are grouped if their timestamps lie within the
+*  tolerance, and otherwise the oldest frame is dropped. Complete framesets
+*  are passed in order to a callback on the calling thread.
+*
+*  The protocol is one line of text per message, so it can be followed with
+*  any TCP tool. Typical use:
+*
+*      // On every capture host
+*      CaptureHostLink link;
+*      if (link.Connect(aggregatorAddress, k_coordinatorPort, hostName, cameras, error) &&
+*          link.WaitForStart(k_coordinatorStartTimeout, error))
+*      {
+*          ... grab threads call link.Send(record) until link.IsStopRequested() ...
+*          link.Finish();
+*      }
+*
+*      // On the aggregator
+*      FrameSetAggregator aggregator(numHosts, tolerance, maxPending);
+*      aggregator.Run(k_coordinatorPort, numFrameSets, callback, error);
+*      aggregator.PrintStatistics();
+*/
+
+#ifndef CAPTURE_COORDINATOR_H
+#define CAPTURE_COORDINATOR_H
+
+// Include this header before Spinnaker.h and windows.h, as winsock2.h must come before windows.h
+// NOMINMAX keeps the min and max macros of windows.h away from std::min and std::max
+#if defined WIN32 || defined _WIN32 || defined WIN64 || defined _WIN64
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+#define CAPTURE_COORDINATOR_WINSOCK 1
+typedef SOCKET CoordinatorSocketHandle;
+#define COORDINATOR_INVALID_SOCKET INVALID_SOCKET
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int CoordinatorSocketHandle;
+#define COORDINATOR_INVALID_SOCKET (-1)
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "FrameSetMatcher.h"
+
+// TCP port the aggregator listens on
+const unsigned short k_coordinatorPort = 50800;
+
+// Time the aggregator waits for all hosts to connect, and the hosts wait to be started, in milliseconds
+const unsigned int k_coordinatorStartTimeout = 60000;
+
+// Time allowed for each handshake message, in milliseconds
+const unsigned int k_coordinatorHandshakeTimeout = 5000;
+
+// Time the aggregator waits for each rig frameset once the hosts are started, in milliseconds
+const unsigned int k_coordinatorFrameSetTimeout = 10000;
+
+// Time the aggregator keeps reading after STOP for the hosts to finish, in milliseconds
+const unsigned int k_coordinatorDrainTimeout = 2000;
+
+// Interval at which blocked reads check whether they should give up, in milliseconds
+const unsigned int k_coordinatorPollInterval = 100;
+
+// Frame records a capture host queues before it drops new ones instead of blocking its grab threads
+const size_t k_coordinatorQueueDepth = 4096;
+
+// Largest offset from the IEEE 1588 master, in nanoseconds, for a camera to count as synchronized
+const int64_t k_coordinatorMaxClockOffset = 1000;
+
+// A camera of the rig as introduced by its capture host
+struct RemoteCamera
+{
+    std::string serialNumber;
+    std::string clockStatus; // GevIEEE1588StatusLatched, e.g. "Master" or "Slave"
+    int64_t offsetFromMaster;
+    unsigned int hostIndex;
+};
+
+// Metadata of one frame, sent by the capture host that grabbed it
+struct FrameRecord
+{
+    std::string serialNumber;
+    uint64_t frameID;
+    int64_t timestamp;
+    bool incomplete;
+};
+
+// One frame from every camera of the rig, indexed like FrameSetAggregator::GetCameras()
+struct RemoteFrameSet
+{
+    unsigned int index;
+    std::vector<FrameRecord> frames;
+    int64_t spread;
+};
+
+// Called on the thread running the aggregator for every complete frameset
+typedef std::function<void(const RemoteFrameSet&)> RemoteFrameSetCallback;
+
+// Starts and stops the socket library for as long as a coordinator object lives
+class CoordinatorNetwork
+{
+public:
+    CoordinatorNetwork()
+    {
+#if defined(CAPTURE_COORDINATOR_WINSOCK)
+        WSADATA data;
+        m_started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+        m_started = true;
+#endif
+    }
+
+    ~CoordinatorNetwork()
+    {
+#if defined(CAPTURE_COORDINATOR_WINSOCK)
+        if (m_started)
+        {
+            WSACleanup();
+        }
+#endif
+    }
+
+    bool IsStarted() const
+    {
+        return m_started;
+    }
+
+private:
+    CoordinatorNetwork(const CoordinatorNetwork&);
+    CoordinatorNetwork& operator=(const CoordinatorNetwork&);
+
+    bool m_started;
+};
+
+// Blocking TCP connection that reads line by line
+class CoordinatorConnection
+{
+public:
+    CoordinatorConnection() : m_socket(COORDINATOR_INVALID_SOCKET)
+    {
+    }
+
+    ~CoordinatorConnection()
+    {
+        Close();
+    }
+
+    bool Connect(const std::string& address, unsigned short port, std::string& error)
+    {
+        Close();
+
+        addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
+
+        std::ostringstream service;
+        service << port;
+
+        addrinfo* addresses = nullptr;
+        if (getaddrinfo(address.c_str(), service.str().c_str(), &hints, &addresses) != 0 || addresses == nullptr)
+        {
+            error = "cannot resolve " + address;
+            return false;
+        }
+
+        for (addrinfo* candidate = addresses; candidate != nullptr; candidate = candidate->ai_next)
+        {
+            m_socket = socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+            if (m_socket == COORDINATOR_INVALID_SOCKET)
+            {
+                continue;
+            }
+            if (connect(m_socket, candidate->ai_addr, static_cast<int>(candidate->ai_addrlen)) == 0)
+            {
+                break;
+            }
+            Close();
+        }
+        freeaddrinfo(addresses);
+
+        if (m_socket == COORDINATOR_INVALID_SOCKET)
+        {
+            error = "cannot connect to " + address + ":" + service.str();
+            return false;
+        }
+
+        SetNoDelay();
+        return true;
+    }
+
+    // Takes over a socket returned by accept()
+    void Attach(CoordinatorSocketHandle handle)
+    {
+        Close();
+        m_socket = handle;
+        SetNoDelay();
+    }
+
+    bool IsOpen() const
+    {
+        return m_socket != COORDINATOR_INVALID_SOCKET;
+    }
+
+    // Sends every byte of the text; not to be called from two threads at once
+    bool SendAll(const std::string& text)
+    {
+#if defined(MSG_NOSIGNAL)
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        if (!IsOpen())
+        {
+            return false;
+        }
+
+        size_t sent = 0;
+        while (sent < text.size())
+        {
+            const int count = send(m_socket, text.data() + sent, static_cast<int>(text.size() - sent), flags);
+            if (count <= 0)
+            {
+                return false;
+            }
+            sent += static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+    //
+    // Reads the next line without its line break
+    //
+    // *** NOTES ***
+    // Returns 1 for a line, 0 if none arrived within timeoutMs and -1 once the
+    // connection is closed. Lines that arrive together are kept and returned
+    // by the following calls without waiting.
+    //
+    int ReadLine(std::string& line, unsigned int timeoutMs)
+    {
+        for (;;)
+        {
+            const size_t end = m_received.find('\n');
+            if (end != std::string::npos)
+            {
+                line = m_received.substr(0, end);
+                m_received.erase(0, end + 1);
+                if (!line.empty() && line[line.size() - 1] == '\r')
+                {
+                    line.erase(line.size() - 1);
+                }
+                return 1;
+            }
+
+            if (!IsOpen())
+            {
+                return -1;
+            }
+
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(m_socket, &readable);
+            timeval timeout;
+            timeout.tv_sec = static_cast<long>(timeoutMs / 1000);
+            timeout.tv_usec = static_cast<long>((timeoutMs % 1000) * 1000);
+
+            const int ready = select(static_cast<int>(m_socket + 1), &readable, nullptr, nullptr, &timeout);
+            if (ready == 0)
+            {
+                return 0;
+            }
+            if (ready < 0)
+            {
+                return -1;
+            }
+
+            char buffer[4096];
+            const int count = recv(m_socket, buffer, sizeof(buffer), 0);
+            if (count <= 0)
+            {
+                return -1;
+            }
+            m_received.append(buffer, static_cast<size_t>(count));
+        }
+    }
+
+    void Close()
+    {
+        if (m_socket != COORDINATOR_INVALID_SOCKET)
+        {
+#if defined(CAPTURE_COORDINATOR_WINSOCK)
+            closesocket(m_socket);
+#else
+            close(m_socket);
+#endif
+            m_socket = COORDINATOR_INVALID_SOCKET;
+        }
+        m_received.clear();
+    }
+
+private:
+    CoordinatorConnection(const CoordinatorConnection&);
+    CoordinatorConnection& operator=(const CoordinatorConnection&);
+
+    // Frame records are small; send them as soon as they are written
+    void SetNoDelay()
+    {
+        int noDelay = 1;
+        setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+    }
+
+    CoordinatorSocketHandle m_socket;
+    std::string m_received;
+};
+
+// Accepts the connections of the capture hosts
+class CoordinatorListener
+{
+public:
+    CoordinatorListener() : m_socket(COORDINATOR_INVALID_SOCKET)
+    {
+    }
+
+    ~CoordinatorListener()
+    {
+        Close();
+    }
+
+    bool Listen(unsigned short port, std::string& error)
+    {
+        Close();
+
+        m_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (m_socket == COORDINATOR_INVALID_SOCKET)
+        {
+            error = "cannot create a socket";
+            return false;
+        }
+
+        // Allow a restarted aggregator to listen again straight away
+        int reuse = 1;
+        setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+
+        if (bind(m_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(m_socket, SOMAXCONN) != 0)
+        {
+            std::ostringstream text;
+            text << "cannot listen on port " << port;
+            error = text.str();
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    // Waits up to timeoutMs for the next host; peer is set to its address
+    bool Accept(CoordinatorConnection& connection, unsigned int timeoutMs, std::string& peer)
+    {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(m_socket, &readable);
+        timeval timeout;
+        timeout.tv_sec = static_cast<long>(timeoutMs / 1000);
+        timeout.tv_usec = static_cast<long>((timeoutMs % 1000) * 1000);
+
+        if (select(static_cast<int>(m_socket + 1), &readable, nullptr, nullptr, &timeout) <= 0)
+        {
+            return false;
+        }
+
+        sockaddr_in address;
+        socklen_t length = sizeof(address);
+        const CoordinatorSocketHandle handle = accept(m_socket, reinterpret_cast<sockaddr*>(&address), &length);
+        if (handle == COORDINATOR_INVALID_SOCKET)
+        {
+            return false;
+        }
+
+        char name[INET_ADDRSTRLEN] = "";
+        inet_ntop(AF_INET, &address.sin_addr, name, sizeof(name));
+        peer = name;
+        connection.Attach(handle);
+        return true;
+    }
+
+    void Close()
+    {
+        if (m_socket != COORDINATOR_INVALID_SOCKET)
+        {
+#if defined(CAPTURE_COORDINATOR_WINSOCK)
+            closesocket(m_socket);
+#else
+            close(m_socket);
+#endif
+            m_socket = COORDINATOR_INVALID_SOCKET;
+        }
+    }
+
+private:
+    CoordinatorListener(const CoordinatorListener&);
+    CoordinatorListener& operator=(const CoordinatorListener&);
+
+    CoordinatorSocketHandle m_socket;
+};
+
+// Splits a protocol line into its space separated words
+inline std::vector<std::string> SplitCoordinatorLine(const std::string& line)
+{
+    std::vector<std::string> words;
+    std::istringstream stream(line);
+    std::string word;
+    while (stream >> word)
+    {
+        words.push_back(word);
+    }
+    return words;
+}
+
+//
+// Capture host side of the coordinator
+//
+// *** NOTES ***
+// The host sends HELLO <host> <cameras>, one CAMERA <serial> <status>
+// <offset> line per camera and READY, then waits for START or ABORT
+// <reason>. While it streams it sends FRAME <serial> <frameID> <timestamp>
+// <incomplete> lines and listens for STOP; it ends with DONE <sent>
+// <dropped>.
+//
+class CaptureHostLink
+{
+public:
+    explicit CaptureHostLink(size_t queueDepth = k_coordinatorQueueDepth)
+        : m_queueDepth(std::max<size_t>(queueDepth, 1)), m_started(false), m_finishing(false), m_stopRequested(false),
+          m_connectionLost(false), m_numSent(0), m_numDropped(0), m_numWrites(0)
+    {
+    }
+
+    ~CaptureHostLink()
+    {
+        Finish();
+    }
+
+    // Connects to the aggregator and introduces this host and its cameras
+    bool Connect(
+        const std::string& address,
+        unsigned short port,
+        const std::string& hostName,
+        const std::vector<RemoteCamera>& cameras,
+        std::string& error)
+    {
+        if (!m_network.IsStarted())
+        {
+            error = "the socket library cannot be started";
+            return false;
+        }
+        if (!m_connection.Connect(address, port, error))
+        {
+            return false;
+        }
+
+        std::ostringstream hello;
+        hello << "HELLO " << (hostName.empty() ? "host" : hostName) << " " << cameras.size() << "\n";
+        for (size_t i = 0; i < cameras.size(); i++)
+        {
+            hello << "CAMERA " << cameras[i].serialNumber << " "
+                  << (cameras[i].clockStatus.empty() ? "Unknown" : cameras[i].clockStatus) << " "
+                  << cameras[i].offsetFromMaster << "\n";
+        }
+        hello << "READY\n";
+
+        if (!m_connection.SendAll(hello.str()))
+        {
+            error = "connection to the aggregator lost while introducing the cameras";
+            m_connection.Close();
+            return false;
+        }
+        return true;
+    }
+
+    // Waits until the aggregator starts every host; returns false if it aborts, with its reason
+    bool WaitForStart(unsigned int timeoutMs, std::string& error)
+    {
+        std::string line;
+        const int status = m_connection.ReadLine(line, timeoutMs);
+        if (status <= 0)
+        {
+            error = status == 0 ? "the aggregator did not start the capture in time" : "connection to the aggregator lost";
+            m_connection.Close();
+            return false;
+        }
+
+        const std::vector<std::string> words = SplitCoordinatorLine(line);
+        if (words.empty() || words[0] != "START")
+        {
+            error = !words.empty() && words[0] == "ABORT" ? "aborted by the aggregator: " + line.substr(std::min<size_t>(line.size(), 6))
+                                                          : "unexpected reply " + line;
+            m_connection.Close();
+            return false;
+        }
+
+        m_started = true;
+        m_sender = std::thread(&CaptureHostLink::SendRecords, this);
+        m_listener = std::thread(&CaptureHostLink::ListenForStop, this);
+        return true;
+    }
+
+    // Queues the record of a frame; drops it instead of blocking when the queue is full
+    void Send(const FrameRecord& record)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_started || m_finishing || m_connectionLost)
+        {
+            return;
+        }
+        if (m_queue.size() >= m_queueDepth)
+        {
+            m_numDropped++;
+            return;
+        }
+        m_queue.push_back(record);
+        m_recordReady.notify_one();
+    }
+
+    // True once the aggregator has all its framesets, or the connection is lost
+    bool IsStopRequested() const
+    {
+        return m_stopRequested;
+    }
+
+    bool IsConnectionLost() const
+    {
+        return m_connectionLost;
+    }
+
+    // Sends the records still queued and the final counts, then closes the connection
+    void Finish()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_finishing)
+            {
+                return;
+            }
+            m_finishing = true;
+            m_recordReady.notify_all();
+        }
+
+        if (m_sender.joinable())
+        {
+            m_sender.join();
+        }
+        if (m_listener.joinable())
+        {
+            m_listener.join();
+        }
+        m_connection.Close();
+    }
+
+    void PrintStatistics()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::cout << "Frame records sent to the aggregator: " << m_numSent << " in " << m_numWrites << " writes, "
+                  << m_numDropped << " dropped" << std::endl;
+        if (m_connectionLost)
+        {
+            std::cout << "Connection to the aggregator was lost" << std::endl;
+        }
+    }
+
+private:
+    CaptureHostLink(const CaptureHostLink&);
+    CaptureHostLink& operator=(const CaptureHostLink&);
+
+    // Sender thread; writes every batch of queued records at once
+    void SendRecords()
+    {
+        std::deque<FrameRecord> batch;
+        std::string text;
+
+        for (;;)
+        {
+            bool finishing = false;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_recordReady.wait(lock, [this] { return !m_queue.empty() || m_finishing; });
+                batch.swap(m_queue);
+                finishing = m_finishing;
+            }
+
+            std::ostringstream lines;
+            for (size_t i = 0; i < batch.size(); i++)
+            {
+                lines << "FRAME " << batch[i].serialNumber << " " << batch[i].frameID << " " << batch[i].timestamp << " "
+                      << (batch[i].incomplete ? 1 : 0) << "\n";
+            }
+
+            if (finishing)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                lines << "DONE " << m_numSent + batch.size() << " " << m_numDropped << "\n";
+            }
+            text = lines.str();
+
+            const bool sent = text.empty() || m_connection.SendAll(text);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (sent)
+                {
+                    m_numSent += static_cast<unsigned int>(batch.size());
+                    m_numWrites++;
+                }
+                else
+                {
+                    m_connectionLost = true;
+                    m_stopRequested = true;
+                    m_numDropped += static_cast<unsigned int>(batch.size());
+                }
+            }
+            batch.clear();
+
+            if (finishing || !sent)
+            {
+                return;
+            }
+        }
+    }
+
+    // Listener thread; waits for STOP until the link is finished
+    void ListenForStop()
+    {
+        std::string line;
+        for (;;)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_finishing || m_connectionLost)
+                {
+                    return;
+                }
+            }
+
+            const int status = m_connection.ReadLine(line, k_coordinatorPollInterval);
+            if (status < 0)
+            {
+                // The aggregator closes the connection once it has read DONE
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_connectionLost = !m_finishing;
+                m_stopRequested = true;
+                return;
+            }
+            if (status > 0 && line == "STOP")
+            {
+                m_stopRequested = true;
+            }
+        }
+    }
+
+    CoordinatorNetwork m_network;
+    CoordinatorConnection m_connection;
+    const size_t m_queueDepth;
+
+    std::mutex m_mutex;
+    std::condition_variable m_recordReady;
+    std::deque<FrameRecord> m_queue;
+    std::thread m_sender;
+    std::thread m_listener;
+
+    bool m_started;
+    bool m_finishing;
+    std::atomic<bool> m_stopRequested;
+    std::atomic<bool> m_connectionLost;
+    unsigned int m_numSent;
+    unsigned int m_numDropped;
+    unsigned int m_numWrites;
+};
+
+//
+// Aggregator side of the coordinator
+//
+// *** NOTES ***
+// The frame records of every camera of the rig, whichever host it is on, are
+// grouped by FrameSetMatcher, the same one TimeSync uses for the cameras of
+// one host. Records from one host arrive in order per camera, but hosts are
+// read on their own threads, so no assumption is made about the order
+// between cameras.
+//
+class FrameSetAggregator
+{
+public:
+    FrameSetAggregator(unsigned int numHosts, int64_t tolerance, size_t maxPending)
+        : m_numHosts(numHosts), m_matcher(0, tolerance, maxPending), m_stopping(false), m_numDelivered(0)
+    {
+    }
+
+    ~FrameSetAggregator()
+    {
+        Stop();
+    }
+
+    //
+    // Runs the whole capture of the rig
+    //
+    // *** NOTES ***
+    // Accepts numHosts capture hosts, checks the rig clock, starts every host
+    // and passes numFrameSets complete framesets to the callback on the
+    // calling thread. It then stops the hosts and waits a moment for their
+    // final counts. Returns false, with the reason, if the rig could not be
+    // started, a host was lost before all framesets arrived, or no frameset
+    // arrived for k_coordinatorFrameSetTimeout, as when a camera of the rig
+    // is not streaming or not being triggered.
+    //
+    bool Run(unsigned short port, unsigned int numFrameSets, const RemoteFrameSetCallback& callback, std::string& error)
+    {
+        if (!m_network.IsStarted())
+        {
+            error = "the socket library cannot be started";
+            return false;
+        }
+
+        if (!AcceptHosts(port, error) || !CheckRigClock(error))
+        {
+            Broadcast("ABORT " + error + "\n");
+            CloseHosts();
+            return false;
+        }
+
+        m_matcher.Reset(m_cameras.size());
+        m_numIncomplete.assign(m_cameras.size(), 0);
+        m_numFrames.assign(m_cameras.size(), 0);
+
+        Broadcast("START\n");
+        for (size_t i = 0; i < m_hosts.size(); i++)
+        {
+            m_hosts[i]->reader = std::thread(&FrameSetAggregator::ReadHost, this, static_cast<unsigned int>(i));
+        }
+
+        bool complete = true;
+        while (m_numDelivered < numFrameSets)
+        {
+            RemoteFrameSet frameSet;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                const bool woken =
+                    m_frameSetReady.wait_for(lock, std::chrono::milliseconds(k_coordinatorFrameSetTimeout),
+                                             [this] { return !m_ready.empty() || AllHostsClosed(); });
+                if (!woken)
+                {
+                    std::ostringstream reason;
+                    reason << "no rig frameset arrived within " << k_coordinatorFrameSetTimeout << " ms after "
+                           << m_numDelivered << " framesets; check that every camera of the rig is streaming"
+                           << " and, when triggered, that its trigger is wired";
+                    error = reason.str();
+                    complete = false;
+                    break;
+                }
+                if (m_ready.empty())
+                {
+                    error = "every capture host disconnected before all framesets arrived";
+                    complete = false;
+                    break;
+                }
+                frameSet = m_ready.front();
+                m_ready.pop_front();
+            }
+
+            callback(frameSet);
+            m_numDelivered++;
+        }
+
+        Stop();
+        return complete;
+    }
+
+    // Every camera of the rig, in the order of the frames of a frameset
+    const std::vector<RemoteCamera>& GetCameras() const
+    {
+        return m_cameras;
+    }
+
+    void PrintStatistics()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (size_t i = 0; i < m_hosts.size(); i++)
+        {
+            const HostState& host = *m_hosts[i];
+            std::cout << "Host " << i << " (" << host.name << " at " << host.peer << "): " << host.cameras.size()
+                      << " cameras, " << host.numRecords << " frame records received";
+            if (host.done)
+            {
+                std::cout << " of " << host.numSent << " sent, " << host.numHostDropped << " dropped on the host";
+            }
+            else
+            {
+                std::cout << ", did not finish";
+            }
+            std::cout << std::endl;
+
+            for (size_t j = 0; j < host.cameras.size(); j++)
+            {
+                const unsigned int camIndex = host.cameras[j];
+                std::cout << "\tCamera " << camIndex << " (" << m_cameras[camIndex].serialNumber << ", "
+                          << m_cameras[camIndex].clockStatus << "): " << m_numFrames[camIndex] << " frames, "
+                          << m_numIncomplete[camIndex] << " incomplete" << std::endl;
+            }
+        }
+
+        std::cout << "Rig framesets assembled: " << m_matcher.GetNumFrameSets() << ", delivered: " << m_numDelivered
+                  << std::endl;
+        m_matcher.PrintStatistics();
+    }
+
+private:
+    FrameSetAggregator(const FrameSetAggregator&);
+    FrameSetAggregator& operator=(const FrameSetAggregator&);
+
+    struct HostState
+    {
+        HostState() : numRecords(0), numSent(0), numHostDropped(0), done(false), closed(false)
+        {
+        }
+
+        CoordinatorConnection connection;
+        std::mutex sendMutex;
+        std::thread reader;
+        std::string name;
+        std::string peer;
+        std::vector<unsigned int> cameras;
+        unsigned int numRecords;
+        unsigned int numSent;
+        unsigned int numHostDropped;
+        bool done;
+        bool closed;
+    };
+
+    // Accepts every host and reads its introduction
+    bool AcceptHosts(unsigned short port, std::string& error)
+    {
+        CoordinatorListener listener;
+        if (!listener.Listen(port, error))
+        {
+            return false;
+        }
+
+        const std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(k_coordinatorStartTimeout);
+
+        while (m_hosts.size() < m_numHosts)
+        {
+            const int64_t remainingMs =
+                std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+
+            std::unique_ptr<HostState> host(new HostState());
+            if (remainingMs <= 0 || !listener.Accept(host->connection, static_cast<unsigned int>(remainingMs), host->peer))
+            {
+                std::ostringstream text;
+                text << "only " << m_hosts.size() << " of " << m_numHosts << " capture hosts connected";
+                error = text.str();
+                return false;
+            }
+
+            if (!ReadHello(*host, static_cast<unsigned int>(m_hosts.size()), error))
+            {
+                error = "host at " + host->peer + ": " + error;
+                host->connection.SendAll("ABORT " + error + "\n");
+                return false;
+            }
+
+            std::cout << "Capture host " << m_hosts.size() << " (" << host->name << " at " << host->peer << ") connected with "
+                      << host->cameras.size() << " cameras" << std::endl;
+            m_hosts.push_back(std::move(host));
+        }
+        return true;
+    }
+
+    bool ReadHello(HostState& host, unsigned int hostIndex, std::string& error)
+    {
+        std::string line;
+        std::vector<std::string> words;
+
+        if (host.connection.ReadLine(line, k_coordinatorHandshakeTimeout) <= 0 ||
+            (words = SplitCoordinatorLine(line)).size() != 3 || words[0] != "HELLO")
+        {
+            error = "no HELLO";
+            return false;
+        }
+        host.name = words[1];
+        const unsigned int numCameras = static_cast<unsigned int>(strtoul(words[2].c_str(), nullptr, 10));
+
+        for (unsigned int i = 0; i < numCameras; i++)
+        {
+            if (host.connection.ReadLine(line, k_coordinatorHandshakeTimeout) <= 0 ||
+                (words = SplitCoordinatorLine(line)).size() != 4 || words[0] != "CAMERA")
+            {
+                error = "incomplete camera list";
+                return false;
+            }
+            if (m_cameraIndex.count(words[1]) != 0)
+            {
+                error = "camera " + words[1] + " is already connected through another host";
+                return false;
+            }
+
+            RemoteCamera camera;
+            camera.serialNumber = words[1];
+            camera.clockStatus = words[2];
+            camera.offsetFromMaster = strtoll(words[3].c_str(), nullptr, 10);
+            camera.hostIndex = hostIndex;
+
+            m_cameraIndex[camera.serialNumber] = static_cast<unsigned int>(m_cameras.size());
+            host.cameras.push_back(static_cast<unsigned int>(m_cameras.size()));
+            m_cameras.push_back(camera);
+        }
+
+        if (host.connection.ReadLine(line, k_coordinatorHandshakeTimeout) <= 0 || line != "READY")
+        {
+            error = "no READY";
+            return false;
+        }
+        return true;
+    }
+
+    // Every camera of every host must follow the same IEEE 1588 master
+    bool CheckRigClock(std::string& error)
+    {
+        std::ostringstream text;
+        unsigned int numMasters = 0;
+
+        if (m_cameras.empty())
+        {
+            error = "the capture hosts have no cameras";
+            return false;
+        }
+
+        for (size_t i = 0; i < m_cameras.size(); i++)
+        {
+            const RemoteCamera& camera = m_cameras[i];
+            if (camera.clockStatus == "Master")
+            {
+                numMasters++;
+            }
+            else if (camera.clockStatus != "Slave")
+            {
+                text << "camera " << camera.serialNumber << " has IEEE 1588 status " << camera.clockStatus;
+                error = text.str();
+                return false;
+            }
+            else if (std::abs(camera.offsetFromMaster) > k_coordinatorMaxClockOffset)
+            {
+                text << "camera " << camera.serialNumber << " is " << camera.offsetFromMaster
+                     << " ns away from the IEEE 1588 master";
+                error = text.str();
+                return false;
+            }
+        }
+
+        // Two masters mean two networks that do not share a clock
+        if (numMasters != 1)
+        {
+            text << "the rig has " << numMasters << " IEEE 1588 masters instead of one";
+            error = text.str();
+            return false;
+        }
+        return true;
+    }
+
+    // Reader thread of one host
+    void ReadHost(unsigned int hostIndex)
+    {
+        HostState& host = *m_hosts[hostIndex];
+        std::chrono::steady_clock::time_point drainDeadline;
+        bool draining = false;
+        std::string line;
+
+        for (;;)
+        {
+            const int status = host.connection.ReadLine(line, k_coordinatorPollInterval);
+            if (status < 0)
+            {
+                break;
+            }
+
+            if (status == 0)
+            {
+                // Once stopped, give the host a moment to send its final counts
+                if (m_stopping)
+                {
+                    if (!draining)
+                    {
+                        draining = true;
+                        drainDeadline =
+                            std::chrono::steady_clock::now() + std::chrono::milliseconds(k_coordinatorDrainTimeout);
+                    }
+                    else if (std::chrono::steady_clock::now() > drainDeadline)
+                    {
+                        break;
+                    }
+                }
+                continue;
+            }
+
+            const std::vector<std::string> words = SplitCoordinatorLine(line);
+            if (words.size() == 5 && words[0] == "FRAME")
+            {
+                FrameRecord record;
+                record.serialNumber = words[1];
+                record.frameID = strtoull(words[2].c_str(), nullptr, 10);
+                record.timestamp = strtoll(words[3].c_str(), nullptr, 10);
+                record.incomplete = words[4] != "0";
+                Add(hostIndex, record);
+            }
+            else if (words.size() == 3 && words[0] == "DONE")
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                host.numSent = static_cast<unsigned int>(strtoul(words[1].c_str(), nullptr, 10));
+                host.numHostDropped = static_cast<unsigned int>(strtoul(words[2].c_str(), nullptr, 10));
+                host.done = true;
+                break;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        host.closed = true;
+        m_frameSetReady.notify_all();
+    }
+
+    // Adds the record of one frame and assembles every frameset it completes
+    void Add(unsigned int hostIndex, const FrameRecord& record)
+    {
+        HostState& host = *m_hosts[hostIndex];
+        std::lock_guard<std::mutex> lock(m_mutex);
+        host.numRecords++;
+
+        // Records for cameras the host did not introduce are ignored
+        std::map<std::string, unsigned int>::const_iterator camera = m_cameraIndex.find(record.serialNumber);
+        if (camera == m_cameraIndex.end() || m_cameras[camera->second].hostIndex != hostIndex)
+        {
+            return;
+        }
+        const unsigned int camIndex = camera->second;
+
+        m_numFrames[camIndex]++;
+        if (record.incomplete)
+        {
+            m_numIncomplete[camIndex]++;
+            return;
+        }
+
+        m_matcher.Add(camIndex, record, [this](unsigned int index, std::vector<FrameRecord>& frames, int64_t spread) {
+            RemoteFrameSet frameSet;
+            frameSet.index = index;
+            frameSet.frames.swap(frames);
+            frameSet.spread = spread;
+
+            // Framesets are only metadata, so they are queued rather than holding back the readers
+            m_ready.push_back(frameSet);
+            m_frameSetReady.notify_one();
+            return true;
+        });
+    }
+
+    // Called with m_mutex held
+    bool AllHostsClosed() const
+    {
+        for (size_t i = 0; i < m_hosts.size(); i++)
+        {
+            if (!m_hosts[i]->closed)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void Broadcast(const std::string& text)
+    {
+        for (size_t i = 0; i < m_hosts.size(); i++)
+        {
+            std::lock_guard<std::mutex> lock(m_hosts[i]->sendMutex);
+            m_hosts[i]->connection.SendAll(text);
+        }
+    }
+
+    // Stops every host and waits for the readers to finish
+    void Stop()
+    {
+        if (m_stopping.exchange(true))
+        {
+            return;
+        }
+
+        Broadcast("STOP\n");
+        for (size_t i = 0; i < m_hosts.size(); i++)
+        {
+            if (m_hosts[i]->reader.joinable())
+            {
+                m_hosts[i]->reader.join();
+            }
+        }
+        CloseHosts();
+    }
+
+    void CloseHosts()
+    {
+        for (size_t i = 0; i < m_hosts.size(); i++)
+        {
+            m_hosts[i]->connection.Close();
+        }
+    }
+
+    CoordinatorNetwork m_network;
+    const unsigned int m_numHosts;
+
+    std::vector<std::unique_ptr<HostState>> m_hosts;
+    std::vector<RemoteCamera> m_cameras;
+    std::map<std::string, unsigned int> m_cameraIndex;
+
+    std::mutex m_mutex;
+    std::condition_variable m_frameSetReady;
+    FrameSetMatcher<FrameRecord> m_matcher;
+    std::deque<RemoteFrameSet> m_ready;
+    std::vector<unsigned int> m_numFrames;
+    std::vector<unsigned int> m_numIncomplete;
+    std::atomic<bool> m_stopping;
+    unsigned int m_numDelivered;
+};
+
+#endif // CAPTURE_COORDINATOR_H
@@ -0,0 +1,580 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief ColorCorrectionKernel.h applies a linear 3x3 color correction matrix
+*  (plus a per-channel offset) to BGR8 and BGR16 images on the host.
+*
+*  The matrix is converted once into 4.12 fixed-point coefficients and applied
+*  with SSE4.1/AVX2 on x86 and NEON on ARM, falling back to a scalar loop that
+*  produces bit-identical results elsewhere. DemosaicAndApply() fuses a
+*  bilinear 8-bit Bayer to BGR8 conversion with the matrix, one row at a time,
+*  so every pixel is corrected while it is still in cache.
+*/
+
+#ifndef COLOR_CORRECTION_KERNEL_H
+#define COLOR_CORRECTION_KERNEL_H
+
+#include "Spinnaker.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#define CCM_KERNEL_AVX2 1
+#endif
+
+// MSVC does not define __SSE4_1__, and x64 alone only guarantees SSE2, so SSE4.1 is
+// used there only when building with /arch:AVX or /arch:AVX2
+#if defined(__AVX2__) || defined(__SSE4_1__) || (defined(_MSC_VER) && defined(__AVX__))
+#define CCM_KERNEL_SSE41 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define CCM_KERNEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Number of fractional bits of the fixed-point coefficients
+const int k_ccmFractionBits = 12;
+
+// Coefficients are limited so that the 16-bit path cannot overflow 32-bit accumulators
+const float k_ccmMaxRowSum = 6.0f;
+
+// Linear color correction in normalized units; out[c] = sum(m[c][i] * in[i]) + offset[c].
+// Rows and columns are in B, G, R order to match the memory layout of BGR images.
+struct ColorMatrix
+{
+    float m[3][3];
+    float offset[3];
+};
+
+class ColorCorrectionKernel
+{
+public:
+    explicit ColorCorrectionKernel(const ColorMatrix& matrix) : m_matrix(matrix), m_valid(true)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            float rowSum = 0.0f;
+            int64_t bias16 = 0;
+
+            for (int i = 0; i < 3; i++)
+            {
+                rowSum += std::fabs(matrix.m[c][i]);
+                m_coef[c][i] = static_cast<int16_t>(Round(matrix.m[c][i] * (1 << k_ccmFractionBits)));
+                bias16 += static_cast<int64_t>(m_coef[c][i]) * 32768;
+            }
+
+            if (rowSum > k_ccmMaxRowSum || std::fabs(matrix.offset[c]) > 1.0f)
+            {
+                m_valid = false;
+            }
+
+            // The offset also carries the rounding term, and for 16 bits the bias of the signed input
+            const int32_t round = 1 << (k_ccmFractionBits - 1);
+            m_offset8[c] = static_cast<int32_t>(Round(matrix.offset[c] * 255.0f * (1 << k_ccmFractionBits))) + round;
+            m_offset16[c] = static_cast<int32_t>(
+                static_cast<int64_t>(Round(matrix.offset[c] * 65535.0f * (1 << k_ccmFractionBits))) + round + bias16);
+        }
+    }
+
+    // False if the matrix is outside the range the fixed-point kernels can represent
+    bool IsValid() const
+    {
+        return m_valid;
+    }
+
+    const ColorMatrix& GetMatrix() const
+    {
+        return m_matrix;
+    }
+
+    // Fixed-point coefficients and 8-bit offsets of the kernel, for other implementations that
+    // must give the same results
+    void GetFixedPoint(int16_t coef[3][3], int32_t offset8[3]) const
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                coef[c][i] = m_coef[c][i];
+            }
+            offset8[c] = m_offset8[c];
+        }
+    }
+
+    // Name of the instruction set the kernels were compiled for
+    static const char* GetInstructionSet()
+    {
+#if defined(CCM_KERNEL_AVX2)
+        return "AVX2";
+#elif defined(CCM_KERNEL_SSE41)
+        return "SSE4.1";
+#elif defined(CCM_KERNEL_NEON)
+        return "NEON";
+#else
+        return "scalar";
+#endif
+    }
+
+    // Color correct a BGR8 or BGR16 image into a preallocated image of the same size and format.
+    // With useSimd set to false the scalar kernel is used, for comparison.
+    bool Apply(const Spinnaker::ImagePtr& src, Spinnaker::ImagePtr& dest, bool useSimd = true) const
+    {
+        const Spinnaker::PixelFormatEnums format = src->GetPixelFormat();
+        if (!m_valid || (format != Spinnaker::PixelFormat_BGR8 && format != Spinnaker::PixelFormat_BGR16) ||
+            dest->GetPixelFormat() != format || dest->GetWidth() != src->GetWidth() ||
+            dest->GetHeight() != src->GetHeight())
+        {
+            return false;
+        }
+
+        const size_t width = src->GetWidth();
+        const size_t height = src->GetHeight();
+        const unsigned char* srcData = static_cast<const unsigned char*>(src->GetData());
+        unsigned char* destData = static_cast<unsigned char*>(dest->GetData());
+        const size_t srcStride = src->GetStride();
+        const size_t destStride = dest->GetStride();
+
+        for (size_t y = 0; y < height; y++)
+        {
+            if (format == Spinnaker::PixelFormat_BGR8)
+            {
+                ApplyBGR8(srcData + y * srcStride, destData + y * destStride, width, useSimd);
+            }
+            else
+            {
+                ApplyBGR16(
+                    reinterpret_cast<const uint16_t*>(srcData + y * srcStride),
+                    reinterpret_cast<uint16_t*>(destData + y * destStride),
+                    width,
+                    useSimd);
+            }
+        }
+
+        return true;
+    }
+
+    // Demosaic an 8-bit Bayer image with bilinear interpolation and color correct it into a
+    // preallocated BGR8 image of the same size, one row at a time
+    bool DemosaicAndApply(const Spinnaker::ImagePtr& src, Spinnaker::ImagePtr& dest) const
+    {
+        int pattern[4];
+        if (!m_valid || !GetBayerPattern(src->GetPixelFormat(), pattern) ||
+            dest->GetPixelFormat() != Spinnaker::PixelFormat_BGR8 || dest->GetWidth() != src->GetWidth() ||
+            dest->GetHeight() != src->GetHeight() || src->GetWidth() < 2 || src->GetHeight() < 2)
+        {
+            return false;
+        }
+
+        const size_t width = src->GetWidth();
+        const size_t height = src->GetHeight();
+        const unsigned char* srcData = static_cast<const unsigned char*>(src->GetData());
+        unsigned char* destData = static_cast<unsigned char*>(dest->GetData());
+        const size_t srcStride = src->GetStride();
+        const size_t destStride = dest->GetStride();
+
+        std::vector<unsigned char> row(width * 3);
+
+        for (size_t y = 0; y < height; y++)
+        {
+            const unsigned char* above = srcData + Reflect(static_cast<ptrdiff_t>(y) - 1, height) * srcStride;
+            const unsigned char* current = srcData + y * srcStride;
+            const unsigned char* below = srcData + Reflect(static_cast<ptrdiff_t>(y) + 1, height) * srcStride;
+
+            for (size_t x = 0; x < width; x++)
+            {
+                const size_t left = Reflect(static_cast<ptrdiff_t>(x) - 1, width);
+                const size_t right = Reflect(static_cast<ptrdiff_t>(x) + 1, width);
+                const int color = pattern[(y & 1) * 2 + (x & 1)];
+                unsigned char* pixel = &row[x * 3];
+
+                // Average of the four direct and the four diagonal neighbours
+                const int cross = (above[x] + below[x] + current[left] + current[right] + 2) >> 2;
+                const int diagonal = (above[left] + above[right] + below[left] + below[right] + 2) >> 2;
+                const int horizontal = (current[left] + current[right] + 1) >> 1;
+                const int vertical = (above[x] + below[x] + 1) >> 1;
+
+                if (color == k_bayerGreen)
+                {
+                    // The row tells which of red and blue lies to the left and right
+                    const int horizontalColor = pattern[(y & 1) * 2 + ((x + 1) & 1)];
+                    pixel[1] = current[x];
+                    pixel[0] = static_cast<unsigned char>(horizontalColor == k_bayerBlue ? horizontal : vertical);
+                    pixel[2] = static_cast<unsigned char>(horizontalColor == k_bayerBlue ? vertical : horizontal);
+                }
+                else
+                {
+                    pixel[1] = static_cast<unsigned char>(cross);
+                    pixel[0] = static_cast<unsigned char>(color == k_bayerBlue ? current[x] : diagonal);
+                    pixel[2] = static_cast<unsigned char>(color == k_bayerBlue ? diagonal : current[x]);
+                }
+            }
+
+            ApplyBGR8(&row[0], destData + y * destStride, width, true);
+        }
+
+        return true;
+    }
+
+    // Color correct numPixels interleaved BGR8 pixels
+    void ApplyBGR8(const unsigned char* src, unsigned char* dest, size_t numPixels, bool useSimd) const
+    {
+        size_t i = 0;
+
+        if (useSimd)
+        {
+#if defined(CCM_KERNEL_AVX2)
+            i = ApplyBGR8Avx2(src, dest, numPixels);
+#elif defined(CCM_KERNEL_SSE41)
+            i = ApplyBGR8Sse41(src, dest, numPixels);
+#elif defined(CCM_KERNEL_NEON)
+            i = ApplyBGR8Neon(src, dest, numPixels);
+#endif
+        }
+
+        for (; i < numPixels; i++)
+        {
+            const int b = src[i * 3];
+            const int g = src[i * 3 + 1];
+            const int r = src[i * 3 + 2];
+
+            for (int c = 0; c < 3; c++)
+            {
+                const int32_t acc = m_coef[c][0] * b + m_coef[c][1] * g + m_coef[c][2] * r + m_offset8[c];
+                dest[i * 3 + c] = static_cast<unsigned char>(Clamp(acc >> k_ccmFractionBits, 255));
+            }
+        }
+    }
+
+    // Color correct numPixels interleaved BGR16 pixels
+    void ApplyBGR16(const uint16_t* src, uint16_t* dest, size_t numPixels, bool useSimd) const
+    {
+        size_t i = 0;
+
+        if (useSimd)
+        {
+#if defined(CCM_KERNEL_SSE41)
+            i = ApplyBGR16Sse41(src, dest, numPixels);
+#elif defined(CCM_KERNEL_NEON)
+            i = ApplyBGR16Neon(src, dest, numPixels);
+#endif
+        }
+
+        for (; i < numPixels; i++)
+        {
+            // Inputs are biased into the signed 16-bit range, as in the SIMD kernels
+            const int b = static_cast<int>(src[i * 3]) - 32768;
+            const int g = static_cast<int>(src[i * 3 + 1]) - 32768;
+            const int r = static_cast<int>(src[i * 3 + 2]) - 32768;
+
+            for (int c = 0; c < 3; c++)
+            {
+                const int32_t acc = m_coef[c][0] * b + m_coef[c][1] * g + m_coef[c][2] * r + m_offset16[c];
+                dest[i * 3 + c] = static_cast<uint16_t>(Clamp(acc >> k_ccmFractionBits, 65535));
+            }
+        }
+    }
+
+private:
+    static const int k_bayerRed = 0;
+    static const int k_bayerGreen = 1;
+    static const int k_bayerBlue = 2;
+
+    static float Round(float value)
+    {
+        return std::floor(value + 0.5f);
+    }
+
+    static int32_t Clamp(int32_t value, int32_t maximum)
+    {
+        return value < 0 ? 0 : (value > maximum ? maximum : value);
+    }
+
+    // Mirror an index at the image border, keeping its position in the Bayer pattern
+    static size_t Reflect(ptrdiff_t index, size_t size)
+    {
+        if (index < 0)
+        {
+            return static_cast<size_t>(-index);
+        }
+        if (index >= static_cast<ptrdiff_t>(size))
+        {
+            return 2 * size - 2 - static_cast<size_t>(index);
+        }
+        return static_cast<size_t>(index);
+    }
+
+    // Color of the 2x2 Bayer tile in row-major order
+    static bool GetBayerPattern(Spinnaker::PixelFormatEnums format, int pattern[4])
+    {
+        switch (format)
+        {
+        case Spinnaker::PixelFormat_BayerRG8:
+            pattern[0] = k_bayerRed, pattern[1] = k_bayerGreen, pattern[2] = k_bayerGreen, pattern[3] = k_bayerBlue;
+            return true;
+        case Spinnaker::PixelFormat_BayerGR8:
+            pattern[0] = k_bayerGreen, pattern[1] = k_bayerRed, pattern[2] = k_bayerBlue, pattern[3] = k_bayerGreen;
+            return true;
+        case Spinnaker::PixelFormat_BayerGB8:
+            pattern[0] = k_bayerGreen, pattern[1] = k_bayerBlue, pattern[2] = k_bayerRed, pattern[3] = k_bayerGreen;
+            return true;
+        case Spinnaker::PixelFormat_BayerBG8:
+            pattern[0] = k_bayerBlue, pattern[1] = k_bayerGreen, pattern[2] = k_bayerGreen, pattern[3] = k_bayerRed;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Pairs of coefficients laid out for _mm_madd_epi16: (first, second) in every 32-bit lane
+    int32_t GetCoefficientPair(int c, int first, int second) const
+    {
+        const uint16_t low = static_cast<uint16_t>(m_coef[c][first]);
+        const uint16_t high = second < 0 ? 0 : static_cast<uint16_t>(m_coef[c][second]);
+        return static_cast<int32_t>((static_cast<uint32_t>(high) << 16) | low);
+    }
+
+#if defined(CCM_KERNEL_SSE41)
+    // 4 pixels per iteration; the 16-byte load reads up to 4 bytes past the pixels it converts
+    size_t ApplyBGR8Sse41(const unsigned char* src, unsigned char* dest, size_t numPixels) const
+    {
+        const __m128i maskBG = _mm_setr_epi8(0, -1, 1, -1, 3, -1, 4, -1, 6, -1, 7, -1, 9, -1, 10, -1);
+        const __m128i maskR = _mm_setr_epi8(2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1);
+        const __m128i maskOut = _mm_setr_epi8(0, 4, 8, 1, 5, 9, 2, 6, 10, 3, 7, 11, -1, -1, -1, -1);
+
+        __m128i coefBG[3], coefR[3], offset[3];
+        for (int c = 0; c < 3; c++)
+        {
+            coefBG[c] = _mm_set1_epi32(GetCoefficientPair(c, 0, 1));
+            coefR[c] = _mm_set1_epi32(GetCoefficientPair(c, 2, -1));
+            offset[c] = _mm_set1_epi32(m_offset8[c]);
+        }
+
+        size_t i = 0;
+        for (; i + 6 <= numPixels; i += 4)
+        {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+            const __m128i bg = _mm_shuffle_epi8(pixels, maskBG);
+            const __m128i r = _mm_shuffle_epi8(pixels, maskR);
+
+            __m128i acc[3];
+            for (int c = 0; c < 3; c++)
+            {
+                acc[c] = _mm_add_epi32(_mm_madd_epi16(bg, coefBG[c]), _mm_madd_epi16(r, coefR[c]));
+                acc[c] = _mm_srai_epi32(_mm_add_epi32(acc[c], offset[c]), k_ccmFractionBits);
+            }
+
+            // [B0..B3 G0..G3 R0..R3 R0..R3] saturated to 8 bits, then interleaved back to BGR
+            const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(acc[0], acc[1]), _mm_packs_epi32(acc[2], acc[2]));
+            const __m128i out = _mm_shuffle_epi8(packed, maskOut);
+
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + i * 3), out);
+            const int32_t tail = _mm_cvtsi128_si32(_mm_srli_si128(out, 8));
+            memcpy(dest + i * 3 + 8, &tail, sizeof(tail));
+        }
+        return i;
+    }
+
+    // 4 pixels per iteration from two overlapping 16-byte loads
+    size_t ApplyBGR16Sse41(const uint16_t* src, uint16_t* dest, size_t numPixels) const
+    {
+        const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+        const __m128i maskBGLow = _mm_setr_epi8(0, 1, 2, 3, 6, 7, 8, 9, 12, 13, 14, 15, -1, -1, -1, -1);
+        const __m128i maskBGHigh = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 3, 4, 5);
+        const __m128i maskRLow = _mm_setr_epi8(4, 5, -1, -1, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i maskRHigh = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 0, 1, -1, -1, 6, 7, -1, -1);
+        const __m128i maskOutBG0 = _mm_setr_epi8(0, 1, 8, 9, -1, -1, 2, 3, 10, 11, -1, -1, 4, 5, 12, 13);
+        const __m128i maskOutR0 = _mm_setr_epi8(-1, -1, -1, -1, 0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1);
+        const __m128i maskOutBG1 = _mm_setr_epi8(-1, -1, 6, 7, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i maskOutR1 = _mm_setr_epi8(4, 5, -1, -1, -1, -1, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+
+        __m128i coefBG[3], coefR[3], offset[3];
+        for (int c = 0; c < 3; c++)
+        {
+            coefBG[c] = _mm_set1_epi32(GetCoefficientPair(c, 0, 1));
+            coefR[c] = _mm_set1_epi32(GetCoefficientPair(c, 2, -1));
+            offset[c] = _mm_set1_epi32(m_offset16[c]);
+        }
+
+        size_t i = 0;
+        for (; i + 6 <= numPixels; i += 4)
+        {
+            const __m128i low = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3)), bias);
+            const __m128i high =
+                _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3 + 8)), bias);
+            const __m128i bg = _mm_or_si128(_mm_shuffle_epi8(low, maskBGLow), _mm_shuffle_epi8(high, maskBGHigh));
+            const __m128i r = _mm_or_si128(_mm_shuffle_epi8(low, maskRLow), _mm_shuffle_epi8(high, maskRHigh));
+
+            __m128i acc[3];
+            for (int c = 0; c < 3; c++)
+            {
+                acc[c] = _mm_add_epi32(_mm_madd_epi16(bg, coefBG[c]), _mm_madd_epi16(r, coefR[c]));
+                acc[c] = _mm_srai_epi32(_mm_add_epi32(acc[c], offset[c]), k_ccmFractionBits);
+            }
+
+            const __m128i packedBG = _mm_packus_epi32(acc[0], acc[1]);
+            const __m128i packedR = _mm_packus_epi32(acc[2], acc[2]);
+            const __m128i out0 =
+                _mm_or_si128(_mm_shuffle_epi8(packedBG, maskOutBG0), _mm_shuffle_epi8(packedR, maskOutR0));
+            const __m128i out1 =
+                _mm_or_si128(_mm_shuffle_epi8(packedBG, maskOutBG1), _mm_shuffle_epi8(packedR, maskOutR1));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 3), out0);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + i * 3 + 8), out1);
+        }
+        return i;
+    }
+#endif
+
+#if defined(CCM_KERNEL_AVX2)
+    // 8 pixels per iteration, as two groups of 4 pixels in the two 128-bit lanes
+    size_t ApplyBGR8Avx2(const unsigned char* src, unsigned char* dest, size_t numPixels) const
+    {
+        const __m256i maskBG =
+            _mm256_broadcastsi128_si256(_mm_setr_epi8(0, -1, 1, -1, 3, -1, 4, -1, 6, -1, 7, -1, 9, -1, 10, -1));
+        const __m256i maskR =
+            _mm256_broadcastsi128_si256(_mm_setr_epi8(2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1));
+        const __m256i maskOut =
+            _mm256_broadcastsi128_si256(_mm_setr_epi8(0, 4, 8, 1, 5, 9, 2, 6, 10, 3, 7, 11, -1, -1, -1, -1));
+
+        __m256i coefBG[3], coefR[3], offset[3];
+        for (int c = 0; c < 3; c++)
+        {
+            coefBG[c] = _mm256_set1_epi32(GetCoefficientPair(c, 0, 1));
+            coefR[c] = _mm256_set1_epi32(GetCoefficientPair(c, 2, -1));
+            offset[c] = _mm256_set1_epi32(m_offset8[c]);
+        }
+
+        size_t i = 0;
+        for (; i + 10 <= numPixels; i += 8)
+        {
+            const __m256i pixels = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3))),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3 + 12)),
+                1);
+            const __m256i bg = _mm256_shuffle_epi8(pixels, maskBG);
+            const __m256i r = _mm256_shuffle_epi8(pixels, maskR);
+
+            __m256i acc[3];
+            for (int c = 0; c < 3; c++)
+            {
+                acc[c] = _mm256_add_epi32(_mm256_madd_epi16(bg, coefBG[c]), _mm256_madd_epi16(r, coefR[c]));
+                acc[c] = _mm256_srai_epi32(_mm256_add_epi32(acc[c], offset[c]), k_ccmFractionBits);
+            }
+
+            const __m256i packed =
+                _mm256_packus_epi16(_mm256_packs_epi32(acc[0], acc[1]), _mm256_packs_epi32(acc[2], acc[2]));
+            const __m256i out = _mm256_shuffle_epi8(packed, maskOut);
+
+            const __m128i outLow = _mm256_castsi256_si128(out);
+            const __m128i outHigh = _mm256_extracti128_si256(out, 1);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + i * 3), outLow);
+            const int32_t tailLow = _mm_cvtsi128_si32(_mm_srli_si128(outLow, 8));
+            memcpy(dest + i * 3 + 8, &tailLow, sizeof(tailLow));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + i * 3 + 12), outHigh);
+            const int32_t tailHigh = _mm_cvtsi128_si32(_mm_srli_si128(outHigh, 8));
+            memcpy(dest + i * 3 + 20, &tailHigh, sizeof(tailHigh));
+        }
+        return i;
+    }
+#endif
+
+#if defined(CCM_KERNEL_NEON)
+    // 8 pixels per iteration with deinterleaving loads and stores
+    size_t ApplyBGR8Neon(const unsigned char* src, unsigned char* dest, size_t numPixels) const
+    {
+        size_t i = 0;
+        for (; i + 8 <= numPixels; i += 8)
+        {
+            const uint8x8x3_t pixels = vld3_u8(src + i * 3);
+            int16x8_t channel[3];
+            for (int j = 0; j < 3; j++)
+            {
+                channel[j] = vreinterpretq_s16_u16(vmovl_u8(pixels.val[j]));
+            }
+
+            uint8x8x3_t out;
+            for (int c = 0; c < 3; c++)
+            {
+                out.val[c] = vqmovun_s16(Multiply(channel, c, m_offset8[c]));
+            }
+            vst3_u8(dest + i * 3, out);
+        }
+        return i;
+    }
+
+    size_t ApplyBGR16Neon(const uint16_t* src, uint16_t* dest, size_t numPixels) const
+    {
+        const uint16x8_t bias = vdupq_n_u16(0x8000);
+
+        size_t i = 0;
+        for (; i + 8 <= numPixels; i += 8)
+        {
+            const uint16x8x3_t pixels = vld3q_u16(src + i * 3);
+            int16x8_t channel[3];
+            for (int j = 0; j < 3; j++)
+            {
+                channel[j] = vreinterpretq_s16_u16(veorq_u16(pixels.val[j], bias));
+            }
+
+            uint16x8x3_t out;
+            for (int c = 0; c < 3; c++)
+            {
+                int32x4_t low, high;
+                MultiplyWide(channel, c, m_offset16[c], low, high);
+                out.val[c] = vcombine_u16(vqmovun_s32(low), vqmovun_s32(high));
+            }
+            vst3q_u16(dest + i * 3, out);
+        }
+        return i;
+    }
+
+    // One output channel of 8 pixels as 32-bit sums shifted back to integer units
+    void MultiplyWide(const int16x8_t channel[3], int c, int32_t offset, int32x4_t& low, int32x4_t& high) const
+    {
+        low = vdupq_n_s32(offset);
+        high = vdupq_n_s32(offset);
+        for (int j = 0; j < 3; j++)
+        {
+            low = vmlal_n_s16(low, vget_low_s16(channel[j]), m_coef[c][j]);
+            high = vmlal_n_s16(high, vget_high_s16(channel[j]), m_coef[c][j]);
+        }
+        low = vshrq_n_s32(low, k_ccmFractionBits);
+        high = vshrq_n_s32(high, k_ccmFractionBits);
+    }
+
+    int16x8_t Multiply(const int16x8_t channel[3], int c, int32_t offset) const
+    {
+        int32x4_t low, high;
+        MultiplyWide(channel, c, offset, low, high);
+        return vcombine_s16(vqmovn_s32(low), vqmovn_s32(high));
+    }
+#endif
+
+    ColorMatrix m_matrix;
+    bool m_valid;
+    int16_t m_coef[3][3];
+    int32_t m_offset8[3];
+    int32_t m_offset16[3];
+};
+
+#endif // COLOR_CORRECTION_KERNEL_H
@@ -0,0 +1,995 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief ConversionBackend.h converts raw images to Mono8 or BGR8 off the
+*  grab thread, on the GPU through OpenCL where one is available and with
+*  ImageProcessor otherwise.
+*
+*  Submit() copies a raw image into one of a fixed number of slots, so the
+*  camera buffer can be released straight away, and Retrieve() returns the
+*  converted images in the order they were submitted. Slots are grouped into
+*  batches that a worker thread converts while the next batch is filled.
+*
+*  The OpenCL backend is compiled in when CONVERSION_BACKEND_USE_OPENCL is
+*  defined and the project links the OpenCL library. Its slots are pinned
+*  host memory, so every frame of a batch is uploaded and downloaded by DMA
+*  with a single wait per batch. On the GPU, Mono8 and Mono12p images are
+*  unpacked to Mono8, and 8-bit and 12-bit packed Bayer images are demosaiced
+*  with bilinear interpolation to BGR8. With a ColorCorrectionKernel the
+*  color correction is fused into the demosaic; the results are the same as
+*  those of ColorCorrectionKernel::DemosaicAndApply() for 8-bit Bayer input.
+*
+*  Any other image, and every image when no OpenCL device can be used, is
+*  converted with ImageProcessor and the chosen color processing algorithm,
+*  then color corrected on the host. Typical use:
+*
+*      ConversionBackend backend(CONVERSION_BACKEND_AUTO, PixelFormat_BGR8);
+*      backend.SetColorCorrection(pKernel);
+*      backend.Submit(pResultImage, imageCnt);
+*      pResultImage->Release();
+*      ...
+*      ConvertedFrame frame;
+*      if (backend.Retrieve(frame, 1000))
+*      {
+*          frame.pImage->Save(filename);
+*          backend.Release(frame);
+*      }
+*/
+
+#ifndef CONVERSION_BACKEND_H
+#define CONVERSION_BACKEND_H
+
+#include "Spinnaker.h"
+#include "ColorCorrectionKernel.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+#if defined(CONVERSION_BACKEND_USE_OPENCL)
+#define CL_TARGET_OPENCL_VERSION 120
+#if defined(__APPLE__)
+#include <OpenCL/opencl.h>
+#else
+#include <CL/cl.h>
+#endif
+#endif
+
+enum conversionBackendType
+{
+    CONVERSION_BACKEND_AUTO,  // OpenCL if a device can be used, ImageProcessor otherwise
+    CONVERSION_BACKEND_CPU,   // ImageProcessor only
+    CONVERSION_BACKEND_OPENCL // OpenCL, falling back to ImageProcessor only if it cannot be used
+};
+
+// Frames converted together with a single wait for the GPU
+const size_t k_conversionBatchSize = 4;
+
+// Raw images that can be held at once; twice the batch size lets one batch fill while another converts
+const size_t k_conversionNumSlots = 2 * k_conversionBatchSize;
+
+// A converted image; pImage stays valid until the frame is handed back with Release()
+struct ConvertedFrame
+{
+    Spinnaker::ImagePtr pImage;
+    uint64_t tag;        // Value passed to Submit(), e.g. the image index
+    bool converted;      // False if the conversion failed
+    bool colorCorrected; // True if the color correction has been applied
+    bool onGpu;          // True if converted by OpenCL
+    int slot;
+};
+
+// Layout of a raw image that the OpenCL kernels read
+enum rawLayoutType
+{
+    RAW_LAYOUT_8,   // One byte per pixel
+    RAW_LAYOUT_12P, // Two pixels in three bytes, least significant bits first
+    RAW_LAYOUT_UNSUPPORTED
+};
+
+// Returns the layout of a raw format and, for Bayer formats, the colors of its 2x2 tile
+// in row-major order as 0 = red, 1 = green, 2 = blue
+inline rawLayoutType GetRawLayout(Spinnaker::PixelFormatEnums format, bool& bayer, int pattern[4])
+{
+    using namespace Spinnaker;
+
+    bayer = true;
+    switch (format)
+    {
+    case PixelFormat_BayerRG8:
+    case PixelFormat_BayerRG12p:
+        pattern[0] = 0, pattern[1] = 1, pattern[2] = 1, pattern[3] = 2;
+        return format == PixelFormat_BayerRG8 ? RAW_LAYOUT_8 : RAW_LAYOUT_12P;
+    case PixelFormat_BayerGR8:
+    case PixelFormat_BayerGR12p:
+        pattern[0] = 1, pattern[1] = 0, pattern[2] = 2, pattern[3] = 1;
+        return format == PixelFormat_BayerGR8 ? RAW_LAYOUT_8 : RAW_LAYOUT_12P;
+    case PixelFormat_BayerGB8:
+    case PixelFormat_BayerGB12p:
+        pattern[0] = 1, pattern[1] = 2, pattern[2] = 0, pattern[3] = 1;
+        return format == PixelFormat_BayerGB8 ? RAW_LAYOUT_8 : RAW_LAYOUT_12P;
+    case PixelFormat_BayerBG8:
+    case PixelFormat_BayerBG12p:
+        pattern[0] = 2, pattern[1] = 1, pattern[2] = 1, pattern[3] = 0;
+        return format == PixelFormat_BayerBG8 ? RAW_LAYOUT_8 : RAW_LAYOUT_12P;
+    case PixelFormat_Mono8:
+        bayer = false;
+        return RAW_LAYOUT_8;
+    case PixelFormat_Mono12p:
+        bayer = false;
+        return RAW_LAYOUT_12P;
+    default:
+        bayer = false;
+        return RAW_LAYOUT_UNSUPPORTED;
+    }
+}
+
+#if defined(CONVERSION_BACKEND_USE_OPENCL)
+// The demosaic and color correction follow ColorCorrectionKernel exactly, so that both give the same results
+static const char* const k_conversionKernelSource =
+    "int load_pixel(global const uchar* src, int stride, int layout, int x, int y)\n"
+    "{\n"
+    "    global const uchar* row = src + y * stride;\n"
+    "    if (layout == 0)\n"
+    "        return row[x];\n"
+    "    global const uchar* pair = row + (x >> 1) * 3;\n"
+    "    const int value = (x & 1) ? ((pair[1] >> 4) | (pair[2] << 4)) : (pair[0] | ((pair[1] & 0x0F) << 8));\n"
+    "    return value >> 4;\n"
+    "}\n"
+    "\n"
+    "int reflect(int index, int size)\n"
+    "{\n"
+    "    return index < 0 ? -index : (index >= size ? 2 * size - 2 - index : index);\n"
+    "}\n"
+    "\n"
+    "kernel void unpack_mono(global const uchar* src, global uchar* dest, int width, int height, int stride, int layout)\n"
+    "{\n"
+    "    const int x = get_global_id(0);\n"
+    "    const int y = get_global_id(1);\n"
+    "    if (x >= width || y >= height)\n"
+    "        return;\n"
+    "    dest[y * width + x] = (uchar)load_pixel(src, stride, layout, x, y);\n"
+    "}\n"
+    "\n"
+    "kernel void demosaic_bgr(global const uchar* src, global uchar* dest, int width, int height, int stride,\n"
+    "                         int layout, int4 pattern, constant int* ccm, int correct)\n"
+    "{\n"
+    "    const int x = get_global_id(0);\n"
+    "    const int y = get_global_id(1);\n"
+    "    if (x >= width || y >= height)\n"
+    "        return;\n"
+    "\n"
+    "    const int up = reflect(y - 1, height);\n"
+    "    const int down = reflect(y + 1, height);\n"
+    "    const int left = reflect(x - 1, width);\n"
+    "    const int right = reflect(x + 1, width);\n"
+    "    const int tile[4] = {pattern.s0, pattern.s1, pattern.s2, pattern.s3};\n"
+    "    const int color = tile[(y & 1) * 2 + (x & 1)];\n"
+    "\n"
+    "    const int centre = load_pixel(src, stride, layout, x, y);\n"
+    "    const int above = load_pixel(src, stride, layout, x, up);\n"
+    "    const int below = load_pixel(src, stride, layout, x, down);\n"
+    "    const int west = load_pixel(src, stride, layout, left, y);\n"
+    "    const int east = load_pixel(src, stride, layout, right, y);\n"
+    "\n"
+    "    int b, g, r;\n"
+    "    if (color == 1)\n"
+    "    {\n"
+    "        const int horizontal = (west + east + 1) >> 1;\n"
+    "        const int vertical = (above + below + 1) >> 1;\n"
+    "        const int horizontalColor = tile[(y & 1) * 2 + ((x + 1) & 1)];\n"
+    "        g = centre;\n"
+    "        b = horizontalColor == 2 ? horizontal : vertical;\n"
+    "        r = horizontalColor == 2 ? vertical : horizontal;\n"
+    "    }\n"
+    "    else\n"
+    "    {\n"
+    "        const int cross = (above + below + west + east + 2) >> 2;\n"
+    "        const int diagonal = (load_pixel(src, stride, layout, left, up) + load_pixel(src, stride, layout, right, up) +\n"
+    "                              load_pixel(src, stride, layout, left, down) + load_pixel(src, stride, layout, right, down) + 2) >> 2;\n"
+    "        g = cross;\n"
+    "        b = color == 2 ? centre : diagonal;\n"
+    "        r = color == 2 ? diagonal : centre;\n"
+    "    }\n"
+    "\n"
+    "    global uchar* pixel = dest + (y * width + x) * 3;\n"
+    "    if (!correct)\n"
+    "    {\n"
+    "        pixel[0] = (uchar)b;\n"
+    "        pixel[1] = (uchar)g;\n"
+    "        pixel[2] = (uchar)r;\n"
+    "        return;\n"
+    "    }\n"
+    "    for (int c = 0; c < 3; c++)\n"
+    "    {\n"
+    "        const int acc = ccm[c * 3] * b + ccm[c * 3 + 1] * g + ccm[c * 3 + 2] * r + ccm[9 + c];\n"
+    "        pixel[c] = (uchar)clamp(acc >> 12, 0, 255);\n"
+    "    }\n"
+    "}\n";
+#endif
+
+class ConversionBackend
+{
+public:
+    // destFormat is PixelFormat_Mono8 or PixelFormat_BGR8
+    ConversionBackend(
+        conversionBackendType type,
+        Spinnaker::PixelFormatEnums destFormat,
+        size_t batchSize = k_conversionBatchSize,
+        size_t numSlots = k_conversionNumSlots)
+        : m_destFormat(destFormat), m_batchSize(std::max<size_t>(batchSize, 1)),
+          m_slots(std::max<size_t>(numSlots, std::max<size_t>(batchSize, 1))), m_pKernel(nullptr), m_useGpu(false),
+          m_finishing(false), m_workerDone(false), m_numGpu(0), m_numCpu(0), m_numFailed(0), m_numBatches(0), m_batchNs(0),
+          m_submitWaitNs(0)
+    {
+        m_processor.SetColorProcessing(Spinnaker::SPINNAKER_COLOR_PROCESSING_ALGORITHM_HQ_LINEAR);
+
+#if defined(CONVERSION_BACKEND_USE_OPENCL)
+        m_context = nullptr;
+        m_queue = nullptr;
+        m_program = nullptr;
+        m_unpackKernel = nullptr;
+        m_demosaicKernel = nullptr;
+        m_ccmBuffer = nullptr;
+        m_lanes.resize(m_batchSize);
+        if (type != CONVERSION_BACKEND_CPU)
+        {
+            m_useGpu = InitOpenCL();
+        }
+#else
+        if (type == CONVERSION_BACKEND_OPENCL)
+        {
+            m_gpuError = "built without CONVERSION_BACKEND_USE_OPENCL";
+        }
+#endif
+
+        for (size_t i = 0; i < m_slots.size(); i++)
+        {
+            m_freeSlots.push_back(static_cast<int>(i));
+        }
+        m_worker = std::thread(&ConversionBackend::ConvertBatches, this);
+    }
+
+    ~ConversionBackend()
+    {
+        Finish();
+
+#if defined(CONVERSION_BACKEND_USE_OPENCL)
+        for (size_t i = 0; i < m_slots.size(); i++)
+        {
+            ReleasePinned(m_slots[i].rawMem, m_slots[i].rawPinned);
+            ReleasePinned(m_slots[i].outMem, m_slots[i].outPinned);
+        }
+        for (size_t i = 0; i < m_lanes.size(); i++)
+        {
+            ReleaseMem(m_lanes[i].raw);
+            ReleaseMem(m_lanes[i].out);
+        }
+        ReleaseMem(m_ccmBuffer);
+        if (m_demosaicKernel != nullptr)
+        {
+            clReleaseKernel(m_demosaicKernel);
+        }
+        if (m_unpackKernel != nullptr)
+        {
+            clReleaseKernel(m_unpackKernel);
+        }
+        if (m_program != nullptr)
+        {
+            clReleaseProgram(m_program);
+        }
+        if (m_queue != nullptr)
+        {
+            clReleaseCommandQueue(m_queue);
+        }
+        if (m_context != nullptr)
+        {
+            clReleaseContext(m_context);
+        }
+#endif
+    }
+
+    // Color correction applied to BGR8 results; set it before the first Submit()
+    void SetColorCorrection(const ColorCorrectionKernel* pKernel)
+    {
+        m_pKernel = pKernel != nullptr && pKernel->IsValid() ? pKernel : nullptr;
+
+#if defined(CONVERSION_BACKEND_USE_OPENCL)
+        if (m_useGpu && m_pKernel != nullptr)
+        {
+            int16_t coef[3][3];
+            int32_t offset8[3];
+            m_pKernel->GetFixedPoint(coef, offset8);
+
+            cl_int ccm[12];
+            for (int c = 0; c < 3; c++)
+            {
+                for (int i = 0; i < 3; i++)
+                {
+                    ccm[c * 3 + i] = coef[c][i];
+                }
+                ccm[9 + c] = offset8[c];
+            }
+            clEnqueueWriteBuffer(m_queue, m_ccmBuffer, CL_TRUE, 0, sizeof(ccm), ccm, 0, nullptr, nullptr);
+        }
+#endif
+    }
+
+    // Algorithm ImageProcessor uses for the images that are not converted on the GPU
+    void SetColorProcessing(Spinnaker::ColorProcessingAlgorithm algorithm)
+    {
+        m_processor.SetColorProcessing(algorithm);
+    }
+
+    bool IsGpu() const
+    {
+        return m_useGpu;
+    }
+
+    // Name of the backend in use, with the reason if OpenCL could not be used
+    std::string GetName() const
+    {
+        if (m_useGpu)
+        {
+            return "OpenCL (" + m_deviceName + ")";
+        }
+        return m_gpuError.empty() ? "ImageProcessor" : "ImageProcessor (" + m_gpuError + ")";
+    }
+
+    //
+    // Copies a raw image into a free slot for conversion
+    //
+    // *** NOTES ***
+    // The image can be released as soon as this returns. Blocks while every
+    // slot holds an image that is being converted or has not been handed
+    // back with Release(). A batch is handed to the worker once it is full;
+    // call Flush() to hand over a partly filled one. Returns false once
+    // Finish() has been called.
+    //
+    bool Submit(const Spinnaker::ImagePtr& image, uint64_t tag)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_slotFree.wait(lock, [this] { return !m_freeSlots.empty() || m_finishing; });
+        if (m_finishing)
+        {
+            return false;
+        }
+        const int index = m_freeSlots.front();
+        m_freeSlots.pop_front();
+        m_submitWaitNs +=
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        lock.unlock();
+
+        // Nobody else uses the slot until it is queued, so it is filled without the lock
+        Slot& slot = m_slots[index];
+        slot.tag = tag;
+        slot.width = image->GetWidth();
+        slot.height = image->GetHeight();
+        slot.stride = image->GetStride();
+        slot.rawSize = image->GetImageSize();
+        slot.format = image->GetPixelFormat();
+        unsigned char* raw = ReserveRaw(slot, slot.rawSize);
+        if (slot.rawSize > 0)
+        {
+            memcpy(raw, image->GetData(), slot.rawSize);
+        }
+
+        lock.lock();
+        m_filling.push_back(index);
+        if (m_filling.size() >= m_batchSize)
+        {
+            m_batches.push_back(m_filling);
+            m_filling.clear();
+            m_batchReady.notify_one();
+        }
+        return true;
+    }
+
+    // Hands a partly filled batch to the worker
+    void Flush()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_filling.empty())
+        {
+            m_batches.push_back(m_filling);
+            m_filling.clear();
+            m_batchReady.notify_one();
+        }
+    }
+
+    // Waits up to timeoutMs for the next converted image, in submission order; returns false on timeout
+    bool Retrieve(ConvertedFrame& frame, unsigned int timeoutMs)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_frameReady.wait_for(
+                lock, std::chrono::milliseconds(timeoutMs), [this] { return !m_done.empty() || IsDrainedLocked(); }) ||
+            m_done.empty())
+        {
+            return false;
+        }
+
+        frame = m_done.front();
+        m_done.pop_front();
+        return true;
+    }
+
+    // Hands the slot of a retrieved image back for the next raw image
+    void Release(ConvertedFrame& frame)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (frame.slot >= 0)
+        {
+            m_freeSlots.push_back(frame.slot);
+            m_slotFree.notify_one();
+        }
+        frame.pImage = Spinnaker::ImagePtr();
+        frame.slot = -1;
+    }
+
+    // Converts what was submitted and stops the worker; the converted images can still be retrieved
+    void Finish()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_finishing)
+            {
+                return;
+            }
+            if (!m_filling.empty())
+            {
+                m_batches.push_back(m_filling);
+                m_filling.clear();
+            }
+            m_finishing = true;
+            m_batchReady.notify_all();
+            m_slotFree.notify_all();
+        }
+
+        if (m_worker.joinable())
+        {
+            m_worker.join();
+        }
+    }
+
+    // True once Finish() has been called and every converted image has been retrieved
+    bool IsDrained()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return IsDrainedLocked();
+    }
+
+    void PrintStatistics()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::cout << "Conversion backend: " << GetName() << std::endl;
+        std::cout << "  " << m_numGpu << " images converted by OpenCL, " << m_numCpu << " by ImageProcessor, "
+                  << m_numFailed << " failed" << std::endl;
+        if (m_numBatches > 0)
+        {
+            std::cout << "  " << m_numBatches << " batches, mean " << m_batchNs / m_numBatches / 1000
+                      << " us per batch of up to " << m_batchSize << " images" << std::endl;
+        }
+        std::cout << "  Time waiting for a free slot: " << m_submitWaitNs / 1000000 << " ms" << std::endl;
+    }
+
+private:
+    ConversionBackend(const ConversionBackend&);
+    ConversionBackend& operator=(const ConversionBackend&);
+
+    struct Slot
+    {
+        Slot()
+            : tag(0), width(0), height(0), stride(0), rawSize(0), format(Spinnaker::UNKNOWN_PIXELFORMAT)
+#if defined(CONVERSION_BACKEND_USE_OPENCL)
+              ,
+              rawMem(nullptr), outMem(nullptr), rawPinned(nullptr), outPinned(nullptr), rawCapacity(0), outCapacity(0)
+#endif
+        {
+        }
+
+        uint64_t tag;
+        size_t width;
+        size_t height;
+        size_t stride;
+        size_t rawSize;
+        Spinnaker::PixelFormatEnums format;
+
+        // Host memory, used when the slot is not pinned
+        std::vector<unsigned char> raw;
+        std::vector<unsigned char> out;
+        std::vector<unsigned char> converted;
+
+#if defined(CONVERSION_BACKEND_USE_OPENCL)
+        // Pinned host memory, mapped for as long as the backend lives
+        cl_mem rawMem;
+        cl_mem outMem;
+        unsigned char* rawPinned;
+        unsigned char* outPinned;
+        size_t rawCapacity;
+        size_t outCapacity;
+#endif
+    };
+
+    // Called with m_mutex held
+    bool IsDrainedLocked() const
+    {
+        return m_workerDone && m_done.empty();
+    }
+
+    size_t GetOutputSize(const Slot& slot) const
+    {
+        return slot.width * slot.height * (m_destFormat == Spinnaker::PixelFormat_BGR8 ? 3 : 1);
+    }
+
+    unsigned char* ReserveRaw(Slot& slot, size_t size)
+    {
+#if defined(CONVERSION_BACKEND_USE_OPENCL)
+        if (m_useGpu && ReservePinned(slot.rawMem, slot.rawPinned, slot.rawCapacity, size))
+        {
+            return slot.rawPinned;
+        }
+#endif
+        if (slot.raw.size() < size)
+        {
+            slot.raw.resize(size);
+        }
+        return slot.raw.empty() ? nullptr : &slot.raw[0];
+    }
+
+    // The raw data copied in by Submit()
+    static unsigned char* GetRaw(Slot& slot)
+    {
+#if defined(CONVERSION_BACKEND_USE_OPENCL)
+        if (slot.rawPinned != nullptr)
+        {
+            return slot.rawPinned;
+        }
+#endif
+        return slot.raw.empty() ? nullptr : &slot.raw[0];
+    }
+
+    // Worker thread; converts one batch after another
+    void ConvertBatches()
+    {
+        for (;;)
+        {
+            std::vector<int> batch;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_batchReady.wait(lock, [this] { return !m_batches.empty() || m_finishing; });
+                if (m_batches.empty())
+                {
+                    m_workerDone = true;
+                    m_frameReady.notify_all();
+                    return;
+                }
+                batch = m_batches.front();
+                m_batches.pop_front();
+            }
+
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            std::vector<ConvertedFrame> frames(batch.size());
+            std::vector<bool> onGpu(batch.size(), false);
+
+#if defined(CONVERSION_BACKEND_USE_OPENCL)
+            if (m_useGpu)
+            {
+                try
+                {
+                    ConvertBatchOpenCL(batch, frames, onGpu);
+                }
+                catch (std::exception& e)
+                {
+                    // Nothing of the batch is trusted; it is converted again on the host below
+                    std::cout << "OpenCL conversion error, converting the batch on the host: " << e.what() << std::endl;
+                    clFinish(m_queue);
+                    onGpu.assign(batch.size(), false);
+                }
+            }
+#endif
+            for (size_t i = 0; i < batch.size(); i++)
+            {
+                if (!onGpu[i])
+                {
+                    ConvertOnHost(batch[i], frames[i]);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_numBatches++;
+            m_batchNs +=
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            for (size_t i = 0; i < frames.size(); i++)
+            {
+                if (!frames[i].converted)
+                {
+                    m_numFailed++;
+                }
+                else if (frames[i].onGpu)
+                {
+                    m_numGpu++;
+                }
+                else
+                {
+                    m_numCpu++;
+                }
+                m_done.push_back(frames[i]);
+            }
+            m_frameReady.notify_all();
+        }
+    }
+
+    // Converts one image with ImageProcessor and color corrects it on the host
+    void ConvertOnHost(int index, ConvertedFrame& frame)
+    {
+        Slot& slot = m_slots[index];
+        frame.pImage = Spinnaker::ImagePtr();
+        frame.tag = slot.tag;
+        frame.slot = index;
+        frame.onGpu = false;
+        frame.converted = false;
+        frame.colorCorrected = false;
+
+        try
+        {
+            unsigned char* raw = GetRaw(slot);
+            Spinnaker::ImagePtr pRaw = Spinnaker::Image::Create(slot.width, slot.height, 0, 0, slot.format, raw);
+
+            const size_t outSize = GetOutputSize(slot);
+            if (slot.out.size() < outSize)
+            {
+                slot.out.resize(outSize);
+            }
+            Spinnaker::ImagePtr pOut =
+                Spinnaker::Image::Create(slot.width, slot.height, 0, 0, m_destFormat, slot.out.empty() ? nullptr : &slot.out[0]);
+
+            if (m_pKernel != nullptr && m_destFormat == Spinnaker::PixelFormat_BGR8)
+            {
+                if (slot.converted.size() < outSize)
+                {
+                    slot.converted.resize(outSize);
+                }
+                Spinnaker::ImagePtr pConverted = Spinnaker::Image::Create(
+                    slot.width, slot.height, 0, 0, m_destFormat, slot.converted.empty() ? nullptr : &slot.converted[0]);
+
+                m_processor.Convert(pRaw, pConverted, m_destFormat);
+                frame.colorCorrected = m_pKernel->Apply(pConverted, pOut);
+                if (!frame.colorCorrected)
+                {
+                    memcpy(&slot.out[0], &slot.converted[0], outSize);
+                }
+            }
+            else
+            {
+                m_processor.Convert(pRaw, pOut, m_destFormat);
+            }
+
+            frame.pImage = pOut;
+            frame.converted = true;
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            std::cout << "Conversion error: " << e.what() << std::endl;
+        }
+        catch (std::exception& e)
+        {
+            std::cout << "Conversion error: " << e.what() << std::endl;
+        }
+    }
+
+#if defined(CONVERSION_BACKEND_USE_OPENCL)
+    struct Lane
+    {
+        Lane() : raw(nullptr), out(nullptr), rawCapacity(0), outCapacity(0)
+        {
+        }
+
+        cl_mem raw;
+        cl_mem out;
+        size_t rawCapacity;
+        size_t outCapacity;
+    };
+
+    // Picks the first GPU, or any OpenCL device if there is no GPU, and builds the kernels
+    bool InitOpenCL()
+    {
+        cl_uint numPlatforms = 0;
+        if (clGetPlatformIDs(0, nullptr, &numPlatforms) != CL_SUCCESS || numPlatforms == 0)
+        {
+            m_gpuError = "no OpenCL platform";
+            return false;
+        }
+        std::vector<cl_platform_id> platforms(numPlatforms);
+        clGetPlatformIDs(numPlatforms, &platforms[0], nullptr);
+
+        cl_device_id device = nullptr;
+        const cl_device_type types[] = {CL_DEVICE_TYPE_GPU, CL_DEVICE_TYPE_ALL};
+        for (size_t t = 0; t < 2 && device == nullptr; t++)
+        {
+            for (cl_uint p = 0; p < numPlatforms && device == nullptr; p++)
+            {
+                cl_uint numDevices = 0;
+                if (clGetDeviceIDs(platforms[p], types[t], 1, &device, &numDevices) != CL_SUCCESS || numDevices == 0)
+                {
+                    device = nullptr;
+                }
+            }
+        }
+        if (device == nullptr)
+        {
+            m_gpuError = "no OpenCL device";
+            return false;
+        }
+
+        char name[256] = "";
+        clGetDeviceInfo(device, CL_DEVICE_NAME, sizeof(name) - 1, name, nullptr);
+        m_deviceName = name;
+
+        cl_int status = CL_SUCCESS;
+        m_context = clCreateContext(nullptr, 1, &device, nullptr, nullptr, &status);
+        if (status == CL_SUCCESS)
+        {
+            m_queue = clCreateCommandQueue(m_context, device, 0, &status);
+        }
+        if (status == CL_SUCCESS)
+        {
+            const char* source = k_conversionKernelSource;
+            m_program = clCreateProgramWithSource(m_context, 1, &source, nullptr, &status);
+        }
+        if (status == CL_SUCCESS)
+        {
+            status = clBuildProgram(m_program, 1, &device, nullptr, nullptr, nullptr);
+        }
+        if (status == CL_SUCCESS)
+        {
+            m_unpackKernel = clCreateKernel(m_program, "unpack_mono", &status);
+        }
+        if (status == CL_SUCCESS)
+        {
+            m_demosaicKernel = clCreateKernel(m_program, "demosaic_bgr", &status);
+        }
+        if (status == CL_SUCCESS)
+        {
+            m_ccmBuffer = clCreateBuffer(m_context, CL_MEM_READ_ONLY, 12 * sizeof(cl_int), nullptr, &status);
+        }
+        if (status != CL_SUCCESS)
+        {
+            m_gpuError = "OpenCL setup failed on " + m_deviceName;
+            return false;
+        }
+        return true;
+    }
+
+    // Allocates pinned host memory of at least size bytes and maps it once
+    bool ReservePinned(cl_mem& mem, unsigned char*& pinned, size_t& capacity, size_t size)
+    {
+        if (capacity >= size && pinned != nullptr)
+        {
+            return true;
+        }
+        ReleasePinned(mem, pinned);
+        capacity = 0;
+
+        cl_int status = CL_SUCCESS;
+        mem = clCreateBuffer(m_context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, std::max<size_t>(size, 1), nullptr, &status);
+        if (status != CL_SUCCESS)
+        {
+            mem = nullptr;
+            return false;
+        }
+        pinned = static_cast<unsigned char*>(clEnqueueMapBuffer(
+            m_queue, mem, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, std::max<size_t>(size, 1), 0, nullptr, nullptr, &status));
+        if (status != CL_SUCCESS)
+        {
+            ReleaseMem(mem);
+            pinned = nullptr;
+            return false;
+        }
+        capacity = size;
+        return true;
+    }
+
+    void ReleasePinned(cl_mem& mem, unsigned char*& pinned)
+    {
+        if (mem != nullptr && pinned != nullptr)
+        {
+            clEnqueueUnmapMemObject(m_queue, mem, pinned, 0, nullptr, nullptr);
+            clFinish(m_queue);
+        }
+        pinned = nullptr;
+        ReleaseMem(mem);
+    }
+
+    static void ReleaseMem(cl_mem& mem)
+    {
+        if (mem != nullptr)
+        {
+            clReleaseMemObject(mem);
+            mem = nullptr;
+        }
+    }
+
+    bool ReserveDevice(cl_mem& mem, size_t& capacity, size_t size, cl_mem_flags flags)
+    {
+        if (capacity >= size && mem != nullptr)
+        {
+            return true;
+        }
+        ReleaseMem(mem);
+        capacity = 0;
+
+        cl_int status = CL_SUCCESS;
+        mem = clCreateBuffer(m_context, flags, std::max<size_t>(size, 1), nullptr, &status);
+        if (status != CL_SUCCESS)
+        {
+            mem = nullptr;
+            return false;
+        }
+        capacity = size;
+        return true;
+    }
+
+    //
+    // Uploads, converts and downloads every image of a batch that the kernels support
+    //
+    // *** NOTES ***
+    // The commands of every image are queued without waiting, and the
+    // worker only waits once for the whole batch. Images the kernels do not
+    // support, or that did not fit a pinned slot, are left to the host.
+    //
+    void ConvertBatchOpenCL(const std::vector<int>& batch, std::vector<ConvertedFrame>& frames, std::vector<bool>& onGpu)
+    {
+        bool queued = false;
+
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            Slot& slot = m_slots[batch[i]];
+            bool bayer = false;
+            int pattern[4] = {0, 0, 0, 0};
+            const rawLayoutType layout = GetRawLayout(slot.format, bayer, pattern);
+            const bool supported =
+                layout != RAW_LAYOUT_UNSUPPORTED && (bayer ? m_destFormat == Spinnaker::PixelFormat_BGR8
+                                                           : m_destFormat == Spinnaker::PixelFormat_Mono8);
+            const size_t outSize = GetOutputSize(slot);
+            const size_t rowSize = layout == RAW_LAYOUT_12P ? (slot.width * 3 + 1) / 2 : slot.width;
+            const size_t stride = slot.stride > 0 ? slot.stride : rowSize;
+
+            if (!supported || slot.rawPinned == nullptr || slot.width < 2 || slot.height < 2 ||
+                slot.rawSize < stride * (slot.height - 1) + rowSize ||
+                !ReservePinned(slot.outMem, slot.outPinned, slot.outCapacity, outSize) ||
+                !ReserveDevice(m_lanes[i].raw, m_lanes[i].rawCapacity, slot.rawSize, CL_MEM_READ_ONLY) ||
+                !ReserveDevice(m_lanes[i].out, m_lanes[i].outCapacity, outSize, CL_MEM_WRITE_ONLY))
+            {
+                continue;
+            }
+
+            const cl_int width = static_cast<cl_int>(slot.width);
+            const cl_int height = static_cast<cl_int>(slot.height);
+            const cl_int rawStride = static_cast<cl_int>(stride);
+            const cl_int rawLayout = layout == RAW_LAYOUT_12P ? 1 : 0;
+            const cl_int correct = m_pKernel != nullptr ? 1 : 0;
+
+            cl_kernel kernel = bayer ? m_demosaicKernel : m_unpackKernel;
+            cl_int status = clEnqueueWriteBuffer(
+                m_queue, m_lanes[i].raw, CL_FALSE, 0, slot.rawSize, slot.rawPinned, 0, nullptr, nullptr);
+            status |= clSetKernelArg(kernel, 0, sizeof(cl_mem), &m_lanes[i].raw);
+            status |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &m_lanes[i].out);
+            status |= clSetKernelArg(kernel, 2, sizeof(cl_int), &width);
+            status |= clSetKernelArg(kernel, 3, sizeof(cl_int), &height);
+            status |= clSetKernelArg(kernel, 4, sizeof(cl_int), &rawStride);
+            status |= clSetKernelArg(kernel, 5, sizeof(cl_int), &rawLayout);
+            if (bayer)
+            {
+                cl_int4 tile;
+                tile.s[0] = pattern[0], tile.s[1] = pattern[1], tile.s[2] = pattern[2], tile.s[3] = pattern[3];
+                status |= clSetKernelArg(kernel, 6, sizeof(cl_int4), &tile);
+                status |= clSetKernelArg(kernel, 7, sizeof(cl_mem), &m_ccmBuffer);
+                status |= clSetKernelArg(kernel, 8, sizeof(cl_int), &correct);
+            }
+
+            // Arguments are captured when the kernel is queued, so the next image can set its own
+            const size_t local[2] = {16, 16};
+            const size_t global[2] = {(slot.width + 15) / 16 * 16, (slot.height + 15) / 16 * 16};
+            status |= clEnqueueNDRangeKernel(m_queue, kernel, 2, nullptr, global, local, 0, nullptr, nullptr);
+            status |= clEnqueueReadBuffer(m_queue, m_lanes[i].out, CL_FALSE, 0, outSize, slot.outPinned, 0, nullptr, nullptr);
+            if (status != CL_SUCCESS)
+            {
+                continue;
+            }
+
+            ConvertedFrame& frame = frames[i];
+            frame.tag = slot.tag;
+            frame.slot = batch[i];
+            frame.onGpu = true;
+            frame.converted = true;
+            frame.colorCorrected = bayer && m_pKernel != nullptr;
+            onGpu[i] = true;
+            queued = true;
+        }
+
+        if (queued && clFinish(m_queue) != CL_SUCCESS)
+        {
+            // The results of the batch cannot be trusted; convert it again on the host
+            for (size_t i = 0; i < batch.size(); i++)
+            {
+                onGpu[i] = false;
+            }
+            return;
+        }
+
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            if (onGpu[i])
+            {
+                Slot& slot = m_slots[batch[i]];
+                frames[i].pImage =
+                    Spinnaker::Image::Create(slot.width, slot.height, 0, 0, m_destFormat, slot.outPinned);
+            }
+        }
+    }
+
+    cl_context m_context;
+    cl_command_queue m_queue;
+    cl_program m_program;
+    cl_kernel m_unpackKernel;
+    cl_kernel m_demosaicKernel;
+    cl_mem m_ccmBuffer;
+    std::vector<Lane> m_lanes;
+#endif
+
+    const Spinnaker::PixelFormatEnums m_destFormat;
+    const size_t m_batchSize;
+    std::vector<Slot> m_slots;
+    const ColorCorrectionKernel* m_pKernel;
+    Spinnaker::ImageProcessor m_processor;
+    bool m_useGpu;
+    std::string m_deviceName;
+    std::string m_gpuError;
+
+    std::mutex m_mutex;
+    std::condition_variable m_slotFree;
+    std::condition_variable m_batchReady;
+    std::condition_variable m_frameReady;
+    std::deque<int> m_freeSlots;
+    std::vector<int> m_filling;
+    std::deque<std::vector<int>> m_batches;
+    std::deque<ConvertedFrame> m_done;
+    std::thread m_worker;
+    bool m_finishing;
+    bool m_workerDone;
+
+    unsigned int m_numGpu;
+    unsigned int m_numCpu;
+    unsigned int m_numFailed;
+    unsigned int m_numBatches;
+    int64_t m_batchNs;
+    int64_t m_submitWaitNs;
+};
+
+#endif // CONVERSION_BACKEND_H
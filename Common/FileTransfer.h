@@ -0,0 +1,697 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief FileTransfer.h uploads and downloads camera files, such as user
+*  sets and lens shading calibration files, through the GenICam File Access
+*  nodes.
+*
+*  A FileTransfer looks up the File Access nodes and the enumeration values
+*  it needs once, and allocates a single staging buffer the size of the largest
+*  transfer window the camera accepts. Each chunk then only writes or reads
+*  the FileAccessBuffer register, executes the operation and reads back its
+*  status and result; FileAccessLength is only written again for a shorter
+*  final chunk.
+*
+*  Files can be streamed: UploadStream() reads one window at a time from an
+*  input stream and DownloadStream() writes every chunk to an output stream
+*  as it arrives, so a large file is never held in memory. A CRC-32 of the
+*  bytes is computed on the fly, and Verify() reads the camera file back to
+*  check it against the checksum and size of a completed transfer without
+*  storing it. The reported throughput covers the chunk loop only, not
+*  opening and closing the file.
+*
+*  Every camera has its own file access nodes, so UploadToCameras() and
+*  DownloadFromCameras() run the cameras on a pool of up to
+*  k_maxConcurrentTransfers workers (see WorkerPool.h). Typical use:
+*
+*      FileTransfer transfer(pCam);
+*      FileTransferResult result;
+*      std::ifstream ifs(filename, std::ios::binary);
+*      if (transfer.UploadStream("UserShadingCoeff1", ifs, result))
+*      {
+*          transfer.Verify("UserShadingCoeff1", result);
+*      }
+*/
+
+#ifndef FILE_TRANSFER_H
+#define FILE_TRANSFER_H
+
+#include "Spinnaker.h"
+#include "SpinGenApi/SpinnakerGenApi.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <istream>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Maximum number of cameras transferring at the same time; each worker moves on to the next camera when done
+const unsigned int k_maxConcurrentTransfers = 8;
+
+// Outcome of one transfer
+struct FileTransferResult
+{
+    Spinnaker::GenICam::gcstring serialNumber;
+    bool success;
+    std::string error;
+    int64_t bytesTransferred;
+    int64_t windowLength;
+    unsigned int numChunks;
+    uint32_t checksum;
+    bool verified;
+    double seconds;
+    double bytesPerSecond;
+};
+
+// Lookup table of the CRC-32 (IEEE 802.3) polynomial
+struct Crc32Table
+{
+    Crc32Table()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+            }
+            values[i] = value;
+        }
+    }
+
+    uint32_t values[256];
+};
+
+// CRC-32 of a block, continuing from the CRC of the preceding bytes; start from 0
+inline uint32_t UpdateCrc32(uint32_t crc, const unsigned char* data, size_t length)
+{
+    static const Crc32Table table;
+
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc = table.values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+class FileTransfer
+{
+public:
+    // The camera must be initialized
+    FileTransfer(Spinnaker::CameraPtr pCam) : m_pCam(pCam), m_resolved(false), m_windowLength(0)
+    {
+        try
+        {
+            Resolve();
+        }
+        catch (Spinnaker::Exception&)
+        {
+            m_resolved = false;
+        }
+    }
+
+    // Writes data to the camera file named by fileSelector, replacing what was there
+    bool Upload(const Spinnaker::GenICam::gcstring& fileSelector, const std::vector<unsigned char>& data, FileTransferResult& result)
+    {
+        size_t position = 0;
+        return UploadFrom(
+            fileSelector,
+            data.empty(),
+            [&](unsigned char* destination, int64_t maxLength) -> int64_t {
+                const size_t length = std::min(static_cast<size_t>(maxLength), data.size() - position);
+                if (length > 0)
+                {
+                    memcpy(destination, &data[position], length);
+                }
+                position += length;
+                return static_cast<int64_t>(length);
+            },
+            result);
+    }
+
+    // Writes everything left in the input stream to the camera file, one window at a time
+    bool UploadStream(const Spinnaker::GenICam::gcstring& fileSelector, std::istream& input, FileTransferResult& result)
+    {
+        const bool empty = !input || input.peek() == std::istream::traits_type::eof();
+        return UploadFrom(
+            fileSelector,
+            empty,
+            [&](unsigned char* destination, int64_t maxLength) -> int64_t {
+                input.read(reinterpret_cast<char*>(destination), static_cast<std::streamsize>(maxLength));
+                return input.bad() ? -1 : static_cast<int64_t>(input.gcount());
+            },
+            result);
+    }
+
+    // Reads the camera file named by fileSelector into data
+    bool Download(const Spinnaker::GenICam::gcstring& fileSelector, std::vector<unsigned char>& data, FileTransferResult& result)
+    {
+        data.clear();
+        return DownloadTo(
+            fileSelector,
+            [&](const unsigned char* chunk, int64_t length) {
+                data.insert(data.end(), chunk, chunk + length);
+                return true;
+            },
+            result);
+    }
+
+    // Writes the camera file to the output stream chunk by chunk as it is read
+    bool DownloadStream(const Spinnaker::GenICam::gcstring& fileSelector, std::ostream& output, FileTransferResult& result)
+    {
+        return DownloadTo(
+            fileSelector,
+            [&](const unsigned char* chunk, int64_t length) {
+                output.write(reinterpret_cast<const char*>(chunk), static_cast<std::streamsize>(length));
+                return output.good();
+            },
+            result);
+    }
+
+    // Reads the camera file back and checks it against the checksum and size of a completed transfer.
+    // Sets result.verified, and fails the result if the file on the camera does not match.
+    bool Verify(const Spinnaker::GenICam::gcstring& fileSelector, FileTransferResult& result)
+    {
+        FileTransferResult readBack;
+        DownloadTo(
+            fileSelector, [](const unsigned char*, int64_t) { return true; }, readBack);
+
+        result.verified = readBack.success && readBack.bytesTransferred == result.bytesTransferred &&
+                          readBack.checksum == result.checksum;
+        if (!result.verified)
+        {
+            result.success = false;
+            result.error = readBack.success ? "checksum mismatch on read back" : "read back failed: " + readBack.error;
+        }
+        return result.verified;
+    }
+
+    bool IsResolved() const
+    {
+        return m_resolved;
+    }
+
+    // Number of bytes moved per File Access operation
+    int64_t GetWindowLength() const
+    {
+        return m_windowLength;
+    }
+
+private:
+    // Non-copyable; the staging buffer and node pointers belong to one camera
+    FileTransfer(const FileTransfer&);
+    FileTransfer& operator=(const FileTransfer&);
+
+    // Looks up the File Access nodes and the enumeration values used per chunk
+    void Resolve()
+    {
+        using namespace Spinnaker::GenApi;
+
+        INodeMap& nodeMap = m_pCam->GetNodeMap();
+
+        m_ptrFileSelector = nodeMap.GetNode("FileSelector");
+        m_ptrOperationSelector = nodeMap.GetNode("FileOperationSelector");
+        m_ptrOpenMode = nodeMap.GetNode("FileOpenMode");
+        m_ptrOperationExecute = nodeMap.GetNode("FileOperationExecute");
+        m_ptrOperationStatus = nodeMap.GetNode("FileOperationStatus");
+        m_ptrOperationResult = nodeMap.GetNode("FileOperationResult");
+        m_ptrFileSize = nodeMap.GetNode("FileSize");
+        m_ptrAccessOffset = nodeMap.GetNode("FileAccessOffset");
+        m_ptrAccessLength = nodeMap.GetNode("FileAccessLength");
+        m_ptrAccessBuffer = nodeMap.GetNode("FileAccessBuffer");
+
+        CStringPtr ptrSerialNumber = m_pCam->GetTLDeviceNodeMap().GetNode("DeviceSerialNumber");
+        m_serialNumber = (IsAvailable(ptrSerialNumber) && IsReadable(ptrSerialNumber)) ? ptrSerialNumber->GetValue() : "";
+
+        if (!IsAvailable(m_ptrFileSelector) || !IsAvailable(m_ptrOperationSelector) || !IsAvailable(m_ptrOpenMode) ||
+            !IsAvailable(m_ptrOperationExecute) || !IsAvailable(m_ptrOperationStatus) ||
+            !IsAvailable(m_ptrOperationResult) || !IsAvailable(m_ptrFileSize) || !IsAvailable(m_ptrAccessOffset) ||
+            !IsAvailable(m_ptrAccessLength) || !IsAvailable(m_ptrAccessBuffer))
+        {
+            return;
+        }
+
+        if (!GetEntryValue(m_ptrOperationSelector, "Open", m_openOperation) ||
+            !GetEntryValue(m_ptrOperationSelector, "Close", m_closeOperation) ||
+            !GetEntryValue(m_ptrOperationSelector, "Read", m_readOperation) ||
+            !GetEntryValue(m_ptrOperationSelector, "Write", m_writeOperation) ||
+            !GetEntryValue(m_ptrOperationSelector, "Delete", m_deleteOperation) ||
+            !GetEntryValue(m_ptrOpenMode, "Read", m_readMode) || !GetEntryValue(m_ptrOpenMode, "Write", m_writeMode) ||
+            !GetEntryValue(m_ptrOperationStatus, "Success", m_successStatus))
+        {
+            return;
+        }
+
+        m_resolved = true;
+    }
+
+    static bool GetEntryValue(const Spinnaker::GenApi::CEnumerationPtr& ptrEnumeration, const char* name, int64_t& value)
+    {
+        Spinnaker::GenApi::CEnumEntryPtr ptrEntry = ptrEnumeration->GetEntryByName(name);
+        if (!Spinnaker::GenApi::IsAvailable(ptrEntry) || !Spinnaker::GenApi::IsReadable(ptrEntry))
+        {
+            return false;
+        }
+        value = ptrEntry->GetValue();
+        return true;
+    }
+
+    void BeginResult(FileTransferResult& result) const
+    {
+        result.serialNumber = m_serialNumber;
+        result.success = false;
+        result.error.clear();
+        result.bytesTransferred = 0;
+        result.windowLength = 0;
+        result.numChunks = 0;
+        result.checksum = 0;
+        result.verified = false;
+        result.seconds = 0.0;
+        result.bytesPerSecond = 0.0;
+    }
+
+    static bool Finish(FileTransferResult& result, const std::chrono::steady_clock::time_point& start, bool success)
+    {
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.success = success;
+        return success;
+    }
+
+    // Selects the file and sizes the transfer window; called at the start of every transfer
+    bool SelectFile(const Spinnaker::GenICam::gcstring& fileSelector, FileTransferResult& result)
+    {
+        using namespace Spinnaker::GenApi;
+
+        if (!m_resolved)
+        {
+            result.error = "file access not supported on device";
+            return false;
+        }
+
+        int64_t fileValue = 0;
+        if (!GetEntryValue(m_ptrFileSelector, fileSelector.c_str(), fileValue))
+        {
+            result.error = std::string(fileSelector.c_str()) + " not supported";
+            return false;
+        }
+        m_ptrFileSelector->SetIntValue(fileValue);
+
+        // The window is the largest FileAccessLength that fits the FileAccessBuffer register
+        const int64_t bufferLength = m_ptrAccessBuffer->GetLength();
+        m_windowLength = std::min(bufferLength, m_ptrAccessLength->GetMax());
+        if (m_windowLength <= 0)
+        {
+            result.error = "invalid FileAccessBuffer length";
+            return false;
+        }
+
+        m_buffer.resize(static_cast<size_t>(m_windowLength));
+        result.windowLength = m_windowLength;
+        return true;
+    }
+
+    // Executes a file operation and checks its status
+    bool Execute(int64_t operation, const char* name, FileTransferResult& result)
+    {
+        m_ptrOperationSelector->SetIntValue(operation);
+        return ExecuteSelected(name, result);
+    }
+
+    // Executes the operation already selected; used per chunk so the selector is only written once
+    bool ExecuteSelected(const char* name, FileTransferResult& result)
+    {
+        m_ptrOperationExecute->Execute();
+        if (m_ptrOperationStatus->GetIntValue() != m_successStatus)
+        {
+            result.error = std::string("failed to ") + name + " file";
+            return false;
+        }
+        return true;
+    }
+
+    bool Open(int64_t mode, FileTransferResult& result)
+    {
+        m_ptrOpenMode->SetIntValue(mode);
+        if (Execute(m_openOperation, "open", result))
+        {
+            return true;
+        }
+
+        // The file may not have been closed properly last time; close it and open it again
+        FileTransferResult closeResult;
+        Execute(m_closeOperation, "close", closeResult);
+        m_ptrOpenMode->SetIntValue(mode);
+        return Execute(m_openOperation, "open", result);
+    }
+
+    bool Close(FileTransferResult& result)
+    {
+        try
+        {
+            return Execute(m_closeOperation, "close", result);
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            if (result.error.empty())
+            {
+                result.error = e.what();
+            }
+            return false;
+        }
+    }
+
+    // Upload driven by a source that fills up to maxLength bytes and returns how many it
+    // filled, 0 at the end of the data or -1 on error
+    template <typename Source>
+    bool UploadFrom(
+        const Spinnaker::GenICam::gcstring& fileSelector,
+        bool empty,
+        Source source,
+        FileTransferResult& result)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        BeginResult(result);
+
+        try
+        {
+            if (!SelectFile(fileSelector, result))
+            {
+                return Finish(result, start, false);
+            }
+
+            if (empty)
+            {
+                result.error = "empty file";
+                return Finish(result, start, false);
+            }
+
+            // Delete the file first in case the camera runs out of space
+            if (m_ptrFileSize->GetValue() > 0 && !Execute(m_deleteOperation, "delete", result))
+            {
+                return Finish(result, start, false);
+            }
+
+            if (!Open(m_writeMode, result))
+            {
+                return Finish(result, start, false);
+            }
+
+            const bool written = WriteChunks(source, result);
+            const bool closed = Close(result);
+            return Finish(result, start, written && closed);
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            result.error = e.what();
+            Close(result);
+            return Finish(result, start, false);
+        }
+    }
+
+    // Download driven by a sink that consumes each chunk and returns false on error
+    template <typename Sink>
+    bool DownloadTo(const Spinnaker::GenICam::gcstring& fileSelector, Sink sink, FileTransferResult& result)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        BeginResult(result);
+
+        try
+        {
+            if (!SelectFile(fileSelector, result))
+            {
+                return Finish(result, start, false);
+            }
+
+            const int64_t fileSize = m_ptrFileSize->GetValue();
+            if (fileSize <= 0)
+            {
+                result.error = "no data available to read";
+                return Finish(result, start, false);
+            }
+
+            if (!Open(m_readMode, result))
+            {
+                return Finish(result, start, false);
+            }
+
+            const bool read = ReadChunks(sink, fileSize, result);
+            const bool closed = Close(result);
+            return Finish(result, start, read && closed);
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            result.error = e.what();
+            Close(result);
+            return Finish(result, start, false);
+        }
+    }
+
+    template <typename Source>
+    bool WriteChunks(Source& source, FileTransferResult& result)
+    {
+        m_ptrAccessOffset->SetValue(0);
+        m_ptrAccessLength->SetValue(m_windowLength);
+        m_ptrOperationSelector->SetIntValue(m_writeOperation);
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int64_t accessLength = m_windowLength;
+        int64_t buffered = 0;
+        bool endOfSource = false;
+
+        while (true)
+        {
+            // Fill the window from the source; bytes the camera did not take last time are still at the front
+            while (!endOfSource && buffered < m_windowLength)
+            {
+                const int64_t filled = source(&m_buffer[static_cast<size_t>(buffered)], m_windowLength - buffered);
+                if (filled < 0)
+                {
+                    result.error = "failed to read the source file";
+                    return false;
+                }
+                if (filled == 0)
+                {
+                    endOfSource = true;
+                }
+                else
+                {
+                    result.checksum = UpdateCrc32(result.checksum, &m_buffer[static_cast<size_t>(buffered)], static_cast<size_t>(filled));
+                    buffered += filled;
+                }
+            }
+
+            if (buffered == 0)
+            {
+                break;
+            }
+
+            // The register is written in multiples of 4 bytes; pad the last chunk
+            const int64_t paddedLength = std::min((buffered + 3) / 4 * 4, m_windowLength);
+            if (paddedLength > buffered)
+            {
+                memset(&m_buffer[static_cast<size_t>(buffered)], 255, static_cast<size_t>(paddedLength - buffered));
+            }
+
+            m_ptrAccessBuffer->Set(&m_buffer[0], paddedLength);
+
+            // Only a final chunk is shorter than the window; otherwise padding would be written to the file
+            if (buffered != accessLength)
+            {
+                m_ptrAccessLength->SetValue(buffered);
+                accessLength = buffered;
+            }
+
+            if (!ExecuteSelected("write", result))
+            {
+                return false;
+            }
+
+            const int64_t written = m_ptrOperationResult->GetValue();
+            if (written <= 0 || written > buffered)
+            {
+                result.error = "camera accepted no data";
+                return false;
+            }
+
+            buffered -= written;
+            if (buffered > 0)
+            {
+                memmove(&m_buffer[0], &m_buffer[static_cast<size_t>(written)], static_cast<size_t>(buffered));
+            }
+
+            result.bytesTransferred += written;
+            result.numChunks++;
+        }
+
+        SetThroughput(result, start);
+        return true;
+    }
+
+    template <typename Sink>
+    bool ReadChunks(Sink& sink, int64_t fileSize, FileTransferResult& result)
+    {
+        m_ptrAccessOffset->SetValue(0);
+        m_ptrAccessLength->SetValue(m_windowLength);
+        m_ptrOperationSelector->SetIntValue(m_readOperation);
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        while (result.bytesTransferred < fileSize)
+        {
+            if (!ExecuteSelected("read", result))
+            {
+                return false;
+            }
+
+            const int64_t read = std::min(m_ptrOperationResult->GetValue(), fileSize - result.bytesTransferred);
+            if (read <= 0)
+            {
+                break;
+            }
+
+            m_ptrAccessBuffer->Get(&m_buffer[0], read);
+            result.checksum = UpdateCrc32(result.checksum, &m_buffer[0], static_cast<size_t>(read));
+
+            if (!sink(&m_buffer[0], read))
+            {
+                result.error = "failed to write the destination file";
+                return false;
+            }
+
+            result.bytesTransferred += read;
+            result.numChunks++;
+        }
+
+        SetThroughput(result, start);
+
+        if (result.bytesTransferred < fileSize)
+        {
+            result.error = "file ended early";
+            return false;
+        }
+        return true;
+    }
+
+    // Sustained rate of the chunk loop, leaving out opening, deleting and closing the file
+    static void SetThroughput(FileTransferResult& result, const std::chrono::steady_clock::time_point& start)
+    {
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.bytesPerSecond = seconds > 0.0 ? result.bytesTransferred / seconds : 0.0;
+    }
+
+    Spinnaker::CameraPtr m_pCam;
+    Spinnaker::GenICam::gcstring m_serialNumber;
+    bool m_resolved;
+
+    Spinnaker::GenApi::CEnumerationPtr m_ptrFileSelector;
+    Spinnaker::GenApi::CEnumerationPtr m_ptrOperationSelector;
+    Spinnaker::GenApi::CEnumerationPtr m_ptrOpenMode;
+    Spinnaker::GenApi::CCommandPtr m_ptrOperationExecute;
+    Spinnaker::GenApi::CEnumerationPtr m_ptrOperationStatus;
+    Spinnaker::GenApi::CIntegerPtr m_ptrOperationResult;
+    Spinnaker::GenApi::CIntegerPtr m_ptrFileSize;
+    Spinnaker::GenApi::CIntegerPtr m_ptrAccessOffset;
+    Spinnaker::GenApi::CIntegerPtr m_ptrAccessLength;
+    Spinnaker::GenApi::CRegisterPtr m_ptrAccessBuffer;
+
+    int64_t m_openOperation;
+    int64_t m_closeOperation;
+    int64_t m_readOperation;
+    int64_t m_writeOperation;
+    int64_t m_deleteOperation;
+    int64_t m_readMode;
+    int64_t m_writeMode;
+    int64_t m_successStatus;
+
+    int64_t m_windowLength;
+    std::vector<unsigned char> m_buffer;
+};
+
+// Uploads the same data to the same file of every camera, and optionally reads each file back to
+// verify its checksum; the cameras must be initialized
+inline bool UploadToCameras(
+    const std::vector<Spinnaker::CameraPtr>& cameras,
+    const Spinnaker::GenICam::gcstring& fileSelector,
+    const std::vector<unsigned char>& data,
+    std::vector<FileTransferResult>& results,
+    bool verify = false)
+{
+    results.assign(cameras.size(), FileTransferResult());
+
+    RunOnWorkerPool(cameras.size(), k_maxConcurrentTransfers, [&](size_t i) {
+        FileTransfer transfer(cameras[i]);
+        if (transfer.Upload(fileSelector, data, results[i]) && verify)
+        {
+            transfer.Verify(fileSelector, results[i]);
+        }
+    });
+
+    bool success = true;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        success = success && results[i].success;
+    }
+    return success;
+}
+
+// Downloads the same file from every camera; the cameras must be initialized
+inline bool DownloadFromCameras(
+    const std::vector<Spinnaker::CameraPtr>& cameras,
+    const Spinnaker::GenICam::gcstring& fileSelector,
+    std::vector<std::vector<unsigned char>>& data,
+    std::vector<FileTransferResult>& results)
+{
+    data.assign(cameras.size(), std::vector<unsigned char>());
+    results.assign(cameras.size(), FileTransferResult());
+
+    RunOnWorkerPool(cameras.size(), k_maxConcurrentTransfers, [&](size_t i) {
+        FileTransfer transfer(cameras[i]);
+        transfer.Download(fileSelector, data[i], results[i]);
+    });
+
+    bool success = true;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        success = success && results[i].success;
+    }
+    return success;
+}
+
+inline void PrintFileTransferResult(const FileTransferResult& result)
+{
+    std::cout << "Camera " << result.serialNumber << ": ";
+    if (result.success)
+    {
+        std::cout << result.bytesTransferred << " bytes in " << result.numChunks << " chunks of up to "
+                  << result.windowLength << " bytes, " << static_cast<int64_t>(result.seconds * 1000.0) << " ms, "
+                  << static_cast<int64_t>(result.bytesPerSecond / 1024.0) << " KB/s sustained, CRC-32 " << std::hex
+                  << result.checksum << std::dec << (result.verified ? " (verified)" : "");
+    }
+    else
+    {
+        std::cout << "failed after " << result.bytesTransferred << " bytes: " << result.error;
+    }
+    std::cout << std::endl;
+}
+
+#endif // FILE_TRANSFER_H
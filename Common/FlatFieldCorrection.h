@@ -0,0 +1,750 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief FlatFieldCorrection.h corrects lens shading and pixel response
+*  non-uniformity of Mono8 and Mono16 images on the host, for cameras that
+*  cannot do it themselves.
+*
+*  FlatFieldCalibrator averages a number of frames of a uniformly lit target,
+*  and optionally of the capped lens, into a FlatFieldMap: one 4.12
+*  fixed-point gain per pixel that scales it to the mean response, and a dark
+*  level that is subtracted first. The map takes two bytes per pixel (four
+*  with a dark frame) and can be saved to and loaded from disk.
+*
+*  FlatFieldCorrection applies the map as out = (in - dark) * gain, with
+*  SSE4.1/AVX2 on x86 and NEON on ARM, falling back to a scalar loop that
+*  produces bit-identical results elsewhere. The rows of each image are split
+*  between a pool of worker threads that is started once, so no threads are
+*  created per frame. Typical use:
+*
+*      FlatFieldCalibrator calibrator;
+*      calibrator.AddFlatFrame(pImage);  // N times
+*      FlatFieldMap map;
+*      calibrator.Build(map);
+*
+*      FlatFieldCorrection flatField(map, 4);
+*      flatField.Apply(pImage, pCorrectedImage);
+*/
+
+#ifndef FLAT_FIELD_CORRECTION_H
+#define FLAT_FIELD_CORRECTION_H
+
+#include "Spinnaker.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#define FLAT_FIELD_AVX2 1
+#endif
+
+// MSVC does not define __SSE4_1__, and x64 alone only guarantees SSE2, so SSE4.1 is
+// used there only when building with /arch:AVX or /arch:AVX2
+#if defined(__AVX2__) || defined(__SSE4_1__) || (defined(_MSC_VER) && defined(__AVX__))
+#define FLAT_FIELD_SSE41 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define FLAT_FIELD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Number of fractional bits of the fixed-point gains; gains up to 16 can be represented
+const int k_flatFieldGainBits = 12;
+
+// Gain given to pixels that do not respond above the dark level, so that they are left as they are
+const uint16_t k_flatFieldUnityGain = 1 << k_flatFieldGainBits;
+
+// Identifies a saved map, followed by the version of its layout
+const char k_flatFieldFileMagic[4] = {'F', 'F', 'C', 'M'};
+const uint32_t k_flatFieldFileVersion = 1;
+
+// Gain and dark level of every pixel of one image size and bit depth
+struct FlatFieldMap
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t bitsPerPixel;
+    std::vector<uint16_t> gain;
+    std::vector<uint16_t> dark;
+
+    FlatFieldMap() : width(0), height(0), bitsPerPixel(0)
+    {
+    }
+
+    bool IsValid() const
+    {
+        return width > 0 && height > 0 && gain.size() == static_cast<size_t>(width) * height &&
+               (dark.empty() || dark.size() == gain.size());
+    }
+
+    bool HasDark() const
+    {
+        return !dark.empty();
+    }
+
+    // True if the map was built for images of this size and format
+    bool Matches(const Spinnaker::ImagePtr& image) const
+    {
+        return IsValid() && image->GetWidth() == width && image->GetHeight() == height &&
+               image->GetBitsPerPixel() == bitsPerPixel;
+    }
+
+    bool Save(const std::string& fileName) const
+    {
+        std::ofstream file(fileName.c_str(), std::ios::binary);
+        if (!IsValid() || !file)
+        {
+            return false;
+        }
+
+        const uint32_t hasDark = HasDark() ? 1 : 0;
+        file.write(k_flatFieldFileMagic, sizeof(k_flatFieldFileMagic));
+        file.write(reinterpret_cast<const char*>(&k_flatFieldFileVersion), sizeof(k_flatFieldFileVersion));
+        file.write(reinterpret_cast<const char*>(&width), sizeof(width));
+        file.write(reinterpret_cast<const char*>(&height), sizeof(height));
+        file.write(reinterpret_cast<const char*>(&bitsPerPixel), sizeof(bitsPerPixel));
+        file.write(reinterpret_cast<const char*>(&hasDark), sizeof(hasDark));
+        file.write(reinterpret_cast<const char*>(&gain[0]), gain.size() * sizeof(uint16_t));
+        if (hasDark)
+        {
+            file.write(reinterpret_cast<const char*>(&dark[0]), dark.size() * sizeof(uint16_t));
+        }
+        return file.good();
+    }
+
+    bool Load(const std::string& fileName)
+    {
+        std::ifstream file(fileName.c_str(), std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+
+        char magic[sizeof(k_flatFieldFileMagic)];
+        uint32_t version = 0;
+        uint32_t hasDark = 0;
+        file.read(magic, sizeof(magic));
+        file.read(reinterpret_cast<char*>(&version), sizeof(version));
+        file.read(reinterpret_cast<char*>(&width), sizeof(width));
+        file.read(reinterpret_cast<char*>(&height), sizeof(height));
+        file.read(reinterpret_cast<char*>(&bitsPerPixel), sizeof(bitsPerPixel));
+        file.read(reinterpret_cast<char*>(&hasDark), sizeof(hasDark));
+        if (!file || memcmp(magic, k_flatFieldFileMagic, sizeof(magic)) != 0 || version != k_flatFieldFileVersion ||
+            (bitsPerPixel != 8 && bitsPerPixel != 16) || width == 0 || height == 0)
+        {
+            *this = FlatFieldMap();
+            return false;
+        }
+
+        gain.resize(static_cast<size_t>(width) * height);
+        file.read(reinterpret_cast<char*>(&gain[0]), gain.size() * sizeof(uint16_t));
+        dark.clear();
+        if (hasDark)
+        {
+            dark.resize(gain.size());
+            file.read(reinterpret_cast<char*>(&dark[0]), dark.size() * sizeof(uint16_t));
+        }
+
+        if (!file)
+        {
+            *this = FlatFieldMap();
+            return false;
+        }
+        return true;
+    }
+};
+
+// Accumulates flat and dark frames and turns them into a FlatFieldMap
+class FlatFieldCalibrator
+{
+public:
+    FlatFieldCalibrator() : m_width(0), m_height(0), m_bitsPerPixel(0), m_numFlatFrames(0), m_numDarkFrames(0)
+    {
+    }
+
+    // Frames of a uniformly lit target, slightly defocused so that its texture averages out
+    bool AddFlatFrame(const Spinnaker::ImagePtr& image)
+    {
+        return Accumulate(image, m_flatSum, m_numFlatFrames);
+    }
+
+    // Frames taken with the lens capped, at the exposure used for the flat frames
+    bool AddDarkFrame(const Spinnaker::ImagePtr& image)
+    {
+        return Accumulate(image, m_darkSum, m_numDarkFrames);
+    }
+
+    unsigned int GetNumFlatFrames() const
+    {
+        return m_numFlatFrames;
+    }
+
+    unsigned int GetNumDarkFrames() const
+    {
+        return m_numDarkFrames;
+    }
+
+    // Averages the frames added so far into a map; returns false if there are no flat frames
+    // or the flat frames are no brighter than the dark frames
+    bool Build(FlatFieldMap& map) const
+    {
+        if (m_numFlatFrames == 0)
+        {
+            return false;
+        }
+
+        const size_t numPixels = m_flatSum.size();
+        std::vector<uint32_t> response(numPixels);
+        std::vector<uint16_t> dark;
+        if (m_numDarkFrames > 0)
+        {
+            dark.resize(numPixels);
+        }
+
+        // Mean response above the dark level, in 1/256 of a digital number to keep the rounding out of the gains
+        uint64_t totalResponse = 0;
+        for (size_t i = 0; i < numPixels; i++)
+        {
+            const uint64_t flat = (static_cast<uint64_t>(m_flatSum[i]) * 256 + m_numFlatFrames / 2) / m_numFlatFrames;
+            uint64_t darkLevel = 0;
+            if (m_numDarkFrames > 0)
+            {
+                dark[i] = static_cast<uint16_t>((m_darkSum[i] + m_numDarkFrames / 2) / m_numDarkFrames);
+                darkLevel = static_cast<uint64_t>(m_darkSum[i]) * 256 / m_numDarkFrames;
+            }
+
+            response[i] = static_cast<uint32_t>(flat > darkLevel ? flat - darkLevel : 0);
+            totalResponse += response[i];
+        }
+
+        const uint64_t meanResponse = totalResponse / numPixels;
+        if (meanResponse == 0)
+        {
+            return false;
+        }
+
+        map.width = m_width;
+        map.height = m_height;
+        map.bitsPerPixel = m_bitsPerPixel;
+        map.gain.resize(numPixels);
+        map.dark.swap(dark);
+
+        const uint64_t maxGain = 0xFFFF;
+        for (size_t i = 0; i < numPixels; i++)
+        {
+            if (response[i] == 0)
+            {
+                map.gain[i] = k_flatFieldUnityGain;
+                continue;
+            }
+
+            const uint64_t gain = ((meanResponse << k_flatFieldGainBits) + response[i] / 2) / response[i];
+            map.gain[i] = static_cast<uint16_t>(std::min(gain, maxGain));
+        }
+
+        return true;
+    }
+
+private:
+    // Frames of up to 16 bits can be summed 65536 times before the 32-bit sums overflow
+    static const unsigned int k_maxFrames = 65536;
+
+    bool Accumulate(const Spinnaker::ImagePtr& image, std::vector<uint32_t>& sum, unsigned int& numFrames)
+    {
+        const Spinnaker::PixelFormatEnums format = image->GetPixelFormat();
+        if ((format != Spinnaker::PixelFormat_Mono8 && format != Spinnaker::PixelFormat_Mono16) ||
+            image->IsIncomplete() || numFrames >= k_maxFrames)
+        {
+            return false;
+        }
+
+        const uint32_t width = static_cast<uint32_t>(image->GetWidth());
+        const uint32_t height = static_cast<uint32_t>(image->GetHeight());
+        const uint32_t bitsPerPixel = format == Spinnaker::PixelFormat_Mono8 ? 8 : 16;
+
+        // The first frame fixes the size and format of the map
+        if (m_numFlatFrames == 0 && m_numDarkFrames == 0)
+        {
+            m_width = width;
+            m_height = height;
+            m_bitsPerPixel = bitsPerPixel;
+        }
+        else if (width != m_width || height != m_height || bitsPerPixel != m_bitsPerPixel)
+        {
+            return false;
+        }
+
+        sum.resize(static_cast<size_t>(width) * height, 0);
+
+        const unsigned char* data = static_cast<const unsigned char*>(image->GetData());
+        const size_t stride = image->GetStride();
+        for (size_t y = 0; y < height; y++)
+        {
+            uint32_t* sumRow = &sum[y * width];
+            if (bitsPerPixel == 8)
+            {
+                const unsigned char* row = data + y * stride;
+                for (size_t x = 0; x < width; x++)
+                {
+                    sumRow[x] += row[x];
+                }
+            }
+            else
+            {
+                const uint16_t* row = reinterpret_cast<const uint16_t*>(data + y * stride);
+                for (size_t x = 0; x < width; x++)
+                {
+                    sumRow[x] += row[x];
+                }
+            }
+        }
+
+        numFrames++;
+        return true;
+    }
+
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_bitsPerPixel;
+    std::vector<uint32_t> m_flatSum;
+    std::vector<uint32_t> m_darkSum;
+    unsigned int m_numFlatFrames;
+    unsigned int m_numDarkFrames;
+};
+
+class FlatFieldCorrection
+{
+public:
+    // The map is copied; numThreads includes the thread that calls Apply()
+    FlatFieldCorrection(const FlatFieldMap& map, unsigned int numThreads)
+        : m_map(map), m_numThreads(std::max(numThreads, 1u)), m_generation(0), m_numPending(0), m_useSimd(true),
+          m_stopping(false)
+    {
+        m_job.srcData = nullptr;
+        m_job.destData = nullptr;
+        m_job.srcStride = 0;
+        m_job.destStride = 0;
+
+        for (unsigned int i = 1; i < m_numThreads; i++)
+        {
+            m_workers.push_back(std::thread(&FlatFieldCorrection::Run, this, i));
+        }
+    }
+
+    ~FlatFieldCorrection()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_start.notify_all();
+
+        for (size_t i = 0; i < m_workers.size(); i++)
+        {
+            m_workers[i].join();
+        }
+    }
+
+    const FlatFieldMap& GetMap() const
+    {
+        return m_map;
+    }
+
+    // Name of the instruction set the kernels were compiled for
+    static const char* GetInstructionSet()
+    {
+#if defined(FLAT_FIELD_AVX2)
+        return "AVX2";
+#elif defined(FLAT_FIELD_SSE41)
+        return "SSE4.1";
+#elif defined(FLAT_FIELD_NEON)
+        return "NEON";
+#else
+        return "scalar";
+#endif
+    }
+
+    // Corrects src into a preallocated image of the same size and format; src and dest may be the same image.
+    // With useSimd set to false the scalar kernel is used, for comparison.
+    bool Apply(const Spinnaker::ImagePtr& src, Spinnaker::ImagePtr& dest, bool useSimd = true)
+    {
+        if (!m_map.Matches(src) || dest->GetPixelFormat() != src->GetPixelFormat() ||
+            dest->GetWidth() != src->GetWidth() || dest->GetHeight() != src->GetHeight())
+        {
+            return false;
+        }
+
+        // Apply() is called from one thread at a time; the lock only hands the job to the workers
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_job.srcData = static_cast<const unsigned char*>(src->GetData());
+        m_job.destData = static_cast<unsigned char*>(dest->GetData());
+        m_job.srcStride = src->GetStride();
+        m_job.destStride = dest->GetStride();
+        m_useSimd = useSimd;
+        m_numPending = m_numThreads - 1;
+        m_generation++;
+        lock.unlock();
+        m_start.notify_all();
+
+        ApplyBand(0);
+
+        lock.lock();
+        m_done.wait(lock, [this] { return m_numPending == 0; });
+        return true;
+    }
+
+    // Corrects numPixels 8-bit pixels starting at pixel index of the map
+    void ApplyMono8(const unsigned char* src, unsigned char* dest, size_t index, size_t numPixels, bool useSimd) const
+    {
+        const uint16_t* gain = &m_map.gain[index];
+        const uint16_t* dark = m_map.HasDark() ? &m_map.dark[index] : nullptr;
+        size_t i = 0;
+
+        if (useSimd)
+        {
+#if defined(FLAT_FIELD_AVX2)
+            i = ApplyMono8Avx2(src, dest, gain, dark, numPixels);
+#elif defined(FLAT_FIELD_SSE41)
+            i = ApplyMono8Sse41(src, dest, gain, dark, numPixels);
+#elif defined(FLAT_FIELD_NEON)
+            i = ApplyMono8Neon(src, dest, gain, dark, numPixels);
+#endif
+        }
+
+        for (; i < numPixels; i++)
+        {
+            const uint32_t level = dark ? static_cast<uint32_t>(std::max<int>(src[i] - dark[i], 0)) : src[i];
+            dest[i] = static_cast<unsigned char>(std::min<uint32_t>(Scale(level, gain[i]), 255));
+        }
+    }
+
+    // Corrects numPixels 16-bit pixels starting at pixel index of the map
+    void ApplyMono16(const uint16_t* src, uint16_t* dest, size_t index, size_t numPixels, bool useSimd) const
+    {
+        const uint16_t* gain = &m_map.gain[index];
+        const uint16_t* dark = m_map.HasDark() ? &m_map.dark[index] : nullptr;
+        size_t i = 0;
+
+        if (useSimd)
+        {
+#if defined(FLAT_FIELD_AVX2)
+            i = ApplyMono16Avx2(src, dest, gain, dark, numPixels);
+#elif defined(FLAT_FIELD_SSE41)
+            i = ApplyMono16Sse41(src, dest, gain, dark, numPixels);
+#elif defined(FLAT_FIELD_NEON)
+            i = ApplyMono16Neon(src, dest, gain, dark, numPixels);
+#endif
+        }
+
+        for (; i < numPixels; i++)
+        {
+            const uint32_t level = dark ? static_cast<uint32_t>(std::max<int>(src[i] - dark[i], 0)) : src[i];
+            dest[i] = static_cast<uint16_t>(std::min<uint32_t>(Scale(level, gain[i]), 65535));
+        }
+    }
+
+private:
+    // Non-copyable; the correction owns its worker threads
+    FlatFieldCorrection(const FlatFieldCorrection&);
+    FlatFieldCorrection& operator=(const FlatFieldCorrection&);
+
+    struct Job
+    {
+        const unsigned char* srcData;
+        unsigned char* destData;
+        size_t srcStride;
+        size_t destStride;
+    };
+
+    // Rounded fixed-point product, as computed by every kernel
+    static uint32_t Scale(uint32_t level, uint16_t gain)
+    {
+        return (level * gain + (1 << (k_flatFieldGainBits - 1))) >> k_flatFieldGainBits;
+    }
+
+    void Run(unsigned int band)
+    {
+        uint64_t generation = 0;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_start.wait(lock, [&] { return m_stopping || m_generation != generation; });
+            if (m_stopping)
+            {
+                return;
+            }
+            generation = m_generation;
+
+            lock.unlock();
+            ApplyBand(band);
+            lock.lock();
+
+            if (--m_numPending == 0)
+            {
+                m_done.notify_one();
+            }
+        }
+    }
+
+    // Corrects the rows of one band of the current job
+    void ApplyBand(unsigned int band)
+    {
+        const size_t width = m_map.width;
+        const size_t height = m_map.height;
+        const size_t firstRow = height * band / m_numThreads;
+        const size_t lastRow = height * (band + 1) / m_numThreads;
+
+        for (size_t y = firstRow; y < lastRow; y++)
+        {
+            if (m_map.bitsPerPixel == 8)
+            {
+                ApplyMono8(m_job.srcData + y * m_job.srcStride, m_job.destData + y * m_job.destStride, y * width, width,
+                           m_useSimd);
+            }
+            else
+            {
+                ApplyMono16(
+                    reinterpret_cast<const uint16_t*>(m_job.srcData + y * m_job.srcStride),
+                    reinterpret_cast<uint16_t*>(m_job.destData + y * m_job.destStride),
+                    y * width,
+                    width,
+                    m_useSimd);
+            }
+        }
+    }
+
+#if defined(FLAT_FIELD_SSE41)
+    // (level * gain + round) >> 12 of 8 16-bit levels, saturated to 16 bits
+    static __m128i ScaleSse41(__m128i level, __m128i gain)
+    {
+        const __m128i round = _mm_set1_epi32(1 << (k_flatFieldGainBits - 1));
+        const __m128i productLow = _mm_mullo_epi16(level, gain);
+        const __m128i productHigh = _mm_mulhi_epu16(level, gain);
+        const __m128i low = _mm_srli_epi32(_mm_add_epi32(_mm_unpacklo_epi16(productLow, productHigh), round), k_flatFieldGainBits);
+        const __m128i high = _mm_srli_epi32(_mm_add_epi32(_mm_unpackhi_epi16(productLow, productHigh), round), k_flatFieldGainBits);
+        return _mm_packus_epi32(low, high);
+    }
+
+    // 16 pixels per iteration
+    static size_t ApplyMono8Sse41(
+        const unsigned char* src,
+        unsigned char* dest,
+        const uint16_t* gain,
+        const uint16_t* dark,
+        size_t numPixels)
+    {
+        const __m128i zero = _mm_setzero_si128();
+
+        size_t i = 0;
+        for (; i + 16 <= numPixels; i += 16)
+        {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i low = _mm_unpacklo_epi8(pixels, zero);
+            __m128i high = _mm_unpackhi_epi8(pixels, zero);
+            if (dark)
+            {
+                low = _mm_subs_epu16(low, _mm_loadu_si128(reinterpret_cast<const __m128i*>(dark + i)));
+                high = _mm_subs_epu16(high, _mm_loadu_si128(reinterpret_cast<const __m128i*>(dark + i + 8)));
+            }
+
+            low = ScaleSse41(low, _mm_loadu_si128(reinterpret_cast<const __m128i*>(gain + i)));
+            high = ScaleSse41(high, _mm_loadu_si128(reinterpret_cast<const __m128i*>(gain + i + 8)));
+
+            // Scaled 8-bit levels stay below 4096, so the signed pack saturates them correctly
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packus_epi16(low, high));
+        }
+        return i;
+    }
+
+    // 8 pixels per iteration
+    static size_t ApplyMono16Sse41(
+        const uint16_t* src,
+        uint16_t* dest,
+        const uint16_t* gain,
+        const uint16_t* dark,
+        size_t numPixels)
+    {
+        size_t i = 0;
+        for (; i + 8 <= numPixels; i += 8)
+        {
+            __m128i level = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            if (dark)
+            {
+                level = _mm_subs_epu16(level, _mm_loadu_si128(reinterpret_cast<const __m128i*>(dark + i)));
+            }
+
+            const __m128i out = ScaleSse41(level, _mm_loadu_si128(reinterpret_cast<const __m128i*>(gain + i)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), out);
+        }
+        return i;
+    }
+#endif
+
+#if defined(FLAT_FIELD_AVX2)
+    // 16 levels at a time; the in-lane unpack and pack cancel out, so the order is kept
+    static __m256i ScaleAvx2(__m256i level, __m256i gain)
+    {
+        const __m256i round = _mm256_set1_epi32(1 << (k_flatFieldGainBits - 1));
+        const __m256i productLow = _mm256_mullo_epi16(level, gain);
+        const __m256i productHigh = _mm256_mulhi_epu16(level, gain);
+        const __m256i low =
+            _mm256_srli_epi32(_mm256_add_epi32(_mm256_unpacklo_epi16(productLow, productHigh), round), k_flatFieldGainBits);
+        const __m256i high =
+            _mm256_srli_epi32(_mm256_add_epi32(_mm256_unpackhi_epi16(productLow, productHigh), round), k_flatFieldGainBits);
+        return _mm256_packus_epi32(low, high);
+    }
+
+    // 32 pixels per iteration
+    static size_t ApplyMono8Avx2(
+        const unsigned char* src,
+        unsigned char* dest,
+        const uint16_t* gain,
+        const uint16_t* dark,
+        size_t numPixels)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+
+        size_t i = 0;
+        for (; i + 32 <= numPixels; i += 32)
+        {
+            // The lanes of the input are swapped so that the in-lane unpack yields pixels 0-15 and 16-31
+            const __m256i pixels =
+                _mm256_permute4x64_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), 0xD8);
+            __m256i low = _mm256_unpacklo_epi8(pixels, zero);
+            __m256i high = _mm256_unpackhi_epi8(pixels, zero);
+            if (dark)
+            {
+                low = _mm256_subs_epu16(low, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dark + i)));
+                high = _mm256_subs_epu16(high, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dark + i + 16)));
+            }
+
+            low = ScaleAvx2(low, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(gain + i)));
+            high = ScaleAvx2(high, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(gain + i + 16)));
+
+            const __m256i out = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), out);
+        }
+        return i;
+    }
+
+    // 16 pixels per iteration
+    static size_t ApplyMono16Avx2(
+        const uint16_t* src,
+        uint16_t* dest,
+        const uint16_t* gain,
+        const uint16_t* dark,
+        size_t numPixels)
+    {
+        size_t i = 0;
+        for (; i + 16 <= numPixels; i += 16)
+        {
+            __m256i level = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            if (dark)
+            {
+                level = _mm256_subs_epu16(level, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dark + i)));
+            }
+
+            const __m256i out = ScaleAvx2(level, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(gain + i)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), out);
+        }
+        return i;
+    }
+#endif
+
+#if defined(FLAT_FIELD_NEON)
+    // Rounding, saturating narrow of the 32-bit products matches Scale() followed by the clamp
+    static uint16x8_t ScaleNeon(uint16x8_t level, uint16x8_t gain)
+    {
+        const uint32x4_t low = vmull_u16(vget_low_u16(level), vget_low_u16(gain));
+        const uint32x4_t high = vmull_u16(vget_high_u16(level), vget_high_u16(gain));
+        return vcombine_u16(vqrshrn_n_u32(low, k_flatFieldGainBits), vqrshrn_n_u32(high, k_flatFieldGainBits));
+    }
+
+    // 16 pixels per iteration
+    static size_t ApplyMono8Neon(
+        const unsigned char* src,
+        unsigned char* dest,
+        const uint16_t* gain,
+        const uint16_t* dark,
+        size_t numPixels)
+    {
+        size_t i = 0;
+        for (; i + 16 <= numPixels; i += 16)
+        {
+            const uint8x16_t pixels = vld1q_u8(src + i);
+            uint16x8_t low = vmovl_u8(vget_low_u8(pixels));
+            uint16x8_t high = vmovl_u8(vget_high_u8(pixels));
+            if (dark)
+            {
+                low = vqsubq_u16(low, vld1q_u16(dark + i));
+                high = vqsubq_u16(high, vld1q_u16(dark + i + 8));
+            }
+
+            low = ScaleNeon(low, vld1q_u16(gain + i));
+            high = ScaleNeon(high, vld1q_u16(gain + i + 8));
+            vst1q_u8(dest + i, vcombine_u8(vqmovn_u16(low), vqmovn_u16(high)));
+        }
+        return i;
+    }
+
+    // 8 pixels per iteration
+    static size_t ApplyMono16Neon(
+        const uint16_t* src,
+        uint16_t* dest,
+        const uint16_t* gain,
+        const uint16_t* dark,
+        size_t numPixels)
+    {
+        size_t i = 0;
+        for (; i + 8 <= numPixels; i += 8)
+        {
+            uint16x8_t level = vld1q_u16(src + i);
+            if (dark)
+            {
+                level = vqsubq_u16(level, vld1q_u16(dark + i));
+            }
+            vst1q_u16(dest + i, ScaleNeon(level, vld1q_u16(gain + i)));
+        }
+        return i;
+    }
+#endif
+
+    const FlatFieldMap m_map;
+    const unsigned int m_numThreads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    std::vector<std::thread> m_workers;
+    Job m_job;
+    uint64_t m_generation;
+    unsigned int m_numPending;
+    bool m_useSimd;
+    bool m_stopping;
+};
+
+#endif // FLAT_FIELD_CORRECTION_H
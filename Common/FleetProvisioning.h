@@ -0,0 +1,297 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief FleetProvisioning.h applies the same settings profile to every
+*  connected camera at once and saves it to a user set.
+*
+*  A provisioning profile sets the exposure time, saves the settings to a
+*  user set and optionally makes that user set the one the camera starts up
+*  with. ProvisionCameras() hands the cameras to a pool of worker threads.
+*  Each worker initializes a camera, applies the profile and deinitializes
+*  it again, so the nodemap downloads of Init(), which dominate the time per
+*  camera, overlap. The System only has to be opened once for the whole
+*  fleet. Each camera gets a ProvisioningResult with its time per step and
+*  the reason it failed, if it did, and one camera failing does not stop the
+*  others. Typical use:
+*
+*      ProvisioningProfile profile = ProvisioningProfile();
+*      profile.exposureTime = 2000.0;
+*      profile.userSet = "UserSet1";
+*      vector<ProvisioningResult> results;
+*      ProvisionCameras(cameras, profile, results);
+*      PrintProvisioningResults(results);
+*/
+
+#ifndef FLEET_PROVISIONING_H
+#define FLEET_PROVISIONING_H
+
+#include "Spinnaker.h"
+#include "SpinGenApi/SpinnakerGenApi.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Number of cameras provisioned at the same time; more only contend for the host's network or USB links
+const unsigned int k_maxConcurrentProvisioning = 8;
+
+// Settings applied to every camera of the fleet
+struct ProvisioningProfile
+{
+    // Exposure time in microseconds, clamped to the range of each camera; 0 leaves the exposure alone
+    double exposureTime;
+
+    // UserSetSelector entry the settings are saved to
+    Spinnaker::GenICam::gcstring userSet;
+
+    // UserSetDefault entry the camera starts up with from now on; empty leaves it alone
+    Spinnaker::GenICam::gcstring startupUserSet;
+
+    // UserSetSelector entry loaded once the settings are saved, e.g. "Default"; empty loads nothing
+    Spinnaker::GenICam::gcstring loadUserSet;
+};
+
+// Outcome of provisioning one camera; the times are in seconds
+struct ProvisioningResult
+{
+    Spinnaker::GenICam::gcstring serialNumber;
+    bool success;
+    std::string error;
+    double exposureTime;
+    double initSeconds;
+    double configureSeconds;
+    double saveSeconds;
+    double seconds;
+};
+
+// Selects an entry of an enumeration by name, or leaves an error in the result
+inline bool SetProvisioningEnumeration(
+    Spinnaker::GenApi::INodeMap& nodeMap,
+    const char* name,
+    const Spinnaker::GenICam::gcstring& entry,
+    ProvisioningResult& result)
+{
+    using namespace Spinnaker::GenApi;
+
+    CEnumerationPtr ptrEnumeration = nodeMap.GetNode(name);
+    if (!IsAvailable(ptrEnumeration) || !IsWritable(ptrEnumeration))
+    {
+        result.error = std::string(name) + " not writable";
+        return false;
+    }
+
+    CEnumEntryPtr ptrEntry = ptrEnumeration->GetEntryByName(entry);
+    if (!IsAvailable(ptrEntry) || !IsReadable(ptrEntry))
+    {
+        result.error = std::string(name) + " has no entry " + entry.c_str();
+        return false;
+    }
+
+    ptrEnumeration->SetIntValue(ptrEntry->GetValue());
+    return true;
+}
+
+inline bool ExecuteProvisioningCommand(Spinnaker::GenApi::INodeMap& nodeMap, const char* name, ProvisioningResult& result)
+{
+    using namespace Spinnaker::GenApi;
+
+    CCommandPtr ptrCommand = nodeMap.GetNode(name);
+    if (!IsAvailable(ptrCommand) || !IsWritable(ptrCommand))
+    {
+        result.error = std::string(name) + " not available";
+        return false;
+    }
+
+    ptrCommand->Execute();
+    return true;
+}
+
+// Applies the profile to an initialized camera and saves it to the user set of the profile
+inline bool ApplyProvisioningProfile(Spinnaker::CameraPtr pCam, const ProvisioningProfile& profile, ProvisioningResult& result)
+{
+    using namespace Spinnaker::GenApi;
+
+    INodeMap& nodeMap = pCam->GetNodeMap();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    if (profile.exposureTime > 0.0)
+    {
+        // Turn off auto exposure, then clamp the exposure time to what this camera supports
+        if (!SetProvisioningEnumeration(nodeMap, "ExposureAuto", "Off", result))
+        {
+            return false;
+        }
+
+        CFloatPtr ptrExposureTime = nodeMap.GetNode("ExposureTime");
+        if (!IsAvailable(ptrExposureTime) || !IsWritable(ptrExposureTime))
+        {
+            result.error = "ExposureTime not writable";
+            return false;
+        }
+
+        ptrExposureTime->SetValue(
+            std::min(std::max(profile.exposureTime, ptrExposureTime->GetMin()), ptrExposureTime->GetMax()));
+        result.exposureTime = ptrExposureTime->GetValue();
+    }
+
+    // The user set is selected before it is saved, then made the startup set
+    if (!SetProvisioningEnumeration(nodeMap, "UserSetSelector", profile.userSet, result))
+    {
+        return false;
+    }
+    result.configureSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    if (!ExecuteProvisioningCommand(nodeMap, "UserSetSave", result))
+    {
+        return false;
+    }
+
+    if (!profile.startupUserSet.empty() &&
+        !SetProvisioningEnumeration(nodeMap, "UserSetDefault", profile.startupUserSet, result))
+    {
+        return false;
+    }
+
+    if (!profile.loadUserSet.empty() &&
+        (!SetProvisioningEnumeration(nodeMap, "UserSetSelector", profile.loadUserSet, result) ||
+         !ExecuteProvisioningCommand(nodeMap, "UserSetLoad", result)))
+    {
+        return false;
+    }
+    result.saveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return true;
+}
+
+// Provisions one camera; cameras that are not initialized yet are initialized for the duration
+inline void ProvisionCamera(Spinnaker::CameraPtr pCam, const ProvisioningProfile& profile, ProvisioningResult& result)
+{
+    using namespace Spinnaker::GenApi;
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool initialized = false;
+
+    result = ProvisioningResult();
+    result.success = false;
+
+    try
+    {
+        CStringPtr ptrSerialNumber = pCam->GetTLDeviceNodeMap().GetNode("DeviceSerialNumber");
+        result.serialNumber =
+            (IsAvailable(ptrSerialNumber) && IsReadable(ptrSerialNumber)) ? ptrSerialNumber->GetValue() : "";
+
+        if (!pCam->IsInitialized())
+        {
+            pCam->Init();
+            initialized = true;
+        }
+        result.initSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        result.success = ApplyProvisioningProfile(pCam, profile, result);
+    }
+    catch (Spinnaker::Exception& e)
+    {
+        result.error = e.what();
+        result.success = false;
+    }
+
+    try
+    {
+        if (initialized)
+        {
+            pCam->DeInit();
+        }
+    }
+    catch (Spinnaker::Exception& e)
+    {
+        if (result.success)
+        {
+            result.error = e.what();
+            result.success = false;
+        }
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Provisions every camera concurrently; returns true if all of them succeeded
+inline bool ProvisionCameras(
+    const std::vector<Spinnaker::CameraPtr>& cameras,
+    const ProvisioningProfile& profile,
+    std::vector<ProvisioningResult>& results,
+    unsigned int numWorkers = k_maxConcurrentProvisioning)
+{
+    results.assign(cameras.size(), ProvisioningResult());
+
+    RunOnWorkerPool(cameras.size(), numWorkers, [&](size_t i) { ProvisionCamera(cameras[i], profile, results[i]); });
+
+    bool success = true;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        success = success && results[i].success;
+    }
+    return success;
+}
+
+// Prints one line per camera and a summary; totalSeconds is the wall-clock time of the whole fleet, if known
+inline void PrintProvisioningResults(const std::vector<ProvisioningResult>& results, double totalSeconds = 0.0)
+{
+    size_t numProvisioned = 0;
+    double slowest = 0.0;
+    double sum = 0.0;
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const ProvisioningResult& result = results[i];
+
+        std::cout << "Camera " << result.serialNumber << ": ";
+        if (result.success)
+        {
+            std::cout << "provisioned in " << static_cast<int64_t>(result.seconds * 1000.0) << " ms (init "
+                      << static_cast<int64_t>(result.initSeconds * 1000.0) << " ms, configure "
+                      << static_cast<int64_t>(result.configureSeconds * 1000.0) << " ms, save "
+                      << static_cast<int64_t>(result.saveSeconds * 1000.0) << " ms)";
+            if (result.exposureTime > 0.0)
+            {
+                std::cout << ", exposure time " << result.exposureTime << " us";
+            }
+            numProvisioned++;
+        }
+        else
+        {
+            std::cout << "failed after " << static_cast<int64_t>(result.seconds * 1000.0) << " ms: " << result.error;
+        }
+        std::cout << std::endl;
+
+        slowest = std::max(slowest, result.seconds);
+        sum += result.seconds;
+    }
+
+    std::cout << numProvisioned << " of " << results.size() << " cameras provisioned";
+    if (totalSeconds > 0.0)
+    {
+        std::cout << " in " << static_cast<int64_t>(totalSeconds * 1000.0) << " ms (" << static_cast<int64_t>(sum * 1000.0)
+                  << " ms of camera time, slowest camera " << static_cast<int64_t>(slowest * 1000.0) << " ms)";
+    }
+    std::cout << std::endl;
+}
+
+#endif // FLEET_PROVISIONING_H
@@ -0,0 +1,210 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief FrameSetMatcher.h groups the frames of several cameras into
+*  framesets by timestamp, for cameras that share one clock such as the
+*  IEEE 1588 clock of a synchronized rig.
+*
+*  Every camera keeps its own queue of frames in timestamp order. Whenever
+*  all cameras have a frame waiting, the oldest frame of each camera is
+*  compared: if they lie within the tolerance they form a frameset, otherwise
+*  the oldest of them cannot have a partner in the other cameras any more and
+*  is dropped. A frame older than the last one queued for its camera means
+*  the camera clock was reset or the camera stalled, so the frames queued
+*  before it are dropped, and a camera with more than maxPending frames
+*  waiting drops its oldest.
+*
+*  The frame type only needs an int64_t timestamp member, so the same
+*  matching serves images grabbed on this host and frame records sent by
+*  other hosts. The matcher is not thread safe; callers add frames under
+*  their own lock. Typical use:
+*
+*      FrameSetMatcher<TimedImage> matcher(numCameras, tolerance, maxPending,
+*                                          [](TimedImage& frame) { frame.pImage->Release(); });
+*
+*      // Under the caller's lock
+*      matcher.Add(camIndex, frame, [&](unsigned int index, std::vector<TimedImage>& frames, int64_t spread) {
+*          ...
+*          return true;
+*      });
+*/
+
+#ifndef FRAME_SET_MATCHER_H
+#define FRAME_SET_MATCHER_H
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+
+template <typename Frame>
+class FrameSetMatcher
+{
+public:
+    // Called for every frame dropped without a match, e.g. to release its image
+    typedef std::function<void(Frame&)> DropHandler;
+
+    FrameSetMatcher(size_t numCameras, int64_t tolerance, size_t maxPending, DropHandler onDrop = DropHandler())
+        : m_pending(numCameras), m_tolerance(tolerance), m_maxPending(std::max<size_t>(maxPending, 1)),
+          m_onDrop(onDrop), m_numFrameSets(0), m_numDropped(0), m_totalSpread(0), m_maxSpread(0)
+    {
+    }
+
+    // Starts over with numCameras cameras; frames still queued are dropped without being counted
+    void Reset(size_t numCameras)
+    {
+        Clear();
+        m_pending.assign(numCameras, std::deque<Frame>());
+    }
+
+    //
+    // Queues a frame of one camera and passes every frameset it completes to
+    // emit(index, frames, spread), with the frames indexed by camera. emit
+    // returns false if it did not take the frameset, which then does not count
+    // towards the statistics.
+    //
+    template <typename Emit> void Add(size_t camIndex, const Frame& frame, Emit emit)
+    {
+        std::deque<Frame>& pending = m_pending[camIndex];
+
+        if (!pending.empty() && frame.timestamp < pending.back().timestamp)
+        {
+            while (!pending.empty())
+            {
+                DropFront(pending);
+            }
+        }
+
+        pending.push_back(frame);
+        if (pending.size() > m_maxPending)
+        {
+            DropFront(pending);
+        }
+
+        while (AllPending())
+        {
+            size_t oldest = 0;
+            int64_t minTimestamp = m_pending[0].front().timestamp;
+            int64_t maxTimestamp = minTimestamp;
+
+            for (size_t i = 1; i < m_pending.size(); i++)
+            {
+                const int64_t headTimestamp = m_pending[i].front().timestamp;
+                if (headTimestamp < minTimestamp)
+                {
+                    minTimestamp = headTimestamp;
+                    oldest = i;
+                }
+                maxTimestamp = std::max<int64_t>(maxTimestamp, headTimestamp);
+            }
+
+            if (maxTimestamp - minTimestamp > m_tolerance)
+            {
+                DropFront(m_pending[oldest]);
+                continue;
+            }
+
+            std::vector<Frame> frames;
+            for (size_t i = 0; i < m_pending.size(); i++)
+            {
+                frames.push_back(m_pending[i].front());
+                m_pending[i].pop_front();
+            }
+
+            const int64_t spread = maxTimestamp - minTimestamp;
+            if (emit(m_numFrameSets, frames, spread))
+            {
+                m_numFrameSets++;
+                m_totalSpread += spread;
+                m_maxSpread = std::max<int64_t>(m_maxSpread, spread);
+            }
+        }
+    }
+
+    // Drops every frame still waiting for a partner, without counting them
+    void Clear()
+    {
+        for (size_t i = 0; i < m_pending.size(); i++)
+        {
+            while (!m_pending[i].empty())
+            {
+                if (m_onDrop)
+                {
+                    m_onDrop(m_pending[i].front());
+                }
+                m_pending[i].pop_front();
+            }
+        }
+    }
+
+    unsigned int GetNumFrameSets() const
+    {
+        return m_numFrameSets;
+    }
+
+    // Prints the frames dropped without a match and the timestamp spread of the framesets
+    void PrintStatistics() const
+    {
+        std::cout << "Frames dropped without a match: " << m_numDropped << std::endl;
+        if (m_numFrameSets > 0)
+        {
+            std::cout << "Timestamp spread within a frameset: mean " << m_totalSpread / m_numFrameSets << " ns, max "
+                      << m_maxSpread << " ns" << std::endl;
+        }
+    }
+
+private:
+    bool AllPending() const
+    {
+        if (m_pending.empty())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < m_pending.size(); i++)
+        {
+            if (m_pending[i].empty())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void DropFront(std::deque<Frame>& pending)
+    {
+        if (m_onDrop)
+        {
+            m_onDrop(pending.front());
+        }
+        pending.pop_front();
+        m_numDropped++;
+    }
+
+    std::vector<std::deque<Frame>> m_pending;
+    const int64_t m_tolerance;
+    const size_t m_maxPending;
+    DropHandler m_onDrop;
+    unsigned int m_numFrameSets;
+    unsigned int m_numDropped;
+    int64_t m_totalSpread;
+    int64_t m_maxSpread;
+};
+
+#endif // FRAME_SET_MATCHER_H
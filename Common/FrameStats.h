@@ -0,0 +1,605 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief FrameStats.h records how long each stage of an acquisition loop
+*  takes per frame (waiting in GetNextImage, Convert, CCM, Save, Release...)
+*  along with stream statistics, and reports p50/p99/max per stage at the end
+*  of a run or periodically to a CSV file.
+*
+*  Each thread (or each camera, when one thread serves several) records into
+*  its own FrameRecorder, created once from the shared FrameStats. Recording
+*  takes no locks: every counter has a single writer and is only read
+*  atomically by the reporting side, so reports can be produced while the
+*  acquisition is still running.
+*
+*  Typical use:
+*
+*      FrameStats stats("AcquisitionCCM", "AcquisitionCCM-stats.csv", 5.0);
+*      FrameRecorder & recorder = stats.CreateRecorder();
+*
+*      StageTimer getTimer(recorder, STAGE_GET_NEXT_IMAGE);
+*      ImagePtr pResultImage = pCam->GetNextImage();
+*      getTimer.Stop();
+*      recorder.RecordFrame(pResultImage);
+*      ...
+*      stats.ReportIfDue();
+*      ...
+*      stats.RecordStreamStatistics(pCam->GetTLStreamNodeMap());
+*      stats.Report();
+*/
+
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include "Spinnaker.h"
+#include "SpinGenApi/SpinnakerGenApi.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Stages of an acquisition loop that can be timed
+enum frameStage
+{
+    STAGE_GET_NEXT_IMAGE,
+    STAGE_CONVERT,
+    STAGE_DEMOSAIC,
+    STAGE_CCM,
+    STAGE_FLAT_FIELD,
+    STAGE_SAVE,
+    STAGE_DISPLAY,
+    STAGE_RELEASE,
+    NUM_FRAME_STAGES
+};
+
+inline const char* GetFrameStageName(frameStage stage)
+{
+    switch (stage)
+    {
+    case STAGE_GET_NEXT_IMAGE:
+        return "GetNextImage";
+    case STAGE_CONVERT:
+        return "Convert";
+    case STAGE_DEMOSAIC:
+        return "Demosaic";
+    case STAGE_CCM:
+        return "CCM";
+    case STAGE_FLAT_FIELD:
+        return "FlatField";
+    case STAGE_SAVE:
+        return "Save";
+    case STAGE_DISPLAY:
+        return "Display";
+    case STAGE_RELEASE:
+        return "Release";
+    default:
+        return "Unknown";
+    }
+}
+
+// Counters are only ever written by the thread that owns them, so a relaxed
+// load and store is enough and avoids a locked read-modify-write per sample.
+inline void AddSingleWriter(std::atomic<uint64_t>& counter, uint64_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+// Log-linear histogram of durations in microseconds. Values below 32 us get
+// a bucket each; above that every power of two is split into 16 buckets, so
+// percentiles are accurate to within about 6% up to several hours.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() : m_count(0), m_totalNs(0), m_maxNs(0)
+    {
+        for (unsigned int i = 0; i < k_numBuckets; i++)
+        {
+            m_buckets[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void Record(uint64_t nanoseconds)
+    {
+        AddSingleWriter(m_buckets[GetBucket(nanoseconds / 1000)], 1);
+        AddSingleWriter(m_count, 1);
+        AddSingleWriter(m_totalNs, nanoseconds);
+        if (nanoseconds > m_maxNs.load(std::memory_order_relaxed))
+        {
+            m_maxNs.store(nanoseconds, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t GetCount() const
+    {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+    // Add the samples of another histogram into this one (used for reporting)
+    void Merge(const LatencyHistogram& other)
+    {
+        for (unsigned int i = 0; i < k_numBuckets; i++)
+        {
+            AddSingleWriter(m_buckets[i], other.m_buckets[i].load(std::memory_order_relaxed));
+        }
+        AddSingleWriter(m_count, other.m_count.load(std::memory_order_relaxed));
+        AddSingleWriter(m_totalNs, other.m_totalNs.load(std::memory_order_relaxed));
+        if (other.m_maxNs.load(std::memory_order_relaxed) > m_maxNs.load(std::memory_order_relaxed))
+        {
+            m_maxNs.store(other.m_maxNs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+
+    double GetMeanMs() const
+    {
+        const uint64_t count = GetCount();
+        return count == 0 ? 0.0 : m_totalNs.load(std::memory_order_relaxed) / 1e6 / count;
+    }
+
+    double GetMaxMs() const
+    {
+        return m_maxNs.load(std::memory_order_relaxed) / 1e6;
+    }
+
+    // Duration below which the given fraction (0 to 1) of samples fall
+    double GetPercentileMs(double fraction) const
+    {
+        uint64_t total = 0;
+        for (unsigned int i = 0; i < k_numBuckets; i++)
+        {
+            total += m_buckets[i].load(std::memory_order_relaxed);
+        }
+        if (total == 0)
+        {
+            return 0.0;
+        }
+
+        const uint64_t target = static_cast<uint64_t>(fraction * (total - 1)) + 1;
+        uint64_t seen = 0;
+        for (unsigned int i = 0; i < k_numBuckets; i++)
+        {
+            seen += m_buckets[i].load(std::memory_order_relaxed);
+            if (seen >= target)
+            {
+                // Report the middle of the bucket, but never more than the largest sample
+                const double bucketMs = (GetBucketLowerBound(i) + GetBucketLowerBound(i + 1)) / 2.0 / 1000.0;
+                return bucketMs < GetMaxMs() ? bucketMs : GetMaxMs();
+            }
+        }
+        return GetMaxMs();
+    }
+
+private:
+    static const unsigned int k_numLinearBuckets = 32;
+    static const unsigned int k_subBuckets = 16;
+    static const unsigned int k_numBuckets = k_numLinearBuckets + (64 - 5) * k_subBuckets;
+
+    static unsigned int GetBucket(uint64_t microseconds)
+    {
+        if (microseconds < k_numLinearBuckets)
+        {
+            return static_cast<unsigned int>(microseconds);
+        }
+
+        unsigned int msb = 0;
+        while ((microseconds >> (msb + 1)) != 0)
+        {
+            msb++;
+        }
+
+        const unsigned int shift = msb - 4;
+        return k_numLinearBuckets + (msb - 5) * k_subBuckets + static_cast<unsigned int>((microseconds >> shift) & (k_subBuckets - 1));
+    }
+
+    static double GetBucketLowerBound(unsigned int bucket)
+    {
+        if (bucket < k_numLinearBuckets)
+        {
+            return bucket;
+        }
+
+        const unsigned int index = bucket - k_numLinearBuckets;
+        const unsigned int msb = index / k_subBuckets + 5;
+        return static_cast<double>(k_subBuckets + index % k_subBuckets) * static_cast<double>(1ULL << (msb - 4));
+    }
+
+    std::atomic<uint64_t> m_buckets[k_numBuckets];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_totalNs;
+    std::atomic<uint64_t> m_maxNs;
+};
+
+// Per-thread (or per-camera) set of stage histograms and frame counters.
+// Only one thread may record into a given recorder.
+class FrameRecorder
+{
+public:
+    FrameRecorder() : m_numFrames(0), m_numIncomplete(0), m_numDropped(0), m_hasFrameID(false), m_lastFrameID(0)
+    {
+        for (unsigned int i = 0; i < k_numStatusCodes; i++)
+        {
+            m_statusCounts[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void Record(frameStage stage, uint64_t nanoseconds)
+    {
+        m_histograms[stage].Record(nanoseconds);
+    }
+
+    // Count a retrieved image, its status if incomplete, and any frame ID gap before it
+    void RecordFrame(const Spinnaker::ImagePtr& pImage)
+    {
+        AddSingleWriter(m_numFrames, 1);
+
+        if (pImage->IsIncomplete())
+        {
+            AddSingleWriter(m_numIncomplete, 1);
+
+            const int status = static_cast<int>(pImage->GetImageStatus()) + 1;
+            AddSingleWriter(m_statusCounts[status >= 0 && status < static_cast<int>(k_numStatusCodes) ? status : 0], 1);
+        }
+
+        const uint64_t frameID = pImage->GetFrameID();
+        if (m_hasFrameID && frameID > m_lastFrameID + 1)
+        {
+            AddSingleWriter(m_numDropped, frameID - m_lastFrameID - 1);
+        }
+        m_hasFrameID = true;
+        m_lastFrameID = frameID;
+    }
+
+    const LatencyHistogram& GetHistogram(frameStage stage) const
+    {
+        return m_histograms[stage];
+    }
+
+    uint64_t GetNumFrames() const
+    {
+        return m_numFrames.load(std::memory_order_relaxed);
+    }
+
+    uint64_t GetNumIncomplete() const
+    {
+        return m_numIncomplete.load(std::memory_order_relaxed);
+    }
+
+    uint64_t GetNumDropped() const
+    {
+        return m_numDropped.load(std::memory_order_relaxed);
+    }
+
+    // Count of incomplete images per ImageStatus; index is the status value + 1
+    static const unsigned int k_numStatusCodes = 16;
+
+    uint64_t GetStatusCount(unsigned int index) const
+    {
+        return m_statusCounts[index].load(std::memory_order_relaxed);
+    }
+
+private:
+    FrameRecorder(const FrameRecorder&);
+    FrameRecorder& operator=(const FrameRecorder&);
+
+    LatencyHistogram m_histograms[NUM_FRAME_STAGES];
+    std::atomic<uint64_t> m_numFrames;
+    std::atomic<uint64_t> m_numIncomplete;
+    std::atomic<uint64_t> m_numDropped;
+    std::atomic<uint64_t> m_statusCounts[k_numStatusCodes];
+
+    // Only touched by the recording thread
+    bool m_hasFrameID;
+    uint64_t m_lastFrameID;
+};
+
+// Times one stage and records it when stopped or when going out of scope
+class StageTimer
+{
+public:
+    StageTimer(FrameRecorder& recorder, frameStage stage)
+        : m_recorder(recorder), m_stage(stage), m_start(std::chrono::steady_clock::now()), m_running(true)
+    {
+    }
+
+    ~StageTimer()
+    {
+        Stop();
+    }
+
+    void Stop()
+    {
+        if (m_running)
+        {
+            m_running = false;
+            m_recorder.Record(m_stage, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - m_start).count()));
+        }
+    }
+
+private:
+    FrameRecorder& m_recorder;
+    frameStage m_stage;
+    std::chrono::steady_clock::time_point m_start;
+    bool m_running;
+};
+
+// Buffer underrun and lost frame counters of a camera's stream at one point in
+// time. The stream counts them across every acquisition, so read them when
+// acquisition begins and pass them to RecordStreamStatistics() to record only
+// the current run.
+struct StreamCounters
+{
+    StreamCounters() : numUnderruns(0), numLostFrames(0), available(false) {}
+
+    int64_t numUnderruns;
+    int64_t numLostFrames;
+    bool available;
+};
+
+inline StreamCounters ReadStreamCounters(Spinnaker::GenApi::INodeMap& streamNodeMap)
+{
+    StreamCounters counters;
+
+    Spinnaker::GenApi::CIntegerPtr ptrUnderruns = streamNodeMap.GetNode("StreamBufferUnderrunCount");
+    if (Spinnaker::GenApi::IsAvailable(ptrUnderruns) && Spinnaker::GenApi::IsReadable(ptrUnderruns))
+    {
+        counters.numUnderruns = ptrUnderruns->GetValue();
+        counters.available = true;
+    }
+
+    Spinnaker::GenApi::CIntegerPtr ptrLostFrames = streamNodeMap.GetNode("StreamLostFrameCount");
+    if (Spinnaker::GenApi::IsAvailable(ptrLostFrames) && Spinnaker::GenApi::IsReadable(ptrLostFrames))
+    {
+        counters.numLostFrames = ptrLostFrames->GetValue();
+        counters.available = true;
+    }
+
+    return counters;
+}
+
+// Owns the recorders of a run and produces the reports
+class FrameStats
+{
+public:
+    // csvPath may be empty to only print to the console; with a reportInterval
+    // above 0, ReportIfDue() appends a CSV row set every reportInterval seconds
+    FrameStats(const std::string& name, const std::string& csvPath = "", double reportIntervalSeconds = 0.0)
+        : m_name(name), m_csvPath(csvPath), m_reportIntervalSeconds(reportIntervalSeconds),
+        m_start(std::chrono::steady_clock::now()), m_lastReport(m_start),
+        m_numUnderruns(0), m_numLostFrames(0), m_hasStreamStatistics(false)
+    {
+        if (!m_csvPath.empty())
+        {
+            std::ofstream csv(m_csvPath.c_str(), std::ios::trunc);
+            csv << "elapsed_s,stage,count,mean_ms,p50_ms,p99_ms,max_ms" << std::endl;
+        }
+    }
+
+    // Create a recorder for the calling thread; the reference stays valid for the life of the FrameStats
+    FrameRecorder& CreateRecorder()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_recorders.push_back(std::shared_ptr<FrameRecorder>(new FrameRecorder()));
+        return *m_recorders.back();
+    }
+
+    // Accumulate the buffer underrun and lost frame counters of a camera's stream
+    // since atStart, as read by ReadStreamCounters() at BeginAcquisition.
+    // Call once per camera, before EndAcquisition.
+    void RecordStreamStatistics(Spinnaker::GenApi::INodeMap& streamNodeMap, const StreamCounters& atStart = StreamCounters())
+    {
+        const StreamCounters counters = ReadStreamCounters(streamNodeMap);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (counters.available)
+        {
+            m_numUnderruns += counters.numUnderruns - atStart.numUnderruns;
+            m_numLostFrames += counters.numLostFrames - atStart.numLostFrames;
+            m_hasStreamStatistics = true;
+        }
+    }
+
+    // Append a row set to the CSV file if the report interval has passed; cheap enough to call every frame
+    void ReportIfDue()
+    {
+        if (m_reportIntervalSeconds <= 0.0 || m_csvPath.empty())
+        {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            return;
+        }
+
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (std::chrono::duration<double>(now - m_lastReport).count() < m_reportIntervalSeconds)
+        {
+            return;
+        }
+        m_lastReport = now;
+
+        WriteCsvRows();
+    }
+
+    // Print the per-stage table and stream statistics, and append the final rows to the CSV file
+    void Report()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const double elapsed = GetElapsedSeconds();
+        std::vector<std::shared_ptr<LatencyHistogram> > histograms = MergeHistograms();
+
+        std::cout << std::endl << "*** FRAME STATISTICS: " << m_name << " ***" << std::endl << std::endl;
+        std::cout << std::left << std::setw(14) << "Stage" << std::right << std::setw(10) << "Count"
+            << std::setw(12) << "Mean ms" << std::setw(12) << "p50 ms" << std::setw(12) << "p99 ms"
+            << std::setw(12) << "Max ms" << std::endl;
+
+        for (unsigned int stage = 0; stage < NUM_FRAME_STAGES; stage++)
+        {
+            const LatencyHistogram& histogram = *histograms[stage];
+            if (histogram.GetCount() == 0)
+            {
+                continue;
+            }
+
+            std::cout << std::left << std::setw(14) << GetFrameStageName(static_cast<frameStage>(stage)) << std::right
+                << std::setw(10) << histogram.GetCount() << std::fixed << std::setprecision(3)
+                << std::setw(12) << histogram.GetMeanMs() << std::setw(12) << histogram.GetPercentileMs(0.5)
+                << std::setw(12) << histogram.GetPercentileMs(0.99) << std::setw(12) << histogram.GetMaxMs()
+                << std::endl;
+        }
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+
+        uint64_t numFrames = 0;
+        uint64_t numIncomplete = 0;
+        uint64_t numDropped = 0;
+        std::vector<uint64_t> statusCounts(FrameRecorder::k_numStatusCodes, 0);
+        for (size_t i = 0; i < m_recorders.size(); i++)
+        {
+            numFrames += m_recorders[i]->GetNumFrames();
+            numIncomplete += m_recorders[i]->GetNumIncomplete();
+            numDropped += m_recorders[i]->GetNumDropped();
+            for (unsigned int status = 0; status < FrameRecorder::k_numStatusCodes; status++)
+            {
+                statusCounts[status] += m_recorders[i]->GetStatusCount(status);
+            }
+        }
+
+        std::cout << std::endl << "Frames: " << numFrames << " in " << elapsed << " s";
+        if (elapsed > 0)
+        {
+            std::cout << " (" << numFrames / elapsed << " images/s)";
+        }
+        std::cout << std::endl;
+        std::cout << "Incomplete: " << numIncomplete << ", dropped (frame ID gaps): " << numDropped << std::endl;
+
+        for (unsigned int status = 0; status < FrameRecorder::k_numStatusCodes; status++)
+        {
+            if (statusCounts[status] != 0)
+            {
+                std::cout << "    " << Spinnaker::Image::GetImageStatusDescription(static_cast<Spinnaker::ImageStatus>(static_cast<int>(status) - 1))
+                    << ": " << statusCounts[status] << std::endl;
+            }
+        }
+
+        if (m_hasStreamStatistics)
+        {
+            std::cout << "Stream buffer underruns: " << m_numUnderruns << ", lost frames: " << m_numLostFrames << std::endl;
+        }
+        std::cout << std::endl;
+
+        if (!m_csvPath.empty())
+        {
+            WriteCsvRows();
+            std::cout << "Frame statistics written to " << m_csvPath << std::endl << std::endl;
+        }
+    }
+
+private:
+    FrameStats(const FrameStats&);
+    FrameStats& operator=(const FrameStats&);
+
+    double GetElapsedSeconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+    // Combine the recorders into one histogram per stage; called with m_mutex held
+    std::vector<std::shared_ptr<LatencyHistogram> > MergeHistograms() const
+    {
+        std::vector<std::shared_ptr<LatencyHistogram> > histograms;
+        for (unsigned int stage = 0; stage < NUM_FRAME_STAGES; stage++)
+        {
+            histograms.push_back(std::shared_ptr<LatencyHistogram>(new LatencyHistogram()));
+            for (size_t i = 0; i < m_recorders.size(); i++)
+            {
+                histograms[stage]->Merge(m_recorders[i]->GetHistogram(static_cast<frameStage>(stage)));
+            }
+        }
+        return histograms;
+    }
+
+    // Append the current cumulative statistics; called with m_mutex held
+    void WriteCsvRows() const
+    {
+        std::ofstream csv(m_csvPath.c_str(), std::ios::app);
+        if (!csv)
+        {
+            return;
+        }
+
+        const double elapsed = GetElapsedSeconds();
+        std::vector<std::shared_ptr<LatencyHistogram> > histograms = MergeHistograms();
+
+        csv << std::fixed << std::setprecision(3);
+        for (unsigned int stage = 0; stage < NUM_FRAME_STAGES; stage++)
+        {
+            const LatencyHistogram& histogram = *histograms[stage];
+            if (histogram.GetCount() == 0)
+            {
+                continue;
+            }
+
+            csv << elapsed << "," << GetFrameStageName(static_cast<frameStage>(stage)) << "," << histogram.GetCount() << ","
+                << histogram.GetMeanMs() << "," << histogram.GetPercentileMs(0.5) << ","
+                << histogram.GetPercentileMs(0.99) << "," << histogram.GetMaxMs() << std::endl;
+        }
+
+        uint64_t numFrames = 0;
+        uint64_t numIncomplete = 0;
+        uint64_t numDropped = 0;
+        for (size_t i = 0; i < m_recorders.size(); i++)
+        {
+            numFrames += m_recorders[i]->GetNumFrames();
+            numIncomplete += m_recorders[i]->GetNumIncomplete();
+            numDropped += m_recorders[i]->GetNumDropped();
+        }
+
+        // Counters only fill in the count column
+        csv << elapsed << ",Frames," << numFrames << ",,,," << std::endl;
+        csv << elapsed << ",Incomplete," << numIncomplete << ",,,," << std::endl;
+        csv << elapsed << ",Dropped," << numDropped << ",,,," << std::endl;
+        if (m_hasStreamStatistics)
+        {
+            csv << elapsed << ",BufferUnderruns," << m_numUnderruns << ",,,," << std::endl;
+            csv << elapsed << ",LostFrames," << m_numLostFrames << ",,,," << std::endl;
+        }
+    }
+
+    const std::string m_name;
+    const std::string m_csvPath;
+    const double m_reportIntervalSeconds;
+    const std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_lastReport;
+
+    std::mutex m_mutex;
+    std::vector<std::shared_ptr<FrameRecorder> > m_recorders;
+    int64_t m_numUnderruns;
+    int64_t m_numLostFrames;
+    bool m_hasStreamStatistics;
+};
+
+#endif // FRAME_STATS_H
@@ -0,0 +1,365 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief ImageEventQueue.h receives images through a Spinnaker image event
+*  handler and hands them to a consumer thread through a bounded queue,
+*  instead of the consumer blocking in GetNextImage().
+*
+*  The image passed to OnImageEvent() only stays valid while the callback
+*  runs, so it is copied into one of a fixed number of buffers owned by the
+*  queue and the camera buffer goes straight back to the stream. The
+*  consumer waits for the next image with a timeout, so a missed trigger
+*  shows up as a timeout instead of a hang, and hands the buffer back with
+*  Release() once it is done.
+*
+*  When the consumer falls behind and every buffer is in use, the backpressure
+*  policy decides what happens to the next image: the oldest queued image is
+*  dropped to make room (lowest latency), the new image is dropped (no gaps
+*  in what was already queued), or the event thread waits up to a timeout for
+*  a buffer to be released.
+*
+*  An optional filter, set before acquisition starts, sees every complete
+*  image on the event thread before it is copied; images it rejects are
+*  counted as skipped and go straight back to the stream. Typical use:
+*
+*      ImageEventQueue imageQueue(4, BACKPRESSURE_DROP_OLDEST);
+*      ImageEventRegistration imageEvents(pCam, imageQueue);
+*      pCam->BeginAcquisition();
+*
+*      QueuedImage image;
+*      if (imageQueue.WaitForImage(image, 1000))
+*      {
+*          ...
+*          imageQueue.Release(image);
+*      }
+*
+*      pCam->EndAcquisition();
+*/
+
+#ifndef IMAGE_EVENT_QUEUE_H
+#define IMAGE_EVENT_QUEUE_H
+
+#include "Spinnaker.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+
+// What the event handler does with an image when every buffer is in use
+enum backpressurePolicy
+{
+    BACKPRESSURE_DROP_OLDEST,
+    BACKPRESSURE_DROP_NEWEST,
+    BACKPRESSURE_BLOCK
+};
+
+// Image handed to the consumer. pImage is a copy owned by the queue and is
+// null for incomplete images, whose status is kept instead.
+struct QueuedImage
+{
+    Spinnaker::ImagePtr pImage;
+    uint64_t frameID;
+    uint64_t timestamp;
+    bool incomplete;
+    Spinnaker::ImageStatus imageStatus;
+    std::chrono::steady_clock::time_point receivedAt;
+    int bufferIndex;
+};
+
+class ImageEventQueue : public Spinnaker::ImageEventHandler
+{
+public:
+    // Returns true if the image is to be queued; called on the event thread, without the queue locked
+    typedef std::function<bool(const Spinnaker::ImagePtr&)> ImageFilter;
+
+    // capacity is the number of images the queue can hold; blockTimeoutMs only applies to BACKPRESSURE_BLOCK
+    ImageEventQueue(size_t capacity, backpressurePolicy policy = BACKPRESSURE_DROP_OLDEST, unsigned int blockTimeoutMs = 100)
+        : m_buffers(std::max<size_t>(capacity, 1)), m_policy(policy), m_blockTimeout(blockTimeoutMs), m_numReceived(0),
+          m_numIncomplete(0), m_numDropped(0), m_numSkipped(0), m_numDelivered(0), m_totalHandoffUs(0), m_maxHandoffUs(0)
+    {
+        for (size_t i = 0; i < m_buffers.size(); i++)
+        {
+            m_freeBuffers.push_back(static_cast<int>(i));
+        }
+    }
+
+    ~ImageEventQueue()
+    {
+    }
+
+    // Set the filter before acquisition starts; an empty filter queues every image
+    void SetFilter(const ImageFilter& filter)
+    {
+        m_filter = filter;
+    }
+
+    // Called on the Spinnaker event thread for every image
+    void OnImageEvent(Spinnaker::ImagePtr image)
+    {
+        const std::chrono::steady_clock::time_point receivedAt = std::chrono::steady_clock::now();
+
+        QueuedImage queuedImage;
+        queuedImage.frameID = image->GetFrameID();
+        queuedImage.timestamp = image->GetTimeStamp();
+        queuedImage.incomplete = image->IsIncomplete();
+        queuedImage.imageStatus = image->GetImageStatus();
+        queuedImage.receivedAt = receivedAt;
+        queuedImage.bufferIndex = -1;
+
+        const bool skipped = !queuedImage.incomplete && m_filter && !m_filter(image);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_numReceived++;
+
+        if (skipped)
+        {
+            m_numSkipped++;
+            return;
+        }
+
+        if (queuedImage.incomplete)
+        {
+            m_numIncomplete++;
+        }
+        else
+        {
+            queuedImage.bufferIndex = AcquireBuffer(lock);
+            if (queuedImage.bufferIndex < 0)
+            {
+                m_numDropped++;
+                return;
+            }
+
+            // Copy outside the lock so that the consumer is not held up; nobody else uses this buffer until it is queued
+            lock.unlock();
+            queuedImage.pImage = CopyImage(image, m_buffers[queuedImage.bufferIndex]);
+            lock.lock();
+        }
+
+        m_queue.push_back(queuedImage);
+        m_imageReady.notify_one();
+    }
+
+    // Waits up to timeoutMs for the next image; returns false on timeout
+    bool WaitForImage(QueuedImage& image, unsigned int timeoutMs)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_imageReady.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return !m_queue.empty(); }))
+        {
+            return false;
+        }
+
+        image = m_queue.front();
+        m_queue.pop_front();
+
+        // Time from the image event to the consumer picking it up
+        const int64_t handoffUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                                      std::chrono::steady_clock::now() - image.receivedAt)
+                                      .count();
+        m_numDelivered++;
+        m_totalHandoffUs += handoffUs;
+        m_maxHandoffUs = std::max<int64_t>(m_maxHandoffUs, handoffUs);
+
+        return true;
+    }
+
+    // Hands the buffer of a consumed image back to the queue
+    void Release(QueuedImage& image)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (image.bufferIndex >= 0)
+        {
+            m_freeBuffers.push_back(image.bufferIndex);
+            m_bufferFree.notify_one();
+        }
+        image.pImage = Spinnaker::ImagePtr();
+        image.bufferIndex = -1;
+    }
+
+    // Drops every queued image, e.g. once acquisition has ended
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (!m_queue.empty())
+        {
+            if (m_queue.front().bufferIndex >= 0)
+            {
+                m_freeBuffers.push_back(m_queue.front().bufferIndex);
+            }
+            m_queue.pop_front();
+        }
+        m_bufferFree.notify_all();
+    }
+
+    void PrintStatistics()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::cout << "Image events: " << m_numReceived << " received, " << m_numIncomplete << " incomplete, "
+                  << m_numDropped << " dropped by backpressure";
+        if (m_numSkipped > 0)
+        {
+            std::cout << ", " << m_numSkipped << " skipped by filter";
+        }
+        std::cout << std::endl;
+        if (m_numDelivered > 0)
+        {
+            std::cout << "Event to consumer latency: mean " << m_totalHandoffUs / m_numDelivered << " us, max "
+                      << m_maxHandoffUs << " us" << std::endl;
+        }
+    }
+
+    unsigned int GetNumDropped()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_numDropped;
+    }
+
+    // Images seen by the event handler, whether queued, skipped or dropped
+    unsigned int GetNumReceived()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_numReceived;
+    }
+
+    // Images waiting for the consumer
+    size_t GetNumQueued()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.size();
+    }
+
+private:
+    // Non-copyable; the camera keeps a reference to the handler
+    ImageEventQueue(const ImageEventQueue&);
+    ImageEventQueue& operator=(const ImageEventQueue&);
+
+    // Returns a free buffer according to the backpressure policy, or -1 to drop the image; called with m_mutex held
+    int AcquireBuffer(std::unique_lock<std::mutex>& lock)
+    {
+        if (m_freeBuffers.empty())
+        {
+            switch (m_policy)
+            {
+            case BACKPRESSURE_DROP_OLDEST:
+                // Take the buffer of the oldest image the consumer has not picked up yet
+                for (std::deque<QueuedImage>::iterator it = m_queue.begin(); it != m_queue.end(); ++it)
+                {
+                    if (it->bufferIndex >= 0)
+                    {
+                        const int bufferIndex = it->bufferIndex;
+                        m_queue.erase(it);
+                        m_numDropped++;
+                        return bufferIndex;
+                    }
+                }
+                return -1;
+
+            case BACKPRESSURE_BLOCK:
+                if (!m_bufferFree.wait_for(
+                        lock, std::chrono::milliseconds(m_blockTimeout), [this] { return !m_freeBuffers.empty(); }))
+                {
+                    return -1;
+                }
+                break;
+
+            case BACKPRESSURE_DROP_NEWEST:
+            default:
+                return -1;
+            }
+        }
+
+        const int bufferIndex = m_freeBuffers.front();
+        m_freeBuffers.pop_front();
+        return bufferIndex;
+    }
+
+    // Copies an image into a buffer of the queue, growing the buffer only when the image size increases
+    static Spinnaker::ImagePtr CopyImage(const Spinnaker::ImagePtr& image, std::vector<unsigned char>& buffer)
+    {
+        const size_t imageSize = image->GetImageSize();
+        if (buffer.size() < imageSize)
+        {
+            buffer.resize(imageSize);
+        }
+        if (imageSize > 0)
+        {
+            memcpy(&buffer[0], image->GetData(), imageSize);
+        }
+
+        return Spinnaker::Image::Create(
+            image->GetWidth(), image->GetHeight(), 0, 0, image->GetPixelFormat(), buffer.empty() ? nullptr : &buffer[0]);
+    }
+
+    std::vector<std::vector<unsigned char>> m_buffers;
+    std::deque<int> m_freeBuffers;
+    std::deque<QueuedImage> m_queue;
+    const backpressurePolicy m_policy;
+    const unsigned int m_blockTimeout;
+    ImageFilter m_filter;
+
+    std::mutex m_mutex;
+    std::condition_variable m_imageReady;
+    std::condition_variable m_bufferFree;
+
+    unsigned int m_numReceived;
+    unsigned int m_numIncomplete;
+    unsigned int m_numDropped;
+    unsigned int m_numSkipped;
+    unsigned int m_numDelivered;
+    int64_t m_totalHandoffUs;
+    int64_t m_maxHandoffUs;
+};
+
+// Registers an image event queue with a camera for the lifetime of this object,
+// so that the handler is unregistered on every path out of the acquisition code.
+// Declare it after the queue so that it is destroyed first.
+class ImageEventRegistration
+{
+public:
+    ImageEventRegistration(Spinnaker::CameraPtr pCam, ImageEventQueue& imageQueue) : m_pCam(pCam), m_imageQueue(imageQueue)
+    {
+        m_pCam->RegisterEventHandler(m_imageQueue);
+    }
+
+    ~ImageEventRegistration()
+    {
+        try
+        {
+            m_pCam->UnregisterEventHandler(m_imageQueue);
+        }
+        catch (Spinnaker::Exception&)
+        {
+        }
+    }
+
+private:
+    ImageEventRegistration(const ImageEventRegistration&);
+    ImageEventRegistration& operator=(const ImageEventRegistration&);
+
+    Spinnaker::CameraPtr m_pCam;
+    ImageEventQueue& m_imageQueue;
+};
+
+#endif // IMAGE_EVENT_QUEUE_H
@@ -0,0 +1,444 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief ProcessingPolicy.h decides which frames of a fast acquisition are
+*  processed, so that the rest can be released without ever being copied,
+*  converted or saved.
+*
+*  A ProcessingPolicy keeps every frame, no frame, every Nth frame, or only
+*  the frames flagged by a cheap metric of the raw buffer. The metric is the
+*  mean intensity and the fraction of saturated pixels of 8-bit and 16-bit
+*  single channel images (mono and Bayer), computed in one pass with AVX2 or
+*  SSE2 on x86 and NEON on ARM for 8-bit images. A frame is flagged when its
+*  mean leaves the expected band, when too many pixels saturate, or when its
+*  mean jumps away from the running mean of the recent frames, which is what
+*  a strobe that fires late or not at all looks like.
+*
+*  FrameSelector applies the policy to each complete image and keeps count
+*  of why frames were kept. Its Select() fits the filter of ImageEventQueue,
+*  which then only copies and queues the kept frames. Typical use:
+*
+*      ProcessingPolicy policy = GetProcessingPolicy(PROCESS_EVERY_NTH);
+*      policy.interval = 50;
+*      FrameSelector selector(policy);
+*      imageQueue.SetFilter([&selector](const ImagePtr& image) { return selector.Select(image); });
+*      ...
+*      selector.PrintStatistics();
+*/
+
+#ifndef PROCESSING_POLICY_H
+#define PROCESSING_POLICY_H
+
+#include "Spinnaker.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#define FRAME_METRIC_AVX2 1
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#define FRAME_METRIC_SSE2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define FRAME_METRIC_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Fraction of full scale at or above which a pixel counts as saturated
+const double k_saturationLevel = 0.98;
+
+// Weight of each new frame in the running mean that jumps are measured against
+const double k_runningMeanWeight = 1.0 / 16.0;
+
+enum processingPolicyType
+{
+    PROCESS_ALL,       // Every frame is processed
+    PROCESS_NONE,      // Every frame is released straight away; only the counts are kept
+    PROCESS_EVERY_NTH, // Every interval-th frame is processed
+    PROCESS_FLAGGED    // Only frames flagged by the intensity metric are processed
+};
+
+// Thresholds are fractions of full scale, so that they apply to 8-bit and 10 to 16-bit formats alike
+struct ProcessingPolicy
+{
+    processingPolicyType type;
+    unsigned int interval;        // PROCESS_EVERY_NTH
+    double minMean;               // PROCESS_FLAGGED: flag frames darker than this
+    double maxMean;               // PROCESS_FLAGGED: flag frames brighter than this
+    double maxSaturatedFraction;  // PROCESS_FLAGGED: flag frames with more saturated pixels than this
+    double maxMeanChange;         // PROCESS_FLAGGED: flag frames whose mean leaves the running mean by more; 0 for off
+};
+
+// Policy of the given type with thresholds that flag little but a strobe failing
+inline ProcessingPolicy GetProcessingPolicy(processingPolicyType type)
+{
+    ProcessingPolicy policy;
+    policy.type = type;
+    policy.interval = 10;
+    policy.minMean = 0.0;
+    policy.maxMean = 1.0;
+    policy.maxSaturatedFraction = 1.0;
+    policy.maxMeanChange = 0.1;
+    return policy;
+}
+
+struct FrameMetric
+{
+    double mean;              // Fraction of full scale
+    double saturatedFraction; // Fraction of pixels at or above k_saturationLevel
+    bool valid;               // False for formats the metric does not cover
+};
+
+// Sums the bytes of a row and counts those at or above threshold
+inline void SumRow8(const uint8_t* row, size_t width, uint8_t threshold, uint64_t& sum, uint64_t& count)
+{
+    size_t x = 0;
+
+#if defined(FRAME_METRIC_AVX2)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i limit = _mm256_set1_epi8(static_cast<char>(threshold));
+        __m256i sums = zero;
+        __m256i counts = zero;
+
+        while (x + 32 <= width)
+        {
+            // The byte counters are flushed every 255 blocks, before they can wrap
+            __m256i blockCounts = zero;
+            for (unsigned int block = 0; block < 255 && x + 32 <= width; block++, x += 32)
+            {
+                const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x));
+                sums = _mm256_add_epi64(sums, _mm256_sad_epu8(pixels, zero));
+                blockCounts = _mm256_sub_epi8(blockCounts, _mm256_cmpeq_epi8(_mm256_max_epu8(pixels, limit), pixels));
+            }
+            counts = _mm256_add_epi64(counts, _mm256_sad_epu8(blockCounts, zero));
+        }
+
+        uint64_t lanes[4];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sums);
+        sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), counts);
+        count += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+#endif
+
+#if defined(FRAME_METRIC_SSE2)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i limit = _mm_set1_epi8(static_cast<char>(threshold));
+        __m128i sums = zero;
+        __m128i counts = zero;
+
+        while (x + 16 <= width)
+        {
+            __m128i blockCounts = zero;
+            for (unsigned int block = 0; block < 255 && x + 16 <= width; block++, x += 16)
+            {
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+                sums = _mm_add_epi64(sums, _mm_sad_epu8(pixels, zero));
+                blockCounts = _mm_sub_epi8(blockCounts, _mm_cmpeq_epi8(_mm_max_epu8(pixels, limit), pixels));
+            }
+            counts = _mm_add_epi64(counts, _mm_sad_epu8(blockCounts, zero));
+        }
+
+        uint64_t lanes[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sums);
+        sum += lanes[0] + lanes[1];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), counts);
+        count += lanes[0] + lanes[1];
+    }
+#elif defined(FRAME_METRIC_NEON)
+    {
+        const uint8x16_t limit = vdupq_n_u8(threshold);
+        uint64x2_t sums = vdupq_n_u64(0);
+        uint64x2_t counts = vdupq_n_u64(0);
+
+        while (x + 16 <= width)
+        {
+            // 16-bit lane sums hold 128 blocks of two bytes each and byte counters 255 blocks
+            uint16x8_t blockSums = vdupq_n_u16(0);
+            uint8x16_t blockCounts = vdupq_n_u8(0);
+            for (unsigned int block = 0; block < 128 && x + 16 <= width; block++, x += 16)
+            {
+                const uint8x16_t pixels = vld1q_u8(row + x);
+                blockSums = vpadalq_u8(blockSums, pixels);
+                blockCounts = vsubq_u8(blockCounts, vcgeq_u8(pixels, limit));
+            }
+            sums = vpadalq_u32(sums, vpaddlq_u16(blockSums));
+            counts = vpadalq_u32(counts, vpaddlq_u16(vpaddlq_u8(blockCounts)));
+        }
+
+        sum += vgetq_lane_u64(sums, 0) + vgetq_lane_u64(sums, 1);
+        count += vgetq_lane_u64(counts, 0) + vgetq_lane_u64(counts, 1);
+    }
+#endif
+
+    for (; x < width; x++)
+    {
+        sum += row[x];
+        count += row[x] >= threshold ? 1 : 0;
+    }
+}
+
+inline void SumRow16(const uint16_t* row, size_t width, uint16_t threshold, uint64_t& sum, uint64_t& count)
+{
+    // The compiler vectorizes this loop; 16-bit lines are rarely fast enough to need more
+    uint64_t rowSum = 0;
+    uint64_t rowCount = 0;
+    for (size_t x = 0; x < width; x++)
+    {
+        rowSum += row[x];
+        rowCount += row[x] >= threshold ? 1 : 0;
+    }
+    sum += rowSum;
+    count += rowCount;
+}
+
+// Number of significant bits per pixel. Mono10/12/14 and the unpacked 10 and 12 bit Bayer
+// formats are held in 16-bit containers, but only reach (1 << validBits) - 1.
+inline unsigned int GetValidBitsPerPixel(const Spinnaker::ImagePtr& image)
+{
+    switch (image->GetPixelFormat())
+    {
+    case Spinnaker::PixelFormat_Mono10:
+    case Spinnaker::PixelFormat_BayerGR10:
+    case Spinnaker::PixelFormat_BayerRG10:
+    case Spinnaker::PixelFormat_BayerGB10:
+    case Spinnaker::PixelFormat_BayerBG10:
+        return 10;
+    case Spinnaker::PixelFormat_Mono12:
+    case Spinnaker::PixelFormat_BayerGR12:
+    case Spinnaker::PixelFormat_BayerRG12:
+    case Spinnaker::PixelFormat_BayerGB12:
+    case Spinnaker::PixelFormat_BayerBG12:
+        return 12;
+    case Spinnaker::PixelFormat_Mono14:
+        return 14;
+    default:
+        return static_cast<unsigned int>(image->GetBitsPerPixel());
+    }
+}
+
+// Computes the metric of an 8-bit or 16-bit single channel image straight from its buffer
+inline FrameMetric ComputeFrameMetric(const Spinnaker::ImagePtr& image)
+{
+    FrameMetric metric;
+    metric.mean = 0.0;
+    metric.saturatedFraction = 0.0;
+    metric.valid = false;
+
+    const size_t bitsPerPixel = image->GetBitsPerPixel();
+    const size_t width = image->GetWidth();
+    const size_t height = image->GetHeight();
+    if (image->GetNumChannels() != 1 || (bitsPerPixel != 8 && bitsPerPixel != 16) || width == 0 || height == 0)
+    {
+        return metric;
+    }
+
+    const size_t stride = image->GetStride() > 0 ? image->GetStride() : width * bitsPerPixel / 8;
+    const uint8_t* data = static_cast<const uint8_t*>(image->GetData());
+    const double fullScale = static_cast<double>((1u << GetValidBitsPerPixel(image)) - 1);
+    uint64_t sum = 0;
+    uint64_t count = 0;
+
+    for (size_t y = 0; y < height; y++)
+    {
+        if (bitsPerPixel == 8)
+        {
+            SumRow8(data + y * stride, width, static_cast<uint8_t>(std::ceil(k_saturationLevel * fullScale)), sum, count);
+        }
+        else
+        {
+            SumRow16(reinterpret_cast<const uint16_t*>(data + y * stride),
+                     width,
+                     static_cast<uint16_t>(std::ceil(k_saturationLevel * fullScale)),
+                     sum,
+                     count);
+        }
+    }
+
+    const double numPixels = static_cast<double>(width) * static_cast<double>(height);
+    metric.mean = static_cast<double>(sum) / numPixels / fullScale;
+    metric.saturatedFraction = static_cast<double>(count) / numPixels;
+    metric.valid = true;
+    return metric;
+}
+
+class FrameSelector
+{
+public:
+    explicit FrameSelector(const ProcessingPolicy& policy)
+        : m_policy(policy), m_numFrames(0), m_numSelected(0), m_numDark(0), m_numBright(0), m_numSaturated(0),
+          m_numJumps(0), m_numUnmeasured(0), m_runningMean(-1.0), m_minMean(1.0), m_maxMean(0.0), m_metricNs(0)
+    {
+    }
+
+    // Name of the instruction set the 8-bit metric was compiled for
+    static const char* GetInstructionSet()
+    {
+#if defined(FRAME_METRIC_AVX2)
+        return "AVX2";
+#elif defined(FRAME_METRIC_SSE2)
+        return "SSE2";
+#elif defined(FRAME_METRIC_NEON)
+        return "NEON";
+#else
+        return "scalar";
+#endif
+    }
+
+    // Returns true if the complete image is to be processed; call it for every frame, in order
+    bool Select(const Spinnaker::ImagePtr& image)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const unsigned int frame = m_numFrames++;
+        bool selected = false;
+
+        switch (m_policy.type)
+        {
+        case PROCESS_ALL:
+            selected = true;
+            break;
+
+        case PROCESS_EVERY_NTH:
+            selected = frame % std::max<unsigned int>(m_policy.interval, 1u) == 0;
+            break;
+
+        case PROCESS_FLAGGED:
+            selected = IsFlagged(image);
+            break;
+
+        case PROCESS_NONE:
+        default:
+            break;
+        }
+
+        if (selected)
+        {
+            m_numSelected++;
+        }
+        return selected;
+    }
+
+    unsigned int GetNumSelected()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_numSelected;
+    }
+
+    void PrintStatistics()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::cout << "Processing policy: " << m_numSelected << " of " << m_numFrames << " frames processed" << std::endl;
+        if (m_policy.type == PROCESS_FLAGGED && m_numFrames > 0)
+        {
+            std::cout << "  Flagged " << m_numDark << " dark, " << m_numBright << " bright, " << m_numSaturated
+                      << " saturated, " << m_numJumps << " jumps";
+            if (m_numUnmeasured > 0)
+            {
+                std::cout << ", " << m_numUnmeasured << " in formats the metric does not cover";
+            }
+            std::cout << std::endl;
+
+            const unsigned int numMeasured = m_numFrames - m_numUnmeasured;
+            if (numMeasured > 0)
+            {
+                std::cout << "  Mean intensity " << static_cast<int>(m_minMean * 100.0 + 0.5) << "% to "
+                          << static_cast<int>(m_maxMean * 100.0 + 0.5) << "% of full scale, "
+                          << m_metricNs / numMeasured / 1000 << " us per frame (" << GetInstructionSet() << ")"
+                          << std::endl;
+            }
+        }
+    }
+
+private:
+    // Called with m_mutex held
+    bool IsFlagged(const Spinnaker::ImagePtr& image)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const FrameMetric metric = ComputeFrameMetric(image);
+
+        if (!metric.valid)
+        {
+            // Frames that cannot be measured are kept rather than silently dropped
+            m_numUnmeasured++;
+            return true;
+        }
+        m_metricNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        m_minMean = std::min<double>(m_minMean, metric.mean);
+        m_maxMean = std::max<double>(m_maxMean, metric.mean);
+
+        bool flagged = false;
+        if (metric.mean < m_policy.minMean)
+        {
+            m_numDark++;
+            flagged = true;
+        }
+        if (metric.mean > m_policy.maxMean)
+        {
+            m_numBright++;
+            flagged = true;
+        }
+        if (metric.saturatedFraction > m_policy.maxSaturatedFraction)
+        {
+            m_numSaturated++;
+            flagged = true;
+        }
+        if (m_policy.maxMeanChange > 0.0 && m_runningMean >= 0.0 &&
+            std::fabs(metric.mean - m_runningMean) > m_policy.maxMeanChange)
+        {
+            m_numJumps++;
+            flagged = true;
+        }
+
+        // A flagged frame does not move the running mean, so a failing strobe stays flagged
+        if (m_runningMean < 0.0)
+        {
+            m_runningMean = metric.mean;
+        }
+        else if (!flagged)
+        {
+            m_runningMean += (metric.mean - m_runningMean) * k_runningMeanWeight;
+        }
+        return flagged;
+    }
+
+    const ProcessingPolicy m_policy;
+    std::mutex m_mutex;
+    unsigned int m_numFrames;
+    unsigned int m_numSelected;
+    unsigned int m_numDark;
+    unsigned int m_numBright;
+    unsigned int m_numSaturated;
+    unsigned int m_numJumps;
+    unsigned int m_numUnmeasured;
+    double m_runningMean;
+    double m_minMean;
+    double m_maxMean;
+    int64_t m_metricNs;
+};
+
+#endif // PROCESSING_POLICY_H
@@ -0,0 +1,451 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief RawRecorder.h records raw sensor buffers into a single multi-frame
+*  container file, so that the grab thread only copies bytes to disk and the
+*  conversion/encoding can be done offline (see RawToProcessed.cpp).
+*
+*  Container layout (all fields little-endian as written by the host):
+*    RawContainerHeader            padded to k_rawContainerAlignment bytes
+*    frame 0 data                  padded to k_rawContainerAlignment bytes
+*    frame 1 data                  ...
+*    RawContainerIndexEntry[frameCount], starting at header.indexOffset
+*
+*  Frames are staged into one aligned block and written to disk a whole block
+*  at a time, and the file is preallocated for the expected number and size
+*  of frames when it is opened, before acquisition, so that the grab thread
+*  never waits for the file to be extended. The header and index are written by Close();
+*  until then the header's frameCount is 0.
+*/
+
+#ifndef RAW_RECORDER_H
+#define RAW_RECORDER_H
+
+#include "Spinnaker.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Identifies a raw container file and its layout version
+const char k_rawContainerMagic[8] = { 'S', 'P', 'N', 'R', 'A', 'W', '0', '1' };
+const uint32_t k_rawContainerVersion = 1;
+
+// Frame data offsets (and the size of every disk write) are multiples of this
+const size_t k_rawContainerAlignment = 4096;
+
+// Size of the staging block that frames are gathered into before being written
+const size_t k_rawContainerBlockSize = 4 * 1024 * 1024;
+
+#pragma pack(push, 1)
+struct RawContainerHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t frameCount;
+    uint64_t indexOffset;
+};
+
+struct RawContainerIndexEntry
+{
+    uint64_t frameID;
+    uint64_t timestamp;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pixelFormat;
+    uint32_t reserved;
+};
+#pragma pack(pop)
+
+inline uint64_t AlignRawContainerOffset(uint64_t value)
+{
+    return (value + k_rawContainerAlignment - 1) / k_rawContainerAlignment * k_rawContainerAlignment;
+}
+
+// Parse the header and index of a container held in memory (for example a mapped file).
+// Returns false if the data is not a complete container.
+inline bool ReadRawContainerIndex(const unsigned char* data, size_t size, std::vector<RawContainerIndexEntry>& index)
+{
+    index.clear();
+
+    if (data == NULL || size < sizeof(RawContainerHeader))
+    {
+        return false;
+    }
+
+    RawContainerHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, k_rawContainerMagic, sizeof(header.magic)) != 0 || header.version != k_rawContainerVersion)
+    {
+        return false;
+    }
+
+    if (header.indexOffset > size || header.frameCount > (size - header.indexOffset) / sizeof(RawContainerIndexEntry))
+    {
+        return false;
+    }
+
+    index.resize(static_cast<size_t>(header.frameCount));
+    if (!index.empty())
+    {
+        memcpy(&index[0], data + header.indexOffset, index.size() * sizeof(RawContainerIndexEntry));
+    }
+
+    for (size_t i = 0; i < index.size(); i++)
+    {
+        if (index[i].offset > size || index[i].size > size - index[i].offset)
+        {
+            index.clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Checks that an index entry holds at least the bytes of the image it describes, so that a
+// truncated or corrupt entry is not read past its end. The bits per pixel of the pixel format
+// are taken from a small image of that format; unknown formats are rejected.
+inline bool RawContainerEntryHoldsImage(const RawContainerIndexEntry& entry)
+{
+    try
+    {
+        Spinnaker::ImagePtr probe =
+            Spinnaker::Image::Create(8, 8, 0, 0, static_cast<Spinnaker::PixelFormatEnums>(entry.pixelFormat));
+        const uint64_t imageBits = static_cast<uint64_t>(entry.width) * entry.height * probe->GetBitsPerPixel();
+        return probe->GetBitsPerPixel() > 0 && entry.size >= (imageBits + 7) / 8;
+    }
+    catch (Spinnaker::Exception&)
+    {
+        return false;
+    }
+}
+
+// Appends raw images to a container file through large aligned writes
+class RawRecorder
+{
+public:
+    RawRecorder() : m_file(NULL), m_fileOffset(0), m_blockUsed(0) {}
+
+    ~RawRecorder()
+    {
+        Close();
+    }
+
+    // Create the container. The file is preallocated here for expectedFrames images of up to
+    // expectedFrameSize bytes, so that Append() never extends it; either may be 0 to skip that.
+    bool Open(const std::string& filepath, uint64_t expectedFrames, uint64_t expectedFrameSize = 0)
+    {
+        Close();
+
+        m_file = fopen(filepath.c_str(), "wb");
+        if (m_file == NULL)
+        {
+            return false;
+        }
+
+        // Writes are already block sized, so bypass the stdio buffer
+        setvbuf(m_file, NULL, _IONBF, 0);
+
+        m_index.clear();
+        m_index.reserve(static_cast<size_t>(expectedFrames));
+        m_block.assign(k_rawContainerBlockSize + k_rawContainerAlignment, 0);
+        m_fileOffset = 0;
+
+        // Space for the header is reserved up front and filled in by Close()
+        m_blockUsed = static_cast<size_t>(AlignRawContainerOffset(sizeof(RawContainerHeader)));
+        memset(GetBlock(), 0, m_blockUsed);
+
+        Preallocate(expectedFrames, expectedFrameSize);
+
+        return true;
+    }
+
+    // Copy the raw buffer of an image into the container
+    bool Append(const Spinnaker::ImagePtr& pImage, uint64_t frameID, uint64_t timestamp)
+    {
+        if (m_file == NULL)
+        {
+            return false;
+        }
+
+        const unsigned char* data = static_cast<const unsigned char*>(pImage->GetData());
+        const size_t size = pImage->GetImageSize();
+
+        RawContainerIndexEntry entry;
+        entry.frameID = frameID;
+        entry.timestamp = timestamp;
+        entry.offset = m_fileOffset + m_blockUsed;
+        entry.size = size;
+        entry.width = static_cast<uint32_t>(pImage->GetWidth());
+        entry.height = static_cast<uint32_t>(pImage->GetHeight());
+        entry.pixelFormat = static_cast<uint32_t>(pImage->GetPixelFormat());
+        entry.reserved = 0;
+
+        if (!Write(data, size) || !Pad())
+        {
+            return false;
+        }
+
+        m_index.push_back(entry);
+        return true;
+    }
+
+    // Write the index and header, trim any unused preallocated space and close the file
+    bool Close()
+    {
+        if (m_file == NULL)
+        {
+            return true;
+        }
+
+        RawContainerHeader header;
+        memcpy(header.magic, k_rawContainerMagic, sizeof(header.magic));
+        header.version = k_rawContainerVersion;
+        header.headerSize = sizeof(RawContainerHeader);
+        header.frameCount = m_index.size();
+        header.indexOffset = m_fileOffset + m_blockUsed;
+
+        bool success = true;
+        if (!m_index.empty())
+        {
+            success = Write(reinterpret_cast<const unsigned char*>(&m_index[0]), m_index.size() * sizeof(RawContainerIndexEntry));
+        }
+
+        // The final block is written out whole and the excess trimmed below
+        const uint64_t fileSize = m_fileOffset + m_blockUsed;
+        success = success && FlushBlock(AlignRawContainerOffset(m_blockUsed));
+        success = success && Truncate(fileSize);
+
+        success = success && fseek(m_file, 0, SEEK_SET) == 0;
+        success = success && fwrite(&header, sizeof(header), 1, m_file) == 1;
+
+        fclose(m_file);
+        m_file = NULL;
+        m_block.clear();
+
+        return success;
+    }
+
+    uint64_t GetFrameCount() const
+    {
+        return m_index.size();
+    }
+
+    uint64_t GetBytesWritten() const
+    {
+        return m_fileOffset + m_blockUsed;
+    }
+
+private:
+    // Non-copyable; the recorder owns the file handle
+    RawRecorder(const RawRecorder&);
+    RawRecorder& operator=(const RawRecorder&);
+
+    // Start of the staging block, aligned so that writes come from aligned memory
+    unsigned char* GetBlock()
+    {
+        uintptr_t address = reinterpret_cast<uintptr_t>(&m_block[0]);
+        return &m_block[0] + (AlignRawContainerOffset(address) - address);
+    }
+
+    bool Write(const unsigned char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            const size_t count = std::min<size_t>(size, k_rawContainerBlockSize - m_blockUsed);
+            memcpy(GetBlock() + m_blockUsed, data, count);
+            m_blockUsed += count;
+            data += count;
+            size -= count;
+
+            if (m_blockUsed == k_rawContainerBlockSize && !FlushBlock(k_rawContainerBlockSize))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Zero-fill up to the next aligned offset so the next frame starts aligned
+    bool Pad()
+    {
+        const size_t padding = static_cast<size_t>(AlignRawContainerOffset(m_blockUsed) - m_blockUsed);
+        memset(GetBlock() + m_blockUsed, 0, padding);
+        m_blockUsed += padding;
+
+        if (m_blockUsed == k_rawContainerBlockSize)
+        {
+            return FlushBlock(k_rawContainerBlockSize);
+        }
+        return true;
+    }
+
+    bool FlushBlock(uint64_t writeSize)
+    {
+        if (writeSize == 0)
+        {
+            return true;
+        }
+
+        memset(GetBlock() + m_blockUsed, 0, static_cast<size_t>(writeSize - m_blockUsed));
+
+        if (fwrite(GetBlock(), 1, static_cast<size_t>(writeSize), m_file) != writeSize)
+        {
+            return false;
+        }
+
+        m_fileOffset += m_blockUsed;
+        m_blockUsed = 0;
+        return true;
+    }
+
+    // Reserve the whole recording on disk so it is not extended on every write. On Windows this
+    // zero-fills the file, which is why it is done when the container is opened.
+    void Preallocate(uint64_t expectedFrames, uint64_t frameSize)
+    {
+        if (expectedFrames == 0 || frameSize == 0)
+        {
+            return;
+        }
+
+        const uint64_t totalSize = AlignRawContainerOffset(sizeof(RawContainerHeader)) +
+            expectedFrames * AlignRawContainerOffset(frameSize) +
+            AlignRawContainerOffset(expectedFrames * sizeof(RawContainerIndexEntry));
+
+        // Extending the file does not move the write position
+        Truncate(totalSize);
+    }
+
+    bool Truncate(uint64_t size)
+    {
+        fflush(m_file);
+#ifdef _WIN32
+        return _chsize_s(_fileno(m_file), static_cast<__int64>(size)) == 0;
+#else
+        return ftruncate(fileno(m_file), static_cast<off_t>(size)) == 0;
+#endif
+    }
+
+    FILE* m_file;
+    uint64_t m_fileOffset;
+    std::vector<unsigned char> m_block;
+    size_t m_blockUsed;
+    std::vector<RawContainerIndexEntry> m_index;
+};
+
+// Selects whether an example converts and saves each image as a jpeg on the
+// grab thread, or appends its raw buffer to a single container file to be
+// converted later by RawToProcessed
+enum recordingType
+{
+    SAVE_JPEG,
+    RAW_CONTAINER
+};
+
+// The container recording of one example run, named
+// <prefix>-<serial number>-recording.spnraw. Every step is reported on the
+// console, and Open() and Close() do nothing when the images are saved as
+// jpegs instead.
+class RawRecording
+{
+public:
+    explicit RawRecording(recordingType type) : m_type(type) {}
+
+    // Create and preallocate the container for expectedFrames images of up to expectedFrameSize
+    // bytes, such as the camera's PayloadSize; call it before the images are grabbed
+    bool Open(const std::string& prefix, const std::string& serialNumber, uint64_t expectedFrames, uint64_t expectedFrameSize)
+    {
+        if (m_type != RAW_CONTAINER)
+        {
+            return true;
+        }
+
+        m_name = prefix + "-";
+        if (!serialNumber.empty())
+        {
+            m_name += serialNumber + "-";
+        }
+        m_name += "recording.spnraw";
+
+        if (!m_recorder.Open(m_name, expectedFrames, expectedFrameSize))
+        {
+            std::cout << "Unable to create " << m_name << ". Aborting..." << std::endl << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool IsRaw() const
+    {
+        return m_type == RAW_CONTAINER;
+    }
+
+    // Append the raw buffer; conversion is deferred to RawToProcessed
+    bool Record(const Spinnaker::ImagePtr& pImage, uint64_t frameID, uint64_t timestamp, bool verbose = true)
+    {
+        if (!m_recorder.Append(pImage, frameID, timestamp))
+        {
+            std::cout << "Unable to write image to " << m_name << "..." << std::endl;
+            return false;
+        }
+        if (verbose)
+        {
+            std::cout << "Image recorded to " << m_name << std::endl;
+        }
+        return true;
+    }
+
+    // Write the container index
+    bool Close()
+    {
+        if (m_type != RAW_CONTAINER)
+        {
+            return true;
+        }
+
+        const uint64_t framesRecorded = m_recorder.GetFrameCount();
+        if (!m_recorder.Close())
+        {
+            std::cout << "Unable to finish writing " << m_name << "..." << std::endl;
+            return false;
+        }
+        std::cout << framesRecorded << " images recorded to " << m_name << std::endl;
+        return true;
+    }
+
+private:
+    recordingType m_type;
+    std::string m_name;
+    RawRecorder m_recorder;
+};
+
+#endif // RAW_RECORDER_H
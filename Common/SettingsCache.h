@@ -0,0 +1,776 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief SettingsCache.h applies a profile of GenICam node values to a camera
+*  while writing only the nodes whose value differs from the camera's.
+*
+*  A SettingsProfile is an ordered list of enumeration, boolean, integer and
+*  float settings, in the order the nodes must be written. Selectors such as
+*  LineSelector are listed with Select(); the settings after them apply to
+*  the selected item. SettingsCache reads the current value of every setting
+*  once, compares it with the profile and writes only what changed. Every
+*  value is kept under the items of the selectors that select its node, as
+*  reported by the node map, so LUTOutputValueAll of one logic block is never
+*  taken for that of another. A selector is only written when a setting under
+*  it has to be read or written, and only if it is not on that item already.
+*  Selections only last for the Apply() call they are listed in.
+*
+*  With a snapshot prefix, the values the camera holds after Save() are kept
+*  in a file per serial number, together with the camera timestamp at that
+*  point. On the next start the snapshot replaces the read pass, so a camera
+*  that is already configured costs one timestamp latch instead of a read of
+*  every node. The snapshot is discarded when the camera timestamp has gone
+*  backwards since it was taken (the camera was restarted), when a write
+*  fails, or on Invalidate(). It cannot see changes made by other
+*  applications, so only use it for cameras this application alone
+*  configures. Typical use:
+*
+*      SettingsProfile settings;
+*      settings.SetEnum("ExposureAuto", "Off").SetFloat("ExposureTime", 50000.0);
+*      SettingsCache cache(pCam, profile, "Example-settings-");
+*      SettingsApplyResult result;
+*      cache.Apply(settings, result);
+*      PrintSettingsResult(result);
+*      cache.Save();
+*/
+
+#ifndef SETTINGS_CACHE_H
+#define SETTINGS_CACHE_H
+
+#include "Spinnaker.h"
+#include "SpinGenApi/SpinnakerGenApi.h"
+#include "CameraProfile.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+// Float settings within this fraction of the profile value count as unchanged, since
+// nodes such as ExposureTime round the value written to what the sensor can do
+const double k_settingsFloatTolerance = 1e-3;
+
+// Snapshots written with another key layout are discarded
+const int64_t k_settingsSnapshotVersion = 2;
+
+enum settingType
+{
+    SETTING_ENUM,
+    SETTING_BOOL,
+    SETTING_INT,
+    SETTING_FLOAT
+};
+
+// What applying a setting did
+enum settingOutcome
+{
+    SETTING_UNCHANGED,  // read from the camera and already right
+    SETTING_CACHED,     // already right according to what is known of the camera; not read
+    SETTING_WRITTEN,    // written
+    SETTING_UNAVAILABLE // optional setting the camera does not have
+};
+
+struct NodeSetting
+{
+    std::string name;
+    std::string value;
+    settingType type;
+    bool selector;
+    bool required;
+    bool clamp;
+};
+
+class SettingsProfile
+{
+public:
+    // Selects the item, e.g. a line or a chunk, that the settings after it apply to
+    SettingsProfile& Select(const std::string& name, const std::string& entry)
+    {
+        return Add(name, entry, SETTING_ENUM, true, true, false);
+    }
+
+    // Settings that are not required are skipped on cameras that do not have the node
+    SettingsProfile& SetEnum(const std::string& name, const std::string& entry, bool required = true)
+    {
+        return Add(name, entry, SETTING_ENUM, false, required, false);
+    }
+
+    SettingsProfile& SetBool(const std::string& name, bool value, bool required = true)
+    {
+        return Add(name, value ? "true" : "false", SETTING_BOOL, false, required, false);
+    }
+
+    SettingsProfile& SetInt(const std::string& name, int64_t value, bool required = true)
+    {
+        std::ostringstream text;
+        text << value;
+        return Add(name, text.str(), SETTING_INT, false, required, false);
+    }
+
+    // With clamp set, the value is limited to the current range of the node instead of failing
+    SettingsProfile& SetFloat(const std::string& name, double value, bool required = true, bool clamp = false)
+    {
+        return Add(name, FormatFloat(value), SETTING_FLOAT, false, required, clamp);
+    }
+
+    const std::vector<NodeSetting>& GetSettings() const
+    {
+        return m_settings;
+    }
+
+    static std::string FormatFloat(double value)
+    {
+        std::ostringstream text;
+        text << std::setprecision(12) << value;
+        return text.str();
+    }
+
+private:
+    SettingsProfile& Add(
+        const std::string& name,
+        const std::string& value,
+        settingType type,
+        bool selector,
+        bool required,
+        bool clamp)
+    {
+        NodeSetting setting;
+        setting.name = name;
+        setting.value = value;
+        setting.type = type;
+        setting.selector = selector;
+        setting.required = required;
+        setting.clamp = clamp;
+        m_settings.push_back(setting);
+        return *this;
+    }
+
+    std::vector<NodeSetting> m_settings;
+};
+
+// Outcome of one setting, as printed by PrintSettingsResult()
+struct SettingRecord
+{
+    std::string name;
+    std::string value;
+    settingOutcome outcome;
+};
+
+// Outcome of applying one profile
+struct SettingsApplyResult
+{
+    Spinnaker::GenICam::gcstring serialNumber;
+    bool success;
+    std::string error;
+    bool usedSnapshot;
+    unsigned int numRead;
+    unsigned int numWritten;
+    unsigned int numCached;
+    unsigned int numUnavailable;
+    double seconds;
+    std::vector<SettingRecord> records;
+};
+
+class SettingsCache
+{
+public:
+    // The camera must be initialized and the profile resolved after Init(). With an empty
+    // snapshot prefix every setting is read from the camera and nothing is persisted.
+    SettingsCache(Spinnaker::CameraPtr pCam, const CameraProfile& profile, const std::string& snapshotPrefix = "")
+        : m_nodeMap(pCam->GetNodeMap()), m_profile(profile), m_usedSnapshot(false), m_failed(false)
+    {
+        if (!snapshotPrefix.empty() && !profile.serialNumber.empty())
+        {
+            m_snapshotFileName = snapshotPrefix + profile.serialNumber.c_str() + ".txt";
+            m_usedSnapshot = LoadSnapshot();
+        }
+    }
+
+    // True if the values of an earlier run were trusted instead of reading the camera
+    bool UsedSnapshot() const
+    {
+        return m_usedSnapshot;
+    }
+
+    // Applies a profile on top of everything applied so far; stops at the first required setting that fails
+    bool Apply(const SettingsProfile& settings, SettingsApplyResult& result)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        // A profile only selects the items it lists itself
+        m_selectors.clear();
+
+        result = SettingsApplyResult();
+        result.serialNumber = m_profile.serialNumber;
+        result.success = true;
+        result.usedSnapshot = m_usedSnapshot;
+
+        const std::vector<NodeSetting>& list = settings.GetSettings();
+        try
+        {
+            for (size_t i = 0; i < list.size() && result.success; i++)
+            {
+                if (list[i].selector)
+                {
+                    SetPendingSelector(list[i]);
+                }
+                else
+                {
+                    result.success = ApplySetting(list[i], result);
+                }
+            }
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            result.error = e.what();
+            result.success = false;
+        }
+
+        if (!result.success)
+        {
+            m_failed = true;
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result.success;
+    }
+
+    // Persists what is known of the camera for the next start; a session in which a
+    // setting failed removes the snapshot instead, since the camera state is then unknown
+    bool Save()
+    {
+        if (m_snapshotFileName.empty())
+        {
+            return false;
+        }
+
+        int64_t timestamp = 0;
+        if (m_failed || !LatchTimestamp(timestamp))
+        {
+            Invalidate();
+            return false;
+        }
+
+        std::ofstream file(m_snapshotFileName.c_str(), std::ios::trunc);
+        file << "version\t" << k_settingsSnapshotVersion << std::endl;
+        file << "serial\t" << m_profile.serialNumber << std::endl;
+        file << "timestamp\t" << timestamp << std::endl;
+        for (std::map<std::string, std::string>::const_iterator it = m_known.begin(); it != m_known.end(); ++it)
+        {
+            file << it->first << "\t" << it->second << std::endl;
+        }
+        return file.good();
+    }
+
+    // Forgets the snapshot, e.g. after the camera has been reset to its defaults
+    void Invalidate()
+    {
+        m_known.clear();
+        if (!m_snapshotFileName.empty())
+        {
+            remove(m_snapshotFileName.c_str());
+        }
+    }
+
+private:
+    SettingsCache(const SettingsCache&);
+    SettingsCache& operator=(const SettingsCache&);
+
+    // Selectors that select a node, outermost first, e.g. LogicBlockSelector then LogicBlockLUTSelector
+    const std::vector<std::string>& GetSelectingFeatures(const std::string& name)
+    {
+        std::map<std::string, std::vector<std::string> >::const_iterator it = m_selecting.find(name);
+        if (it != m_selecting.end())
+        {
+            return it->second;
+        }
+
+        std::vector<std::string> selecting;
+        AddSelectingFeatures(name, selecting, 0);
+        return m_selecting[name] = selecting;
+    }
+
+    void AddSelectingFeatures(const std::string& name, std::vector<std::string>& selecting, unsigned int depth) const
+    {
+        using namespace Spinnaker::GenApi;
+
+        Spinnaker::GenApi::INode* pNode = m_nodeMap.GetNode(name.c_str());
+        if (pNode == nullptr || depth > 8)
+        {
+            return;
+        }
+
+        FeatureList_t features;
+        pNode->GetSelectingFeatures(features);
+        for (size_t i = 0; i < features.size(); i++)
+        {
+            if (features[i] == nullptr || features[i]->GetNode() == nullptr)
+            {
+                continue;
+            }
+
+            // A selector's own selectors have to be on their item before it is
+            const std::string selector = features[i]->GetNode()->GetName().c_str();
+            AddSelectingFeatures(selector, selecting, depth + 1);
+            if (std::find(selecting.begin(), selecting.end(), selector) == selecting.end())
+            {
+                selecting.push_back(selector);
+            }
+        }
+    }
+
+    //
+    // Collects the selectors that select a setting's node and the items they are to be on
+    //
+    // *** NOTES ***
+    // A selector listed in the profile is to be on the listed item. One that the profile does
+    // not list stays where the camera has it, which is read once, so that the key still tells
+    // the items apart. A node without selectors is keyed by its name alone, whatever the
+    // profile has selected before it.
+    //
+    void GetSelection(const std::string& name, std::vector<std::pair<std::string, std::string> >& selection, SettingsApplyResult& result)
+    {
+        using namespace Spinnaker::GenApi;
+
+        selection.clear();
+        const std::vector<std::string>& selecting = GetSelectingFeatures(name);
+        for (size_t i = 0; i < selecting.size(); i++)
+        {
+            const std::string& selector = selecting[i];
+            std::string entry;
+
+            for (size_t j = 0; j < m_selectors.size() && entry.empty(); j++)
+            {
+                if (m_selectors[j].first == selector)
+                {
+                    entry = m_selectors[j].second;
+                }
+            }
+
+            if (entry.empty())
+            {
+                std::map<std::string, std::string>::const_iterator known = m_known.find(selector);
+                if (known != m_known.end())
+                {
+                    entry = known->second;
+                }
+                else
+                {
+                    CValuePtr ptrSelector = m_nodeMap.GetNode(selector.c_str());
+                    if (!IsAvailable(ptrSelector) || !IsReadable(ptrSelector))
+                    {
+                        continue;
+                    }
+                    entry = ptrSelector->ToString().c_str();
+                    result.numRead++;
+                    m_known[selector] = entry;
+                }
+            }
+
+            selection.push_back(std::make_pair(selector, entry));
+        }
+    }
+
+    // Key of a setting under the items of its selectors, e.g. "LineSelector=Line2;LineMode"
+    static std::string GetKey(const std::string& name, const std::vector<std::pair<std::string, std::string> >& selection)
+    {
+        std::string key;
+        for (size_t i = 0; i < selection.size(); i++)
+        {
+            key += selection[i].first + "=" + selection[i].second + ";";
+        }
+        return key + name;
+    }
+
+    void SetPendingSelector(const NodeSetting& setting)
+    {
+        for (size_t i = 0; i < m_selectors.size(); i++)
+        {
+            if (m_selectors[i].first == setting.name)
+            {
+                m_selectors[i].second = setting.value;
+                return;
+            }
+        }
+        m_selectors.push_back(std::make_pair(setting.name, setting.value));
+    }
+
+    // Puts the selectors of a setting on their items before the setting is read or written
+    bool ApplySelectors(const std::vector<std::pair<std::string, std::string> >& selection, SettingsApplyResult& result)
+    {
+        using namespace Spinnaker::GenApi;
+
+        for (size_t i = 0; i < selection.size(); i++)
+        {
+            const std::string& name = selection[i].first;
+            const std::string& entry = selection[i].second;
+
+            std::map<std::string, std::string>::const_iterator known = m_known.find(name);
+            if (known != m_known.end() && known->second == entry)
+            {
+                continue;
+            }
+
+            CEnumerationPtr ptrSelector = m_nodeMap.GetNode(name.c_str());
+            if (!IsAvailable(ptrSelector) || !IsWritable(ptrSelector))
+            {
+                result.error = name + " not writable";
+                return false;
+            }
+
+            if (known == m_known.end())
+            {
+                result.numRead++;
+                if (ptrSelector->GetCurrentEntry()->GetSymbolic() == entry.c_str())
+                {
+                    m_known[name] = entry;
+                    continue;
+                }
+            }
+
+            CEnumEntryPtr ptrEntry = ptrSelector->GetEntryByName(entry.c_str());
+            if (!IsAvailable(ptrEntry) || !IsReadable(ptrEntry))
+            {
+                result.error = name + " has no entry " + entry;
+                return false;
+            }
+
+            ptrSelector->SetIntValue(ptrEntry->GetValue());
+            result.numWritten++;
+            m_known[name] = entry;
+        }
+        return true;
+    }
+
+    bool ApplySetting(const NodeSetting& setting, SettingsApplyResult& result)
+    {
+        using namespace Spinnaker::GenApi;
+
+        std::vector<std::pair<std::string, std::string> > selection;
+        GetSelection(setting.name, selection, result);
+
+        const std::string key = GetKey(setting.name, selection);
+        SettingRecord record;
+        record.name = setting.name;
+        record.value = setting.value;
+
+        std::map<std::string, std::string>::const_iterator known = m_known.find(key);
+        if (known != m_known.end() && Matches(setting, known->second))
+        {
+            record.outcome = SETTING_CACHED;
+            result.numCached++;
+            result.records.push_back(record);
+            return true;
+        }
+
+        if (!ApplySelectors(selection, result))
+        {
+            return false;
+        }
+
+        CValuePtr ptrValue = m_nodeMap.GetNode(setting.name.c_str());
+        if (known == m_known.end())
+        {
+            if (!IsAvailable(ptrValue) || !IsReadable(ptrValue))
+            {
+                return Unavailable(setting, record, result);
+            }
+
+            const std::string current = ReadValue(setting, ptrValue);
+            result.numRead++;
+            m_known[key] = current;
+
+            if (Matches(setting, current))
+            {
+                record.outcome = SETTING_UNCHANGED;
+                result.records.push_back(record);
+                return true;
+            }
+        }
+
+        if (!IsAvailable(ptrValue) || !IsWritable(ptrValue))
+        {
+            return Unavailable(setting, record, result);
+        }
+
+        // A clamped float that is already at the limit of its range needs no write either
+        NodeSetting target = setting;
+        if (setting.type == SETTING_FLOAT && setting.clamp)
+        {
+            CFloatPtr ptrFloat = ptrValue;
+            const double value = std::min<double>(std::max<double>(ParseFloat(setting.value), ptrFloat->GetMin()), ptrFloat->GetMax());
+            target.value = SettingsProfile::FormatFloat(value);
+            target.clamp = false;
+
+            if (m_known.count(key) != 0 && Matches(target, m_known[key]))
+            {
+                record.value = target.value;
+                record.outcome = known == m_known.end() ? SETTING_UNCHANGED : SETTING_CACHED;
+                result.numCached += record.outcome == SETTING_CACHED ? 1 : 0;
+                result.records.push_back(record);
+                return true;
+            }
+        }
+
+        std::string written = target.value;
+        if (!WriteValue(target, ptrValue, written, result))
+        {
+            return false;
+        }
+
+        record.value = written;
+        record.outcome = SETTING_WRITTEN;
+        result.numWritten++;
+        m_known[key] = written;
+        result.records.push_back(record);
+        return true;
+    }
+
+    static bool Unavailable(const NodeSetting& setting, SettingRecord& record, SettingsApplyResult& result)
+    {
+        if (setting.required)
+        {
+            result.error = setting.name + " not available";
+            return false;
+        }
+
+        record.outcome = SETTING_UNAVAILABLE;
+        result.numUnavailable++;
+        result.records.push_back(record);
+        return true;
+    }
+
+    static std::string ReadValue(const NodeSetting& setting, Spinnaker::GenApi::CValuePtr ptrValue)
+    {
+        using namespace Spinnaker::GenApi;
+
+        std::ostringstream text;
+        switch (setting.type)
+        {
+        case SETTING_ENUM:
+        {
+            CEnumerationPtr ptrEnumeration = ptrValue;
+            text << ptrEnumeration->GetCurrentEntry()->GetSymbolic();
+            break;
+        }
+        case SETTING_BOOL:
+        {
+            CBooleanPtr ptrBoolean = ptrValue;
+            text << (ptrBoolean->GetValue() ? "true" : "false");
+            break;
+        }
+        case SETTING_INT:
+        {
+            CIntegerPtr ptrInteger = ptrValue;
+            text << ptrInteger->GetValue();
+            break;
+        }
+        case SETTING_FLOAT:
+        default:
+        {
+            CFloatPtr ptrFloat = ptrValue;
+            return SettingsProfile::FormatFloat(ptrFloat->GetValue());
+        }
+        }
+        return text.str();
+    }
+
+    // Writes the setting; written receives the value as it is kept in the snapshot
+    static bool WriteValue(
+        const NodeSetting& setting,
+        Spinnaker::GenApi::CValuePtr ptrValue,
+        std::string& written,
+        SettingsApplyResult& result)
+    {
+        using namespace Spinnaker::GenApi;
+
+        switch (setting.type)
+        {
+        case SETTING_ENUM:
+        {
+            CEnumerationPtr ptrEnumeration = ptrValue;
+            CEnumEntryPtr ptrEntry = ptrEnumeration->GetEntryByName(setting.value.c_str());
+            if (!IsAvailable(ptrEntry) || !IsReadable(ptrEntry))
+            {
+                result.error = setting.name + " has no entry " + setting.value;
+                return false;
+            }
+            ptrEnumeration->SetIntValue(ptrEntry->GetValue());
+            break;
+        }
+        case SETTING_BOOL:
+        {
+            CBooleanPtr ptrBoolean = ptrValue;
+            ptrBoolean->SetValue(setting.value == "true");
+            break;
+        }
+        case SETTING_INT:
+        {
+            CIntegerPtr ptrInteger = ptrValue;
+            ptrInteger->SetValue(ParseInt(setting.value));
+            break;
+        }
+        case SETTING_FLOAT:
+        default:
+        {
+            CFloatPtr ptrFloat = ptrValue;
+            const double value = ParseFloat(setting.value);
+            ptrFloat->SetValue(value);
+            written = SettingsProfile::FormatFloat(value);
+            break;
+        }
+        }
+        return true;
+    }
+
+    static bool Matches(const NodeSetting& setting, const std::string& current)
+    {
+        switch (setting.type)
+        {
+        case SETTING_INT:
+            return ParseInt(current) == ParseInt(setting.value);
+        case SETTING_FLOAT:
+        {
+            const double desired = ParseFloat(setting.value);
+            return std::fabs(ParseFloat(current) - desired) <= k_settingsFloatTolerance * std::max<double>(std::fabs(desired), 1.0);
+        }
+        default:
+            return current == setting.value;
+        }
+    }
+
+    static int64_t ParseInt(const std::string& text)
+    {
+        std::istringstream stream(text);
+        int64_t value = 0;
+        stream >> value;
+        return value;
+    }
+
+    static double ParseFloat(const std::string& text)
+    {
+        std::istringstream stream(text);
+        double value = 0.0;
+        stream >> value;
+        return value;
+    }
+
+    bool LatchTimestamp(int64_t& timestamp) const
+    {
+        using namespace Spinnaker::GenApi;
+
+        if (!m_profile.resolvedNodes || !IsAvailable(m_profile.ptrTimestampLatch) ||
+            !IsWritable(m_profile.ptrTimestampLatch) || !IsAvailable(m_profile.ptrTimestampValue) ||
+            !IsReadable(m_profile.ptrTimestampValue))
+        {
+            return false;
+        }
+
+        m_profile.ptrTimestampLatch->Execute();
+        timestamp = m_profile.ptrTimestampValue->GetValue();
+        return true;
+    }
+
+    // Loads the snapshot of this camera if the camera has not been restarted since it was saved
+    bool LoadSnapshot()
+    {
+        std::ifstream file(m_snapshotFileName.c_str());
+        if (!file)
+        {
+            return false;
+        }
+
+        std::map<std::string, std::string> values;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            const size_t tab = line.find('\t');
+            if (tab != std::string::npos)
+            {
+                values[line.substr(0, tab)] = line.substr(tab + 1);
+            }
+        }
+
+        int64_t timestamp = 0;
+        try
+        {
+            if (ParseInt(values["version"]) != k_settingsSnapshotVersion ||
+                values["serial"] != m_profile.serialNumber.c_str() || !LatchTimestamp(timestamp) ||
+                timestamp < ParseInt(values["timestamp"]))
+            {
+                return false;
+            }
+        }
+        catch (Spinnaker::Exception&)
+        {
+            return false;
+        }
+
+        values.erase("version");
+        values.erase("serial");
+        values.erase("timestamp");
+        m_known.swap(values);
+        return true;
+    }
+
+    Spinnaker::GenApi::INodeMap& m_nodeMap;
+    const CameraProfile& m_profile;
+    std::string m_snapshotFileName;
+    bool m_usedSnapshot;
+    bool m_failed;
+
+    // Values the camera holds, by key; selectors are keyed by their name alone
+    std::map<std::string, std::string> m_known;
+
+    // Item each selector of the current Apply() is to be on, in the order the selectors appeared
+    std::vector<std::pair<std::string, std::string> > m_selectors;
+
+    // Selectors of each node, as reported by the node map
+    std::map<std::string, std::vector<std::string> > m_selecting;
+};
+
+inline void PrintSettingsResult(const SettingsApplyResult& result)
+{
+    const char* const outcomes[] = {"unchanged", "cached", "written", "unavailable"};
+
+    for (size_t i = 0; i < result.records.size(); i++)
+    {
+        const SettingRecord& record = result.records[i];
+        std::cout << std::left << std::setw(31) << record.name << std::setw(10) << record.value << std::right << " ("
+                  << outcomes[record.outcome] << ")" << std::endl;
+    }
+
+    std::cout << "Camera " << result.serialNumber << ": " << result.records.size() << " settings, "
+              << result.numRead << " read, " << result.numWritten << " written, " << result.numCached
+              << (result.usedSnapshot ? " from snapshot" : " already known") << ", "
+              << static_cast<int64_t>(result.seconds * 1000.0) << " ms";
+    if (!result.success)
+    {
+        std::cout << "; failed: " << result.error;
+    }
+    std::cout << std::endl;
+}
+
+#endif // SETTINGS_CACHE_H
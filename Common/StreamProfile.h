@@ -0,0 +1,284 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief StreamProfile.h configures the buffer handling of a camera stream
+*  for either low latency or no dropped frames.
+*
+*  The low latency profile uses the NewestOnly handling mode with a few
+*  buffers, so GetNextImage() always returns the most recent frame and older
+*  frames are discarded; this suits live view. The no drop profile uses
+*  OldestFirst and sizes the buffer count so that the stream can absorb the
+*  given consumer stall at the current frame rate, within a memory budget;
+*  this suits recording. The burst profile also uses OldestFirst, with a
+*  buffer for every frame of a burst plus a margin, so that a burst that
+*  arrives faster than it is read is held by the stream in full. The default
+*  profile leaves the SDK settings alone.
+*
+*  Apply the profile after Init() and before BeginAcquisition(). The effective
+*  settings are read back from the stream nodemap, and the stream drop
+*  counters are recorded so that PrintStreamDrops() reports only the frames
+*  lost during this acquisition. Typical use:
+*
+*      StreamSettings streamSettings;
+*      ApplyStreamProfile(pCam, STREAM_PROFILE_NO_DROP, streamSettings);
+*      PrintStreamSettings(streamSettings);
+*      ...
+*      PrintStreamDrops(pCam, streamSettings);
+*/
+
+#ifndef STREAM_PROFILE_H
+#define STREAM_PROFILE_H
+
+#include "Spinnaker.h"
+#include "SpinGenApi/SpinnakerGenApi.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdint.h>
+
+// Number of buffers used by the low latency profile; one is being filled while another is processed
+const int64_t k_lowLatencyBufferCount = 3;
+
+// Consumer stall, in milliseconds, that the no drop profile sizes its buffers for
+const double k_noDropConsumerJitter = 500.0;
+
+// Buffers added by the no drop profile on top of those needed to cover the stall
+const int64_t k_noDropBufferMargin = 4;
+
+// Upper bound, in bytes, on the memory the no drop profile allocates for stream buffers
+const int64_t k_noDropMaxBufferMemory = 1024LL * 1024 * 1024;
+
+enum streamProfileType
+{
+    STREAM_PROFILE_DEFAULT,     // Leave the SDK defaults
+    STREAM_PROFILE_LOW_LATENCY, // NewestOnly, few buffers
+    STREAM_PROFILE_NO_DROP,     // OldestFirst, buffers sized from frame size and consumer jitter
+    STREAM_PROFILE_BURST        // OldestFirst, a buffer for every frame of a burst
+};
+
+// Stream settings in effect after ApplyStreamProfile(), and the drop counters at that point
+struct StreamSettings
+{
+    Spinnaker::GenICam::gcstring serialNumber;
+    streamProfileType profile;
+    Spinnaker::GenICam::gcstring handlingMode;
+    Spinnaker::GenICam::gcstring bufferCountMode;
+    int64_t bufferCount;
+    int64_t payloadSize;
+    double frameRate;
+
+    int64_t lostFramesAtStart;
+    int64_t droppedFramesAtStart;
+    int64_t underrunsAtStart;
+};
+
+// Reads a counter of a stream nodemap, or -1 if it is not available
+inline int64_t ReadStreamDropCounter(Spinnaker::GenApi::INodeMap& nodeMapStream, const char* name)
+{
+    using namespace Spinnaker::GenApi;
+
+    CIntegerPtr ptrCounter = nodeMapStream.GetNode(name);
+    return (IsAvailable(ptrCounter) && IsReadable(ptrCounter)) ? ptrCounter->GetValue() : -1;
+}
+
+inline bool SetStreamEnumeration(Spinnaker::GenApi::INodeMap& nodeMapStream, const char* name, const char* entry)
+{
+    using namespace Spinnaker::GenApi;
+
+    CEnumerationPtr ptrEnumeration = nodeMapStream.GetNode(name);
+    if (!IsAvailable(ptrEnumeration) || !IsWritable(ptrEnumeration))
+    {
+        return false;
+    }
+
+    CEnumEntryPtr ptrEntry = ptrEnumeration->GetEntryByName(entry);
+    if (!IsAvailable(ptrEntry) || !IsReadable(ptrEntry))
+    {
+        return false;
+    }
+
+    ptrEnumeration->SetIntValue(ptrEntry->GetValue());
+    return true;
+}
+
+inline Spinnaker::GenICam::gcstring GetStreamEnumeration(Spinnaker::GenApi::INodeMap& nodeMapStream, const char* name)
+{
+    using namespace Spinnaker::GenApi;
+
+    CEnumerationPtr ptrEnumeration = nodeMapStream.GetNode(name);
+    if (!IsAvailable(ptrEnumeration) || !IsReadable(ptrEnumeration))
+    {
+        return "unavailable";
+    }
+    return ptrEnumeration->ToString();
+}
+
+// Number of buffers the no drop profile needs to cover the consumer jitter at the given frame rate
+inline int64_t GetNoDropBufferCount(double frameRate, int64_t payloadSize)
+{
+    int64_t bufferCount = static_cast<int64_t>(std::ceil(frameRate * k_noDropConsumerJitter / 1000.0)) + k_noDropBufferMargin;
+
+    if (payloadSize > 0)
+    {
+        bufferCount = std::min<int64_t>(bufferCount, std::max<int64_t>(k_noDropMaxBufferMemory / payloadSize, 1));
+    }
+    return std::max<int64_t>(bufferCount, k_lowLatencyBufferCount);
+}
+
+// Number of buffers the burst profile needs to hold a whole burst, within the same memory budget
+inline int64_t GetBurstBufferCount(int64_t burstFrames, int64_t payloadSize)
+{
+    int64_t bufferCount = burstFrames + k_noDropBufferMargin;
+
+    if (payloadSize > 0)
+    {
+        bufferCount = std::min<int64_t>(bufferCount, std::max<int64_t>(k_noDropMaxBufferMemory / payloadSize, 1));
+    }
+    return std::max<int64_t>(bufferCount, k_lowLatencyBufferCount);
+}
+
+// Configures the stream of an initialized camera for the chosen profile and reads back the
+// settings in effect. Returns false if a setting of the profile could not be applied.
+// burstFrames is the number of frames per burst and only applies to STREAM_PROFILE_BURST.
+inline bool ApplyStreamProfile(
+    Spinnaker::CameraPtr pCam,
+    streamProfileType profile,
+    StreamSettings& settings,
+    int64_t burstFrames = 0)
+{
+    using namespace Spinnaker::GenApi;
+
+    bool applied = true;
+
+    INodeMap& nodeMap = pCam->GetNodeMap();
+    INodeMap& nodeMapStream = pCam->GetTLStreamNodeMap();
+
+    CStringPtr ptrSerialNumber = pCam->GetTLDeviceNodeMap().GetNode("DeviceSerialNumber");
+    settings.serialNumber = (IsAvailable(ptrSerialNumber) && IsReadable(ptrSerialNumber)) ? ptrSerialNumber->GetValue() : "";
+    settings.profile = profile;
+
+    CIntegerPtr ptrPayloadSize = nodeMap.GetNode("PayloadSize");
+    settings.payloadSize = (IsAvailable(ptrPayloadSize) && IsReadable(ptrPayloadSize)) ? ptrPayloadSize->GetValue() : 0;
+
+    CFloatPtr ptrFrameRate = nodeMap.GetNode("AcquisitionResultingFrameRate");
+    if (!IsAvailable(ptrFrameRate) || !IsReadable(ptrFrameRate))
+    {
+        ptrFrameRate = nodeMap.GetNode("AcquisitionFrameRate");
+    }
+    settings.frameRate = (IsAvailable(ptrFrameRate) && IsReadable(ptrFrameRate)) ? ptrFrameRate->GetValue() : 0.0;
+
+    if (profile != STREAM_PROFILE_DEFAULT)
+    {
+        const bool lowLatency = profile == STREAM_PROFILE_LOW_LATENCY;
+
+        applied = SetStreamEnumeration(nodeMapStream, "StreamBufferHandlingMode", lowLatency ? "NewestOnly" : "OldestFirst");
+        applied = SetStreamEnumeration(nodeMapStream, "StreamBufferCountMode", "Manual") && applied;
+
+        CIntegerPtr ptrBufferCount = nodeMapStream.GetNode("StreamBufferCountManual");
+        if (IsAvailable(ptrBufferCount) && IsWritable(ptrBufferCount))
+        {
+            int64_t bufferCount = k_lowLatencyBufferCount;
+            if (profile == STREAM_PROFILE_NO_DROP)
+            {
+                bufferCount = GetNoDropBufferCount(settings.frameRate, settings.payloadSize);
+            }
+            else if (profile == STREAM_PROFILE_BURST)
+            {
+                bufferCount = GetBurstBufferCount(burstFrames, settings.payloadSize);
+            }
+            ptrBufferCount->SetValue(std::min<int64_t>(std::max<int64_t>(bufferCount, ptrBufferCount->GetMin()), ptrBufferCount->GetMax()));
+        }
+        else
+        {
+            applied = false;
+        }
+    }
+
+    settings.handlingMode = GetStreamEnumeration(nodeMapStream, "StreamBufferHandlingMode");
+    settings.bufferCountMode = GetStreamEnumeration(nodeMapStream, "StreamBufferCountMode");
+
+    CIntegerPtr ptrBufferCountResult = nodeMapStream.GetNode("StreamBufferCountResult");
+    if (!IsAvailable(ptrBufferCountResult) || !IsReadable(ptrBufferCountResult))
+    {
+        ptrBufferCountResult = nodeMapStream.GetNode("StreamBufferCountManual");
+    }
+    settings.bufferCount =
+        (IsAvailable(ptrBufferCountResult) && IsReadable(ptrBufferCountResult)) ? ptrBufferCountResult->GetValue() : -1;
+
+    // The stream counters accumulate across acquisitions, so remember where this one starts
+    settings.lostFramesAtStart = ReadStreamDropCounter(nodeMapStream, "StreamLostFrameCount");
+    settings.droppedFramesAtStart = ReadStreamDropCounter(nodeMapStream, "StreamDroppedFrameCount");
+    settings.underrunsAtStart = ReadStreamDropCounter(nodeMapStream, "StreamBufferUnderrunCount");
+
+    return applied;
+}
+
+inline void PrintStreamSettings(const StreamSettings& settings)
+{
+    const char* const profileNames[] = {"default", "low latency", "no drop", "burst"};
+
+    std::cout << "Stream profile for camera " << settings.serialNumber << ": " << profileNames[settings.profile] << std::endl;
+    std::cout << "  Buffer handling mode: " << settings.handlingMode << std::endl;
+    std::cout << "  Buffer count mode: " << settings.bufferCountMode << std::endl;
+    std::cout << "  Buffer count: " << settings.bufferCount;
+    if (settings.bufferCount > 0 && settings.payloadSize > 0)
+    {
+        std::cout << " (" << settings.bufferCount * settings.payloadSize / (1024 * 1024) << " MB)";
+    }
+    std::cout << std::endl;
+    if (settings.frameRate > 0.0 && settings.bufferCount > 0)
+    {
+        std::cout << "  Buffered time at " << settings.frameRate
+                  << " fps: " << static_cast<int64_t>(settings.bufferCount * 1000.0 / settings.frameRate) << " ms"
+                  << std::endl;
+    }
+}
+
+// Prints the frames the stream lost or dropped since ApplyStreamProfile()
+inline void PrintStreamDrops(Spinnaker::CameraPtr pCam, const StreamSettings& settings)
+{
+    Spinnaker::GenApi::INodeMap& nodeMapStream = pCam->GetTLStreamNodeMap();
+
+    const char* const names[] = {"StreamLostFrameCount", "StreamDroppedFrameCount", "StreamBufferUnderrunCount"};
+    const char* const labels[] = {"lost frames", "dropped frames", "buffer underruns"};
+    const int64_t atStart[] = {settings.lostFramesAtStart, settings.droppedFramesAtStart, settings.underrunsAtStart};
+
+    std::cout << "Stream drops for camera " << settings.serialNumber << ":";
+    for (unsigned int i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        const int64_t value = ReadStreamDropCounter(nodeMapStream, names[i]);
+        if (value >= 0)
+        {
+            std::cout << " " << value - std::max<int64_t>(atStart[i], 0) << " " << labels[i];
+        }
+        else
+        {
+            std::cout << " " << labels[i] << " unavailable";
+        }
+        std::cout << (i + 1 < sizeof(names) / sizeof(names[0]) ? "," : "");
+    }
+    std::cout << std::endl;
+
+    // NewestOnly discards unread frames by design, so drops are expected with the low latency profile
+    if (settings.profile == STREAM_PROFILE_LOW_LATENCY)
+    {
+        std::cout << "  (frames replaced by newer ones are expected with the low latency profile)" << std::endl;
+    }
+}
+
+#endif // STREAM_PROFILE_H
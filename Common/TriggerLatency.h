@@ -0,0 +1,761 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief TriggerLatency.h measures how long a camera takes from a trigger to
+*  the exposure and to the delivery of the image on the host.
+*
+*  TriggerLatencyBenchmark issues software triggers, or pulses a user output
+*  that the trigger or logic block configuration listens to, at a fixed rate
+*  and records the host time of each. A grab thread records the host arrival
+*  time, frame ID and timestamp of every image, and the ExposureStart and
+*  ExposureEnd events, where the camera has them, give the exposure times of
+*  each frame. CameraClockSync maps the camera times to host time.
+*
+*  Once the run is over each frame is matched to the last trigger issued
+*  before its exposure started, and the first frame of every trigger adds one
+*  sample to the trigger to exposure start, exposure end, frame timestamp and
+*  host delivery histograms. Triggers without a frame are reported as missed
+*  and frames beyond framesPerTrigger as extra. The trigger period must be
+*  longer than the time from a trigger to its last exposure, or the frames of
+*  one trigger are matched to the next. Typical use:
+*
+*      TriggerBenchmarkSettings settings;
+*      settings.issueType = TRIGGER_ISSUE_USER_OUTPUT;
+*      settings.userOutput = "UserOutput0";
+*      TriggerLatencyBenchmark benchmark(pCam);
+*      TriggerLatencyReport report;
+*      string error;
+*      if (benchmark.Run(settings, report, error))
+*      {
+*          PrintTriggerLatencyReport(report);
+*      }
+*/
+
+#ifndef TRIGGER_LATENCY_H
+#define TRIGGER_LATENCY_H
+
+#include "Spinnaker.h"
+#include "SpinGenApi/SpinnakerGenApi.h"
+#include "CameraClockSync.h"
+#include "CameraProfile.h"
+#include "FrameStats.h"
+#include "SettingsCache.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+// A frame whose exposure maps to slightly before a trigger still belongs to it; this
+// covers the error of the clock mapping when the trigger to exposure latency is short
+const int64_t k_triggerMatchToleranceNs = 1000000;
+
+// How long the grab thread waits for an image before it checks whether to stop
+const unsigned int k_triggerGrabTimeoutMs = 100;
+
+// Selects whether an example waits for its hardware trigger, or issues the
+// triggers itself through RunTriggerLatencyBenchmark()
+enum triggerFlowType
+{
+    TRIGGER_MANUAL,
+    TRIGGER_BENCHMARK
+};
+
+// How the benchmark issues its triggers
+enum triggerIssueType
+{
+    TRIGGER_ISSUE_SOFTWARE,   // Execute TriggerSoftware; TriggerSource must be Software
+    TRIGGER_ISSUE_USER_OUTPUT // Pulse a user output that the trigger, counters or logic blocks are driven by
+};
+
+enum triggerLatencyStage
+{
+    LATENCY_EXPOSURE_START,  // Trigger to the ExposureStart event
+    LATENCY_EXPOSURE_END,    // Trigger to the ExposureEnd event
+    LATENCY_FRAME_TIMESTAMP, // Trigger to the timestamp of the image
+    LATENCY_DELIVERY,        // Trigger to the image arriving on the host
+    NUM_LATENCY_STAGES
+};
+
+inline const char* GetTriggerLatencyStageName(triggerLatencyStage stage)
+{
+    switch (stage)
+    {
+    case LATENCY_EXPOSURE_START:
+        return "ExposureStart";
+    case LATENCY_EXPOSURE_END:
+        return "ExposureEnd";
+    case LATENCY_FRAME_TIMESTAMP:
+        return "Timestamp";
+    case LATENCY_DELIVERY:
+        return "Delivery";
+    default:
+        return "Unknown";
+    }
+}
+
+struct TriggerBenchmarkSettings
+{
+    TriggerBenchmarkSettings()
+        : issueType(TRIGGER_ISSUE_SOFTWARE), userOutput("UserOutput0"), rateHz(10.0), numTriggers(100), pulseMs(1),
+          framesPerTrigger(1), drainMs(1000)
+    {
+    }
+
+    triggerIssueType issueType;
+
+    // UserOutputSelector entry pulsed for each trigger by TRIGGER_ISSUE_USER_OUTPUT
+    Spinnaker::GenICam::gcstring userOutput;
+
+    // UserOutputSelector entry held high for the whole run, e.g. the enable of a gated trigger; empty for none
+    Spinnaker::GenICam::gcstring enableOutput;
+
+    double rateHz;
+    unsigned int numTriggers;
+
+    // Length of the user output pulse; shorter than the trigger period
+    unsigned int pulseMs;
+
+    // Images each trigger produces, e.g. the burst length of a burst trigger
+    unsigned int framesPerTrigger;
+
+    // How long to keep grabbing after the last trigger
+    unsigned int drainMs;
+};
+
+struct TriggerLatencyReport
+{
+    Spinnaker::GenICam::gcstring serialNumber;
+    unsigned int numTriggers;
+    unsigned int numFrames;
+    unsigned int numIncomplete;
+    unsigned int numMissedTriggers; // Triggers without any frame
+    unsigned int numMissedFrames;   // Frames short of framesPerTrigger on triggers that did produce frames
+    unsigned int numExtraFrames;    // Frames beyond framesPerTrigger, or before the first trigger
+    unsigned int numClamped;        // Latencies that mapped below zero and were recorded as zero
+    int64_t maxIssueNs;             // Longest trigger command or user output write
+    bool clockSynchronized;
+    bool exposureEvents;
+    double clockResidualNs;
+    LatencyHistogram latencies[NUM_LATENCY_STAGES];
+};
+
+// Records the camera timestamps of the ExposureStart and ExposureEnd events by frame ID
+class ExposureEventRecorder : public Spinnaker::DeviceEventHandler
+{
+public:
+    explicit ExposureEventRecorder(Spinnaker::GenApi::INodeMap& nodeMap) : m_nodeMap(nodeMap)
+    {
+    }
+
+    void OnDeviceEvent(Spinnaker::GenICam::gcstring eventName)
+    {
+        try
+        {
+            if (eventName == "EventExposureStart")
+            {
+                Record("EventExposureStartTimestamp", "EventExposureStartFrameID", m_starts);
+            }
+            else if (eventName == "EventExposureEnd")
+            {
+                Record("EventExposureEndTimestamp", "EventExposureEndFrameID", m_ends);
+            }
+        }
+        catch (Spinnaker::Exception&)
+        {
+            // A lost event only leaves its frame to be matched by the image timestamp
+        }
+    }
+
+    bool GetExposureStart(int64_t frameID, int64_t& timestamp) const
+    {
+        return Find(m_starts, frameID, timestamp);
+    }
+
+    bool GetExposureEnd(int64_t frameID, int64_t& timestamp) const
+    {
+        return Find(m_ends, frameID, timestamp);
+    }
+
+private:
+    ExposureEventRecorder(const ExposureEventRecorder&);
+    ExposureEventRecorder& operator=(const ExposureEventRecorder&);
+
+    void Record(const char* timestampName, const char* frameIDName, std::map<int64_t, int64_t>& events)
+    {
+        using namespace Spinnaker::GenApi;
+
+        CIntegerPtr ptrTimestamp = m_nodeMap.GetNode(timestampName);
+        CIntegerPtr ptrFrameID = m_nodeMap.GetNode(frameIDName);
+        if (!IsAvailable(ptrTimestamp) || !IsReadable(ptrTimestamp) || !IsAvailable(ptrFrameID) ||
+            !IsReadable(ptrFrameID))
+        {
+            return;
+        }
+
+        const int64_t timestamp = ptrTimestamp->GetValue();
+        const int64_t frameID = ptrFrameID->GetValue();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        events[frameID] = timestamp;
+    }
+
+    bool Find(const std::map<int64_t, int64_t>& events, int64_t frameID, int64_t& timestamp) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<int64_t, int64_t>::const_iterator event = events.find(frameID);
+        if (event == events.end())
+        {
+            return false;
+        }
+        timestamp = event->second;
+        return true;
+    }
+
+    Spinnaker::GenApi::INodeMap& m_nodeMap;
+    mutable std::mutex m_mutex;
+    std::map<int64_t, int64_t> m_starts;
+    std::map<int64_t, int64_t> m_ends;
+};
+
+class TriggerLatencyBenchmark
+{
+public:
+    // The camera must be initialized and configured to take images on the chosen trigger
+    explicit TriggerLatencyBenchmark(Spinnaker::CameraPtr pCam)
+        : m_pCam(pCam), m_nodeMap(pCam->GetNodeMap()), m_profile(ResolveProfile(pCam)), m_cache(pCam, m_profile),
+          m_stopping(false)
+    {
+    }
+
+    // Begins acquisition, issues the triggers, ends acquisition and matches the frames to the triggers.
+    // Image timestamps and exposure events are enabled where the camera has them.
+    bool Run(const TriggerBenchmarkSettings& settings, TriggerLatencyReport& report, std::string& error)
+    {
+        using namespace Spinnaker::GenApi;
+
+        report.serialNumber = m_profile.serialNumber;
+        report.numTriggers = 0;
+        report.numFrames = 0;
+        report.numIncomplete = 0;
+        report.numMissedTriggers = 0;
+        report.numMissedFrames = 0;
+        report.numExtraFrames = 0;
+        report.numClamped = 0;
+        report.maxIssueNs = 0;
+        report.clockSynchronized = false;
+        report.exposureEvents = false;
+        report.clockResidualNs = 0.0;
+
+        if (settings.rateHz <= 0.0 || settings.numTriggers == 0 || settings.framesPerTrigger == 0)
+        {
+            error = "the trigger rate, number of triggers and frames per trigger must be positive";
+            return false;
+        }
+        if (settings.issueType == TRIGGER_ISSUE_USER_OUTPUT && settings.pulseMs * settings.rateHz >= 1000.0)
+        {
+            error = "the user output pulse must be shorter than the trigger period";
+            return false;
+        }
+
+        m_triggers.clear();
+        m_frames.clear();
+
+        ExposureEventRecorder events(m_nodeMap);
+        CameraClockSync clock(m_profile, 1.0);
+        std::thread grabber;
+        bool registered = false;
+        bool acquiring = false;
+        bool enabled = false;
+        bool success = false;
+
+        try
+        {
+            report.exposureEvents = EnableTimestamps(error);
+            if (!error.empty())
+            {
+                return false;
+            }
+
+            report.clockSynchronized = clock.Start();
+            if (!report.clockSynchronized)
+            {
+                std::cout << "Camera timestamp cannot be latched; only host delivery latency is measured..."
+                          << std::endl;
+            }
+
+            if (report.exposureEvents)
+            {
+                m_pCam->RegisterEventHandler(events);
+                registered = true;
+            }
+
+            enabled = !settings.enableOutput.empty();
+            if (PrepareTriggers(settings, error))
+            {
+                m_pCam->BeginAcquisition();
+                acquiring = true;
+
+                m_stopping = false;
+                grabber = std::thread(&TriggerLatencyBenchmark::Grab, this);
+
+                success = IssueTriggers(settings, report, error);
+                std::this_thread::sleep_for(std::chrono::milliseconds(settings.drainMs));
+            }
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            error = e.what();
+            success = false;
+        }
+
+        // Stop grabbing before acquisition ends, on every path out of the run
+        m_stopping = true;
+        if (grabber.joinable())
+        {
+            grabber.join();
+        }
+
+        try
+        {
+            if (acquiring)
+            {
+                m_pCam->EndAcquisition();
+            }
+            if (registered)
+            {
+                m_pCam->UnregisterEventHandler(events);
+            }
+            if (enabled)
+            {
+                SetUserOutput(settings.enableOutput, false);
+            }
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            if (success)
+            {
+                error = e.what();
+                success = false;
+            }
+        }
+        clock.Stop();
+
+        if (success)
+        {
+            report.clockResidualNs = clock.GetModel().residualNs;
+            Match(settings, clock, events, report);
+        }
+        return success;
+    }
+
+private:
+    TriggerLatencyBenchmark(const TriggerLatencyBenchmark&);
+    TriggerLatencyBenchmark& operator=(const TriggerLatencyBenchmark&);
+
+    struct FrameSample
+    {
+        int64_t frameID;
+        int64_t timestamp;
+        int64_t arrivalNs;
+        bool incomplete;
+    };
+
+    static CameraProfile ResolveProfile(Spinnaker::CameraPtr pCam)
+    {
+        CameraProfile profile;
+        profile.Resolve(pCam);
+        return profile;
+    }
+
+    static int64_t SteadyNow()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // True if the event selector has the entry, so it can be selected without failing the profile
+    bool HasEvent(const char* entry) const
+    {
+        using namespace Spinnaker::GenApi;
+
+        CEnumerationPtr ptrEventSelector = m_nodeMap.GetNode("EventSelector");
+        if (!IsAvailable(ptrEventSelector) || !IsWritable(ptrEventSelector))
+        {
+            return false;
+        }
+        CEnumEntryPtr ptrEntry = ptrEventSelector->GetEntryByName(entry);
+        return IsAvailable(ptrEntry) && IsReadable(ptrEntry);
+    }
+
+    // Turns on the timestamp and frame ID chunks and the exposure events; returns true if
+    // ExposureEnd events are delivered. Leaves an error only if the settings could not be written.
+    bool EnableTimestamps(std::string& error)
+    {
+        SettingsProfile settings;
+        settings.SetBool("ChunkModeActive", true, false);
+        settings.Select("ChunkSelector", "Timestamp").SetBool("ChunkEnable", true, false);
+        settings.Select("ChunkSelector", "FrameID").SetBool("ChunkEnable", true, false);
+
+        const bool exposureEnd = HasEvent("ExposureEnd");
+        if (exposureEnd)
+        {
+            settings.Select("EventSelector", "ExposureEnd").SetEnum("EventNotification", "On", false);
+        }
+        if (HasEvent("ExposureStart"))
+        {
+            settings.Select("EventSelector", "ExposureStart").SetEnum("EventNotification", "On", false);
+        }
+
+        SettingsApplyResult result;
+        if (!m_cache.Apply(settings, result))
+        {
+            error = result.error;
+            return false;
+        }
+        return exposureEnd;
+    }
+
+    bool SetUserOutput(const Spinnaker::GenICam::gcstring& userOutput, bool value)
+    {
+        using namespace Spinnaker::GenApi;
+
+        CEnumerationPtr ptrUserOutputSelector = m_nodeMap.GetNode("UserOutputSelector");
+        if (!IsAvailable(ptrUserOutputSelector) || !IsWritable(ptrUserOutputSelector))
+        {
+            return false;
+        }
+        CEnumEntryPtr ptrUserOutput = ptrUserOutputSelector->GetEntryByName(userOutput);
+        if (!IsAvailable(ptrUserOutput) || !IsReadable(ptrUserOutput))
+        {
+            return false;
+        }
+        if (ptrUserOutputSelector->GetIntValue() != ptrUserOutput->GetValue())
+        {
+            ptrUserOutputSelector->SetIntValue(ptrUserOutput->GetValue());
+        }
+
+        CBooleanPtr ptrOutputValue = m_nodeMap.GetNode("UserOutputValue");
+        if (!IsAvailable(ptrOutputValue) || !IsWritable(ptrOutputValue))
+        {
+            return false;
+        }
+        ptrOutputValue->SetValue(value);
+        return true;
+    }
+
+    // Checks that the triggers can be issued and brings the user outputs to their idle level
+    bool PrepareTriggers(const TriggerBenchmarkSettings& settings, std::string& error)
+    {
+        using namespace Spinnaker::GenApi;
+
+        if (settings.issueType == TRIGGER_ISSUE_SOFTWARE)
+        {
+            CCommandPtr ptrSoftwareTrigger = m_nodeMap.GetNode("TriggerSoftware");
+            if (!IsAvailable(ptrSoftwareTrigger) || !IsWritable(ptrSoftwareTrigger))
+            {
+                error = "TriggerSoftware not available; the trigger source must be Software";
+                return false;
+            }
+        }
+        else if (!SetUserOutput(settings.userOutput, false))
+        {
+            error = std::string("unable to set ") + settings.userOutput.c_str();
+            return false;
+        }
+
+        if (!settings.enableOutput.empty() && !SetUserOutput(settings.enableOutput, true))
+        {
+            error = std::string("unable to set ") + settings.enableOutput.c_str();
+            return false;
+        }
+        return true;
+    }
+
+    // Issues the triggers at the configured rate; the host time of a trigger is the middle of its write
+    bool IssueTriggers(const TriggerBenchmarkSettings& settings, TriggerLatencyReport& report, std::string& error)
+    {
+        using namespace Spinnaker::GenApi;
+
+        CCommandPtr ptrSoftwareTrigger = m_nodeMap.GetNode("TriggerSoftware");
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const std::chrono::duration<double> period(1.0 / settings.rateHz);
+
+        for (unsigned int i = 0; i < settings.numTriggers; i++)
+        {
+            std::this_thread::sleep_until(
+                start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(period * static_cast<double>(i)));
+
+            const int64_t before = SteadyNow();
+            if (settings.issueType == TRIGGER_ISSUE_SOFTWARE)
+            {
+                ptrSoftwareTrigger->Execute();
+            }
+            else if (!SetUserOutput(settings.userOutput, true))
+            {
+                error = std::string("unable to set ") + settings.userOutput.c_str();
+                return false;
+            }
+            const int64_t after = SteadyNow();
+
+            m_triggers.push_back(before + (after - before) / 2);
+            report.maxIssueNs = std::max<int64_t>(report.maxIssueNs, after - before);
+            report.numTriggers++;
+
+            if (settings.issueType == TRIGGER_ISSUE_USER_OUTPUT)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(settings.pulseMs));
+                SetUserOutput(settings.userOutput, false);
+            }
+        }
+        return true;
+    }
+
+    // Grab thread; records every image until the run is over
+    void Grab()
+    {
+        while (!m_stopping)
+        {
+            try
+            {
+                Spinnaker::ImagePtr pImage = m_pCam->GetNextImage(k_triggerGrabTimeoutMs);
+
+                FrameSample frame;
+                frame.arrivalNs = SteadyNow();
+                frame.frameID = -1;
+                frame.timestamp = static_cast<int64_t>(pImage->GetTimeStamp());
+                frame.incomplete = pImage->IsIncomplete();
+
+                // The exposure events carry the camera's frame ID, which only the chunk data
+                // holds; the frame ID and timestamp of the image are those of the transport
+                // layer. An incomplete image may have no chunk data and matches no event.
+                if (!frame.incomplete)
+                {
+                    const Spinnaker::ChunkData& chunkData = pImage->GetChunkData();
+                    frame.frameID = chunkData.GetFrameID();
+                    frame.timestamp = chunkData.GetTimestamp();
+                }
+                pImage->Release();
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_frames.push_back(frame);
+            }
+            catch (Spinnaker::Exception&)
+            {
+                // Timed out; check whether to stop
+            }
+        }
+    }
+
+    static void RecordLatency(LatencyHistogram& histogram, int64_t latencyNs, TriggerLatencyReport& report)
+    {
+        if (latencyNs < 0)
+        {
+            report.numClamped++;
+            latencyNs = 0;
+        }
+        histogram.Record(static_cast<uint64_t>(latencyNs));
+    }
+
+    // Matches each frame to the last trigger before its exposure and records the first frame of each trigger
+    void Match(
+        const TriggerBenchmarkSettings& settings,
+        const CameraClockSync& clock,
+        const ExposureEventRecorder& events,
+        TriggerLatencyReport& report)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<unsigned int> counts(m_triggers.size(), 0);
+
+        for (size_t i = 0; i < m_frames.size(); i++)
+        {
+            const FrameSample& frame = m_frames[i];
+            report.numFrames++;
+            if (frame.incomplete)
+            {
+                report.numIncomplete++;
+            }
+
+            int64_t exposureStart = 0;
+            int64_t exposureEnd = 0;
+            const bool hasStart = events.GetExposureStart(frame.frameID, exposureStart);
+            const bool hasEnd = events.GetExposureEnd(frame.frameID, exposureEnd);
+
+            // Without a camera clock the frame can only be matched by its arrival
+            int64_t reference = frame.arrivalNs;
+            if (report.clockSynchronized)
+            {
+                reference = clock.ToSteadyTime(hasStart ? exposureStart : frame.timestamp);
+            }
+
+            std::vector<int64_t>::const_iterator trigger =
+                std::upper_bound(m_triggers.begin(), m_triggers.end(), reference + k_triggerMatchToleranceNs);
+            if (trigger == m_triggers.begin())
+            {
+                report.numExtraFrames++;
+                continue;
+            }
+            --trigger;
+
+            const size_t index = trigger - m_triggers.begin();
+            if (++counts[index] > settings.framesPerTrigger)
+            {
+                report.numExtraFrames++;
+                continue;
+            }
+            if (counts[index] != 1)
+            {
+                continue;
+            }
+
+            if (report.clockSynchronized)
+            {
+                if (hasStart)
+                {
+                    RecordLatency(report.latencies[LATENCY_EXPOSURE_START], clock.ToSteadyTime(exposureStart) - *trigger, report);
+                }
+                if (hasEnd)
+                {
+                    RecordLatency(report.latencies[LATENCY_EXPOSURE_END], clock.ToSteadyTime(exposureEnd) - *trigger, report);
+                }
+                RecordLatency(report.latencies[LATENCY_FRAME_TIMESTAMP], clock.ToSteadyTime(frame.timestamp) - *trigger, report);
+            }
+            RecordLatency(report.latencies[LATENCY_DELIVERY], frame.arrivalNs - *trigger, report);
+        }
+
+        for (size_t i = 0; i < counts.size(); i++)
+        {
+            if (counts[i] == 0)
+            {
+                report.numMissedTriggers++;
+            }
+            else if (counts[i] < settings.framesPerTrigger)
+            {
+                report.numMissedFrames += settings.framesPerTrigger - counts[i];
+            }
+        }
+    }
+
+    Spinnaker::CameraPtr m_pCam;
+    Spinnaker::GenApi::INodeMap& m_nodeMap;
+    CameraProfile m_profile;
+    SettingsCache m_cache;
+
+    std::atomic<bool> m_stopping;
+    std::mutex m_mutex;
+    std::vector<int64_t> m_triggers;
+    std::vector<FrameSample> m_frames;
+};
+
+inline void PrintTriggerLatencyReport(const TriggerLatencyReport& report)
+{
+    std::cout << std::endl << "*** TRIGGER LATENCY: " << report.serialNumber << " ***" << std::endl << std::endl;
+    std::cout << std::left << std::setw(14) << "Trigger to" << std::right << std::setw(10) << "Count"
+              << std::setw(12) << "Min ms" << std::setw(12) << "Mean ms" << std::setw(12) << "p50 ms"
+              << std::setw(12) << "p99 ms" << std::setw(12) << "Max ms" << std::endl;
+
+    for (unsigned int stage = 0; stage < NUM_LATENCY_STAGES; stage++)
+    {
+        const LatencyHistogram& histogram = report.latencies[stage];
+        if (histogram.GetCount() == 0)
+        {
+            continue;
+        }
+
+        std::cout << std::left << std::setw(14) << GetTriggerLatencyStageName(static_cast<triggerLatencyStage>(stage))
+                  << std::right << std::setw(10) << histogram.GetCount() << std::fixed << std::setprecision(3)
+                  << std::setw(12) << histogram.GetPercentileMs(0.0) << std::setw(12) << histogram.GetMeanMs()
+                  << std::setw(12) << histogram.GetPercentileMs(0.5) << std::setw(12) << histogram.GetPercentileMs(0.99)
+                  << std::setw(12) << histogram.GetMaxMs() << std::endl;
+    }
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6);
+
+    std::cout << std::endl
+              << report.numTriggers << " triggers, " << report.numFrames << " frames (" << report.numIncomplete
+              << " incomplete), " << report.numMissedTriggers << " missed triggers, " << report.numMissedFrames
+              << " missed frames, " << report.numExtraFrames << " extra frames" << std::endl;
+    std::cout << "Longest trigger write " << report.maxIssueNs / 1000 << " us";
+    if (report.clockSynchronized)
+    {
+        std::cout << ", clock mapping residual " << static_cast<int64_t>(report.clockResidualNs / 1000.0) << " us";
+    }
+    if (!report.exposureEvents)
+    {
+        std::cout << ", no exposure events";
+    }
+    if (report.numClamped > 0)
+    {
+        std::cout << ", " << report.numClamped << " latencies below zero recorded as zero";
+    }
+    std::cout << std::endl;
+}
+
+// Pulses userOutput for 1 ms numTriggers times at rateHz, with enableOutput
+// held high for the whole run when one is given, and prints the latency
+// report. The benchmark runs acquisition itself, so the camera must not be
+// streaming. Returns false, with the reason printed, if the run failed.
+inline bool RunTriggerLatencyBenchmark(Spinnaker::CameraPtr pCam, const Spinnaker::GenICam::gcstring& userOutput,
+                                       double rateHz, unsigned int numTriggers, unsigned int framesPerTrigger = 1,
+                                       const Spinnaker::GenICam::gcstring& enableOutput = "")
+{
+    TriggerBenchmarkSettings settings;
+    settings.issueType = TRIGGER_ISSUE_USER_OUTPUT;
+    settings.userOutput = userOutput;
+    settings.enableOutput = enableOutput;
+    settings.rateHz = rateHz;
+    settings.numTriggers = numTriggers;
+    settings.pulseMs = 1;
+    settings.framesPerTrigger = framesPerTrigger;
+
+    std::cout << "Benchmarking " << numTriggers << " triggers at " << rateHz << " Hz";
+    if (framesPerTrigger > 1)
+    {
+        std::cout << ", " << framesPerTrigger << " images each";
+    }
+    std::cout << "..." << std::endl;
+
+    try
+    {
+        TriggerLatencyBenchmark benchmark(pCam);
+        TriggerLatencyReport report;
+        std::string error;
+        if (!benchmark.Run(settings, report, error))
+        {
+            std::cout << "Unable to benchmark trigger latency: " << error << std::endl << std::endl;
+            return false;
+        }
+
+        PrintTriggerLatencyReport(report);
+    }
+    catch (Spinnaker::Exception& e)
+    {
+        std::cout << "Error: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#endif // TRIGGER_LATENCY_H
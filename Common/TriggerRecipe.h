@@ -0,0 +1,369 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief TriggerRecipe.h describes a logic block, counter and line setup as
+*  one table and applies it with the fewest node writes.
+*
+*  A TriggerRecipe lists the logic blocks with their truth tables and LUT
+*  inputs, the counters with their event, trigger and reset sources, and the
+*  lines with their mode and source. An empty (null) field leaves that node
+*  as it is. CompileTriggerRecipe() checks the recipe and turns it into a
+*  SettingsProfile, grouped so that LogicBlockSelector, LogicBlockLUTSelector,
+*  CounterSelector and LineSelector are each set once per item.
+*
+*  TriggerRecipeEngine keeps the compiled recipes of a camera. Load() checks
+*  a recipe once against the camera's nodemap, and Apply() writes only the
+*  nodes that differ from what the camera holds under the same logic block,
+*  LUT, input, counter and line, so switching between loaded recipes only
+*  costs the nodes in which they differ. This assumes nothing else writes
+*  these nodes while the engine is in use.
+*  Typical use:
+*
+*      TriggerRecipeEngine engine(pCam);
+*      SettingsApplyResult result;
+*      engine.Apply(recipe, result);
+*      PrintSettingsResult(result);
+*
+*  ConfigureTriggerRecipe() does the same and announces the recipe, as the
+*  logic block examples do at startup.
+*/
+
+#ifndef TRIGGER_RECIPE_H
+#define TRIGGER_RECIPE_H
+
+#include "Spinnaker.h"
+#include "SpinGenApi/SpinnakerGenApi.h"
+#include "CameraProfile.h"
+#include "SettingsCache.h"
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Number of LUT inputs of a logic block; the truth tables have one bit per input combination
+const unsigned int k_logicBlockNumInputs = 3;
+
+struct LogicBlockInput
+{
+    const char* source;     // LogicBlockLUTInputSource entry, e.g. "ExposureStart"
+    const char* activation; // LogicBlockLUTInputActivation entry, e.g. "RisingEdge"
+};
+
+struct LogicBlockConfig
+{
+    const char* block;      // LogicBlockSelector entry, e.g. "LogicBlock0"
+    unsigned int enableLUT; // LogicBlockLUTOutputValueAll of the Enable LUT, bit n for inputs I2 I1 I0 = n
+    unsigned int valueLUT;  // LogicBlockLUTOutputValueAll of the Value LUT
+    LogicBlockInput inputs[k_logicBlockNumInputs];
+};
+
+struct CounterConfig
+{
+    const char* counter;           // CounterSelector entry, e.g. "Counter0"
+    const char* eventSource;       // CounterEventSource entry, e.g. "MHzTick"
+    const char* triggerSource;     // CounterTriggerSource entry, e.g. "Off"
+    const char* triggerActivation; // CounterTriggerActivation entry
+    const char* resetSource;       // CounterResetSource entry
+    const char* resetActivation;   // CounterResetActivation entry
+    int64_t duration;              // CounterDuration, in events of the event source
+};
+
+struct LineConfig
+{
+    const char* line;   // LineSelector entry, e.g. "Line2"
+    const char* mode;   // LineMode entry, e.g. "Output"
+    const char* source; // LineSource entry, e.g. "LogicBlock0"
+};
+
+struct TriggerRecipe
+{
+    std::string name;
+    std::vector<LogicBlockConfig> logicBlocks;
+    std::vector<CounterConfig> counters;
+    std::vector<LineConfig> lines;
+};
+
+// True if the truth table changes with input i, i.e. output n differs from output n with bit i flipped
+inline bool LogicBlockUsesInput(const LogicBlockConfig& block, unsigned int input)
+{
+    const unsigned int numRows = 1u << k_logicBlockNumInputs;
+    for (unsigned int row = 0; row < numRows; row++)
+    {
+        const unsigned int other = row ^ (1u << input);
+        if (((block.enableLUT >> row) & 1) != ((block.enableLUT >> other) & 1) ||
+            ((block.valueLUT >> row) & 1) != ((block.valueLUT >> other) & 1))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Checks the recipe and compiles it into the ordered node writes it stands for
+inline bool CompileTriggerRecipe(const TriggerRecipe& recipe, SettingsProfile& settings, std::string& error)
+{
+    const unsigned int lutMask = (1u << (1u << k_logicBlockNumInputs)) - 1;
+    std::set<std::string> items;
+
+    settings = SettingsProfile();
+
+    for (size_t i = 0; i < recipe.logicBlocks.size(); i++)
+    {
+        const LogicBlockConfig& block = recipe.logicBlocks[i];
+        if (block.block == nullptr || !items.insert(block.block).second)
+        {
+            error = "logic block " + std::string(block.block ? block.block : "") + " is missing or listed twice";
+            return false;
+        }
+        if ((block.enableLUT & ~lutMask) != 0 || (block.valueLUT & ~lutMask) != 0)
+        {
+            error = std::string(block.block) + " truth table has more rows than inputs";
+            return false;
+        }
+
+        settings.Select("LogicBlockSelector", block.block);
+        settings.Select("LogicBlockLUTSelector", "Enable");
+        settings.SetInt("LogicBlockLUTOutputValueAll", block.enableLUT);
+        settings.Select("LogicBlockLUTSelector", "Value");
+        settings.SetInt("LogicBlockLUTOutputValueAll", block.valueLUT);
+
+        for (unsigned int input = 0; input < k_logicBlockNumInputs; input++)
+        {
+            const LogicBlockInput& source = block.inputs[input];
+            if (source.source == nullptr)
+            {
+                // An input the truth table depends on must be set, or the recipe would
+                // behave differently depending on what was configured before it
+                if (LogicBlockUsesInput(block, input))
+                {
+                    std::ostringstream text;
+                    text << block.block << " truth table depends on Input" << input << ", which has no source";
+                    error = text.str();
+                    return false;
+                }
+                continue;
+            }
+
+            std::ostringstream inputName;
+            inputName << "Input" << input;
+            settings.Select("LogicBlockLUTInputSelector", inputName.str());
+            settings.SetEnum("LogicBlockLUTInputSource", source.source);
+            if (source.activation != nullptr)
+            {
+                settings.SetEnum("LogicBlockLUTInputActivation", source.activation);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < recipe.counters.size(); i++)
+    {
+        const CounterConfig& counter = recipe.counters[i];
+        if (counter.counter == nullptr || !items.insert(counter.counter).second)
+        {
+            error = "counter " + std::string(counter.counter ? counter.counter : "") + " is missing or listed twice";
+            return false;
+        }
+        if (counter.duration < 1)
+        {
+            error = std::string(counter.counter) + " duration must be at least 1";
+            return false;
+        }
+
+        const char* const names[] = {"CounterEventSource",
+                                     "CounterTriggerSource",
+                                     "CounterTriggerActivation",
+                                     "CounterResetSource",
+                                     "CounterResetActivation"};
+        const char* const entries[] = {counter.eventSource,
+                                       counter.triggerSource,
+                                       counter.triggerActivation,
+                                       counter.resetSource,
+                                       counter.resetActivation};
+
+        settings.Select("CounterSelector", counter.counter);
+        for (unsigned int n = 0; n < sizeof(names) / sizeof(names[0]); n++)
+        {
+            if (entries[n] != nullptr)
+            {
+                settings.SetEnum(names[n], entries[n]);
+            }
+        }
+        settings.SetInt("CounterDuration", counter.duration);
+    }
+
+    for (size_t i = 0; i < recipe.lines.size(); i++)
+    {
+        const LineConfig& line = recipe.lines[i];
+        if (line.line == nullptr || !items.insert(line.line).second)
+        {
+            error = "line " + std::string(line.line ? line.line : "") + " is missing or listed twice";
+            return false;
+        }
+
+        settings.Select("LineSelector", line.line);
+        if (line.mode != nullptr)
+        {
+            settings.SetEnum("LineMode", line.mode);
+        }
+        if (line.source != nullptr)
+        {
+            settings.SetEnum("LineSource", line.source);
+        }
+    }
+
+    return true;
+}
+
+// Checks that the camera has every node and enumeration entry the compiled recipe writes
+inline bool ValidateTriggerRecipe(Spinnaker::GenApi::INodeMap& nodeMap, const SettingsProfile& settings, std::string& error)
+{
+    using namespace Spinnaker::GenApi;
+
+    const std::vector<NodeSetting>& list = settings.GetSettings();
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        INode* pNode = nodeMap.GetNode(list[i].name.c_str());
+        if (pNode == nullptr || !IsImplemented(pNode))
+        {
+            error = list[i].name + " is not implemented by this camera";
+            return false;
+        }
+
+        if (list[i].type == SETTING_ENUM)
+        {
+            CEnumerationPtr ptrEnumeration = pNode;
+            if (!ptrEnumeration.IsValid() || ptrEnumeration->GetEntryByName(list[i].value.c_str()) == nullptr)
+            {
+                error = list[i].name + " has no entry " + list[i].value;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+class TriggerRecipeEngine
+{
+public:
+    // The camera must be initialized
+    explicit TriggerRecipeEngine(Spinnaker::CameraPtr pCam)
+        : m_nodeMap(pCam->GetNodeMap()), m_profile(ResolveProfile(pCam)), m_cache(pCam, m_profile)
+    {
+    }
+
+    // Compiles and validates a recipe once; a recipe with the same name replaces the old one
+    bool Load(const TriggerRecipe& recipe, std::string& error)
+    {
+        SettingsProfile settings;
+        if (!CompileTriggerRecipe(recipe, settings, error))
+        {
+            error = recipe.name + ": " + error;
+            return false;
+        }
+
+        try
+        {
+            if (!ValidateTriggerRecipe(m_nodeMap, settings, error))
+            {
+                error = recipe.name + ": " + error;
+                return false;
+            }
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            error = recipe.name + ": " + e.what();
+            return false;
+        }
+
+        m_recipes[recipe.name] = settings;
+        return true;
+    }
+
+    bool IsLoaded(const std::string& name) const
+    {
+        return m_recipes.count(name) != 0;
+    }
+
+    // Applies a loaded recipe, writing only the nodes that differ from what the camera holds
+    bool Apply(const std::string& name, SettingsApplyResult& result)
+    {
+        std::map<std::string, SettingsProfile>::const_iterator recipe = m_recipes.find(name);
+        if (recipe == m_recipes.end())
+        {
+            result = SettingsApplyResult();
+            result.serialNumber = m_profile.serialNumber;
+            result.success = false;
+            result.error = name + " is not loaded";
+            return false;
+        }
+
+        m_activeRecipe = name;
+        return m_cache.Apply(recipe->second, result);
+    }
+
+    // Loads the recipe the first time it is applied, then applies it
+    bool Apply(const TriggerRecipe& recipe, SettingsApplyResult& result)
+    {
+        std::string error;
+        if (!IsLoaded(recipe.name) && !Load(recipe, error))
+        {
+            result = SettingsApplyResult();
+            result.serialNumber = m_profile.serialNumber;
+            result.success = false;
+            result.error = error;
+            return false;
+        }
+        return Apply(recipe.name, result);
+    }
+
+    // Name of the recipe applied last, or empty if none was
+    const std::string& GetActiveRecipe() const
+    {
+        return m_activeRecipe;
+    }
+
+private:
+    static CameraProfile ResolveProfile(Spinnaker::CameraPtr pCam)
+    {
+        CameraProfile profile;
+        profile.Resolve(pCam);
+        return profile;
+    }
+
+    Spinnaker::GenApi::INodeMap& m_nodeMap;
+    CameraProfile m_profile;
+    SettingsCache m_cache;
+    std::map<std::string, SettingsProfile> m_recipes;
+    std::string m_activeRecipe;
+};
+
+// Writes the nodes of the recipe that differ from what the camera holds and prints what was done
+inline bool ConfigureTriggerRecipe(TriggerRecipeEngine& engine, const TriggerRecipe& recipe)
+{
+    std::cout << std::endl << "Configuring the " << recipe.name << " trigger recipe" << std::endl;
+
+    SettingsApplyResult result;
+    const bool applied = engine.Apply(recipe, result);
+    PrintSettingsResult(result);
+    return applied;
+}
+
+#endif // TRIGGER_RECIPE_H
@@ -0,0 +1,61 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+*  @brief WorkerPool.h runs one task per item, such as per camera, on a
+*  fixed number of threads.
+*
+*  RunOnWorkerPool() starts at most numWorkers threads. Each takes the next
+*  item as soon as it is done with its last one, so a slow item only holds up
+*  its own worker while the others carry on with the rest. It returns once
+*  every item is done. Typical use:
+*
+*      RunOnWorkerPool(cameras.size(), 8, [&](size_t i) { Configure(cameras[i]); });
+*/
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+
+// Runs task(i) for every i below numItems on up to numWorkers threads
+template <typename Task> void RunOnWorkerPool(size_t numItems, unsigned int numWorkers, Task task)
+{
+    std::atomic<size_t> nextItem(0);
+    const size_t numThreads = std::min<size_t>(numItems, std::max<unsigned int>(numWorkers, 1u));
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < numThreads; t++)
+    {
+        workers.push_back(std::thread([&]() {
+            for (size_t i = nextItem++; i < numItems; i = nextItem++)
+            {
+                task(i);
+            }
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); t++)
+    {
+        workers[t].join();
+    }
+}
+
+#endif // WORKER_POOL_H
@@ -1,8 +1,13 @@
 #include "Spinnaker.h"
 #include "SpinGenApi/SpinnakerGenApi.h"
+#include "StreamProfile.h"
 #include <iostream>
 #include <sstream>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <set>
 
 using namespace Spinnaker;
 using namespace Spinnaker::GenApi;
@@ -11,6 +16,24 @@ using namespace std;
 
 #define CAM_LIST_REFRESH_TIME 1000
 
+// Stream buffer profile applied to every camera when it arrives after the reset.
+// See StreamProfile.h in the Common folder.
+const streamProfileType chosenStreamProfile = STREAM_PROFILE_NO_DROP;
+
+// Time in milliseconds allowed for every camera to come back after the reset
+const unsigned int k_recoveryTimeout = 30000;
+
+// A camera that has just arrived can take a moment to appear in the camera list;
+// look it up this many times, this many milliseconds apart
+const unsigned int k_arrivalLookupAttempts = 50;
+const unsigned int k_arrivalLookupInterval = 20;
+
+// Grab timeout in milliseconds once the cameras are streaming again
+const unsigned int k_grabTimeout = 1000;
+
+// Serializes console output from the reset threads
+mutex printMutex;
+
 // In the example, InterfaceEventHandler inherits from InterfaceEvent while
 // SystemEventHandler inherits from ArrivalEvent and RemovalEvent. This is
 // done for demonstration purposes and is not a constraint of the SDK. All 
@@ -20,66 +43,228 @@ class SystemEventHandler : public ArrivalEvent, public RemovalEvent
 {
 public:
 
-    SystemEventHandler(SystemPtr system) : m_system(system) {};
+    SystemEventHandler(SystemPtr system) : m_system(system), m_recovering(false), m_numRestarting(0) {};
     ~SystemEventHandler() {};
 
-    // This method defines the arrival event on the system. It retrieves the
-    // number of cameras currently connected and prints it out.
+    // This method defines the arrival event on the system. During a recovery
+    // it re-initializes the camera that arrived, configures its stream buffers
+    // and starts acquisition, then wakes up anyone waiting for the camera to
+    // recover. Arrivals outside a recovery are only reported.
     void OnDeviceArrival(uint64_t deviceSerialNumber)
     {
-        cout << "Device arrival sn: " << deviceSerialNumber << endl;
-
-        CameraPtr pCam = m_system->GetCameras().GetBySerial(to_string(deviceSerialNumber));
-        while (pCam == NULL) {
-            pCam = m_system->GetCameras().GetBySerial(to_string(deviceSerialNumber));
-            cout << "Cam null" << endl;
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Device arrival sn: " << deviceSerialNumber << endl;
         }
 
-        pCam->Init();
+        const string serialNumber = to_string(deviceSerialNumber);
+        bool started = false;
+
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (!m_recovering)
+            {
+                return;
+            }
+            m_numRestarting++;
+        }
 
-        //Configure buffer handling 
-        Spinnaker::GenApi::INodeMap & sNodeMap = pCam->GetTLStreamNodeMap();
-        CEnumerationPtr ptrStreamBufferCountMode = sNodeMap.GetNode("StreamBufferCountMode");
-        CEnumEntryPtr ptrStreamBufferCountModeManual = ptrStreamBufferCountMode->GetEntryByName("Manual");
+        try
+        {
+            CameraPtr pCam = m_system->GetCameras().GetBySerial(serialNumber);
+            for (unsigned int i = 1; pCam == nullptr && i < k_arrivalLookupAttempts; i++)
+            {
+                this_thread::sleep_for(chrono::milliseconds(k_arrivalLookupInterval));
+                pCam = m_system->GetCameras().GetBySerial(serialNumber);
+            }
 
-        ptrStreamBufferCountMode->SetIntValue(ptrStreamBufferCountModeManual->GetValue());
-        //cout << "Stream Buffer Count Mode set to manual..." << endl;
+            if (pCam == nullptr)
+            {
+                lock_guard<mutex> lock(printMutex);
+                cout << "Camera: " << serialNumber << " arrived but is not in the camera list" << endl;
+            }
+            else
+            {
+                pCam->Init();
+
+                //Configure buffer handling 
+                StreamSettings streamSettings;
+                const bool applied = ApplyStreamProfile(pCam, chosenStreamProfile, streamSettings);
+                {
+                    lock_guard<mutex> lock(printMutex);
+                    if (!applied)
+                    {
+                        cout << "Unable to apply every stream buffer setting..." << endl;
+                    }
+                    PrintStreamSettings(streamSettings);
+                }
 
-        CIntegerPtr ptrBufferCount = sNodeMap.GetNode("StreamBufferCountManual");
-        ptrBufferCount->SetValue(10);
-        //cout << "Buffer count now set to: " << ptrBufferCount->GetValue() << endl;
+                pCam->BeginAcquisition();
+                started = true;
+            }
+        }
+        catch (Spinnaker::Exception &e)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Camera: " << serialNumber << " could not be restarted: " << e.what() << endl;
+        }
 
-        pCam->BeginAcquisition();
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_numRestarting--;
+            if (started)
+            {
+                m_recovered.insert(serialNumber);
+            }
+            else
+            {
+                m_failed.insert(serialNumber);
+            }
+        }
+        m_arrival.notify_all();
     }
 
-    // This method defines the removal event on the system. It does the same
-    // as the system arrival event - it retrieves the number of cameras 
-    // currently connected and prints it out.
+    // This method defines the removal event on the system. It ends acquisition
+    // and deinitializes the camera that was removed, if it is still known.
     void OnDeviceRemoval(uint64_t deviceSerialNumber)
     {
-        cout << "Device removal sn: " << deviceSerialNumber << endl;
-        CameraPtr pCam = m_system->GetCameras().GetBySerial(to_string(deviceSerialNumber));
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Device removal sn: " << deviceSerialNumber << endl;
+        }
 
-        if (pCam != NULL && pCam->IsStreaming()) {
-            pCam->EndAcquisition();
-            cout << "Camera: " << deviceSerialNumber << " end acquisition" << endl;
+        try
+        {
+            CameraPtr pCam = m_system->GetCameras().GetBySerial(to_string(deviceSerialNumber));
+
+            if (pCam != nullptr && pCam->IsStreaming()) {
+                pCam->EndAcquisition();
+                lock_guard<mutex> lock(printMutex);
+                cout << "Camera: " << deviceSerialNumber << " end acquisition" << endl;
+            }
+
+            if (pCam != nullptr && pCam->IsInitialized()) {
+                pCam->DeInit();
+                lock_guard<mutex> lock(printMutex);
+                cout << "Camera: " << deviceSerialNumber << " deinit" << endl;
+            }
+        }
+        catch (Spinnaker::Exception &e)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Camera: " << deviceSerialNumber << " could not be released: " << e.what() << endl;
         }
+    }
 
-        if (pCam != NULL && pCam->IsInitialized()) {
-            pCam->DeInit();
-            cout << "Camera: " << deviceSerialNumber << " deinit" << endl;
+    // Forgets earlier arrivals and restarts the cameras that arrive from now
+    // on; call before resetting the cameras
+    void BeginRecovery()
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_recovered.clear();
+        m_failed.clear();
+        m_recovering = true;
+    }
+
+    // Waits until every camera in the list has either been restarted or failed
+    // to restart, or the timeout expires. Recovery then ends: a restart still
+    // in progress is waited for, and cameras arriving later are left alone, so
+    // that the caller can use and release the cameras without the event thread
+    // starting one at the same time. Returns the serial numbers of the cameras
+    // that did not recover.
+    vector<string> WaitForArrivals(const vector<string> & serialNumbers, unsigned int timeoutMs)
+    {
+        const chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs);
+
+        unique_lock<mutex> lock(m_mutex);
+        m_arrival.wait_until(lock, deadline, [&] {
+            for (const string & sn : serialNumbers)
+            {
+                if (m_recovered.count(sn) == 0 && m_failed.count(sn) == 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        });
+
+        m_recovering = false;
+        m_arrival.wait(lock, [this] { return m_numRestarting == 0; });
+
+        vector<string> missing;
+        for (const string & sn : serialNumbers)
+        {
+            if (m_recovered.count(sn) == 0)
+            {
+                missing.push_back(sn);
+            }
         }
+        return missing;
     }
 
 private:
 
     SystemPtr m_system;
+
+    mutex m_mutex;
+    condition_variable m_arrival;
+    bool m_recovering;
+    unsigned int m_numRestarting;
+    set<string> m_recovered;
+    set<string> m_failed;
 };
 
+// This function executes DeviceReset on every camera at once. Each reset runs
+// on its own thread because a camera can take a while to acknowledge the
+// command, and resetting one after the other adds those delays up.
+int ResetCameras(CameraList & camList, const vector<string> & camSerialList)
+{
+    vector<CCommandPtr> resetCommands;
+
+    // Check every camera before resetting any, so that a failure leaves the rig untouched
+    for (const string & sn : camSerialList) {
+        CCommandPtr ptrResetCommand = camList.GetBySerial(sn)->GetNodeMap().GetNode("DeviceReset");
+        if (!IsAvailable(ptrResetCommand) || !IsWritable(ptrResetCommand))
+        {
+            cout << "Unable to execute reset on camera: " << sn << ". Aborting..." << endl;
+            return -1;
+        }
+        resetCommands.push_back(ptrResetCommand);
+    }
+
+    vector<int> results(camSerialList.size(), 0);
+    vector<thread> resetThreads;
+
+    for (unsigned int i = 0; i < camSerialList.size(); i++) {
+        resetThreads.push_back(thread([&, i] {
+            try
+            {
+                resetCommands[i]->Execute();
+            }
+            catch (Spinnaker::Exception &e)
+            {
+                // The camera may drop off the bus before the command is acknowledged
+                lock_guard<mutex> lock(printMutex);
+                cout << "Camera: " << camSerialList[i] << " reset reported: " << e.what() << endl;
+            }
+        }));
+    }
+
+    for (thread & resetThread : resetThreads)
+    {
+        resetThread.join();
+    }
+
+    for (const string & sn : camSerialList) {
+        cout << "Camera: " << sn << " has been reset" << endl;
+    }
+
+    return 0;
+}
 
 // This function acts as the body of the example; please see NodeMapInfo example 
 // for more in-depth comments on setting up cameras.
-int RunMultipleCamera(SystemPtr pSystem)
+int RunMultipleCamera(SystemPtr pSystem, SystemEventHandler & systemEventHandler)
 {
     int result = 0;
 
@@ -103,39 +288,47 @@ int RunMultipleCamera(SystemPtr pSystem)
             cout << "Camera with SN: " << ptrStringSerial->GetValue() << " initialized" << endl;
         }
 
+        //
         // Reset the cameras
-        camList = pSystem->GetCameras();
-
-        for (int i = 0; i < camSerialList.size(); i++) {
-            CCommandPtr ptrResetCommand = camList.GetBySerial(camSerialList[i])->GetNodeMap().GetNode("DeviceReset");
-            if (!IsAvailable(ptrResetCommand) || !IsWritable(ptrResetCommand))
-            {
-                cout << "Unable to execute reset. Aborting..." << endl;
-                return -1;
-            }
+        //
+        // *** NOTES ***
+        // All cameras are reset at the same time. Each camera is initialized
+        // again, configured and started by SystemEventHandler as soon as it
+        // arrives, so the cameras recover in parallel and nothing polls the
+        // camera list in the meantime.
+        //
+        const chrono::steady_clock::time_point resetStart = chrono::steady_clock::now();
 
-            ptrResetCommand->Execute();
+        systemEventHandler.BeginRecovery();
 
-            cout << "Camera: " << camSerialList[i] << " has been reset" << endl;
+        camList = pSystem->GetCameras();
+        if (ResetCameras(camList, camSerialList) < 0)
+        {
+            return -1;
         }
 
-        int camCount = 0;
+        // Release the cameras from before the reset so that the arrivals are not held up by them
+        camList.Clear();
 
+        vector<string> missing = systemEventHandler.WaitForArrivals(camSerialList, k_recoveryTimeout);
 
-        while (camCount < camSerialList.size()) {
-            camList = pSystem->GetCameras();
-            cout << " CameraList size = " << camList.GetSize() << endl;
-            camCount = 0;
+        const long long recoveryTime =
+            chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - resetStart).count();
 
-            for (string& sn : camSerialList) {
-                if (camList.GetBySerial(sn) != NULL &&
-                    camList.GetBySerial(sn)->IsInitialized() &&
-                    camList.GetBySerial(sn)->IsStreaming()) {
-                    camCount++;
-                    cout << " " << sn;
-                }
+        if (!missing.empty())
+        {
+            cout << endl << missing.size() << " of " << camSerialList.size() << " cameras did not recover within "
+                << k_recoveryTimeout << " ms:";
+            for (const string & sn : missing)
+            {
+                cout << " " << sn;
             }
             cout << endl;
+            result = -1;
+        }
+        else
+        {
+            cout << endl << "All " << camSerialList.size() << " cameras recovered in " << recoveryTime << " ms" << endl;
         }
 
         cout << endl;
@@ -145,16 +338,27 @@ int RunMultipleCamera(SystemPtr pSystem)
         // Grab 10 image from each camrea
         for (int j = 0; j < 10; j++) {
             for (int i = 0; i < camList.GetSize(); i++) {
-                ImagePtr pResultImage = camList.GetByIndex(i)->GetNextImage();
+                if (!camList.GetByIndex(i)->IsStreaming())
+                {
+                    continue;
+                }
+                ImagePtr pResultImage = camList.GetByIndex(i)->GetNextImage(k_grabTimeout);
                 CStringPtr ptrStringSerial = camList.GetByIndex(i)->GetTLDeviceNodeMap().GetNode("DeviceSerialNumber");
                 cout << "SN: " << ptrStringSerial->GetValue() << " Image number: " << j << endl;
+                pResultImage->Release();
             }
         }
 
         //De init all
         for (int i = 0; i < camList.GetSize(); i++) {
-            camList.GetByIndex(i)->EndAcquisition();
-            camList.GetByIndex(i)->DeInit();
+            if (camList.GetByIndex(i)->IsStreaming())
+            {
+                camList.GetByIndex(i)->EndAcquisition();
+            }
+            if (camList.GetByIndex(i)->IsInitialized())
+            {
+                camList.GetByIndex(i)->DeInit();
+            }
             CStringPtr ptrStringSerial = camList.GetByIndex(i)->GetTLDeviceNodeMap().GetNode("DeviceSerialNumber");
             cout << "Camera with SN: " << ptrStringSerial->GetValue() << " denitialized" << endl;
         }
@@ -238,7 +442,7 @@ int main(int /*argc*/, char** /*argv*/)
 
     int result = 0;
 
-    RunMultipleCamera(system);
+    result = RunMultipleCamera(system, systemEventHandler);
 
     //
     // Unregister system event from system object
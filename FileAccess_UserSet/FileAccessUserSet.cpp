@@ -35,6 +35,9 @@
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <chrono>
+#include "FileTransfer.h"
+#include "FleetProvisioning.h"
 
 using namespace Spinnaker;
 using namespace Spinnaker::GenApi;
@@ -43,6 +46,7 @@ using namespace std;
 
 static bool _enableDebug = false;
 static gcstring _fileSelector = "UserSet0";
+static bool _uploadToAllCameras = false;
 
 // This function set the exposure time to default(i.e., Auto)
 bool setExposureDefault(INodeMap& nodemap)
@@ -253,94 +257,6 @@ static void PrintDebugMessage(string msg)
     }
 }
 
-// Execute delete operation
-bool ExecuteDeleteCommand(CameraPtr pCam)
-{
-    PrintDebugMessage("Deleting file...");
-    try
-    {
-        pCam->FileOperationSelector.SetValue(FileOperationSelector_Delete);
-        pCam->FileOperationExecute.Execute();
-        if (pCam->FileOperationStatus.GetValue() != FileOperationStatus_Success)
-        {
-            cout << "Failed to delete file!" << endl;
-            return false;
-        }
-    }
-    catch (Spinnaker::Exception& e)
-    {
-        cout << "Unexpected exception : " << e.what() << endl;
-        return false;
-    }
-    return true;
-}
-
-// Open camera file for writing
-bool OpenFileToWrite(CameraPtr pCam)
-{
-    PrintDebugMessage("Opening file for writing...");
-    try
-    {
-        pCam->FileOperationSelector.SetValue(FileOperationSelector_Open);
-        pCam->FileOpenMode.SetValue(FileOpenMode_Write);
-        pCam->FileOperationExecute.Execute();
-        if (pCam->FileOperationStatus.GetValue() != FileOperationStatus_Success)
-        {
-            cout << "Failed to open file for writing!" << endl;
-            return false;
-        }
-    }
-    catch (Spinnaker::Exception& e)
-    {
-        cout << "Unexpected exception : " << e.what();
-        return false;
-    }
-    return true;
-}
-
-// Execute write operation
-bool ExecuteWriteCommand(CameraPtr pCam)
-{
-    try
-    {
-        pCam->FileOperationSelector.SetValue(FileOperationSelector_Write);
-        pCam->FileOperationExecute.Execute();
-        if (pCam->FileOperationStatus.GetValue() != FileOperationStatus_Success)
-        {
-            cout << "Failed to write to file!" << endl;
-            return false;
-        }
-    }
-    catch (Spinnaker::Exception& e)
-    {
-        cout << "Unexpected exception : " << e.what();
-        return false;
-    }
-    return true;
-}
-
-// Close the file
-bool CloseFile(CameraPtr pCam)
-{
-    PrintDebugMessage("Closing file...");
-    try
-    {
-        pCam->FileOperationSelector.SetValue(FileOperationSelector_Close);
-        pCam->FileOperationExecute.Execute();
-        if (pCam->FileOperationStatus.GetValue() != FileOperationStatus_Success)
-        {
-            cout << "Failed to close file!" << endl;
-            return false;
-        }
-    }
-    catch (Spinnaker::Exception& e)
-    {
-        cout << "Unexpected exception : " << e.what();
-        return false;
-    }
-    return true;
-}
-
 // Load user set selector operation
 bool LoadUserSet(CameraPtr pCam)
 {
@@ -375,9 +291,33 @@ bool SaveUserSet(CameraPtr pCam)
     return true;
 }
 
+// Initializes the cameras that take part in a transfer: every camera when
+// uploading to all cameras, otherwise only the first one
+vector<CameraPtr> InitializeCameras(CameraList& camList, CameraPtr pCam, bool allCameras)
+{
+    vector<CameraPtr> cameras;
+    const unsigned int numCameras = allCameras ? camList.GetSize() : 1;
+
+    for (unsigned int i = 0; i < numCameras; i++)
+    {
+        CameraPtr pCamera = allCameras ? camList.GetByIndex(i) : pCam;
+
+        // Retrieve TL device nodemap and print device information
+        PrintDeviceInfo(pCamera->GetTLDeviceNodeMap());
+
+        // Initialize camera
+        pCamera->Init();
+        cameras.push_back(pCamera);
+    }
+
+    return cameras;
+}
+
 // Upload the user set to the camera file
 bool UploadUserSet()
 {
+    bool result = true;
+
     try
     {
         // Prompt the user to enter file name for reading to camera
@@ -399,6 +339,12 @@ bool UploadUserSet()
             return false;
         }
 
+        if (data.empty())
+        {
+            cout << "Empty file. No data will be written to camera." << endl;
+            return false;
+        }
+
         SystemPtr system;
         CameraList camList;
         CameraPtr pCam;
@@ -410,218 +356,52 @@ bool UploadUserSet()
             return false;
         }
 
-        // Retrieve TL device nodemap and print device information
-        INodeMap& nodeMapTLDevice = pCam->GetTLDeviceNodeMap();
-        PrintDeviceInfo(nodeMapTLDevice);
-
-        // Initialize camera
-        pCam->Init();
-
-        // Retrieve GenICam nodemap
-        INodeMap& nodeMap = pCam->GetNodeMap();
+        vector<CameraPtr> cameras = InitializeCameras(camList, pCam, _uploadToAllCameras);
 
+        //
+        // Upload the file to every camera
+        //
+        // *** NOTES ***
+        // FileTransfer looks up the file access nodes once and moves the file
+        // in windows as large as the FileAccessBuffer register allows, from a
+        // buffer allocated once per camera. Each camera is written on its own
+        // thread, so provisioning many cameras takes about as long as one.
+        // Every file is read back and its CRC-32 compared with the upload
+        // before the user set is loaded.
+        //
         cout << endl << "*** UPLOADING FILE ***" << endl;
-        PrintDebugMessage("Fetching \"UserFile1\" Entry from FileSelectorNode...");
+        PrintDebugMessage("Uploading " + to_string(static_cast<long long>(data.size())) + " bytes to " +
+            string(_fileSelector.c_str()) + " on " + to_string(static_cast<long long>(cameras.size())) + " camera(s)...");
 
-        // Check file selector support
-        if (pCam->FileSelector == NULL)
-        {
-            cout << "File selector not supported on device!";
-            return false;
-        }
+        vector<FileTransferResult> results;
+        result = UploadToCameras(cameras, _fileSelector, data, results, true);
 
-        NodeList_t selectorList;
-        pCam->FileSelector.GetEntries(selectorList);
-        for (unsigned int i = 0; i < selectorList.size(); i++)
+        for (unsigned int i = 0; i < cameras.size(); i++)
         {
-            // Get current enum entry node
-            CEnumEntryPtr node = selectorList.at(i);
-            PrintDebugMessage("Setting value to FileSelectorNode...");
+            PrintFileTransferResult(results[i]);
 
-            // Check file selector entry support
-            if (!node || !IsReadable(node))
-            {
-                // Go to next entry node
-                cout << node->GetSymbolic() << " not supported!" << endl;
-                continue;
-            }
-            if (node->GetSymbolic().compare(_fileSelector) == 0)
+            // Execute the user set
+            if (results[i].success)
             {
-                cout << "The node: " << node->GetSymbolic() << endl;
-                PrintDebugMessage("Setting value to FileSelectorNode...");
-
-                // Set file selector
-                pCam->FileSelector.SetIntValue((int64_t)node->GetNumericValue());
-
-                // Delete file on camera before writing in case camera runs out of space
-                if (pCam->FileSize.GetValue() > 0)
-                {
-                    if (ExecuteDeleteCommand(pCam) != true)
-                    {
-                        cout << "Failed to delete file!" << endl;
-                        continue;
-                    }
-                }
-
-                // Open file on camera for write
-                if (OpenFileToWrite(pCam) != true)
-                {
-                    cout << "Failed to open file!" << endl;
-
-                    // Maybe file was not closed properly last time.
-                    // Close and re-open again
-                    if (!CloseFile(pCam))
-                    {
-                        // It fails to close the file. Abort!
-                        cout << "Problem opening file node." << endl;
-                        return false;
-                    }
-
-                    // File was closed. Open again.
-                    if (!OpenFileToWrite(pCam))
-                    {
-                        // Fails again. Abort!
-                        cout << "Problem opening file node." << endl;
-                        return false;
-                    }
-                }
-
-                // Attempt to set FileAccessLength to FileAccessBufferNode length to speed up the write
-                if (pCam->FileAccessLength.GetValue() < pCam->FileAccessBuffer.GetLength())
-                {
-                    try
-                    {
-                        pCam->FileAccessLength.SetValue(pCam->FileAccessBuffer.GetLength());
-                    }
-                    catch (Spinnaker::Exception& e)
-                    {
-                        cout << "Unable to set FileAccessLength to FileAccessBuffer length : " << e.what();
-                    }
-                }
-                // Set File Access Offset to zero if it is not
-                pCam->FileAccessOffset.SetValue(0);
-
-                // Compute number of write operations required
-                int64_t totalBytesToWrite = data.size();
-                int64_t intermediateBufferSize = pCam->FileAccessLength.GetValue();
-                int64_t writeIterations = (totalBytesToWrite / intermediateBufferSize) + (totalBytesToWrite % intermediateBufferSize == 0 ? 0 : 1);
-
-                if (totalBytesToWrite == 0)
-                {
-                    cout << "Empty file. No data will be written to camera." << endl;
-                    return false;
-                }
-
-                PrintDebugMessage("Start saving user set file on camera...");
-                PrintDebugMessage("Total Bytes to write : " + to_string(static_cast<long long>(totalBytesToWrite)));
-                PrintDebugMessage("FileAccessLength : " + to_string(static_cast<long long>(intermediateBufferSize)));
-                PrintDebugMessage("Write Iterations : " + to_string(static_cast<long long>(writeIterations)));
-
-                int64_t index = 0;
-                int64_t bytesLeftToWrite = totalBytesToWrite;
-                int64_t totalBytesWritten = 0;
-                bool paddingRequired = false;
-                int numPaddings = 0;
-
-                cout << "Writing data to device" << endl;
-
-                unsigned char* pFileData = static_cast<unsigned char*>(data.data());
-
-                for (unsigned int i = 0; i < writeIterations; i++)
-                {
-                    // Check whether padding is required
-                    if (intermediateBufferSize > bytesLeftToWrite)
-                    {
-                        // Check for multiple of 4 bytes
-                        unsigned int remainder = bytesLeftToWrite % 4;
-                        if (remainder != 0)
-                        {
-                            paddingRequired = true;
-                            numPaddings = 4 - remainder;
-                        }
-                    }
-
-                    // Setup data to write
-                    int64_t tmpBufferSize = intermediateBufferSize <= bytesLeftToWrite
-                        ? intermediateBufferSize : (bytesLeftToWrite + numPaddings);
-                    std::unique_ptr<unsigned char> tmpBuffer(new unsigned char[tmpBufferSize]);
-                    memcpy(
-                        tmpBuffer.get(),
-                        &pFileData[index],
-                        ((intermediateBufferSize <= bytesLeftToWrite) ? intermediateBufferSize : bytesLeftToWrite));
-
-                    if (paddingRequired)
-                    {
-                        // Fill padded bytes
-                        for (int j = 0; j < numPaddings; j++)
-                        {
-                            unsigned char* pTmpBuffer = tmpBuffer.get();
-                            pTmpBuffer[bytesLeftToWrite + j] = 255;
-                        }
-                    }
-
-                    // Update index for next write iteration
-                    index = index +
-                        (intermediateBufferSize <= bytesLeftToWrite ? intermediateBufferSize : bytesLeftToWrite);
-
-                    // Write to FileAccessBufferNode
-                    pCam->FileAccessBuffer.Set(tmpBuffer.get(), tmpBufferSize);
-
-                    if (intermediateBufferSize > bytesLeftToWrite)
-                    {
-                        // It updates file Access Length Node;
-                        // otherwise, garbage data outside the range
-                        // would be written to device.
-                        pCam->FileAccessLength.SetValue(bytesLeftToWrite);
-                    }
-
-                    // Perform Write command
-                    if (!ExecuteWriteCommand(pCam))
-                    {
-                        cout << "Writing to stream failed!" << endl;
-                        break;
-                    }
-
-                    // Verify size of bytes written
-                    int64_t sizeWritten = pCam->FileOperationResult.GetValue();
-
-                    // Log current file access offset
-                    PrintDebugMessage("File Access Offset: " + to_string(pCam->FileAccessOffset.GetValue()));
-
-                    // Keep track of total bytes written
-                    totalBytesWritten += sizeWritten;
-                    PrintDebugMessage(
-                        "Bytes written: " + to_string(static_cast<long long>(totalBytesWritten)) + " of " +
-                        to_string(static_cast<long long>(totalBytesToWrite)));
-
-                    // Keep track of bytes left to write
-                    bytesLeftToWrite = totalBytesToWrite - totalBytesWritten;
-                    PrintDebugMessage("Bytes left: " + to_string(static_cast<long long>(bytesLeftToWrite)));
-
-                    cout << "Progress : " << (i * 100 / writeIterations) << " %" << endl;
-                }
-
-                cout << "Writing complete" << endl;
-
-                if (!CloseFile(pCam))
-                {
-                    cout << "Failed to close file!" << endl;
-                }
-
-                // Execute the user set
-                LoadUserSet(pCam);
+                LoadUserSet(cameras[i]);
             }
         }
 
+        cout << "Writing complete" << endl;
+
         //
-        // Release reference to the camera
+        // Release reference to the cameras
         //
         // *** NOTES ***
         // Had the CameraPtr object been created within the for-loop, it would not
         // be necessary to manually break the reference because the shared pointer
         // would have automatically cleaned itself up upon exiting the loop.
         //
-        pCam->DeInit();
+        for (unsigned int i = 0; i < cameras.size(); i++)
+        {
+            cameras[i]->DeInit();
+        }
+        cameras.clear();
         pCam = nullptr;
 
         // Clear camera list before releasing system
@@ -638,58 +418,14 @@ bool UploadUserSet()
         cout << "Unexpected exception : " << e.what();
         return false;
     }
-    return true;
-}
-
-// Open camera file to read
-bool OpenFileToRead(CameraPtr pCamera)
-{
-    cout << "Opening file for reading..." << endl;
-    try
-    {
-        pCamera->FileOperationSelector.SetValue(FileOperationSelector_Open);
-        pCamera->FileOpenMode.SetValue(FileOpenMode_Read);
-        pCamera->FileOperationExecute.Execute();
-
-        if (pCamera->FileOperationStatus.GetValue() != FileOperationStatus_Success)
-        {
-            cout << "Failed to open file for reading!" << endl;
-            return false;
-        }
-    }
-    catch (Spinnaker::Exception& e)
-    {
-        cout << "Unexpected exception : " << e.what() << endl;
-        return false;
-    }
-    return true;
-}
-
-// Execute read operation
-bool ExecuteReadCommand(CameraPtr pCamera)
-{
-    try
-    {
-        pCamera->FileOperationSelector.SetValue(FileOperationSelector_Read);
-        pCamera->FileOperationExecute.Execute();
-
-        if (pCamera->FileOperationStatus.GetValue() != FileOperationStatus_Success)
-        {
-            cout << "Failed to read file!" << endl;
-            return false;
-        }
-    }
-    catch (Spinnaker::Exception& e)
-    {
-        cout << "Unexpected exception : " << e.what() << endl;
-        return false;
-    }
-    return true;
+    return result;
 }
 
 // Download the user set to the disk from camera file
 bool DownloadUserSet()
 {
+    bool result = true;
+
     try
     {
         // Prompt the user to enter file name for saving to the disc
@@ -761,126 +497,132 @@ bool DownloadUserSet()
 
         cout << endl << "*** DOWNLOADING File ***" << endl;
 
-        // Check file selector support
-        PrintDebugMessage("Fetching \"UserFile1\" Entry from FileSelectorNode...");
-        if (pCam->FileSelector == NULL)
+        // Write the file to disk chunk by chunk as it is read from the camera
         {
-            cout << "File selector not supported on device!";
-            return false;
+            ofstream ofs(filename, ios_base::binary | ios_base::trunc);
+            if (!ofs)
+            {
+                cout << "Unable to create " << filename << "..." << endl;
+                result = false;
+            }
+            else
+            {
+                FileTransfer transfer(pCam);
+                FileTransferResult transferResult;
+                result = transfer.DownloadStream(_fileSelector, ofs, transferResult);
+                PrintFileTransferResult(transferResult);
+            }
         }
 
-        NodeList_t selectorList;
-        pCam->FileSelector.GetEntries(selectorList);
-        for (unsigned int i = 0; i < selectorList.size(); i++)
+        if (result)
         {
-            // Get current enum entry node
-            CEnumEntryPtr node = selectorList.at(i);
+            cout << "Reading complete" << endl << endl;
+            cout << "*** SAVING USER SET FILE ***" << endl;
+        }
+        else
+        {
+            remove(filename.c_str());
+        }
 
-            PrintDebugMessage("Setting value to FileSelectorNode...");
+        //
+        // Release reference to the camera
+        //
+        // *** NOTES ***
+        // Had the CameraPtr object been created within the for-loop, it would not
+        // be necessary to manually break the reference because the shared pointer
+        // would have automatically cleaned itself up upon exiting the loop.
+        //
+        pCam->DeInit();
+        pCam = nullptr;
 
-            // Check file selector entry support
-            if (!node || !IsReadable(node))
-            {
-                // Go to next entry node
-                cout << node->GetSymbolic() << " not supported!" << endl;
-                continue;
-            }
+        // Clear camera list before releasing system
+        camList.Clear();
 
-            if (node->GetSymbolic().compare(_fileSelector) == 0)
-            {
-                // Set file selector
-                pCam->FileSelector.SetIntValue((int64_t)node->GetNumericValue());
-                int64_t bytesToRead = pCam->FileSize.GetValue();
-                if (bytesToRead == 0)
-                {
-                    cout << "No data available to read!" << endl;
-                    continue;
-                }
-                PrintDebugMessage("Total data to download : " + to_string(static_cast<long long>(bytesToRead)));
-
-                // Open file on camera for reading
-                if (OpenFileToRead(pCam) != true)
-                {
-                    cout << "Failed to open file!" << endl;
-                    continue;
-                }
-                // Attempt to set FileAccessLength to FileAccessBufferNode length to speed up the write
-                if (pCam->FileAccessLength.GetValue() < pCam->FileAccessBuffer.GetLength())
-                {
-                    try
-                    {
-                        pCam->FileAccessLength.SetValue(pCam->FileAccessBuffer.GetLength());
-                    }
-                    catch (Spinnaker::Exception& e)
-                    {
-                        cout << "Unable to set FileAccessLength to FileAccessBuffer length : " << e.what() << endl;
-                    }
-                }
-
-                // Set File Access Offset to zero if its not
-                pCam->FileAccessOffset.SetValue(0);
-
-                // Compute number of read operations required
-                int64_t intermediateBufferSize = pCam->FileAccessLength.GetValue();
-                int64_t iterations = (bytesToRead / intermediateBufferSize) + (bytesToRead % intermediateBufferSize == 0 ? 0 : 1);
-                PrintDebugMessage("Fetching file from camera.");
-                int64_t index = 0;
-                int64_t totalSizeRead = 0;
-                std::unique_ptr<unsigned char> dataBuffer(new unsigned char[bytesToRead]);
-                uint8_t* pData = dataBuffer.get();
-
-                for (unsigned int i = 0; i < iterations; i++)
-                {
-                    if (!ExecuteReadCommand(pCam))
-                    {
-                        cout << "Reading stream failed!" << endl;
-                        break;
-                    }
-
-                    // Verify size of bytes read
-                    int64_t sizeRead = pCam->FileOperationResult.GetValue();
-
-                    // Read from buffer Node
-                    pCam->FileAccessBuffer.Get(&pData[index], sizeRead);
-
-                    // Update index for next read iteration
-                    index = index + sizeRead;
-
-                    // Keep track of total bytes read
-                    totalSizeRead += sizeRead;
-                    PrintDebugMessage(
-                        "Bytes read: " + to_string(static_cast<long long>(totalSizeRead)) + " of "
-                        + to_string(static_cast<long long>(bytesToRead)));
-                    cout << "Progress : " << (i * 100 / iterations) << " %" << endl;
-                }
-
-                cout << "Reading complete" << endl;
-
-                if (!CloseFile(pCam))
-                {
-                    cout << "Failed to close file!" << endl;
-                }
-                cout << endl;
+        // Release system
+        system->ReleaseInstance();
 
-                // save file
-                ofstream ofs(filename, ios_base::binary | ios_base::trunc);
+        cout << endl << "Done! Press Enter to exit..." << endl;
+        getchar();
+    }
+    catch (Spinnaker::Exception& e)
+    {
+        cout << "Unexpected exception : " << e.what() << endl;
+        return false;
+    }
+    return result;
+}
+// Set the exposure time of every connected camera and save it to the user set, all cameras at once
+bool ProvisionUserSets()
+{
+    bool result = true;
 
-                ofs.write((char*)&pData[0], totalSizeRead);
-                ofs.close();
+    try
+    {
+        // Prompt the user to enter a value of exposure time to set
+        cout << "Please enter the choice of exposure time in microseconds: ";
+        double exp;
+        (cin >> exp).get();
 
-                cout << "*** SAVING USER SET FILE ***" << endl;
-            }
+        // Check if cin is valid
+        if (!cin || exp <= 0.0) {
+            cerr << "Error: Invalid input detected" << endl;
+
+            //clear the buffer
+            cin.clear();
+            while (cin.get() != '\n')continue;
+            return false;
         }
+
+        SystemPtr system;
+        CameraList camList;
+        CameraPtr pCam;
+
+        // Initialize System
+        if (!InitializeSystem(system, camList, pCam))
+        {
+            PrintResultMessage(false);
+            return false;
+        }
+        pCam = nullptr;
+
+        vector<CameraPtr> cameras;
+        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        {
+            cameras.push_back(camList.GetByIndex(i));
+        }
+
         //
-        // Release reference to the camera
+        // Provision every camera
+        //
+        // *** NOTES ***
+        // The System is opened once for the whole fleet, and a pool of
+        // workers initializes, configures and saves up to
+        // k_maxConcurrentProvisioning cameras at the same time. Every camera
+        // is deinitialized again by its worker, so the user set files can be
+        // downloaded or uploaded right after.
+        //
+        cout << endl << "*** PROVISIONING " << cameras.size() << " CAMERA(S) ***" << endl;
+
+        ProvisioningProfile profile = ProvisioningProfile();
+        profile.exposureTime = exp;
+        profile.userSet = _fileSelector;
+
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        vector<ProvisioningResult> results;
+        result = ProvisionCameras(cameras, profile, results);
+
+        PrintProvisioningResults(results, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+
+        //
+        // Release reference to the cameras
         //
         // *** NOTES ***
         // Had the CameraPtr object been created within the for-loop, it would not
         // be necessary to manually break the reference because the shared pointer
         // would have automatically cleaned itself up upon exiting the loop.
         //
-        pCam->DeInit();
-        pCam = nullptr;
+        cameras.clear();
 
         // Clear camera list before releasing system
         camList.Clear();
@@ -896,8 +638,9 @@ bool DownloadUserSet()
         cout << "Unexpected exception : " << e.what() << endl;
         return false;
     }
-    return true;
+    return result;
 }
+
 // Print out usage of the application
 void PrintUsage()
 {
@@ -906,6 +649,8 @@ void PrintUsage()
     cout << "Options:" << endl;
     cout << "/d : Prompt the user to enter exposure time in microseconds, store the user set file on the current folder with giving file name" << endl;
     cout << "/u : Read the user set file with giving file name, upload it to camera and print the current exposure value." << endl;
+    cout << "/a : Upload to every connected camera at the same time (use before /u)." << endl;
+    cout << "/p : Prompt the user to enter exposure time in microseconds and save it to the user set of every connected camera at the same time." << endl;
     cout << "/v : Enable verbose output." << endl;
     cout << "/? : Print usage informaion." << endl;
     cout << endl << endl;
@@ -947,6 +692,11 @@ int main(int argc, char* argv[])
             _enableDebug = true;
         }
 
+        if (args[i] == "/a" || args[i] == "/A")
+        {
+            _uploadToAllCameras = true;
+        }
+
         if (args[i] == "?")
         {
             PrintUsage();
@@ -960,6 +710,16 @@ int main(int argc, char* argv[])
             }
         }
 
+        else if (args[i] == "/p" || args[i] == "/P")
+        {
+            if (!ProvisionUserSets())
+            {
+                PrintResultMessage(false);
+                return -1;
+            }
+            return result;
+        }
+
         else if (args[i] == "/d" || args[i] == "/D")
         {
             if (!DownloadUserSet())
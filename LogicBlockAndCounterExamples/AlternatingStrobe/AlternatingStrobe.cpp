@@ -40,12 +40,24 @@
 #include "SpinGenApi/SpinnakerGenApi.h"
 #include <iostream>
 #include <sstream>
+#include "ImageEventQueue.h"
+#include "TriggerRecipe.h"
 
 using namespace Spinnaker;
 using namespace Spinnaker::GenApi;
 using namespace Spinnaker::GenICam;
 using namespace std;
 
+// Images are delivered through ImageEventQueue.h, which describes the backpressure policies.
+// The camera runs at FRAME_RATE, so an image that has not arrived within k_triggerTimeout
+// milliseconds, for example because a trigger left on by an earlier setup holds the camera
+// back, aborts the run. A reminder is printed every k_triggerReminderInterval meanwhile.
+// Set k_triggerTimeout to 0 to wait for each image without a limit.
+const unsigned int k_triggerTimeout = 10000;
+const unsigned int k_triggerReminderInterval = 5000;
+const size_t k_imageQueueDepth = 4;
+const backpressurePolicy chosenBackpressure = BACKPRESSURE_DROP_OLDEST;
+
 #define ALTERNATING_TRIGGER_DELAY_US 10000
 #define EXPOSURE_LENGTH_US 20000
 #define STROBE_DURATION_US 10000
@@ -67,157 +79,45 @@ bool LoadDefaultUserSet(CameraPtr pCam)
     return true;
 }
 
-// LocicBlock0 takes LogicBlock1 as input determine if the
-// offset is to be applied.
-// If LogicBlock1 = 0, LogicBlock0 has a rising edge on ExposureStart.
+// Logic blocks, counters and lines of the alternating strobe
+//
+// LocicBlock0 takes LogicBlock1 as input determine if the offset is to be
+// applied. If LogicBlock1 = 0, LogicBlock0 has a rising edge on ExposureStart.
 // If LogicBlock1 = 1, LogicBlock0 has a rising edge on Counter0End.
-bool ConfigureLogicBlock0(CameraPtr pCam)
-{
-    cout << endl << endl << "Configuring Logic Block 0" << endl << endl;
-    try
-    {
-        pCam->LogicBlockSelector.SetValue(LogicBlockSelector_LogicBlock0);
-
-        pCam->LogicBlockLUTSelector.SetValue(LogicBlockLUTSelector_Enable);
-        pCam->LogicBlockLUTOutputValueAll.SetValue(0xFF);
-
-        pCam->LogicBlockLUTSelector.SetValue(LogicBlockLUTSelector_Value);
-        pCam->LogicBlockLUTOutputValueAll.SetValue(0xCA);
-
-        pCam->LogicBlockLUTInputSelector.SetValue(LogicBlockLUTInputSelector_Input0);
-        pCam->LogicBlockLUTInputSource.SetValue(LogicBlockLUTInputSource_ExposureStart);
-        pCam->LogicBlockLUTInputActivation.SetValue(LogicBlockLUTInputActivation_RisingEdge);
-
-        pCam->LogicBlockLUTInputSelector.SetValue(LogicBlockLUTInputSelector_Input1);
-        pCam->LogicBlockLUTInputSource.SetValue(LogicBlockLUTInputSource_Counter0End);
-        pCam->LogicBlockLUTInputActivation.SetValue(LogicBlockLUTInputActivation_RisingEdge);
-
-        pCam->LogicBlockLUTInputSelector.SetValue(LogicBlockLUTInputSelector_Input2);
-        pCam->LogicBlockLUTInputSource.SetValue(LogicBlockLUTInputSource_LogicBlock1);
-        pCam->LogicBlockLUTInputActivation.SetValue(LogicBlockLUTInputActivation_LevelHigh);
-    }
-    catch (Spinnaker::Exception &e)
-    {
-        cout << "Error: " << e.what() << endl;
-        return false;
-    }
-    return true;
-}
-
+//
 // LogicBlock1 is used like a T-flipflop in order to hold a state logic value
-// that will be toggled on each ExposureEnd event.
-bool ConfigureLogicBlock1(CameraPtr pCam)
-{
-    cout << endl << "Configuring Logic Block 1" << endl;
-    try
-    {
-        pCam->LogicBlockSelector.SetValue(LogicBlockSelector_LogicBlock1);
-
-        pCam->LogicBlockLUTSelector.SetValue(LogicBlockLUTSelector_Enable);
-        pCam->LogicBlockLUTOutputValueAll.SetValue(0xAF);
-
-        pCam->LogicBlockLUTSelector.SetValue(LogicBlockLUTSelector_Value);
-        pCam->LogicBlockLUTOutputValueAll.SetValue(0x20);
-
-        pCam->LogicBlockLUTInputSelector.SetValue(LogicBlockLUTInputSelector_Input0);
-        pCam->LogicBlockLUTInputSource.SetValue(LogicBlockLUTInputSource_ExposureEnd);
-        pCam->LogicBlockLUTInputActivation.SetValue(LogicBlockLUTInputActivation_RisingEdge);
-
-        pCam->LogicBlockLUTInputSelector.SetValue(LogicBlockLUTInputSelector_Input1);
-        pCam->LogicBlockLUTInputSource.SetValue(LogicBlockLUTInputSource_LogicBlock1);
-        pCam->LogicBlockLUTInputActivation.SetValue(LogicBlockLUTInputActivation_LevelHigh);
-
-        // UserOutput1 is used to activate the alternating behavior and initialize/reset
-        // the LogicBlock1 value to 0. Begin with UserOutput1=0 to intialize the
-        // Logic Block Q value to 0.
-        pCam->LogicBlockLUTInputSelector.SetValue(LogicBlockLUTInputSelector_Input2);
-        pCam->LogicBlockLUTInputSource.SetValue(LogicBlockLUTInputSource_UserOutput1);
-        pCam->LogicBlockLUTInputActivation.SetValue(LogicBlockLUTInputActivation_LevelHigh);
-    }
-    catch (Spinnaker::Exception &e)
-    {
-        cout << "Error: " << e.what() << endl;
-        return false;
-    }
-    return true;
-}
-
-// Counter0 is used as a MHz timer to count to alternating DelayTimeUS microseconds
-// starting on Exposure Start.
-bool ConfigureCounter0(CameraPtr pCam, uint64_t alternatingDelayTimeUS)
-{
-    cout << endl << "Configuring Counter 0" << endl;
-    try
-    {
-        pCam->CounterSelector.SetValue(CounterSelector_Counter0);
-        pCam->CounterEventSource.SetValue(CounterEventSource_MHzTick);
-        pCam->CounterTriggerSource.SetValue(CounterTriggerSource_Off);
-        pCam->CounterResetSource.SetValue(CounterResetSource_ExposureStart);
-        pCam->CounterResetActivation.SetValue(CounterResetActivation_RisingEdge);
-        pCam->CounterDuration.SetValue(alternatingDelayTimeUS);
-    }
-    catch (Spinnaker::Exception &e)
-    {
-        cout << "Error: " << e.what() << endl;
-        return false;
-    }
-    return true;
-}
-
-// Counter1 is used as a MHz timer to count to strobeDurrationUS microseconds
-// Starting on LogicBlock0 Rising Edge.
-bool ConfigureCounter1(CameraPtr pCam, uint64_t strobeDurrationUS)
+// that will be toggled on each ExposureEnd event. UserOutput1 is used to
+// activate the alternating behavior and initialize/reset the LogicBlock1
+// value to 0.
+//
+// Counter0 is used as a MHz timer to count to alternatingDelayTimeUS
+// microseconds starting on Exposure Start, and Counter1 to count to
+// strobeDurrationUS microseconds starting on LogicBlock0 Rising Edge.
+//
+// Line2 outputs the custom strobe signal, and Line1 the Exposure Active
+// signal for debugging (Optional).
+TriggerRecipe GetAlternatingStrobeRecipe(uint64_t alternatingDelayTimeUS, uint64_t strobeDurrationUS)
 {
-    cout << endl << "Configuring Counter 1" << endl;
-    try
-    {
-        pCam->CounterSelector.SetValue(CounterSelector_Counter1);
-        pCam->CounterEventSource.SetValue(CounterEventSource_MHzTick);
-        pCam->CounterTriggerSource.SetValue(CounterTriggerSource_Off);
-        pCam->CounterResetSource.SetValue(CounterResetSource_LogicBlock0);
-        pCam->CounterResetActivation.SetValue(CounterResetActivation_RisingEdge);
-        pCam->CounterDuration.SetValue(strobeDurrationUS);
-    }
-    catch (Spinnaker::Exception &e)
-    {
-        cout << "Error: " << e.what() << endl;
-        return false;
-    }
-    return true;
-}
-
-// Output used to output the custom strobe signal
-bool ConfigureLine2(CameraPtr pCam) {
-    cout << endl << "Configuring Line 2" << endl;
-    try
-    {
-        pCam->LineSelector.SetValue(LineSelector_Line2);
-        pCam->LineMode.SetValue(LineMode_Output);
-        pCam->LineSource.SetValue(LineSource_Counter1Active);
-    }
-    catch (Spinnaker::Exception &e)
-    {
-        cout << "Error: " << e.what() << endl;
-        return false;
-    }
-    return true;
-}
-
-// Strobe Exposure Active Output signal, for debugging (Optional)
-bool ConfigureLine1(CameraPtr pCam) {
-    cout << endl << "Configuring Line 1" << endl;
-    try
-    {
-        pCam->LineSelector.SetValue(LineSelector_Line1);
-        pCam->LineMode.SetValue(LineMode_Output);
-        pCam->LineSource.SetValue(LineSource_ExposureActive);
-    }
-    catch (Spinnaker::Exception &e)
-    {
-        cout << "Error: " << e.what() << endl;
-        return false;
-    }
-    return true;
+    TriggerRecipe recipe;
+    recipe.name = "AlternatingStrobe";
+
+    recipe.logicBlocks = {
+        {"LogicBlock0",
+         0xFF,
+         0xCA,
+         {{"ExposureStart", "RisingEdge"}, {"Counter0End", "RisingEdge"}, {"LogicBlock1", "LevelHigh"}}},
+        {"LogicBlock1",
+         0xAF,
+         0x20,
+         {{"ExposureEnd", "RisingEdge"}, {"LogicBlock1", "LevelHigh"}, {"UserOutput1", "LevelHigh"}}}};
+
+    recipe.counters = {
+        {"Counter0", "MHzTick", "Off", nullptr, "ExposureStart", "RisingEdge", static_cast<int64_t>(alternatingDelayTimeUS)},
+        {"Counter1", "MHzTick", "Off", nullptr, "LogicBlock0", "RisingEdge", static_cast<int64_t>(strobeDurrationUS)}};
+
+    recipe.lines = {{"Line2", "Output", "Counter1Active"}, {"Line1", "Output", "ExposureActive"}};
+
+    return recipe;
 }
 
 bool ConfigureFrameRate(CameraPtr pCam, double frameRate)
@@ -310,29 +210,51 @@ bool AcquireImages(CameraPtr pCam)
         pCam->UserOutputSelector.SetValue(UserOutputSelector_UserOutput1);
         pCam->UserOutputValue.SetValue(true);
 
+        // Deliver images through the event handler instead of polling GetNextImage()
+        ImageEventQueue imageQueue(k_imageQueueDepth, chosenBackpressure);
+        ImageEventRegistration imageEvents(pCam, imageQueue);
+
         pCam->BeginAcquisition();
 
         cout << "Acquiring images..." << endl;
 
         const int unsigned k_numImages = 100;
+        bool failed = false;
 
         for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
         {
             try
             {
-                ImagePtr pResultImage = pCam->GetNextImage();
+                QueuedImage image;
+                unsigned int waitedMs = 0;
+                bool received = false;
+                while (!(received = imageQueue.WaitForImage(image, k_triggerReminderInterval)))
+                {
+                    waitedMs += k_triggerReminderInterval;
+                    if (k_triggerTimeout > 0 && waitedMs >= k_triggerTimeout)
+                    {
+                        break;
+                    }
+                    cout << "Still waiting for the trigger of image " << imageCnt << "..." << endl;
+                }
+                if (!received)
+                {
+                    cout << "No image within " << waitedMs << " ms; the trigger may have been missed, aborting..." << endl << endl;
+                    failed = true;
+                    break;
+                }
 
-                if (pResultImage->IsIncomplete())
+                if (image.incomplete)
                 {
-                    cout << "Image incomplete with image status " << pResultImage->GetImageStatus() << "..." << endl << endl;
+                    cout << "Image incomplete with image status " << image.imageStatus << "..." << endl << endl;
                 }
                 else
                 {
-                    cout << "Grabbed image " << imageCnt << ", width = " << pResultImage->GetWidth() << ", height = " << pResultImage->GetHeight() << endl;
+                    cout << "Grabbed image " << imageCnt << ", width = " << image.pImage->GetWidth() << ", height = " << image.pImage->GetHeight() << endl;
                     // Omitting image conversion and saving for brevity. See Acquisition.cpp for how to convert and save images
                 }
 
-                pResultImage->Release();
+                imageQueue.Release(image);
 
                 cout << endl;
             }
@@ -344,17 +266,19 @@ bool AcquireImages(CameraPtr pCam)
 
         pCam->EndAcquisition();
 
+        imageQueue.PrintStatistics();
+
         // Disable Alternating Strobe
         pCam->UserOutputSelector.SetValue(UserOutputSelector_UserOutput1);
         pCam->UserOutputValue.SetValue(false);
+
+        return failed;
     }
     catch (Spinnaker::Exception &e)
     {
         cout << "Error: " << e.what() << endl;
         return true;
     }
-
-    return false;
 }
 
 int RunSingleCamera(CameraPtr pCam)
@@ -391,37 +315,13 @@ int RunSingleCamera(CameraPtr pCam)
             return -1;
         }
 
-        if (!ConfigureLine2(pCam))
-        {
-            return -1;
-        }
-
-        // Configure Line 1 Exposure active output for debugging (Optional)
-        if (!ConfigureLine1(pCam))
-        {
-            return -1;
-        }
-
         // Ensure that user output 1 is false initially to initialize logic block Q value
         pCam->UserOutputSelector.SetValue(UserOutputSelector_UserOutput1);
         pCam->UserOutputValue.SetValue(false);
 
-        if (!ConfigureLogicBlock0(pCam))
-        {
-            return -1;
-        }
-
-        if (!ConfigureLogicBlock1(pCam))
-        {
-            return -1;
-        }
-
-        if (!ConfigureCounter0(pCam, ALTERNATING_TRIGGER_DELAY_US))
-        {
-            return -1;
-        }
-
-        if (!ConfigureCounter1(pCam, STROBE_DURATION_US))
+        // Configure the logic blocks, counters and lines from one recipe
+        TriggerRecipeEngine engine(pCam);
+        if (!ConfigureTriggerRecipe(engine, GetAlternatingStrobeRecipe(ALTERNATING_TRIGGER_DELAY_US, STROBE_DURATION_US)))
         {
             return -1;
         }
@@ -103,11 +103,19 @@ Enable LUT: 0xEF
 
 */
 
+#include <atomic>
 #include <iostream>
 #include <sstream>
+// NOMINMAX keeps the min and max macros of windows.h away from std::min and std::max in the shared headers
+#define NOMINMAX
 #include <windows.h>
 #include "Spinnaker.h"
 #include "SpinGenApi/SpinnakerGenApi.h"
+#include "RawRecorder.h"
+#include "BurstCapture.h"
+#include "StreamProfile.h"
+#include "TriggerRecipe.h"
+#include "TriggerLatency.h"
 
 // spacing between bursts in a trigger
 #define uS_BETWEEN_TRIGGER    5000
@@ -122,777 +130,106 @@ using namespace Spinnaker::GenApi;
 using namespace Spinnaker::GenICam;
 using namespace std;
 
-int UserOutputSet(INodeMap & nodeMap, char * userOutputStr, bool val)
-{
-    int result = 0;
-
-    // Configure the user output
-    CEnumerationPtr ptrUserOutputSelector = nodeMap.GetNode("UserOutputSelector");
-
-    if (!IsAvailable(ptrUserOutputSelector) || !IsWritable(ptrUserOutputSelector))
-    {
-        cout << "Unable to set UserOutputSelector (enum retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrUserOutput = ptrUserOutputSelector->GetEntryByName(userOutputStr);
-    if (!IsAvailable(ptrUserOutput) || !IsReadable(ptrUserOutput))
-    {
-        cout << "Unable to set FrameTriggerWait (entry retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    int64_t userInput = ptrUserOutput->GetValue();
-
-    ptrUserOutputSelector->SetIntValue(userInput);
-
-    CBooleanPtr ptrOutputValue = nodeMap.GetNode("UserOutputValue");
-    if (!IsAvailable(ptrOutputValue) || !IsWritable(ptrOutputValue))
-    {
-        cout << "Unable to set User Output Enable (boolean retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    ptrOutputValue->SetValue(val);
-
-    return result;
-}
-
-void UserOutputPulse(INodeMap & nodeMap, char *  userOutputStr, uint32_t pulseLength_milli) {
-    UserOutputSet(nodeMap, userOutputStr, true);
-    Sleep(pulseLength_milli);
-    UserOutputSet(nodeMap, userOutputStr, false);
-}
-
-// Configure counter 0
-int SetupCounter0(INodeMap & nodeMap, int burstCount)
-{
-    int result = 0;
-
-    cout << endl << "Configuring Pulse Width Modulation signal" << endl;
-
-    try
-    {
-        // Set Counter Selector to Counter 0
-        CEnumerationPtr ptrCounterSelector = nodeMap.GetNode("CounterSelector");
-
-        // Check to see if camera supports Counter and Timer functionality
-        if (!IsAvailable(ptrCounterSelector))
-        {
-            cout << endl << "Camera does not support Counter and Timer Functionality. Aborting..." << endl;
-            return -1;
-        }
-
-        if (!IsAvailable(ptrCounterSelector) || !IsWritable(ptrCounterSelector))
-        {
-            cout << "Unable to set Counter Selector (enum retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        CEnumEntryPtr ptrCounter0 = ptrCounterSelector->GetEntryByName("Counter0");
-        if (!IsAvailable(ptrCounter0) || !IsReadable(ptrCounter0))
-        {
-            cout << "Unable to set Counter Selector (entry retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        int64_t counter0 = ptrCounter0->GetValue();
-
-        ptrCounterSelector->SetIntValue(counter0);
-
-        // Set Counter Duration to input value
-        CIntegerPtr ptrCounterDuration = nodeMap.GetNode("CounterDuration");
-        if (!IsAvailable(ptrCounterDuration) || !IsWritable(ptrCounterDuration))
-        {
-            cout << "Unable to set Counter Duration (integer retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        ptrCounterDuration->SetValue(burstCount);
-
-        // Set Counter Event Source to ExposureStart
-        CEnumerationPtr ptrCounterEventSource = nodeMap.GetNode("CounterEventSource");
-        if (!IsAvailable(ptrCounterEventSource) || !IsWritable(ptrCounterEventSource))
-        {
-            cout << "Unable to set Counter Event Source (enum retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        CEnumEntryPtr ptrCounterEventSourceExposureStart = ptrCounterEventSource->GetEntryByName("ExposureStart");
-        if (!IsAvailable(ptrCounterEventSourceExposureStart) || !IsReadable(ptrCounterEventSourceExposureStart))
-        {
-            cout << "Unable to set Counter Event Source (entry retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        int64_t counterEventSourceExposureStart = ptrCounterEventSourceExposureStart->GetValue();
-
-        ptrCounterEventSource->SetIntValue(counterEventSourceExposureStart);
-
-        // Set Counter 0 Trigger Source to UserOutput0
-        CEnumerationPtr ptrCounterTriggerSource = nodeMap.GetNode("CounterTriggerSource");
-        if (!IsAvailable(ptrCounterTriggerSource) || !IsWritable(ptrCounterTriggerSource))
-        {
-            cout << "Unable to set Counter Trigger Source (enum retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        CEnumEntryPtr ptrCounterTriggerSourceUserOutput0 = ptrCounterTriggerSource->GetEntryByName("UserOutput0");
-        if (!IsAvailable(ptrCounterTriggerSourceUserOutput0) || !IsReadable(ptrCounterTriggerSourceUserOutput0))
-        {
-            cout << "Unable to set Counter Trigger Source (entry retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        int64_t counterTriggerSourceUserOutput0 = ptrCounterTriggerSourceUserOutput0->GetValue();
-
-        ptrCounterTriggerSource->SetIntValue(counterTriggerSourceUserOutput0);
-
-        // Set Counter Trigger Activation to Rising Edge
-        CEnumerationPtr ptrCounterTriggerActivation = nodeMap.GetNode("CounterTriggerActivation");
-        if (!IsAvailable(ptrCounterTriggerActivation) || !IsWritable(ptrCounterTriggerActivation))
-        {
-            cout << "Unable to set Counter Trigger Activation (enum retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        CEnumEntryPtr ptrCounterTriggerActivationRE = ptrCounterTriggerActivation->GetEntryByName("RisingEdge");
-        if (!IsAvailable(ptrCounterTriggerActivationRE) || !IsReadable(ptrCounterTriggerActivationRE))
-        {
-            cout << "Unable to set Counter Trigger Activation (entry retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        int64_t counterTriggerActivationRE = ptrCounterTriggerActivationRE->GetValue();
-
-        ptrCounterTriggerActivation->SetIntValue(counterTriggerActivationRE);
-    }
-    catch (Spinnaker::Exception &e)
-    {
-        cout << "Error: " << e.what() << endl;
-        result = -1;
-    }
-
-    return result;
-}
-
-// configure Counter 1
-int SetupCounter1(INodeMap & nodeMap, int microSecondsBetweenTriggers)
-{
-    int result = 0;
-
-    cout << endl << "Configuring Pulse Width Modulation signal" << endl;
-
-    try
-    {
-        // Set Counter Selector to Counter 1
-        CEnumerationPtr ptrCounterSelector = nodeMap.GetNode("CounterSelector");
-
-        // Check to see if camera supports Counter and Timer functionality
-        if (!IsAvailable(ptrCounterSelector))
-        {
-            cout << endl << "Camera does not support Counter and Timer Functionality.  Aborting..." << endl;
-            return -1;
-        }
-
-        if (!IsAvailable(ptrCounterSelector) || !IsWritable(ptrCounterSelector))
-        {
-            cout << "Unable to set Counter Selector (enum retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        CEnumEntryPtr ptrCounter1 = ptrCounterSelector->GetEntryByName("Counter1");
-        if (!IsAvailable(ptrCounter1) || !IsReadable(ptrCounter1))
-        {
-            cout << "Unable to set Counter Selector (entry retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        int64_t counter1 = ptrCounter1->GetValue();
-
-        ptrCounterSelector->SetIntValue(counter1);
-
-        // Set Counter Duration to input value
-        CIntegerPtr ptrCounterDuration = nodeMap.GetNode("CounterDuration");
-        if (!IsAvailable(ptrCounterDuration) || !IsWritable(ptrCounterDuration))
-        {
-            cout << "Unable to set Counter Duration (integer retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        ptrCounterDuration->SetValue(microSecondsBetweenTriggers);
-
-        // Set Counter Event Source to MHzTick
-        CEnumerationPtr ptrCounterEventSource = nodeMap.GetNode("CounterEventSource");
-        if (!IsAvailable(ptrCounterEventSource) || !IsWritable(ptrCounterEventSource))
-        {
-            cout << "Unable to set Counter Event Source (enum retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        CEnumEntryPtr ptrCounterEventSourceMHzTick = ptrCounterEventSource->GetEntryByName("MHzTick");
-        if (!IsAvailable(ptrCounterEventSourceMHzTick) || !IsReadable(ptrCounterEventSourceMHzTick))
-        {
-            cout << "Unable to set Counter Event Source (entry retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        int64_t counterEventSourceMHzTick = ptrCounterEventSourceMHzTick->GetValue();
-
-        ptrCounterEventSource->SetIntValue(counterEventSourceMHzTick);
-
-        // Set Counter 0 Trigger Source to LogicBlock1
-        CEnumerationPtr ptrCounterTriggerSource = nodeMap.GetNode("CounterTriggerSource");
-        if (!IsAvailable(ptrCounterTriggerSource) || !IsWritable(ptrCounterTriggerSource))
-        {
-            cout << "Unable to set Counter Trigger Source (enum retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        CEnumEntryPtr ptrCounterTriggerSourceLB0 = ptrCounterTriggerSource->GetEntryByName("LogicBlock0");
-        if (!IsAvailable(ptrCounterTriggerSourceLB0) || !IsReadable(ptrCounterTriggerSourceLB0))
-        {
-            cout << "Unable to set Counter Trigger Source (entry retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        int64_t counterTriggerSourceLB0 = ptrCounterTriggerSourceLB0->GetValue();
-
-        ptrCounterTriggerSource->SetIntValue(counterTriggerSourceLB0);
-
-        // Set Counter Trigger Activation to Level High
-        CEnumerationPtr ptrCounterTriggerActivation = nodeMap.GetNode("CounterTriggerActivation");
-        if (!IsAvailable(ptrCounterTriggerActivation) || !IsWritable(ptrCounterTriggerActivation))
-        {
-            cout << "Unable to set Counter Trigger Activation (enum retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        CEnumEntryPtr ptrCounterTriggerActivationLH = ptrCounterTriggerActivation->GetEntryByName("LevelHigh");
-        if (!IsAvailable(ptrCounterTriggerActivationLH) || !IsReadable(ptrCounterTriggerActivationLH))
-        {
-            cout << "Unable to set Counter Trigger Activation (entry retrieval). Aborting..." << endl << endl;
-            return -1;
-        }
-
-        int64_t counterTriggerActivationLH = ptrCounterTriggerActivationLH->GetValue();
-
-        ptrCounterTriggerActivation->SetIntValue(counterTriggerActivationLH);
-    }
-    catch (Spinnaker::Exception &e)
-    {
-        cout << "Error: " << e.what() << endl;
-        result = -1;
-    }
-
-    return result;
-}
-
-// This function does the logic block 0 configuration
-int ConfigureLogicBlock0(INodeMap & nodeMap)
-{
-    int result = 0;
-
-    cout << endl << endl << "*** CONFIGURING LOGIC BLOCKS ***" << endl << endl;
-
-    // Select Logic Block 0
-    CEnumerationPtr ptrLogicBlockSelector = nodeMap.GetNode("LogicBlockSelector");
-    if (!IsAvailable(ptrLogicBlockSelector) || !IsReadable(ptrLogicBlockSelector))
-    {
-        cout << "Unable to set logic block selector to Logic Block 0 (node retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLogicBlock0 = ptrLogicBlockSelector->GetEntryByName("LogicBlock0");
-    if (!IsAvailable(ptrLogicBlock0) || !IsReadable(ptrLogicBlock0))
-    {
-        cout << "Unable to set logic block selector to Logic Block 0 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLogicBlockSelector->SetIntValue(ptrLogicBlock0->GetValue());
-
-    cout << "Logic Block 0 selected...." << endl;
-
-    // Set Logic Block LUT to Enable
-    CEnumerationPtr ptrLBLUTSelector = nodeMap.GetNode("LogicBlockLUTSelector");
-    if (!IsAvailable(ptrLBLUTSelector) || !IsReadable(ptrLBLUTSelector))
-    {
-        cout << "Unable to set LUT logic block selector to Enable (node retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLBLUTEnable = ptrLBLUTSelector->GetEntryByName("Enable");
-    if (!IsAvailable(ptrLBLUTEnable) || !IsReadable(ptrLBLUTEnable))
-    {
-        cout << "Unable to set LUT logic block selector to Enable (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTSelector->SetIntValue(ptrLBLUTEnable->GetValue());
-
-    cout << "Logic Block LUT set to to Enable..." << endl;
-
-    // Set Logic Block LUT Output Value All to 0xEF
-    CIntegerPtr ptrLBLUTOutputValueAll = nodeMap.GetNode("LogicBlockLUTOutputValueAll");
-    if (!IsAvailable(ptrLBLUTOutputValueAll) || !IsReadable(ptrLBLUTOutputValueAll))
-    {
-        cout << "Unable to set value to LUT logic block output value all (integer retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTOutputValueAll->SetValue(0xEF);
-
-    cout << "Logic Block LUT Output Value All set to to 0xEF..." << endl;
-
-    // Set Logic Block LUT Input Selector to Input 0
-    CEnumerationPtr ptrLBLUTInputSelector = nodeMap.GetNode("LogicBlockLUTInputSelector");
-    if (!IsAvailable(ptrLBLUTInputSelector) || !IsReadable(ptrLBLUTInputSelector))
-    {
-        cout << "Unable to set LUT logic block input selector to Input 0 (node retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLBLUTInput0 = ptrLBLUTInputSelector->GetEntryByName("Input0");
-    if (!IsAvailable(ptrLBLUTInput0) || !IsReadable(ptrLBLUTInput0))
-    {
-        cout << "Unable to set LUT logic block selector to Input 0 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTInputSelector->SetIntValue(ptrLBLUTInput0->GetValue());
-
-    cout << "Logic Block LUT Input Selector set to to Input 0 ..." << endl;
-
-    // Set Logic Block LUT Input Source to CounterOEnd
-    CEnumerationPtr ptrLBLUTSource = nodeMap.GetNode("LogicBlockLUTInputSource");
-    if (!IsAvailable(ptrLBLUTSource) || !IsReadable(ptrLBLUTSource))
-    {
-        cout << "Unable to set LUT logic block input source to Frame Trigger Wait (node retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLBLUTSourceC0E = ptrLBLUTSource->GetEntryByName("Counter0End");
-    if (!IsAvailable(ptrLBLUTSourceC0E) || !IsReadable(ptrLBLUTSourceC0E))
-    {
-        cout << "Unable to set LUT logic block input source to Counter0End (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTSource->SetIntValue(ptrLBLUTSourceC0E->GetValue());
-
-    cout << "Logic Block LUT Input Source set to to Counter0End ..." << endl;
-
-    // Set Logic Block LUT Activation Type to Rising Edge
-    CEnumerationPtr ptrLBLUTActivation = nodeMap.GetNode("LogicBlockLUTInputActivation");
-    if (!IsAvailable(ptrLBLUTActivation) || !IsReadable(ptrLBLUTActivation))
-    {
-        cout << "Unable to set LUT logic block input activation to level high (node retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLBLUTActivationRE = ptrLBLUTActivation->GetEntryByName("RisingEdge");
-    if (!IsAvailable(ptrLBLUTActivationRE) || !IsReadable(ptrLBLUTActivationRE))
-    {
-        cout << "Unable to set LUT logic block input activation to RisingEdge (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTActivation->SetIntValue(ptrLBLUTActivationRE->GetValue());
-
-    cout << "Logic Block LUT Input Activation set to level high..." << endl;
-
-    // Set Logic Block LUT Input Selector to Input 1
-    CEnumEntryPtr ptrLBLUTInput1 = ptrLBLUTInputSelector->GetEntryByName("Input1");
-    if (!IsAvailable(ptrLBLUTInput1) || !IsReadable(ptrLBLUTInput1))
-    {
-        cout << "Unable to set LUT logic block Input selector to input 1 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTInputSelector->SetIntValue(ptrLBLUTInput1->GetValue());
-
-    cout << "Logic Block LUT Input Selector set to to Input 1 ..." << endl;
-
-    // Set Logic Block LUT Source to UserOutput0
-    CEnumEntryPtr ptrLBLUTSourceUO0 = ptrLBLUTSource->GetEntryByName("UserOutput0");
-    if (!IsAvailable(ptrLBLUTSourceUO0) || !IsReadable(ptrLBLUTSourceUO0))
-    {
-        cout << "Unable to set LUT logic block input source to UserOutput0 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTSource->SetIntValue(ptrLBLUTSourceUO0->GetValue());
-
-    cout << "Logic Block LUT Input Source set to to Counter0Start ..." << endl;
-
-    // Set Logic Block LUT Activation Type to Rising Edge
-    ptrLBLUTActivation->SetIntValue(ptrLBLUTActivationRE->GetValue());
-    cout << "Logic Block LUT Input Activation set to Rising Edge..." << endl;
-
-    // Set Logic Block LUT Input Selector to Input 2
-    CEnumEntryPtr ptrLBLUTInput2 = ptrLBLUTInputSelector->GetEntryByName("Input2");
-    if (!IsAvailable(ptrLBLUTInput2) || !IsReadable(ptrLBLUTInput2))
-    {
-        cout << "Unable to set LUT logic block selector to input 2 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTInputSelector->SetIntValue(ptrLBLUTInput2->GetValue());
-
-    cout << "Logic Block LUT Input Selector set to to Input 2 ..." << endl;
-
-    // Set Logic Block LUT Source to UserOutput1
-    CEnumEntryPtr ptrLBLUTSourceUO1 = ptrLBLUTSource->GetEntryByName("UserOutput1");
-    if (!IsAvailable(ptrLBLUTSourceUO1) || !IsReadable(ptrLBLUTSourceUO1))
-    {
-        cout << "Unable to set LUT logic block input source to UserOutput1 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTSource->SetIntValue(ptrLBLUTSourceUO1->GetValue());
-
-    cout << "Logic Block LUT Input Source set to to UserOutput1 ..." << endl;
-
-    // Set Logic Block LUT Activation Type to Level High
-    CEnumEntryPtr ptrLBLUTActivationLevelHigh = ptrLBLUTActivation->GetEntryByName("LevelHigh");
-    if (!IsAvailable(ptrLBLUTActivationLevelHigh) || !IsReadable(ptrLBLUTActivationLevelHigh))
-    {
-        cout << "Unable to set LUT logic block input activation to level high (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTActivation->SetIntValue(ptrLBLUTActivationLevelHigh->GetValue());
-
-    cout << "Logic Block LUT Input Activation set to level high..." << endl;
-
-    // Set Logic Block Lut Selector to Value
-    CEnumEntryPtr ptrLBLUTValue = ptrLBLUTSelector->GetEntryByName("Value");
-    if (!IsAvailable(ptrLBLUTValue) || !IsReadable(ptrLBLUTValue))
-    {
-        cout << "Unable to set LUT logic block selector to Value (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTSelector->SetIntValue(ptrLBLUTValue->GetValue());
-
-    cout << "Logic Block LUT set to to Value..." << endl;
-
-    // Set Logic Block LUT output Value All to 0x40
-    ptrLBLUTOutputValueAll->SetValue(0x40);
-    cout << "Logic Block LUT Output Value All set to to 0x40..." << endl << endl;
-
-    return result;
-}
-
-// This function does the logic block 1 configuration.
-int ConfigureLogicBlock1(INodeMap & nodeMap)
-{
-    int result = 0;
-
-    cout << endl << endl << "*** CONFIGURING LOGIC BLOCKS ***" << endl << endl;
-
-    // Select Logic Block 1
-    CEnumerationPtr ptrLogicBlockSelector = nodeMap.GetNode("LogicBlockSelector");
-    if (!IsAvailable(ptrLogicBlockSelector) || !IsReadable(ptrLogicBlockSelector))
-    {
-        cout << "Unable to set logic block selector to Logic Block 1 (node retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLogicBlock1 = ptrLogicBlockSelector->GetEntryByName("LogicBlock1");
-    if (!IsAvailable(ptrLogicBlock1) || !IsReadable(ptrLogicBlock1))
-    {
-        cout << "Unable to set logic block selector to Logic Block 1 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLogicBlockSelector->SetIntValue(ptrLogicBlock1->GetValue());
-
-    cout << "Logic Block 1 selected...." << endl;
-
-    // Set Logic Block LUT to Enable
-    CEnumerationPtr ptrLBLUTSelector = nodeMap.GetNode("LogicBlockLUTSelector");
-    if (!IsAvailable(ptrLBLUTSelector) || !IsReadable(ptrLBLUTSelector))
-    {
-        cout << "Unable to set LUT logic block selector to Enable (node retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLBLUTEnable = ptrLBLUTSelector->GetEntryByName("Enable");
-    if (!IsAvailable(ptrLBLUTEnable) || !IsReadable(ptrLBLUTEnable))
-    {
-        cout << "Unable to set LUT logic block selector to Enable (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTSelector->SetIntValue(ptrLBLUTEnable->GetValue());
-
-    cout << "Logic Block LUT set to to Enable..." << endl;
-
-    // Set Logic Block LUT Output Value All to 0xEF
-    CIntegerPtr ptrLBLUTOutputValueAll = nodeMap.GetNode("LogicBlockLUTOutputValueAll");
-    if (!IsAvailable(ptrLBLUTOutputValueAll) || !IsReadable(ptrLBLUTOutputValueAll))
-    {
-        cout << "Unable to set value to LUT logic block output value all (integer retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTOutputValueAll->SetValue(0xEF);
-
-    cout << "Logic Block LUT Output Value All set to to 0xEF..." << endl;
-
-    // Set Logic Block LUT Input Selector to Input 0
-    CEnumerationPtr ptrLBLUTInputSelector = nodeMap.GetNode("LogicBlockLUTInputSelector");
-    if (!IsAvailable(ptrLBLUTInputSelector) || !IsReadable(ptrLBLUTInputSelector))
-    {
-        cout << "Unable to set LUT logic block input selector to Input 0 (node retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLBLUTInput0 = ptrLBLUTInputSelector->GetEntryByName("Input0");
-    if (!IsAvailable(ptrLBLUTInput0) || !IsReadable(ptrLBLUTInput0))
-    {
-        cout << "Unable to set LUT logic block selector to Input 0 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTInputSelector->SetIntValue(ptrLBLUTInput0->GetValue());
-
-    cout << "Logic Block LUT Input Selector set to to Input 0 ..." << endl;
-
-    // Set Logic Block LUT Input Source to ExposureEnd
-    CEnumerationPtr ptrLBLUTSource = nodeMap.GetNode("LogicBlockLUTInputSource");
-    if (!IsAvailable(ptrLBLUTSource) || !IsReadable(ptrLBLUTSource))
-    {
-        cout << "Unable to set LUT logic block input source to Frame Trigger Wait (node retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLBLUTSourceEE = ptrLBLUTSource->GetEntryByName("ExposureEnd");
-    if (!IsAvailable(ptrLBLUTSourceEE) || !IsReadable(ptrLBLUTSourceEE))
-    {
-        cout << "Unable to set LUT logic block input source to ExposureEnd (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTSource->SetIntValue(ptrLBLUTSourceEE->GetValue());
-
-    cout << "Logic Block LUT Input Source set to ExposureEnd ..." << endl;
-
-    // Set Logic Block LUT Activation Type to Rising Edge
-    CEnumerationPtr ptrLBLUTActivation = nodeMap.GetNode("LogicBlockLUTInputActivation");
-    if (!IsAvailable(ptrLBLUTActivation) || !IsReadable(ptrLBLUTActivation))
-    {
-        cout << "Unable to set LUT logic block input activation to level high (node retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLBLUTActivationRE = ptrLBLUTActivation->GetEntryByName("RisingEdge");
-    if (!IsAvailable(ptrLBLUTActivationRE) || !IsReadable(ptrLBLUTActivationRE))
-    {
-        cout << "Unable to set LUT logic block input activation to RisingEdge (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTActivation->SetIntValue(ptrLBLUTActivationRE->GetValue());
-
-    cout << "Logic Block LUT Input Activation set to RisingEdge..." << endl;
-
-    // Set Logic Block LUT Input Selector to Input 1
-    CEnumEntryPtr ptrLBLUTInput1 = ptrLBLUTInputSelector->GetEntryByName("Input1");
-    if (!IsAvailable(ptrLBLUTInput1) || !IsReadable(ptrLBLUTInput1))
-    {
-        cout << "Unable to set LUT logic block Input selector to input 1 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTInputSelector->SetIntValue(ptrLBLUTInput1->GetValue());
-
-    cout << "Logic Block LUT Input Selector set to to Input 1 ..." << endl;
-
-    // Set Logic Block LUT Source to Counter1Start
-    CEnumEntryPtr ptrLBLUTSourceCS1 = ptrLBLUTSource->GetEntryByName("Counter1Start");
-    if (!IsAvailable(ptrLBLUTSourceCS1) || !IsReadable(ptrLBLUTSourceCS1))
-    {
-        cout << "Unable to set LUT logic block input source to Counter1Start (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTSource->SetIntValue(ptrLBLUTSourceCS1->GetValue());
-
-    cout << "Logic Block LUT Input Source set to to Counter1Start ..." << endl;
-
-    // Set Logic Block LUT Activation Type to Rising Edge
-    ptrLBLUTActivation->SetIntValue(ptrLBLUTActivationRE->GetValue());
-
-    cout << "Logic Block LUT Input Activation set to Rising Edge..." << endl;
-
-    // Set Logic Block LUT Input Selector to Input 2
-    CEnumEntryPtr ptrLBLUTInput2 = ptrLBLUTInputSelector->GetEntryByName("Input2");
-    if (!IsAvailable(ptrLBLUTInput2) || !IsReadable(ptrLBLUTInput2))
-    {
-        cout << "Unable to set LUT logic block selector to input 2 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTInputSelector->SetIntValue(ptrLBLUTInput2->GetValue());
-
-    cout << "Logic Block LUT Input Selector set to to Input 2 ..." << endl;
-
-    // Set Logic Block LUT Source to UserOutput1
-    CEnumEntryPtr ptrLBLUTSourceUO1 = ptrLBLUTSource->GetEntryByName("UserOutput1");
-    if (!IsAvailable(ptrLBLUTSourceUO1) || !IsReadable(ptrLBLUTSourceUO1))
-    {
-        cout << "Unable to set LUT logic block input source to UserOutput1 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTSource->SetIntValue(ptrLBLUTSourceUO1->GetValue());
-
-    cout << "Logic Block LUT Input Source set to to UserOutput1 ..." << endl;
-
-    // Set Logic Block LUT Activation Type to LevelHigh
-    CEnumEntryPtr ptrLBLUTActivationLH = ptrLBLUTActivation->GetEntryByName("LevelHigh");
-    if (!IsAvailable(ptrLBLUTActivationLH) || !IsReadable(ptrLBLUTActivationLH))
-    {
-        cout << "Unable to set LUT logic block input activation to level high (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTActivation->SetIntValue(ptrLBLUTActivationLH->GetValue());
-
-    cout << "Logic Block LUT Input Activation set to level high..." << endl;
-
-    // Set Logic Block Lut Selector to Value
-    CEnumEntryPtr ptrLBLUTValue = ptrLBLUTSelector->GetEntryByName("Value");
-    if (!IsAvailable(ptrLBLUTValue) || !IsReadable(ptrLBLUTValue))
-    {
-        cout << "Unable to set LUT logic block selector to Value (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTSelector->SetIntValue(ptrLBLUTValue->GetValue());
+// Use the following global constant to select whether each image is saved as
+// a jpeg or recorded into a raw container; see recordingType in RawRecorder.h.
+const recordingType chosenRecording = SAVE_JPEG;
+
+// Use the following enum and global constant to select whether each image of
+// a burst is converted and saved before the next one is retrieved, or whether
+// the whole burst is first grabbed into preallocated memory, with a stream
+// buffer for every frame of the burst, and only then converted and saved on
+// a worker thread while the next burst is captured. Bursts with a short
+// uS_BETWEEN_TRIGGER overrun the stream buffers with CAPTURE_PER_FRAME.
+enum captureType
+{
+    CAPTURE_PER_FRAME,
+    CAPTURE_BURST_ARENA
+};
 
-    cout << "Logic Block LUT set to to Value..." << endl;
+const captureType chosenCapture = CAPTURE_BURST_ARENA;
 
-    // Set Logic Block LUT output Value All to 0x40
-    ptrLBLUTOutputValueAll->SetValue(0x40);
+// Milliseconds a frame of a burst may take to arrive before the rest of the burst counts as missing
+const uint64_t k_burstFrameTimeout = 1000;
 
-    cout << "Logic Block LUT Output Value All set to to 0x40..." << endl << endl;
-    return result;
-}
+// Use the following global constant to select whether each burst is
+// triggered by pressing Enter, or whether k_benchmarkNumTriggers bursts are
+// triggered automatically at k_benchmarkTriggerRate to measure the latency
+// from the UserOutput0 pulse to the exposure and delivery of the first image.
+// The trigger period must be longer than a burst.
+const triggerFlowType chosenTriggerFlow = TRIGGER_MANUAL;
+const double k_benchmarkTriggerRate = 10.0;
+const unsigned int k_benchmarkNumTriggers = 100;
 
-// Strobe output
-int ConfigureLine2Strobe(INodeMap & nodeMap) {
+int UserOutputSet(INodeMap & nodeMap, char * userOutputStr, bool val)
+{
     int result = 0;
-    cout << endl << endl << "*** CONFIGURING STROBE ***" << endl << endl;
-
-    // Set Line Selector
-    CEnumerationPtr ptrLineSelector = nodeMap.GetNode("LineSelector");
-    if (!IsAvailable(ptrLineSelector) || !IsWritable(ptrLineSelector))
-    {
-        cout << "Unable to set Line Selector (enum retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLineSelectorLine2 = ptrLineSelector->GetEntryByName("Line2");
-    if (!IsAvailable(ptrLineSelectorLine2) || !IsReadable(ptrLineSelectorLine2))
-    {
-        cout << "Unable to set Line Selector (entry retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
 
-    int64_t lineSelectorLine2 = ptrLineSelectorLine2->GetValue();
-
-    ptrLineSelector->SetIntValue(lineSelectorLine2);
+    // Configure the user output
+    CEnumerationPtr ptrUserOutputSelector = nodeMap.GetNode("UserOutputSelector");
 
-    // Set Line Mode to output
-    CEnumerationPtr ptrLineMode = nodeMap.GetNode("LineMode");
-    if (!IsAvailable(ptrLineMode) || !IsWritable(ptrLineMode))
+    if (!IsAvailable(ptrUserOutputSelector) || !IsWritable(ptrUserOutputSelector))
     {
-        cout << "Unable to set Line Mode (enum retrieval). Aborting..." << endl << endl;
+        cout << "Unable to set UserOutputSelector (enum retrieval). Aborting..." << endl << endl;
         return -1;
     }
 
-    CEnumEntryPtr ptrLineModeOutput = ptrLineMode->GetEntryByName("Output");
-    if (!IsAvailable(ptrLineModeOutput) || !IsReadable(ptrLineModeOutput))
+    CEnumEntryPtr ptrUserOutput = ptrUserOutputSelector->GetEntryByName(userOutputStr);
+    if (!IsAvailable(ptrUserOutput) || !IsReadable(ptrUserOutput))
     {
-        cout << "Unable to set Line Mode (entry retrieval). Aborting..." << endl << endl;
+        cout << "Unable to set FrameTriggerWait (entry retrieval). Aborting..." << endl << endl;
         return -1;
     }
 
-    int64_t lineModeOutput = ptrLineModeOutput->GetValue();
-
-    ptrLineMode->SetIntValue(lineModeOutput);
+    int64_t userInput = ptrUserOutput->GetValue();
 
-    // Set Line Source for Selected Line to LogicBlock1
-    CEnumerationPtr ptrLineSource = nodeMap.GetNode("LineSource");
-    if (!IsAvailable(ptrLineSource) || !IsWritable(ptrLineSource))
-    {
-        cout << "Unable to set Line Source (enum retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
+    ptrUserOutputSelector->SetIntValue(userInput);
 
-    CEnumEntryPtr ptrLineSourceLB1 = ptrLineSource->GetEntryByName("LogicBlock1");
-    if (!IsAvailable(ptrLineSourceLB1) || !IsReadable(ptrLineSourceLB1))
+    CBooleanPtr ptrOutputValue = nodeMap.GetNode("UserOutputValue");
+    if (!IsAvailable(ptrOutputValue) || !IsWritable(ptrOutputValue))
     {
-        cout << "Unable to set Line Source (entry retrieval). Aborting..." << endl << endl;
+        cout << "Unable to set User Output Enable (boolean retrieval). Aborting..." << endl << endl;
         return -1;
     }
 
-    int64_t LineSourceCounterLB1 = ptrLineSourceLB1->GetValue();
-
-    ptrLineSource->SetIntValue(LineSourceCounterLB1);
+    ptrOutputValue->SetValue(val);
 
     return result;
 }
 
-// Exposure active Strobe
-// Just for debugging
-int ConfigureLine1Strobe(INodeMap & nodeMap) {
-    int result = 0;
-    cout << endl << endl << "*** CONFIGURING STROBE ***" << endl << endl;
-
-    //Set Line Selector
-    CEnumerationPtr ptrLineSelector = nodeMap.GetNode("LineSelector");
-    if (!IsAvailable(ptrLineSelector) || !IsWritable(ptrLineSelector))
-    {
-        cout << "Unable to set Line Selector (enum retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLineSelectorLine1 = ptrLineSelector->GetEntryByName("Line1");
-    if (!IsAvailable(ptrLineSelectorLine1) || !IsReadable(ptrLineSelectorLine1))
-    {
-        cout << "Unable to set Line Selector (entry retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    int64_t lineSelectorLine1 = ptrLineSelectorLine1->GetValue();
-
-    ptrLineSelector->SetIntValue(lineSelectorLine1);
-
-    // Set Line Source for Selected Line to ExposureActive
-    CEnumerationPtr ptrLineSource = nodeMap.GetNode("LineSource");
-    if (!IsAvailable(ptrLineSource) || !IsWritable(ptrLineSource))
-    {
-        cout << "Unable to set Line Source (enum retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLineSourceExposure = ptrLineSource->GetEntryByName("ExposureActive");
-    if (!IsAvailable(ptrLineSourceExposure) || !IsReadable(ptrLineSourceExposure))
-    {
-        cout << "Unable to set Line Source (entry retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    int64_t LineSourceCounterUserExposure = ptrLineSourceExposure->GetValue();
-
-    ptrLineSource->SetIntValue(LineSourceCounterUserExposure);
+void UserOutputPulse(INodeMap & nodeMap, char *  userOutputStr, uint32_t pulseLength_milli) {
+    UserOutputSet(nodeMap, userOutputStr, true);
+    Sleep(pulseLength_milli);
+    UserOutputSet(nodeMap, userOutputStr, false);
+}
 
-    return result;
+// Logic blocks, counters and lines of the burst, as described at the top of
+// this file. Counter 0 counts the exposures of a burst, Counter 1 times the
+// spacing between the triggers, Logic Block 0 is high while Counter 0 is
+// active and Logic Block 1 drives the strobe from Counter 1 Start to Exposure
+// End. Line 2 outputs the strobe; Line 1 outputs Exposure Active, just for
+// debugging.
+TriggerRecipe GetBurstStrobeRecipe(int burstCount, int microSecondsBetweenTriggers)
+{
+    TriggerRecipe recipe;
+    recipe.name = "BurstStrobeThenTrigger";
+
+    recipe.logicBlocks = {
+        {"LogicBlock0",
+         0xEF,
+         0x40,
+         {{"Counter0End", "RisingEdge"}, {"UserOutput0", "RisingEdge"}, {"UserOutput1", "LevelHigh"}}},
+        {"LogicBlock1",
+         0xEF,
+         0x40,
+         {{"ExposureEnd", "RisingEdge"}, {"Counter1Start", "RisingEdge"}, {"UserOutput1", "LevelHigh"}}}};
+
+    recipe.counters = {
+        {"Counter0", "ExposureStart", "UserOutput0", "RisingEdge", nullptr, nullptr, burstCount},
+        {"Counter1", "MHzTick", "LogicBlock0", "LevelHigh", nullptr, nullptr, microSecondsBetweenTriggers}};
+
+    recipe.lines = {{"Line2", "Output", "LogicBlock1"}, {"Line1", nullptr, "ExposureActive"}};
+
+    return recipe;
 }
 
 // This function configures the camera to use a trigger. First, trigger mode is
@@ -1131,6 +468,125 @@ int PrintDeviceInfo(INodeMap & nodeMap)
     return result;
 }
 
+// This function converts and saves, or records, the images of one burst once
+// the whole burst is in its arena. It runs on the worker thread of the burst
+// capture while the next burst is grabbed.
+int SaveBurst(const BurstArena & arena, const gcstring & deviceSerialNumber, RawRecording & recording)
+{
+    int result = 0;
+
+    for (size_t imageCnt = 0; imageCnt < arena.GetNumFrames(); imageCnt++)
+    {
+        const BurstFrame & frame = arena.GetFrame(imageCnt);
+        if (frame.incomplete)
+        {
+            cout << "Burst " << arena.GetBurstIndex() << " image " << imageCnt << " incomplete with image status " << frame.imageStatus << "..." << endl;
+            continue;
+        }
+
+        ImagePtr pImage = arena.GetImage(imageCnt);
+
+        if (recording.IsRaw())
+        {
+            if (!recording.Record(pImage, frame.frameID, frame.timestamp, false))
+            {
+                result = -1;
+            }
+        }
+        else
+        {
+            // Convert image to mono 8
+            ImagePtr convertedImage = pImage->Convert(PixelFormat_Mono8, HQ_LINEAR);
+
+            // Create a unique filename
+            ostringstream filename;
+
+            filename << "Trigger-";
+            if (deviceSerialNumber != "")
+            {
+                filename << deviceSerialNumber.c_str() << "-";
+            }
+            filename << arena.GetBurstIndex() << "-" << imageCnt << ".jpg";
+
+            // Save image
+            convertedImage->Save(filename.str().c_str());
+        }
+    }
+
+    cout << "Burst " << arena.GetBurstIndex() << ": " << arena.GetNumFrames() << " images " << (recording.IsRaw() ? "recorded" : "saved") << endl;
+
+    return result;
+}
+
+// This function grabs each burst into a preallocated arena before any image
+// of it is converted or saved, and saves the bursts on a worker thread.
+int AcquireBursts(CameraPtr pCam, INodeMap & nodeMap, const gcstring & deviceSerialNumber, RawRecording & recording)
+{
+    int result = 0;
+
+    try
+    {
+        //
+        // Allocate the burst arenas
+        //
+        // *** NOTES ***
+        // Each arena holds BURST_COUNT frames of the current payload size and
+        // is allocated once, before the first trigger. While a burst streams
+        // in, every image is only copied into the next slot of the arena and
+        // released, so the stream buffer is free again straight away; the
+        // conversion and jpeg encoding happen once the burst is complete, on
+        // the worker thread, while the next burst is captured into the
+        // other arena.
+        //
+        const size_t frameSize = GetBurstFrameSize(nodeMap);
+        if (frameSize == 0)
+        {
+            cout << "Unable to read the payload size. Aborting..." << endl << endl;
+            return -1;
+        }
+
+        atomic<int> saveResult(0);
+        BurstCapture capture(BURST_COUNT, frameSize, [&](const BurstArena & arena) {
+            if (SaveBurst(arena, deviceSerialNumber, recording) != 0)
+            {
+                saveResult = -1;
+            }
+        });
+
+        cout << "Allocated " << k_burstArenaCount << " burst arenas of " << BURST_COUNT * frameSize / (1024 * 1024) << " MB..." << endl << endl;
+
+        for (unsigned int triggerCnt = 0; triggerCnt < TRIGGER_NUM; triggerCnt++)
+        {
+            // Retrieve the next burst from the trigger
+            result = result | GrabNextImageByTrigger(nodeMap, pCam);
+
+            BurstResult burst;
+            if (!capture.Capture(pCam, k_burstFrameTimeout, burst))
+            {
+                cout << "Burst " << burst.burstIndex << " grabbed " << burst.numFrames << " of " << BURST_COUNT << " images (" << burst.numIncomplete << " incomplete, " << burst.numMissing << " missing)..." << endl;
+                result = -1;
+            }
+            else
+            {
+                cout << "Burst " << burst.burstIndex << " grabbed in " << static_cast<int64_t>(burst.captureMs) << " ms" << endl;
+            }
+        }
+
+        // Wait for the last bursts to be saved
+        capture.Finish();
+        capture.PrintStatistics();
+
+        result = result | saveResult;
+    }
+    catch (Spinnaker::Exception &e)
+    {
+        cout << "Error: " << e.what() << endl;
+        result = -1;
+    }
+
+    return result;
+}
+
 // This function acquires and saves 10 images from a device; please see
 // Acquisition example for more in-depth comments on acquiring images.
 int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice)
@@ -1162,6 +618,22 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
 
         cout << "Acquisition mode set to continuous..." << endl;
 
+        if (chosenTriggerFlow == TRIGGER_BENCHMARK)
+        {
+            return RunTriggerLatencyBenchmark(pCam, "UserOutput0", k_benchmarkTriggerRate, k_benchmarkNumTriggers, BURST_COUNT) ? 0 : -1;
+        }
+
+        // Give the stream a buffer for every frame of a burst
+        StreamSettings streamSettings;
+        if (chosenCapture == CAPTURE_BURST_ARENA)
+        {
+            if (!ApplyStreamProfile(pCam, STREAM_PROFILE_BURST, streamSettings, BURST_COUNT))
+            {
+                cout << "Unable to apply every stream buffer setting; continuing with the settings below..." << endl;
+            }
+            PrintStreamSettings(streamSettings);
+        }
+
         // Begin acquiring images
         pCam->BeginAcquisition();
 
@@ -1182,60 +654,96 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
         // Retrieve, convert, and save images
         const int unsigned k_numImages = 10;
 
-        for (unsigned int triggerCnt = 0; triggerCnt < TRIGGER_NUM; triggerCnt++) {
-            // Retrieve the next images from the trigger
-            result = result | GrabNextImageByTrigger(nodeMap, pCam);
+        // Create the container that raw images are recorded into
+        RawRecording recording(chosenRecording);
+        if (!recording.Open("Trigger", deviceSerialNumber.c_str(), TRIGGER_NUM * BURST_COUNT, pCam->PayloadSize.GetValue()))
+        {
+            pCam->EndAcquisition();
+            return -1;
+        }
 
-            for (unsigned int imageCnt = 0; imageCnt < BURST_COUNT; imageCnt++)
-            {
-                try
-                {
-                    // Retrieve the next received image
-                    ImagePtr pResultImage = pCam->GetNextImage();
+        if (chosenCapture == CAPTURE_BURST_ARENA)
+        {
+            result = result | AcquireBursts(pCam, nodeMap, deviceSerialNumber, recording);
+        }
+        else
+        {
+            for (unsigned int triggerCnt = 0; triggerCnt < TRIGGER_NUM; triggerCnt++) {
+                // Retrieve the next images from the trigger
+                result = result | GrabNextImageByTrigger(nodeMap, pCam);
 
-                    if (pResultImage->IsIncomplete())
-                    {
-                        cout << "Image incomplete with image status " << pResultImage->GetImageStatus() << "..." << endl << endl;
-                    }
-                    else
+                for (unsigned int imageCnt = 0; imageCnt < BURST_COUNT; imageCnt++)
+                {
+                    try
                     {
-                        // Print image information
-                        cout << "Grabbed image " << imageCnt << ", width = " << pResultImage->GetWidth() << ", height = " << pResultImage->GetHeight() << endl;
-
-                        // Convert image to mono 8
-                        ImagePtr convertedImage = pResultImage->Convert(PixelFormat_Mono8, HQ_LINEAR);
+                        // Retrieve the next received image
+                        ImagePtr pResultImage = pCam->GetNextImage();
 
-                        // Create a unique filename
-                        ostringstream filename;
-
-                        filename << "Trigger-";
-                        if (deviceSerialNumber != "")
+                        if (pResultImage->IsIncomplete())
+                        {
+                            cout << "Image incomplete with image status " << pResultImage->GetImageStatus() << "..." << endl << endl;
+                        }
+                        else
                         {
-                            filename << deviceSerialNumber.c_str() << "-";
+                            // Print image information
+                            cout << "Grabbed image " << imageCnt << ", width = " << pResultImage->GetWidth() << ", height = " << pResultImage->GetHeight() << endl;
+
+                            if (recording.IsRaw())
+                            {
+                                if (!recording.Record(pResultImage, pResultImage->GetFrameID(), pResultImage->GetTimeStamp()))
+                                {
+                                    result = -1;
+                                }
+                            }
+                            else
+                            {
+                                // Convert image to mono 8
+                                ImagePtr convertedImage = pResultImage->Convert(PixelFormat_Mono8, HQ_LINEAR);
+
+                                // Create a unique filename
+                                ostringstream filename;
+
+                                filename << "Trigger-";
+                                if (deviceSerialNumber != "")
+                                {
+                                    filename << deviceSerialNumber.c_str() << "-";
+                                }
+                                filename << triggerCnt << "-" << imageCnt << ".jpg";
+
+                                // Save image
+                                convertedImage->Save(filename.str().c_str());
+
+                                cout << "Image saved at " << filename.str() << endl;
+                            }
                         }
-                        filename << triggerCnt << "-" << imageCnt << ".jpg";
 
-                        // Save image
-                        convertedImage->Save(filename.str().c_str());
+                        // Release image
+                        pResultImage->Release();
 
-                        cout << "Image saved at " << filename.str() << endl;
+                        cout << endl;
+                    }
+                    catch (Spinnaker::Exception &e)
+                    {
+                        cout << "Error: " << e.what() << endl;
+                        result = -1;
                     }
-
-                    // Release image
-                    pResultImage->Release();
-
-                    cout << endl;
-                }
-                catch (Spinnaker::Exception &e)
-                {
-                    cout << "Error: " << e.what() << endl;
-                    result = -1;
                 }
             }
         }
 
+        // Write the container index
+        if (!recording.Close())
+        {
+            result = -1;
+        }
+
         // End acquisition
         pCam->EndAcquisition();
+
+        if (chosenCapture == CAPTURE_BURST_ARENA)
+        {
+            PrintStreamDrops(pCam, streamSettings);
+        }
     }
     catch (Spinnaker::Exception &e)
     {
@@ -1393,24 +901,6 @@ int RunSingleCamera(CameraPtr pCam)
             return err;
         }
 
-        // Configure Line 2 strobe
-        // Actual strobe output that preceeds exposure
-        err = ConfigureLine2Strobe(nodeMap);
-
-        if (err < 0)
-        {
-            return err;
-        }
-
-        // Configure line 1 strobe
-        // Exposure active (for debug purposes)
-        err = ConfigureLine1Strobe(nodeMap);
-
-        if (err < 0)
-        {
-            return err;
-        }
-
         // Ensure that user output 0 is false initially
         // User output 0 is used to trigger
         UserOutputSet(nodeMap, "UserOutput0", false);
@@ -1419,15 +909,10 @@ int RunSingleCamera(CameraPtr pCam)
         // User output 1 is used to initialize logic blocks
         UserOutputSet(nodeMap, "UserOutput1", false);
 
-        // LB0 used to determine when Counter 0 is actve
-        err = ConfigureLogicBlock0(nodeMap);
-        if (err < 0)
-        {
-            return err;
-        }
-
-        // LB1 used to determine when stobe is active (counter 1 start to exposure end)
-        err = ConfigureLogicBlock1(nodeMap);
+        // Configure the strobe lines, LB0 (Counter 0 active), LB1 (strobe active,
+        // counter 1 start to exposure end) and counters 0 and 1 from one recipe
+        TriggerRecipeEngine engine(pCam);
+        err = ConfigureTriggerRecipe(engine, GetBurstStrobeRecipe(BURST_COUNT, uS_BETWEEN_TRIGGER)) ? 0 : -1;
         if (err < 0)
         {
             return err;
@@ -1442,20 +927,6 @@ int RunSingleCamera(CameraPtr pCam)
             return err;
         }
 
-        // Configure counters 0
-        err = SetupCounter0(nodeMap, BURST_COUNT);
-        if (err < 0)
-        {
-            return err;
-        }
-
-        // Configure counters 1
-        err = SetupCounter1(nodeMap, uS_BETWEEN_TRIGGER);
-        if (err < 0)
-        {
-            return err;
-        }
-
         UserOutputSet(nodeMap, "UserOutput1", true);
 
         // Acquire images
@@ -2,12 +2,42 @@
 #include "SpinGenApi/SpinnakerGenApi.h"
 #include <iostream>
 #include <sstream>
+#include "RawRecorder.h"
+#include "ImageEventQueue.h"
+#include "TriggerLatency.h"
 
 using namespace Spinnaker;
 using namespace Spinnaker::GenApi;
 using namespace Spinnaker::GenICam;
 using namespace std;
 
+// Images are delivered through ImageEventQueue.h, which describes the backpressure policies.
+// The enable and trigger are set by hand, so each image is waited for up to k_triggerTimeout
+// milliseconds, with a reminder every k_triggerReminderInterval, before the run is aborted.
+// Set k_triggerTimeout to 0 to wait for each trigger without a limit.
+const unsigned int k_triggerTimeout = 60000;
+const unsigned int k_triggerReminderInterval = 5000;
+const size_t k_imageQueueDepth = 4;
+const backpressurePolicy chosenBackpressure = BACKPRESSURE_DROP_OLDEST;
+
+// Use the following global constant to select whether each image is saved as
+// a jpeg or recorded into a raw container; see recordingType in RawRecorder.h.
+const recordingType chosenRecording = SAVE_JPEG;
+
+// Use the following global constant to select whether the images are
+// triggered by hand on Line0 while the enable on Line2 is held high, or whether
+// the logic block listens to UserOutput0 and UserOutput1 instead, so that
+// k_benchmarkNumTriggers triggers can be issued at k_benchmarkTriggerRate to
+// measure the latency from the trigger to the exposure and delivery of each
+// image without any wiring.
+const triggerFlowType chosenTriggerFlow = TRIGGER_MANUAL;
+const double k_benchmarkTriggerRate = 10.0;
+const unsigned int k_benchmarkNumTriggers = 100;
+
+// Logic block inputs of the trigger and the enable signal
+const char* const k_triggerInputSource = chosenTriggerFlow == TRIGGER_BENCHMARK ? "UserOutput0" : "Line0";
+const char* const k_enableInputSource = chosenTriggerFlow == TRIGGER_BENCHMARK ? "UserOutput1" : "Line2";
+
 // This function configures the camera to use a trigger.
 int ConfigureTrigger(INodeMap & nodeMap)
 {
@@ -173,7 +203,7 @@ int ConfigureLogicBlock0(INodeMap & nodeMap)
 
 	cout << "Logic Block LUT Input Selector set to to Input 0 ..." << endl;
 
-	// Set Logic Block LUT Input Source to Line0
+	// Set Logic Block LUT Input Source to the trigger input
 	CEnumerationPtr ptrLBLUTSource = nodeMap.GetNode("LogicBlockLUTInputSource");
 	if (!IsAvailable(ptrLBLUTSource) || !IsReadable(ptrLBLUTSource))
 	{
@@ -181,16 +211,16 @@ int ConfigureLogicBlock0(INodeMap & nodeMap)
 		return -1;
 	}
 
-	CEnumEntryPtr ptrLBLUTSourceL0 = ptrLBLUTSource->GetEntryByName("Line0");
+	CEnumEntryPtr ptrLBLUTSourceL0 = ptrLBLUTSource->GetEntryByName(k_triggerInputSource);
 	if (!IsAvailable(ptrLBLUTSourceL0) || !IsReadable(ptrLBLUTSourceL0))
 	{
-		cout << "Unable to set LUT logic block input source to Line0 (enum entry retrieval). Non-fatal error..." << endl;
+		cout << "Unable to set LUT logic block input source to " << k_triggerInputSource << " (enum entry retrieval). Non-fatal error..." << endl;
 		return -1;
 	}
 
 	ptrLBLUTSource->SetIntValue(ptrLBLUTSourceL0->GetValue());
 
-	cout << "Logic Block LUT Input Source set to to Line0 ..." << endl;
+	cout << "Logic Block LUT Input Source set to to " << k_triggerInputSource << " ..." << endl;
 
 	// Set Logic Block LUT Activation Type to Rising Edge
 	CEnumerationPtr ptrLBLUTActivation = nodeMap.GetNode("LogicBlockLUTInputActivation");
@@ -223,17 +253,17 @@ int ConfigureLogicBlock0(INodeMap & nodeMap)
 
 	cout << "Logic Block LUT Input Selector set to to Input 1 ..." << endl;
 
-	// Set Logic Block LUT Source to Line2
-	CEnumEntryPtr ptrLBLUTSourceL2 = ptrLBLUTSource->GetEntryByName("Line2");
+	// Set Logic Block LUT Source to the enable input
+	CEnumEntryPtr ptrLBLUTSourceL2 = ptrLBLUTSource->GetEntryByName(k_enableInputSource);
 	if (!IsAvailable(ptrLBLUTSourceL2) || !IsReadable(ptrLBLUTSourceL2))
 	{
-		cout << "Unable to set LUT logic block input source to Line2 (enum entry retrieval). Non-fatal error..." << endl;
+		cout << "Unable to set LUT logic block input source to " << k_enableInputSource << " (enum entry retrieval). Non-fatal error..." << endl;
 		return -1;
 	}
 
 	ptrLBLUTSource->SetIntValue(ptrLBLUTSourceL2->GetValue());
 
-	cout << "Logic Block LUT Input Source set to to Line2 ..." << endl;
+	cout << "Logic Block LUT Input Source set to to " << k_enableInputSource << " ..." << endl;
 
 	// Set Logic Block LUT Activation Type to Level High
 	CEnumEntryPtr ptrLBLUTActivationLH = ptrLBLUTActivation->GetEntryByName("LevelHigh");
@@ -489,6 +519,15 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
 
 		cout << "Acquisition mode set to continuous..." << endl;
 
+		if (chosenTriggerFlow == TRIGGER_BENCHMARK)
+		{
+			return RunTriggerLatencyBenchmark(pCam, k_triggerInputSource, k_benchmarkTriggerRate, k_benchmarkNumTriggers, 1, k_enableInputSource) ? 0 : -1;
+		}
+
+		// Deliver images through the event handler instead of polling GetNextImage()
+		ImageEventQueue imageQueue(k_imageQueueDepth, chosenBackpressure);
+		ImageEventRegistration imageEvents(pCam, imageQueue);
+
 		// Begin acquiring images
 		pCam->BeginAcquisition();
 
@@ -509,6 +548,14 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
 		// Retrieve, convert, and save images
 		const int unsigned k_numImages = 10;
 
+		// Create the container that raw images are recorded into
+		RawRecording recording(chosenRecording);
+		if (!recording.Open("Trigger", deviceSerialNumber.c_str(), k_numImages, pCam->PayloadSize.GetValue()))
+		{
+			pCam->EndAcquisition();
+			return -1;
+		}
+
 		for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
 		{
 			try
@@ -517,38 +564,65 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
 				result = result | GrabNextImageByTrigger(nodeMap, pCam);
 
 				// Retrieve the next received image
-				ImagePtr pResultImage = pCam->GetNextImage();
+				QueuedImage image;
+				unsigned int waitedMs = 0;
+				bool received = false;
+				while (!(received = imageQueue.WaitForImage(image, k_triggerReminderInterval)))
+				{
+					waitedMs += k_triggerReminderInterval;
+					if (k_triggerTimeout > 0 && waitedMs >= k_triggerTimeout)
+					{
+						break;
+					}
+					cout << "Still waiting for the trigger of image " << imageCnt << "..." << endl;
+				}
+				if (!received)
+				{
+					cout << "No image within " << waitedMs << " ms; the trigger may have been missed, aborting..." << endl << endl;
+					result = -1;
+					break;
+				}
 
-				if (pResultImage->IsIncomplete())
+				if (image.incomplete)
 				{
-					cout << "Image incomplete with image status " << pResultImage->GetImageStatus() << "..." << endl << endl;
+					cout << "Image incomplete with image status " << image.imageStatus << "..." << endl << endl;
 				}
 				else
 				{
 					// Print image information
-					cout << "Grabbed image " << imageCnt << ", width = " << pResultImage->GetWidth() << ", height = " << pResultImage->GetHeight() << endl;
-
-					// Convert image to mono 8
-					ImagePtr convertedImage = pResultImage->Convert(PixelFormat_Mono8, HQ_LINEAR);
+					cout << "Grabbed image " << imageCnt << ", width = " << image.pImage->GetWidth() << ", height = " << image.pImage->GetHeight() << endl;
 
-					// Create a unique filename
-					ostringstream filename;
-
-					filename << "Trigger-";
-					if (deviceSerialNumber != "")
+					if (recording.IsRaw())
 					{
-						filename << deviceSerialNumber.c_str() << "-";
+						if (!recording.Record(image.pImage, image.frameID, image.timestamp))
+						{
+							result = -1;
+						}
 					}
-					filename << imageCnt << ".jpg";
+					else
+					{
+						// Convert image to mono 8
+						ImagePtr convertedImage = image.pImage->Convert(PixelFormat_Mono8, HQ_LINEAR);
+
+						// Create a unique filename
+						ostringstream filename;
 
-					// Save image
-					convertedImage->Save(filename.str().c_str());
+						filename << "Trigger-";
+						if (deviceSerialNumber != "")
+						{
+							filename << deviceSerialNumber.c_str() << "-";
+						}
+						filename << imageCnt << ".jpg";
 
-					cout << "Image saved at " << filename.str() << endl;
+						// Save image
+						convertedImage->Save(filename.str().c_str());
+
+						cout << "Image saved at " << filename.str() << endl;
+					}
 				}
 
 				// Release image
-				pResultImage->Release();
+				imageQueue.Release(image);
 
 				cout << endl;
 			}
@@ -559,8 +633,16 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
 			}
 		}
 
+		// Write the container index
+		if (!recording.Close())
+		{
+			result = -1;
+		}
+
 		// End acquisition
 		pCam->EndAcquisition();
+
+		imageQueue.PrintStatistics();
 	}
 	catch (Spinnaker::Exception &e)
 	{
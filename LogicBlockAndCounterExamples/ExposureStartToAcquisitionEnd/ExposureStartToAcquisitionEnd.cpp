@@ -40,6 +40,7 @@ Enable LUT: 0xEF
 #include <windows.h>
 #include "Spinnaker.h"
 #include "SpinGenApi/SpinnakerGenApi.h"
+#include "TriggerRecipe.h"
 
 using namespace Spinnaker;
 using namespace Spinnaker::GenApi;
@@ -87,323 +88,24 @@ void userOutputPulse(INodeMap & nodeMap, char *  userOutputStr, uint32_t pulseLe
     userOutputSet(nodeMap, userOutputStr, false);
 }
 
-// This function does the logic block 0 configuration
-int ConfigureLogicBlock0(INodeMap & nodeMap)
+// Logic block and lines of the strobe, as described at the top of this file.
+// Logic Block 0 is high from ExposureStart until AcquisitionActive falls.
+// Line 2 outputs the strobe; Line 1 outputs Exposure Active, just for
+// debugging.
+TriggerRecipe GetExposureStartToAcquisitionEndRecipe()
 {
-    int result = 0;
-
-    cout << endl << endl << "*** CONFIGURING LOGIC BLOCKS ***" << endl << endl;
-
-    // Select Logic Block 0
-    CEnumerationPtr ptrLogicBlockSelector = nodeMap.GetNode("LogicBlockSelector");
-    if (!IsAvailable(ptrLogicBlockSelector) || !IsReadable(ptrLogicBlockSelector))
-    {
-        cout << "Unable to set logic block selector to Logic Block 0 (node retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLogicBlock0 = ptrLogicBlockSelector->GetEntryByName("LogicBlock0");
-    if (!IsAvailable(ptrLogicBlock0) || !IsReadable(ptrLogicBlock0))
-    {
-        cout << "Unable to set logic block selector to Logic Block 0 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLogicBlockSelector->SetIntValue(ptrLogicBlock0->GetValue());
-
-    cout << "Logic Block 0 selected...." << endl;
-
-    // Set Logic Block Lut to Enable
-    CEnumerationPtr ptrLBLUTSelector = nodeMap.GetNode("LogicBlockLUTSelector");
-    if (!IsAvailable(ptrLBLUTSelector) || !IsReadable(ptrLBLUTSelector))
-    {
-        cout << "Unable to set LUT logic block selector to Enable (node retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLBLUTEnable = ptrLBLUTSelector->GetEntryByName("Enable");
-    if (!IsAvailable(ptrLBLUTEnable) || !IsReadable(ptrLBLUTEnable))
-    {
-        cout << "Unable to set LUT logic block selector to Enable (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTSelector->SetIntValue(ptrLBLUTEnable->GetValue());
-
-    cout << "Logic Block LUT set to to Enable..." << endl;
-
-
-    CIntegerPtr ptrLBLUTOutputValueAll = nodeMap.GetNode("LogicBlockLUTOutputValueAll");
-    if (!IsAvailable(ptrLBLUTOutputValueAll) || !IsReadable(ptrLBLUTOutputValueAll))
-    {
-        cout << "Unable to set value to LUT logic block output value all (integer retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTOutputValueAll->SetValue(0xEF);
-
-    cout << "Logic Block LUT Output Value All set..." << endl;
-
-    // Set Logic Block LUT Input Selector to Input 0
-    CEnumerationPtr ptrLBLUTInputSelector = nodeMap.GetNode("LogicBlockLUTInputSelector");
-    if (!IsAvailable(ptrLBLUTInputSelector) || !IsReadable(ptrLBLUTInputSelector))
-    {
-        cout << "Unable to set LUT logic block input selector to Input 0 (node retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLBLUTInput0 = ptrLBLUTInputSelector->GetEntryByName("Input0");
-    if (!IsAvailable(ptrLBLUTInput0) || !IsReadable(ptrLBLUTInput0))
-    {
-        cout << "Unable to set LUT logic block selector to Input 0 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTInputSelector->SetIntValue(ptrLBLUTInput0->GetValue());
-
-    cout << "Logic Block LUT Input Selector set to to Input 0 ..." << endl;
-
-    CEnumerationPtr ptrLBLUTSource = nodeMap.GetNode("LogicBlockLUTInputSource");
-    if (!IsAvailable(ptrLBLUTSource) || !IsReadable(ptrLBLUTSource))
-    {
-        cout << "Unable to set LUT logic block input source to Frame Trigger Wait (node retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLBLUTSourceInput0 = ptrLBLUTSource->GetEntryByName("ExposureStart");
-    if (!IsAvailable(ptrLBLUTSourceInput0) || !IsReadable(ptrLBLUTSourceInput0))
-    {
-        cout << "Unable to set LUT logic block input 0 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTSource->SetIntValue(ptrLBLUTSourceInput0->GetValue());
-
-    cout << "Logic Block LUT Input Source 0 set ..." << endl;
-
-    // Set Logic Block LUT Activation Type to Rising Edge
-    CEnumerationPtr ptrLBLUTActivation = nodeMap.GetNode("LogicBlockLUTInputActivation");
-    if (!IsAvailable(ptrLBLUTActivation) || !IsReadable(ptrLBLUTActivation))
-    {
-        cout << "Unable to set LUT logic block input activation to level high (node retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLBLUTActivationRE = ptrLBLUTActivation->GetEntryByName("RisingEdge");
-    if (!IsAvailable(ptrLBLUTActivationRE) || !IsReadable(ptrLBLUTActivationRE))
-    {
-        cout << "Unable to set LUT logic block input activation to RisingEdge (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTActivation->SetIntValue(ptrLBLUTActivationRE->GetValue());
-
-    cout << "Logic Block LUT Input Activation set to level high..." << endl;
-
-    // Set Logic Block LUT Input Selector to Input 1
-    CEnumEntryPtr ptrLBLUTInput1 = ptrLBLUTInputSelector->GetEntryByName("Input1");
-    if (!IsAvailable(ptrLBLUTInput1) || !IsReadable(ptrLBLUTInput1))
-    {
-        cout << "Unable to set LUT logic block Input selector to input 1 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTInputSelector->SetIntValue(ptrLBLUTInput1->GetValue());
-
-    cout << "Logic Block LUT Input Selector set to to Input 1 ..." << endl;
-
-    CEnumEntryPtr ptrLBLUTSourceInput1 = ptrLBLUTSource->GetEntryByName("AcquisitionActive");
-    if (!IsAvailable(ptrLBLUTSourceInput1) || !IsReadable(ptrLBLUTSourceInput1))
-    {
-        cout << "Unable to set LUT logic block input source 1 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTSource->SetIntValue(ptrLBLUTSourceInput1->GetValue());
-
-    cout << "Logic Block LUT Input Source 1 set ..." << endl;
-
-    // Set Logic Block LUT Activation Type to Falling Edge
-    CEnumEntryPtr ptrLBLUTActivationFE = ptrLBLUTActivation->GetEntryByName("FallingEdge");
-    if (!IsAvailable(ptrLBLUTActivationFE) || !IsReadable(ptrLBLUTActivationFE))
-    {
-        cout << "Unable to set LUT logic block input activation to FallingEdge (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTActivation->SetIntValue(ptrLBLUTActivationFE->GetValue());
-
-    cout << "Logic Block LUT Input Activation set to Falling Edge..." << endl;
-
-    // Set Logic Block LUT Input Selector to Input 2
-    CEnumEntryPtr ptrLBLUTInput2 = ptrLBLUTInputSelector->GetEntryByName("Input2");
-    if (!IsAvailable(ptrLBLUTInput2) || !IsReadable(ptrLBLUTInput2))
-    {
-        cout << "Unable to set LUT logic block selector to input 2 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTInputSelector->SetIntValue(ptrLBLUTInput2->GetValue());
-
-    cout << "Logic Block LUT Input Selector set to to Input 2 ..." << endl;
-
-    CEnumEntryPtr ptrLBLUTSourceInput2 = ptrLBLUTSource->GetEntryByName("UserOutput0");
-    if (!IsAvailable(ptrLBLUTSourceInput2) || !IsReadable(ptrLBLUTSourceInput2))
-    {
-        cout << "Unable to set LUT logic block input source 2 (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTSource->SetIntValue(ptrLBLUTSourceInput2->GetValue());
-
-    cout << "Logic Block LUT Input Source 2 set ..." << endl;
+    TriggerRecipe recipe;
+    recipe.name = "ExposureStartToAcquisitionEnd";
 
-    // Set Logic Block LUT Activation Type to Level High
+    recipe.logicBlocks = {
+        {"LogicBlock0",
+         0xEF,
+         0x20,
+         {{"ExposureStart", "RisingEdge"}, {"AcquisitionActive", "FallingEdge"}, {"UserOutput0", "LevelHigh"}}}};
 
-    CEnumEntryPtr ptrLBLUTActivationLevelHigh = ptrLBLUTActivation->GetEntryByName("LevelHigh");
-    if (!IsAvailable(ptrLBLUTActivationLevelHigh) || !IsReadable(ptrLBLUTActivationLevelHigh))
-    {
-        cout << "Unable to set LUT logic block input activation to level high (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTActivation->SetIntValue(ptrLBLUTActivationLevelHigh->GetValue());
-
-    cout << "Logic Block LUT Input Activation set to level high..." << endl;
-
-
-    // Set Logic Block Lut Selector to Value
-    CEnumEntryPtr ptrLBLUTValue = ptrLBLUTSelector->GetEntryByName("Value");
-    if (!IsAvailable(ptrLBLUTValue) || !IsReadable(ptrLBLUTValue))
-    {
-        cout << "Unable to set LUT logic block selector to Value (enum entry retrieval). Non-fatal error..." << endl;
-        return -1;
-    }
-
-    ptrLBLUTSelector->SetIntValue(ptrLBLUTValue->GetValue());
-
-    cout << "Logic Block LUT set to to Value..." << endl;
+    recipe.lines = {{"Line2", "Output", "LogicBlock0"}, {"Line1", nullptr, "ExposureActive"}};
 
-    // Set Logic Block LUT output Value All
-    ptrLBLUTOutputValueAll->SetValue(0x20);
-
-    cout << "Logic Block LUT Output Value All set" << endl << endl;
-
-    return result;
-}
-
-
-// Strobe output
-int ConfigureLine2Strobe(INodeMap & nodeMap) {
-    int result = 0;
-    cout << endl << endl << "*** CONFIGURING STROBE ***" << endl << endl;
-
-    //Set Line Selector
-    CEnumerationPtr ptrLineSelector = nodeMap.GetNode("LineSelector");
-    if (!IsAvailable(ptrLineSelector) || !IsWritable(ptrLineSelector))
-    {
-        cout << "Unable to set Line Selector (enum retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLineSelectorLine2 = ptrLineSelector->GetEntryByName("Line2");
-    if (!IsAvailable(ptrLineSelectorLine2) || !IsReadable(ptrLineSelectorLine2))
-    {
-        cout << "Unable to set Line Selector (entry retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    int64_t lineSelectorLine2 = ptrLineSelectorLine2->GetValue();
-
-    ptrLineSelector->SetIntValue(lineSelectorLine2);
-
-    //Set Line Mode to output
-    CEnumerationPtr ptrLineMode = nodeMap.GetNode("LineMode");
-    if (!IsAvailable(ptrLineMode) || !IsWritable(ptrLineMode))
-    {
-        cout << "Unable to set Line Mode (enum retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLineModeOutput = ptrLineMode->GetEntryByName("Output");
-    if (!IsAvailable(ptrLineModeOutput) || !IsReadable(ptrLineModeOutput))
-    {
-        cout << "Unable to set Line Mode (entry retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    int64_t lineModeOutput = ptrLineModeOutput->GetValue();
-
-    ptrLineMode->SetIntValue(lineModeOutput);
-
-    // Set Line Source for Selected Line
-    CEnumerationPtr ptrLineSource = nodeMap.GetNode("LineSource");
-    if (!IsAvailable(ptrLineSource) || !IsWritable(ptrLineSource))
-    {
-        cout << "Unable to set Line Source (enum retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLineSourceVal = ptrLineSource->GetEntryByName("LogicBlock0");
-    if (!IsAvailable(ptrLineSourceVal) || !IsReadable(ptrLineSourceVal))
-    {
-        cout << "Unable to set Line Source (entry retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    int64_t LineSourceVal = ptrLineSourceVal->GetValue();
-
-    ptrLineSource->SetIntValue(LineSourceVal);
-
-    return result;
-}
-
-// Exposure active Strobe 
-// Just for debugging
-int ConfigureLine1Strobe(INodeMap & nodeMap) {
-    int result = 0;
-    cout << endl << endl << "*** CONFIGURING STROBE ***" << endl << endl;
-
-    //Set Line Selector
-    CEnumerationPtr ptrLineSelector = nodeMap.GetNode("LineSelector");
-    if (!IsAvailable(ptrLineSelector) || !IsWritable(ptrLineSelector))
-    {
-        cout << "Unable to set Line Selector (enum retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLineSelectorLine1 = ptrLineSelector->GetEntryByName("Line1");
-    if (!IsAvailable(ptrLineSelectorLine1) || !IsReadable(ptrLineSelectorLine1))
-    {
-        cout << "Unable to set Line Selector (entry retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    int64_t lineSelectorLine1 = ptrLineSelectorLine1->GetValue();
-
-    ptrLineSelector->SetIntValue(lineSelectorLine1);
-
-
-    // Set Line Source for Selected Line to ExposureActive
-    CEnumerationPtr ptrLineSource = nodeMap.GetNode("LineSource");
-    if (!IsAvailable(ptrLineSource) || !IsWritable(ptrLineSource))
-    {
-        cout << "Unable to set Line Source (enum retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    CEnumEntryPtr ptrLineSourceExposure = ptrLineSource->GetEntryByName("ExposureActive");
-    if (!IsAvailable(ptrLineSourceExposure) || !IsReadable(ptrLineSourceExposure))
-    {
-        cout << "Unable to set Line Source (entry retrieval). Aborting..." << endl << endl;
-        return -1;
-    }
-
-    int64_t LineSourceCounterUserExposure = ptrLineSourceExposure->GetValue();
-
-    ptrLineSource->SetIntValue(LineSourceCounterUserExposure);
-
-    return result;
+    return recipe;
 }
 
 int ConfigureTrigger(INodeMap & nodeMap)
@@ -849,24 +551,9 @@ int RunSingleCamera(CameraPtr pCam)
         // ensure that user output 0 is false initially to insitialize logicblock0 to 0
         userOutputSet(nodeMap, "UserOutput0", false);
 
-        err = ConfigureLine2Strobe(nodeMap);
-
-        if (err < 0)
-        {
-            return err;
-        }
-
-        // configure line 1 strobe
-        // exposure active (for debug purposes)
-        err = ConfigureLine1Strobe(nodeMap);
-
-        if (err < 0)
-        {
-            return err;
-        }
-
-        // LB0 used to determine when stobe is active
-        err = ConfigureLogicBlock0(nodeMap);
+        // Configure the strobe lines and LB0, which determines when the strobe is active
+        TriggerRecipeEngine engine(pCam);
+        err = ConfigureTriggerRecipe(engine, GetExposureStartToAcquisitionEndRecipe()) ? 0 : -1;
         if (err < 0)
         {
             return err;
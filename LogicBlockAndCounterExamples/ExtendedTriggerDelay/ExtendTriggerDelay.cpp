@@ -39,12 +39,38 @@
 #include "SpinGenApi/SpinnakerGenApi.h"
 #include <iostream>
 #include <sstream>
+#include "RawRecorder.h"
+#include "ImageEventQueue.h"
+#include "TriggerLatency.h"
 
 using namespace Spinnaker;
 using namespace Spinnaker::GenApi;
 using namespace Spinnaker::GenICam;
 using namespace std;
 
+// Images are delivered through ImageEventQueue.h, which describes the backpressure policies.
+// The delay starts on the Line0 trigger, which is given by hand, so the loop waits up to
+// k_triggerTimeout milliseconds for each image and then aborts the run; 0 waits without a
+// limit. A reminder is printed every k_triggerReminderInterval while waiting.
+const unsigned int k_triggerTimeout = 60000;
+const unsigned int k_triggerReminderInterval = 5000;
+const size_t k_imageQueueDepth = 4;
+const backpressurePolicy chosenBackpressure = BACKPRESSURE_DROP_OLDEST;
+
+// Use the following global constant to select whether each image is saved as
+// a jpeg or recorded into a raw container; see recordingType in RawRecorder.h.
+const recordingType chosenRecording = SAVE_JPEG;
+
+// Use the following global constant to select whether the delay is
+// started by the GPIO input on Line0, or whether it is started by UserOutput0
+// instead, so that k_benchmarkNumTriggers triggers can be issued at
+// k_benchmarkTriggerRate to measure the delay the camera actually produces
+// from the trigger to the exposure and delivery of each image. The trigger
+// period must be longer than TRIGGER_DELAY_US.
+const triggerFlowType chosenTriggerFlow = TRIGGER_MANUAL;
+const double k_benchmarkTriggerRate = 4.0;
+const unsigned int k_benchmarkNumTriggers = 40;
+
 uint64_t TRIGGER_DELAY_US = 125000;
 uint64_t COUNTER_0_DURRATION_US = 1000;
 
@@ -79,7 +105,8 @@ bool ConfigureLogicBlock0(CameraPtr pCam)
         pCam->LogicBlockLUTOutputValueAll.SetValue(0x22);
 
         pCam->LogicBlockLUTInputSelector.SetValue(LogicBlockLUTInputSelector_Input0);
-        pCam->LogicBlockLUTInputSource.SetValue(LogicBlockLUTInputSource_Line0);
+        pCam->LogicBlockLUTInputSource.SetValue(
+            chosenTriggerFlow == TRIGGER_BENCHMARK ? LogicBlockLUTInputSource_UserOutput0 : LogicBlockLUTInputSource_Line0);
         pCam->LogicBlockLUTInputActivation.SetValue(LogicBlockLUTInputActivation_RisingEdge);
 
         pCam->LogicBlockLUTInputSelector.SetValue(LogicBlockLUTInputSelector_Input1);
@@ -140,7 +167,8 @@ bool ConfigureCounter1(CameraPtr pCam, uint64_t counter0Cycles)
             pCam->CounterResetSource.SetValue(CounterResetSource_Off);
         }
 
-        pCam->CounterTriggerSource.SetValue(CounterTriggerSource_Line0);
+        pCam->CounterTriggerSource.SetValue(
+            chosenTriggerFlow == TRIGGER_BENCHMARK ? CounterTriggerSource_UserOutput0 : CounterTriggerSource_Line0);
         pCam->CounterTriggerActivation.SetValue(CounterTriggerActivation_RisingEdge);
     }
     catch (Spinnaker::Exception &e)
@@ -241,6 +269,15 @@ bool AcquireImages(CameraPtr pCam)
     {
         pCam->AcquisitionMode.SetValue(AcquisitionMode_Continuous);
 
+        if (chosenTriggerFlow == TRIGGER_BENCHMARK)
+        {
+            return !RunTriggerLatencyBenchmark(pCam, "UserOutput0", k_benchmarkTriggerRate, k_benchmarkNumTriggers);
+        }
+
+        // Deliver images through the event handler instead of polling GetNextImage()
+        ImageEventQueue imageQueue(k_imageQueueDepth, chosenBackpressure);
+        ImageEventRegistration imageEvents(pCam, imageQueue);
+
         pCam->BeginAcquisition();
 
         cout << "Acquiring images..." << endl;
@@ -248,38 +285,74 @@ bool AcquireImages(CameraPtr pCam)
         string deviceSerialNumber = pCam->DeviceID.GetValue();
 
         const int unsigned k_numImages = 10;
+        bool failed = false;
+
+        // Create the container that raw images are recorded into
+        RawRecording recording(chosenRecording);
+        if (!recording.Open("Trigger", deviceSerialNumber.c_str(), k_numImages, pCam->PayloadSize.GetValue()))
+        {
+            pCam->EndAcquisition();
+            return true;
+        }
 
         for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
         {
             try
             {
-                ImagePtr pResultImage = pCam->GetNextImage();
+                QueuedImage image;
+                unsigned int waitedMs = 0;
+                bool received = false;
+                while (!(received = imageQueue.WaitForImage(image, k_triggerReminderInterval)))
+                {
+                    waitedMs += k_triggerReminderInterval;
+                    if (k_triggerTimeout > 0 && waitedMs >= k_triggerTimeout)
+                    {
+                        break;
+                    }
+                    cout << "Still waiting for the trigger of image " << imageCnt << "..." << endl;
+                }
+                if (!received)
+                {
+                    cout << "No image within " << waitedMs << " ms; the trigger may have been missed, aborting..." << endl << endl;
+                    failed = true;
+                    break;
+                }
 
-                if (pResultImage->IsIncomplete())
+                if (image.incomplete)
                 {
-                    cout << "Image incomplete with image status " << pResultImage->GetImageStatus() << "..." << endl << endl;
+                    cout << "Image incomplete with image status " << image.imageStatus << "..." << endl << endl;
                 }
                 else
                 {
-                    cout << "Grabbed image " << imageCnt << ", width = " << pResultImage->GetWidth() << ", height = " << pResultImage->GetHeight() << endl;
-
-                    ImagePtr convertedImage = pResultImage->Convert(PixelFormat_Mono8, HQ_LINEAR);
+                    cout << "Grabbed image " << imageCnt << ", width = " << image.pImage->GetWidth() << ", height = " << image.pImage->GetHeight() << endl;
 
-                    ostringstream filename;
-
-                    filename << "Trigger-";
-                    if (deviceSerialNumber != "")
+                    if (recording.IsRaw())
                     {
-                        filename << deviceSerialNumber.c_str() << "-";
+                        if (!recording.Record(image.pImage, image.frameID, image.timestamp))
+                        {
+                            failed = true;
+                        }
                     }
-                    filename << imageCnt << ".jpg";
+                    else
+                    {
+                        ImagePtr convertedImage = image.pImage->Convert(PixelFormat_Mono8, HQ_LINEAR);
 
-                    convertedImage->Save(filename.str().c_str());
+                        ostringstream filename;
 
-                    cout << "Image saved at " << filename.str() << endl;
+                        filename << "Trigger-";
+                        if (deviceSerialNumber != "")
+                        {
+                            filename << deviceSerialNumber.c_str() << "-";
+                        }
+                        filename << imageCnt << ".jpg";
+
+                        convertedImage->Save(filename.str().c_str());
+
+                        cout << "Image saved at " << filename.str() << endl;
+                    }
                 }
 
-                pResultImage->Release();
+                imageQueue.Release(image);
 
                 cout << endl;
             }
@@ -289,15 +362,23 @@ bool AcquireImages(CameraPtr pCam)
             }
         }
 
+        // Write the container index
+        if (!recording.Close())
+        {
+            failed = true;
+        }
+
         pCam->EndAcquisition();
+
+        imageQueue.PrintStatistics();
+
+        return failed;
     }
     catch (Spinnaker::Exception &e)
     {
         cout << "Error: " << e.what() << endl;
         return true;
     }
-
-    return false;
 }
 
 int RunSingleCamera(CameraPtr pCam)
@@ -62,6 +62,9 @@ Enable LUT: 0xEE
 #include <windows.h>
 #include "Spinnaker.h"
 #include "SpinGenApi/SpinnakerGenApi.h"
+#include "ImageEventQueue.h"
+#include "ProcessingPolicy.h"
+#include "TriggerRecipe.h"
 
 // This value is 1/FPS in mircoseconds
 #define uS_FRAME_RATE_TIMER 5555
@@ -73,6 +76,26 @@ using namespace Spinnaker::GenApi;
 using namespace Spinnaker::GenICam;
 using namespace std;
 
+// Images are delivered through ImageEventQueue.h, which describes the timeout and backpressure policies
+const unsigned int k_imageTimeout = 1000;
+const size_t k_imageQueueDepth = 4;
+const backpressurePolicy chosenBackpressure = BACKPRESSURE_DROP_OLDEST;
+
+// Use the following to choose which frames are converted and saved. The rest
+// are released on the event thread without being copied, so that checking
+// the strobe on a live line does not slow acquisition down. PROCESS_EVERY_NTH
+// keeps every k_processInterval-th frame; PROCESS_FLAGGED keeps the frames
+// whose mean intensity leaves k_minStrobeMean to k_maxStrobeMean, that have
+// more than k_maxSaturatedFraction of their pixels saturated, or whose mean
+// jumps by more than k_maxMeanChange, as when the strobe fires late or not at
+// all. Intensities are fractions of full scale.
+const processingPolicyType chosenProcessing = PROCESS_EVERY_NTH;
+const unsigned int k_processInterval = 50;
+const double k_minStrobeMean = 0.05;
+const double k_maxStrobeMean = 0.95;
+const double k_maxSaturatedFraction = 0.05;
+const double k_maxMeanChange = 0.1;
+
 
 int userOutputSet(INodeMap & nodeMap, char *  userOutputStr, bool val) {
 	int result = 0;
@@ -115,564 +138,29 @@ void userOutputPulse(INodeMap & nodeMap, char *  userOutputStr, uint32_t pulseLe
 	userOutputSet(nodeMap, userOutputStr, false);
 }
 
-// configure counter 0
-int SetupCounter0(INodeMap & nodeMap, int durration)
-{
-	int result = 0;
-
-	cout << endl << "Configuring Pulse Width Modulation signal" << endl;
-
-	try
-	{
-		// Set Counter Selector to Counter 0
-		CEnumerationPtr ptrCounterSelector = nodeMap.GetNode("CounterSelector");
-
-		// Check to see if camera supports Counter and Timer functionality
-		if (!IsAvailable(ptrCounterSelector))
-		{
-			cout << endl << "Camera does not support Counter and Timer Functionality.  Aborting..." << endl;
-			return -1;
-		}
-
-		if (!IsAvailable(ptrCounterSelector) || !IsWritable(ptrCounterSelector))
-		{
-			cout << "Unable to set Counter Selector (enum retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		CEnumEntryPtr ptrCounter0 = ptrCounterSelector->GetEntryByName("Counter0");
-		if (!IsAvailable(ptrCounter0) || !IsReadable(ptrCounter0))
-		{
-			cout << "Unable to set Counter Selector (entry retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		int64_t counter0 = ptrCounter0->GetValue();
-
-		ptrCounterSelector->SetIntValue(counter0);
-
-		// Set Counter Duration to input value
-		CIntegerPtr ptrCounterDuration = nodeMap.GetNode("CounterDuration");
-		if (!IsAvailable(ptrCounterDuration) || !IsWritable(ptrCounterDuration))
-		{
-			cout << "Unable to set Counter Duration (integer retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		ptrCounterDuration->SetValue(durration);
-
-
-		// Set Counter Event Source to MHzTick
-		CEnumerationPtr ptrCounterEventSource = nodeMap.GetNode("CounterEventSource");
-		if (!IsAvailable(ptrCounterEventSource) || !IsWritable(ptrCounterEventSource))
-		{
-			cout << "Unable to set Counter Event Source (enum retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		CEnumEntryPtr ptrCounterEventSourceMHzTick = ptrCounterEventSource->GetEntryByName("MHzTick");
-		if (!IsAvailable(ptrCounterEventSourceMHzTick) || !IsReadable(ptrCounterEventSourceMHzTick))
-		{
-			cout << "Unable to set Counter Event Source (entry retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		int64_t counterEventSourceMHzTick = ptrCounterEventSourceMHzTick->GetValue();
-
-		ptrCounterEventSource->SetIntValue(counterEventSourceMHzTick);
-
-
-		CEnumerationPtr ptrCounterTriggerSource = nodeMap.GetNode("CounterTriggerSource");
-		if (!IsAvailable(ptrCounterTriggerSource) || !IsWritable(ptrCounterTriggerSource))
-		{
-			cout << "Unable to set Counter Trigger Source (enum retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		CEnumEntryPtr ptrCounterTriggerSourceVal = ptrCounterTriggerSource->GetEntryByName("UserOutput0");
-		if (!IsAvailable(ptrCounterTriggerSourceVal) || !IsReadable(ptrCounterTriggerSourceVal))
-		{
-			cout << "Unable to set Counter Trigger Source (entry retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		int64_t counterTriggerSourceOutput = ptrCounterTriggerSourceVal->GetValue();
-
-		ptrCounterTriggerSource->SetIntValue(counterTriggerSourceOutput);
-
-
-		// Set Counter Reset Activation
-		CEnumerationPtr ptrCounterTriggerActivation = nodeMap.GetNode("CounterTriggerActivation");
-		if (!IsAvailable(ptrCounterTriggerActivation) || !IsWritable(ptrCounterTriggerActivation))
-		{
-			cout << "Unable to set Counter Trigger Activation (enum retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		CEnumEntryPtr ptrCounterTriggerActivationLH = ptrCounterTriggerActivation->GetEntryByName("LevelHigh");
-		if (!IsAvailable(ptrCounterTriggerActivationLH) || !IsReadable(ptrCounterTriggerActivationLH))
-		{
-			cout << "Unable to set Counter Trigger Activation (entry retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		int64_t counterTriggerActivationRE = ptrCounterTriggerActivationLH->GetValue();
-
-		ptrCounterTriggerActivation->SetIntValue(counterTriggerActivationRE);
-	}
-	catch (Spinnaker::Exception &e)
-	{
-		cout << "Error: " << e.what() << endl;
-		result = -1;
-	}
-
-	return result;
-}
-
-
-// configure Counter 1
-int SetupCounter1(INodeMap & nodeMap, int durration)
-{
-	int result = 0;
-
-	cout << endl << "Configuring Pulse Width Modulation signal" << endl;
-
-	try
-	{
-		// Set Counter Selector to Counter 1
-		CEnumerationPtr ptrCounterSelector = nodeMap.GetNode("CounterSelector");
-
-		// Check to see if camera supports Counter and Timer functionality
-		if (!IsAvailable(ptrCounterSelector))
-		{
-			cout << endl << "Camera does not support Counter and Timer Functionality.  Aborting..." << endl;
-			return -1;
-		}
-
-		if (!IsAvailable(ptrCounterSelector) || !IsWritable(ptrCounterSelector))
-		{
-			cout << "Unable to set Counter Selector (enum retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		CEnumEntryPtr ptrCounter1 = ptrCounterSelector->GetEntryByName("Counter1");
-		if (!IsAvailable(ptrCounter1) || !IsReadable(ptrCounter1))
-		{
-			cout << "Unable to set Counter Selector (entry retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		int64_t counter1 = ptrCounter1->GetValue();
-
-		ptrCounterSelector->SetIntValue(counter1);
-		// Set Counter Duration to input value
-		CIntegerPtr ptrCounterDuration = nodeMap.GetNode("CounterDuration");
-		if (!IsAvailable(ptrCounterDuration) || !IsWritable(ptrCounterDuration))
-		{
-			cout << "Unable to set Counter Duration (integer retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		ptrCounterDuration->SetValue(durration);
-
-
-		// Set Counter Event Source to MHzTick
-		CEnumerationPtr ptrCounterEventSource = nodeMap.GetNode("CounterEventSource");
-		if (!IsAvailable(ptrCounterEventSource) || !IsWritable(ptrCounterEventSource))
-		{
-			cout << "Unable to set Counter Event Source (enum retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		CEnumEntryPtr ptrCounterEventSourceMHzTick = ptrCounterEventSource->GetEntryByName("MHzTick");
-		if (!IsAvailable(ptrCounterEventSourceMHzTick) || !IsReadable(ptrCounterEventSourceMHzTick))
-		{
-			cout << "Unable to set Counter Event Source (entry retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		int64_t counterEventSourceMHzTick = ptrCounterEventSourceMHzTick->GetValue();
-
-		ptrCounterEventSource->SetIntValue(counterEventSourceMHzTick);
-
-		CEnumerationPtr ptrCounterTriggerSource = nodeMap.GetNode("CounterTriggerSource");
-		if (!IsAvailable(ptrCounterTriggerSource) || !IsWritable(ptrCounterTriggerSource))
-		{
-			cout << "Unable to set Counter Trigger Source (enum retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		CEnumEntryPtr ptrCounterTriggerSourceVal = ptrCounterTriggerSource->GetEntryByName("Off");
-		if (!IsAvailable(ptrCounterTriggerSourceVal) || !IsReadable(ptrCounterTriggerSourceVal))
-		{
-			cout << "Unable to set Counter Trigger Source (entry retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		int64_t counterTriggerSourceOutput = ptrCounterTriggerSourceVal->GetValue();
-
-		ptrCounterTriggerSource->SetIntValue(counterTriggerSourceOutput);
-
-		CEnumerationPtr ptrCounterResetSource = nodeMap.GetNode("CounterResetSource");
-		if (!IsAvailable(ptrCounterResetSource) || !IsWritable(ptrCounterResetSource))
-		{
-			cout << "Unable to set Counter Reset Source (enum retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		CEnumEntryPtr ptrCounterResetSourceVal= ptrCounterResetSource->GetEntryByName("Counter0Start");
-		if (!IsAvailable(ptrCounterResetSourceVal) || !IsReadable(ptrCounterResetSourceVal))
-		{
-			cout << "Unable to set Counter Reset Source (entry retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		int64_t counterResetSourceLogicBlock = ptrCounterResetSourceVal->GetValue();
-
-		ptrCounterResetSource->SetIntValue(counterResetSourceLogicBlock);
-
-
-		// Set Counter Reset Activation to Rising Edge
-		CEnumerationPtr ptrCounterResetActivation = nodeMap.GetNode("CounterResetActivation");
-		if (!IsAvailable(ptrCounterResetActivation) || !IsWritable(ptrCounterResetActivation))
-		{
-			cout << "Unable to set Counter Reset Activation (enum retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		CEnumEntryPtr ptrCounterResetActivationRE = ptrCounterResetActivation->GetEntryByName("RisingEdge");
-		if (!IsAvailable(ptrCounterResetActivationRE) || !IsReadable(ptrCounterResetActivationRE))
-		{
-			cout << "Unable to set Counter Reset Activation (entry retrieval). Aborting..." << endl << endl;
-			return -1;
-		}
-
-		int64_t counterResetActivationRE = ptrCounterResetActivationRE->GetValue();
-
-		ptrCounterResetActivation->SetIntValue(counterResetActivationRE);
-	}
-	catch (Spinnaker::Exception &e)
-	{
-		cout << "Error: " << e.what() << endl;
-		result = -1;
-	}
-
-	return result;
-}
-
-
-
-// This function does the logic block 0 configuration
-int ConfigureLogicBlock0(INodeMap & nodeMap)
+// Logic blocks, counters and lines of the strobe, as described at the top of
+// this file. Counter 0 times 1/Framerate, Counter 1 the exposure offset from
+// the strobe, and Logic Block 0 drives the strobe from Counter0Start to
+// ExposureEnd. Line 2 outputs the strobe; Line 1 outputs Exposure Active,
+// just for debugging.
+TriggerRecipe GetStrobeBeforeExposureRecipe(int frameRateTimer, int strobeOffset)
 {
-	int result = 0;
-
-	cout << endl << endl << "*** CONFIGURING LOGIC BLOCKS ***" << endl << endl;
-
-	// Select Logic Block 0
-	CEnumerationPtr ptrLogicBlockSelector = nodeMap.GetNode("LogicBlockSelector");
-	if (!IsAvailable(ptrLogicBlockSelector) || !IsReadable(ptrLogicBlockSelector))
-	{
-		cout << "Unable to set logic block selector to Logic Block 0 (node retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	CEnumEntryPtr ptrLogicBlock0 = ptrLogicBlockSelector->GetEntryByName("LogicBlock0");
-	if (!IsAvailable(ptrLogicBlock0) || !IsReadable(ptrLogicBlock0))
-	{
-		cout << "Unable to set logic block selector to Logic Block 0 (enum entry retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	ptrLogicBlockSelector->SetIntValue(ptrLogicBlock0->GetValue());
-
-	cout << "Logic Block 0 selected...." << endl;
-
-	// Set Logic Block Lut to Enable
-	CEnumerationPtr ptrLBLUTSelector = nodeMap.GetNode("LogicBlockLUTSelector");
-	if (!IsAvailable(ptrLBLUTSelector) || !IsReadable(ptrLBLUTSelector))
-	{
-		cout << "Unable to set LUT logic block selector to Enable (node retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	CEnumEntryPtr ptrLBLUTEnable = ptrLBLUTSelector->GetEntryByName("Enable");
-	if (!IsAvailable(ptrLBLUTEnable) || !IsReadable(ptrLBLUTEnable))
-	{
-		cout << "Unable to set LUT logic block selector to Enable (enum entry retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	ptrLBLUTSelector->SetIntValue(ptrLBLUTEnable->GetValue());
-
-	cout << "Logic Block LUT set to to Enable..." << endl;
+	TriggerRecipe recipe;
+	recipe.name = "StrobeBeforeExposure";
 
+	recipe.logicBlocks = {
+		{"LogicBlock0",
+		 0xEE,
+		 0x22,
+		 {{"Counter0Start", "RisingEdge"}, {"ExposureEnd", "RisingEdge"}, {"Zero", "LevelHigh"}}}};
 
-	CIntegerPtr ptrLBLUTOutputValueAll = nodeMap.GetNode("LogicBlockLUTOutputValueAll");
-	if (!IsAvailable(ptrLBLUTOutputValueAll) || !IsReadable(ptrLBLUTOutputValueAll))
-	{
-		cout << "Unable to set value to LUT logic block output value all (integer retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	ptrLBLUTOutputValueAll->SetValue(0xEE);
-
-	cout << "Logic Block LUT Output Value All set..." << endl;
-
-	// Set Logic Block LUT Input Selector to Input 0
-	CEnumerationPtr ptrLBLUTInputSelector = nodeMap.GetNode("LogicBlockLUTInputSelector");
-	if (!IsAvailable(ptrLBLUTInputSelector) || !IsReadable(ptrLBLUTInputSelector))
-	{
-		cout << "Unable to set LUT logic block input selector to Input 0 (node retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	CEnumEntryPtr ptrLBLUTInput0 = ptrLBLUTInputSelector->GetEntryByName("Input0");
-	if (!IsAvailable(ptrLBLUTInput0) || !IsReadable(ptrLBLUTInput0))
-	{
-		cout << "Unable to set LUT logic block selector to Input 0 (enum entry retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	ptrLBLUTInputSelector->SetIntValue(ptrLBLUTInput0->GetValue());
-
-	cout << "Logic Block LUT Input Selector set to to Input 0 ..." << endl;
-
-	CEnumerationPtr ptrLBLUTSource = nodeMap.GetNode("LogicBlockLUTInputSource");
-	if (!IsAvailable(ptrLBLUTSource) || !IsReadable(ptrLBLUTSource))
-	{
-		cout << "Unable to set LUT logic block input source to Frame Trigger Wait (node retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	CEnumEntryPtr ptrLBLUTSourceInput0 = ptrLBLUTSource->GetEntryByName("Counter0Start");
-	if (!IsAvailable(ptrLBLUTSourceInput0) || !IsReadable(ptrLBLUTSourceInput0))
-	{
-		cout << "Unable to set LUT logic block input 0 (enum entry retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	ptrLBLUTSource->SetIntValue(ptrLBLUTSourceInput0->GetValue());
-
-	cout << "Logic Block LUT Input Source 0 set ..." << endl;
-
-	// Set Logic Block LUT Activation Type to Rising Edge
-	CEnumerationPtr ptrLBLUTActivation = nodeMap.GetNode("LogicBlockLUTInputActivation");
-	if (!IsAvailable(ptrLBLUTActivation) || !IsReadable(ptrLBLUTActivation))
-	{
-		cout << "Unable to set LUT logic block input activation to level high (node retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	CEnumEntryPtr ptrLBLUTActivationRE = ptrLBLUTActivation->GetEntryByName("RisingEdge");
-	if (!IsAvailable(ptrLBLUTActivationRE) || !IsReadable(ptrLBLUTActivationRE))
-	{
-		cout << "Unable to set LUT logic block input activation to RisingEdge (enum entry retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	ptrLBLUTActivation->SetIntValue(ptrLBLUTActivationRE->GetValue());
-
-	cout << "Logic Block LUT Input Activation set to level high..." << endl;
-
-	// Set Logic Block LUT Input Selector to Input 1
-	CEnumEntryPtr ptrLBLUTInput1 = ptrLBLUTInputSelector->GetEntryByName("Input1");
-	if (!IsAvailable(ptrLBLUTInput1) || !IsReadable(ptrLBLUTInput1))
-	{
-		cout << "Unable to set LUT logic block Input selector to input 1 (enum entry retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	ptrLBLUTInputSelector->SetIntValue(ptrLBLUTInput1->GetValue());
-
-	cout << "Logic Block LUT Input Selector set to to Input 1 ..." << endl;
-
-	CEnumEntryPtr ptrLBLUTSourceInput1= ptrLBLUTSource->GetEntryByName("ExposureEnd");
-	if (!IsAvailable(ptrLBLUTSourceInput1) || !IsReadable(ptrLBLUTSourceInput1))
-	{
-		cout << "Unable to set LUT logic block input source 1 (enum entry retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	ptrLBLUTSource->SetIntValue(ptrLBLUTSourceInput1->GetValue());
-
-	cout << "Logic Block LUT Input Source 1 set ..." << endl;
-
-	// Set Logic Block LUT Activation Type to Rising Edge
-
-	ptrLBLUTActivation->SetIntValue(ptrLBLUTActivationRE->GetValue());
-
-	cout << "Logic Block LUT Input Activation set to Rising Edge..." << endl;
-
-	// Set Logic Block LUT Input Selector to Input 2
-	CEnumEntryPtr ptrLBLUTInput2 = ptrLBLUTInputSelector->GetEntryByName("Input2");
-	if (!IsAvailable(ptrLBLUTInput2) || !IsReadable(ptrLBLUTInput2))
-	{
-		cout << "Unable to set LUT logic block selector to input 2 (enum entry retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	ptrLBLUTInputSelector->SetIntValue(ptrLBLUTInput2->GetValue());
-
-	cout << "Logic Block LUT Input Selector set to to Input 2 ..." << endl;
-
-	CEnumEntryPtr ptrLBLUTSourceInput2= ptrLBLUTSource->GetEntryByName("Zero");
-	if (!IsAvailable(ptrLBLUTSourceInput2) || !IsReadable(ptrLBLUTSourceInput2))
-	{
-		cout << "Unable to set LUT logic block input source 2 (enum entry retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	ptrLBLUTSource->SetIntValue(ptrLBLUTSourceInput2->GetValue());
-
-	cout << "Logic Block LUT Input Source 2 set ..." << endl;
-
-	// Set Logic Block LUT Activation Type to Level High
-
-	CEnumEntryPtr ptrLBLUTActivationLevelHigh = ptrLBLUTActivation->GetEntryByName("LevelHigh");
-	if (!IsAvailable(ptrLBLUTActivationLevelHigh) || !IsReadable(ptrLBLUTActivationLevelHigh))
-	{
-		cout << "Unable to set LUT logic block input activation to level high (enum entry retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	ptrLBLUTActivation->SetIntValue(ptrLBLUTActivationLevelHigh->GetValue());
-
-	cout << "Logic Block LUT Input Activation set to level high..." << endl;
-
-
-	// Set Logic Block Lut Selector to Value
-	CEnumEntryPtr ptrLBLUTValue = ptrLBLUTSelector->GetEntryByName("Value");
-	if (!IsAvailable(ptrLBLUTValue) || !IsReadable(ptrLBLUTValue))
-	{
-		cout << "Unable to set LUT logic block selector to Value (enum entry retrieval). Non-fatal error..." << endl;
-		return -1;
-	}
-
-	ptrLBLUTSelector->SetIntValue(ptrLBLUTValue->GetValue());
-
-	cout << "Logic Block LUT set to to Value..." << endl;
-
-	// Set Logic Block LUT output Value All
-	ptrLBLUTOutputValueAll->SetValue(0x22);
-
-	cout << "Logic Block LUT Output Value All set" << endl << endl;
-
-	return result;
-}
-
-
-// Strobe output
-int ConfigureLine2Strobe(INodeMap & nodeMap) {
-	int result = 0;
-	cout << endl << endl << "*** CONFIGURING STROBE ***" << endl << endl;
-
-	//Set Line Selector
-	CEnumerationPtr ptrLineSelector = nodeMap.GetNode("LineSelector");
-	if (!IsAvailable(ptrLineSelector) || !IsWritable(ptrLineSelector))
-	{
-		cout << "Unable to set Line Selector (enum retrieval). Aborting..." << endl << endl;
-		return -1;
-	}
-
-	CEnumEntryPtr ptrLineSelectorLine2 = ptrLineSelector->GetEntryByName("Line2");
-	if (!IsAvailable(ptrLineSelectorLine2) || !IsReadable(ptrLineSelectorLine2))
-	{
-		cout << "Unable to set Line Selector (entry retrieval). Aborting..." << endl << endl;
-		return -1;
-	}
-
-	int64_t lineSelectorLine2 = ptrLineSelectorLine2->GetValue();
-
-	ptrLineSelector->SetIntValue(lineSelectorLine2);
-
-	//Set Line Mode to output
-	CEnumerationPtr ptrLineMode = nodeMap.GetNode("LineMode");
-	if (!IsAvailable(ptrLineMode) || !IsWritable(ptrLineMode))
-	{
-		cout << "Unable to set Line Mode (enum retrieval). Aborting..." << endl << endl;
-		return -1;
-	}
-
-	CEnumEntryPtr ptrLineModeOutput = ptrLineMode->GetEntryByName("Output");
-	if (!IsAvailable(ptrLineModeOutput) || !IsReadable(ptrLineModeOutput))
-	{
-		cout << "Unable to set Line Mode (entry retrieval). Aborting..." << endl << endl;
-		return -1;
-	}
+	recipe.counters = {
+		{"Counter0", "MHzTick", "UserOutput0", "LevelHigh", nullptr, nullptr, frameRateTimer},
+		{"Counter1", "MHzTick", "Off", nullptr, "Counter0Start", "RisingEdge", strobeOffset}};
 
-	int64_t lineModeOutput = ptrLineModeOutput->GetValue();
-
-	ptrLineMode->SetIntValue(lineModeOutput);
-
-	// Set Line Source for Selected Line
-	CEnumerationPtr ptrLineSource = nodeMap.GetNode("LineSource");
-	if (!IsAvailable(ptrLineSource) || !IsWritable(ptrLineSource))
-	{
-		cout << "Unable to set Line Source (enum retrieval). Aborting..." << endl << endl;
-		return -1;
-	}
+	recipe.lines = {{"Line2", "Output", "LogicBlock0"}, {"Line1", nullptr, "ExposureActive"}};
 
-	CEnumEntryPtr ptrLineSourceVal= ptrLineSource->GetEntryByName("LogicBlock0");
-	if (!IsAvailable(ptrLineSourceVal) || !IsReadable(ptrLineSourceVal))
-	{
-		cout << "Unable to set Line Source (entry retrieval). Aborting..." << endl << endl;
-		return -1;
-	}
-
-	int64_t LineSourceVal = ptrLineSourceVal->GetValue();
-
-	ptrLineSource->SetIntValue(LineSourceVal);
-
-	return result;
-}
-
-// Exposure active Strobe 
-// Just for debugging
-int ConfigureLine1Strobe(INodeMap & nodeMap) {
-	int result = 0;
-	cout << endl << endl << "*** CONFIGURING STROBE ***" << endl << endl;
-
-	//Set Line Selector
-	CEnumerationPtr ptrLineSelector = nodeMap.GetNode("LineSelector");
-	if (!IsAvailable(ptrLineSelector) || !IsWritable(ptrLineSelector))
-	{
-		cout << "Unable to set Line Selector (enum retrieval). Aborting..." << endl << endl;
-		return -1;
-	}
-
-	CEnumEntryPtr ptrLineSelectorLine1 = ptrLineSelector->GetEntryByName("Line1");
-	if (!IsAvailable(ptrLineSelectorLine1) || !IsReadable(ptrLineSelectorLine1))
-	{
-		cout << "Unable to set Line Selector (entry retrieval). Aborting..." << endl << endl;
-		return -1;
-	}
-
-	int64_t lineSelectorLine1 = ptrLineSelectorLine1->GetValue();
-
-	ptrLineSelector->SetIntValue(lineSelectorLine1);
-
-
-	// Set Line Source for Selected Line to ExposureActive
-	CEnumerationPtr ptrLineSource = nodeMap.GetNode("LineSource");
-	if (!IsAvailable(ptrLineSource) || !IsWritable(ptrLineSource))
-	{
-		cout << "Unable to set Line Source (enum retrieval). Aborting..." << endl << endl;
-		return -1;
-	}
-
-	CEnumEntryPtr ptrLineSourceExposure = ptrLineSource->GetEntryByName("ExposureActive");
-	if (!IsAvailable(ptrLineSourceExposure) || !IsReadable(ptrLineSourceExposure))
-	{
-		cout << "Unable to set Line Source (entry retrieval). Aborting..." << endl << endl;
-		return -1;
-	}
-
-	int64_t LineSourceCounterUserExposure = ptrLineSourceExposure->GetValue();
-
-	ptrLineSource->SetIntValue(LineSourceCounterUserExposure);
-
-	return result;
+	return recipe;
 }
 
 int ConfigureTrigger(INodeMap & nodeMap)
@@ -1029,6 +517,29 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
 
 		cout << "Acquisition mode set to continuous..." << endl;
 
+		//
+		// Choose which frames are processed
+		//
+		// *** NOTES ***
+		// The selector looks at every complete image on the event thread,
+		// before it is copied. Frames it does not select are only counted and
+		// their camera buffers go straight back to the stream, so only the
+		// selected frames reach the loop below. The cheap intensity metric
+		// of PROCESS_FLAGGED reads the raw buffer in a single pass.
+		//
+		ProcessingPolicy policy = GetProcessingPolicy(chosenProcessing);
+		policy.interval = k_processInterval;
+		policy.minMean = k_minStrobeMean;
+		policy.maxMean = k_maxStrobeMean;
+		policy.maxSaturatedFraction = k_maxSaturatedFraction;
+		policy.maxMeanChange = k_maxMeanChange;
+		FrameSelector frameSelector(policy);
+
+		// Deliver images through the event handler instead of polling GetNextImage()
+		ImageEventQueue imageQueue(k_imageQueueDepth, chosenBackpressure);
+		imageQueue.SetFilter([&frameSelector](const ImagePtr& image) { return frameSelector.Select(image); });
+		ImageEventRegistration imageEvents(pCam, imageQueue);
+
 		//
 		// Begin acquiring images
 		//
@@ -1067,10 +578,11 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
 		// start the altrnating strobe
 		userOutputSet(nodeMap, "UserOutput0", true);
 		
-		// Retrieve, convert, and save images
+		// Retrieve, convert, and save images; skipped frames count towards k_numImages too
 		const unsigned int k_numImages = 1000;
+		unsigned int numReceived = 0;
 
-		for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
+		while (imageQueue.GetNumReceived() < k_numImages || imageQueue.GetNumQueued() > 0)
 		{
 			try
 			{
@@ -1078,15 +590,28 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
 				// Retrieve next received image
 				//
 				// *** NOTES ***
-				// Capturing an image houses images on the camera buffer. Trying
-				// to capture an image that does not exist will hang the camera.
+				// The image event handler has already copied the image out of
+				// the camera buffer. Waiting with a timeout means that a missed
+				// trigger is reported instead of hanging the example.
 				//
 				// *** LATER ***
-				// Once an image from the buffer is saved and/or no longer 
-				// needed, the image must be released in order to keep the 
-				// buffer from filling up.
+				// Once the image is no longer needed, it must be released back
+				// to the queue so that its buffer can hold another image.
 				//
-				ImagePtr pResultImage = pCam->GetNextImage();
+				QueuedImage image;
+				if (!imageQueue.WaitForImage(image, k_imageTimeout))
+				{
+					// Frames that were skipped still show that the strobe is running
+					if (imageQueue.GetNumReceived() > numReceived)
+					{
+						numReceived = imageQueue.GetNumReceived();
+						continue;
+					}
+
+					cout << "No image within " << k_imageTimeout << " ms; the trigger may have been missed..." << endl << endl;
+					break;
+				}
+				numReceived = imageQueue.GetNumReceived();
 
 				//
 				// Ensure image completion
@@ -1097,11 +622,11 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
 				// Further, check image status for a little more insight into
 				// why an image is incomplete.
 				//
-				if (pResultImage->IsIncomplete())
+				if (image.incomplete)
 				{
 					// Retreive and print the image status description
 					cout << "Image incomplete: "
-						<< Image::GetImageStatusDescription(pResultImage->GetImageStatus())
+						<< Image::GetImageStatusDescription(image.imageStatus)
 						<< "..." << endl << endl;
 				}
 				else
@@ -1114,11 +639,11 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
 					// things such as CRC, image status, and offset values, to
 					// name a few.
 					//
-					size_t width = pResultImage->GetWidth();
+					size_t width = image.pImage->GetWidth();
 
-					size_t height = pResultImage->GetHeight();
+					size_t height = image.pImage->GetHeight();
 
-					cout << "Grabbed image " << imageCnt << ", width = " << width << ", height = " << height << endl;
+					cout << "Grabbed image " << image.frameID << ", width = " << width << ", height = " << height << endl;
 
 					//
 					// Convert image to mono 8
@@ -1132,17 +657,17 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
 					// When converting images, color processing algorithm is an
 					// optional parameter.
 					// 
-					//ImagePtr convertedImage = pResultImage->Convert(PixelFormat_Mono8, HQ_LINEAR);
+					ImagePtr convertedImage = image.pImage->Convert(PixelFormat_Mono8, HQ_LINEAR);
 
-					//// Create a unique filename
-					//ostringstream filename;
+					// Create a unique filename
+					ostringstream filename;
 
-					//filename << "Acquisition-";
-					//if (deviceSerialNumber != "")
-					//{
-					//	filename << deviceSerialNumber.c_str() << "-";
-					//}
-					//filename << imageCnt << ".jpg";
+					filename << "Acquisition-";
+					if (deviceSerialNumber != "")
+					{
+						filename << deviceSerialNumber.c_str() << "-";
+					}
+					filename << image.frameID << ".jpg";
 
 					//
 					// Save image
@@ -1152,20 +677,19 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
 					// serial numbers to keep images of one device from 
 					// overwriting those of another.
 					//
-					//convertedImage->Save(filename.str().c_str());
+					convertedImage->Save(filename.str().c_str());
 
-					//cout << "Image saved at " << filename.str() << endl;
+					cout << "Image saved at " << filename.str() << endl;
 				}
 
 				//
 				// Release image
 				//
 				// *** NOTES ***
-				// Images retrieved directly from the camera (i.e. non-converted
-				// images) need to be released in order to keep from filling the
-				// buffer.
+				// Images from the queue need to be released in order to keep
+				// the queue from filling up.
 				//
-				pResultImage->Release();
+				imageQueue.Release(image);
 
 				cout << endl;
 			}
@@ -1189,6 +713,9 @@ int AcquireImages(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDevice
 
 		pCam->EndAcquisition();
 
+		imageQueue.PrintStatistics();
+		frameSelector.PrintStatistics();
+
 
 	}
 	catch (Spinnaker::Exception &e)
@@ -1231,38 +758,9 @@ int RunSingleCamera(CameraPtr pCam)
 			return err;
 		}
 
-		err = ConfigureLine2Strobe(nodeMap);
-
-		if (err < 0)
-		{
-			return err;
-		}
-
-		// configure line 1 strobe
-		// exposure active (for debug purposes)
-		err = ConfigureLine1Strobe(nodeMap);
-
-		if (err < 0)
-		{
-			return err;
-		}
-
-		// LB0 used to determine when Counter 0 is actve
-		err = ConfigureLogicBlock0(nodeMap);
-		if (err < 0)
-		{
-			return err;
-		}
-
-		// Configure counters 0
-		err = SetupCounter0(nodeMap, uS_FRAME_RATE_TIMER);
-		if (err < 0)
-		{
-			return err;
-		}
-
-		// Configure counters 1
-		err = SetupCounter1(nodeMap, uS_STROBE_OFFSET);
+		// Configure the strobe lines, LB0 and counters 0 and 1 from one recipe
+		TriggerRecipeEngine engine(pCam);
+		err = ConfigureTriggerRecipe(engine, GetStrobeBeforeExposureRecipe(uS_FRAME_RATE_TIMER, uS_STROBE_OFFSET)) ? 0 : -1;
 		if (err < 0)
 		{
 			return err;
@@ -35,16 +35,29 @@
 
 // for windows mkdir
 #ifdef _WIN32
+#include <windows.h>
 #include <direct.h>
+#else
+// for memory mapping on non-Windows
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
 #include <errno.h>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
 #include <vector>
 #include <queue>
 #include <string>
 #include <cstring>
 #include "dirent.h"
+#include "RawRecorder.h"
+#include "BoundedQueue.h"
+#include "ConversionBackend.h"
 
 using namespace Spinnaker;
 using namespace Spinnaker::GenApi;
@@ -64,6 +77,31 @@ using namespace std;
 #define RAW_INPUT_DIR           "./input"
 #define PROCESSED_OUTPUT_DIR    "output"
 
+// Define conversion threading. NUM_WORKER_THREADS of 0 uses one worker per
+// hardware thread and 1 converts the files serially on the main thread.
+// READ_AHEAD_DEPTH is the number of raw files kept loaded per worker so that
+// file reads overlap with conversion.
+#define NUM_WORKER_THREADS      0
+#define READ_AHEAD_DEPTH        2
+
+// Define the input path. By default the files are read into buffers on the
+// read-ahead thread above. With USE_MEMORY_MAPPING set to 1, each .raw file is
+// mapped into memory and converted in place rather than copied into a buffer,
+// and the read-ahead settings above are not used.
+// Setting RAW_CONTAINER_FILE to the path of a single file of concatenated raw
+// frames (HEIGHT * WIDTH * BYTE_DEPTH bytes each) maps that file once and
+// converts every frame in it instead of the files in RAW_INPUT_DIR; containers
+// written by RawRecorder.h are read through their frame index instead.
+#define USE_MEMORY_MAPPING      0
+#define RAW_CONTAINER_FILE      ""
+
+// With USE_CONVERSION_BACKEND set to 1, the files in RAW_INPUT_DIR are read on
+// the main thread and converted in batches by Common/ConversionBackend.h, on the
+// GPU when built with CONVERSION_BACKEND_USE_OPENCL defined and with
+// ImageProcessor otherwise. The threading and memory mapping settings above are
+// not used.
+#define USE_CONVERSION_BACKEND  0
+
 // Create a queue to store raw image filenames
 queue<string> raw_image_files;
 
@@ -130,9 +168,20 @@ int getdir(string dir, queue<string> & files)
     return 0;
 }
 
-// Convert .raw images to the target pixel format and file type, and store them in the output directory
-void processImages()
+// Build the output filepath for a .raw image file with the target file type extension
+string getOutputFilepath(const string & fileName)
+{
+    string newFilename = fileName;
+    replaceExt(newFilename, TARGET_FILE_TYPE);
+    return string(PROCESSED_OUTPUT_DIR) + string("/") + newFilename;
+}
+
+// Convert .raw images to the target pixel format and file type, and store them in the output directory.
+// Returns the number of files converted.
+uint64_t processImages()
 {
+    uint64_t filesDone = 0;
+
     // Create an ImagePtr object to get the image data
     ImagePtr tempImage = Image::Create();
     tempImage->ResetImage(WIDTH, HEIGHT, X_OFFSET, Y_OFFSET, RAW_IMAGE_PIXEL_TYPE);
@@ -143,7 +192,7 @@ void processImages()
     while (!raw_image_files.empty())
     {
         string fileName;
-        cout << "\nFiles remaining: " << raw_image_files.size() - 1 << "/" << total_files;
+        cout << "\nFiles converted: " << filesDone << "/" << total_files;
         fileName = raw_image_files.front();
         raw_image_files.pop();
         cout << "\t" << " converting file: " << fileName;
@@ -161,28 +210,662 @@ void processImages()
         }
 
         // Read the current .raw image data in the specified format and store them in the buffer
-        fread(buffer, sizeof(unsigned char), HEIGHT * WIDTH * BYTE_DEPTH, inFile);
+        const size_t bytesRead = fread(buffer, sizeof(unsigned char), HEIGHT * WIDTH * BYTE_DEPTH, inFile);
 
         fclose(inFile);
 
+        // A short file would leave the previous image in part of the buffer
+        if (bytesRead != HEIGHT * WIDTH * BYTE_DEPTH)
+        {
+            cout << "Error reading: " << filepath << " holds " << bytesRead << " of " << HEIGHT * WIDTH * BYTE_DEPTH << " bytes";
+            continue;
+        }
+
         // Create the new filename and path with the target file type extension
-        string newFilename = fileName;
-        replaceExt(newFilename, TARGET_FILE_TYPE);
-        string newFilepath = string(PROCESSED_OUTPUT_DIR) + string("/") + newFilename;
+        string newFilepath = getOutputFilepath(fileName);
 
         // Save the image to the target pixel format and file type
         try
         {
             ImagePtr convertedImage = tempImage->Convert(TARGET_IMAGE_FORMAT, HQ_LINEAR);
             convertedImage->Save(newFilepath.c_str());
+            ++filesDone;
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            cout << "Error: " << e.what() << endl;
+        }
+    }
+
+    return filesDone;
+}
+
+// A .raw image file loaded into one of the preallocated input buffers
+struct RawFrame
+{
+    string fileName;
+    ImagePtr image;
+};
+
+// Serializes console output from the worker threads
+mutex printMutex;
+
+// Read the .raw files in the queue into free input buffers, ahead of the workers converting them
+void readImages(BoundedQueue<ImagePtr> & freeBuffers, BoundedQueue<RawFrame> & loadedFrames)
+{
+    while (!raw_image_files.empty())
+    {
+        RawFrame frame;
+        frame.fileName = raw_image_files.front();
+        raw_image_files.pop();
+
+        // Wait for a worker to hand back an input buffer
+        freeBuffers.Pop(frame.image);
+
+        // Filepath for the current .raw image file
+        string filepath = string(RAW_INPUT_DIR) + string("/") + frame.fileName;
+
+        // Open the current .raw image
+        FILE* inFile = fopen(filepath.c_str(), "rb");
+
+        if (inFile == NULL)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "\nError reading: " << filepath;
+            freeBuffers.Push(frame.image);
+            continue;
+        }
+
+        // Read the current .raw image data in the specified format and store them in the buffer
+        const size_t bytesRead = fread(frame.image->GetData(), sizeof(unsigned char), HEIGHT * WIDTH * BYTE_DEPTH, inFile);
+
+        fclose(inFile);
+
+        // A short file would leave the previous image in part of the buffer
+        if (bytesRead != HEIGHT * WIDTH * BYTE_DEPTH)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "\nError reading: " << filepath << " holds " << bytesRead << " of " << HEIGHT * WIDTH * BYTE_DEPTH << " bytes";
+            freeBuffers.Push(frame.image);
+            continue;
+        }
+
+        loadedFrames.Push(frame);
+    }
+
+    loadedFrames.Close();
+}
+
+// Worker thread body; converts loaded .raw images into its own preallocated output image and saves them
+void convertImages(BoundedQueue<ImagePtr> & freeBuffers, BoundedQueue<RawFrame> & loadedFrames, atomic<uint64_t> & filesDone)
+{
+    // Create the output image once so that no image memory is allocated per file
+    ImagePtr convertedImage = Image::Create();
+    convertedImage->ResetImage(WIDTH, HEIGHT, X_OFFSET, Y_OFFSET, TARGET_IMAGE_FORMAT);
+
+    RawFrame frame;
+    while (loadedFrames.Pop(frame))
+    {
+        string newFilepath = getOutputFilepath(frame.fileName);
+
+        // Save the image to the target pixel format and file type
+        bool bufferReturned = false;
+        bool converted = false;
+        try
+        {
+            frame.image->Convert(convertedImage, TARGET_IMAGE_FORMAT, HQ_LINEAR);
+
+            // The input buffer can be refilled as soon as it has been converted
+            freeBuffers.Push(frame.image);
+            bufferReturned = true;
+
+            convertedImage->Save(newFilepath.c_str());
+            converted = true;
         }
         catch (Spinnaker::Exception& e)
         {
+            lock_guard<mutex> lock(printMutex);
             cout << "Error: " << e.what() << endl;
         }
+
+        if (!bufferReturned)
+        {
+            freeBuffers.Push(frame.image);
+        }
+
+        if (!converted)
+        {
+            continue;
+        }
+
+        const uint64_t done = ++filesDone;
+
+        lock_guard<mutex> lock(printMutex);
+        cout << "\nFiles converted: " << done << "/" << total_files;
+        cout << "\t" << " converted file: " << frame.fileName;
     }
 }
 
+// Convert .raw images across multiple worker threads, reading files ahead on a separate thread.
+// Returns the number of files converted.
+uint64_t processImagesParallel(unsigned int numWorkers)
+{
+    cout << "Converting with " << numWorkers << " worker threads..." << endl;
+
+    //
+    // Preallocate the input buffers
+    //
+    // *** NOTES ***
+    // READ_AHEAD_DEPTH buffers per worker are recycled between the reader
+    // and the workers, so there is always a file loaded and waiting when a
+    // worker finishes the previous one.
+    //
+    const unsigned int numBuffers = numWorkers * READ_AHEAD_DEPTH;
+    BoundedQueue<ImagePtr> freeBuffers(numBuffers);
+    BoundedQueue<RawFrame> loadedFrames(numBuffers);
+
+    for (unsigned int i = 0; i < numBuffers; i++)
+    {
+        ImagePtr rawImage = Image::Create();
+        rawImage->ResetImage(WIDTH, HEIGHT, X_OFFSET, Y_OFFSET, RAW_IMAGE_PIXEL_TYPE);
+        freeBuffers.Push(rawImage);
+    }
+
+    atomic<uint64_t> filesDone(0);
+    vector<thread> workers;
+
+    for (unsigned int i = 0; i < numWorkers; i++)
+    {
+        workers.push_back(thread(convertImages, ref(freeBuffers), ref(loadedFrames), ref(filesDone)));
+    }
+
+    readImages(freeBuffers, loadedFrames);
+
+    for (unsigned int i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+
+    return filesDone;
+}
+
+// Read-only memory mapping of a whole file (CreateFileMapping on Windows, mmap elsewhere)
+class MappedFile
+{
+public:
+    MappedFile() : data(NULL), size(0)
+#ifdef _WIN32
+        , fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL)
+#endif
+    {}
+
+    ~MappedFile()
+    {
+        unmap();
+    }
+
+    // Map the file at the given path, returning false if it cannot be mapped
+    bool map(const string & filepath)
+    {
+        unmap();
+
+#ifdef _WIN32
+        fileHandle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+        {
+            unmap();
+            return false;
+        }
+        size = static_cast<size_t>(fileSize.QuadPart);
+
+        mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mappingHandle == NULL)
+        {
+            unmap();
+            return false;
+        }
+
+        data = static_cast<unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+#else
+        int fd = open(filepath.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat fileInfo;
+        if (fstat(fd, &fileInfo) != 0 || fileInfo.st_size == 0)
+        {
+            close(fd);
+            return false;
+        }
+        size = static_cast<size_t>(fileInfo.st_size);
+
+        void* view = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        // The mapping stays valid once the descriptor is closed
+        close(fd);
+
+        if (view == MAP_FAILED)
+        {
+            size = 0;
+            return false;
+        }
+        data = static_cast<unsigned char*>(view);
+
+        // Frames are converted front to back
+        madvise(view, size, MADV_SEQUENTIAL);
+#endif
+        if (data == NULL)
+        {
+            unmap();
+            return false;
+        }
+        return true;
+    }
+
+    void unmap()
+    {
+#ifdef _WIN32
+        if (data != NULL)
+        {
+            UnmapViewOfFile(data);
+        }
+        if (mappingHandle != NULL)
+        {
+            CloseHandle(mappingHandle);
+            mappingHandle = NULL;
+        }
+        if (fileHandle != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(fileHandle);
+            fileHandle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (data != NULL)
+        {
+            munmap(data, size);
+        }
+#endif
+        data = NULL;
+        size = 0;
+    }
+
+    unsigned char* getData() const
+    {
+        return data;
+    }
+
+    size_t getSize() const
+    {
+        return size;
+    }
+
+private:
+    // Mappings are not copyable
+    MappedFile(const MappedFile &);
+    MappedFile & operator=(const MappedFile &);
+
+    unsigned char* data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE fileHandle;
+    HANDLE mappingHandle;
+#endif
+};
+
+// Take the next .raw filename off the queue; safe to call from several worker threads
+bool popRawFile(string & fileName)
+{
+    static mutex fileQueueMutex;
+    lock_guard<mutex> lock(fileQueueMutex);
+
+    if (raw_image_files.empty())
+    {
+        return false;
+    }
+    fileName = raw_image_files.front();
+    raw_image_files.pop();
+    return true;
+}
+
+// Worker thread body; maps each .raw file and converts it directly from the
+// mapped pages into its own preallocated output image
+void convertMappedImages(atomic<uint64_t> & filesDone)
+{
+    ImagePtr convertedImage = Image::Create();
+    convertedImage->ResetImage(WIDTH, HEIGHT, X_OFFSET, Y_OFFSET, TARGET_IMAGE_FORMAT);
+
+    MappedFile mappedFile;
+    string fileName;
+
+    while (popRawFile(fileName))
+    {
+        // Filepath for the current .raw image file
+        string filepath = string(RAW_INPUT_DIR) + string("/") + fileName;
+
+        if (!mappedFile.map(filepath) || mappedFile.getSize() < HEIGHT * WIDTH * BYTE_DEPTH)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "\nError reading: " << filepath;
+            continue;
+        }
+
+        bool converted = false;
+        try
+        {
+            // Wrap the mapped file without copying; the mapping must outlive the image
+            ImagePtr rawImage = Image::Create(WIDTH, HEIGHT, X_OFFSET, Y_OFFSET, RAW_IMAGE_PIXEL_TYPE, mappedFile.getData());
+
+            rawImage->Convert(convertedImage, TARGET_IMAGE_FORMAT, HQ_LINEAR);
+            convertedImage->Save(getOutputFilepath(fileName).c_str());
+            converted = true;
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Error: " << e.what() << endl;
+        }
+
+        mappedFile.unmap();
+
+        if (!converted)
+        {
+            continue;
+        }
+
+        const uint64_t done = ++filesDone;
+
+        lock_guard<mutex> lock(printMutex);
+        cout << "\nFiles converted: " << done << "/" << total_files;
+        cout << "\t" << " converted file: " << fileName;
+    }
+}
+
+// Convert each .raw file through a memory mapping across multiple worker threads.
+// Returns the number of files converted.
+uint64_t processMappedImages(unsigned int numWorkers)
+{
+    cout << "Converting memory mapped files with " << numWorkers << " worker threads..." << endl;
+
+    atomic<uint64_t> filesDone(0);
+    vector<thread> workers;
+
+    for (unsigned int i = 0; i < numWorkers; i++)
+    {
+        workers.push_back(thread(convertMappedImages, ref(filesDone)));
+    }
+
+    for (unsigned int i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+
+    return filesDone;
+}
+
+// Get the filename of a container without its directory and extension, to prefix its output files with
+string getContainerName(const string & filepath)
+{
+    string name = filepath;
+
+    string::size_type i = name.find_last_of("/\\");
+    if (i != string::npos)
+    {
+        name = name.substr(i + 1);
+    }
+
+    i = name.rfind('.');
+    if (i != string::npos && i > 0)
+    {
+        name = name.substr(0, i);
+    }
+    return name;
+}
+
+// Worker thread body; converts frames of the mapped container, taking the next
+// unconverted frame index each time
+void convertContainerFrames(const MappedFile & container, const string & containerName,
+    const vector<RawContainerIndexEntry> & frames, atomic<uint64_t> & nextFrame, atomic<uint64_t> & filesDone)
+{
+    ImagePtr convertedImage = Image::Create();
+    convertedImage->ResetImage(WIDTH, HEIGHT, X_OFFSET, Y_OFFSET, TARGET_IMAGE_FORMAT);
+
+    for (uint64_t frame = nextFrame++; frame < frames.size(); frame = nextFrame++)
+    {
+        const RawContainerIndexEntry & entry = frames[static_cast<size_t>(frame)];
+
+        // Frame IDs restart with every acquisition and camera, so the name also holds the
+        // container's name (the recorders put the camera serial number in it) and the frame's
+        // position in the container
+        ostringstream frameName;
+        frameName << containerName << "-" << frame << "-frame-" << entry.frameID << "." << RAW_FILE_TYPE;
+
+        if (!RawContainerEntryHoldsImage(entry))
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Error: frame " << frame << " of " << containerName << " holds " << entry.size
+                 << " bytes, too few for a " << entry.width << "x" << entry.height << " image" << endl;
+            continue;
+        }
+
+        bool converted = false;
+        try
+        {
+            // Recordings from different cameras or ROIs can hold frames of another size
+            if (convertedImage->GetWidth() != entry.width || convertedImage->GetHeight() != entry.height)
+            {
+                convertedImage->ResetImage(entry.width, entry.height, 0, 0, TARGET_IMAGE_FORMAT);
+            }
+
+            ImagePtr rawImage = Image::Create(entry.width, entry.height, 0, 0,
+                static_cast<PixelFormatEnums>(entry.pixelFormat), container.getData() + entry.offset);
+
+            rawImage->Convert(convertedImage, TARGET_IMAGE_FORMAT, HQ_LINEAR);
+            convertedImage->Save(getOutputFilepath(frameName.str()).c_str());
+            converted = true;
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Error: " << e.what() << endl;
+        }
+
+        if (!converted)
+        {
+            continue;
+        }
+
+        const uint64_t done = ++filesDone;
+
+        lock_guard<mutex> lock(printMutex);
+        cout << "\nFrames converted: " << done << "/" << total_files;
+        cout << "\t" << " converted frame: " << entry.frameID;
+    }
+}
+
+// Map a single multi-frame container file once and convert all of its frames across multiple worker threads.
+// Containers recorded with RawRecorder.h are read through their index; any other file is treated as
+// back-to-back frames using the image settings above. Returns the number of frames converted.
+uint64_t processMappedContainer(const string & filepath, unsigned int numWorkers)
+{
+    MappedFile container;
+    if (!container.map(filepath))
+    {
+        cout << "Error reading: " << filepath << endl;
+        return 0;
+    }
+
+    vector<RawContainerIndexEntry> frames;
+
+    if (ReadRawContainerIndex(container.getData(), container.getSize(), frames))
+    {
+        cout << "Read index of " << frames.size() << " recorded frames from " << filepath << endl;
+    }
+    else
+    {
+        const size_t frameSize = HEIGHT * WIDTH * BYTE_DEPTH;
+
+        if (container.getSize() % frameSize != 0)
+        {
+            cout << "Warning: " << filepath << " is not a whole number of frames, ignoring the last "
+                << container.getSize() % frameSize << " bytes" << endl;
+        }
+
+        frames.resize(container.getSize() / frameSize);
+        for (size_t i = 0; i < frames.size(); i++)
+        {
+            frames[i].frameID = i;
+            frames[i].timestamp = 0;
+            frames[i].offset = i * frameSize;
+            frames[i].size = frameSize;
+            frames[i].width = WIDTH;
+            frames[i].height = HEIGHT;
+            frames[i].pixelFormat = RAW_IMAGE_PIXEL_TYPE;
+            frames[i].reserved = 0;
+        }
+    }
+
+    total_files = frames.size();
+
+    cout << "Converting " << total_files << " frames from " << filepath << " with " << numWorkers << " worker threads..." << endl;
+
+    const string containerName = getContainerName(filepath);
+    atomic<uint64_t> nextFrame(0);
+    atomic<uint64_t> filesDone(0);
+    vector<thread> workers;
+
+    for (unsigned int i = 0; i < numWorkers; i++)
+    {
+        workers.push_back(thread(convertContainerFrames, cref(container), cref(containerName), cref(frames), ref(nextFrame), ref(filesDone)));
+    }
+
+    for (unsigned int i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+
+    return filesDone;
+}
+
+// Saver thread body; saves the images converted by the backend in the order the files were read
+void saveBackendImages(ConversionBackend & backend, const vector<string> & fileNames, atomic<uint64_t> & filesDone)
+{
+    ConvertedFrame frame;
+
+    while (!backend.IsDrained())
+    {
+        if (!backend.Retrieve(frame, 100))
+        {
+            continue;
+        }
+
+        const string & fileName = fileNames[static_cast<size_t>(frame.tag)];
+        bool converted = false;
+
+        if (!frame.converted)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "\nError: " << fileName << " could not be converted";
+        }
+        else
+        {
+            try
+            {
+                frame.pImage->Save(getOutputFilepath(fileName).c_str());
+                converted = true;
+            }
+            catch (Spinnaker::Exception& e)
+            {
+                lock_guard<mutex> lock(printMutex);
+                cout << "Error: " << e.what() << endl;
+            }
+        }
+
+        backend.Release(frame);
+
+        if (!converted)
+        {
+            continue;
+        }
+
+        const uint64_t done = ++filesDone;
+
+        lock_guard<mutex> lock(printMutex);
+        cout << "\nFiles converted: " << done << "/" << total_files;
+        cout << "\t" << " converted file: " << fileName;
+    }
+}
+
+// Convert .raw images in batches with the conversion backend, saving them on a separate thread.
+// Returns the number of files converted.
+uint64_t processImagesConversionBackend()
+{
+    // File names indexed by the tag each image is submitted with
+    vector<string> fileNames;
+    while (!raw_image_files.empty())
+    {
+        fileNames.push_back(raw_image_files.front());
+        raw_image_files.pop();
+    }
+
+    ConversionBackend backend(CONVERSION_BACKEND_AUTO, TARGET_IMAGE_FORMAT);
+    cout << "Converting with " << backend.GetName() << "..." << endl;
+
+    // Submit() copies the image into a backend slot, so one input buffer is enough
+    ImagePtr rawImage = Image::Create();
+    rawImage->ResetImage(WIDTH, HEIGHT, X_OFFSET, Y_OFFSET, RAW_IMAGE_PIXEL_TYPE);
+
+    atomic<uint64_t> filesDone(0);
+    thread saver(saveBackendImages, ref(backend), cref(fileNames), ref(filesDone));
+
+    for (size_t i = 0; i < fileNames.size(); i++)
+    {
+        // Filepath for the current .raw image file
+        string filepath = string(RAW_INPUT_DIR) + string("/") + fileNames[i];
+
+        // Open the current .raw image
+        FILE* inFile = fopen(filepath.c_str(), "rb");
+
+        if (inFile == NULL)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "\nError reading: " << filepath;
+            continue;
+        }
+
+        // Read the current .raw image data in the specified format and store them in the buffer
+        const size_t bytesRead = fread(rawImage->GetData(), sizeof(unsigned char), HEIGHT * WIDTH * BYTE_DEPTH, inFile);
+
+        fclose(inFile);
+
+        // A short file would leave the previous image in part of the buffer
+        if (bytesRead != HEIGHT * WIDTH * BYTE_DEPTH)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "\nError reading: " << filepath << " holds " << bytesRead << " of " << HEIGHT * WIDTH * BYTE_DEPTH << " bytes";
+            continue;
+        }
+
+        backend.Submit(rawImage, i);
+    }
+
+    // Convert the last partly filled batch and wait for the saver to save it
+    backend.Finish();
+    saver.join();
+
+    cout << endl;
+    backend.PrintStatistics();
+
+    return filesDone;
+}
+
 // Example entry point; please see Enumeration example for more in-depth
 // comments on preparing and cleaning up the system.
 int main(int /*argc*/, char** /*argv*/)
@@ -236,18 +919,67 @@ int main(int /*argc*/, char** /*argv*/)
         }
     }
 
-    // Directory for the .raw files
-    string dir = string(RAW_INPUT_DIR) + string("/");
+    const string containerFile = RAW_CONTAINER_FILE;
+
+    if (containerFile.empty())
+    {
+        // Directory for the .raw files
+        string dir = string(RAW_INPUT_DIR) + string("/");
 
-    // Get .raw files under the specified directory
-    getdir(dir, raw_image_files);
+        // Get .raw files under the specified directory
+        getdir(dir, raw_image_files);
 
-    // Total number of .raw images to be processed
-    total_files = raw_image_files.size();
+        // Total number of .raw images to be processed
+        total_files = raw_image_files.size();
+    }
 
     // Convert images
-    processImages();
+    unsigned int numWorkers = NUM_WORKER_THREADS;
+    if (numWorkers == 0)
+    {
+        numWorkers = thread::hardware_concurrency() > 0 ? thread::hardware_concurrency() : 1;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    uint64_t convertedFiles = 0;
+
+    if (!containerFile.empty())
+    {
+        convertedFiles = processMappedContainer(containerFile, numWorkers);
+    }
+    else if (USE_CONVERSION_BACKEND)
+    {
+        convertedFiles = processImagesConversionBackend();
+    }
+    else if (USE_MEMORY_MAPPING)
+    {
+        convertedFiles = processMappedImages(numWorkers);
+    }
+    else if (numWorkers > 1)
+    {
+        convertedFiles = processImagesParallel(numWorkers);
+    }
+    else
+    {
+        convertedFiles = processImages();
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << endl << endl << "Converted " << convertedFiles << " of " << total_files << " files in " << seconds << " seconds";
+    if (seconds > 0)
+    {
+        cout << " (" << convertedFiles / seconds << " files/s)";
+    }
+    cout << endl;
+
+    // Files that could not be read, converted or saved were reported above
+    if (convertedFiles < total_files || (!containerFile.empty() && total_files == 0))
+    {
+        result = -1;
+    }
 
     cout << endl << endl << "Done! Press Enter to exit..." << endl;
     getchar();
-}
\ No newline at end of file
+
+    return result;
+}
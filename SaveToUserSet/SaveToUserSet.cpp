@@ -27,6 +27,8 @@
 #include "SpinGenApi/SpinnakerGenApi.h"
 #include <iostream>
 #include <sstream> 
+#include <chrono>
+#include "FleetProvisioning.h"
 
 //
 // Uncomment to have the camera restored to factory default settings (please note this overrides any settings changes made)
@@ -38,6 +40,16 @@ using namespace Spinnaker::GenApi;
 using namespace Spinnaker::GenICam;
 using namespace std;
 
+// Provision the cameras one after the other, or the whole fleet at once on a pool of worker
+// threads that initialize, configure and save up to k_maxConcurrentProvisioning cameras in parallel
+enum provisioningModeType
+{
+    PROVISION_ONE_BY_ONE,
+    PROVISION_FLEET
+};
+
+const provisioningModeType chosenProvisioningMode = PROVISION_FLEET;
+
 // This function sets the exposure time to 2000 microseconds and saves that to User Set 1
 int SaveCustomSettings(CameraPtr pCam, INodeMap& nodeMap, INodeMap& nodeMapTLDevice)
 {
@@ -234,6 +246,59 @@ int RunSingleCamera(CameraPtr pCam)
     return result;
 }
 
+// This function applies the settings of SaveCustomSettings() to every camera of the list
+// concurrently and prints how long each camera took, and why it failed if it did.
+int ProvisionFleet(CameraList& camList)
+{
+    int result = 0;
+
+    cout << endl << endl << "*** PROVISIONING " << camList.GetSize() << " CAMERAS ***" << endl << endl;
+
+    try
+    {
+        vector<CameraPtr> cameras;
+        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        {
+            cameras.push_back(camList.GetByIndex(i));
+        }
+
+        //
+        // Apply the same profile to every camera
+        //
+        // *** NOTES ***
+        // Most of the time spent on a camera is Init() downloading its nodemap,
+        // so the workers initialize the cameras at the same time and each
+        // camera costs little more than its own round trips. A camera that
+        // fails is reported and does not stop the others.
+        //
+        ProvisioningProfile profile = ProvisioningProfile();
+        profile.exposureTime = 2000.0;
+        profile.userSet = "UserSet1";
+        profile.startupUserSet = "UserSet1";
+#ifdef RESTORE_FACTORY_DEFAULT
+        profile.startupUserSet = "Default";
+        profile.loadUserSet = "Default";
+#endif
+
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        vector<ProvisioningResult> results;
+        if (!ProvisionCameras(cameras, profile, results))
+        {
+            result = -1;
+        }
+
+        PrintProvisioningResults(results, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    }
+    catch (Spinnaker::Exception& e)
+    {
+        cout << "Error: " << e.what() << endl;
+        result = -1;
+    }
+
+    return result;
+}
+
 // Example entry point; please see Enumeration example for more in-depth 
 // comments on preparing and cleaning up the system.
 int main(int /*argc*/, char** /*argv*/)
@@ -273,18 +338,26 @@ int main(int /*argc*/, char** /*argv*/)
     // Create shared pointer to camera
     CameraPtr pCam = NULL;
 
-    // Run example on each camera
-    for (unsigned int i = 0; i < numCameras; i++)
+    if (chosenProvisioningMode == PROVISION_FLEET)
     {
-        // Select camera
-        pCam = camList.GetByIndex(i);
+        // Run example on every camera at once
+        result = ProvisionFleet(camList);
+    }
+    else
+    {
+        // Run example on each camera
+        for (unsigned int i = 0; i < numCameras; i++)
+        {
+            // Select camera
+            pCam = camList.GetByIndex(i);
 
-        cout << endl << "Running example for camera " << i << "..." << endl;
+            cout << endl << "Running example for camera " << i << "..." << endl;
 
-        // Run example
-        result = result | RunSingleCamera(pCam);
+            // Run example
+            result = result | RunSingleCamera(pCam);
 
-        cout << "Camera " << i << " example complete..." << endl << endl;
+            cout << "Camera " << i << " example complete..." << endl << endl;
+        }
     }
 
     //
@@ -41,6 +41,10 @@
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include "FrameStats.h"
+#include "FileTransfer.h"
+#include "FlatFieldCorrection.h"
+#include <memory>
 
 using namespace Spinnaker;
 using namespace Spinnaker::GenApi;
@@ -51,6 +55,30 @@ static bool _enableDebug = false;
 static string filename = "";
 static gcstring _fileSelector = "UserShadingCoeff1";
 
+// Per-frame stage timings of the acquisition are printed at the end and written to this CSV
+// file every _frameStatsInterval seconds (empty to only print them)
+static string _frameStatsFileName = "ShadingCorrection-stats.csv";
+static double _frameStatsInterval = 5.0;
+
+// Lens shading is corrected by the camera, or by the host flat-field engine on cameras without
+// LensShadingCorrectionMode; the host engine can also be chosen for any camera with -s
+enum shadingCorrectionEngineType
+{
+    ON_CAMERA_SHADING_CORRECTION,
+    HOST_SHADING_CORRECTION
+};
+static shadingCorrectionEngineType _shadingCorrectionEngine = ON_CAMERA_SHADING_CORRECTION;
+
+// Set by SwitchShadingCorrectionMode() when acquired images are to be corrected on the host
+static bool _hostShadingCorrection = false;
+
+// Frames averaged into the host flat-field map, optionally preceded by as many dark frames
+// (-k), the file the map is kept in between runs, and the threads that apply it
+static unsigned int _numFlatFieldFrames = 16;
+static bool _captureDarkFrames = false;
+static string _flatFieldFileName = "ShadingCorrection-flatfield.bin";
+static unsigned int _numFlatFieldThreads = 4;
+
 // Print out usage of the application
 void PrintUsage()
 {
@@ -61,7 +89,9 @@ void PrintUsage()
          << endl;
     cout << "Usage: LensShadingCorrection [options] COMMAND" << endl << endl;
     cout << "Option:\n\t";
-    cout << "-v : Enable verbose output" << endl;
+    cout << "-v : Enable verbose output\n\t";
+    cout << "-s : Correct acquired images with the host flat-field engine instead of the camera\n\t";
+    cout << "-k : Capture dark frames with the lens capped before calibrating the host flat-field engine" << endl;
 
     cout << "Commands:\n\t";
     cout << "-c : Create and deploy calibration file to camera\n\t";
@@ -194,12 +224,42 @@ int SwitchShadingCorrectionMode(CameraPtr pCam, bool mode)
     INodeMap& nodeMap = pCam->GetNodeMap();
     PrintDebugMessage("Configuring camera for lens shading correction with new calibration file");
 
+    CEnumerationPtr ptrLensShadingCorrectionMode = nodeMap.GetNode("LensShadingCorrectionMode");
+    gcstring modeString = mode ? "Active" : "Off";
+
+    //
+    // Fall back to the host flat-field engine
+    //
+    // *** NOTES ***
+    // Older cameras have no lens shading correction of their own. On those,
+    // or when the host engine is chosen, the on camera correction is turned
+    // off where it exists so that the images are not corrected twice, and
+    // AcquireImages() corrects every image on the host instead.
+    //
+    if (_shadingCorrectionEngine == HOST_SHADING_CORRECTION || !IsWritable(ptrLensShadingCorrectionMode))
+    {
+        if (IsWritable(ptrLensShadingCorrectionMode))
+        {
+            CEnumEntryPtr ptrLensShadingCorrectionModeOff = ptrLensShadingCorrectionMode->GetEntryByName("Off");
+            if (IsReadable(ptrLensShadingCorrectionModeOff))
+            {
+                ptrLensShadingCorrectionMode->SetIntValue(ptrLensShadingCorrectionModeOff->GetValue());
+            }
+        }
+        else
+        {
+            PrintDebugMessage("Lens Shading Correction mode not available on this camera");
+        }
+
+        _hostShadingCorrection = mode;
+        cout << "Host flat-field correction set to " << modeString << "..." << endl;
+        return 0;
+    }
+    _hostShadingCorrection = false;
+
     // Ensure lens shading correction mode is set to Active
     // Retrieve entry node from enumeration node
-
-    CEnumerationPtr ptrLensShadingCorrectionMode = nodeMap.GetNode("LensShadingCorrectionMode");
     CEnumEntryPtr ptrLensShadingCorrectionModeSelected;
-    gcstring modeString = mode ? "Active" : "Off";
 
     ptrLensShadingCorrectionModeSelected = ptrLensShadingCorrectionMode->GetEntryByName(modeString);
 
@@ -222,6 +282,123 @@ int SwitchShadingCorrectionMode(CameraPtr pCam, bool mode)
     return 0;
 }
 
+// This function grabs _numFlatFieldFrames images, converts them to mono 8 and adds them to
+// the calibrator as flat frames, or as dark frames when dark is set.
+int CaptureFlatFieldFrames(CameraPtr pCam, ImageProcessor& processor, FlatFieldCalibrator& calibrator, bool dark)
+{
+    int result = 0;
+
+    try
+    {
+        pCam->BeginAcquisition();
+
+        for (unsigned int imageCnt = 0; imageCnt < _numFlatFieldFrames; imageCnt++)
+        {
+            try
+            {
+                ImagePtr pResultImage = pCam->GetNextImage(1000);
+
+                if (pResultImage->IsIncomplete())
+                {
+                    cout << "Image incomplete: " << Image::GetImageStatusDescription(pResultImage->GetImageStatus())
+                         << "..." << endl;
+                }
+                else
+                {
+                    ImagePtr convertedImage = processor.Convert(pResultImage, PixelFormat_Mono8);
+                    const bool added =
+                        dark ? calibrator.AddDarkFrame(convertedImage) : calibrator.AddFlatFrame(convertedImage);
+                    if (!added)
+                    {
+                        cout << "Unable to add image " << imageCnt << " to the flat-field calibration..." << endl;
+                        result = -1;
+                    }
+                }
+
+                pResultImage->Release();
+            }
+            catch (Spinnaker::Exception& e)
+            {
+                cout << "Error: " << e.what() << endl;
+                result = -1;
+            }
+        }
+
+        pCam->EndAcquisition();
+    }
+    catch (Spinnaker::Exception& e)
+    {
+        cout << "Error: " << e.what() << endl;
+        return -1;
+    }
+
+    cout << "Captured " << (dark ? calibrator.GetNumDarkFrames() : calibrator.GetNumFlatFrames()) << " "
+         << (dark ? "dark" : "flat") << " frames..." << endl;
+
+    return result;
+}
+
+// This function loads the host flat-field map saved by an earlier run, or calibrates a new one
+// from images of the camera and saves it. Delete the file to calibrate again.
+bool PrepareFlatFieldMap(CameraPtr pCam, INodeMap& nodeMap, FlatFieldMap& flatFieldMap)
+{
+    cout << endl << "*** HOST FLAT-FIELD CALIBRATION ***" << endl << endl;
+
+    // A saved map is only used if it was made for the images that are about to be acquired
+    CIntegerPtr ptrWidth = nodeMap.GetNode("Width");
+    CIntegerPtr ptrHeight = nodeMap.GetNode("Height");
+    if (flatFieldMap.Load(_flatFieldFileName) && flatFieldMap.bitsPerPixel == 8 && IsReadable(ptrWidth) &&
+        IsReadable(ptrHeight) && flatFieldMap.width == ptrWidth->GetValue() &&
+        flatFieldMap.height == ptrHeight->GetValue())
+    {
+        cout << "Flat-field map loaded from " << _flatFieldFileName << (flatFieldMap.HasDark() ? " (with dark frame)" : "")
+             << "..." << endl;
+        return true;
+    }
+
+    ImageProcessor processor;
+    FlatFieldCalibrator calibrator;
+
+    if (_captureDarkFrames)
+    {
+        cout << "Cap the lens and press Enter to capture " << _numFlatFieldFrames << " dark frames..." << endl;
+        getchar();
+
+        if (CaptureFlatFieldFrames(pCam, processor, calibrator, true) != 0)
+        {
+            return false;
+        }
+    }
+
+    cout << "Point the camera at a uniformly lit target and press Enter to capture " << _numFlatFieldFrames
+         << " flat frames..." << endl;
+    getchar();
+
+    if (CaptureFlatFieldFrames(pCam, processor, calibrator, false) != 0)
+    {
+        return false;
+    }
+
+    if (!calibrator.Build(flatFieldMap))
+    {
+        cout << "Unable to build the flat-field map; the flat frames are no brighter than the dark frames. Aborting..."
+             << endl
+             << endl;
+        return false;
+    }
+
+    if (flatFieldMap.Save(_flatFieldFileName))
+    {
+        cout << "Flat-field map saved at " << _flatFieldFileName << endl;
+    }
+    else
+    {
+        cout << "Unable to save the flat-field map at " << _flatFieldFileName << "..." << endl;
+    }
+
+    return true;
+}
+
 // This function acquires and saves 10 images from a device.
 int AcquireImages(CameraPtr pCam, INodeMap& nodeMap, INodeMap& nodeMapTLDevice)
 {
@@ -284,6 +461,23 @@ int AcquireImages(CameraPtr pCam, INodeMap& nodeMap, INodeMap& nodeMapTLDevice)
 #else
         result = result | ResetGVCPHeartbeat(pCam);
 #endif
+
+        // Calibrate the host flat-field engine before the images that are saved
+        unique_ptr<FlatFieldCorrection> pFlatField;
+        if (_hostShadingCorrection)
+        {
+            FlatFieldMap flatFieldMap;
+            if (!PrepareFlatFieldMap(pCam, nodeMap, flatFieldMap))
+            {
+                return -1;
+            }
+
+            pFlatField.reset(new FlatFieldCorrection(flatFieldMap, _numFlatFieldThreads));
+            cout << "Host flat-field correction uses " << _numFlatFieldThreads << " threads ("
+                 << FlatFieldCorrection::GetInstructionSet() << ")..." << endl
+                 << endl;
+        }
+
         //
         // Begin acquiring images
         //
@@ -336,6 +530,10 @@ int AcquireImages(CameraPtr pCam, INodeMap& nodeMap, INodeMap& nodeMapTLDevice)
         //
         processor.SetColorProcessing(SPINNAKER_COLOR_PROCESSING_ALGORITHM_HQ_LINEAR);
 
+        // Time each stage of the acquisition loop
+        FrameStats stats("ShadingCorrection", _frameStatsFileName, _frameStatsInterval);
+        FrameRecorder& frameRecorder = stats.CreateRecorder();
+
         for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
         {
             try
@@ -352,7 +550,10 @@ int AcquireImages(CameraPtr pCam, INodeMap& nodeMap, INodeMap& nodeMapTLDevice)
                 // needed, the image must be released in order to keep the
                 // buffer from filling up.
                 //
+                StageTimer getTimer(frameRecorder, STAGE_GET_NEXT_IMAGE);
                 ImagePtr pResultImage = pCam->GetNextImage(1000);
+                getTimer.Stop();
+                frameRecorder.RecordFrame(pResultImage);
 
                 //
                 // Ensure image completion
@@ -398,7 +599,23 @@ int AcquireImages(CameraPtr pCam, INodeMap& nodeMap, INodeMap& nodeMapTLDevice)
                     // When converting images, color processing algorithm is an
                     // optional parameter.
                     //
+                    StageTimer convertTimer(frameRecorder, STAGE_CONVERT);
                     ImagePtr convertedImage = processor.Convert(pResultImage, PixelFormat_Mono8);
+                    convertTimer.Stop();
+
+                    // Correct the converted image in place with the host flat-field map
+                    if (pFlatField)
+                    {
+                        StageTimer flatFieldTimer(frameRecorder, STAGE_FLAT_FIELD);
+                        const bool corrected = pFlatField->Apply(convertedImage, convertedImage);
+                        flatFieldTimer.Stop();
+
+                        if (!corrected)
+                        {
+                            cout << "Flat-field map does not match image " << imageCnt << "; saved uncorrected..."
+                                 << endl;
+                        }
+                    }
 
                     // Create a unique filename
                     ostringstream filename;
@@ -418,7 +635,9 @@ int AcquireImages(CameraPtr pCam, INodeMap& nodeMap, INodeMap& nodeMapTLDevice)
                     // serial numbers to keep images of one device from
                     // overwriting those of another.
                     //
+                    StageTimer saveTimer(frameRecorder, STAGE_SAVE);
                     convertedImage->Save(filename.str().c_str());
+                    saveTimer.Stop();
 
                     cout << "Image saved at " << filename.str() << endl;
                 }
@@ -431,7 +650,11 @@ int AcquireImages(CameraPtr pCam, INodeMap& nodeMap, INodeMap& nodeMapTLDevice)
                 // images) need to be released in order to keep from filling the
                 // buffer.
                 //
+                StageTimer releaseTimer(frameRecorder, STAGE_RELEASE);
                 pResultImage->Release();
+                releaseTimer.Stop();
+
+                stats.ReportIfDue();
 
                 cout << endl;
             }
@@ -442,6 +665,10 @@ int AcquireImages(CameraPtr pCam, INodeMap& nodeMap, INodeMap& nodeMapTLDevice)
             }
         }
 
+        // Print the stage timings and stream statistics
+        stats.RecordStreamStatistics(pCam->GetTLStreamNodeMap());
+        stats.Report();
+
         //
         // End acquisition
         //
@@ -628,140 +855,6 @@ bool LensShadingCorrectionCalibrationStatus(INodeMap& nodeMap)
     return result;
 }
 
-// Open camera file to read
-bool OpenFileToRead(CameraPtr pCamera)
-{
-    cout << "Opening file for reading..." << endl;
-    try
-    {
-        pCamera->FileOperationSelector.SetValue(FileOperationSelector_Open);
-        pCamera->FileOpenMode.SetValue(FileOpenMode_Read);
-        pCamera->FileOperationExecute.Execute();
-
-        if (pCamera->FileOperationStatus.GetValue() != FileOperationStatus_Success)
-        {
-            cout << "Failed to open file for reading!" << endl;
-            return false;
-        }
-    }
-    catch (Spinnaker::Exception& e)
-    {
-        cout << "Unexpected exception : " << e.what() << endl;
-        return false;
-    }
-    return true;
-}
-
-// Execute read operation
-bool ExecuteReadCommand(CameraPtr pCamera)
-{
-    try
-    {
-        pCamera->FileOperationSelector.SetValue(FileOperationSelector_Read);
-        pCamera->FileOperationExecute.Execute();
-
-        if (pCamera->FileOperationStatus.GetValue() != FileOperationStatus_Success)
-        {
-            cout << "Failed to read file!" << endl;
-            return false;
-        }
-    }
-    catch (Spinnaker::Exception& e)
-    {
-        cout << "Unexpected exception : " << e.what() << endl;
-        return false;
-    }
-    return true;
-}
-
-// Close the file
-bool CloseFile(CameraPtr pCam)
-{
-    PrintDebugMessage("Closing file...");
-    try
-    {
-        pCam->FileOperationSelector.SetValue(FileOperationSelector_Close);
-        pCam->FileOperationExecute.Execute();
-        if (pCam->FileOperationStatus.GetValue() != FileOperationStatus_Success)
-        {
-            cout << "Failed to close file!" << endl;
-            return false;
-        }
-    }
-    catch (Spinnaker::Exception& e)
-    {
-        cout << "Unexpected exception : " << e.what();
-        return false;
-    }
-    return true;
-}
-
-// Execute delete operation
-bool ExecuteDeleteCommand(CameraPtr pCam)
-{
-    PrintDebugMessage("Deleting file...");
-    try
-    {
-        pCam->FileOperationSelector.SetValue(FileOperationSelector_Delete);
-        pCam->FileOperationExecute.Execute();
-        if (pCam->FileOperationStatus.GetValue() != FileOperationStatus_Success)
-        {
-            cout << "Failed to delete file!" << endl;
-            return false;
-        }
-    }
-    catch (Spinnaker::Exception& e)
-    {
-        cout << "Unexpected exception : " << e.what() << endl;
-        return false;
-    }
-    return true;
-}
-
-// Open camera file for writing
-bool OpenFileToWrite(CameraPtr pCam)
-{
-    PrintDebugMessage("Opening file for writing...");
-    try
-    {
-        pCam->FileOperationSelector.SetValue(FileOperationSelector_Open);
-        pCam->FileOpenMode.SetValue(FileOpenMode_Write);
-        pCam->FileOperationExecute.Execute();
-        if (pCam->FileOperationStatus.GetValue() != FileOperationStatus_Success)
-        {
-            cout << "Failed to open file for writing!" << endl;
-            return false;
-        }
-    }
-    catch (Spinnaker::Exception& e)
-    {
-        cout << "Unexpected exception : " << e.what();
-        return false;
-    }
-    return true;
-}
-
-// Execute write operation
-bool ExecuteWriteCommand(CameraPtr pCam)
-{
-    try
-    {
-        pCam->FileOperationSelector.SetValue(FileOperationSelector_Write);
-        pCam->FileOperationExecute.Execute();
-        if (pCam->FileOperationStatus.GetValue() != FileOperationStatus_Success)
-        {
-            cout << "Failed to write to file!" << endl;
-            return false;
-        }
-    }
-    catch (Spinnaker::Exception& e)
-    {
-        cout << "Unexpected exception : " << e.what();
-        return false;
-    }
-    return true;
-}
-
 // Create and save a calibration file from camera memory
 bool CreateCalibrationFile()
 {
@@ -940,6 +1033,8 @@ bool CreateCalibrationFile()
 // Download Calibration file from camera
 bool DownloadCalibrationFile()
 {
+    bool downloaded = true;
+
     try
     {
         SystemPtr system;
@@ -974,122 +1069,42 @@ bool DownloadCalibrationFile()
         // Initialize camera
         pCam->Init();
 
-        // Retrieve GenICam nodemap
-        INodeMap& nodeMap = pCam->GetNodeMap();
-
         cout << endl << "*** DOWNLOADING File ***" << endl;
 
-        // Check file selector support
-        PrintDebugMessage("Fetching \"UserShadingCoeff1\" Entry from FileSelectorNode...");
-        if (pCam->FileSelector == NULL)
-        {
-            cout << "File selector not supported on device!";
-            return false;
-        }
-
-        NodeList_t selectorList;
-        pCam->FileSelector.GetEntries(selectorList);
-        for (unsigned int i = 0; i < selectorList.size(); i++)
+        //
+        // Stream the calibration file to disk
+        //
+        // *** NOTES ***
+        // Each chunk is written to the output file as soon as it is read from
+        // the camera, so the file is never held in memory. A CRC-32 of the
+        // file is computed on the way and printed with the transfer rate.
+        //
         {
-            // Get current enum entry node
-            CEnumEntryPtr node = selectorList.at(i);
-
-            PrintDebugMessage("Setting value to FileSelectorNode...");
-
-            // Check file selector entry support
-            if (!node || !IsReadable(node))
+            ofstream ofs(filename, ios_base::binary | ios_base::trunc);
+            if (!ofs)
             {
-                // Go to next entry node
-                cout << node->GetSymbolic() << " not supported!" << endl;
-                continue;
+                cout << "Unable to create " << filename << "..." << endl;
+                downloaded = false;
             }
-
-            if (node->GetSymbolic().compare(_fileSelector) == 0)
+            else
             {
-                // Set file selector
-                pCam->FileSelector.SetIntValue((int64_t)node->GetNumericValue());
-                int64_t bytesToRead = pCam->FileSize.GetValue();
-                if (bytesToRead == 0)
-                {
-                    cout << "No data available to read!" << endl;
-                    continue;
-                }
-                PrintDebugMessage("Total data to download : " + to_string(static_cast<long long>(bytesToRead)));
-
-                // Open file on camera for reading
-                if (OpenFileToRead(pCam) != true)
-                {
-                    cout << "Failed to open file!" << endl;
-                    continue;
-                }
-                // Attempt to set FileAccessLength to FileAccessBufferNode length to speed up the write
-                if (pCam->FileAccessLength.GetValue() < pCam->FileAccessBuffer.GetLength())
-                {
-                    try
-                    {
-                        pCam->FileAccessLength.SetValue(pCam->FileAccessBuffer.GetLength());
-                    }
-                    catch (Spinnaker::Exception& e)
-                    {
-                        cout << "Unable to set FileAccessLength to FileAccessBuffer length : " << e.what() << endl;
-                    }
-                }
-
-                // Ensure File Access Offset is 0
-                pCam->FileAccessOffset.SetValue(0);
-
-                // Compute number of read operations required
-                int64_t intermediateBufferSize = pCam->FileAccessLength.GetValue();
-                int64_t iterations =
-                    (bytesToRead / intermediateBufferSize) + (bytesToRead % intermediateBufferSize == 0 ? 0 : 1);
-                PrintDebugMessage("Fetching file from camera.");
-                int64_t index = 0;
-                int64_t totalSizeRead = 0;
-                std::unique_ptr<unsigned char> dataBuffer(new unsigned char[static_cast<unsigned int>(bytesToRead)]);
-                uint8_t* pData = dataBuffer.get();
-
-                for (unsigned int i = 0; i < iterations; i++)
-                {
-                    if (!ExecuteReadCommand(pCam))
-                    {
-                        cout << "Reading stream failed!" << endl;
-                        break;
-                    }
-
-                    // Verify size read in bytes
-                    int64_t sizeRead = pCam->FileOperationResult.GetValue();
-
-                    // Read from buffer Node
-                    pCam->FileAccessBuffer.Get(&pData[index], sizeRead);
-
-                    // Update index for next read iteration
-                    index = index + sizeRead;
-
-                    // Keep track of total bytes read
-                    totalSizeRead += sizeRead;
-                    PrintDebugMessage(
-                        "Bytes read: " + to_string(static_cast<long long>(totalSizeRead)) + " of " +
-                        to_string(static_cast<long long>(bytesToRead)));
-                    cout << "Progress : " << (i * 100 / iterations) << " %" << endl;
-                }
-
-                cout << "Reading complete" << endl;
-
-                if (!CloseFile(pCam))
-                {
-                    cout << "Failed to close file!" << endl;
-                }
-                cout << endl;
-
-                // save file
-                ofstream ofs(filename, ios_base::binary | ios_base::trunc);
-
-                ofs.write((char*)&pData[0], totalSizeRead);
-                ofs.close();
-
-                cout << "*** SAVING CALIBRATION FILE ***" << endl;
+                FileTransfer transfer(pCam);
+                FileTransferResult transferResult;
+                downloaded = transfer.DownloadStream(_fileSelector, ofs, transferResult);
+                PrintFileTransferResult(transferResult);
             }
         }
+
+        if (downloaded)
+        {
+            cout << "Reading complete" << endl << endl;
+            cout << "*** SAVING CALIBRATION FILE ***" << endl;
+        }
+        else
+        {
+            remove(filename.c_str());
+        }
+
         //
         // Release reference to the camera
         //
@@ -1112,7 +1127,7 @@ bool DownloadCalibrationFile()
         cout << "Unexpected exception : " << e.what() << endl;
         return false;
     }
-    return true;
+    return downloaded;
 }
 
 // Upload Calibration file to the camera
@@ -1133,15 +1148,9 @@ bool UploadCalibrationFile()
             return false;
         }
 
-        // Read from the file
+        // Open the file; it is streamed to the camera one window at a time rather than read into memory
         std::ifstream ifs(filename, std::ios::binary);
-
-        // Read the data:
-        std::vector<unsigned char> data =
-            std::vector<unsigned char>((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
-
-        // Check if data is valid
-        if (!ifs && !ifs.eof())
+        if (!ifs)
         {
             cerr << "Error Reading from file. Aborting..." << endl;
             return false;
@@ -1165,199 +1174,38 @@ bool UploadCalibrationFile()
         INodeMap& nodeMap = pCam->GetNodeMap();
 
         cout << endl << "*** UPLOADING FILE ***" << endl;
-        PrintDebugMessage("Fetching \"UserShadingCoeff1\" Entry from FileSelectorNode...");
 
-        // Check file selector support
-        if (pCam->FileSelector == NULL)
+        //
+        // Stream the calibration file to the camera and verify it
+        //
+        // *** NOTES ***
+        // The file is read from disk one FileAccessBuffer window at a time
+        // and written to the camera as it is read. The file on the camera is
+        // then read back and its CRC-32 compared with that of the uploaded
+        // bytes, so a calibration that did not arrive intact is caught before
+        // it is activated.
+        //
+        FileTransfer transfer(pCam);
+        FileTransferResult transferResult;
+        if (transfer.UploadStream(_fileSelector, ifs, transferResult))
         {
-            cout << "File selector not supported on device!";
-            return false;
+            transfer.Verify(_fileSelector, transferResult);
         }
+        PrintFileTransferResult(transferResult);
 
-        NodeList_t selectorList;
-        pCam->FileSelector.GetEntries(selectorList);
-        for (unsigned int i = 0; i < selectorList.size(); i++)
+        if (!transferResult.success)
         {
-            // Get current enum entry node
-            CEnumEntryPtr node = selectorList.at(i);
-            PrintDebugMessage("Setting value to FileSelectorNode...");
-
-            // Check file selector entry support
-            if (!node || !IsReadable(node))
-            {
-                // Go to next entry node
-                cout << node->GetSymbolic() << " not supported!" << endl;
-                continue;
-            }
-            if (node->GetSymbolic().compare(_fileSelector) == 0)
-            {
-                cout << "The node: " << node->GetSymbolic() << endl;
-                PrintDebugMessage("Setting value to FileSelectorNode...");
-
-                // Set file selector
-                pCam->FileSelector.SetIntValue((int64_t)node->GetNumericValue());
-
-                // Delete file on camera before writing in case camera runs out of space
-                if (pCam->FileSize.GetValue() > 0)
-                {
-                    if (ExecuteDeleteCommand(pCam) != true)
-                    {
-                        cout << "Failed to delete file!" << endl;
-                        continue;
-                    }
-                }
-
-                // Open file on camera for write
-                if (OpenFileToWrite(pCam) != true)
-                {
-                    cout << "Failed to open file!" << endl;
-
-                    // Error may be caused by improper file closing
-                    // Close and re-open again
-                    if (!CloseFile(pCam))
-                    {
-                        // File failed to close. Abort!
-                        cout << "Problem opening file node." << endl;
-                        return false;
-                    }
-
-                    // File was closed. Open again.
-                    if (!OpenFileToWrite(pCam))
-                    {
-                        // File failed to open again. Abort!
-                        cout << "Problem opening file node." << endl;
-                        return false;
-                    }
-                }
-
-                // Attempt to set FileAccessLength to FileAccessBufferNode length to speed up the write
-                if (pCam->FileAccessLength.GetValue() < pCam->FileAccessBuffer.GetLength())
-                {
-                    try
-                    {
-                        pCam->FileAccessLength.SetValue(pCam->FileAccessBuffer.GetLength());
-                    }
-                    catch (Spinnaker::Exception& e)
-                    {
-                        cout << "Unable to set FileAccessLength to FileAccessBuffer length : " << e.what();
-                    }
-                }
-                // Ensure File Access Offset is 0
-                pCam->FileAccessOffset.SetValue(0);
-
-                // Compute number of write operations required
-                int64_t totalBytesToWrite = data.size();
-                int64_t intermediateBufferSize = pCam->FileAccessLength.GetValue();
-                int64_t writeIterations = (totalBytesToWrite / intermediateBufferSize) +
-                                          (totalBytesToWrite % intermediateBufferSize == 0 ? 0 : 1);
-
-                if (totalBytesToWrite == 0)
-                {
-                    cout << "Empty file. No data will be written to camera." << endl;
-                    return false;
-                }
-
-                PrintDebugMessage("Start saving user set file on camera...");
-                PrintDebugMessage("Total Bytes to write : " + to_string(static_cast<long long>(totalBytesToWrite)));
-                PrintDebugMessage("FileAccessLength : " + to_string(static_cast<long long>(intermediateBufferSize)));
-                PrintDebugMessage("Write Iterations : " + to_string(static_cast<long long>(writeIterations)));
-
-                int64_t index = 0;
-                int64_t bytesLeftToWrite = totalBytesToWrite;
-                int64_t totalBytesWritten = 0;
-                bool paddingRequired = false;
-                int numPaddings = 0;
-
-                cout << "Writing data to device" << endl;
-
-                unsigned char* pFileData = static_cast<unsigned char*>(data.data());
-
-                for (unsigned int i = 0; i < writeIterations; i++)
-                {
-                    // Check whether padding is required
-                    if (intermediateBufferSize > bytesLeftToWrite)
-                    {
-                        // Check for multiple of 4 bytes
-                        unsigned int remainder = bytesLeftToWrite % 4;
-                        if (remainder != 0)
-                        {
-                            paddingRequired = true;
-                            numPaddings = 4 - remainder;
-                        }
-                    }
-
-                    // Setup data to write
-                    int64_t tmpBufferSize = intermediateBufferSize <= bytesLeftToWrite
-                                                ? intermediateBufferSize
-                                                : (bytesLeftToWrite + numPaddings);
-                    std::unique_ptr<unsigned char> tmpBuffer(
-                        new unsigned char[static_cast<unsigned int>(tmpBufferSize)]);
-                    memcpy(
-                        tmpBuffer.get(),
-                        &pFileData[index],
-                        static_cast<size_t>((
-                            (intermediateBufferSize <= bytesLeftToWrite) ? intermediateBufferSize : bytesLeftToWrite)));
-
-                    if (paddingRequired)
-                    {
-                        // Fill padded bytes
-                        for (int j = 0; j < numPaddings; j++)
-                        {
-                            unsigned char* pTmpBuffer = tmpBuffer.get();
-                            pTmpBuffer[bytesLeftToWrite + j] = 255;
-                        }
-                    }
-
-                    // Update index for next write iteration
-                    index = index +
-                            (intermediateBufferSize <= bytesLeftToWrite ? intermediateBufferSize : bytesLeftToWrite);
-
-                    // Write to FileAccessBufferNode
-                    pCam->FileAccessBuffer.Set(tmpBuffer.get(), tmpBufferSize);
-
-                    if (intermediateBufferSize > bytesLeftToWrite)
-                    {
-                        // Update file Access Length Node.
-                        // This is to prevent garbage data outside
-                        // the range from being written to the device.
-                        pCam->FileAccessLength.SetValue(bytesLeftToWrite);
-                    }
+            cout << "Calibration file upload failed; leaving the active coefficient set unchanged..." << endl;
 
-                    // Perform Write command
-                    if (!ExecuteWriteCommand(pCam))
-                    {
-                        cout << "Writing to stream failed!" << endl;
-                        break;
-                    }
-
-                    // Verify size of bytes written
-                    int64_t sizeWritten = pCam->FileOperationResult.GetValue();
-
-                    // Log current file access offset
-                    PrintDebugMessage("File Access Offset: " + to_string(pCam->FileAccessOffset.GetValue()));
-
-                    // Keep track of total bytes written
-                    totalBytesWritten += sizeWritten;
-                    PrintDebugMessage(
-                        "Bytes written: " + to_string(static_cast<long long>(totalBytesWritten)) + " of " +
-                        to_string(static_cast<long long>(totalBytesToWrite)));
-
-                    // Keep track of bytes left to write
-                    bytesLeftToWrite = totalBytesToWrite - totalBytesWritten;
-                    PrintDebugMessage("Bytes left: " + to_string(static_cast<long long>(bytesLeftToWrite)));
-
-                    cout << "Progress : " << (i * 100 / writeIterations) << " %" << endl;
-                }
-
-                cout << "Writing complete" << endl;
-
-                if (!CloseFile(pCam))
-                {
-                    cout << "Failed to close file!" << endl;
-                }
-            }
+            pCam->DeInit();
+            pCam = nullptr;
+            camList.Clear();
+            system->ReleaseInstance();
+            return false;
         }
 
+        cout << "Writing complete" << endl;
+
         // Set calibration mode to off
         CEnumerationPtr ptrLensShadingCorrectionMode = nodeMap.GetNode("LensShadingCorrectionMode");
         if (!IsReadable(ptrLensShadingCorrectionMode) || !IsWritable(ptrLensShadingCorrectionMode))
@@ -1483,6 +1331,16 @@ int main(int argc, char** argv)
         {
             filename = args[i + 1];
         }
+
+        if (args[i] == "-s" || args[i] == "-S")
+        {
+            _shadingCorrectionEngine = HOST_SHADING_CORRECTION;
+        }
+
+        if (args[i] == "-k" || args[i] == "-K")
+        {
+            _captureDarkFrames = true;
+        }
     }
 
     for (size_t i = 1; i < args.size(); ++i)
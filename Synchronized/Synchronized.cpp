@@ -25,8 +25,10 @@
 *
 *  This examples accounts for GPIO layout and other differences between camera 
 *  families, automatically setting the correct settings depending upon the camera
-*  family being used.  The cameras are initially set to factory default settings,
-*  and reset back to factory default settings upon example completion as well.
+*  family being used.  Only the settings that differ from what each camera
+*  holds are written; optionally, the cameras are initially set to factory
+*  default settings, and reset back to factory default settings upon example
+*  completion as well.
 *
 */
 #include "Spinnaker.h"
@@ -35,9 +37,22 @@
 #include <sstream> 
 #include <vector>
 #include <iomanip>
-#include <omp.h>
 #include <direct.h>
 #include <string>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <sys/stat.h>
+#include "FrameStats.h"
+#include "CameraProfile.h"
+#include "BandwidthPlanner.h"
+#include "StreamProfile.h"
+#include "SettingsCache.h"
+#include "BoundedQueue.h"
 
 using namespace Spinnaker;
 using namespace Spinnaker::GenApi;
@@ -47,20 +62,82 @@ using namespace std;
 // Global constants and objects
 const unsigned int k_numImages = 10;
 const unsigned int k_grabTimeout = 800;
-const unsigned int k_packetSize = 9000;
+
+// Largest packet the network interfaces accept, and the fraction of each GigE
+// link that is shared out between the cameras on it; 9000 requires jumbo frames
+const int64_t k_maxPacketSize = 9000;
+const double k_linkHeadroom = 0.9;
+
+// Stream all GigE cameras for a while after planning and report resends and incomplete images
+const bool ProbeBandwidth = true;
+const double k_bandwidthProbeSeconds = 3.0;
 
 const double k_exposureTime = 50000.0; // Units in micro seconds; should not exceed 1,000,000/k_frameRate.
 const double k_gain = 3.0;
 const double k_frameRate = 10.0;
 const char* k_pixelFormat = "Mono8";
 
-const gcstring cameraFamilyFFY = "FFY";
-const gcstring cameraFamilyBFS = "BFS";
-const gcstring cameraFamilyORX = "ORX";
-const gcstring cameraFamilyBFLY = "BFLY";
-const gcstring cameraFamilyCM3 = "CM3";
-const gcstring cameraFamilyGS3 = "GS3";
-const gcstring cameraFamilyFL3 = "FL3";
+
+// Use the following enum and global constant to select whether images are
+// grabbed round-robin from the main thread, or by a dedicated grab thread per
+// camera feeding a bounded per-camera queue.
+enum acquisitionType
+{
+    ROUND_ROBIN,
+    THREAD_PER_CAMERA
+};
+
+const acquisitionType chosenAcquisition = THREAD_PER_CAMERA;
+
+// Number of grabbed images each camera may hold in its queue before its grab
+// thread waits on the processing thread. Keep this below the stream buffer
+// count so the camera always has free buffers to fill.
+const unsigned int k_queueDepth = 4;
+
+// Number of preallocated Mono8 images per camera that converted frames are
+// held in until the writer has saved them.
+const unsigned int k_poolDepth = 8;
+
+// Number of writer threads shared by all cameras, and the file format they
+// save images in (JPEG, PNG or RAW).
+const unsigned int k_numWriterThreads = 4;
+const ImageFileFormat k_saveFormat = JPEG;
+
+// Per-frame stage timings of every camera are printed at the end of
+// acquisition and written to this CSV file every k_frameStatsInterval seconds
+// (empty to disable)
+const char* const k_frameStatsCsv = "Synchronized-stats.csv";
+const double k_frameStatsInterval = 5.0;
+
+// Use the following global constant to select the stream buffer profile of
+// every camera. STREAM_PROFILE_NO_DROP (OldestFirst, buffers sized for
+// consumer stalls) keeps every frame for recording, while
+// STREAM_PROFILE_LOW_LATENCY (NewestOnly, few buffers) always hands over the
+// most recent frame.
+const streamProfileType chosenStreamProfile = STREAM_PROFILE_NO_DROP;
+
+// Use the following enum and global constant to select how the camera
+// settings are applied. SETTINGS_FACTORY_RESET restores the factory defaults
+// before and after the example, SETTINGS_DIFF writes only the settings that
+// differ from what the camera holds, and SETTINGS_DIFF_SNAPSHOT additionally
+// skips reading the camera when its timestamp has not gone backwards since the
+// last run. The snapshot cannot tell when a camera with a monotonic or PTP
+// disciplined time base was power cycled, or when another tool loaded a user
+// set, so only select it for a rig this example alone configures.
+enum settingsApplyType
+{
+    SETTINGS_FACTORY_RESET,
+    SETTINGS_DIFF,
+    SETTINGS_DIFF_SNAPSHOT
+};
+
+const settingsApplyType chosenSettingsApply = SETTINGS_DIFF;
+
+// Snapshots are saved as <prefix><serial number>.txt
+const char* const k_settingsSnapshotPrefix = "Synchronized-settings-";
+
+// Serializes console output from the grab and processing threads
+mutex printMutex;
 
 int PrintBuildInfo(SystemPtr system)
 {
@@ -133,190 +210,33 @@ bool SetVideoMode(INodeMap & nodeMap)
     return true;
 }
 
-bool SetPacketSize(INodeMap & nodeMap)
-{
-    CIntegerPtr ptrPacketSize = nodeMap.GetNode("GevSCPSPacketSize");
-    if (!IsAvailable(ptrPacketSize) || !IsWritable(ptrPacketSize))
-    {
-        cout << "[GEV SCPS Packet Size] node not available!!" << endl;
-        return false;
-    }
-
-    ptrPacketSize->SetValue(k_packetSize);
-    cout << "Packet Size: " << ptrPacketSize->GetValue() << endl;
-
-    return true;
-}
-
-bool EnableV3_3(INodeMap & nodeMap, gcstring cameraModel)
+// Acquisition mode, exposure time and framerate of every camera
+void AddCameraSettings(SettingsProfile & settings, const CameraProfile & profile)
 {
-    // Set Line Selector to Line2 before enable 3.3V output, this step is necessary for BFS
-    if (cameraModel.find(cameraFamilyBFS) != std::string::npos)
-    {
-        CEnumerationPtr ptrLineSelector = nodeMap.GetNode("LineSelector");
-        if (!IsAvailable(ptrLineSelector) || !IsWritable(ptrLineSelector))
-        {
-            cout << "[Line Selector] node not available!!" << endl;
-            return false;
-        }
-
-        CEnumEntryPtr ptrLineSelectorLine2 = ptrLineSelector->GetEntryByName("Line2");
-        if (!IsAvailable(ptrLineSelectorLine2) || !IsReadable(ptrLineSelectorLine2))
-        {
-            cout << "Unable to set [Line Selector] to [Line2]. Aborting..." << endl;
-        }
-        else
-        {
-            ptrLineSelector->SetIntValue(ptrLineSelectorLine2->GetValue());
-            cout << "Line Selector: " << ptrLineSelector->GetCurrentEntry()->GetSymbolic() << endl;
-        }
-    }
+    settings.SetEnum("AcquisitionMode", "Continuous");
+    settings.SetEnum("ExposureAuto", "Off");
+    settings.SetFloat("ExposureTime", k_exposureTime);
 
-    // Enable 3.3V output
-    CBooleanPtr ptrV3_3Enable = nodeMap.GetNode("V3_3Enable");
-    if (!IsAvailable(ptrV3_3Enable) || !IsWritable(ptrV3_3Enable))
+    // Acquisition Frame Rate Enabled (with a "d" at the end) is used for Gen2 cameras,
+    // which also need Frame Rate Auto turned off
+    if (profile.IsGen2())
     {
-        cout << "[3.3V Enable] node not available!!" << endl;
-        return false;
+        settings.SetBool("AcquisitionFrameRateEnabled", true);
+        settings.SetEnum("AcquisitionFrameRateAuto", "Off");
     }
-
-    ptrV3_3Enable->SetValue(true);
-    cout << "3.3V Enable: " << ptrV3_3Enable->GetValue() << endl;
-
-    return true;
-}
-
-// Set acquisition mode, exposure time and framerate
-int ConfigureCameraSettings(INodeMap & nodeMap, gcstring cameraModel)
-{
-    int result = 0;
-
-    try
-    {
-        // Set Acquisition Mode to Continuous
-        CEnumerationPtr ptrAcquisitionMode = nodeMap.GetNode("AcquisitionMode");
-        if (!IsAvailable(ptrAcquisitionMode) || !IsWritable(ptrAcquisitionMode))
-        {
-            cout << "[Acquisition Mode] node not available!!" << endl;
-            return -1;
-        }
-
-        CEnumEntryPtr ptrAcquisitionModeContinuous = ptrAcquisitionMode->GetEntryByName("Continuous");
-        if (!IsAvailable(ptrAcquisitionModeContinuous) || !IsReadable(ptrAcquisitionModeContinuous))
-        {
-            cout << "Unable to set [Acquisition Mode] to [Continuous]. Aborting..." << endl;
-            return -1;
-        }
-
-        ptrAcquisitionMode->SetIntValue(ptrAcquisitionModeContinuous->GetValue());
-        cout << "Acquisition Mode: " << ptrAcquisitionMode->GetCurrentEntry()->GetSymbolic() << endl;
-
-        // Turn off Exposure Auto
-        CEnumerationPtr ptrExposureAuto = nodeMap.GetNode("ExposureAuto");
-        if (!IsAvailable(ptrExposureAuto) || !IsWritable(ptrExposureAuto))
-        {
-            cout << "[Exposure Auto] node not available!!" << endl;
-            return -1;
-        }
-
-        CEnumEntryPtr ptrExposureAutoOff = ptrExposureAuto->GetEntryByName("Off");
-        if (!IsAvailable(ptrExposureAutoOff) || !IsReadable(ptrExposureAutoOff))
-        {
-            cout << "Unable to set [Exposure Auto] to [Off]. Aborting..." << endl;
-            return -1;
-        }
-
-        ptrExposureAuto->SetIntValue(ptrExposureAutoOff->GetValue());
-        cout << "Exposure Auto: " << ptrExposureAuto->GetCurrentEntry()->GetSymbolic() << endl;
-
-        // Set Exposure Time
-        CFloatPtr ptrExposureTime = nodeMap.GetNode("ExposureTime");
-        if (!IsAvailable(ptrExposureTime) || !IsWritable(ptrExposureTime))
-        {
-            cout << "[Exposure Time] node not available!!" << endl;
-            return -1;
-        }
-
-        ptrExposureTime->SetValue(k_exposureTime);
-
-        cout << "Exposure Time:                 " << ptrExposureTime->GetValue() << " us" << endl;
-
-        // Turn on Acquisition Frame Rate Enable
-        CBooleanPtr ptrFrameRateEnable = nodeMap.GetNode("AcquisitionFrameRateEnable");
-        if (ptrFrameRateEnable == NULL)
-        {
-            // Acquisition Frame Rate Enabled (with a "d" at the end) is used for Gen2 cameras
-            ptrFrameRateEnable = nodeMap.GetNode("AcquisitionFrameRateEnabled");
-        }
-
-        if (IsAvailable(ptrFrameRateEnable) && IsWritable(ptrFrameRateEnable))
-        {
-            ptrFrameRateEnable->SetValue(true);
-            cout << "Acquisition Frame Rate Enable: " << ptrFrameRateEnable->GetValue() << endl;
-        }
-        else
-        {
-            cout << "[Acquisition Frame Rate Enable] node not available!!" << endl;
-            return false;
-        }
-
-        // Turn off Frame Rate Auto, this step is only necessary for Gen2 cameras
-        if (cameraModel.find(cameraFamilyBFLY) != std::string::npos || cameraModel.find(cameraFamilyCM3) != std::string::npos ||
-            cameraModel.find(cameraFamilyFL3) != std::string::npos || cameraModel.find(cameraFamilyGS3) != std::string::npos)
-        {
-            CEnumerationPtr ptrFrameRateAuto = nodeMap.GetNode("AcquisitionFrameRateAuto");
-            if (!IsAvailable(ptrFrameRateAuto) || !IsWritable(ptrFrameRateAuto))
-            {
-                cout << "[Frame Rate Auto] node not available!!" << endl;
-                return false;
-            }
-
-            CEnumEntryPtr ptrFrameRateAutoOff = ptrFrameRateAuto->GetEntryByName("Off");
-            if (!IsAvailable(ptrFrameRateAutoOff) || !IsReadable(ptrFrameRateAutoOff))
-            {
-                cout << "Unable to set [Frame Rate Auto] to [Off]. Aborting..." << endl;
-                return false;
-            }
-
-            ptrFrameRateAuto->SetIntValue(ptrFrameRateAutoOff->GetValue());
-            cout << "Frame Rate Auto: " << ptrFrameRateAuto->GetCurrentEntry()->GetSymbolic() << endl;
-        }
-
-        // Set Acquisition Frame Rate
-        CFloatPtr ptrAcquisitionFrameRate = nodeMap.GetNode("AcquisitionFrameRate");
-        if (!IsAvailable(ptrAcquisitionFrameRate) || !IsWritable(ptrAcquisitionFrameRate))
-        {
-            cout << "[Acquisition Frame Rate] node not available!!" << endl;
-            return -1;
-        }
-
-        const double frameRateMax = ptrAcquisitionFrameRate->GetMax();
-        double frameRateToSet = k_frameRate;
-
-        if (frameRateToSet > frameRateMax)
-        {
-            cout << "Error setting framerate (user value exceeds camera's current max framerate); setting framerate to camera's current max framerate" << endl;
-            frameRateToSet = frameRateMax;
-        }
-
-        ptrAcquisitionFrameRate->SetValue(frameRateToSet);
-        cout << "Frame Rate: " << ptrAcquisitionFrameRate->GetValue() << " Hz" << endl;
-
-    }
-    catch (Spinnaker::Exception &e)
+    else
     {
-        cout << "Error: " << e.what() << endl;
-        result = -1;
+        settings.SetBool("AcquisitionFrameRateEnable", true);
     }
 
-    return result;
+    // The frame rate is limited to the camera's current max framerate
+    settings.SetFloat("AcquisitionFrameRate", k_frameRate, true, true);
 }
 
-// Configure Timestamp and Frame ID Chunk Data
-int ConfigureChunkData(INodeMap & nodeMap)
+// Configure Timestamp and Frame ID Chunk Data through the settings cache of the camera
+int ConfigureChunkData(INodeMap & nodeMap, SettingsCache & cache)
 {
     int result = 0;
-    CameraPtr pCam = nullptr;
 
     cout << endl << endl << "*** CONFIGURING CHUNK DATA ***" << endl << endl;
 
@@ -328,74 +248,38 @@ int ConfigureChunkData(INodeMap & nodeMap)
         // *** NOTES ***
         // Once enabled, chunk data will be available at the end of the payload
         // of every image captured until it is disabled. Chunk data can also be 
-        // retrieved from the nodemap.
+        // retrieved from the nodemap. Chunk mode is activated before the chunks
+        // are selected, and only the nodes that differ are written.
         //
 
-        CBooleanPtr ptrChunkModeActive = nodeMap.GetNode("ChunkModeActive");
-        if (!IsAvailable(ptrChunkModeActive) || !IsWritable(ptrChunkModeActive))
-        {
-            cout << "Unable to activate chunk mode. Aborting..." << endl << endl;
-            return -1;
-        }
-
-        ptrChunkModeActive->SetValue(true);
-
-        cout << "Chunk mode activated..." << endl;
-
         CEnumerationPtr ptrChunkSelector = nodeMap.GetNode("ChunkSelector");
-        if (!IsAvailable(ptrChunkSelector) || !IsWritable(ptrChunkSelector))
+        if (!IsAvailable(ptrChunkSelector) || !IsReadable(ptrChunkSelector))
         {
-            cout << "Chunk Selector is not writable" << endl;
+            cout << "Chunk Selector is not available. Aborting..." << endl;
             return -1;
         }
 
-        // Enable Timestamp Chunk Data
-        CEnumEntryPtr ptrChunkSelectorTimestamp = ptrChunkSelector->GetEntryByName("Timestamp");
-        if (!IsAvailable(ptrChunkSelectorTimestamp) || !IsReadable(ptrChunkSelectorTimestamp))
-        {
-            cout << "Unable to set Chunk Selector (node retrieval). Aborting..." << endl;
-            return -1;
-        }
-
-        ptrChunkSelector->SetIntValue(ptrChunkSelectorTimestamp->GetValue());
+        // Frame Counter is used for Gen2 cameras
+        const char* frameIDChunk = ptrChunkSelector->GetEntryByName("FrameID") != NULL ? "FrameID" : "FrameCounter";
 
-        // Retrieve corresponding boolean
-        CBooleanPtr ptrChunkEnable = nodeMap.GetNode("ChunkEnable");
+        SettingsProfile settings;
+        settings.SetBool("ChunkModeActive", true);
+        settings.Select("ChunkSelector", "Timestamp");
+        settings.SetBool("ChunkEnable", true);
+        settings.Select("ChunkSelector", frameIDChunk);
+        settings.SetBool("ChunkEnable", true);
 
-        // Enable the boolean, thus enabling the corresponding chunk data
-        if (IsWritable(ptrChunkEnable))
+        SettingsApplyResult settingsResult;
+        if (cache.Apply(settings, settingsResult))
         {
-            ptrChunkEnable->SetValue(true);
             cout << "Chunk data enabled" << endl;
         }
         else
         {
-            cout << "Chunk data node not writable" << endl;
+            cout << "Unable to enable chunk data" << endl;
             result = -1;
         }
-
-        // Enable Frame ID Chunk Data
-        CEnumEntryPtr ptrChunkSelectorFrameID = ptrChunkSelector->GetEntryByName("FrameID");
-        if (ptrChunkSelectorFrameID == NULL)
-        {
-            // Frame Counter is used for Gen2 cameras
-            ptrChunkSelectorFrameID = ptrChunkSelector->GetEntryByName("FrameCounter");
-        }
-
-        ptrChunkSelector->SetIntValue(ptrChunkSelectorFrameID->GetValue());
-
-        // Enable the boolean, thus enabling the corresponding chunk data
-        if (IsWritable(ptrChunkEnable))
-        {
-            ptrChunkEnable->SetValue(true);
-            cout << "Chunk data enabled" << endl;
-        }
-        else
-        {
-            cout << "Chunk data node not writable" << endl;
-            result = -1;
-        }
-
+        PrintSettingsResult(settingsResult);
     }
     catch (Spinnaker::Exception &e)
     {
@@ -405,190 +289,52 @@ int ConfigureChunkData(INodeMap & nodeMap)
     return result;
 }
 
-// Configure Primary camera Digital Output Control settings
-int SetupPrimaryCam(INodeMap & nodeMap, gcstring cameraModel)
+// Primary camera Digital Output Control settings
+void AddPrimarySettings(SettingsProfile & settings, const CameraProfile & profile)
 {
-    int result = 0;
+    // The primary camera runs freely, also when it was a secondary camera last time
+    settings.SetEnum("TriggerMode", "Off");
 
-    try
+    // Enable 3.3V output for BFLY or BFS cameras; BFS cameras need Line Selector set to Line2 first
+    if (profile.family == FAMILY_BFS)
     {
-        // Enable 3.3V output for BFLY or BFS cameras
-        if (cameraModel.find(cameraFamilyBFLY) != std::string::npos || cameraModel.find(cameraFamilyBFS) != std::string::npos)
-        {
-            EnableV3_3(nodeMap, cameraModel);
-        }
-
-        // Set Line Selector to appropriate line (only necessary for non-BFS/BFLy cameras)
-        CEnumerationPtr ptrLineSelector = nodeMap.GetNode("LineSelector");
-        if (!IsAvailable(ptrLineSelector) || !IsWritable(ptrLineSelector))
-        {
-            cout << "[Line Selector] node not available!!" << endl;
-            return -1;
-        }
-
-        if (cameraModel.find(cameraFamilyCM3) != std::string::npos || cameraModel.find(cameraFamilyFL3) != std::string::npos ||
-            cameraModel.find(cameraFamilyGS3) != std::string::npos || cameraModel.find(cameraFamilyORX) != std::string::npos ||
-            cameraModel.find(cameraFamilyFFY) != std::string::npos)
-        {
-            CEnumEntryPtr ptrLineSelectorLine2 = ptrLineSelector->GetEntryByName("Line2");
-
-            if (!IsAvailable(ptrLineSelectorLine2) || !IsReadable(ptrLineSelectorLine2))
-            {
-                cout << "Unable to set [Line Selector] to [Line2]. Aborting..." << endl;
-                return -1;
-            }
-            ptrLineSelector->SetIntValue(ptrLineSelectorLine2->GetValue());
-            cout << "Line Selector:                 " << ptrLineSelector->GetCurrentEntry()->GetSymbolic() << endl;
-        }
-
-        // Set Line Mode to Output
-        CEnumerationPtr ptrLineMode = nodeMap.GetNode("LineMode");
-        if (!IsAvailable(ptrLineMode) || !IsWritable(ptrLineMode))
-        {
-            cout << "[Line Mode] node not available!!" << endl;
-            return -1;
-        }
-
-        CEnumEntryPtr ptrLineModeOutput = ptrLineMode->GetEntryByName("Output");
-        if (!IsAvailable(ptrLineModeOutput) || !IsReadable(ptrLineModeOutput))
-        {
-            cout << "Unable to set [Line Source] to [ExposureActive]. Aborting..." << endl;
-            return -1;
-        }
-
-        ptrLineMode->SetIntValue(ptrLineModeOutput->GetValue());
-
-        // Set Line Source to ExposureActive
-        CEnumerationPtr ptrLineSource = nodeMap.GetNode("LineSource");
-        if (!IsAvailable(ptrLineSource) || !IsWritable(ptrLineSource))
-        {
-            cout << "[Line Source] node not available!!" << endl;
-            return -1;
-        }
-
-        CEnumEntryPtr ptrLineSourceExposureActive = ptrLineSource->GetEntryByName("ExposureActive");
-        if (!IsAvailable(ptrLineSourceExposureActive) || !IsReadable(ptrLineSourceExposureActive))
-        {
-            cout << "Unable to set [Line Source] to [ExposureActive]. Aborting..." << endl;
-            return -1;
-        }
-
-        ptrLineSource->SetIntValue(ptrLineSourceExposureActive->GetValue());
-        cout << "Line Source:                   " << ptrLineSource->GetCurrentEntry()->GetSymbolic() << endl;
-
+        settings.Select("LineSelector", "Line2");
     }
-    catch (Spinnaker::Exception &e)
+    if (profile.family == FAMILY_BFLY || profile.family == FAMILY_BFS)
     {
-        cout << "Error: " << e.what() << endl;
-        result = -1;
+        settings.SetBool("V3_3Enable", true, false);
     }
 
-    return result;
+    // Set Line Selector to appropriate line (only necessary for non-BFS/BFLy cameras)
+    if (profile.family == FAMILY_CM3 || profile.family == FAMILY_FL3 || profile.family == FAMILY_GS3 ||
+        profile.family == FAMILY_ORX || profile.family == FAMILY_FFY)
+    {
+        settings.Select("LineSelector", "Line2");
+    }
+
+    settings.SetEnum("LineMode", "Output");
+    settings.SetEnum("LineSource", "ExposureActive");
 }
 
-int SetupSecondaryCam(INodeMap & nodeMap, gcstring cameraModel)
+// Secondary cameras are triggered by the exposure signal of the primary camera
+void AddSecondarySettings(SettingsProfile & settings, const CameraProfile & profile)
 {
-    int result = 0;
+    settings.SetEnum("TriggerMode", "On");
 
-    try
+    if (profile.family == FAMILY_BFS || profile.family == FAMILY_CM3 || profile.family == FAMILY_FL3 ||
+        profile.family == FAMILY_GS3 || profile.family == FAMILY_FFY)
     {
-
-        // Set Trigger Mode to On
-        CEnumerationPtr ptrTriggerMode = nodeMap.GetNode("TriggerMode");
-        if (!IsAvailable(ptrTriggerMode) || !IsWritable(ptrTriggerMode))
-        {
-            cout << "[Trigger Mode] node not available!!" << endl;
-            return -1;
-        }
-
-        CEnumEntryPtr ptrTriggerModeOn = ptrTriggerMode->GetEntryByName("On");
-        if (!IsAvailable(ptrTriggerModeOn) || !IsReadable(ptrTriggerModeOn))
-        {
-            cout << "Unable to set [Trigger Mode] to [On]. Aborting..." << endl;
-            return -1;
-        }
-
-        ptrTriggerMode->SetIntValue(ptrTriggerModeOn->GetValue());
-        cout << "Trigger Mode:                  " << ptrTriggerMode->GetCurrentEntry()->GetSymbolic() << endl;
-
-        // Set Trigger Source to Line3
-        CEnumerationPtr ptrTriggerSource = nodeMap.GetNode("TriggerSource");
-        if (!IsAvailable(ptrTriggerSource) || !IsWritable(ptrTriggerSource))
-        {
-            cout << "[Trigger Source] node not available!!" << endl;
-            return -1;
-        }
-
-        if (cameraModel.find(cameraFamilyBFS) != std::string::npos || cameraModel.find(cameraFamilyCM3) != std::string::npos ||
-            cameraModel.find(cameraFamilyFL3) != std::string::npos || cameraModel.find(cameraFamilyGS3) != std::string::npos ||
-            cameraModel.find(cameraFamilyFFY) != std::string::npos)
-        {
-            CEnumEntryPtr ptrTriggerSourceLine3 = ptrTriggerSource->GetEntryByName("Line3");
-            if (!IsAvailable(ptrTriggerSourceLine3) || !IsReadable(ptrTriggerSourceLine3))
-            {
-                cout << "Unable to set [Trigger Source] to [Line3]. Aborting..." << endl;
-                return -1;
-            }
-
-            ptrTriggerSource->SetIntValue(ptrTriggerSourceLine3->GetValue());
-            cout << "Trigger Source:                " << ptrTriggerSource->GetCurrentEntry()->GetSymbolic() << endl;
-        }
-        else if (cameraModel.find(cameraFamilyORX) != std::string::npos)
-        {
-            CEnumEntryPtr ptrTriggerSourceLine5 = ptrTriggerSource->GetEntryByName("Line5");
-            if (!IsAvailable(ptrTriggerSourceLine5) || !IsReadable(ptrTriggerSourceLine5))
-            {
-                cout << "Unable to set [Trigger Source] to [Line5]. Aborting..." << endl;
-                return -1;
-            }
-
-            ptrTriggerSource->SetIntValue(ptrTriggerSourceLine5->GetValue());
-            cout << "Trigger Source:                " << ptrTriggerSource->GetCurrentEntry()->GetSymbolic() << endl;
-        }
-
-        // Set Trigger Activation to Rising Edge
-        CEnumerationPtr ptrTriggerActivation = nodeMap.GetNode("TriggerActivation");
-        if (!IsAvailable(ptrTriggerActivation) || !IsWritable(ptrTriggerActivation))
-        {
-            cout << "[Trigger Activation] node not available!!" << endl;
-            return -1;
-        }
-
-        CEnumEntryPtr ptrTriggerActivationRisingEdge = ptrTriggerActivation->GetEntryByName("RisingEdge");
-        if (!IsAvailable(ptrTriggerActivationRisingEdge) || !IsReadable(ptrTriggerActivationRisingEdge))
-        {
-            cout << "Unable to set [Trigger Activation] to [RisingEdge]. Aborting..." << endl;
-            return -1;
-        }
-
-        ptrTriggerActivation->SetIntValue(ptrTriggerActivationRisingEdge->GetValue());
-        cout << "Trigger Activation:            " << ptrTriggerActivation->GetCurrentEntry()->GetSymbolic() << endl;
-
-        // Set Trigger Overlap to Read Out
-        CEnumerationPtr ptrTriggerOverlap = nodeMap.GetNode("TriggerOverlap");
-        if (!IsAvailable(ptrTriggerOverlap) || !IsWritable(ptrTriggerOverlap))
-        {
-            cout << "[Trigger Overlap] node not available" << endl;
-            return result;
-        }
-
-        CEnumEntryPtr ptrTriggerOverlapReadOut = ptrTriggerOverlap->GetEntryByName("ReadOut");
-        if (!IsAvailable(ptrTriggerOverlapReadOut) || !IsReadable(ptrTriggerOverlapReadOut))
-        {
-            cout << "Unable to set [Trigger Overlap] to [ReadOut]." << endl;
-        }
-
-        ptrTriggerOverlap->SetIntValue(ptrTriggerOverlapReadOut->GetValue());
-        cout << "Trigger Overlap:               " << ptrTriggerOverlap->GetCurrentEntry()->GetSymbolic() << endl;
-
+        settings.SetEnum("TriggerSource", "Line3");
     }
-    catch (Spinnaker::Exception &e)
+    else if (profile.family == FAMILY_ORX)
     {
-        cout << "Error: " << e.what() << endl;
-        result = -1;
+        settings.SetEnum("TriggerSource", "Line5");
     }
 
-    return result;
+    settings.SetEnum("TriggerActivation", "RisingEdge");
+
+    // Not every camera has Trigger Overlap
+    settings.SetEnum("TriggerOverlap", "ReadOut", false);
 }
 
 bool RestoreFactoryDefault(INodeMap & nodeMap)
@@ -681,8 +427,460 @@ int DisableHeartbeat(CameraPtr pCam, INodeMap & nodeMap, INodeMap & nodeMapTLDev
 }
 #endif
 
+// Fixed set of preallocated Mono8 images that converted frames are written
+// into. Slots are recycled by the writer once saved, so the memory held by a
+// camera stays at width x height x k_poolDepth no matter how long the capture
+// runs, and a full pool simply holds back that camera's processing thread.
+class ImagePool
+{
+public:
+
+    ImagePool(size_t width, size_t height, size_t depth)
+        : m_buffer(width * height * depth), m_freeSlots(depth)
+    {
+        for (size_t slot = 0; slot < depth; slot++)
+        {
+            m_images.push_back(Image::Create(width, height, 0, 0, PixelFormat_Mono8, &m_buffer[slot * width * height]));
+            m_freeSlots.Push(static_cast<unsigned int>(slot));
+        }
+    };
+    ~ImagePool() {};
+
+    // Blocks until a slot is free
+    unsigned int Acquire()
+    {
+        unsigned int slot = 0;
+        m_freeSlots.Pop(slot);
+        return slot;
+    }
+
+    void Recycle(unsigned int slot)
+    {
+        m_freeSlots.Push(slot);
+    }
+
+    ImagePtr GetImage(unsigned int slot) const
+    {
+        return m_images[slot];
+    }
+
+    size_t GetSizeInBytes() const
+    {
+        return m_buffer.size();
+    }
+
+private:
+
+    vector<unsigned char> m_buffer;
+    vector<ImagePtr> m_images;
+    BoundedQueue<unsigned int> m_freeSlots;
+};
+
+// A grabbed image and the chunk data Frame ID it was captured with
+struct GrabbedFrame
+{
+    ImagePtr pImage;
+    int64_t frameID;
+};
+
+// Per-camera state shared by the grab and processing threads of one camera,
+// and by the writer threads saving its images
+struct CameraStream
+{
+    CameraStream(CameraPtr cam, unsigned int camIndex, gcstring camSerial, string dir, size_t width, size_t height, FrameStats & stats)
+        : pCam(cam), index(camIndex), serialNumber(camSerial), outputDir(dir), grabbed(k_queueDepth),
+        pool(width, height, k_poolDepth), timestampPrevious(0), frameIDPrevious(0),
+        numGrabbed(0), numIncomplete(0), numSkipped(0), numSaved(0), bytesWritten(0), result(0), hasSaveSpan(false),
+        grabRecorder(stats.CreateRecorder()), processRecorder(stats.CreateRecorder()) {};
+
+    CameraPtr pCam;
+    unsigned int index;
+    gcstring serialNumber;
+    string outputDir;
+    BoundedQueue<GrabbedFrame> grabbed;
+    ImagePool pool;
+    int64_t timestampPrevious;
+    int64_t frameIDPrevious;
+    unsigned int numGrabbed;
+    unsigned int numIncomplete;
+    unsigned int numSkipped;
+
+    // Stream counters when acquisition began, so that only this run's drops are reported
+    StreamCounters streamCountersAtStart;
+
+    // Updated concurrently by the writer threads
+    atomic<unsigned int> numSaved;
+    atomic<uint64_t> bytesWritten;
+    atomic<int> result;
+
+    // Wall-clock span from the start of the first save to the end of the last;
+    // the writer threads save in parallel, so their save times cannot be summed
+    mutex saveSpanMutex;
+    bool hasSaveSpan;
+    chrono::steady_clock::time_point firstSaveStart;
+    chrono::steady_clock::time_point lastSaveEnd;
+
+    // Stage timings; each is only written by the thread that grabs or
+    // processes this camera's images
+    FrameRecorder & grabRecorder;
+    FrameRecorder & processRecorder;
+};
+
+// A converted image waiting in its camera's pool to be written to disk; the
+// camera serial number and Frame ID form the output filename.
+struct WriteJob
+{
+    CameraStream* pStream;
+    unsigned int slot;
+    int64_t frameID;
+};
+
+// Returns the filename extension matching a save format
+string GetFileExtension(ImageFileFormat format)
+{
+    switch (format)
+    {
+    case PNG:
+        return ".png";
+    case RAW:
+        return ".raw";
+    case JPEG:
+    default:
+        return ".jpg";
+    }
+}
+
+//
+// Fixed-size pool of writer threads shared by all cameras
+//
+// *** NOTES ***
+// Jobs from every camera go through a single queue, so the writers stay busy
+// even when the cameras deliver images unevenly. Each job returns its slot to
+// the owning camera's pool once the image is on disk.
+//
+class WriterPool
+{
+public:
+
+    WriterPool(unsigned int numThreads, size_t capacity, FrameStats & stats) : m_jobs(capacity), m_stats(stats)
+    {
+        for (unsigned int i = 0; i < numThreads; i++)
+        {
+            m_threads.push_back(thread(&WriterPool::Run, this));
+        }
+    };
+    // Joins the writer threads on paths that return before Finish is called
+    ~WriterPool()
+    {
+        Finish();
+    };
+
+    void Submit(const WriteJob & job)
+    {
+        m_jobs.Push(job);
+    }
+
+    // Writes every job still queued, then stops the writer threads
+    void Finish()
+    {
+        m_jobs.Close();
+        for (unsigned int i = 0; i < m_threads.size(); i++)
+        {
+            m_threads[i].join();
+        }
+        m_threads.clear();
+    }
+
+private:
+
+    void Run()
+    {
+        WriteJob job;
+
+        // Save timings of every camera this writer serves
+        FrameRecorder & frameRecorder = m_stats.CreateRecorder();
+
+        while (m_jobs.Pop(job))
+        {
+            CameraStream & stream = *job.pStream;
+
+            try
+            {
+                // Create a unique filename
+                ostringstream filename;
+                filename << stream.outputDir << "\\" << stream.serialNumber << "-" << job.frameID << GetFileExtension(k_saveFormat);
+
+                // Save the image
+                const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                stream.pool.GetImage(job.slot)->Save(filename.str().c_str(), k_saveFormat);
+                const chrono::steady_clock::time_point end = chrono::steady_clock::now();
+                const int64_t saveTimeNs = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+                {
+                    lock_guard<mutex> lock(stream.saveSpanMutex);
+                    if (!stream.hasSaveSpan || start < stream.firstSaveStart)
+                    {
+                        stream.firstSaveStart = start;
+                    }
+                    if (!stream.hasSaveSpan || end > stream.lastSaveEnd)
+                    {
+                        stream.lastSaveEnd = end;
+                    }
+                    stream.hasSaveSpan = true;
+                }
+                frameRecorder.Record(STAGE_SAVE, static_cast<uint64_t>(saveTimeNs));
+
+                struct stat fileInfo;
+                if (stat(filename.str().c_str(), &fileInfo) == 0)
+                {
+                    stream.bytesWritten += static_cast<uint64_t>(fileInfo.st_size);
+                }
+                stream.numSaved++;
+
+                lock_guard<mutex> lock(printMutex);
+                cout << "Saved frame " << job.frameID << " from camera " << stream.index << endl;
+            }
+            catch (Spinnaker::Exception &e)
+            {
+                {
+                    lock_guard<mutex> lock(printMutex);
+                    cout << "Error: " << e.what() << endl;
+                }
+                stream.result = -1;
+            }
+
+            stream.pool.Recycle(job.slot);
+        }
+    }
+
+    BoundedQueue<WriteJob> m_jobs;
+    vector<thread> m_threads;
+    FrameStats & m_stats;
+};
+
+// Checks a freshly grabbed image for completion and skipped frames using its
+// chunk data Frame ID and timestamp, then hands it to the processing thread.
+void HandleGrabbedImage(CameraStream & stream, ImagePtr pResultImage)
+{
+    stream.grabRecorder.RecordFrame(pResultImage);
+
+    if (pResultImage->IsIncomplete())
+    {
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Camera " << stream.index << " image incomplete with image status " << pResultImage->GetImageStatus() << "..." << endl << endl;
+        }
+        stream.numIncomplete++;
+
+        // Release image
+        pResultImage->Release();
+        return;
+    }
+
+    ChunkData chunkData = pResultImage->GetChunkData();
+
+    // Retrieve timestamp and Frame ID
+    const int64_t timestampCurrent = chunkData.GetTimestamp();
+    const int64_t frameIDCurrent = chunkData.GetFrameID();
+
+    {
+        lock_guard<mutex> lock(printMutex);
+        cout << "Grabbing Frame ID " << frameIDCurrent << " from camera " << stream.index << " - TimeStamp [" << timestampCurrent << "]" << endl;
+
+        if (stream.numGrabbed > 0)
+        {
+            cout << "Time between consecutive images: " << (timestampCurrent - stream.timestampPrevious) / 1000 << " microseconds" << endl << endl;
+
+            if ((frameIDCurrent - stream.frameIDPrevious) > 1)
+            {
+                cout << "Frame skipped at " << frameIDCurrent << " on camera " << stream.index << ", last frame ID was " << stream.frameIDPrevious << endl;
+                stream.numSkipped += static_cast<unsigned int>(frameIDCurrent - stream.frameIDPrevious - 1);
+            }
+        }
+    }
+
+    stream.timestampPrevious = timestampCurrent;
+    stream.frameIDPrevious = frameIDCurrent;
+    stream.numGrabbed++;
+
+    // Hand the image over; it is released by the processing thread
+    GrabbedFrame frame;
+    frame.pImage = pResultImage;
+    frame.frameID = frameIDCurrent;
+    stream.grabbed.Push(frame);
+}
+
+// Grab thread body; retrieves k_numImages from a single camera
+void GrabImages(CameraStream & stream)
+{
+    for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
+    {
+        try
+        {
+            StageTimer getTimer(stream.grabRecorder, STAGE_GET_NEXT_IMAGE);
+            ImagePtr pResultImage = stream.pCam->GetNextImage(k_grabTimeout);
+            getTimer.Stop();
+
+            HandleGrabbedImage(stream, pResultImage);
+        }
+        catch (Spinnaker::Exception &e)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Camera " << stream.index << " error: " << e.what() << endl;
+            stream.result = -1;
+        }
+    }
+
+    stream.grabbed.Close();
+}
+
+// Retrieves k_numImages from every camera in turn on the calling thread
+void GrabImagesRoundRobin(vector<unique_ptr<CameraStream>> & streams)
+{
+    for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
+    {
+        for (unsigned int i = 0; i < streams.size(); i++)
+        {
+            try
+            {
+                StageTimer getTimer(streams[i]->grabRecorder, STAGE_GET_NEXT_IMAGE);
+                ImagePtr pResultImage = streams[i]->pCam->GetNextImage(k_grabTimeout);
+                getTimer.Stop();
+
+                HandleGrabbedImage(*streams[i], pResultImage);
+            }
+            catch (Spinnaker::Exception &e)
+            {
+                lock_guard<mutex> lock(printMutex);
+                cout << "Error: " << e.what() << endl;
+                streams[i]->result = -1;
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < streams.size(); i++)
+    {
+        streams[i]->grabbed.Close();
+    }
+}
+
+// Processing thread body; converts each grabbed image into a free pool slot,
+// releases the grabbed buffer back to the camera stream and submits the slot
+// to the writer pool.
+void ProcessImages(CameraStream & stream, WriterPool & writers, FrameStats & stats)
+{
+    GrabbedFrame frame;
+
+    while (stream.grabbed.Pop(frame))
+    {
+        const unsigned int slot = stream.pool.Acquire();
+
+        try
+        {
+            // Convert the image into the preallocated slot
+            StageTimer convertTimer(stream.processRecorder, STAGE_CONVERT);
+            frame.pImage->Convert(stream.pool.GetImage(slot), PixelFormat_Mono8, HQ_LINEAR);
+            convertTimer.Stop();
+
+            WriteJob job;
+            job.pStream = &stream;
+            job.slot = slot;
+            job.frameID = frame.frameID;
+            writers.Submit(job);
+        }
+        catch (Spinnaker::Exception &e)
+        {
+            {
+                lock_guard<mutex> lock(printMutex);
+                cout << "Camera " << stream.index << " error: " << e.what() << endl;
+            }
+            stream.result = -1;
+            stream.pool.Recycle(slot);
+        }
+
+        // Release image
+        StageTimer releaseTimer(stream.processRecorder, STAGE_RELEASE);
+        frame.pImage->Release();
+        releaseTimer.Stop();
+        frame.pImage = nullptr;
+
+        stats.ReportIfDue();
+    }
+}
+
+// Plans packet size and packet delay or throughput limit for the GigE cameras
+// on every interface so that their combined bandwidth fits the link. USB3
+// cameras are left as they are.
+int ConfigureBandwidth(const InterfaceList & interfaceList)
+{
+    int result = 0;
+
+    try
+    {
+        const BandwidthPlanner planner(k_maxPacketSize, k_linkHeadroom);
+        vector<BandwidthPlan> plans;
+
+        for (unsigned int i = 0; i < interfaceList.GetSize(); i++)
+        {
+            BandwidthPlan plan;
+            if (!planner.PlanInterface(interfaceList.GetByIndex(i), plan))
+            {
+                continue;
+            }
+
+            BandwidthPlanner::PrintPlan(plan);
+            if (!BandwidthPlanner::ApplyPlan(plan))
+            {
+                cout << "Unable to apply the bandwidth plan of interface " << plan.interfaceName << ". Aborting..." << endl;
+                return -1;
+            }
+
+            plans.push_back(plan);
+        }
+
+        // The primary camera triggers the secondary cameras, so they are all probed together
+        if (ProbeBandwidth && !plans.empty())
+        {
+            cout << endl << "Probing the bandwidth plan for " << k_bandwidthProbeSeconds << " seconds..." << endl;
+
+            vector<BandwidthProbeResult> probeResults;
+            const bool passed = ProbeBandwidthPlan(plans, k_bandwidthProbeSeconds, probeResults);
+            PrintBandwidthProbe(probeResults, k_bandwidthProbeSeconds);
+
+            cout << (passed ? "Bandwidth plan holds." : "Bandwidth plan dropped frames; lower the frame rate or headroom.") << endl;
+        }
+    }
+    catch (Spinnaker::Exception &e)
+    {
+        cout << "Error: " << e.what() << endl;
+        result = -1;
+    }
+
+    return result;
+}
+
 // This function acquires and saves images from each camera
-int AcquireImages(CameraList camList, unsigned int primaryIndex)
+// Ends acquisition on every camera in the list that is streaming, so that a
+// failure part way through setup does not leave the secondary cameras acquiring
+void EndAcquisitionOfStartedCameras(CameraList & camList)
+{
+    for (unsigned int i = 0; i < camList.GetSize(); i++)
+    {
+        try
+        {
+            CameraPtr pStartedCam = camList.GetByIndex(i);
+            if (pStartedCam->IsStreaming())
+            {
+                pStartedCam->EndAcquisition();
+            }
+        }
+        catch (Spinnaker::Exception &e)
+        {
+            cout << "Error: " << e.what() << endl;
+        }
+    }
+}
+
+int AcquireImages(CameraList camList, const vector<CameraProfile> & profiles, unsigned int primaryIndex)
 {
     int result = 0;
     CameraPtr pCam = nullptr;
@@ -692,6 +890,22 @@ int AcquireImages(CameraList camList, unsigned int primaryIndex)
         // Prepare each camera to acquire images
         vector<gcstring> serialNumbers(camList.GetSize());
 
+        //
+        // Preallocate the frame store of each camera
+        //
+        // *** NOTES ***
+        // Converted images are kept in a fixed pool of k_poolDepth Mono8
+        // buffers per camera that the writer recycles once each image has
+        // been saved. The total memory held is therefore
+        // width x height x number of cameras x k_poolDepth, regardless of how
+        // many images are captured.
+        //
+        vector<unique_ptr<CameraStream>> streams;
+        size_t frameStoreSize = 0;
+
+        // Stage timings of every camera, grab and writer thread
+        FrameStats stats("Synchronized", k_frameStatsCsv, k_frameStatsInterval);
+
         for (unsigned int i = 0; i < camList.GetSize(); i++)
         {
             // Select camera
@@ -703,156 +917,139 @@ int AcquireImages(CameraList camList, unsigned int primaryIndex)
             // If using a GEV camera and debugging, should disable heartbeat first to prevent further issues
             if (DisableHeartbeat(pCam, pCam->GetNodeMap(), pCam->GetTLDeviceNodeMap()) != 0)
             {
+                EndAcquisitionOfStartedCameras(camList);
                 return -1;
             }
 
             cout << endl << "*** END OF DEBUG ***" << endl;
 #endif
-            // Retrieve device serial number for filename
-            serialNumbers[i] = "";
-
-            CStringPtr ptrStringSerial = pCam->GetTLDeviceNodeMap().GetNode("DeviceSerialNumber");
-
-            if (IsAvailable(ptrStringSerial) && IsReadable(ptrStringSerial))
+            // Device serial number for filename
+            serialNumbers[i] = profiles[i].serialNumber;
+            cout << "Camera " << i << " serial number is " << serialNumbers[i] << "..." << endl << endl;
+
+            // Retrieve image dimensions for the frame store
+            CIntegerPtr ptrWidth = pCam->GetNodeMap().GetNode("Width");
+            CIntegerPtr ptrHeight = pCam->GetNodeMap().GetNode("Height");
+            if (!IsAvailable(ptrWidth) || !IsReadable(ptrWidth) || !IsAvailable(ptrHeight) || !IsReadable(ptrHeight))
             {
-                serialNumbers[i] = ptrStringSerial->GetValue();
-                cout << "Camera " << i << " serial number is " << serialNumbers[i] << "..." << endl;
+                cout << "Unable to read image dimensions of camera " << i << ". Aborting..." << endl;
+                EndAcquisitionOfStartedCameras(camList);
+                return -1;
             }
-            cout << endl;
+
+            // Create the output directory once per camera
+            const string outputDir = ".\\Camera " + serialNumbers[i] + " images";
+            _mkdir(outputDir.c_str());
+
+            streams.push_back(unique_ptr<CameraStream>(new CameraStream(pCam, i, serialNumbers[i], outputDir,
+                static_cast<size_t>(ptrWidth->GetValue()), static_cast<size_t>(ptrHeight->GetValue()), stats)));
+            frameStoreSize += streams.back()->pool.GetSizeInBytes();
 
             // Begin Acquistion on all Secondary cameras first
             if (i != primaryIndex)
             {
+                streams.back()->streamCountersAtStart = ReadStreamCounters(pCam->GetTLStreamNodeMap());
                 pCam->BeginAcquisition();
                 cout << "Secondary camera " << i << " begin acquiring images..." << endl;
             }
 
         }
 
+        cout << "Frame store preallocated: " << frameStoreSize / (1024 * 1024) << " MB (" << k_poolDepth << " images per camera)" << endl;
+
         cout << endl << "Press Enter to start retrieving and converting images...";
         cin.ignore();
 
         // Start capture on the Primary camera
         pCam = camList.GetByIndex(primaryIndex);
+        streams[primaryIndex]->streamCountersAtStart = ReadStreamCounters(pCam->GetTLStreamNodeMap());
         pCam->BeginAcquisition();
         cout << "Primary camera " << primaryIndex << " begin acquiring images..." << endl << endl;
 
+        //
+        // Start the writer pool and the processing thread of every camera
+        //
+        // *** NOTES ***
+        // Conversion and saving run concurrently with acquisition, so images
+        // are written out while the cameras are still streaming instead of
+        // after the last image has been captured. The writer queue can hold
+        // every pool slot of every camera, so submitting never blocks.
+        //
+        WriterPool writers(k_numWriterThreads, streams.size() * k_poolDepth, stats);
+        vector<thread> threads;
 
-        vector<ImagePtr> pImages;
-
-        // Create arrays for timestamp and Frame ID values
-        vector<int64_t> timestampPrevious(camList.GetSize());
-        vector<int64_t> timestampInterval(camList.GetSize());
-        vector<int64_t> frameIDPrevious(camList.GetSize());
+        for (unsigned int i = 0; i < streams.size(); i++)
+        {
+            threads.push_back(thread(ProcessImages, ref(*streams[i]), ref(writers), ref(stats)));
+        }
 
-        for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
+        if (chosenAcquisition == THREAD_PER_CAMERA)
         {
-            for (unsigned int i = 0; i < camList.GetSize(); i++)
+            //
+            // Grab from every camera concurrently
+            //
+            // *** NOTES ***
+            // Each camera gets its own grab thread. A stalled or slow camera
+            // only ever blocks its own threads, so the remaining cameras keep
+            // streaming at full rate.
+            //
+            for (unsigned int i = 0; i < streams.size(); i++)
             {
-                try
-                {
-                    // Select camera
-                    pCam = camList.GetByIndex(i);
-
-                    // Retrieve the image
-                    ImagePtr pResultImage = pCam->GetNextImage(k_grabTimeout);
-
-                    if (pResultImage->IsIncomplete())
-                    {
-                        cout << "Image incomplete with image   " << pResultImage->GetImageStatus() << "..." << endl << endl;
-                    }
-                    else
-                    {
-                        ChunkData chunkData = pResultImage->GetChunkData();
-
-                        // Retrieve timestamp and Frame ID
-                        const int64_t timestampCurrent = chunkData.GetTimestamp();
-                        const int64_t frameIDCurrent = chunkData.GetFrameID();
-
-                        cout << "Grabbing Frame ID " << frameIDCurrent << " from camera " << i << " - TimeStamp [" << timestampCurrent << "]" << endl;
-
-                        if (imageCnt == 0)
-                        {
-                            timestampPrevious[i] = timestampCurrent;
-                            frameIDPrevious[i] = frameIDCurrent;
-                        }
-                        else
-                        {
-                            timestampInterval[i] = timestampCurrent - timestampPrevious[i];
-                            cout << "Time between consecutive images: " << (timestampCurrent - timestampPrevious[i]) / 1000 << " microseconds" << endl << endl;
-
-                            if ((frameIDCurrent - frameIDPrevious[i]) > 1)
-                            {
-                                cout << "Frame skipped at " << frameIDCurrent << ", last frame ID was " << frameIDPrevious[i] << endl;
-                            }
-
-                            timestampPrevious[i] = timestampCurrent;
-                            frameIDPrevious[i] = frameIDCurrent;
-                        }
-
-                        // Convert the image
-                        pImages.push_back(pResultImage->Convert(PixelFormat_Mono8, HQ_LINEAR));
-
-                    }
-                    // Release image
-                    pResultImage->Release();
-                }
-                catch (Spinnaker::Exception &e)
-                {
-                    cout << "Error: " << e.what() << endl;
-                    result = -1;
-                }
+                threads.push_back(thread(GrabImages, ref(*streams[i])));
             }
         }
+        else
+        {
+            GrabImagesRoundRobin(streams);
+        }
 
-        // Run a separate loop for saving
-        cout << "Saving images..." << endl;
-
-#pragma omp parallel for
-        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        for (unsigned int i = 0; i < threads.size(); i++)
         {
-#pragma omp parallel for
-            for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
-            {
-                try
-                {
-                    int offset = imageCnt * camList.GetSize() + i;
+            threads[i].join();
+        }
 
-                    // Create a unique filename
-                    string Dir = "Camera " + serialNumbers[i] + " images";
-                    _mkdir(Dir.c_str());
-                    ostringstream filename;
-                    filename << ".\\" + Dir + "\\" << serialNumbers[i] << "-" << imageCnt << ".jpg";
+        // Wait for the remaining images to be written
+        writers.Finish();
 
-                    // Save the image
-                    pImages[offset]->Save(filename.str().c_str());
-                    cout << "Saving frame " << imageCnt << " from camera " << i << endl;
-                }
-                catch (Spinnaker::Exception &e)
-                {
-                    cout << "Error: " << e.what() << endl;
-                    result = -1;
-                }
-            }
-        }
+        cout << endl << "*** STREAM SUMMARY ***" << endl << endl;
 
-        // End acquisition for each camera
-        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        for (unsigned int i = 0; i < streams.size(); i++)
         {
-            // End acquisition
-            camList.GetByIndex(i)->EndAcquisition();
+            const double megabytes = streams[i]->bytesWritten / (1024.0 * 1024.0);
+            const double seconds = streams[i]->hasSaveSpan
+                ? chrono::duration<double>(streams[i]->lastSaveEnd - streams[i]->firstSaveStart).count()
+                : 0.0;
+
+            cout << "Camera " << i << " (" << streams[i]->serialNumber << "): "
+                << streams[i]->numGrabbed << " grabbed, "
+                << streams[i]->numIncomplete << " incomplete, "
+                << streams[i]->numSkipped << " skipped, "
+                << streams[i]->numSaved << " saved, "
+                << fixed << setprecision(1) << megabytes << " MB written at "
+                << (seconds > 0.0 ? megabytes / seconds : 0.0) << " MB/s" << endl;
+
+            result = result | streams[i]->result;
+
+            stats.RecordStreamStatistics(streams[i]->pCam->GetTLStreamNodeMap(), streams[i]->streamCountersAtStart);
         }
+        cout << endl;
+
+        stats.Report();
+
+        // End acquisition for each camera
+        EndAcquisitionOfStartedCameras(camList);
     }
     catch (Spinnaker::Exception &e)
     {
         cout << "Error: " << e.what() << endl;
+        EndAcquisitionOfStartedCameras(camList);
         result = -1;
     }
     return result;
 }
 
 // This function acts as the body of the example
-int RunMultipleCameras(CameraList camList)
+int RunMultipleCameras(CameraList camList, const InterfaceList & interfaceList)
 {
     int result = 0;
     CameraPtr pCam = nullptr;
@@ -870,6 +1067,25 @@ int RunMultipleCameras(CameraList camList)
             result = PrintDeviceInfo(nodeMapTLDevice, i);
         }
 
+        //
+        // Resolve the profile of each camera
+        //
+        // *** NOTES ***
+        // The serial number and camera family of every camera are read once
+        // from the transport layer nodemap. Selecting the primary camera,
+        // configuring the trigger lines and naming the saved images all use
+        // the profile instead of looking the nodes up again.
+        //
+        vector<CameraProfile> profiles(camList.GetSize());
+        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        {
+            if (!profiles[i].Resolve(camList.GetByIndex(i)))
+            {
+                cout << "Unable to determine camera family of camera " << i << ". Aborting..." << endl << endl;
+                return -1;
+            }
+        }
+
         // Get the Primary camera SN from user input
         string primarySN;
         string currentSN;
@@ -884,14 +1100,7 @@ int RunMultipleCameras(CameraList camList)
             // Loop through cameras to find s/n provided by user, assign as primary
             for (unsigned int i = 0; i < camList.GetSize(); i++)
             {
-                pCam = camList.GetByIndex(i);
-
-                CStringPtr ptrStringSerial = pCam->GetTLDeviceNodeMap().GetNode("DeviceSerialNumber");
-
-                if (IsAvailable(ptrStringSerial) && IsReadable(ptrStringSerial))
-                {
-                    currentSN = ptrStringSerial->GetValue();
-                }
+                currentSN = profiles[i].serialNumber;
 
                 if (currentSN == primarySN)
                 {
@@ -907,85 +1116,124 @@ int RunMultipleCameras(CameraList camList)
             }
         } while (primaryNotDetected);
 
-        // Initialize each camera
+        //
+        // Initialize and set up each camera
+        //
+        // *** NOTES ***
+        // The settings of each camera are described as a profile. The
+        // settings cache reads what the camera holds, and writes only the
+        // nodes that differ from the profile. Only SETTINGS_FACTORY_RESET
+        // restores the factory defaults first, which forces every setting
+        // that differs from the defaults to be written again on every run.
+        // SETTINGS_DIFF_SNAPSHOT also keeps the result per serial number, so
+        // a camera that has not been restarted since it was last set up is
+        // not even read.
+        //
         for (unsigned int i = 0; i < camList.GetSize(); i++)
         {
             // Select camera
             pCam = camList.GetByIndex(i);
 
-            // Initialize camera
+            // Initialize camera, and resolve its nodes now that they exist
             pCam->Init();
+            profiles[i].Resolve(pCam);
 
-            // Restore camera settings to factory default
             INodeMap & nodeMap = pCam->GetNodeMap();
-            if (RestoreFactoryDefault(nodeMap) == false)
+            if (chosenSettingsApply == SETTINGS_FACTORY_RESET)
             {
-                cout << "Error restoring camera " << i << " settings to Factory default!" << endl;
-                result = -1;
+                // Restore camera settings to factory default; a camera that cannot be restored
+                // is still set up below, starting from its current settings
+                if (RestoreFactoryDefault(nodeMap) == false)
+                {
+                    cout << "Warning: unable to restore camera " << i << " settings to Factory default, continuing..." << endl;
+                }
+                else
+                {
+                    cout << "Camera " << i << " settings restored to factory default" << endl;
+                }
             }
-            cout << "Camera " << i << " settings restored to factory default" << endl;
 
             // Set up Cameras
             cout << endl << "Setting up camera " << i << " ..." << endl << endl;
             cout << "Node name                      Value     " << endl;
             cout << "=========================================" << endl;
 
-            // Sets the boolalpha format flag for the str stream
-            std::cout.setf(std::ios::boolalpha);
-
-            // Determine camera family
-            CStringPtr ptrDeviceModelName = nodeMap.GetNode("DeviceModelName");
-            if (!IsAvailable(ptrDeviceModelName) || !IsReadable(ptrDeviceModelName))
+            SettingsProfile settings;
+            AddCameraSettings(settings, profiles[i]);
+            if (i == primaryIndex)
             {
-                cout << "Unable to determine camera family. Aborting..." << endl << endl;
-                return -1;
+                AddPrimarySettings(settings, profiles[i]);
             }
-
-            gcstring cameraModel = ptrDeviceModelName->GetValue();
-
-            result = result | ConfigureCameraSettings(nodeMap, cameraModel);
-            if (result < 0)
+            else
             {
-                return result;
+                AddSecondarySettings(settings, profiles[i]);
             }
 
-            result = ConfigureChunkData(nodeMap);
-            if (result < 0)
+            SettingsCache cache(pCam, profiles[i], chosenSettingsApply == SETTINGS_DIFF_SNAPSHOT ? k_settingsSnapshotPrefix : "");
+            SettingsApplyResult settingsResult;
+            const bool applied = cache.Apply(settings, settingsResult);
+            PrintSettingsResult(settingsResult);
+            cout << "Camera " << i << " is set up as " << (i == primaryIndex ? "primary" : "secondary") << " camera" << endl;
+
+            if (!applied)
             {
-                return result;
+                cache.Save();
+                return -1;
             }
 
-            if (i == primaryIndex)
+            const int chunkResult = ConfigureChunkData(nodeMap, cache);
+            if (chunkResult < 0)
             {
-                cout << endl << "======== Primary Camera Settings =========" << endl;
-                result = result | SetupPrimaryCam(nodeMap, cameraModel);
-                cout << endl;
+                cache.Invalidate();
+                return chunkResult;
             }
-            else
+
+            // Only saved once every setting of the camera has been written through the cache
+            cache.Save();
+        }
+
+        // Share the GigE links between the cameras now that image size and frame rate are set
+        cout << endl << "======== Bandwidth Plan =========" << endl;
+        result = result | ConfigureBandwidth(interfaceList);
+
+        // Configure stream buffers once the frame rate each camera will reach is known
+        cout << endl << "======== Stream Buffers =========" << endl;
+        vector<StreamSettings> streamSettings(camList.GetSize());
+        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        {
+            if (!ApplyStreamProfile(camList.GetByIndex(i), chosenStreamProfile, streamSettings[i]))
             {
-                cout << endl << "========= Secondary Camera Settings =========" << endl;
-                result = result | SetupSecondaryCam(nodeMap, cameraModel);
-                cout << endl;
+                cout << "Unable to apply every stream buffer setting on camera " << i << "..." << endl;
             }
+            PrintStreamSettings(streamSettings[i]);
         }
 
         // Acquire images on all cameras
         cout << endl;
-        result = result | AcquireImages(camList, primaryIndex);
+        result = result | AcquireImages(camList, profiles, primaryIndex);
+
+        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        {
+            PrintStreamDrops(camList.GetByIndex(i), streamSettings[i]);
+        }
 
         for (unsigned int i = 0; i < camList.GetSize(); i++)
         {
             // Select camera
             pCam = camList.GetByIndex(i);
 
-            // Restore camera settings to factory default
-            INodeMap &nodeMap = pCam->GetNodeMap();
-            if (RestoreFactoryDefault(nodeMap) == false)
+            // Restore camera settings to factory default; the diff modes leave the cameras set
+            // up, so the next run has nothing to write
+            if (chosenSettingsApply == SETTINGS_FACTORY_RESET)
             {
-                cout << "Error restoring camera " << i << " settings to Factory default!!" << endl;
-                result = -1;
+                INodeMap &nodeMap = pCam->GetNodeMap();
+                if (RestoreFactoryDefault(nodeMap) == false)
+                {
+                    cout << "Error restoring camera " << i << " settings to Factory default!!" << endl;
+                    result = -1;
+                }
+                cout << "Camera " << i << " settings restored to factory default" << endl;
             }
-            cout << "Camera " << i << " settings restored to factory default" << endl;
 
             // Deinitialize camera
             pCam->DeInit();
@@ -1048,11 +1296,15 @@ int main(int /*argc*/, char** /*argv*/)
         return -1;
     }
 
+    // Retrieve list of interfaces, used to plan the bandwidth of GigE cameras
+    InterfaceList interfaceList = system->GetInterfaces();
+
     // Run example on all cameras
-    result = RunMultipleCameras(camList);
+    result = RunMultipleCameras(camList, interfaceList);
 
-    // Clear camera list before releasing system
+    // Clear camera and interface lists before releasing system
     camList.Clear();
+    interfaceList.Clear();
 
     // Release system
     system->ReleaseInstance();
@@ -0,0 +1,1168 @@
+//=============================================================================
+// Copyright (c) 2001-2020 FLIR Systems, Inc. All Rights Reserved.
+//
+// This software is the confidential and proprietary information of FLIR
+// Integrated Imaging Solutions, Inc. ("Confidential Information"). You
+// shall not disclose such Confidential Information and shall use it only in
+// accordance with the terms of the license agreement you entered into
+// with FLIR Integrated Imaging Solutions, Inc. (FLIR).
+//
+// FLIR MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF THE
+// SOFTWARE, EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE, OR NON-INFRINGEMENT. FLIR SHALL NOT BE LIABLE FOR ANY DAMAGES
+// SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR DISTRIBUTING
+// THIS SOFTWARE OR ITS DERIVATIVES.
+//=============================================================================
+
+/**
+ *  @example ThroughputBenchmark.cpp
+ *
+ *  @brief ThroughputBenchmark.cpp measures how many frames per second each
+ *  post processing stage used by the other examples can sustain, without a
+ *  camera attached. Recorded raw frames are replayed from memory through
+ *  image conversion with every color processing algorithm, color correction
+ *  with every CCM color temperature, host shading correction, JPEG and PNG
+ *  saving and wrapping in an OpenCV Mat.
+ *
+ *  Every stage is run at each configured resolution and thread count, and
+ *  the results are appended to a CSV file. When a baseline file from an
+ *  earlier run is present, every case is compared against it and the
+ *  example returns an error if any case has become slower than the
+ *  tolerance allows, so that SDK or code changes that cost frames are caught
+ *  before they reach a production system.
+ *
+ *  Please leave us feedback at: https://www.surveymonkey.com/r/TDYMVAPI
+ *  More source code examples at: https://github.com/Teledyne-MV/Spinnaker-Examples
+ *  Need help? Check out our forum at: https://teledynevisionsolutions.zendesk.com/hc/en-us/community/topics
+ */
+
+#include "Spinnaker.h"
+#include "SpinGenApi/SpinnakerGenApi.h"
+#include "ImageUtilityCCM.h"
+#include "FlatFieldCorrection.h"
+#include "RawRecorder.h"
+#include "dirent.h"
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <ctime>
+
+// Set to 0 to build without OpenCV; the OpenCV stage is then skipped
+#define USE_OPENCV 1
+
+#if USE_OPENCV
+#include "opencv2/core.hpp"
+#endif
+
+using namespace Spinnaker;
+using namespace Spinnaker::GenApi;
+using namespace Spinnaker::GenICam;
+using namespace std;
+
+// Use the following enum and global constant to select the recorded frames that are replayed.
+// INPUT_EXAMPLE_IMAGE samples the AcquisitionCCM example image into a BayerRG8 mosaic,
+// INPUT_RAW_DIRECTORY reads the .raw files written for RawToProcessed, and INPUT_RAW_CONTAINER
+// reads a recording made with RawRecorder.h.
+enum benchmarkInputType
+{
+    INPUT_EXAMPLE_IMAGE,
+    INPUT_RAW_DIRECTORY,
+    INPUT_RAW_CONTAINER
+};
+
+const benchmarkInputType kBenchmarkInput = INPUT_EXAMPLE_IMAGE;
+
+// The example image shipped with AcquisitionCCM
+const string kExampleImageFileName = "Cloudy_6500k.raw";
+const size_t kExampleImageWidth = 2448;
+const size_t kExampleImageHeight = 2048;
+
+// Raw files of one frame each, with the image parameters they were saved with
+const string kRawInputDir = "./input";
+const size_t kRawImageWidth = 640;
+const size_t kRawImageHeight = 480;
+const PixelFormatEnums kRawImagePixelFormat = PixelFormat_BayerBG16;
+
+// Container written by RawRecorder.h; the image parameters are read from its index
+const string kRawContainerFile = "recording.spnraw";
+
+// Number of recorded frames held in memory and replayed in turn
+const size_t kMaxSourceFrames = 8;
+
+// Resolutions every stage is run at. A width and height of 0 replays the frames as recorded;
+// other resolutions tile the recorded frames, which needs a format of whole bytes per pixel.
+struct BenchmarkResolution
+{
+    size_t width;
+    size_t height;
+};
+
+const BenchmarkResolution kResolutions[] = {{0, 0}, {1440, 1080}, {640, 480}};
+
+// Number of threads every stage is run with; 0 uses one thread per hardware thread. Every thread
+// has its own ImageProcessor and destination buffers, as in the AcquisitionCCM worker pool.
+const unsigned int kThreadCounts[] = {1, 2, 4, 0};
+
+// Frames each thread processes before timing starts
+const unsigned int kWarmupFramesPerThread = 2;
+
+// Every case is timed kPassesPerCase times. A pass runs until the threads have processed
+// kMinFramesPerThread frames each on average and kMinPassSeconds have passed. The median frame
+// rate of the passes is reported and compared with the baseline, so that one disturbed pass is
+// not taken for a regression.
+const unsigned int kMinFramesPerThread = 32;
+const double kMinPassSeconds = 0.5;
+const unsigned int kPassesPerCase = 5;
+
+// Set any of the following to false to skip a stage
+const bool BenchmarkConvert = true;
+const bool BenchmarkColorCorrection = true;
+const bool BenchmarkShadingCorrection = true;
+const bool BenchmarkSave = true;
+const bool BenchmarkOpenCV = true;
+
+// Results of every run are appended to kResultsFileName. Copy a results file to kBaselineFileName to
+// compare later runs against it; a case whose frame rate drops by more than kRegressionTolerance of
+// the baseline is reported as a regression.
+const string kResultsFileName = "ThroughputBenchmark-results.csv";
+const string kBaselineFileName = "ThroughputBenchmark-baseline.csv";
+const double kRegressionTolerance = 0.10;
+
+// A recorded frame held in memory
+struct SourceFrame
+{
+    size_t width;
+    size_t height;
+    PixelFormatEnums pixelFormat;
+    vector<unsigned char> data;
+};
+
+// The timed results of one stage at one resolution and thread count
+struct BenchmarkResult
+{
+    string stage;
+    string variant;
+    size_t width;
+    size_t height;
+    unsigned int numThreads;
+    unsigned int numFrames;
+    double seconds;
+    double fps;
+    double megapixelsPerSecond;
+    double p50Ms;
+    double p99Ms;
+    double maxMs;
+};
+
+// The frames timed in one pass of a case
+struct BenchmarkPass
+{
+    unsigned int numFrames;
+    double seconds;
+    double fps;
+};
+
+// Body of a case for one thread: processes the given frame index
+typedef function<void(size_t)> FrameBody;
+
+// Called once on each benchmark thread to create the thread's own state, given the thread index
+typedef function<FrameBody(unsigned int)> ThreadSetup;
+
+mutex printMutex;
+
+// Returns the number of bytes per pixel of an unpacked format, or 0 for packed and unknown formats
+size_t GetBytesPerPixel(PixelFormatEnums pixelFormat)
+{
+    switch (pixelFormat)
+    {
+    case PixelFormat_Mono8:
+    case PixelFormat_BayerRG8:
+    case PixelFormat_BayerGR8:
+    case PixelFormat_BayerGB8:
+    case PixelFormat_BayerBG8:
+        return 1;
+    case PixelFormat_Mono16:
+    case PixelFormat_BayerRG16:
+    case PixelFormat_BayerBG16:
+        return 2;
+    case PixelFormat_BGR8:
+    case PixelFormat_RGB8:
+        return 3;
+    default:
+        return 0;
+    }
+}
+
+// Returns the name of a color processing algorithm
+string ColorProcessingToString(ColorProcessingAlgorithm algorithm)
+{
+    switch (algorithm)
+    {
+    case SPINNAKER_COLOR_PROCESSING_ALGORITHM_NEAREST_NEIGHBOR:
+        return "NearestNeighbor";
+    case SPINNAKER_COLOR_PROCESSING_ALGORITHM_NEAREST_NEIGHBOR_AVG:
+        return "NearestNeighborAvg";
+    case SPINNAKER_COLOR_PROCESSING_ALGORITHM_BILINEAR:
+        return "Bilinear";
+    case SPINNAKER_COLOR_PROCESSING_ALGORITHM_EDGE_SENSING:
+        return "EdgeSensing";
+    case SPINNAKER_COLOR_PROCESSING_ALGORITHM_HQ_LINEAR:
+        return "HQLinear";
+    case SPINNAKER_COLOR_PROCESSING_ALGORITHM_IPP:
+        return "IPP";
+    case SPINNAKER_COLOR_PROCESSING_ALGORITHM_DIRECTIONAL_FILTER:
+        return "DirectionalFilter";
+    case SPINNAKER_COLOR_PROCESSING_ALGORITHM_RIGOROUS:
+        return "Rigorous";
+    case SPINNAKER_COLOR_PROCESSING_ALGORITHM_WEIGHTED_DIRECTIONAL_FILTER:
+        return "WeightedDirectionalFilter";
+    default:
+        return "None";
+    }
+}
+
+// Adds a frame if it matches the frames read so far; the benchmark replays frames of one size and format
+bool AddSourceFrame(
+    vector<SourceFrame>& frames,
+    size_t width,
+    size_t height,
+    PixelFormatEnums pixelFormat,
+    const unsigned char* data,
+    size_t size)
+{
+    if (!frames.empty() &&
+        (frames[0].width != width || frames[0].height != height || frames[0].pixelFormat != pixelFormat ||
+         frames[0].data.size() != size))
+    {
+        cout << "Skipping a " << width << "x" << height << " frame that does not match the first frame" << endl;
+        return false;
+    }
+
+    SourceFrame frame;
+    frame.width = width;
+    frame.height = height;
+    frame.pixelFormat = pixelFormat;
+    frame.data.assign(data, data + size);
+    frames.push_back(frame);
+    return true;
+}
+
+// This function reads the BGR8 example image and samples it into a BayerRG8 mosaic, so that the
+// replayed frame looks like one grabbed from a color camera.
+int ReadExampleImage(vector<SourceFrame>& frames)
+{
+    const size_t size = kExampleImageWidth * kExampleImageHeight * 3;
+    vector<unsigned char> bgr(size);
+
+    cout << "Reading image: " << kExampleImageFileName << endl;
+    ifstream file(kExampleImageFileName.c_str(), ios::binary | ios::in);
+    if (!file || !file.read(reinterpret_cast<char*>(&bgr[0]), size))
+    {
+        cout << kExampleImageFileName << " not found in the working directory" << endl;
+        return -1;
+    }
+
+    vector<unsigned char> bayer(kExampleImageWidth * kExampleImageHeight);
+    for (size_t y = 0; y < kExampleImageHeight; y++)
+    {
+        for (size_t x = 0; x < kExampleImageWidth; x++)
+        {
+            // Channel index within the BGR pixel of an RGGB tile position
+            const size_t channel = (y & 1) == 0 ? ((x & 1) == 0 ? 2 : 1) : ((x & 1) == 0 ? 1 : 0);
+            bayer[y * kExampleImageWidth + x] = bgr[(y * kExampleImageWidth + x) * 3 + channel];
+        }
+    }
+
+    AddSourceFrame(frames, kExampleImageWidth, kExampleImageHeight, PixelFormat_BayerRG8, &bayer[0], bayer.size());
+    return 0;
+}
+
+// This function reads up to kMaxSourceFrames .raw files from kRawInputDir, in name order so that
+// every run replays the same frames.
+int ReadRawDirectory(vector<SourceFrame>& frames)
+{
+    DIR* dp = opendir(kRawInputDir.c_str());
+    if (dp == NULL)
+    {
+        cout << "Error opening " << kRawInputDir << endl;
+        return -1;
+    }
+
+    vector<string> fileNames;
+    struct dirent* dirp;
+    while ((dirp = readdir(dp)) != NULL)
+    {
+        const string fileName = dirp->d_name;
+        if (fileName.size() > 4)
+        {
+            string extension = fileName.substr(fileName.size() - 4);
+            transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            if (extension == ".raw")
+            {
+                fileNames.push_back(fileName);
+            }
+        }
+    }
+    closedir(dp);
+    sort(fileNames.begin(), fileNames.end());
+
+    const size_t size = kRawImageWidth * kRawImageHeight * GetBytesPerPixel(kRawImagePixelFormat);
+    vector<unsigned char> buffer(size);
+
+    for (size_t i = 0; i < fileNames.size() && frames.size() < kMaxSourceFrames; i++)
+    {
+        const string filePath = kRawInputDir + "/" + fileNames[i];
+        ifstream file(filePath.c_str(), ios::binary | ios::in);
+        if (size == 0 || !file || !file.read(reinterpret_cast<char*>(&buffer[0]), size))
+        {
+            cout << "Skipping " << filePath << ", which holds less than one " << kRawImageWidth << "x"
+                 << kRawImageHeight << " frame" << endl;
+            continue;
+        }
+        AddSourceFrame(frames, kRawImageWidth, kRawImageHeight, kRawImagePixelFormat, &buffer[0], size);
+    }
+
+    return frames.empty() ? -1 : 0;
+}
+
+// This function reads up to kMaxSourceFrames frames from a RawRecorder container, using the image
+// parameters from its index.
+int ReadRawContainer(vector<SourceFrame>& frames)
+{
+    ifstream file(kRawContainerFile.c_str(), ios::binary | ios::in | ios::ate);
+    if (!file)
+    {
+        cout << kRawContainerFile << " not found in the working directory" << endl;
+        return -1;
+    }
+
+    const size_t size = static_cast<size_t>(file.tellg());
+    vector<unsigned char> container(max<size_t>(size, 1));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(&container[0]), size))
+    {
+        cout << "Error reading " << kRawContainerFile << endl;
+        return -1;
+    }
+
+    vector<RawContainerIndexEntry> index;
+    if (!ReadRawContainerIndex(&container[0], size, index))
+    {
+        cout << kRawContainerFile << " is not a complete raw container" << endl;
+        return -1;
+    }
+
+    for (size_t i = 0; i < index.size() && frames.size() < kMaxSourceFrames; i++)
+    {
+        const RawContainerIndexEntry& entry = index[i];
+        if (!RawContainerEntryHoldsImage(entry))
+        {
+            cout << "Skipping frame " << i << " of " << kRawContainerFile << ", whose " << entry.size
+                 << " bytes are too few for a " << entry.width << "x" << entry.height << " image" << endl;
+            continue;
+        }
+        AddSourceFrame(
+            frames,
+            entry.width,
+            entry.height,
+            static_cast<PixelFormatEnums>(entry.pixelFormat),
+            &container[entry.offset],
+            entry.size);
+    }
+
+    return frames.empty() ? -1 : 0;
+}
+
+// This function tiles a recorded frame to the requested resolution. Whole 2x2 tiles are copied so
+// that the Bayer pattern is unchanged. Returns false if the format is packed.
+bool TileFrame(const SourceFrame& source, size_t width, size_t height, SourceFrame& tiled)
+{
+    const size_t bytesPerPixel = GetBytesPerPixel(source.pixelFormat);
+    if (bytesPerPixel == 0 || source.width < 2 || source.height < 2 ||
+        source.data.size() < source.width * source.height * bytesPerPixel)
+    {
+        return false;
+    }
+
+    const size_t sourceWidth = source.width & ~static_cast<size_t>(1);
+    const size_t sourceHeight = source.height & ~static_cast<size_t>(1);
+    const size_t sourceStride = source.width * bytesPerPixel;
+
+    tiled.width = width;
+    tiled.height = height;
+    tiled.pixelFormat = source.pixelFormat;
+    tiled.data.resize(width * height * bytesPerPixel);
+
+    for (size_t y = 0; y < height; y++)
+    {
+        const unsigned char* sourceRow = &source.data[(y % sourceHeight) * sourceStride];
+        unsigned char* row = &tiled.data[y * width * bytesPerPixel];
+
+        for (size_t x = 0; x < width; x += sourceWidth)
+        {
+            const size_t count = min(sourceWidth, width - x);
+            memcpy(row + x * bytesPerPixel, sourceRow, count * bytesPerPixel);
+        }
+    }
+
+    return true;
+}
+
+// Returns the frame at percentile p of sorted durations, in milliseconds
+double GetPercentile(const vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+    const size_t index = min(sorted.size() - 1, static_cast<size_t>(p * (sorted.size() - 1) + 0.5));
+    return sorted[index];
+}
+
+//
+// This function times one pass of a case
+//
+// *** NOTES ***
+// Every thread first creates its own state through setup and processes a few untimed frames, so
+// that buffer allocation and first-use costs are not measured. Timing starts once every thread is
+// warm. The threads then take frame indices from a shared counter until kMinFramesPerThread frames
+// per thread are done and kMinPassSeconds have passed, so the frame rate is the rate the whole pool
+// sustains. The latency of every frame is appended to latencies for the percentiles.
+//
+bool RunPass(unsigned int numThreads, const ThreadSetup& setup, vector<double>& latencies, unsigned int& numFrames, double& seconds)
+{
+    const unsigned int minFrames = kMinFramesPerThread * numThreads;
+    const chrono::duration<double> minDuration(kMinPassSeconds);
+
+    atomic<unsigned int> nextFrame(0);
+    atomic<bool> failed(false);
+    vector<vector<double>> threadLatencies(numThreads);
+
+    mutex startMutex;
+    condition_variable startCondition;
+    unsigned int numReady = 0;
+    bool started = false;
+    chrono::steady_clock::time_point start;
+
+    vector<thread> threads;
+    for (unsigned int t = 0; t < numThreads; t++)
+    {
+        threads.push_back(thread([&, t]() {
+            FrameBody body;
+            try
+            {
+                body = setup(t);
+                for (unsigned int i = 0; i < kWarmupFramesPerThread; i++)
+                {
+                    body(t + i * numThreads);
+                }
+            }
+            catch (Spinnaker::Exception& e)
+            {
+                lock_guard<mutex> lock(printMutex);
+                cout << "Error: " << e.what() << endl;
+                failed = true;
+            }
+
+            {
+                unique_lock<mutex> lock(startMutex);
+                numReady++;
+                startCondition.notify_all();
+                startCondition.wait(lock, [&]() { return started; });
+            }
+
+            if (!body || failed)
+            {
+                return;
+            }
+
+            threadLatencies[t].reserve(kMinFramesPerThread * 2);
+            for (unsigned int frame = nextFrame++; !failed; frame = nextFrame++)
+            {
+                const chrono::steady_clock::time_point frameStart = chrono::steady_clock::now();
+                if (frame >= minFrames && frameStart - start >= minDuration)
+                {
+                    break;
+                }
+
+                try
+                {
+                    body(frame);
+                    const chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - frameStart;
+                    threadLatencies[t].push_back(elapsed.count());
+                }
+                catch (Spinnaker::Exception& e)
+                {
+                    lock_guard<mutex> lock(printMutex);
+                    cout << "Error: " << e.what() << endl;
+                    failed = true;
+                }
+            }
+        }));
+    }
+
+    {
+        unique_lock<mutex> lock(startMutex);
+        startCondition.wait(lock, [&]() { return numReady == numThreads; });
+        start = chrono::steady_clock::now();
+        started = true;
+        startCondition.notify_all();
+    }
+
+    for (size_t t = 0; t < threads.size(); t++)
+    {
+        threads[t].join();
+    }
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    if (failed)
+    {
+        return false;
+    }
+
+    numFrames = 0;
+    for (size_t t = 0; t < threadLatencies.size(); t++)
+    {
+        latencies.insert(latencies.end(), threadLatencies[t].begin(), threadLatencies[t].end());
+        numFrames += static_cast<unsigned int>(threadLatencies[t].size());
+    }
+    seconds = elapsed.count();
+
+    return true;
+}
+
+//
+// This function times one stage at one resolution and thread count
+//
+// *** NOTES ***
+// The case is timed kPassesPerCase times through RunPass. The pass with the median frame rate gives
+// the frames, seconds and frame rate of the result, and the percentiles are taken over the frames of
+// every pass.
+//
+bool RunCase(
+    const string& stage,
+    const string& variant,
+    size_t width,
+    size_t height,
+    unsigned int numThreads,
+    const ThreadSetup& setup,
+    BenchmarkResult& result)
+{
+    vector<double> sorted;
+    vector<BenchmarkPass> passes(kPassesPerCase);
+    for (unsigned int p = 0; p < kPassesPerCase; p++)
+    {
+        BenchmarkPass& pass = passes[p];
+        if (!RunPass(numThreads, setup, sorted, pass.numFrames, pass.seconds))
+        {
+            return false;
+        }
+        pass.fps = pass.seconds > 0.0 ? pass.numFrames / pass.seconds : 0.0;
+    }
+    sort(passes.begin(), passes.end(), [](const BenchmarkPass& a, const BenchmarkPass& b) { return a.fps < b.fps; });
+    sort(sorted.begin(), sorted.end());
+
+    const BenchmarkPass& median = passes[passes.size() / 2];
+
+    result.stage = stage;
+    result.variant = variant;
+    result.width = width;
+    result.height = height;
+    result.numThreads = numThreads;
+    result.numFrames = median.numFrames;
+    result.seconds = median.seconds;
+    result.fps = median.fps;
+    result.megapixelsPerSecond = result.fps * width * height / 1000000.0;
+    result.p50Ms = GetPercentile(sorted, 0.50);
+    result.p99Ms = GetPercentile(sorted, 0.99);
+    result.maxMs = sorted.empty() ? 0.0 : sorted.back();
+
+    cout << left << setw(12) << stage << setw(28) << variant << right << setw(5) << width << "x" << left
+         << setw(6) << height << right << setw(3) << numThreads << " threads" << fixed << setprecision(1)
+         << setw(9) << result.fps << " fps" << setw(9) << result.megapixelsPerSecond << " MP/s" << setprecision(2)
+         << setw(9) << result.p50Ms << " ms p50" << setw(9) << result.p99Ms << " ms p99" << endl;
+    cout.unsetf(ios::fixed);
+    cout << setprecision(6);
+
+    return true;
+}
+
+// Frames of one resolution in each of the formats the stages take as input
+struct StageInputs
+{
+    size_t width;
+    size_t height;
+    vector<ImagePtr> raw;
+    vector<ImagePtr> bgr;
+    vector<ImagePtr> mono;
+    vector<vector<unsigned char>> buffers;
+};
+
+// This function converts the replayed frames once into the BGR8 and Mono8 images the later stages
+// start from, so that only the stage being measured is timed.
+void PrepareStageInputs(vector<SourceFrame>& frames, StageInputs& inputs)
+{
+    ImageProcessor processor;
+    processor.SetColorProcessing(SPINNAKER_COLOR_PROCESSING_ALGORITHM_HQ_LINEAR);
+
+    const size_t numPixels = inputs.width * inputs.height;
+    inputs.buffers.resize(frames.size() * 2);
+
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        ImagePtr raw =
+            Image::Create(inputs.width, inputs.height, 0, 0, frames[i].pixelFormat, &frames[i].data[0]);
+
+        inputs.buffers[i * 2].resize(numPixels * 3);
+        inputs.buffers[i * 2 + 1].resize(numPixels);
+        ImagePtr bgr = Image::Create(inputs.width, inputs.height, 0, 0, PixelFormat_BGR8, &inputs.buffers[i * 2][0]);
+        ImagePtr mono =
+            Image::Create(inputs.width, inputs.height, 0, 0, PixelFormat_Mono8, &inputs.buffers[i * 2 + 1][0]);
+
+        processor.Convert(raw, bgr, PixelFormat_BGR8);
+        processor.Convert(raw, mono, PixelFormat_Mono8);
+
+        inputs.raw.push_back(raw);
+        inputs.bgr.push_back(bgr);
+        inputs.mono.push_back(mono);
+    }
+}
+
+// Creates a destination image backed by a buffer that lives as long as the returned image holder
+ImagePtr CreateBuffer(shared_ptr<vector<unsigned char>>& buffer, size_t width, size_t height, PixelFormatEnums pixelFormat, size_t bytesPerPixel)
+{
+    buffer = make_shared<vector<unsigned char>>(width * height * bytesPerPixel);
+    return Image::Create(width, height, 0, 0, pixelFormat, &(*buffer)[0]);
+}
+
+// This function runs image conversion with every color processing algorithm
+void RunConvertStage(const StageInputs& inputs, unsigned int numThreads, vector<BenchmarkResult>& results)
+{
+    const ColorProcessingAlgorithm algorithms[] = {
+        SPINNAKER_COLOR_PROCESSING_ALGORITHM_NEAREST_NEIGHBOR,
+        SPINNAKER_COLOR_PROCESSING_ALGORITHM_NEAREST_NEIGHBOR_AVG,
+        SPINNAKER_COLOR_PROCESSING_ALGORITHM_BILINEAR,
+        SPINNAKER_COLOR_PROCESSING_ALGORITHM_EDGE_SENSING,
+        SPINNAKER_COLOR_PROCESSING_ALGORITHM_HQ_LINEAR,
+        SPINNAKER_COLOR_PROCESSING_ALGORITHM_IPP,
+        SPINNAKER_COLOR_PROCESSING_ALGORITHM_DIRECTIONAL_FILTER,
+        SPINNAKER_COLOR_PROCESSING_ALGORITHM_RIGOROUS,
+        SPINNAKER_COLOR_PROCESSING_ALGORITHM_WEIGHTED_DIRECTIONAL_FILTER};
+
+    const vector<ImagePtr>* raw = &inputs.raw;
+    const size_t width = inputs.width;
+    const size_t height = inputs.height;
+
+    for (size_t a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); a++)
+    {
+        const ColorProcessingAlgorithm algorithm = algorithms[a];
+
+        BenchmarkResult result;
+        if (RunCase(
+                "Convert",
+                ColorProcessingToString(algorithm),
+                width,
+                height,
+                numThreads,
+                [=](unsigned int) {
+                    // ImageProcessor is not shared between threads, so every thread keeps its own instance
+                    shared_ptr<ImageProcessor> processor = make_shared<ImageProcessor>();
+                    processor->SetColorProcessing(algorithm);
+
+                    shared_ptr<vector<unsigned char>> buffer;
+                    ImagePtr converted = CreateBuffer(buffer, width, height, PixelFormat_BGR8, 3);
+
+                    // The buffer is captured so that it lives as long as the image over it
+                    return FrameBody([processor, buffer, converted, raw](size_t frame) mutable {
+                        processor->Convert((*raw)[frame % raw->size()], converted, PixelFormat_BGR8);
+                    });
+                },
+                result))
+        {
+            results.push_back(result);
+        }
+    }
+}
+
+// This function runs ImageUtilityCCM with every CCM color temperature
+void RunColorCorrectionStage(const StageInputs& inputs, unsigned int numThreads, vector<BenchmarkResult>& results)
+{
+    const CCMColorTemperature colorTemperatures[] = {
+        SPINNAKER_CCM_COLOR_TEMP_HALOGEN_2700K,
+        SPINNAKER_CCM_COLOR_TEMP_TUNGSTEN_3200K,
+        SPINNAKER_CCM_COLOR_TEMP_OFFICE_FLUORESCENT_4000K,
+        SPINNAKER_CCM_COLOR_TEMP_LED_4649K,
+        SPINNAKER_CCM_COLOR_TEMP_LED_5000K,
+        SPINNAKER_CCM_COLOR_TEMP_SUNLIGHT_5500K,
+        SPINNAKER_CCM_COLOR_TEMP_CLOUDY_6500K};
+
+    const vector<ImagePtr>* bgr = &inputs.bgr;
+    const size_t width = inputs.width;
+    const size_t height = inputs.height;
+
+    for (size_t c = 0; c < sizeof(colorTemperatures) / sizeof(colorTemperatures[0]); c++)
+    {
+        CCMSettings ccmSettings;
+        ccmSettings.ColorTemperature = colorTemperatures[c];
+        ccmSettings.Sensor = SPINNAKER_CCM_SENSOR_IMX250;
+        ccmSettings.Type = SPINNAKER_CCM_TYPE_LINEAR;
+        ccmSettings.ColorSpace = SPINNAKER_CCM_COLOR_SPACE_SRGB;
+        ccmSettings.Application = SPINNAKER_CCM_APPLICATION_GENERIC;
+
+        BenchmarkResult result;
+        if (RunCase(
+                "CCM",
+                ImageUtilityCCM::ColorTemperatureToString(colorTemperatures[c]),
+                width,
+                height,
+                numThreads,
+                [=](unsigned int) {
+                    shared_ptr<vector<unsigned char>> buffer;
+                    ImagePtr corrected = CreateBuffer(buffer, width, height, PixelFormat_BGR8, 3);
+
+                    return FrameBody([buffer, corrected, bgr, ccmSettings](size_t frame) mutable {
+                        ImageUtilityCCM::ColorCorrect((*bgr)[frame % bgr->size()], corrected, ccmSettings);
+                    });
+                },
+                result))
+        {
+            results.push_back(result);
+        }
+    }
+}
+
+// This function runs the host flat-field correction, with a map calibrated from the replayed frames
+void RunShadingCorrectionStage(const StageInputs& inputs, unsigned int numThreads, vector<BenchmarkResult>& results)
+{
+    FlatFieldCalibrator calibrator;
+    for (size_t i = 0; i < inputs.mono.size(); i++)
+    {
+        calibrator.AddFlatFrame(inputs.mono[i]);
+    }
+
+    shared_ptr<FlatFieldMap> map = make_shared<FlatFieldMap>();
+    if (!calibrator.Build(*map))
+    {
+        cout << "Skipping shading correction, the replayed frames do not give a flat-field map" << endl;
+        return;
+    }
+
+    const vector<ImagePtr>* mono = &inputs.mono;
+    const size_t width = inputs.width;
+    const size_t height = inputs.height;
+
+    BenchmarkResult result;
+    if (RunCase(
+            "Shading",
+            string("FlatField-") + FlatFieldCorrection::GetInstructionSet(),
+            width,
+            height,
+            numThreads,
+            [=](unsigned int) {
+                // The benchmark threads already run in parallel, so every correction uses only its caller
+                shared_ptr<FlatFieldCorrection> correction = make_shared<FlatFieldCorrection>(*map, 1);
+
+                shared_ptr<vector<unsigned char>> buffer;
+                ImagePtr corrected = CreateBuffer(buffer, width, height, PixelFormat_Mono8, 1);
+
+                return FrameBody([correction, buffer, corrected, mono](size_t frame) mutable {
+                    correction->Apply((*mono)[frame % mono->size()], corrected);
+                });
+            },
+            result))
+    {
+        results.push_back(result);
+    }
+}
+
+// This function saves BGR8 images as JPEG and PNG. Every thread overwrites its own file, so the time
+// includes writing to the working directory's disk.
+void RunSaveStage(const StageInputs& inputs, unsigned int numThreads, vector<BenchmarkResult>& results)
+{
+    const string extensions[] = {"jpg", "png"};
+    const vector<ImagePtr>* bgr = &inputs.bgr;
+
+    for (size_t e = 0; e < sizeof(extensions) / sizeof(extensions[0]); e++)
+    {
+        const string extension = extensions[e];
+
+        BenchmarkResult result;
+        if (RunCase(
+                "Save",
+                extension == "jpg" ? "JPEG" : "PNG",
+                inputs.width,
+                inputs.height,
+                numThreads,
+                [=](unsigned int t) {
+                    ostringstream filename;
+                    filename << "ThroughputBenchmark-" << t << "." << extension;
+                    const string fileName = filename.str();
+
+                    return FrameBody([=](size_t frame) { (*bgr)[frame % bgr->size()]->Save(fileName.c_str()); });
+                },
+                result))
+        {
+            results.push_back(result);
+        }
+
+        for (unsigned int t = 0; t < numThreads; t++)
+        {
+            ostringstream filename;
+            filename << "ThroughputBenchmark-" << t << "." << extension;
+            remove(filename.str().c_str());
+        }
+    }
+}
+
+#if USE_OPENCV
+// Wrap the image data in an OpenCV Mat without copying it, as in AcquisitionOpenCV
+cv::Mat WrapImage(const ImagePtr& pImage)
+{
+    unsigned int rows = static_cast<unsigned int>(pImage->GetHeight());
+    unsigned int cols = static_cast<unsigned int>(pImage->GetWidth());
+    unsigned int num_channels = static_cast<unsigned int>(pImage->GetNumChannels());
+    void* image_data = pImage->GetData();
+    size_t stride = pImage->GetStride();
+    return cv::Mat(rows, cols, (num_channels == 3) ? CV_8UC3 : CV_8UC1, image_data, stride);
+}
+
+// This function wraps BGR8 images in an OpenCV Mat, and wraps and clones them for applications that
+// keep the Mat after the image has been released.
+void RunOpenCVStage(const StageInputs& inputs, unsigned int numThreads, vector<BenchmarkResult>& results)
+{
+    const vector<ImagePtr>* bgr = &inputs.bgr;
+
+    for (int clone = 0; clone < 2; clone++)
+    {
+        BenchmarkResult result;
+        if (RunCase(
+                "OpenCV",
+                clone ? "WrapAndClone" : "Wrap",
+                inputs.width,
+                inputs.height,
+                numThreads,
+                [=](unsigned int) {
+                    shared_ptr<cv::Mat> kept = make_shared<cv::Mat>();
+
+                    return FrameBody([=](size_t frame) {
+                        cv::Mat wrapped = WrapImage((*bgr)[frame % bgr->size()]);
+                        *kept = clone ? wrapped.clone() : wrapped;
+                    });
+                },
+                result))
+        {
+            results.push_back(result);
+        }
+    }
+}
+#endif
+
+// Key identifying a case across runs, as the stage to threads columns of a results line
+string GetCaseKey(const string& stage, const string& variant, size_t width, size_t height, unsigned int numThreads)
+{
+    // Names are written without commas so that the results need no quoting
+    string name = variant;
+    replace(name.begin(), name.end(), ',', ' ');
+
+    ostringstream key;
+    key << stage << "," << name << "," << width << "," << height << "," << numThreads;
+    return key.str();
+}
+
+// Splits one CSV line; the benchmark writes no quoted fields
+vector<string> SplitCSVLine(const string& line)
+{
+    vector<string> fields;
+    istringstream stream(line);
+    string field;
+    while (getline(stream, field, ','))
+    {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+// This function appends the results of a run to kResultsFileName, writing the header when the file is new
+int WriteResults(const vector<BenchmarkResult>& results, const string& runLabel, const string& libraryVersion)
+{
+    bool writeHeader = true;
+    {
+        ifstream existing(kResultsFileName.c_str());
+        writeHeader = !existing || existing.peek() == ifstream::traits_type::eof();
+    }
+
+    ofstream file(kResultsFileName.c_str(), ios::out | ios::app);
+    if (!file)
+    {
+        cout << "Error writing " << kResultsFileName << endl;
+        return -1;
+    }
+
+    if (writeHeader)
+    {
+        file << "run,spinnaker,stage,variant,width,height,threads,frames,seconds,fps,megapixels_per_second,p50_ms,"
+                "p99_ms,max_ms"
+             << endl;
+    }
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult& r = results[i];
+        file << runLabel << "," << libraryVersion << "," << GetCaseKey(r.stage, r.variant, r.width, r.height, r.numThreads)
+             << "," << r.numFrames << "," << r.seconds << "," << r.fps << "," << r.megapixelsPerSecond << ","
+             << r.p50Ms << "," << r.p99Ms << "," << r.maxMs << endl;
+    }
+
+    cout << endl << results.size() << " results appended to " << kResultsFileName << endl;
+    return 0;
+}
+
+//
+// This function compares the results with kBaselineFileName
+//
+// *** NOTES ***
+// The baseline has the same columns as the results file, and when it holds several runs the last
+// run of each case is used. Only the frame rate is compared, which is already the median of
+// kPassesPerCase passes on both sides; a case slower than the baseline by more
+// than kRegressionTolerance counts as a regression and makes the example return an error, so that
+// the benchmark can gate a build. Cases missing from either side are listed but do not fail.
+//
+int CompareWithBaseline(const vector<BenchmarkResult>& results)
+{
+    ifstream file(kBaselineFileName.c_str());
+    if (!file)
+    {
+        cout << "No baseline " << kBaselineFileName << " found; copy " << kResultsFileName
+             << " there to compare future runs against this one" << endl;
+        return 0;
+    }
+
+    string line;
+    getline(file, line);
+    const vector<string> header = SplitCSVLine(line);
+    const size_t fpsColumn = find(header.begin(), header.end(), "fps") - header.begin();
+    const size_t stageColumn = find(header.begin(), header.end(), "stage") - header.begin();
+    if (fpsColumn >= header.size() || stageColumn + 5 > header.size())
+    {
+        cout << kBaselineFileName << " is not a ThroughputBenchmark results file" << endl;
+        return -1;
+    }
+
+    map<string, double> baseline;
+    while (getline(file, line))
+    {
+        const vector<string> fields = SplitCSVLine(line);
+        if (fields.size() < header.size())
+        {
+            continue;
+        }
+        const string key = fields[stageColumn] + "," + fields[stageColumn + 1] + "," + fields[stageColumn + 2] + "," +
+                           fields[stageColumn + 3] + "," + fields[stageColumn + 4];
+        baseline[key] = atof(fields[fpsColumn].c_str());
+    }
+
+    cout << endl << "*** COMPARISON WITH " << kBaselineFileName << " ***" << endl << endl;
+
+    unsigned int numRegressions = 0;
+    unsigned int numCompared = 0;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult& r = results[i];
+        const string key = GetCaseKey(r.stage, r.variant, r.width, r.height, r.numThreads);
+        map<string, double>::const_iterator it = baseline.find(key);
+        if (it == baseline.end())
+        {
+            cout << "New case: " << key << endl;
+            continue;
+        }
+
+        numCompared++;
+        const double change = it->second > 0.0 ? r.fps / it->second - 1.0 : 0.0;
+        if (change < -kRegressionTolerance)
+        {
+            numRegressions++;
+            cout << "REGRESSION: " << key << " " << r.fps << " fps, baseline " << it->second << " fps ("
+                 << change * 100.0 << "%)" << endl;
+        }
+        baseline.erase(it);
+    }
+
+    for (map<string, double>::const_iterator it = baseline.begin(); it != baseline.end(); ++it)
+    {
+        cout << "Not run: " << it->first << endl;
+    }
+
+    cout << numCompared << " cases compared, " << numRegressions << " slower than the baseline by more than "
+         << kRegressionTolerance * 100.0 << "%" << endl;
+
+    return numRegressions > 0 ? -1 : 0;
+}
+
+// Example entry point; the run label written to the results defaults to the start time and can be
+// given as the first argument, for example a build number
+int main(int argc, char** argv)
+{
+    int result = 0;
+
+    // Print application build information
+    cout << "Application build date: " << __DATE__ << " " << __TIME__ << endl << endl;
+
+    // Retrieve singleton reference to system object; no camera is needed
+    SystemPtr system = System::GetInstance();
+
+    // Print out current library version
+    const LibraryVersion spinnakerLibraryVersion = system->GetLibraryVersion();
+    ostringstream libraryVersion;
+    libraryVersion << spinnakerLibraryVersion.major << "." << spinnakerLibraryVersion.minor << "."
+                   << spinnakerLibraryVersion.type << "." << spinnakerLibraryVersion.build;
+    cout << "Spinnaker library version: " << libraryVersion.str() << endl << endl;
+
+    string runLabel;
+    if (argc > 1)
+    {
+        runLabel = argv[1];
+    }
+    else
+    {
+        ostringstream label;
+        label << static_cast<long long>(time(NULL));
+        runLabel = label.str();
+    }
+
+    // Read the recorded frames
+    vector<SourceFrame> sourceFrames;
+    if (kBenchmarkInput == INPUT_EXAMPLE_IMAGE)
+    {
+        result = ReadExampleImage(sourceFrames);
+    }
+    else if (kBenchmarkInput == INPUT_RAW_DIRECTORY)
+    {
+        result = ReadRawDirectory(sourceFrames);
+    }
+    else
+    {
+        result = ReadRawContainer(sourceFrames);
+    }
+
+    if (result != 0 || sourceFrames.empty())
+    {
+        cout << "No recorded frames to replay" << endl;
+        system->ReleaseInstance();
+        return -1;
+    }
+
+    cout << "Replaying " << sourceFrames.size() << " recorded " << sourceFrames[0].width << "x"
+         << sourceFrames[0].height << " frames" << endl;
+
+    // Resolve the thread counts, leaving out repeats so that every case is run once
+    vector<unsigned int> threadCounts;
+    for (size_t t = 0; t < sizeof(kThreadCounts) / sizeof(kThreadCounts[0]); t++)
+    {
+        const unsigned int numThreads =
+            kThreadCounts[t] > 0 ? kThreadCounts[t] : max(thread::hardware_concurrency(), 1u);
+        if (find(threadCounts.begin(), threadCounts.end(), numThreads) == threadCounts.end())
+        {
+            threadCounts.push_back(numThreads);
+        }
+    }
+
+    vector<BenchmarkResult> results;
+
+    for (size_t r = 0; r < sizeof(kResolutions) / sizeof(kResolutions[0]); r++)
+    {
+        vector<SourceFrame> frames;
+        if (kResolutions[r].width == 0 || kResolutions[r].height == 0)
+        {
+            frames = sourceFrames;
+        }
+        else
+        {
+            // Keep whole 2x2 tiles so the Bayer pattern starts on the same color
+            const size_t width = kResolutions[r].width & ~static_cast<size_t>(1);
+            const size_t height = kResolutions[r].height & ~static_cast<size_t>(1);
+
+            frames.resize(sourceFrames.size());
+            bool tiled = width > 0 && height > 0;
+            for (size_t i = 0; i < sourceFrames.size() && tiled; i++)
+            {
+                tiled = TileFrame(sourceFrames[i], width, height, frames[i]);
+            }
+            if (!tiled)
+            {
+                cout << endl
+                     << "Skipping " << kResolutions[r].width << "x" << kResolutions[r].height
+                     << ", the recorded format cannot be tiled" << endl;
+                continue;
+            }
+        }
+
+        StageInputs inputs;
+        inputs.width = frames[0].width;
+        inputs.height = frames[0].height;
+
+        try
+        {
+            PrepareStageInputs(frames, inputs);
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            cout << "Error: " << e.what() << endl;
+            result = -1;
+            continue;
+        }
+
+        cout << endl << "*** " << inputs.width << "x" << inputs.height << " ***" << endl << endl;
+
+        for (size_t t = 0; t < threadCounts.size(); t++)
+        {
+            const unsigned int numThreads = threadCounts[t];
+
+            if (BenchmarkConvert)
+            {
+                RunConvertStage(inputs, numThreads, results);
+            }
+            if (BenchmarkColorCorrection)
+            {
+                RunColorCorrectionStage(inputs, numThreads, results);
+            }
+            if (BenchmarkShadingCorrection)
+            {
+                RunShadingCorrectionStage(inputs, numThreads, results);
+            }
+            if (BenchmarkSave)
+            {
+                RunSaveStage(inputs, numThreads, results);
+            }
+#if USE_OPENCV
+            if (BenchmarkOpenCV)
+            {
+                RunOpenCVStage(inputs, numThreads, results);
+            }
+#endif
+        }
+    }
+
+    result = result | WriteResults(results, runLabel, libraryVersion.str());
+    result = result | CompareWithBaseline(results);
+
+    // Release system
+    system->ReleaseInstance();
+
+    return result;
+}
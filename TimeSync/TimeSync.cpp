@@ -15,16 +15,143 @@
 // THIS SOFTWARE OR ITS DERIVATIVES.
 //=============================================================================
 
+// The coordinator includes winsock2.h, which must come before the windows.h included by Spinnaker.h
+#include "CaptureCoordinator.h"
 #include "Spinnaker.h"
 #include "SpinGenApi/SpinnakerGenApi.h"
 #include <iostream>
 #include <sstream>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "CameraProfile.h"
+#include "BandwidthPlanner.h"
+#include "StreamProfile.h"
+#include "SettingsCache.h"
+#include "BoundedQueue.h"
+#include "FrameSetMatcher.h"
 
 using namespace Spinnaker;
 using namespace Spinnaker::GenApi;
 using namespace Spinnaker::GenICam;
 using namespace std;
 
+// Use the following enum and global constant to select whether images are
+// grabbed from one camera after another, or from all cameras at once and
+// grouped into framesets by their timestamps.
+enum streamingType
+{
+    STREAM_SERIAL,
+    STREAM_THREADED
+};
+
+const streamingType chosenStreaming = STREAM_THREADED;
+
+// Number of images grabbed per camera, or framesets delivered when streaming threaded
+const unsigned int k_numImages = 10;
+
+// Frames whose IEEE 1588 timestamps differ by at most this many nanoseconds
+// are grouped into the same frameset. Half of the 10 fps frame period pairs
+// free running cameras with their nearest frame; tighten it when the cameras
+// are triggered together.
+const int64_t k_frameSetTolerance = 50000000;
+
+// Frames held per camera while waiting for the other cameras; older frames are
+// dropped. Together with the queued framesets this must stay below the number
+// of stream buffers of each camera, or the cameras run out of buffers.
+const size_t k_frameSetMaxPending = 4;
+
+// Complete framesets queued for the consumer
+const size_t k_frameSetQueueDepth = 2;
+
+// Grab timeout in milliseconds, so that grab threads notice when streaming stops
+const unsigned int k_grabTimeout = 1000;
+
+// Use the following enum and global constant to select whether packet size,
+// packet delay and throughput limit are fixed values or planned from each
+// camera's image size and frame rate so that all cameras on an interface fit
+// its link.
+enum bandwidthType
+{
+    BANDWIDTH_FIXED,
+    BANDWIDTH_PLANNED
+};
+
+const bandwidthType chosenBandwidth = BANDWIDTH_PLANNED;
+
+// Largest packet the network interfaces accept; 9000 requires jumbo frames
+const int64_t k_maxPacketSize = 9000;
+
+// Fraction of each link the planner hands out to cameras
+const double k_linkHeadroom = 0.9;
+
+// Stream all cameras for a while after planning and report resends and incomplete images
+const bool ProbeBandwidth = true;
+const double k_bandwidthProbeSeconds = 3.0;
+
+// Use the following global constant to select the stream buffer profile of
+// every camera. STREAM_PROFILE_NO_DROP (OldestFirst, buffers sized for
+// consumer stalls) keeps every frame for the framesets, while
+// STREAM_PROFILE_LOW_LATENCY (NewestOnly, few buffers) always hands over the
+// most recent frame. The low latency profile has fewer buffers than the
+// threaded streaming holds, so use it with serial streaming only.
+const streamProfileType chosenStreamProfile = STREAM_PROFILE_NO_DROP;
+
+// Use the following enum and global constant to select whether this host
+// runs the whole rig or is one of several hosts of a larger one. A capture
+// host grabs its own cameras and sends the serial number, frame ID and
+// IEEE 1588 timestamp of every frame to the aggregator at
+// k_aggregatorAddress. The aggregator needs no cameras; it waits for
+// k_numCaptureHosts hosts, starts them together and assembles the framesets
+// of the whole rig. The role can also be chosen on the command line with
+// /capture <aggregator address> or /aggregate <number of hosts>.
+enum coordinatorType
+{
+    COORDINATOR_NONE,
+    COORDINATOR_CAPTURE_HOST,
+    COORDINATOR_AGGREGATOR
+};
+
+const coordinatorType chosenCoordinator = COORDINATOR_NONE;
+const char* const k_aggregatorAddress = "192.168.0.10";
+const unsigned int k_numCaptureHosts = 2;
+
+// Frames held per camera by the aggregator while waiting for the other hosts.
+// Only metadata is held, so this can cover the network delay between hosts.
+const size_t k_rigFrameSetMaxPending = 64;
+
+// Use the following enum and global constant to select how the capture hosts
+// set up the triggers of their cameras. With RIG_TRIGGER_HARDWARE, the
+// exposure output (Line2) of the camera with serial number k_rigPrimarySerial
+// must be wired to the trigger input of every other camera of the rig, on
+// every host, as in the Synchronized example. The host of that camera lets it
+// run freely and puts its exposure signal on Line2, and every other camera is
+// triggered on the rising edge of Line3 (Line5 on Oryx). With
+// RIG_TRIGGER_FREE_RUNNING every camera runs freely, so the exposures are only
+// timestamped on the shared clock, not aligned. The primary camera can also be
+// chosen on the command line with /primary <serial number>.
+enum rigTriggerType
+{
+    RIG_TRIGGER_FREE_RUNNING,
+    RIG_TRIGGER_HARDWARE
+};
+
+const rigTriggerType chosenRigTrigger = RIG_TRIGGER_FREE_RUNNING;
+const char* const k_rigPrimarySerial = "";
+
+// Role, aggregator, host count and rig trigger in effect, from the constants above or the command line
+coordinatorType coordinatorRole = chosenCoordinator;
+string aggregatorAddress = k_aggregatorAddress;
+unsigned int numCaptureHosts = k_numCaptureHosts;
+rigTriggerType rigTrigger = chosenRigTrigger;
+string rigPrimarySerial = k_rigPrimarySerial;
+
+mutex printMutex;
+
 // This helper function allows the example to sleep in both Windows and Linux
 // systems. Note that Windows sleep takes milliseconds as a parameter while
 // Linux systems take microseconds as a parameter.
@@ -148,45 +275,50 @@ int ConfigureInterface(const InterfaceList& interfaceList)
 
 // This function configures IEEE 1588 settings on each camera
 // It enables IEEE 1588
-int ConfigureIEEE1588(const CameraList& camList)
+int ConfigureIEEE1588(const vector<CameraProfile>& profiles)
 {
     int result = 0;
-    CameraPtr pCam = nullptr;
+    bool enabled = false;
 
     cout << endl << endl << "*** CONFIGURING IEEE 1588 ***" << endl << endl;
 
     try
     {
         // Enable IEEE 1588 settings for each camera
-        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        for (unsigned int i = 0; i < profiles.size(); i++)
         {
-            // Select camera
-            pCam = camList.GetByIndex(i);
-
             // Enable IEEE 1588 settings
-            CBooleanPtr ptrIEEE1588 = pCam->GetNodeMap().GetNode("GevIEEE1588");
+            const CBooleanPtr& ptrIEEE1588 = profiles[i].ptrIEEE1588;
             if (!IsAvailable(ptrIEEE1588) || !IsWritable(ptrIEEE1588))
             {
                 cout << "Camera " << i << " Unable to enable IEEE 1588 (node retrieval). Aborting..." << endl;
                 return -1;
             }
 
-            // Enable IEEE 1588
+            // Enable IEEE 1588, unless a previous run left it enabled
+            if (ptrIEEE1588->GetValue())
+            {
+                cout << "Camera " << i << " IEEE 1588 is already enabled." << endl;
+                continue;
+            }
+
             ptrIEEE1588->SetValue(true);
+            enabled = true;
             cout << "Camera " << i << " IEEE 1588 is enabled." << endl;
         }
 
-        // Requires delay for at least 6 seconds to enable 1588 settings
-
-        cout << "Waiting for 10 seconds " << endl;
-        SleepyWrapper(10000);
+        // Requires delay for at least 6 seconds to enable 1588 settings; cameras that
+        // already had it enabled are synchronized already, which the checks below verify
+        if (enabled)
+        {
+            cout << "Waiting for 10 seconds " << endl;
+            SleepyWrapper(10000);
+        }
 
         // Check if IEEE 1588 settings is enabled for each camera
-        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        for (unsigned int i = 0; i < profiles.size(); i++)
         {
-            // Select camera
-            pCam = camList.GetByIndex(i);
-            CCommandPtr ptrGevIEEE1588DataSetLatch = pCam->GetNodeMap().GetNode("GevIEEE1588DataSetLatch");
+            const CCommandPtr& ptrGevIEEE1588DataSetLatch = profiles[i].ptrIEEE1588DataSetLatch;
             if (!IsAvailable(ptrGevIEEE1588DataSetLatch))
             {
                 cout << "Camera " << i << " Unable to execute IEEE 1588 data set latch (node retrieval). Aborting..."
@@ -196,7 +328,7 @@ int ConfigureIEEE1588(const CameraList& camList)
             ptrGevIEEE1588DataSetLatch->Execute();
 
             // Check if 1588 status is not in intialization
-            CEnumerationPtr ptrGevIEEE1588StatusLatched = pCam->GetNodeMap().GetNode("GevIEEE1588StatusLatched");
+            const CEnumerationPtr& ptrGevIEEE1588StatusLatched = profiles[i].ptrIEEE1588StatusLatched;
             if (!IsAvailable(ptrGevIEEE1588StatusLatched) || !IsReadable(ptrGevIEEE1588StatusLatched))
             {
                 cout << "Camera " << i << " Unable to read IEEE1588 status (node retrieval). Aborting..." << endl;
@@ -220,8 +352,7 @@ int ConfigureIEEE1588(const CameraList& camList)
 
             // Check if camera(s) is(are) synchronized to master camera
             // Verify if camera offset from master is larger than 1000ns which means camera(s) is(are) not synchronized
-            CIntegerPtr ptrGevIEEE1588OffsetFromMasterLatched =
-                pCam->GetNodeMap().GetNode("GevIEEE1588OffsetFromMasterLatched");
+            const CIntegerPtr& ptrGevIEEE1588OffsetFromMasterLatched = profiles[i].ptrIEEE1588OffsetFromMasterLatched;
             if (!IsAvailable(ptrGevIEEE1588OffsetFromMasterLatched) ||
                 !IsReadable(ptrGevIEEE1588OffsetFromMasterLatched))
             {
@@ -244,146 +375,135 @@ int ConfigureIEEE1588(const CameraList& camList)
     return result;
 }
 
+// Applies the settings to every camera, writing only the nodes that differ from what the camera holds
+int ApplyCameraSettings(const CameraList& camList, const vector<CameraProfile>& profiles, const SettingsProfile& settings)
+{
+    for (unsigned int i = 0; i < camList.GetSize(); i++)
+    {
+        SettingsCache cache(camList.GetByIndex(i), profiles[i]);
+        SettingsApplyResult settingsResult;
+        const bool applied = cache.Apply(settings, settingsResult);
+        PrintSettingsResult(settingsResult);
+
+        if (!applied)
+        {
+            cout << "Camera " << i << " Unable to apply settings. Aborting..." << endl;
+            return -1;
+        }
+    }
+    return 0;
+}
+
 // This function configures action control settings
 // For each camera, it sets action device key, group key and group mask.
-int ConfigureActionControl(const CameraList& camList)
+int ConfigureActionControl(const CameraList& camList, const vector<CameraProfile>& profiles)
 {
-    int result = 0;
-    CameraPtr pCam = nullptr;
-
     cout << endl << endl << "*** CONFIGURING ACTION CONTROL ***" << endl << endl;
 
-    try
-    {
-        for (unsigned int i = 0; i < camList.GetSize(); i++)
-        {
-            // Select camera
-            pCam = camList.GetByIndex(i);
+    // Set action device key to 0, action group key to 1 and action group mask to 1
+    SettingsProfile settings;
+    settings.SetInt("ActionDeviceKey", 0);
+    settings.SetInt("ActionGroupKey", 1);
+    settings.SetInt("ActionGroupMask", 1);
 
-            // Apply action group setting
-            CIntegerPtr ptrActionDeviceKey = pCam->GetNodeMap().GetNode("ActionDeviceKey");
-            if (!IsAvailable(ptrActionDeviceKey) || !IsWritable(ptrActionDeviceKey))
-            {
-                cout << "Camera " << i << " Unable to set Action Device Key (node retrieval). Aborting..." << endl;
-                return -1;
-            }
+    return ApplyCameraSettings(camList, profiles, settings);
+}
 
-            // Set action device key to 0
-            ptrActionDeviceKey->SetValue(0);
-            cout << "Camera " << i << " action device key is set" << endl;
+// This function configures other nodes for frame synchronization.
+// It sets acquisition frame rate , exposure settings,
+// acquisition Timing and image timestamp
+int ConfigureOtherNodes(const CameraList& camList, const vector<CameraProfile>& profiles)
+{
+    cout << endl << endl << "*** CONFIGURING OTHER NODES ***" << endl << endl;
 
-            CIntegerPtr ptrActionGroupKey = pCam->GetNodeMap().GetNode("ActionGroupKey");
-            if (!IsAvailable(ptrActionGroupKey) || !IsWritable(ptrActionGroupKey))
-            {
-                cout << "Camera " << i << " Unable to set Action Group Key (node retrieval). Aborting..." << endl;
-                return -1;
-            }
+    // Turn on frame rate control and set 10fps for this example, then turn off exposure
+    // auto and set the exposure time to 1000 for this example, where the camera has it
+    SettingsProfile settings;
+    settings.SetBool("AcquisitionFrameRateEnable", true);
+    settings.SetFloat("AcquisitionFrameRate", 10.0);
+    settings.SetEnum("ExposureAuto", "Off");
+    settings.SetFloat("ExposureTime", 1000.0, false);
 
-            // Set action group key to 1
-            ptrActionGroupKey->SetValue(1);
-            cout << "Camera " << i << " action group key is set" << endl;
+    return ApplyCameraSettings(camList, profiles, settings);
+}
 
-            CIntegerPtr ptrActionGroupMask = pCam->GetNodeMap().GetNode("ActionGroupMask");
-            if (!IsAvailable(ptrActionGroupMask) || !IsWritable(ptrActionGroupMask))
-            {
-                cout << "Camera " << i << " Unable to retrieve Action Group Mask (node retrieval). Aborting...e"
-                    << endl;
-                return -1;
-            }
+// The primary camera of a hardware triggered rig runs freely and drives Line2 with its exposure signal
+void AddRigPrimarySettings(SettingsProfile& settings, const CameraProfile& profile)
+{
+    settings.SetEnum("TriggerMode", "Off");
+    settings.Select("LineSelector", "Line2");
 
-            // Set action group mask to 1
-            ptrActionGroupMask->SetValue(1);
-            cout << "Camera " << i << " action group mask is set" << endl;
-        }
-    }
-    catch (Spinnaker::Exception& e)
+    // Enable 3.3V output for BFLY or BFS cameras
+    if (profile.family == FAMILY_BFLY || profile.family == FAMILY_BFS)
     {
-        cout << "Error: " << e.what() << endl;
-        result = -1;
+        settings.SetBool("V3_3Enable", true, false);
     }
-    return result;
+
+    settings.SetEnum("LineMode", "Output");
+    settings.SetEnum("LineSource", "ExposureActive");
 }
 
-// This function configures other nodes for frame synchronization.
-// It sets acquisition frame rate , exposure settings,
-// acquisition Timing and image timestamp
-int ConfigureOtherNodes(const CameraList& camList)
+// Every other camera of a hardware triggered rig is triggered by the exposure signal of the primary camera
+void AddRigSecondarySettings(SettingsProfile& settings, const CameraProfile& profile)
 {
-    int result = 0;
-    CameraPtr pCam = nullptr;
-
-    cout << endl << endl << "*** CONFIGURING OTHER NODES ***" << endl << endl;
+    settings.SetEnum("TriggerMode", "On");
+    settings.SetEnum("TriggerSource", profile.family == FAMILY_ORX ? "Line5" : "Line3");
+    settings.SetEnum("TriggerActivation", "RisingEdge");
 
-    try
-    {
-        for (unsigned int i = 0; i < camList.GetSize(); i++)
-        {
-            // Select camera
-            pCam = camList.GetByIndex(i);
-
-            // Frame rate setting
-            // Turn on frame rate control
-            CBooleanPtr ptrFrameRateEnable = pCam->GetNodeMap().GetNode("AcquisitionFrameRateEnable");
-            if (!IsAvailable(ptrFrameRateEnable) || !IsWritable(ptrFrameRateEnable))
-            {
-                cout << "Camera " << i << " Unable to enable Acquisition Frame Rate (node retrieval). Aborting..."
-                    << endl;
-                return -1;
-            }
+    // Not every camera has Trigger Overlap
+    settings.SetEnum("TriggerOverlap", "ReadOut", false);
+}
 
-            // Enable  Acquisition Frame Rate Enable
-            ptrFrameRateEnable->SetValue(true);
+// This function configures the triggers of the cameras of a capture host for
+// the rig trigger in use. Free running cameras have the trigger turned off,
+// also when a previous run left it on.
+int ConfigureRigTrigger(const CameraList& camList, const vector<CameraProfile>& profiles)
+{
+    cout << endl << endl << "*** CONFIGURING RIG TRIGGER ***" << endl << endl;
 
-            CFloatPtr ptrFrameRate = pCam->GetNodeMap().GetNode("AcquisitionFrameRate");
-            if (!IsAvailable(ptrFrameRate) || !IsWritable(ptrFrameRate))
-            {
-                cout << "Camera " << i << " Unable to set Acquisition Frame Rate (node retrieval). Aborting..." << endl;
-                return -1;
-            }
+    if (rigTrigger == RIG_TRIGGER_FREE_RUNNING)
+    {
+        SettingsProfile settings;
+        settings.SetEnum("TriggerMode", "Off");
+        return ApplyCameraSettings(camList, profiles, settings);
+    }
 
-            // Set 10fps for this example
-            const float frameRate = 10.0f;
-            ptrFrameRate->SetValue(frameRate);
-            cout << "Camera " << i << " Frame rate is set to " << frameRate << endl;
+    if (rigPrimarySerial.empty())
+    {
+        cout << "Set k_rigPrimarySerial, or use /primary <serial number>, to the camera that triggers the rig. "
+                "Aborting..."
+             << endl;
+        return -1;
+    }
 
-            // Turn off exposure auto.
-            CEnumerationPtr ptrExposureAuto = pCam->GetNodeMap().GetNode("ExposureAuto");
-            if (!IsAvailable(ptrExposureAuto) || !IsWritable(ptrExposureAuto))
-            {
-                cout << "Camera " << i << " Unable to disable Exposure Auto (node retrieval). Aborting..." << endl;
-                return -1;
-            }
+    for (unsigned int i = 0; i < camList.GetSize(); i++)
+    {
+        const bool primary = rigPrimarySerial == profiles[i].serialNumber.c_str();
 
-            CEnumEntryPtr ptrExposureAutoOff = ptrExposureAuto->GetEntryByName("Off");
-            if (!IsAvailable(ptrExposureAutoOff) || !IsReadable(ptrExposureAutoOff))
-            {
-                cout << "Camera " << i << " Unable to set Exposure Auto (enum entry retrieval). Aborting..." << endl;
-                return -1;
-            }
+        SettingsProfile settings;
+        if (primary)
+        {
+            AddRigPrimarySettings(settings, profiles[i]);
+        }
+        else
+        {
+            AddRigSecondarySettings(settings, profiles[i]);
+        }
 
-            // Turn off Exposure Auto
-            ptrExposureAuto->SetIntValue(ptrExposureAutoOff->GetValue());
+        SettingsCache cache(camList.GetByIndex(i), profiles[i]);
+        SettingsApplyResult settingsResult;
+        const bool applied = cache.Apply(settings, settingsResult);
+        PrintSettingsResult(settingsResult);
 
-            CFloatPtr ptrExposureTime = pCam->GetNodeMap().GetNode("ExposureTime");
-            if (IsAvailable(ptrExposureTime) && IsWritable(ptrExposureTime))
-            {
-                // Set exposure time to 1000 for this example
-                const float exposureTime = 1000.0f;
-                ptrExposureTime->SetValue(exposureTime);
-                cout << "Camera " << i << " Exposure time is set to " << exposureTime << endl;
-            }
-            else
-            {
-                cout << "Camera " << i << " Unable to set Exposure Time (node retrieval). Aborting..." << endl;
-            }
+        if (!applied)
+        {
+            cout << "Camera " << i << " Unable to configure the trigger. Aborting..." << endl;
+            return -1;
         }
+        cout << "Camera " << i << " is set up as " << (primary ? "primary" : "secondary") << " camera of the rig"
+             << endl;
     }
-    catch (Spinnaker::Exception& e)
-    {
-        cout << "Error: " << e.what() << endl;
-        result = -1;
-    }
-    return result;
+    return 0;
 }
 
 // This function configures chunk data settings
@@ -471,7 +591,468 @@ int ConfigureChunkData(const CameraList& camList)
     return result;
 }
 
-int AcquireImages(const SystemPtr& system, const InterfaceList& interfaceList, CameraList camList)
+// One image from every camera, indexed by camera, taken at the same time
+struct FrameSet
+{
+    unsigned int index;
+    vector<ImagePtr> images;
+    vector<int64_t> timestamps;
+    int64_t spread;
+};
+
+// Called on the consumer thread for every complete frameset; the images are released once it returns
+typedef function<void(const FrameSet&)> FrameSetCallback;
+
+// Releases every image of a frameset back to its camera
+void ReleaseFrameSet(FrameSet& frameSet)
+{
+    for (size_t i = 0; i < frameSet.images.size(); i++)
+    {
+        frameSet.images[i]->Release();
+    }
+    frameSet.images.clear();
+}
+
+// An image with its chunk timestamp, as queued by the frameset matcher
+struct TimedImage
+{
+    ImagePtr pImage;
+    int64_t timestamp;
+};
+
+//
+// Groups the frames of all cameras into framesets by timestamp
+//
+// *** NOTES ***
+// The grouping is done by FrameSetMatcher, the same one the multi-host
+// aggregator uses, so local and rig framesets are matched alike. As all
+// cameras share the IEEE 1588 clock, their timestamps can be compared
+// directly. Frames dropped without a match are released back to their camera.
+//
+class FrameSetAssembler
+{
+public:
+    FrameSetAssembler(size_t numCameras, int64_t tolerance, size_t maxPending, BoundedQueue<FrameSet>& output)
+        : m_matcher(numCameras, tolerance, maxPending, [](TimedImage& frame) { frame.pImage->Release(); }),
+          m_output(output)
+    {
+    }
+
+    // Called by the grab thread of a camera for each complete image
+    void Add(unsigned int camIndex, ImagePtr pImage, int64_t timestamp)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        TimedImage timedImage = {pImage, timestamp};
+        m_matcher.Add(camIndex, timedImage, [this](unsigned int index, vector<TimedImage>& frames, int64_t spread) {
+            FrameSet frameSet;
+            frameSet.index = index;
+            frameSet.spread = spread;
+            for (size_t i = 0; i < frames.size(); i++)
+            {
+                frameSet.images.push_back(frames[i].pImage);
+                frameSet.timestamps.push_back(frames[i].timestamp);
+            }
+
+            // Pushed while locked so that framesets reach the consumer in order
+            if (!m_output.Push(frameSet))
+            {
+                ReleaseFrameSet(frameSet);
+                return false;
+            }
+            return true;
+        });
+    }
+
+    // Releases the frames still waiting for a partner
+    void Clear()
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_matcher.Clear();
+    }
+
+    void PrintStatistics()
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        cout << "Framesets assembled: " << m_matcher.GetNumFrameSets() << endl;
+        m_matcher.PrintStatistics();
+    }
+
+private:
+    FrameSetMatcher<TimedImage> m_matcher;
+    BoundedQueue<FrameSet>& m_output;
+    mutex m_mutex;
+};
+
+// This function grabs images from one camera on its own thread and hands
+// every complete image to the frameset assembler with its chunk timestamp.
+void GrabFrames(CameraPtr pCam, unsigned int camIndex, FrameSetAssembler& assembler, const atomic<bool>& stopping)
+{
+    while (!stopping)
+    {
+        try
+        {
+            ImagePtr pResultImage = pCam->GetNextImage(k_grabTimeout);
+
+            if (pResultImage->IsIncomplete())
+            {
+                {
+                    lock_guard<mutex> lock(printMutex);
+                    cout << "Camera " << camIndex << " image incomplete with image status "
+                         << pResultImage->GetImageStatus() << "..." << endl;
+                }
+                pResultImage->Release();
+                continue;
+            }
+
+            const int64_t timestamp = pResultImage->GetChunkData().GetTimestamp();
+            assembler.Add(camIndex, pResultImage, timestamp);
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            // Grab timeouts are expected while another camera is being waited for
+            if (!stopping)
+            {
+                lock_guard<mutex> lock(printMutex);
+                cout << "Camera " << camIndex << " error: " << e.what() << endl;
+            }
+        }
+    }
+}
+
+// This function streams all cameras at once, one grab thread per camera, and
+// passes numFrameSets complete framesets to the callback on the calling
+// thread. Acquisition must already have been started on every camera.
+int StreamFrameSets(const CameraList& camList, unsigned int numFrameSets, const FrameSetCallback& callback)
+{
+    int result = 0;
+
+    const unsigned int numCameras = camList.GetSize();
+
+    BoundedQueue<FrameSet> frameSets(k_frameSetQueueDepth);
+    FrameSetAssembler assembler(numCameras, k_frameSetTolerance, k_frameSetMaxPending, frameSets);
+    atomic<bool> stopping(false);
+
+    vector<thread> grabThreads;
+    for (unsigned int i = 0; i < numCameras; i++)
+    {
+        grabThreads.push_back(thread(GrabFrames, camList.GetByIndex(i), i, ref(assembler), cref(stopping)));
+    }
+
+    FrameSet frameSet;
+    for (unsigned int i = 0; i < numFrameSets && frameSets.Pop(frameSet); i++)
+    {
+        try
+        {
+            callback(frameSet);
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            lock_guard<mutex> lock(printMutex);
+            cout << "Error: " << e.what() << endl;
+            result = -1;
+        }
+        ReleaseFrameSet(frameSet);
+    }
+
+    // Stop the grab threads, then release everything they left behind
+    stopping = true;
+    frameSets.Close();
+
+    for (size_t i = 0; i < grabThreads.size(); i++)
+    {
+        grabThreads[i].join();
+    }
+
+    assembler.Clear();
+    while (frameSets.Pop(frameSet))
+    {
+        ReleaseFrameSet(frameSet);
+    }
+
+    cout << endl;
+    assembler.PrintStatistics();
+
+    return result;
+}
+
+// This function is the frameset consumer of this example; it prints the
+// timestamp of every image and how far apart they are.
+void PrintFrameSet(const FrameSet& frameSet)
+{
+    lock_guard<mutex> lock(printMutex);
+
+    cout << "Frameset " << frameSet.index << " (spread " << frameSet.spread << " ns)" << endl;
+    for (size_t i = 0; i < frameSet.images.size(); i++)
+    {
+        cout << "\tCamera " << i << " timestamp: " << frameSet.timestamps[i] << endl;
+    }
+}
+
+// This function reads the IEEE 1588 status and offset from the master of a
+// camera, so that the aggregator can check that every host shares one clock.
+bool ReadIEEE1588Status(const CameraProfile& profile, RemoteCamera& camera)
+{
+    camera.serialNumber = profile.serialNumber.c_str();
+    camera.clockStatus = "Unknown";
+    camera.offsetFromMaster = 0;
+    camera.hostIndex = 0;
+
+    if (!IsAvailable(profile.ptrIEEE1588DataSetLatch) || !IsAvailable(profile.ptrIEEE1588StatusLatched) ||
+        !IsReadable(profile.ptrIEEE1588StatusLatched) || !IsAvailable(profile.ptrIEEE1588OffsetFromMasterLatched) ||
+        !IsReadable(profile.ptrIEEE1588OffsetFromMasterLatched))
+    {
+        return false;
+    }
+
+    profile.ptrIEEE1588DataSetLatch->Execute();
+
+    CEnumEntryPtr ptrStatus = profile.ptrIEEE1588StatusLatched->GetCurrentEntry();
+    if (IsAvailable(ptrStatus) && IsReadable(ptrStatus))
+    {
+        camera.clockStatus = ptrStatus->GetSymbolic().c_str();
+    }
+    camera.offsetFromMaster = profile.ptrIEEE1588OffsetFromMasterLatched->GetValue();
+    return true;
+}
+
+// This function grabs images from one camera on its own thread and sends the
+// metadata of every image to the aggregator until the aggregator stops it.
+void SendFrames(CameraPtr pCam, unsigned int camIndex, const string serialNumber, CaptureHostLink& link)
+{
+    while (!link.IsStopRequested())
+    {
+        try
+        {
+            ImagePtr pResultImage = pCam->GetNextImage(k_grabTimeout);
+
+            FrameRecord record;
+            record.serialNumber = serialNumber;
+            record.frameID = pResultImage->GetFrameID();
+            record.incomplete = pResultImage->IsIncomplete();
+            record.timestamp = record.incomplete ? 0 : pResultImage->GetChunkData().GetTimestamp();
+
+            // The image stays on this host; a real application would process or store it here
+            pResultImage->Release();
+
+            link.Send(record);
+        }
+        catch (Spinnaker::Exception& e)
+        {
+            // Grab timeouts are expected while waiting for a slower camera or a trigger
+            if (!link.IsStopRequested())
+            {
+                lock_guard<mutex> lock(printMutex);
+                cout << "Camera " << camIndex << " error: " << e.what() << endl;
+            }
+        }
+    }
+}
+
+//
+// This function runs the cameras of this host as part of a larger rig
+//
+// *** NOTES ***
+// The cameras are introduced to the aggregator with their IEEE 1588 status,
+// and acquisition only begins once the aggregator has heard from every
+// host and found all cameras on one clock, so that every host starts at the
+// same time. Each camera is then grabbed from on its own thread until the
+// aggregator has all its framesets.
+//
+int StreamToAggregator(const CameraList& camList, const vector<CameraProfile>& profiles)
+{
+    int result = 0;
+
+    CaptureHostLink link;
+    vector<RemoteCamera> cameras(camList.GetSize());
+    for (unsigned int i = 0; i < camList.GetSize(); i++)
+    {
+        if (!ReadIEEE1588Status(profiles[i], cameras[i]))
+        {
+            cout << "Camera " << i << " Unable to read IEEE 1588 status; the aggregator will refuse it..." << endl;
+        }
+        cout << "Camera " << i << " IEEE 1588 status: " << cameras[i].clockStatus << ", offset from master "
+             << cameras[i].offsetFromMaster << " ns" << endl;
+    }
+
+    // The socket library is started by the link, so the host name is read afterwards
+    char hostName[256] = "";
+    gethostname(hostName, sizeof(hostName));
+
+    string error;
+    cout << endl << "Connecting to the aggregator at " << aggregatorAddress << "..." << endl;
+    if (!link.Connect(aggregatorAddress, k_coordinatorPort, hostName, cameras, error) ||
+        !link.WaitForStart(k_coordinatorStartTimeout, error))
+    {
+        cout << "Unable to join the rig: " << error << ". Aborting..." << endl;
+        return -1;
+    }
+    cout << "Started by the aggregator..." << endl << endl;
+
+    try
+    {
+        // The primary camera of a triggered rig starts last, so that this host's other cameras see its first trigger
+        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        {
+            if (rigTrigger != RIG_TRIGGER_HARDWARE || rigPrimarySerial != profiles[i].serialNumber.c_str())
+            {
+                camList.GetByIndex(i)->BeginAcquisition();
+            }
+        }
+        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        {
+            if (rigTrigger == RIG_TRIGGER_HARDWARE && rigPrimarySerial == profiles[i].serialNumber.c_str())
+            {
+                camList.GetByIndex(i)->BeginAcquisition();
+            }
+        }
+
+        vector<thread> grabThreads;
+        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        {
+            grabThreads.push_back(
+                thread(SendFrames, camList.GetByIndex(i), i, string(profiles[i].serialNumber.c_str()), ref(link)));
+        }
+
+        for (size_t i = 0; i < grabThreads.size(); i++)
+        {
+            grabThreads[i].join();
+        }
+
+        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        {
+            camList.GetByIndex(i)->EndAcquisition();
+        }
+    }
+    catch (Spinnaker::Exception& e)
+    {
+        cout << "Error: " << e.what() << endl;
+        result = -1;
+    }
+
+    if (link.IsConnectionLost())
+    {
+        result = -1;
+    }
+
+    link.Finish();
+    cout << endl;
+    link.PrintStatistics();
+
+    return result;
+}
+
+// This function is the rig frameset consumer of this example; it prints the
+// frame ID and timestamp of every camera of the rig and how far apart they are.
+void PrintRigFrameSet(const vector<RemoteCamera>& cameras, const RemoteFrameSet& frameSet)
+{
+    cout << "Rig frameset " << frameSet.index << " (spread " << frameSet.spread << " ns)" << endl;
+    for (size_t i = 0; i < frameSet.frames.size(); i++)
+    {
+        cout << "\tHost " << cameras[i].hostIndex << " camera " << frameSet.frames[i].serialNumber << " frame ID "
+             << frameSet.frames[i].frameID << " timestamp: " << frameSet.frames[i].timestamp << endl;
+    }
+}
+
+// This function runs the aggregator of a rig spread over several capture
+// hosts; it needs no cameras of its own.
+int RunAggregator(unsigned int numHosts)
+{
+    cout << endl << "*** AGGREGATING " << numHosts << " CAPTURE HOSTS ***" << endl << endl;
+    cout << "Waiting for capture hosts on port " << k_coordinatorPort << "..." << endl;
+
+    FrameSetAggregator aggregator(numHosts, k_frameSetTolerance, k_rigFrameSetMaxPending);
+
+    string error;
+    const bool complete = aggregator.Run(
+        k_coordinatorPort,
+        k_numImages,
+        [&aggregator](const RemoteFrameSet& frameSet) { PrintRigFrameSet(aggregator.GetCameras(), frameSet); },
+        error);
+
+    cout << endl;
+    aggregator.PrintStatistics();
+
+    if (!complete)
+    {
+        cout << "Rig capture failed: " << error << endl;
+        return -1;
+    }
+    return 0;
+}
+
+// This function plans packet size, packet delay and throughput limit for the
+// cameras on every interface so that their combined bandwidth fits the link,
+// applies the plan and optionally probes it.
+int ConfigureBandwidth(const InterfaceList& interfaceList)
+{
+    int result = 0;
+
+    cout << endl << endl << "*** CONFIGURING BANDWIDTH ***" << endl << endl;
+
+    try
+    {
+        //
+        // Plan each interface
+        //
+        // *** NOTES ***
+        // Every camera needs its payload size times its frame rate on the
+        // wire, plus the headers of each packet. When the cameras on one
+        // interface need less than the link provides, the spare bandwidth is
+        // shared out as gaps between packets so that the cameras do not burst
+        // into the NIC at the same time; when they need more, every camera's
+        // frame rate will drop in the same proportion, and the plan says so.
+        //
+        const BandwidthPlanner planner(k_maxPacketSize, k_linkHeadroom);
+        vector<BandwidthPlan> plans;
+
+        for (unsigned int i = 0; i < interfaceList.GetSize(); i++)
+        {
+            BandwidthPlan plan;
+            if (!planner.PlanInterface(interfaceList.GetByIndex(i), plan))
+            {
+                continue;
+            }
+
+            BandwidthPlanner::PrintPlan(plan);
+            if (!BandwidthPlanner::ApplyPlan(plan))
+            {
+                cout << "Unable to apply the bandwidth plan of interface " << plan.interfaceName << ". Aborting..."
+                     << endl;
+                return -1;
+            }
+            if (plan.oversubscribed)
+            {
+                cout << "Interface " << plan.interfaceName << " cannot carry every camera at its frame rate." << endl;
+            }
+
+            plans.push_back(plan);
+        }
+
+        if (ProbeBandwidth && !plans.empty())
+        {
+            cout << endl << "Probing the bandwidth plan for " << k_bandwidthProbeSeconds << " seconds..." << endl;
+
+            vector<BandwidthProbeResult> probeResults;
+            const bool passed = ProbeBandwidthPlan(plans, k_bandwidthProbeSeconds, probeResults);
+            PrintBandwidthProbe(probeResults, k_bandwidthProbeSeconds);
+
+            cout << (passed ? "Bandwidth plan holds." : "Bandwidth plan dropped frames; lower the frame rate or headroom.")
+                 << endl;
+        }
+    }
+    catch (Spinnaker::Exception& e)
+    {
+        cout << "Error: " << e.what() << endl;
+        result = -1;
+    }
+
+    return result;
+}
+
+int AcquireImages(
+    const SystemPtr& system, const InterfaceList& interfaceList, CameraList camList, const vector<CameraProfile>& profiles)
 {
     int result = 0;
     CameraPtr pCam = nullptr;
@@ -485,11 +1066,10 @@ int AcquireImages(const SystemPtr& system, const InterfaceList& interfaceList, C
         // Prepare each camera to acquire images
         //
         // *** NOTES ***
-        // For pseudo-simultaneous streaming, each camera is prepared as if it
-        // were just one, but in a loop. Notice that cameras are selected with
-        // an index. We demonstrate pseudo-simultaneous streaming because true
-        // simultaneous streaming would require multiple process or threads,
-        // which is too complex for an example.
+        // Each camera is prepared as if it were just one, but in a loop.
+        // Notice that cameras are selected with an index. With STREAM_SERIAL
+        // the cameras are then grabbed from pseudo-simultaneously, one after
+        // another; with STREAM_THREADED every camera gets its own grab thread.
         //
         // Serial numbers are the only persistent objects we gather in this
         // example, which is why a vector is created.
@@ -526,139 +1106,163 @@ int AcquireImages(const SystemPtr& system, const InterfaceList& interfaceList, C
 
             cout << "Camera " << i << " acquisition mode set to continuous..." << endl;
 
-            // Device Link Throughput Limit setting
-            CIntegerPtr ptrDeviceLinkThroughputLimit = pCam->GetNodeMap().GetNode("DeviceLinkThroughputLimit");
-            if (!IsAvailable(ptrDeviceLinkThroughputLimit) || !IsWritable(ptrDeviceLinkThroughputLimit))
-            {
-                cout << "Unable to set device link throughput limit (node retrieval; camera " << i << "). Aborting..."
-                    << endl
-                    << endl;
-                return -1;
-            }
-            // Set throughput close to the maximum limit 125000000
-            const int64_t deviceLinkThroughputLimit = 100000000;
-            ptrDeviceLinkThroughputLimit->SetValue(deviceLinkThroughputLimit);
-
-            // Packet size, Packet delay setting
-            CIntegerPtr ptrPacketSize = pCam->GetNodeMap().GetNode("GevSCPSPacketSize");
-            if (!IsAvailable(ptrPacketSize) || !IsWritable(ptrPacketSize))
-            {
-                cout << "Unable to set packet size (node retrieval; camera " << i << "). Aborting..." << endl << endl;
-                return -1;
-            }
-            // Set packet size to maximum value
-            const int64_t packetSize = 9000;
-            ptrPacketSize->SetValue(packetSize);
-
-            CIntegerPtr ptrPacketDelay = pCam->GetNodeMap().GetNode("GevSCPD");
-            if (!IsAvailable(ptrPacketDelay) || !IsWritable(ptrPacketDelay))
+            // Fixed bandwidth settings; planned settings are applied by ConfigureBandwidth()
+            if (chosenBandwidth == BANDWIDTH_FIXED)
             {
-                cout << "Unable to set packet delay (node retrieval; camera " << i << "). Aborting..." << endl << endl;
-                return -1;
-            }
-
-            // Set packet delay 9000 by using formula packet delay x 8
-            // for BFS only, there is 8 bit internal tick
-            // for Gen 2 cameras , just use packet delay 9000
-            const int64_t packetDelay = 72000;
-            ptrPacketDelay->SetValue(packetDelay);
-
-            // Begin acquiring images
-            pCam->BeginAcquisition();
+                // Device Link Throughput Limit setting
+                CIntegerPtr ptrDeviceLinkThroughputLimit = pCam->GetNodeMap().GetNode("DeviceLinkThroughputLimit");
+                if (!IsAvailable(ptrDeviceLinkThroughputLimit) || !IsWritable(ptrDeviceLinkThroughputLimit))
+                {
+                    cout << "Unable to set device link throughput limit (node retrieval; camera " << i << "). Aborting..."
+                        << endl
+                        << endl;
+                    return -1;
+                }
+                // Set throughput close to the maximum limit 125000000
+                const int64_t deviceLinkThroughputLimit = 100000000;
+                ptrDeviceLinkThroughputLimit->SetValue(deviceLinkThroughputLimit);
 
-            cout << "Camera " << i << " started acquiring images..." << endl;
+                // Packet size, Packet delay setting
+                CIntegerPtr ptrPacketSize = pCam->GetNodeMap().GetNode("GevSCPSPacketSize");
+                if (!IsAvailable(ptrPacketSize) || !IsWritable(ptrPacketSize))
+                {
+                    cout << "Unable to set packet size (node retrieval; camera " << i << "). Aborting..." << endl << endl;
+                    return -1;
+                }
+                // Set packet size to maximum value
+                const int64_t packetSize = 9000;
+                ptrPacketSize->SetValue(packetSize);
 
-            // Retrieve device serial number for filename
-            strSerialNumbers[i] = "";
+                CIntegerPtr ptrPacketDelay = pCam->GetNodeMap().GetNode("GevSCPD");
+                if (!IsAvailable(ptrPacketDelay) || !IsWritable(ptrPacketDelay))
+                {
+                    cout << "Unable to set packet delay (node retrieval; camera " << i << "). Aborting..." << endl << endl;
+                    return -1;
+                }
 
-            CStringPtr ptrStringSerial = pCam->GetTLDeviceNodeMap().GetNode("DeviceSerialNumber");
+                // Set packet delay 9000 by using formula packet delay x 8
+                // for BFS only, there is 8 bit internal tick
+                // for Gen 2 cameras , just use packet delay 9000
+                const int64_t packetDelay = 72000;
+                ptrPacketDelay->SetValue(packetDelay);
+            }
 
-            if (IsAvailable(ptrStringSerial) && IsReadable(ptrStringSerial))
+            // Begin acquiring images; a capture host waits for the aggregator to start the rig
+            if (coordinatorRole != COORDINATOR_CAPTURE_HOST)
             {
-                strSerialNumbers[i] = ptrStringSerial->GetValue();
-                cout << "Camera " << i << " serial number set to " << strSerialNumbers[i] << "..." << endl;
+                pCam->BeginAcquisition();
+
+                cout << "Camera " << i << " started acquiring images..." << endl;
             }
-            cout << endl;
+
+            // Device serial number for filename
+            strSerialNumbers[i] = profiles[i].serialNumber;
+            cout << "Camera " << i << " serial number set to " << strSerialNumbers[i] << "..." << endl << endl;
         }
 
-        const unsigned int numInterfaces = interfaceList.GetSize();
-        for (unsigned int i = 0; i < numInterfaces; i++)
+        if (coordinatorRole == COORDINATOR_CAPTURE_HOST)
+        {
+            // Stream the cameras of this host as part of the rig
+            result = result | StreamToAggregator(camList, profiles);
+        }
+        else if (chosenStreaming == STREAM_THREADED)
         {
-            interfacePtr = interfaceList.GetByIndex(i);
-            INodeMap& nodeMapInterface = interfacePtr->GetTLNodeMap();
-            interfacePtr->UpdateCameras();
-            camList = interfacePtr->GetCameras();
             //
-            // Retrieve, convert, and save images for each camera
+            // Stream all cameras at once
             //
             // *** NOTES ***
-            // In order to work with simultaneous camera streams, nested loops are
-            // needed. It is important that the inner loop be the one iterating
-            // through the cameras; otherwise, all images will be grabbed from a
-            // single camera before grabbing any images from another.
+            // Every camera is grabbed from on its own thread, and frames from
+            // all cameras are grouped into framesets by their IEEE 1588
+            // timestamps. Only complete framesets reach PrintFrameSet(); a
+            // real application would pass its own consumer instead.
             //
-            const unsigned int k_numImages = 10;
-            for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
+            result = result | StreamFrameSets(camList, k_numImages, PrintFrameSet);
+
+            for (unsigned int i = 0; i < camList.GetSize(); i++)
             {
-                for (unsigned int index = 0; index < camList.GetSize(); index++)
+                camList.GetByIndex(i)->EndAcquisition();
+            }
+        }
+        else
+        {
+            const unsigned int numInterfaces = interfaceList.GetSize();
+            for (unsigned int i = 0; i < numInterfaces; i++)
+            {
+                interfacePtr = interfaceList.GetByIndex(i);
+                INodeMap& nodeMapInterface = interfacePtr->GetTLNodeMap();
+                interfacePtr->UpdateCameras();
+                camList = interfacePtr->GetCameras();
+                //
+                // Retrieve, convert, and save images for each camera
+                //
+                // *** NOTES ***
+                // In order to work with simultaneous camera streams, nested loops are
+                // needed. It is important that the inner loop be the one iterating
+                // through the cameras; otherwise, all images will be grabbed from a
+                // single camera before grabbing any images from another.
+                //
+                for (unsigned int imageCnt = 0; imageCnt < k_numImages; imageCnt++)
                 {
-                    try
+                    for (unsigned int index = 0; index < camList.GetSize(); index++)
                     {
-                        // Select camera
-                        pCam = camList.GetByIndex(index);
-
-                        // Retrieve next received image and ensure image completion
-                        ImagePtr pResultImage = pCam->GetNextImage();
-
-                        if (pResultImage->IsIncomplete())
+                        try
                         {
-                            cout << "Image incomplete with image status " << pResultImage->GetImageStatus() << "..."
-                                << endl
-                                << endl;
+                            // Select camera
+                            pCam = camList.GetByIndex(index);
+
+                            // Retrieve next received image and ensure image completion
+                            ImagePtr pResultImage = pCam->GetNextImage();
+
+                            if (pResultImage->IsIncomplete())
+                            {
+                                cout << "Image incomplete with image status " << pResultImage->GetImageStatus() << "..."
+                                    << endl
+                                    << endl;
+                            }
+                            else
+                            {
+                                // Print image information
+                                cout << "Camera " << index << " grabbed image " << imageCnt << endl;
+                            }
+
+                            // Get timestamp
+                            ChunkData chunkData = pResultImage->GetChunkData();
+
+                            // Retrieve timestamp
+                            const int64_t timestamp = chunkData.GetTimestamp();
+                            cout << "\tTimestamp: " << timestamp << endl;
+
+                            // Release image
+                            pResultImage->Release();
+
+                            cout << endl;
                         }
-                        else
+                        catch (Spinnaker::Exception& e)
                         {
-                            // Print image information
-                            cout << "Camera " << index << " grabbed image " << imageCnt << endl;
+                            cout << "Error: " << e.what() << endl;
+                            result = -1;
                         }
-
-                        // Get timestamp
-                        ChunkData chunkData = pResultImage->GetChunkData();
-
-                        // Retrieve timestamp
-                        const int64_t timestamp = chunkData.GetTimestamp();
-                        cout << "\tTimestamp: " << timestamp << endl;
-
-                        // Release image
-                        pResultImage->Release();
-
-                        cout << endl;
-                    }
-                    catch (Spinnaker::Exception& e)
-                    {
-                        cout << "Error: " << e.what() << endl;
-                        result = -1;
                     }
                 }
-            }
 
-            //
-            // End acquisition for each camera
-            //
-            // *** NOTES ***
-            // Notice that what is usually a one-step process is now two steps
-            // because of the additional step of selecting the camera. It is worth
-            // repeating that camera selection needs to be done once per loop.
-            //
-            // It is possible to interact with cameras through the camera list with
-            // GetByIndex(); this is an alternative to retrieving cameras as
-            // CameraPtr objects that can be quick and easy for small tasks.
-            //
-
-            // End acquisition
-            for (unsigned int index = 0; index < camList.GetSize(); index++)
-            {
-                camList.GetByIndex(index)->EndAcquisition();
+                //
+                // End acquisition for each camera
+                //
+                // *** NOTES ***
+                // Notice that what is usually a one-step process is now two steps
+                // because of the additional step of selecting the camera. It is worth
+                // repeating that camera selection needs to be done once per loop.
+                //
+                // It is possible to interact with cameras through the camera list with
+                // GetByIndex(); this is an alternative to retrieving cameras as
+                // CameraPtr objects that can be quick and easy for small tasks.
+                //
+
+                // End acquisition
+                for (unsigned int index = 0; index < camList.GetSize(); index++)
+                {
+                    camList.GetByIndex(index)->EndAcquisition();
+                }
             }
         }
     }
@@ -725,6 +1329,24 @@ int RunMultipleCameras(const SystemPtr& system, const InterfaceList& interfaceLi
             pCam->Init();
         }
 
+        //
+        // Resolve the profile of each camera
+        //
+        // *** NOTES ***
+        // The serial number and the IEEE 1588 nodes of every camera are
+        // looked up once, after the cameras are initialized, and reused by
+        // the configuration and acquisition steps below.
+        //
+        vector<CameraProfile> profiles(camList.GetSize());
+        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        {
+            if (!profiles[i].Resolve(camList.GetByIndex(i)))
+            {
+                cout << "Unable to read the device model of camera " << i << ". Aborting..." << endl;
+                return -1;
+            }
+        }
+
         // Configure Interface Settings
         result = ConfigureInterface(interfaceList);
         if (result < 0)
@@ -733,26 +1355,36 @@ int RunMultipleCameras(const SystemPtr& system, const InterfaceList& interfaceLi
         }
 
         // Configure IEEE 1588 settings
-        result = ConfigureIEEE1588(camList);
+        result = ConfigureIEEE1588(profiles);
         if (result < 0)
         {
             return result;
         }
 
         // Configure Action control settings
-        result = ConfigureActionControl(camList);
+        result = ConfigureActionControl(camList, profiles);
         if (result < 0)
         {
             return result;
         }
         
         // Configure other node settings for frame synchronization
-        result = ConfigureOtherNodes(camList);
+        result = ConfigureOtherNodes(camList, profiles);
         if (result < 0)
         {
             return result;
         }
 
+        // Configure the rig trigger of a capture host
+        if (coordinatorRole == COORDINATOR_CAPTURE_HOST)
+        {
+            result = ConfigureRigTrigger(camList, profiles);
+            if (result < 0)
+            {
+                return result;
+            }
+        }
+
         // Configure chunk data
         result = ConfigureChunkData(camList);
         if (result < 0)
@@ -760,13 +1392,40 @@ int RunMultipleCameras(const SystemPtr& system, const InterfaceList& interfaceLi
             return result;
         }
 
+        // Plan the GigE bandwidth of all cameras
+        if (chosenBandwidth == BANDWIDTH_PLANNED)
+        {
+            result = ConfigureBandwidth(interfaceList);
+            if (result < 0)
+            {
+                return result;
+            }
+        }
+
+        // Configure stream buffers once the frame rate each camera will reach is known
+        vector<StreamSettings> streamSettings(camList.GetSize());
+        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        {
+            if (!ApplyStreamProfile(camList.GetByIndex(i), chosenStreamProfile, streamSettings[i]))
+            {
+                cout << "Unable to apply every stream buffer setting on camera " << i << "..." << endl;
+            }
+            PrintStreamSettings(streamSettings[i]);
+        }
+        cout << endl;
+
         // Acquire images on all cameras
-        result = AcquireImages(system, interfaceList, camList);
+        result = AcquireImages(system, interfaceList, camList, profiles);
         if (result < 0)
         {
             return result;
         }
 
+        for (unsigned int i = 0; i < camList.GetSize(); i++)
+        {
+            PrintStreamDrops(camList.GetByIndex(i), streamSettings[i]);
+        }
+
         //
         // Deinitialize each camera
         //
@@ -794,13 +1453,52 @@ int RunMultipleCameras(const SystemPtr& system, const InterfaceList& interfaceLi
 
 // Example entry point; please see Enumeration example for more in-depth
 // comments on preparing and cleaning up the system.
-int main(int /*argc*/, char** /*argv*/)
+int main(int argc, char** argv)
 {
     int result = 0;
 
     // Print application build information
     cout << "Application build date: " << __DATE__ << " " << __TIME__ << endl << endl;
 
+    // The coordinator role can be chosen per host without rebuilding
+    vector<string> args(argv, argv + argc);
+    for (size_t i = 1; i < args.size(); i++)
+    {
+        if ((args[i] == "/capture" || args[i] == "/c") && i + 1 < args.size())
+        {
+            coordinatorRole = COORDINATOR_CAPTURE_HOST;
+            aggregatorAddress = args[++i];
+        }
+        else if ((args[i] == "/aggregate" || args[i] == "/a") && i + 1 < args.size())
+        {
+            coordinatorRole = COORDINATOR_AGGREGATOR;
+            numCaptureHosts = static_cast<unsigned int>(strtoul(args[++i].c_str(), nullptr, 10));
+        }
+        else if ((args[i] == "/primary" || args[i] == "/p") && i + 1 < args.size())
+        {
+            rigTrigger = RIG_TRIGGER_HARDWARE;
+            rigPrimarySerial = args[++i];
+        }
+        else
+        {
+            cout << "Usage: TimeSync [/capture <aggregator address> [/primary <serial number>] | /aggregate <number "
+                    "of hosts>]"
+                 << endl;
+            return -1;
+        }
+    }
+
+    // The aggregator only assembles the framesets of the capture hosts
+    if (coordinatorRole == COORDINATOR_AGGREGATOR)
+    {
+        result = RunAggregator(numCaptureHosts);
+
+        cout << endl << "Done! Press Enter to exit..." << endl;
+        getchar();
+
+        return result;
+    }
+
     // Retrieve singleton reference to system object
     SystemPtr system = System::GetInstance();
 